@@ -51,9 +51,6 @@ def cutline_1():
 
 def cutline_2():
 
-    if not ogrtest.have_geos():
-        return 'skip'
-
     tst = gdaltest.GDALTest( 'VRT', 'cutline_blend.vrt', 1, 21395 )
     return tst.testOpen()
 
@@ -62,9 +62,48 @@ def tps_1():
 
     return 'success' 
 
+###############################################################################
+# Test that the transformation is exact at the GCPs with enough GCPs to
+# use the blocked and multi-threaded solver. The forward and reverse solves
+# each get half of NUM_THREADS, so NUM_THREADS=4 is needed for the threaded
+# LU factorization to be used.
+
+def tps_2():
+
+    drv = gdal.GetDriverByName('MEM')
+    ds = drv.Create('foo',200,200)
+    gcp_list = []
+    for j in range(20):
+        for i in range(20):
+            x = i * 13.0 + (j % 3)
+            y = j * 13.0 + (i % 5)
+            gcp_list.append(gdal.GCP(1000 + x + 0.001 * y * y,
+                                     2000 - y + 0.002 * x * y, 0, x, y))
+    ds.SetGCPs(gcp_list, osr.GetUserInputAsWKT('WGS84'))
+
+    for num_threads in ['1', '2', '4']:
+        transformer = gdal.Transformer(ds, None,
+                                       ['METHOD=GCP_TPS',
+                                        'NUM_THREADS=' + num_threads] )
+        for gcp in gcp_list:
+            (success, pnt) = transformer.TransformPoint(0, gcp.GCPPixel, gcp.GCPLine)
+            if not success or abs(pnt[0] - gcp.GCPX) > 1e-6 or abs(pnt[1] - gcp.GCPY) > 1e-6:
+                gdaltest.post_reason('fail')
+                print(num_threads, gcp.GCPPixel, gcp.GCPLine, pnt)
+                return 'fail'
+
+            (success, pnt) = transformer.TransformPoint(1, gcp.GCPX, gcp.GCPY)
+            if not success or abs(pnt[0] - gcp.GCPPixel) > 1e-6 or abs(pnt[1] - gcp.GCPLine) > 1e-6:
+                gdaltest.post_reason('fail')
+                print(num_threads, gcp.GCPX, gcp.GCPY, pnt)
+                return 'fail'
+
+    return 'success' 
+
 
 gdaltest_list = [
     tps_1,
+    tps_2,
     ]
 
 if __name__ == '__main__':
@@ -1240,6 +1240,109 @@ def warp_40():
 
     return 'success'
 
+###############################################################################
+# Test that the bilinear and cubic fast paths for Int16, UInt16 and Float32
+# (with and without SSE2) give the same result as the general case.
+
+def warp_41():
+
+    vrt_template = open('data/utmsmall_blinear.vrt', 'rt').read()
+    vrt_template = vrt_template.replace('relativeToVRT="1">../../gcore',
+                                        'relativeToVRT="0">../gcore')
+
+    for resampling in [ 'Bilinear', 'Cubic' ]:
+        for datatype in [ 'Int16', 'UInt16', 'Float32' ]:
+            vrt = vrt_template.replace('<ResampleAlg>Bilinear',
+                                       '<ResampleAlg>%s' % resampling)
+            vrt = vrt.replace('<WorkingDataType>Byte',
+                              '<WorkingDataType>%s' % datatype)
+            vrt = vrt.replace('dataType="Byte"', 'dataType="%s"' % datatype)
+            vrt_general = vrt.replace('<BandList>',
+                '<Option name="USE_GENERAL_CASE">TRUE</Option><BandList>')
+
+            ds = gdal.Open(vrt_general)
+            ref_cs = ds.GetRasterBand(1).Checksum()
+            ds = None
+
+            for use_sse in [ 'YES', 'NO' ]:
+                gdal.SetConfigOption('GDAL_USE_SSE', use_sse)
+                ds = gdal.Open(vrt)
+                cs = ds.GetRasterBand(1).Checksum()
+                ds = None
+                gdal.SetConfigOption('GDAL_USE_SSE', None)
+
+                if cs != ref_cs:
+                    gdaltest.post_reason('fail')
+                    print(resampling, datatype, use_sse, cs, ref_cs)
+                    return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that the bilinear and cubic specializations with a source nodata mask
+# give the same result as the general case.
+
+def warp_42():
+
+    vrt_template = open('data/utmsmall_blinear.vrt', 'rt').read()
+    vrt_template = vrt_template.replace('relativeToVRT="1">../../gcore',
+                                        'relativeToVRT="0">../gcore')
+    vrt_template = vrt_template.replace('<BandMapping src="1" dst="1"/>',
+        '<BandMapping src="1" dst="1"><SrcNoDataReal>107</SrcNoDataReal>' +
+        '<SrcNoDataImag>0</SrcNoDataImag></BandMapping>')
+
+    for resampling in [ 'Bilinear', 'Cubic' ]:
+        for datatype in [ 'Byte', 'Int16', 'UInt16', 'Float32', 'Float64' ]:
+            vrt = vrt_template.replace('<ResampleAlg>Bilinear',
+                                       '<ResampleAlg>%s' % resampling)
+            vrt = vrt.replace('<WorkingDataType>Byte',
+                              '<WorkingDataType>%s' % datatype)
+            vrt = vrt.replace('dataType="Byte"', 'dataType="%s"' % datatype)
+            vrt_general = vrt.replace('<BandList>',
+                '<Option name="USE_GENERAL_CASE">TRUE</Option><BandList>')
+
+            ds = gdal.Open(vrt_general)
+            ref_cs = ds.GetRasterBand(1).Checksum()
+            ds = None
+
+            ds = gdal.Open(vrt)
+            cs = ds.GetRasterBand(1).Checksum()
+            ds = None
+
+            if cs != ref_cs:
+                gdaltest.post_reason('fail')
+                print(resampling, datatype, cs, ref_cs)
+                return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test a multi-threaded warp of several chunks with a RPC transformer, whose
+# per-thread clones are reused from one chunk to the next.
+
+def warp_43():
+
+    if test_cli_utilities.get_gdalwarp_path() is None:
+        return 'skip'
+
+    cs = []
+    for num_threads in ['1', '2']:
+        gdaltest.runexternal(test_cli_utilities.get_gdalwarp_path() +
+            ' -overwrite -rpc -ts 1000 1000 -wm 1 -wo NUM_THREADS=' + num_threads +
+            ' ../gcore/data/byte_rpc.tif tmp/warp_43.tif')
+        ds = gdal.Open('tmp/warp_43.tif')
+        cs.append(ds.GetRasterBand(1).Checksum())
+        ds = None
+
+    gdal.Unlink('tmp/warp_43.tif')
+
+    if cs[0] != cs[1]:
+        gdaltest.post_reason('fail')
+        print(cs)
+        return 'fail'
+
+    return 'success'
+
 ###############################################################################
 
 gdaltest_list = [
@@ -1289,6 +1392,9 @@ gdaltest_list = [
     warp_39,
     warp_39,
     warp_40,
+    warp_41,
+    warp_42,
+    warp_43,
     ]
 
 
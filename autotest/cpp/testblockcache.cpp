@@ -0,0 +1,167 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  GDAL Core
+ * Purpose:  Test scalability of the raster block cache with several threads.
+ *
+ ******************************************************************************
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "gdal.h"
+#include "cpl_multiproc.h"
+#include "cpl_conv.h"
+
+#define RASTER_SIZE     1024
+#define ITERATIONS      200000
+
+typedef struct
+{
+    GDALDatasetH hDS;
+    int          nSeed;
+    int          nLines;        /* number of distinct lines read */
+    int          bError;
+} ThreadData;
+
+static void ReaderThread(void* pData)
+{
+    ThreadData* psData = (ThreadData*) pData;
+    GDALRasterBandH hBand = GDALGetRasterBand(psData->hDS, 1);
+    GByte abyLine[RASTER_SIZE];
+    unsigned int nRand = (unsigned int) psData->nSeed;
+
+    for(int i = 0; i < ITERATIONS; i++)
+    {
+        /* Cheap LCG, rand() is not thread-safe everywhere */
+        nRand = nRand * 1103515245U + 12345U;
+        int nLine = (int)((nRand >> 8) % psData->nLines);
+
+        if( GDALRasterIO(hBand, GF_Read, 0, nLine, RASTER_SIZE, 1,
+                         abyLine, RASTER_SIZE, 1, GDT_Byte, 0, 0) != CE_None ||
+            abyLine[0] != (GByte)(nLine & 0xff) ||
+            abyLine[RASTER_SIZE-1] != (GByte)(nLine & 0xff) )
+        {
+            psData->bError = TRUE;
+            return;
+        }
+    }
+}
+
+static GDALDatasetH CreateDataset()
+{
+    GDALDatasetH hDS = GDALCreate(GDALGetDriverByName("MEM"), "",
+                                  RASTER_SIZE, RASTER_SIZE, 1, GDT_Byte, NULL);
+    GDALRasterBandH hBand = GDALGetRasterBand(hDS, 1);
+    GByte abyLine[RASTER_SIZE];
+    for(int i = 0; i < RASTER_SIZE; i++)
+    {
+        memset(abyLine, i & 0xff, RASTER_SIZE);
+        GDALRasterIO(hBand, GF_Write, 0, i, RASTER_SIZE, 1,
+                     abyLine, RASTER_SIZE, 1, GDT_Byte, 0, 0);
+    }
+    GDALFlushCache(hDS);
+    return hDS;
+}
+
+int main(int argc, char* argv[])
+{
+    /* At least 4 threads, so that concurrent evictions are exercised */
+    int nMaxThreads = MAX(4, CPLGetNumCPUs());
+    int bError = FALSE;
+
+    if( argc == 2 )
+        nMaxThreads = atoi(argv[1]);
+    if( nMaxThreads < 1 )
+        nMaxThreads = 1;
+
+    GDALAllRegister();
+
+    /* Smaller than the total size of the datasets so that blocks get */
+    /* evicted while threads are reading. */
+    GDALSetCacheMax64((GIntBig)RASTER_SIZE * RASTER_SIZE / 2);
+
+    GDALDatasetH* pahDS = (GDALDatasetH*) CPLMalloc(nMaxThreads * sizeof(GDALDatasetH));
+    ThreadData* pasData = (ThreadData*) CPLMalloc(nMaxThreads * sizeof(ThreadData));
+    void** pahThreads = (void**) CPLMalloc(nMaxThreads * sizeof(void*));
+    for(int i = 0; i < nMaxThreads; i++)
+        pahDS[i] = CreateDataset();
+
+    for(int nThreads = 1; nThreads <= nMaxThreads; nThreads *= 2)
+    {
+        /* With several threads, the last run reads a few lines per */
+        /* dataset with a cache smaller than all of them, so that threads */
+        /* constantly evict the blocks that other threads are about to lock. */
+        int nLines = RASTER_SIZE;
+        if( nThreads > 1 && nThreads * 2 > nMaxThreads )
+        {
+            nLines = 4;
+            GDALSetCacheMax64((GIntBig)RASTER_SIZE * nLines * nThreads / 2);
+        }
+
+        clock_t start = clock();
+        time_t nWallStart = time(NULL);
+
+        for(int i = 0; i < nThreads; i++)
+        {
+            pasData[i].hDS = pahDS[i];
+            pasData[i].nSeed = i + 1;
+            pasData[i].nLines = nLines;
+            pasData[i].bError = FALSE;
+            pahThreads[i] = CPLCreateJoinableThread(ReaderThread, &pasData[i]);
+        }
+        for(int i = 0; i < nThreads; i++)
+        {
+            CPLJoinThread(pahThreads[i]);
+            if( pasData[i].bError )
+                bError = TRUE;
+        }
+
+        clock_t end = clock();
+        printf("%d thread(s), %d reads each : %.2f s CPU, %d s elapsed, "
+               "cache used = " CPL_FRMT_GIB "\n",
+               nThreads, ITERATIONS, (end - start) * 1.0 / CLOCKS_PER_SEC,
+               (int)(time(NULL) - nWallStart), GDALGetCacheUsed64());
+    }
+
+    for(int i = 0; i < nMaxThreads; i++)
+        GDALClose(pahDS[i]);
+    CPLFree(pahDS);
+    CPLFree(pasData);
+    CPLFree(pahThreads);
+
+    if( GDALGetCacheUsed64() != 0 )
+    {
+        printf("Cache used should be 0 after closing datasets\n");
+        bError = TRUE;
+    }
+
+    GDALDestroyDriverManager();
+
+    if( bError )
+    {
+        printf("ERROR\n");
+        return 1;
+    }
+    return 0;
+}
@@ -437,6 +437,64 @@ void check_GDT_CFloat32and64()
     }
 }
 
+/* Check that packed conversions, which may use SIMD code, give the same */
+/* results as the per-word code used for non packed buffers */
+void check_packed()
+{
+    const double adfValues[] = { 0, 0.4, 0.5, 0.6, 1.5, -0.4, -0.5, -0.6,
+        -1.5, -0.0, 127.5, 254.5, 254.6, 255.4, 255.5, 256, -1, 1000.7,
+        -32767.5, -32768.4, -32768.5, -40000, 32766.5, 32767.4, 32767.5,
+        40000, 65534.5, 65535.4, 65535.5, 70000, 1e10, -1e10, 3.25, 17.75,
+        12345.5, -12345.5, 42 };
+    const int nValues = (int)(sizeof(adfValues) / sizeof(adfValues[0]));
+    const GDALDataType aeTypes[] = { GDT_Byte, GDT_Int16, GDT_UInt16,
+        GDT_Int32, GDT_UInt32, GDT_Float32, GDT_Float64,
+        GDT_CInt16, GDT_CInt32, GDT_CFloat32, GDT_CFloat64 };
+    const int nTypes = (int)(sizeof(aeTypes) / sizeof(aeTypes[0]));
+    GByte abyIn[40 * 16], abyPacked[40 * 16], abyStrided[2 * 40 * 16];
+
+    for( int iIn = 0; iIn < nTypes; iIn++ )
+    {
+        GDALDataType eIn = aeTypes[iIn];
+        int nInSize = GDALGetDataTypeSize(eIn) / 8;
+        for( int k = 0; k < nValues; k++ )
+        {
+            double adfComplex[2];
+            adfComplex[0] = adfValues[k];
+            adfComplex[1] = adfValues[nValues - 1 - k];
+            GDALCopyWords(adfComplex, GDT_CFloat64, 0,
+                          abyIn + k * nInSize, eIn, 0, 1);
+        }
+
+        for( int iOut = 0; iOut < nTypes; iOut++ )
+        {
+            GDALDataType eOut = aeTypes[iOut];
+            int nOutSize = GDALGetDataTypeSize(eOut) / 8;
+
+            memset(abyPacked, 0, sizeof(abyPacked));
+            memset(abyStrided, 0, sizeof(abyStrided));
+            GDALCopyWords(abyIn, eIn, nInSize, abyPacked, eOut, nOutSize,
+                          nValues);
+            GDALCopyWords(abyIn, eIn, nInSize, abyStrided, eOut, 2 * nOutSize,
+                          nValues);
+
+            for( int k = 0; k < nValues; k++ )
+            {
+                if( memcmp(abyPacked + k * nOutSize,
+                           abyStrided + 2 * k * nOutSize, nOutSize) != 0 )
+                {
+                    std::cout << "Packed conversion from " <<
+                                 GDALGetDataTypeName(eIn) << " to " <<
+                                 GDALGetDataTypeName(eOut) <<
+                                 " differs for value " << adfValues[k] <<
+                                 std::endl;
+                    bErr = TRUE;
+                }
+            }
+        }
+    }
+}
+
 int main(int argc, char* argv[])
 {
     pIn = (char*)malloc(128);
@@ -451,6 +509,7 @@ int main(int argc, char* argv[])
     check_GDT_CInt16();
     check_GDT_CInt32();
     check_GDT_CFloat32and64();
+    check_packed();
     
     free(pIn);
     free(pOut);
@@ -46,8 +46,22 @@ def geoloc_1():
     return tst.testOpen()
 
 
+###############################################################################
+# Verify warped result with the inverse index instead of the backmap.
+
+def geoloc_2():
+
+    gdal.SetConfigOption( 'GDAL_GEOLOC_USE_INDEX', 'YES' )
+    tst = gdaltest.GDALTest( 'VRT', 'warpsst.vrt', 1, 63114 )
+    ret = tst.testOpen()
+    gdal.SetConfigOption( 'GDAL_GEOLOC_USE_INDEX', None )
+
+    return ret
+
+
 gdaltest_list = [
-    geoloc_1 ]
+    geoloc_1,
+    geoloc_2 ]
 
 if __name__ == '__main__':
 
@@ -1845,6 +1845,41 @@ def tiff_ovr_48():
 
     return 'success'
 
+###############################################################################
+# Test that overviews computed with several threads are the same as with
+# a single one, with the single band and the pixel interleaved code paths
+
+def tiff_ovr_49():
+
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    mem_ds = gdal.GetDriverByName('MEM').Create('', 601, 403, 3)
+    for i in range(3):
+        data = src_ds.GetRasterBand(i+1).ReadRaster(0,0,50,50,601,403)
+        mem_ds.GetRasterBand(i+1).WriteRaster(0,0,601,403,data)
+    src_ds = None
+
+    for options in [ [], ['COMPRESS=DEFLATE'] ]:
+        for resampling in [ 'NEAREST', 'AVERAGE', 'GAUSS', 'CUBIC' ]:
+            cs = []
+            for num_threads in [ '1', '4' ]:
+                ds = gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_ovr_49.tif', mem_ds, options = options)
+                old_val = gdal.GetConfigOption('GDAL_NUM_THREADS')
+                gdal.SetConfigOption('GDAL_NUM_THREADS', num_threads)
+                ds.BuildOverviews(resampling, [2, 4, 8])
+                gdal.SetConfigOption('GDAL_NUM_THREADS', old_val)
+                cs.append([ ds.GetRasterBand(i+1).GetOverview(j).Checksum() for i in range(3) for j in range(3) ])
+                ds = None
+                gdaltest.tiff_drv.Delete('/vsimem/tiff_ovr_49.tif')
+
+            if cs[0] != cs[1]:
+                gdaltest.post_reason('did not get expected checksums')
+                print(options)
+                print(resampling)
+                print(cs)
+                return 'fail'
+
+    return 'success'
+
 ###############################################################################
 # Cleanup
 
@@ -1938,6 +1973,7 @@ gdaltest_list_internal = [
     tiff_ovr_46,
     tiff_ovr_47,
     tiff_ovr_48,
+    tiff_ovr_49,
     tiff_ovr_cleanup ]
 
 def tiff_ovr_invert_endianness():
@@ -1260,6 +1260,51 @@ def tiff_read_irregular_tile_size_jpeg_in_tiff():
 
     return 'success'
 
+###############################################################################
+# Test that multi-block reads decoded by worker threads (NUM_THREADS open
+# option) return the same data as single-threaded reads, and that
+# GDAL_NUM_THREADS alone does not enable them
+
+def tiff_read_multi_threaded_decoding():
+
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    for options in [ ['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16', 'COMPRESS=DEFLATE'],
+                     ['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16', 'COMPRESS=LZW', 'INTERLEAVE=BAND'],
+                     ['BLOCKYSIZE=3', 'COMPRESS=PACKBITS'] ]:
+        gdal.GetDriverByName('GTiff').CreateCopy('/vsimem/tiff_read_multi_threaded_decoding.tif', src_ds, options = options)
+
+        ds = gdal.Open('/vsimem/tiff_read_multi_threaded_decoding.tif')
+        ref_data = ds.ReadRaster(0, 0, 50, 50)
+        ref_band_data = ds.GetRasterBand(2).ReadRaster(5, 7, 40, 40)
+        ds = None
+
+        ds = gdal.OpenEx('/vsimem/tiff_read_multi_threaded_decoding.tif',
+                         open_options = ['NUM_THREADS=4'])
+        data = ds.ReadRaster(0, 0, 50, 50)
+        ds.FlushCache()
+        band_data = ds.GetRasterBand(2).ReadRaster(5, 7, 40, 40)
+        ds = None
+
+        if data != ref_data or band_data != ref_band_data:
+            gdaltest.post_reason('fail')
+            print(options)
+            return 'fail'
+
+        gdal.SetConfigOption('GDAL_NUM_THREADS', '4')
+        ds = gdal.Open('/vsimem/tiff_read_multi_threaded_decoding.tif')
+        data = ds.ReadRaster(0, 0, 50, 50)
+        ds = None
+        gdal.SetConfigOption('GDAL_NUM_THREADS', None)
+
+        gdal.Unlink('/vsimem/tiff_read_multi_threaded_decoding.tif')
+
+        if data != ref_data:
+            gdaltest.post_reason('fail')
+            print(options)
+            return 'fail'
+
+    return 'success'
+
 ###############################################################################################
 
 for item in init_list:
@@ -1314,6 +1359,7 @@ gdaltest_list.append( (tiff_read_huge4GB) )
 gdaltest_list.append( (tiff_read_bigtiff) )
 gdaltest_list.append( (tiff_read_tiff_metadata) )
 gdaltest_list.append( (tiff_read_irregular_tile_size_jpeg_in_tiff) )
+gdaltest_list.append( (tiff_read_multi_threaded_decoding) )
 
 if __name__ == '__main__':
 
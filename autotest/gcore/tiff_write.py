@@ -5029,6 +5029,110 @@ def tiff_write_127():
     return 'success'
     
 
+###############################################################################
+# Test multi-threaded compression with NUM_THREADS
+
+def tiff_write_128():
+
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    ref_cs = [ src_ds.GetRasterBand(i+1).Checksum() for i in range(3) ]
+
+    for options in [ [ 'COMPRESS=DEFLATE' ],
+                     [ 'COMPRESS=LZW', 'PREDICTOR=2', 'BLOCKYSIZE=3' ],
+                     [ 'COMPRESS=PACKBITS', 'TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16' ],
+                     [ 'COMPRESS=DEFLATE', 'TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16', 'INTERLEAVE=BAND' ] ]:
+
+        ds = gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_write_128.tif', src_ds,
+                                          options = options + [ 'NUM_THREADS=4' ])
+        ds = None
+
+        ds = gdal.Open('/vsimem/tiff_write_128.tif')
+        cs = [ ds.GetRasterBand(i+1).Checksum() for i in range(3) ]
+        ds = None
+        if cs != ref_cs:
+            gdaltest.post_reason('fail')
+            print(options)
+            print(cs)
+            return 'fail'
+
+    # Rewrite existing blocks in update mode, and read them back before close
+    gdal.SetConfigOption('GDAL_NUM_THREADS', '4')
+    ds = gdal.Open('/vsimem/tiff_write_128.tif', gdal.GA_Update)
+    ds.GetRasterBand(1).Fill(255)
+    ds.FlushCache()
+    cs = ds.GetRasterBand(1).Checksum()
+    ds = None
+    gdal.SetConfigOption('GDAL_NUM_THREADS', None)
+    if cs != 30658:
+        gdaltest.post_reason('fail')
+        print(cs)
+        return 'fail'
+
+    ds = gdal.Open('/vsimem/tiff_write_128.tif')
+    cs = [ ds.GetRasterBand(i+1).Checksum() for i in range(3) ]
+    ds = None
+    if cs != [ 30658, ref_cs[1], ref_cs[2] ]:
+        gdaltest.post_reason('fail')
+        print(cs)
+        return 'fail'
+
+    gdaltest.tiff_drv.Delete('/vsimem/tiff_write_128.tif')
+
+    return 'success'
+
+###############################################################################
+# Test that CreateCopy() gives the same result when swaths are read in
+# worker threads (GDAL_COPY_NUM_THREADS)
+
+def tiff_write_129():
+
+    vrt_xml = """<VRTDataset rasterXSize="2000" rasterYSize="2000">"""
+    for i in range(3):
+        vrt_xml += """
+  <VRTRasterBand dataType="Byte" band="%d">
+    <SimpleSource>
+      <SourceFilename relativeToVRT="0">data/rgbsmall.tif</SourceFilename>
+      <SourceBand>%d</SourceBand>
+      <SrcRect xOff="0" yOff="0" xSize="50" ySize="50"/>
+      <DstRect xOff="0" yOff="0" xSize="2000" ySize="2000"/>
+    </SimpleSource>
+  </VRTRasterBand>""" % (i+1, i+1)
+    vrt_xml += """
+</VRTDataset>"""
+    # Materialize the source, as the result of the upsampling of the VRT
+    # depends on the request windows
+    src_ds = gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_write_129_src.tif',
+                                          gdal.Open(vrt_xml),
+                                          options = [ 'TILED=YES' ])
+    src_ds = None
+    src_ds = gdal.Open('/vsimem/tiff_write_129_src.tif')
+    ref_cs = [ src_ds.GetRasterBand(i+1).Checksum() for i in range(3) ]
+
+    for num_threads in [ None, '2', '4' ]:
+        for options in [ [ 'COMPRESS=DEFLATE', 'TILED=YES' ],
+                         [ 'INTERLEAVE=BAND' ] ]:
+            gdal.SetConfigOption('GDAL_COPY_NUM_THREADS', num_threads)
+            ds = gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_write_129.tif', src_ds,
+                                              options = options)
+            ds = None
+            gdal.SetConfigOption('GDAL_COPY_NUM_THREADS', None)
+
+            ds = gdal.Open('/vsimem/tiff_write_129.tif')
+            cs = [ ds.GetRasterBand(i+1).Checksum() for i in range(3) ]
+            ds = None
+            if cs != ref_cs:
+                gdaltest.post_reason('fail')
+                print(num_threads)
+                print(options)
+                print(cs)
+                return 'fail'
+
+    src_ds = None
+    gdaltest.tiff_drv.Delete('/vsimem/tiff_write_129.tif')
+    gdaltest.tiff_drv.Delete('/vsimem/tiff_write_129_src.tif')
+
+    return 'success'
+
 ###############################################################################
 # Ask to run again tests with GDAL_API_PROXY=YES
 
@@ -5187,6 +5291,8 @@ gdaltest_list = [
     tiff_write_125,
     tiff_write_126,
     tiff_write_127,
+    tiff_write_128,
+    tiff_write_129,
     #tiff_write_api_proxy,
     tiff_write_cleanup ]
 
@@ -37,6 +37,7 @@ from sys import version_info
 sys.path.append( '../pymod' )
 
 import gdaltest
+import webserver
 
 ###############################################################################
 #
@@ -286,6 +287,50 @@ def vsicurl_11():
 
     return 'success'
 
+###############################################################################
+# Test reading several strips with VSIFReadMultiRangeL() from a local server,
+# with the various ways of downloading the ranges
+
+def vsicurl_multirange():
+    try:
+        drv = gdal.GetDriverByName( 'HTTP' )
+    except:
+        drv = None
+
+    if drv is None:
+        return 'skip'
+
+    (process, port) = webserver.launch()
+    if port == 0:
+        return 'skip'
+
+    ref_ds = gdal.Open('data/byte_bigtiff_strip5lines.tif')
+    ref_data = ref_ds.ReadRaster(0, 0, 20, 20)
+    ref_ds = None
+
+    ret = 'success'
+    gdal.SetConfigOption('CPL_VSIL_CURL_MULTIRANGE_GAP', '0')
+    for mode in [ 'PARALLEL', 'SINGLE_GET', 'SERIAL' ]:
+        gdal.SetConfigOption('CPL_VSIL_CURL_MULTIRANGE', mode)
+        ds = gdal.Open('/vsicurl/http://127.0.0.1:%d/datafile/byte_bigtiff_strip5lines.tif' % port)
+        if ds is None:
+            gdaltest.post_reason('fail')
+            ret = 'fail'
+            break
+        data = ds.ReadRaster(0, 0, 20, 20)
+        ds = None
+        if data != ref_data:
+            gdaltest.post_reason('fail')
+            print(mode)
+            ret = 'fail'
+            break
+    gdal.SetConfigOption('CPL_VSIL_CURL_MULTIRANGE', None)
+    gdal.SetConfigOption('CPL_VSIL_CURL_MULTIRANGE_GAP', None)
+
+    webserver.server_stop(process, port)
+
+    return ret
+
 gdaltest_list = [ vsicurl_1,
                   vsicurl_2,
                   vsicurl_3,
@@ -296,7 +341,8 @@ gdaltest_list = [ vsicurl_1,
                   vsicurl_8,
                   vsicurl_9,
                   vsicurl_10,
-                  vsicurl_11 ]
+                  vsicurl_11,
+                  vsicurl_multirange ]
 
 if __name__ == '__main__':
 
@@ -276,14 +276,140 @@ def vsifile_6():
     return 'success'
 
 ###############################################################################
-# Test vsicache above 2 GB
+# Test that handles opened with VSI_CACHE on the same file share the cache,
+# and that the cache is not used after the file has been modified
+
+def vsifile_7():
+
+    fp = gdal.VSIFOpenL('tmp/vsifile_7.bin', 'wb')
+    gdal.VSIFWriteL('0123456789', 1, 10, fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('VSI_CACHE', 'YES')
+    fp1 = gdal.VSIFOpenL('tmp/vsifile_7.bin', 'rb')
+    fp2 = gdal.VSIFOpenL('tmp/vsifile_7.bin', 'rb')
+    gdal.SetConfigOption('VSI_CACHE', None)
+    data1 = gdal.VSIFReadL(1, 10, fp1).decode('ascii')
+    gdal.VSIFSeekL(fp2, 5, 0)
+    data2 = gdal.VSIFReadL(1, 10, fp2).decode('ascii')
+    gdal.VSIFCloseL(fp1)
+    gdal.VSIFCloseL(fp2)
+
+    if data1 != '0123456789' or data2 != '56789':
+        gdaltest.post_reason('fail')
+        print(data1)
+        print(data2)
+        return 'fail'
+
+    fp = gdal.VSIFOpenL('tmp/vsifile_7.bin', 'wb')
+    gdal.VSIFWriteL('abcdefghijkl', 1, 12, fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('VSI_CACHE', 'YES')
+    fp = gdal.VSIFOpenL('tmp/vsifile_7.bin', 'rb')
+    gdal.SetConfigOption('VSI_CACHE', None)
+    data = gdal.VSIFReadL(1, 12, fp).decode('ascii')
+    gdal.VSIFCloseL(fp)
+
+    gdal.Unlink('tmp/vsifile_7.bin')
+
+    if data != 'abcdefghijkl':
+        gdaltest.post_reason('fail')
+        print(data)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test readahead (VSI_READAHEAD) on a /vsigzip/ stream
+
+def vsifile_8():
+
+    ref_data = ''.join(['%08X' % i for i in range(50000)])
+    fp = gdal.VSIFOpenL('/vsigzip/tmp/vsifile_8.bin.gz', 'wb')
+    gdal.VSIFWriteL(ref_data, 1, len(ref_data), fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('VSI_READAHEAD', 'YES')
+    gdal.SetConfigOption('VSI_READAHEAD_BLOCK_SIZE', '10000')
+    fp = gdal.VSIFOpenL('/vsigzip/tmp/vsifile_8.bin.gz', 'rb')
+    gdal.SetConfigOption('VSI_READAHEAD', None)
+    gdal.SetConfigOption('VSI_READAHEAD_BLOCK_SIZE', None)
+
+    data = ''
+    while True:
+        chunk = gdal.VSIFReadL(1, 3000, fp)
+        if len(chunk) == 0:
+            break
+        data += chunk.decode('ascii')
+
+    gdal.VSIFSeekL(fp, 100000, 0)
+    data2 = gdal.VSIFReadL(1, 16, fp).decode('ascii')
+    gdal.VSIFSeekL(fp, 50, 0)
+    data3 = gdal.VSIFReadL(1, 16, fp).decode('ascii')
+    gdal.VSIFCloseL(fp)
+
+    gdal.Unlink('tmp/vsifile_8.bin.gz')
+
+    if data != ref_data:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if data2 != ref_data[100000:100016] or data3 != ref_data[50:66]:
+        gdaltest.post_reason('fail')
+        print(data2)
+        print(data3)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that vsicache does not serve blocks of the previous content of a file
+# rewritten with the same size (and likely the same modification time)
+
+def vsifile_9():
+
+    fp = gdal.VSIFOpenL('tmp/vsifile_9.bin', 'wb')
+    gdal.VSIFWriteL('0123456789', 1, 10, fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('VSI_CACHE', 'YES')
+    fp = gdal.VSIFOpenL('tmp/vsifile_9.bin', 'rb')
+    gdal.SetConfigOption('VSI_CACHE', None)
+    data = gdal.VSIFReadL(1, 10, fp).decode('ascii')
+    gdal.VSIFCloseL(fp)
+    if data != '0123456789':
+        gdaltest.post_reason('fail')
+        print(data)
+        return 'fail'
+
+    fp = gdal.VSIFOpenL('tmp/vsifile_9.bin', 'wb')
+    gdal.VSIFWriteL('abcdefghij', 1, 10, fp)
+    gdal.VSIFCloseL(fp)
+
+    gdal.SetConfigOption('VSI_CACHE', 'YES')
+    fp = gdal.VSIFOpenL('tmp/vsifile_9.bin', 'rb')
+    gdal.SetConfigOption('VSI_CACHE', None)
+    data = gdal.VSIFReadL(1, 10, fp).decode('ascii')
+    gdal.VSIFCloseL(fp)
+
+    gdal.Unlink('tmp/vsifile_9.bin')
+
+    if data != 'abcdefghij':
+        gdaltest.post_reason('fail')
+        print(data)
+        return 'fail'
+
+    return 'success'
 
 gdaltest_list = [ vsifile_1,
                   vsifile_2,
                   vsifile_3,
                   vsifile_4,
                   vsifile_5,
-                  vsifile_6 ]
+                  vsifile_6,
+                  vsifile_7,
+                  vsifile_8,
+                  vsifile_9 ]
 
 if __name__ == '__main__':
 
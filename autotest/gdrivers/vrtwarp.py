@@ -93,10 +93,55 @@ def vrtwarp_3():
 
     return 'success'
 
+###############################################################################
+# Test that the implicit and explicit overviews of a warped VRT are computed
+# from the source overview matching their resolution.
+
+def vrtwarp_4():
+
+    src_ds = gdal.Open( '../gcore/data/byte.tif' )
+    tmp_ds = gdal.GetDriverByName('GTiff').Create( 'tmp/vrtwarp_4.tif', 400, 400 )
+    tmp_ds.SetGeoTransform( [ 440720, 3, 0, 3751320, 0, -3 ] )
+    tmp_ds.SetProjection( src_ds.GetProjectionRef() )
+    tmp_ds.GetRasterBand(1).WriteRaster( 0, 0, 400, 400,
+                                         src_ds.ReadRaster( 0, 0, 20, 20, 400, 400 ) )
+    src_ds = None
+    tmp_ds.BuildOverviews( 'AVERAGE', overviewlist = [2, 4] )
+    expected_cs = [ tmp_ds.GetRasterBand(1).GetOverview(i).Checksum() for i in range(2) ]
+
+    vrt_ds = gdal.AutoCreateWarpedVRT( tmp_ds )
+    tmp_ds = None
+
+    if vrt_ds.GetRasterBand(1).GetOverviewCount() != 2:
+        gdaltest.post_reason( 'fail' )
+        print(vrt_ds.GetRasterBand(1).GetOverviewCount())
+        return 'fail'
+    cs = [ vrt_ds.GetRasterBand(1).GetOverview(i).Checksum() for i in range(2) ]
+    if cs != expected_cs:
+        gdaltest.post_reason( 'fail' )
+        print(cs)
+        print(expected_cs)
+        return 'fail'
+
+    vrt_ds.BuildOverviews( 'NEAR', overviewlist = [2, 4] )
+    cs = [ vrt_ds.GetRasterBand(1).GetOverview(i).Checksum() for i in range(2) ]
+    vrt_ds = None
+
+    gdal.GetDriverByName('GTiff').Delete( 'tmp/vrtwarp_4.tif' )
+
+    if cs != expected_cs:
+        gdaltest.post_reason( 'fail' )
+        print(cs)
+        print(expected_cs)
+        return 'fail'
+
+    return 'success'
+
 gdaltest_list = [
     vrtwarp_1,
     vrtwarp_2,
-    vrtwarp_3 ]
+    vrtwarp_3,
+    vrtwarp_4 ]
 
 if __name__ == '__main__':
 
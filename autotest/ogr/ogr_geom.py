@@ -909,6 +909,43 @@ def ogr_geom_getenvelope3d():
 
     return 'success'
 
+###############################################################################
+# Test WKB round-tripping and envelopes of line strings and polygons with
+# odd and even point counts, in both byte orders and coordinate dimensions.
+
+def ogr_geom_wkb_byte_order_roundtrip():
+
+    for wkt in [ 'LINESTRING (1 2,-3 4,5 -6)',
+                 'LINESTRING (1 2,-3 4,5 -6,7 8)',
+                 'LINESTRING (1 2 3,-3 4 -5,5 -6 7)',
+                 'LINESTRING (1 2 3,-3 4 -5,5 -6 7,-7 8 9)',
+                 'POLYGON ((0 0,10 0,10 -10,0 0),(1 -1,2 -1,2 -2,1 -1))',
+                 'POLYGON ((0 0 1,10 0 2,10 -10 -3,0 0 1))' ]:
+        g = ogr.CreateGeometryFromWkt(wkt)
+        for byte_order in [ ogr.wkbNDR, ogr.wkbXDR ]:
+            g2 = ogr.CreateGeometryFromWkb(g.ExportToWkb(byte_order))
+            if g2.ExportToWkt() != g.ExportToWkt():
+                gdaltest.post_reason('fail')
+                print(wkt)
+                print(g2.ExportToWkt())
+                return 'fail'
+            if g2.GetEnvelope3D() != g.GetEnvelope3D():
+                gdaltest.post_reason('fail')
+                print(wkt)
+                print(g2.GetEnvelope3D())
+                return 'fail'
+
+    g = ogr.CreateGeometryFromWkt('LINESTRING (1 2 3,-3 4 -5,5 -6 7,-7 8 9)')
+    envelope = g.GetEnvelope3D()
+    expected_envelope = ( -7, 5, -6, 8, -5, 9 )
+    if envelope != expected_envelope:
+        gdaltest.post_reason('did not get expected envelope')
+        print(envelope)
+        print(expected_envelope)
+        return 'fail'
+
+    return 'success'
+
 ###############################################################################
 # cleanup
 
@@ -947,6 +984,7 @@ gdaltest_list = [
     ogr_geom_getpoints,
     ogr_geom_mixed_coordinate_dimension,
     ogr_geom_getenvelope3d,
+    ogr_geom_wkb_byte_order_roundtrip,
     ogr_geom_cleanup ]
 
 if __name__ == '__main__':
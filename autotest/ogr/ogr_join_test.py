@@ -484,6 +484,62 @@ def ogr_join_21():
     else:
         return 'fail'
 
+###############################################################################
+# Test that the join hash table gives the same result as attribute filtering,
+# either keeping the secondary features in memory or only their FIDs, and
+# with a string key that must be matched case insensitively.
+
+def ogr_join_22():
+
+    ds = ogr.GetDriverByName('Memory').CreateDataSource('')
+    lyr = ds.CreateLayer('first')
+    lyr.CreateField(ogr.FieldDefn('key', ogr.OFTString))
+    lyr.CreateField(ogr.FieldDefn('num', ogr.OFTInteger))
+    for (key, num) in [ ('a', 1), ('B', 2), ('c', 3), (None, 4) ]:
+        feat = ogr.Feature(lyr.GetLayerDefn())
+        if key is not None:
+            feat.SetField('key', key)
+        feat.SetField('num', num)
+        lyr.CreateFeature(feat)
+
+    lyr = ds.CreateLayer('second')
+    lyr.CreateField(ogr.FieldDefn('key', ogr.OFTString))
+    lyr.CreateField(ogr.FieldDefn('num', ogr.OFTReal))
+    lyr.CreateField(ogr.FieldDefn('val', ogr.OFTString))
+    for (key, num, val) in [ ('A', 2, 'x'), ('b', 1, 'y'), ('B', 1, 'z') ]:
+        feat = ogr.Feature(lyr.GetLayerDefn())
+        feat.SetField('key', key)
+        feat.SetField('num', num)
+        feat.SetField('val', val)
+        lyr.CreateFeature(feat)
+
+    for max_memory in [ None, '0' ]:
+        gdal.SetConfigOption('OGR_GENSQL_JOIN_HASH_MAX_MEMORY', max_memory)
+
+        sql_lyr = ds.ExecuteSQL(
+            'SELECT first.num, second.val FROM first LEFT JOIN second ON first.key = second.key' )
+        vals = [ feat.GetField('second.val') for feat in sql_lyr ]
+        ds.ReleaseResultSet( sql_lyr )
+        if vals != [ 'x', 'y', None, None ]:
+            gdaltest.post_reason( 'fail' )
+            print(vals)
+            gdal.SetConfigOption('OGR_GENSQL_JOIN_HASH_MAX_MEMORY', None)
+            return 'fail'
+
+        sql_lyr = ds.ExecuteSQL(
+            'SELECT first.key, second.val FROM first LEFT JOIN second ON first.num = second.num' )
+        vals = [ feat.GetField('second.val') for feat in sql_lyr ]
+        ds.ReleaseResultSet( sql_lyr )
+        if vals != [ 'y', 'x', None, None ]:
+            gdaltest.post_reason( 'fail' )
+            print(vals)
+            gdal.SetConfigOption('OGR_GENSQL_JOIN_HASH_MAX_MEMORY', None)
+            return 'fail'
+
+    gdal.SetConfigOption('OGR_GENSQL_JOIN_HASH_MAX_MEMORY', None)
+
+    return 'success'
+
 ###############################################################################
 
 def ogr_join_cleanup():
@@ -515,6 +571,7 @@ gdaltest_list = [
     ogr_join_19,
     ogr_join_20,
     ogr_join_21,
+    ogr_join_22,
     ogr_join_cleanup ]
 
 if __name__ == '__main__':
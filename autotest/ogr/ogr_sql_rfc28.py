@@ -921,6 +921,51 @@ def ogr_rfc28_41():
 
     return 'success'
 
+###############################################################################
+# Check that the compiled form of attribute filters selects the same features
+# as the evaluation of the expression tree.
+
+def ogr_rfc28_42():
+
+    ds = ogr.GetDriverByName("Memory").CreateDataSource( "my_ds")
+    lyr = ds.CreateLayer( "my_layer")
+    lyr.CreateField(ogr.FieldDefn('i', ogr.OFTInteger))
+    lyr.CreateField(ogr.FieldDefn('r', ogr.OFTReal))
+    lyr.CreateField(ogr.FieldDefn('s', ogr.OFTString))
+    for (i, r, s) in [ (1, 1.5, 'abc'), (2, None, 'ABD'), (None, -2.0, None),
+                       (3, 3.0, 'x_y'), (0, 0.0, '') ]:
+        feat = ogr.Feature(lyr.GetLayerDefn())
+        if i is not None:
+            feat.SetField('i', i)
+        if r is not None:
+            feat.SetField('r', r)
+        if s is not None:
+            feat.SetField('s', s)
+        lyr.CreateFeature(feat)
+
+    filters = [ 'i > r', 'i <> 0 AND r >= 0', 'i IN (1, 3) OR s = \'abd\'',
+                's LIKE \'a%\'', 'i BETWEEN 1 AND 2', 'NOT (i = 3)',
+                'r IS NULL OR s IS NULL', 'i + 1 = 3', 'i / 0 = 2147483647',
+                'i % 2 = 1', 'r % 2 = 1', 's > \'ab\'', 'i = \'3\'',
+                'SUBSTR(s, 1, 1) = \'a\' AND i > 0', 'FID = 2' ]
+
+    for filter in filters:
+        fids = []
+        for compile_where in [ 'YES', 'NO' ]:
+            gdal.SetConfigOption('OGR_SQL_COMPILE_WHERE', compile_where)
+            lyr.SetAttributeFilter( filter )
+            fids.append( [ feat.GetFID() for feat in lyr ] )
+            gdal.SetConfigOption('OGR_SQL_COMPILE_WHERE', None)
+        if fids[0] != fids[1]:
+            gdaltest.post_reason('fail')
+            print(filter)
+            print(fids)
+            return 'fail'
+
+    ds = None
+
+    return 'success'
+
 ###############################################################################
 def ogr_rfc28_cleanup():
     gdaltest.lyr = None
@@ -972,6 +1017,7 @@ gdaltest_list = [
     ogr_rfc28_39,
     ogr_rfc28_40,
     ogr_rfc28_41,
+    ogr_rfc28_42,
     ogr_rfc28_cleanup ]
 
 if __name__ == '__main__':
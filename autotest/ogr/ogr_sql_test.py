@@ -1354,6 +1354,159 @@ def ogr_sql_44():
 
     return 'success'
 
+###############################################################################
+# Test ORDER BY with sorted runs spilled to disk, and ORDER BY ... LIMIT
+
+def ogr_sql_45():
+
+    sql = 'SELECT eas_id, prfedea FROM poly ORDER BY area DESC'
+    sql_lyr = gdaltest.ds.ExecuteSQL( sql )
+    expected = [ f.GetField('eas_id') for f in sql_lyr ]
+    gdaltest.ds.ReleaseResultSet( sql_lyr )
+
+    if len(expected) != 10:
+        gdaltest.post_reason('fail')
+        print(expected)
+        return 'fail'
+
+    # Only a few features fit in each sorted run
+    gdal.SetConfigOption('OGR_GENSQL_SORT_MAX_MEMORY', '0.0001')
+    sql_lyr = gdaltest.ds.ExecuteSQL( sql )
+    got = [ f.GetField('eas_id') for f in sql_lyr ]
+    gdaltest.ds.ReleaseResultSet( sql_lyr )
+    gdal.SetConfigOption('OGR_GENSQL_SORT_MAX_MEMORY', None)
+
+    if got != expected:
+        gdaltest.post_reason('fail')
+        print(got)
+        print(expected)
+        return 'fail'
+
+    for max_memory in [ None, '0.0001' ]:
+        gdal.SetConfigOption('OGR_GENSQL_SORT_MAX_MEMORY', max_memory)
+        sql_lyr = gdaltest.ds.ExecuteSQL( sql + ' LIMIT 3' )
+        gdal.SetConfigOption('OGR_GENSQL_SORT_MAX_MEMORY', None)
+        if sql_lyr.GetFeatureCount() != 3:
+            gdaltest.post_reason('fail')
+            return 'fail'
+        got = [ f.GetField('eas_id') for f in sql_lyr ]
+        gdaltest.ds.ReleaseResultSet( sql_lyr )
+        if got != expected[0:3]:
+            gdaltest.post_reason('fail')
+            print(max_memory)
+            print(got)
+            return 'fail'
+
+    sql_lyr = gdaltest.ds.ExecuteSQL( 'SELECT * FROM poly LIMIT 0' )
+    feat = sql_lyr.GetNextFeature()
+    gdaltest.ds.ReleaseResultSet( sql_lyr )
+    if feat is not None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test GROUP BY, with and without spilling groups to temporary files
+
+def ogr_sql_46():
+
+    ds = ogr.GetDriverByName('Memory').CreateDataSource('ogr_sql_46')
+    lyr = ds.CreateLayer('layer')
+    lyr.CreateField(ogr.FieldDefn('strfield', ogr.OFTString))
+    lyr.CreateField(ogr.FieldDefn('intfield', ogr.OFTInteger))
+    lyr.CreateField(ogr.FieldDefn('floatfield', ogr.OFTReal))
+    for i in range(100):
+        feat = ogr.Feature(lyr.GetLayerDefn())
+        if i % 10 != 9:
+            feat.SetField(0, 'key%d' % (i % 10))
+        feat.SetField(1, i % 3)
+        if i % 7 != 0:
+            feat.SetField(2, i)
+        lyr.CreateFeature(feat)
+    feat = None
+
+    # Expected values of each group, by strfield
+    expected = []
+    for k in range(10):
+        values = [ i for i in range(k, 100, 10) if i % 7 != 0 ]
+        if k == 9:
+            key = None
+        else:
+            key = 'key%d' % k
+        expected.append( [ key, 10, len(values), sum(values), min(values),
+                           max(values), float(sum(values)) / len(values),
+                           len(set([ i % 3 for i in range(k, 100, 10) ])) ] )
+    # NULL sorts first
+    expected = [ expected[9] ] + expected[0:9]
+
+    sql = 'SELECT strfield, COUNT(*), COUNT(floatfield), SUM(floatfield), ' \
+          'MIN(floatfield), MAX(floatfield), AVG(floatfield), ' \
+          'COUNT(DISTINCT intfield) FROM layer GROUP BY strfield ORDER BY strfield'
+
+    for max_memory in [ None, '0.0001' ]:
+        gdal.SetConfigOption('OGR_GENSQL_GROUP_BY_MAX_MEMORY', max_memory)
+        sql_lyr = ds.ExecuteSQL( sql )
+        feature_count = sql_lyr.GetFeatureCount()
+        gdal.SetConfigOption('OGR_GENSQL_GROUP_BY_MAX_MEMORY', None)
+        if feature_count != 10:
+            gdaltest.post_reason('fail')
+            print(max_memory)
+            return 'fail'
+        got = []
+        for feat in sql_lyr:
+            row = []
+            for i in range(8):
+                if feat.IsFieldSet(i):
+                    row.append(feat.GetField(i))
+                else:
+                    row.append(None)
+            got.append(row)
+        ds.ReleaseResultSet( sql_lyr )
+        if got != expected:
+            gdaltest.post_reason('fail')
+            print(max_memory)
+            print(got)
+            print(expected)
+            return 'fail'
+
+    # Several GROUP BY fields, unordered
+    sql_lyr = ds.ExecuteSQL( 'SELECT intfield, strfield, COUNT(*) AS n FROM layer '
+                             'WHERE strfield IS NOT NULL GROUP BY strfield, intfield' )
+    got = {}
+    for feat in sql_lyr:
+        got[(feat.GetField('strfield'), feat.GetField('intfield'))] = feat.GetField('n')
+    ds.ReleaseResultSet( sql_lyr )
+    if len(got) != 27 or sum(got.values()) != 90 or got[('key0', 0)] != 4:
+        gdaltest.post_reason('fail')
+        print(got)
+        return 'fail'
+
+    # A group without non-null value gets NULL aggregates
+    sql_lyr = ds.ExecuteSQL( 'SELECT intfield, SUM(floatfield) FROM layer '
+                             'WHERE floatfield IS NULL GROUP BY intfield ORDER BY intfield DESC LIMIT 1' )
+    feat = sql_lyr.GetNextFeature()
+    if feat.GetField(0) != 2 or feat.IsFieldSet(1) or sql_lyr.GetNextFeature() is not None:
+        gdaltest.post_reason('fail')
+        feat.DumpReadable()
+        return 'fail'
+    ds.ReleaseResultSet( sql_lyr )
+
+    for sql in [ 'SELECT floatfield FROM layer GROUP BY strfield',
+                 'SELECT strfield FROM layer GROUP BY strfield ORDER BY intfield',
+                 'SELECT CAST(strfield AS integer) FROM layer GROUP BY strfield',
+                 'SELECT COUNT(*) FROM layer GROUP BY foo' ]:
+        gdal.PushErrorHandler('CPLQuietErrorHandler')
+        sql_lyr = ds.ExecuteSQL( sql )
+        gdal.PopErrorHandler()
+        if sql_lyr is not None:
+            gdaltest.post_reason('fail')
+            print(sql)
+            ds.ReleaseResultSet( sql_lyr )
+            return 'fail'
+
+    return 'success'
+
 def ogr_sql_cleanup():
     gdaltest.lyr = None
     gdaltest.ds.Destroy()
@@ -1407,6 +1560,8 @@ gdaltest_list = [
     ogr_sql_42,
     ogr_sql_43,
     ogr_sql_44,
+    ogr_sql_45,
+    ogr_sql_46,
     ogr_sql_cleanup ]
 
 if __name__ == '__main__':
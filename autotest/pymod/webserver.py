@@ -71,6 +71,61 @@ class GDAL_Handler(BaseHTTPRequestHandler):
 
         return
 
+    # Serve a file of the data/ directory of the current test directory,
+    # honouring (multi-)range requests
+    def send_data_file(self, head_only):
+        filename = 'data/' + self.path[len('/datafile/'):]
+        try:
+            f = open(filename, 'rb')
+            content = f.read()
+            f.close()
+        except IOError:
+            self.send_error(404,'File Not Found: %s' % self.path)
+            return
+
+        range_header = self.headers.get('Range')
+        if head_only or range_header is None or range_header.find('bytes=') != 0:
+            self.send_response(200)
+            self.send_header('Content-Length', len(content))
+            self.end_headers()
+            if not head_only:
+                self.wfile.write(content)
+            return
+
+        ranges = []
+        for r in range_header[len('bytes='):].split(','):
+            (start, end) = r.split('-')
+            ranges.append((int(start), min(int(end), len(content) - 1)))
+
+        self.send_response(206)
+        if len(ranges) == 1:
+            (start, end) = ranges[0]
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (start, end, len(content)))
+            self.send_header('Content-Length', end - start + 1)
+            self.end_headers()
+            self.wfile.write(content[start:end+1])
+            return
+
+        boundary = 'GDAL_RANGE_BOUNDARY'
+        body = ''.encode('ascii')
+        for (start, end) in ranges:
+            body += ('--%s\r\n' % boundary).encode('ascii')
+            body += ('Content-Range: bytes %d-%d/%d\r\n\r\n' % (start, end, len(content))).encode('ascii')
+            body += content[start:end+1]
+            body += '\r\n'.encode('ascii')
+        body += ('--%s--\r\n' % boundary).encode('ascii')
+        self.send_header('Content-Type', 'multipart/byteranges; boundary=%s' % boundary)
+        self.send_header('Content-Length', len(body))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_HEAD(self):
+        if self.path.find('/datafile/') == 0:
+            self.send_data_file(True)
+            return
+
+        self.send_error(404,'File Not Found: %s' % self.path)
+
     def do_GET(self):
 
         try:
@@ -87,6 +142,10 @@ class GDAL_Handler(BaseHTTPRequestHandler):
                 self.server.stop_requested = True
                 return
 
+            if self.path.find('/datafile/') == 0:
+                self.send_data_file(False)
+                return
+
             if self.path == '/index.html':
                 self.send_response(200)
                 self.send_header('Content-type', 'text/html')
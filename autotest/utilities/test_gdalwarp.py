@@ -1060,6 +1060,87 @@ def test_gdalwarp_37():
 
     return 'success'
 
+###############################################################################
+# Test -multi with several chunks in flight (NUM_THREADS warping option)
+
+def test_gdalwarp_38():
+    if test_cli_utilities.get_gdalwarp_path() is None:
+        return 'skip'
+
+    gdaltest.runexternal(test_cli_utilities.get_gdalwarp_path() + ' -wm 1 -ts 2000 2000 -r bilinear ./data/utmsmall.tif tmp/testgdalwarp38_ref.tif')
+    gdaltest.runexternal(test_cli_utilities.get_gdalwarp_path() + ' -wm 1 -ts 2000 2000 -r bilinear -multi -wo NUM_THREADS=4 ./data/utmsmall.tif tmp/testgdalwarp38.tif')
+
+    ref_ds = gdal.Open('tmp/testgdalwarp38_ref.tif')
+    ds = gdal.Open('tmp/testgdalwarp38.tif')
+    if ds is None or ref_ds is None:
+        return 'fail'
+
+    if ds.GetRasterBand(1).Checksum() != ref_ds.GetRasterBand(1).Checksum():
+        gdaltest.post_reason('Bad checksum')
+        return 'fail'
+
+    ds = None
+    ref_ds = None
+
+    return 'success'
+
+###############################################################################
+# Test the 2D grid mode of the approximate transformer (exact for an affine
+# transformation)
+
+def test_gdalwarp_39():
+    if test_cli_utilities.get_gdalwarp_path() is None:
+        return 'skip'
+
+    gdaltest.runexternal(test_cli_utilities.get_gdalwarp_path() + ' -et 0 -ts 500 500 tmp/testgdalwarp_gcp.tif tmp/testgdalwarp39_ref.tif')
+    gdaltest.runexternal(test_cli_utilities.get_gdalwarp_path() + ' -et 0.125 -ts 500 500 --config GDAL_APPROX_TRANSFORMER_2D YES tmp/testgdalwarp_gcp.tif tmp/testgdalwarp39.tif')
+
+    ref_ds = gdal.Open('tmp/testgdalwarp39_ref.tif')
+    ds = gdal.Open('tmp/testgdalwarp39.tif')
+    if ds is None or ref_ds is None:
+        return 'fail'
+
+    if ds.GetRasterBand(1).Checksum() != ref_ds.GetRasterBand(1).Checksum():
+        gdaltest.post_reason('Bad checksum')
+        return 'fail'
+
+    ds = None
+    ref_ds = None
+
+    return 'success'
+
+###############################################################################
+# Test the 2D grid mode of the approximate transformer with a non linear
+# transformation. With such a small error threshold, cells get split down to
+# the maximum depth and the remaining points are transformed exactly, so the
+# result must match the exact warp.
+
+def test_gdalwarp_40():
+    if test_cli_utilities.get_gdalwarp_path() is None:
+        return 'skip'
+
+    if test_cli_utilities.get_gdal_translate_path() is None:
+        return 'skip'
+
+    gdaltest.runexternal(test_cli_utilities.get_gdal_translate_path() + ' -a_srs EPSG:26711 -gcp 0 0 440720 3751320 -gcp 20 0 441920 3751320 -gcp 20 20 441920 3750120 -gcp 0 20 440720 3750120 -gcp 10 10 441400 3750600 ../gcore/data/byte.tif tmp/testgdalwarp40_gcp.tif')
+
+    gdaltest.runexternal(test_cli_utilities.get_gdalwarp_path() + ' -tps -et 0 -ts 500 500 tmp/testgdalwarp40_gcp.tif tmp/testgdalwarp40_ref.tif')
+    gdaltest.runexternal(test_cli_utilities.get_gdalwarp_path() + ' -tps -et 0.000001 -ts 500 500 --config GDAL_APPROX_TRANSFORMER_2D YES tmp/testgdalwarp40_gcp.tif tmp/testgdalwarp40.tif')
+
+    ref_ds = gdal.Open('tmp/testgdalwarp40_ref.tif')
+    ds = gdal.Open('tmp/testgdalwarp40.tif')
+    if ds is None or ref_ds is None:
+        return 'fail'
+
+    if ds.GetRasterBand(1).Checksum() != ref_ds.GetRasterBand(1).Checksum():
+        gdaltest.post_reason('Bad checksum')
+        return 'fail'
+
+    ds = None
+    ref_ds = None
+
+    return 'success'
+
 ###############################################################################
 # Cleanup
 
@@ -1069,7 +1150,7 @@ def test_gdalwarp_cleanup():
     if gdal.GetConfigOption( 'CPL_DEBUG', 'OFF' ) == 'ON':
         return 'success'
     
-    for i in range(37):
+    for i in range(40):
         try:
             os.remove('tmp/testgdalwarp' + str(i+1) + '.tif')
         except:
@@ -1110,6 +1191,22 @@ def test_gdalwarp_cleanup():
         os.remove('tmp/testgdalwarp37.tif')
     except:
         pass
+    try:
+        os.remove('tmp/testgdalwarp38_ref.tif')
+    except:
+        pass
+    try:
+        os.remove('tmp/testgdalwarp39_ref.tif')
+    except:
+        pass
+    try:
+        os.remove('tmp/testgdalwarp40_gcp.tif')
+    except:
+        pass
+    try:
+        os.remove('tmp/testgdalwarp40_ref.tif')
+    except:
+        pass
     return 'success'
 
 gdaltest_list = [
@@ -1151,6 +1248,9 @@ gdaltest_list = [
     test_gdalwarp_35,
     test_gdalwarp_36,
     test_gdalwarp_37,
+    test_gdalwarp_38,
+    test_gdalwarp_39,
+    test_gdalwarp_40,
     test_gdalwarp_cleanup
     ]
 
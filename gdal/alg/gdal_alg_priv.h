@@ -175,13 +175,27 @@ void GDALCleanupTransformDeserializerMutex();
 void* GDALCloneTPSTransformer( void *pTransformArg );
 void* GDALCloneGenImgProjTransformer( void *pTransformArg );
 void* GDALCloneApproxTransformer( void *pTransformArg );
-/* TODO : GDALCloneGeoLocTransformer? , GDALCloneRPCTransformer? */ 
+void* GDALCloneGeoLocTransformer( void *pTransformArg );
+void* GDALCloneRPCTransformer( void *pTransformArg );
+void* GDALCloneReprojectionTransformer( void *pTransformArg );
 
 void* GDALCreateTPSTransformerInt( int nGCPCount, const GDAL_GCP *pasGCPList, 
                                    int bReversed, char** papszOptions );
 
 void CPL_DLL * GDALCloneTransformer( void *pTranformerArg );
 
+/* Pool of clones of a transformer, reused by successive multi-threaded */
+/* operations such as the warping of the chunks of a GDALWarpOperation */
+
+typedef struct _GDALTransformerClonePool GDALTransformerClonePool;
+
+GDALTransformerClonePool *GDALCreateTransformerClonePool( void *pTransformArg );
+void GDALDestroyTransformerClonePool( GDALTransformerClonePool *psPool );
+GDALTransformerClonePool *GDALGetTransformerClonePool( void *pTransformArg );
+void *GDALTransformerClonePoolAcquire( GDALTransformerClonePool *psPool );
+void GDALTransformerClonePoolRelease( GDALTransformerClonePool *psPool,
+                                      void *pClonedTransformArg );
+
 /************************************************************************/
 /*      Float comparison function.                                      */
 /************************************************************************/
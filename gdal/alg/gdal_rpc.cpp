@@ -30,6 +30,7 @@
 
 #include "gdal_priv.h"
 #include "gdal_alg.h"
+#include "gdal_alg_priv.h"
 #include "ogr_spatialref.h"
 #include "cpl_minixml.h"
 
@@ -174,19 +175,34 @@ static void RPCComputeTerms( double dfLong, double dfLat, double dfHeight,
 }
 
 /************************************************************************/
-/*                            RPCEvaluate()                             */
+/*                            RPCEvaluate4()                            */
+/*                                                                      */
+/*      Evaluate the four polynomials of the RPC model in a single      */
+/*      pass over the terms.                                            */
 /************************************************************************/
 
-static double RPCEvaluate( double *padfTerms, double *padfCoefs )
+static void RPCEvaluate4( const double *padfTerms,
+                          const double *padfCoefs1, const double *padfCoefs2,
+                          const double *padfCoefs3, const double *padfCoefs4,
+                          double *pdfSum1, double *pdfSum2,
+                          double *pdfSum3, double *pdfSum4 )
 
 {
-    double dfSum = 0.0;
+    double dfSum1 = 0.0, dfSum2 = 0.0, dfSum3 = 0.0, dfSum4 = 0.0;
     int i;
 
     for( i = 0; i < 20; i++ )
-        dfSum += padfTerms[i] * padfCoefs[i];
+    {
+        dfSum1 += padfTerms[i] * padfCoefs1[i];
+        dfSum2 += padfTerms[i] * padfCoefs2[i];
+        dfSum3 += padfTerms[i] * padfCoefs3[i];
+        dfSum4 += padfTerms[i] * padfCoefs4[i];
+    }
 
-    return dfSum;
+    *pdfSum1 = dfSum1;
+    *pdfSum2 = dfSum2;
+    *pdfSum3 = dfSum3;
+    *pdfSum4 = dfSum4;
 }
 
 /************************************************************************/
@@ -200,18 +216,21 @@ static void RPCTransformPoint( GDALRPCInfo *psRPC,
 {
     double dfResultX, dfResultY;
     double adfTerms[20];
+    double dfSampNum, dfSampDen, dfLineNum, dfLineDen;
    
     RPCComputeTerms( 
         (dfLong   - psRPC->dfLONG_OFF) / psRPC->dfLONG_SCALE, 
         (dfLat    - psRPC->dfLAT_OFF) / psRPC->dfLAT_SCALE, 
         (dfHeight - psRPC->dfHEIGHT_OFF) / psRPC->dfHEIGHT_SCALE,
         adfTerms );
+
+    RPCEvaluate4( adfTerms,
+                  psRPC->adfSAMP_NUM_COEFF, psRPC->adfSAMP_DEN_COEFF,
+                  psRPC->adfLINE_NUM_COEFF, psRPC->adfLINE_DEN_COEFF,
+                  &dfSampNum, &dfSampDen, &dfLineNum, &dfLineDen );
     
-    dfResultX = RPCEvaluate( adfTerms, psRPC->adfSAMP_NUM_COEFF )
-        / RPCEvaluate( adfTerms, psRPC->adfSAMP_DEN_COEFF );
-    
-    dfResultY = RPCEvaluate( adfTerms, psRPC->adfLINE_NUM_COEFF )
-        / RPCEvaluate( adfTerms, psRPC->adfLINE_DEN_COEFF );
+    dfResultX = dfSampNum / dfSampDen;
+    dfResultY = dfLineNum / dfLineDen;
     
     *pdfPixel = dfResultX * psRPC->dfSAMP_SCALE + psRPC->dfSAMP_OFF;
     *pdfLine = dfResultY * psRPC->dfLINE_SCALE + psRPC->dfLINE_OFF;
@@ -230,6 +249,11 @@ typedef enum {
   /*! Cubic Convolution Approximation (4x4 kernel) */  DRA_Cubic=2
 } DEMResampleAlg;
 
+/* A DEM window is only read for a GDALRPCTransform() call if it has */
+/* no more than this many pixels per transformed point.  Otherwise   */
+/* the per point reads through the block cache are cheaper.          */
+#define RPC_DEM_WINDOW_PIXELS_PER_POINT 64
+
 typedef struct {
 
     GDALTransformerInfo sTI;
@@ -253,6 +277,13 @@ typedef struct {
     int         bHasTriedOpeningDS;
     GDALDataset *poDS;
 
+    /* DEM values of the whole DEM, or of the last window read */
+    double      *padfDEMBuffer;
+    int         nDEMBufferXOff;
+    int         nDEMBufferYOff;
+    int         nDEMBufferXSize;
+    int         nDEMBufferYSize;
+
     OGRCoordinateTransformation *poCT;
 
     double      adfGeoTransform[6];
@@ -489,6 +520,8 @@ void GDALDestroyRPCTransformer( void *pTransformAlg )
 
     CPLFree( psTransform->pszDEMPath );
 
+    CPLFree( psTransform->padfDEMBuffer );
+
     if(psTransform->poDS)
         GDALClose(psTransform->poDS);
     if(psTransform->poCT)
@@ -497,6 +530,40 @@ void GDALDestroyRPCTransformer( void *pTransformAlg )
     CPLFree( pTransformAlg );
 }
 
+/************************************************************************/
+/*                       GDALCloneRPCTransformer()                      */
+/************************************************************************/
+
+void *GDALCloneRPCTransformer( void *hTransformArg )
+
+{
+    VALIDATE_POINTER1( hTransformArg, "GDALCloneRPCTransformer", NULL );
+
+    GDALRPCTransformInfo *psTransform = 
+        (GDALRPCTransformInfo *) hTransformArg;
+
+    GDALRPCTransformInfo *psClone = (GDALRPCTransformInfo *)
+        CPLMalloc(sizeof(GDALRPCTransformInfo));
+
+/* -------------------------------------------------------------------- */
+/*      The RPC coefficients and the affine approximation are kept      */
+/*      as they are. The DEM, its coordinate transformation and the     */
+/*      DEM buffer are owned by each instance, so the clone reopens     */
+/*      the DEM lazily on first use.                                    */
+/* -------------------------------------------------------------------- */
+    memcpy( psClone, psTransform, sizeof(GDALRPCTransformInfo) );
+    if( psTransform->pszDEMPath != NULL )
+        psClone->pszDEMPath = CPLStrdup( psTransform->pszDEMPath );
+    psClone->bHasTriedOpeningDS = FALSE;
+    psClone->poDS = NULL;
+    psClone->poCT = NULL;
+    psClone->padfDEMBuffer = NULL;
+    psClone->nDEMBufferXSize = 0;
+    psClone->nDEMBufferYSize = 0;
+
+    return psClone;
+}
+
 /************************************************************************/
 /*                      RPCInverseTransformPoint()                      */
 /************************************************************************/
@@ -589,6 +656,305 @@ double BiCubicKernel(double dfVal)
 	return ( 0.16666666666666666667 * ( a - ( 4.0 * b ) + ( 6.0 * c ) - ( 4.0 * d ) ) );
 }
 
+/************************************************************************/
+/*                         RPCLoadDEMWindow()                           */
+/*                                                                      */
+/*      Read into psTransform->padfDEMBuffer the DEM values needed to   */
+/*      interpolate the heights at the given DEM pixel/line locations.  */
+/*      The whole DEM is read once if it is small enough compared to    */
+/*      the block cache size.  Otherwise the window covering the        */
+/*      points is read, unless it is too large for the number of        */
+/*      points, in which case RPCGetDEMKernel() falls back to reading   */
+/*      each kernel from the DEM.  Only the points for which            */
+/*      panSuccess[] is TRUE are considered.                            */
+/************************************************************************/
+
+static void RPCLoadDEMWindow( GDALRPCTransformInfo *psTransform,
+                              int nPointCount,
+                              const double *padfDEMX, const double *padfDEMY,
+                              const int *panSuccess )
+
+{
+    int nRasterXSize = psTransform->poDS->GetRasterXSize();
+    int nRasterYSize = psTransform->poDS->GetRasterYSize();
+    GIntBig nMaxPixels = GDALGetCacheMax64() / (4 * sizeof(double));
+    int nXOff, nYOff, nXSize, nYSize;
+    int i;
+
+    if( psTransform->padfDEMBuffer != NULL
+        && psTransform->nDEMBufferXSize == nRasterXSize
+        && psTransform->nDEMBufferYSize == nRasterYSize )
+        return;
+
+    if( (GIntBig) nRasterXSize * nRasterYSize <= nMaxPixels )
+    {
+        nXOff = 0;
+        nYOff = 0;
+        nXSize = nRasterXSize;
+        nYSize = nRasterYSize;
+    }
+    else
+    {
+/* -------------------------------------------------------------------- */
+/*      Compute the window covering the interpolation kernels.          */
+/* -------------------------------------------------------------------- */
+        int nBefore = 0, nAfter = 1;
+        int nXMin = nRasterXSize, nYMin = nRasterYSize, nXMax = 0, nYMax = 0;
+
+        if( psTransform->eResampleAlg == DRA_Cubic )
+        {
+            nBefore = 1;
+            nAfter = 3;
+        }
+        else if( psTransform->eResampleAlg == DRA_Bilinear )
+            nAfter = 2;
+
+        for( i = 0; i < nPointCount; i++ )
+        {
+            if( !panSuccess[i] 
+                || !(padfDEMX[i] > -1 && padfDEMX[i] < nRasterXSize
+                     && padfDEMY[i] > -1 && padfDEMY[i] < nRasterYSize) )
+                continue;
+
+            int dX = int(padfDEMX[i]);
+            int dY = int(padfDEMY[i]);
+            nXMin = MIN(nXMin, dX - nBefore);
+            nYMin = MIN(nYMin, dY - nBefore);
+            nXMax = MAX(nXMax, dX + nAfter);
+            nYMax = MAX(nYMax, dY + nAfter);
+        }
+
+        nXOff = MAX(nXMin, 0);
+        nYOff = MAX(nYMin, 0);
+        nXSize = MIN(nXMax, nRasterXSize) - nXOff;
+        nYSize = MIN(nYMax, nRasterYSize) - nYOff;
+        if( nXSize <= 0 || nYSize <= 0 )
+            return;
+
+        /* Already in the buffer from a previous call ? */
+        if( psTransform->padfDEMBuffer != NULL
+            && nXOff >= psTransform->nDEMBufferXOff
+            && nYOff >= psTransform->nDEMBufferYOff
+            && nXOff + nXSize <= psTransform->nDEMBufferXOff
+                                 + psTransform->nDEMBufferXSize
+            && nYOff + nYSize <= psTransform->nDEMBufferYOff
+                                 + psTransform->nDEMBufferYSize )
+            return;
+
+        GIntBig nPixels = (GIntBig) nXSize * nYSize;
+        if( nPixels > nMaxPixels
+            || nPixels > (GIntBig) nPointCount * RPC_DEM_WINDOW_PIXELS_PER_POINT )
+            return;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Read the window.  The bilinear and cubic interpolations have    */
+/*      always worked on elevations fetched as Int32, so keep doing     */
+/*      that to preserve results.                                       */
+/* -------------------------------------------------------------------- */
+    int nValues = nXSize * nYSize;
+    int bands[1] = {1};
+    CPLErr eErr;
+
+    CPLFree( psTransform->padfDEMBuffer );
+    psTransform->nDEMBufferXSize = 0;
+    psTransform->nDEMBufferYSize = 0;
+    psTransform->padfDEMBuffer = (double *)
+        VSIMalloc2( sizeof(double), nValues );
+    if( psTransform->padfDEMBuffer == NULL )
+        return;
+
+    if( psTransform->eResampleAlg == DRA_NearestNeighbour )
+    {
+        eErr = psTransform->poDS->RasterIO( GF_Read, nXOff, nYOff,
+                                            nXSize, nYSize,
+                                            psTransform->padfDEMBuffer,
+                                            nXSize, nYSize, GDT_Float64,
+                                            1, bands, 0, 0, 0 );
+    }
+    else
+    {
+        GInt32 *panData = (GInt32 *) VSIMalloc2( sizeof(GInt32), nValues );
+
+        if( panData == NULL )
+            eErr = CE_Failure;
+        else
+            eErr = psTransform->poDS->RasterIO( GF_Read, nXOff, nYOff,
+                                                nXSize, nYSize,
+                                                panData,
+                                                nXSize, nYSize, GDT_Int32,
+                                                1, bands, 0, 0, 0 );
+        for( i = 0; eErr == CE_None && i < nValues; i++ )
+            psTransform->padfDEMBuffer[i] = panData[i];
+
+        CPLFree( panData );
+    }
+
+    if( eErr != CE_None )
+    {
+        CPLFree( psTransform->padfDEMBuffer );
+        psTransform->padfDEMBuffer = NULL;
+        return;
+    }
+
+    psTransform->nDEMBufferXOff = nXOff;
+    psTransform->nDEMBufferYOff = nYOff;
+    psTransform->nDEMBufferXSize = nXSize;
+    psTransform->nDEMBufferYSize = nYSize;
+}
+
+/************************************************************************/
+/*                         RPCGetDEMKernel()                            */
+/*                                                                      */
+/*      Return a pointer to the DEM values of the nKernelSize x         */
+/*      nKernelSize window whose top left corner is (nX,nY), taken      */
+/*      from the DEM buffer when it covers it, or read into             */
+/*      padfKernel (16 values) otherwise.  The window must be inside    */
+/*      the DEM.  *pnLineStride receives the stride of the returned     */
+/*      values.                                                         */
+/************************************************************************/
+
+static const double *RPCGetDEMKernel( GDALRPCTransformInfo *psTransform,
+                                      int nX, int nY, int nKernelSize,
+                                      double *padfKernel, int *pnLineStride )
+
+{
+    if( psTransform->padfDEMBuffer != NULL
+        && nX >= psTransform->nDEMBufferXOff
+        && nY >= psTransform->nDEMBufferYOff
+        && nX + nKernelSize <= psTransform->nDEMBufferXOff
+                               + psTransform->nDEMBufferXSize
+        && nY + nKernelSize <= psTransform->nDEMBufferYOff
+                               + psTransform->nDEMBufferYSize )
+    {
+        *pnLineStride = psTransform->nDEMBufferXSize;
+        return psTransform->padfDEMBuffer
+            + (nX - psTransform->nDEMBufferXOff)
+            + (nY - psTransform->nDEMBufferYOff)
+                * psTransform->nDEMBufferXSize;
+    }
+
+    int bands[1] = {1};
+    CPLErr eErr;
+
+    if( psTransform->eResampleAlg == DRA_NearestNeighbour )
+    {
+        eErr = psTransform->poDS->RasterIO( GF_Read, nX, nY,
+                                            nKernelSize, nKernelSize,
+                                            padfKernel,
+                                            nKernelSize, nKernelSize,
+                                            GDT_Float64,
+                                            1, bands, 0, 0, 0 );
+    }
+    else
+    {
+        GInt32 anElevData[16] = {0};
+
+        eErr = psTransform->poDS->RasterIO( GF_Read, nX, nY,
+                                            nKernelSize, nKernelSize,
+                                            anElevData,
+                                            nKernelSize, nKernelSize,
+                                            GDT_Int32,
+                                            1, bands, 0, 0, 0 );
+        for( int i = 0; i < nKernelSize * nKernelSize; i++ )
+            padfKernel[i] = anElevData[i];
+    }
+
+    if( eErr != CE_None )
+        return NULL;
+
+    *pnLineStride = nKernelSize;
+    return padfKernel;
+}
+
+/************************************************************************/
+/*                         RPCGetDEMHeight()                            */
+/*                                                                      */
+/*      Interpolate the DEM at the given DEM pixel/line location.       */
+/************************************************************************/
+
+static int RPCGetDEMHeight( GDALRPCTransformInfo *psTransform,
+                            double dfX, double dfY, double *pdfDEMH )
+
+{
+    int nRasterXSize = psTransform->poDS->GetRasterXSize();
+    int nRasterYSize = psTransform->poDS->GetRasterYSize();
+    int dX = int(dfX);
+    int dY = int(dfY);
+    double dfDeltaX = dfX - dX;
+    double dfDeltaY = dfY - dY;
+    double adfKernel[16];
+    const double *padfElev;
+    int nStride;
+
+    if(psTransform->eResampleAlg == DRA_Cubic)
+    {
+        int dXNew = dX - 1;
+        int dYNew = dY - 1;
+        if (!(dXNew >= 0 && dYNew >= 0 && dXNew + 4 <= nRasterXSize && dYNew + 4 <= nRasterYSize))
+            return FALSE;
+
+        //cubic interpolation
+        padfElev = RPCGetDEMKernel( psTransform, dXNew, dYNew, 4, adfKernel,
+                                    &nStride );
+        if( padfElev == NULL )
+            return FALSE;
+
+        double dfSumH(0);
+        for ( int i = 0; i < 4; i++ )
+        {
+            // Loop across the X axis
+            for ( int j = 0; j < 4; j++ )
+            {
+                // Calculate the weight for the specified pixel according
+                // to the bicubic b-spline kernel we're using for
+                // interpolation
+                int dKernIndX = j - 1;
+                int dKernIndY = i - 1;
+                double dfPixelWeight = BiCubicKernel(dKernIndX - dfDeltaX) * BiCubicKernel(dKernIndY - dfDeltaY);
+
+                // Create a sum of all values
+                // adjusted for the pixel's calculated weight
+                dfSumH += padfElev[j + i * nStride] * dfPixelWeight;
+            }
+        }
+        *pdfDEMH = dfSumH;
+    }
+    else if(psTransform->eResampleAlg == DRA_Bilinear)
+    {
+        if (!(dX >= 0 && dY >= 0 && dX + 2 <= nRasterXSize && dY + 2 <= nRasterYSize))
+            return FALSE;
+
+        //bilinear interpolation
+        padfElev = RPCGetDEMKernel( psTransform, dX, dY, 2, adfKernel,
+                                    &nStride );
+        if( padfElev == NULL )
+            return FALSE;
+
+        double dfDeltaX1 = 1.0 - dfDeltaX;                
+        double dfDeltaY1 = 1.0 - dfDeltaY;
+
+        double dfXZ1 = padfElev[0] * dfDeltaX1 + padfElev[1] * dfDeltaX;
+        double dfXZ2 = padfElev[nStride] * dfDeltaX1 + padfElev[nStride + 1] * dfDeltaX;
+        double dfYZ = dfXZ1 * dfDeltaY1 + dfXZ2 * dfDeltaY;
+        *pdfDEMH = dfYZ;
+    }
+    else
+    {
+        if (!(dX >= 0 && dY >= 0 && dX < nRasterXSize && dY < nRasterYSize))
+            return FALSE;
+
+        padfElev = RPCGetDEMKernel( psTransform, dX, dY, 1, adfKernel,
+                                    &nStride );
+        if( padfElev == NULL )
+            return FALSE;
+
+        *pdfDEMH = padfElev[0];
+    }
+
+    return TRUE;
+}
+
 /************************************************************************/
 /*                          GDALRPCTransform()                          */
 /************************************************************************/
@@ -608,7 +974,6 @@ int GDALRPCTransform( void *pTransformArg, int bDstToSrc,
     if( psTransform->bReversed )
         bDstToSrc = !bDstToSrc;
 
-    int bands[1] = {1};
     int nRasterXSize = 0, nRasterYSize = 0;
 
 /* -------------------------------------------------------------------- */
@@ -659,284 +1024,130 @@ int GDALRPCTransform( void *pTransformArg, int bDstToSrc,
     }
 
 /* -------------------------------------------------------------------- */
-/*      The simple case is transforming from lat/long to pixel/line.    */
-/*      Just apply the equations directly.                              */
+/*      Without a DEM, the simple case is transforming from lat/long    */
+/*      to pixel/line: just apply the equations directly.  The          */
+/*      inverse (pixel/line/height to lat/long) uses an iterative       */
+/*      method from an initial linear approximation.                    */
 /* -------------------------------------------------------------------- */
-    if( bDstToSrc )
+    if( psTransform->poDS == NULL )
     {
         for( i = 0; i < nPointCount; i++ )
         {
-            if(psTransform->poDS)
-            {
-                double dfX, dfY;
-                //check if dem is not in WGS84 and transform points padfX[i], padfY[i]
-                if(psTransform->poCT)
-                {
-                    double dfXOrig = padfX[i];
-                    double dfYOrig = padfY[i];
-                    double dfZOrig = padfZ[i];
-                    if (!psTransform->poCT->Transform(
-                                                1, &dfXOrig, &dfYOrig, &dfZOrig))
-                    {
-                        panSuccess[i] = FALSE;
-                        continue;
-                    }
-                    GDALApplyGeoTransform( psTransform->adfReverseGeoTransform,
-                                           dfXOrig, dfYOrig, &dfX, &dfY );
-                }
-                else
-                    GDALApplyGeoTransform( psTransform->adfReverseGeoTransform,
-                                           padfX[i], padfY[i], &dfX, &dfY );
-                int dX = int(dfX);
-                int dY = int(dfY);
-
-                if (!(dX >= 0 && dY >= 0 &&
-                      dX+2 <= nRasterXSize && dY+2 <= nRasterYSize))
-                {
-                    panSuccess[i] = FALSE;
-                    continue;
-                }
-
-                double dfDEMH(0);
-                double dfDeltaX = dfX - dX;
-                double dfDeltaY = dfY - dY;
-                
-                if(psTransform->eResampleAlg == DRA_Cubic)
-                {
-                    int dXNew = dX - 1;
-                    int dYNew = dY - 1;
-                    if (!(dXNew >= 0 && dYNew >= 0 && dXNew + 4 <= nRasterXSize && dYNew + 4 <= nRasterYSize))
-                    {
-                        panSuccess[i] = FALSE;
-                        continue;
-                    }
-                    //cubic interpolation
-                    int anElevData[16] = {0};
-                    CPLErr eErr = psTransform->poDS->RasterIO(GF_Read, dXNew, dYNew, 4, 4,
-                                                              &anElevData, 4, 4,
-                                                              GDT_Int32, 1, bands, 0, 0, 0);
-                    if(eErr != CE_None)
-                    {
-                        panSuccess[i] = FALSE;
-                        continue;
-                    }
-
-                    double dfSumH(0);
-                    for ( int i = 0; i < 4; i++ )
-                    {
-                        // Loop across the X axis
-                        for ( int j = 0; j < 4; j++ )
-                        {
-                            // Calculate the weight for the specified pixel according
-                            // to the bicubic b-spline kernel we're using for
-                            // interpolation
-                            int dKernIndX = j - 1;
-                            int dKernIndY = i - 1;
-                            double dfPixelWeight = BiCubicKernel(dKernIndX - dfDeltaX) * BiCubicKernel(dKernIndY - dfDeltaY);
-
-                            // Create a sum of all values
-                            // adjusted for the pixel's calculated weight
-                            dfSumH += anElevData[j + i * 4] * dfPixelWeight;
-                        }
-                    }
-                    dfDEMH = dfSumH;
-                }
-                else if(psTransform->eResampleAlg == DRA_Bilinear)
-                {
-                    if (!(dX >= 0 && dY >= 0 && dX + 2 <= nRasterXSize && dY + 2 <= nRasterYSize))
-                    {
-                        panSuccess[i] = FALSE;
-                        continue;
-                    }
-                    //bilinear interpolation
-                    int anElevData[4] = {0,0,0,0};
-                    CPLErr eErr = psTransform->poDS->RasterIO(GF_Read, dX, dY, 2, 2,
-                                                              &anElevData, 2, 2,
-                                                              GDT_Int32, 1, bands, 0, 0, 0);
-                    if(eErr != CE_None)
-                    {
-                        panSuccess[i] = FALSE;
-                        continue;
-                    }
-                    double dfDeltaX1 = 1.0 - dfDeltaX;                
-                    double dfDeltaY1 = 1.0 - dfDeltaY;
-
-                    double dfXZ1 = anElevData[0] * dfDeltaX1 + anElevData[1] * dfDeltaX;
-                    double dfXZ2 = anElevData[2] * dfDeltaX1 + anElevData[3] * dfDeltaX;
-                    double dfYZ = dfXZ1 * dfDeltaY1 + dfXZ2 * dfDeltaY;
-                    dfDEMH = dfYZ;
-                }
-                else
-                {
-                    if (!(dX >= 0 && dY >= 0 && dX < nRasterXSize && dY < nRasterYSize))
-                    {
-                        panSuccess[i] = FALSE;
-                        continue;
-                    }
-                    CPLErr eErr = psTransform->poDS->RasterIO(GF_Read, dX, dY, 1, 1,
-                                                              &dfDEMH, 1, 1,
-                                                              GDT_Float64, 1, bands, 0, 0, 0);
-                    if(eErr != CE_None)
-                    {
-                        panSuccess[i] = FALSE;
-                        continue;
-                    }              
-                }                
-
-                RPCTransformPoint( psRPC, padfX[i], padfY[i], 
-                                   padfZ[i] + (psTransform->dfHeightOffset + dfDEMH) *
-                                                psTransform->dfHeightScale, 
+            double dfHeight = padfZ[i] + psTransform->dfHeightOffset *
+                                         psTransform->dfHeightScale;
+
+            if( bDstToSrc )
+                RPCTransformPoint( psRPC, padfX[i], padfY[i], dfHeight,
                                    padfX + i, padfY + i );
-            }
             else
-                RPCTransformPoint( psRPC, padfX[i], padfY[i], 
-                                   padfZ[i] + psTransform->dfHeightOffset *
-                                              psTransform->dfHeightScale, 
-                                   padfX + i, padfY + i );
+                RPCInverseTransformPoint( psTransform, padfX[i], padfY[i],
+                                          dfHeight, padfX + i, padfY + i );
             panSuccess[i] = TRUE;
         }
 
         return TRUE;
     }
 
+    if( nPointCount <= 0 )
+        return TRUE;
+
 /* -------------------------------------------------------------------- */
-/*      Compute the inverse (pixel/line/height to lat/long).  This      */
-/*      function uses an iterative method from an initial linear        */
-/*      approximation.                                                  */
+/*      With a DEM, first compute for every point the DEM pixel/line    */
+/*      location where the height must be interpolated, so that the     */
+/*      DEM window they need can be read at once.                       */
 /* -------------------------------------------------------------------- */
+    double *padfDEMX = (double *)
+        VSIMalloc2( sizeof(double), 2 * (size_t) nPointCount );
+    if( padfDEMX == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "GDALRPCTransform(): out of memory." );
+        for( i = 0; i < nPointCount; i++ )
+            panSuccess[i] = FALSE;
+        return FALSE;
+    }
+    double *padfDEMY = padfDEMX + nPointCount;
+
     for( i = 0; i < nPointCount; i++ )
     {
-        double dfResultX, dfResultY;
+        double dfLong, dfLat;
 
-        if(psTransform->poDS)
+        if( bDstToSrc )
+        {
+            dfLong = padfX[i];
+            dfLat = padfY[i];
+        }
+        else
         {
             RPCInverseTransformPoint( psTransform, padfX[i], padfY[i], 
                       padfZ[i] + psTransform->dfHeightOffset *
                                  psTransform->dfHeightScale,
-                      &dfResultX, &dfResultY );
+                      &dfLong, &dfLat );
+        }
 
-            double dfX, dfY;
-            //check if dem is not in WGS84 and transform points padfX[i], padfY[i]
-            if(psTransform->poCT)
+        //check if dem is not in WGS84 and transform points padfX[i], padfY[i]
+        if(psTransform->poCT)
+        {
+            double dfZ = bDstToSrc ? padfZ[i] : 0;
+            if (!psTransform->poCT->Transform(1, &dfLong, &dfLat, &dfZ))
             {
-                double dfZ = 0;
-                if (!psTransform->poCT->Transform(1, &dfResultX, &dfResultY, &dfZ))
-                {
-                    panSuccess[i] = FALSE;
-                    continue;
-                }
+                panSuccess[i] = FALSE;
+                continue;
             }
+        }
 
-            GDALApplyGeoTransform( psTransform->adfReverseGeoTransform,
-                                    dfResultX, dfResultY, &dfX, &dfY );
-            int dX = int(dfX);
-            int dY = int(dfY);
+        GDALApplyGeoTransform( psTransform->adfReverseGeoTransform,
+                               dfLong, dfLat, padfDEMX + i, padfDEMY + i );
 
-            double dfDEMH(0);
-            double dfDeltaX = dfX - dX;
-            double dfDeltaY = dfY - dY;
+        if( bDstToSrc )
+        {
+            int dX = int(padfDEMX[i]);
+            int dY = int(padfDEMY[i]);
 
-            if(psTransform->eResampleAlg == DRA_Cubic)
-            {
-                int dXNew = dX - 1;
-                int dYNew = dY - 1;
-                if (!(dXNew >= 0 && dYNew >= 0 && dXNew + 4 <= nRasterXSize && dYNew + 4 <= nRasterYSize))
-                {
-                    panSuccess[i] = FALSE;
-                    continue;
-                }
-                //cubic interpolation
-                int anElevData[16] = {0};
-                CPLErr eErr = psTransform->poDS->RasterIO(GF_Read, dXNew, dYNew, 4, 4,
-                                                          &anElevData, 4, 4,
-                                                          GDT_Int32, 1, bands, 0, 0, 0);
-                if(eErr != CE_None)
-                {
-                    panSuccess[i] = FALSE;
-                    continue;
-                }
-
-                double dfSumH(0);
-                for ( int i = 0; i < 4; i++ )
-                {
-                    // Loop across the X axis
-                    for ( int j = 0; j < 4; j++ )
-                    {
-                        // Calculate the weight for the specified pixel according
-                        // to the bicubic b-spline kernel we're using for
-                        // interpolation
-                        int dKernIndX = j - 1;
-                        int dKernIndY = i - 1;
-                        double dfPixelWeight = BiCubicKernel(dKernIndX - dfDeltaX) * BiCubicKernel(dKernIndY - dfDeltaY);
-
-                        // Create a sum of all values
-                        // adjusted for the pixel's calculated weight
-                        dfSumH += anElevData[j + i * 4] * dfPixelWeight;
-                    }
-                }
-                dfDEMH = dfSumH;
-            }
-            else if(psTransform->eResampleAlg == DRA_Bilinear)
+            if (!(dX >= 0 && dY >= 0 &&
+                  dX+2 <= nRasterXSize && dY+2 <= nRasterYSize))
             {
-                if (!(dX >= 0 && dY >= 0 && dX + 2 <= nRasterXSize && dY + 2 <= nRasterYSize))
-                {
-                    panSuccess[i] = FALSE;
-                    continue;
-                }
-                //bilinear interpolation
-                int anElevData[4] = {0,0,0,0};
-                CPLErr eErr = psTransform->poDS->RasterIO(GF_Read, dX, dY, 2, 2,
-                                                          &anElevData, 2, 2,
-                                                          GDT_Int32, 1, bands, 0, 0, 0);
-                if(eErr != CE_None)
-                {
-                    panSuccess[i] = FALSE;
-                    continue;
-                }
-                double dfDeltaX1 = 1.0 - dfDeltaX;                
-                double dfDeltaY1 = 1.0 - dfDeltaY;
-
-                double dfXZ1 = anElevData[0] * dfDeltaX1 + anElevData[1] * dfDeltaX;
-                double dfXZ2 = anElevData[2] * dfDeltaX1 + anElevData[3] * dfDeltaX;
-                double dfYZ = dfXZ1 * dfDeltaY1 + dfXZ2 * dfDeltaY;
-                dfDEMH = dfYZ;
+                panSuccess[i] = FALSE;
+                continue;
             }
-            else
-            {
-                if (!(dX >= 0 && dY >= 0 && dX < nRasterXSize && dY < nRasterYSize))
-                {
-                    panSuccess[i] = FALSE;
-                    continue;
-                }
-                CPLErr eErr = psTransform->poDS->RasterIO(GF_Read, dX, dY, 1, 1,
-                                                          &dfDEMH, 1, 1,
-                                                          GDT_Float64, 1, bands, 0, 0, 0);
-                if(eErr != CE_None)
-                {
-                    panSuccess[i] = FALSE;
-                    continue;
-                }           
-            }
-
-            RPCInverseTransformPoint( psTransform, padfX[i], padfY[i], 
-                                      padfZ[i] + (psTransform->dfHeightOffset + dfDEMH) *
-                                                  psTransform->dfHeightScale,
-                                      &dfResultX, &dfResultY );
         }
-        else
-        {
-            RPCInverseTransformPoint( psTransform, padfX[i], padfY[i], 
-                                      padfZ[i] + psTransform->dfHeightOffset *
-                                                 psTransform->dfHeightScale,
-                                      &dfResultX, &dfResultY );
 
+        panSuccess[i] = TRUE;
+    }
+
+    RPCLoadDEMWindow( psTransform, nPointCount, padfDEMX, padfDEMY,
+                      panSuccess );
+
+/* -------------------------------------------------------------------- */
+/*      Then transform the points at their DEM height.                  */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < nPointCount; i++ )
+    {
+        double dfDEMH(0);
+
+        if( !panSuccess[i] )
+            continue;
+
+        if( !RPCGetDEMHeight( psTransform, padfDEMX[i], padfDEMY[i],
+                              &dfDEMH ) )
+        {
+            panSuccess[i] = FALSE;
+            continue;
         }
-        padfX[i] = dfResultX;
-        padfY[i] = dfResultY;
 
-        panSuccess[i] = TRUE;
+        double dfHeight = padfZ[i] + (psTransform->dfHeightOffset + dfDEMH) *
+                                     psTransform->dfHeightScale;
+
+        if( bDstToSrc )
+            RPCTransformPoint( psRPC, padfX[i], padfY[i], dfHeight,
+                               padfX + i, padfY + i );
+        else
+            RPCInverseTransformPoint( psTransform, padfX[i], padfY[i],
+                                      dfHeight, padfX + i, padfY + i );
     }
 
+    CPLFree( padfDEMX );
+
     return TRUE;
 }
 
@@ -39,6 +39,9 @@
 
 CPL_CVSID("$Id$");
 
+/* Number of points evaluated together by GDALTPSTransform() */
+#define TPS_TRANSFORM_BATCH_SIZE 256
+
 CPL_C_START
 CPLXMLNode *GDALSerializeTPSTransformer( void *pTransformArg );
 void *GDALDeserializeTPSTransformer( CPLXMLNode *psTree );
@@ -96,8 +99,11 @@ void* GDALCloneTPSTransformer( void *hTransformArg )
  * Creating the TPS transformer involves solving systems of linear equations
  * related to the number of control points involved.  This solution is
  * computed within this function call.  It can be quite an expensive operation
- * for large numbers of GCPs.  For instance, for reference, it takes on the 
- * order of 10s for 400 GCPs on a 2GHz Athlon processor. 
+ * for large numbers of GCPs, as its cost grows with the cube of the number
+ * of GCPs.  When there are more than 100 GCPs, the GDAL_NUM_THREADS
+ * configuration option (or the NUM_THREADS option of
+ * GDALCreateGenImgProjTransformer2()) can be set to a number of threads or
+ * ALL_CPUS to split the computation between several cores.
  *
  * TPS Transformers are serializable. 
  *
@@ -119,10 +125,17 @@ void *GDALCreateTPSTransformer( int nGCPCount, const GDAL_GCP *pasGCPList,
     return GDALCreateTPSTransformerInt(nGCPCount, pasGCPList, bReversed, NULL);
 }
 
+typedef struct
+{
+    TPSTransformInfo *psInfo;
+    int               nThreads;
+} TPSSolveJob;
+
 static void GDALTPSComputeForwardInThread(void* pData)
 {
-    TPSTransformInfo *psInfo = (TPSTransformInfo *)pData;
-    psInfo->bForwardSolved = psInfo->poForward->solve() != 0;
+    TPSSolveJob *psJob = (TPSSolveJob *)pData;
+    psJob->psInfo->bForwardSolved =
+        psJob->psInfo->poForward->solve(psJob->nThreads) != 0;
 }
 
 void *GDALCreateTPSTransformerInt( int nGCPCount, const GDAL_GCP *pasGCPList, 
@@ -188,15 +201,23 @@ void *GDALCreateTPSTransformerInt( int nGCPCount, const GDAL_GCP *pasGCPList,
             nThreads = atoi(pszWarpThreads);
     }
 
+    CPLWorkerThreadPool* poThreadPool = NULL;
     if( nThreads > 1 )
+        poThreadPool = CPLGetWorkerThreadPool(1);
+
+    if( poThreadPool != NULL )
     {
-        /* Compute direct and reverse transforms in parallel */
-        void* hThread = CPLCreateJoinableThread(GDALTPSComputeForwardInThread, psInfo);
-        psInfo->bReverseSolved = psInfo->poReverse->solve() != 0;
-        if( hThread != NULL )
-            CPLJoinThread(hThread);
-        else
-            psInfo->bForwardSolved = psInfo->poForward->solve() != 0;
+        /* Compute direct and reverse transforms in parallel, each of */
+        /* them splitting its factorization between half of the threads */
+        TPSSolveJob sJob;
+        sJob.psInfo = psInfo;
+        sJob.nThreads = MAX(1, nThreads / 2);
+        CPLJobGroup oJobGroup;
+        poThreadPool->SubmitJob(GDALTPSComputeForwardInThread, &sJob,
+                                &oJobGroup);
+        psInfo->bReverseSolved =
+            psInfo->poReverse->solve(MAX(1, nThreads - sJob.nThreads)) != 0;
+        poThreadPool->WaitCompletion(&oJobGroup);
     }
     else
     {
@@ -281,25 +302,27 @@ int GDALTPSTransform( void *pTransformArg, int bDstToSrc,
 
     int    i;
     TPSTransformInfo *psInfo = (TPSTransformInfo *) pTransformArg;
+    VizGeorefSpline2D *poSpline =
+        bDstToSrc ? psInfo->poReverse : psInfo->poForward;
 
-    for( i = 0; i < nPointCount; i++ )
+/* -------------------------------------------------------------------- */
+/*      Evaluate the spline by batches of points, so that the GCPs      */
+/*      are streamed from memory once per batch.                        */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < nPointCount; i += TPS_TRANSFORM_BATCH_SIZE )
     {
-        double xy_out[2];
+        const int nBatch = MIN(TPS_TRANSFORM_BATCH_SIZE, nPointCount - i);
+        double adfX[TPS_TRANSFORM_BATCH_SIZE];
+        double adfY[TPS_TRANSFORM_BATCH_SIZE];
+        double *apadfOut[2] = { x + i, y + i };
+
+        memcpy( adfX, x + i, sizeof(double) * nBatch );
+        memcpy( adfY, y + i, sizeof(double) * nBatch );
+        poSpline->get_points( nBatch, adfX, adfY, apadfOut );
+    }
 
-        if( bDstToSrc )
-        {
-            psInfo->poReverse->get_point( x[i], y[i], xy_out );
-            x[i] = xy_out[0];
-            y[i] = xy_out[1];
-        }
-        else
-        {
-            psInfo->poForward->get_point( x[i], y[i], xy_out );
-            x[i] = xy_out[0];
-            y[i] = xy_out[1];
-        }
+    for( i = 0; i < nPointCount; i++ )
         panSuccess[i] = TRUE;
-    }
 
     return TRUE;
 }
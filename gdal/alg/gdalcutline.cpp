@@ -31,14 +31,110 @@
 #include "gdalwarper.h"
 #include "gdal_alg.h"
 #include "ogr_api.h"
-#include "ogr_geos.h"
 #include "ogr_geometry.h"
 #include "cpl_string.h"
+#include <vector>
 
 CPL_CVSID("$Id$");
 
+/************************************************************************/
+/*                      BlendPointSegmentDist()                         */
+/*                                                                      */
+/*      Euclidean distance from a point to a segment.                   */
+/************************************************************************/
+
+static double BlendPointSegmentDist( double dfX, double dfY,
+                                     const double *padfSeg )
+
+{
+    double dfDX = padfSeg[2] - padfSeg[0];
+    double dfDY = padfSeg[3] - padfSeg[1];
+    double dfPX = dfX - padfSeg[0];
+    double dfPY = dfY - padfSeg[1];
+    double dfLen2 = dfDX * dfDX + dfDY * dfDY;
+
+    if( dfLen2 > 0.0 )
+    {
+        double dfT = (dfPX * dfDX + dfPY * dfDY) / dfLen2;
+
+        if( dfT >= 1.0 )
+        {
+            dfPX = dfX - padfSeg[2];
+            dfPY = dfY - padfSeg[3];
+        }
+        else if( dfT > 0.0 )
+        {
+            dfPX -= dfT * dfDX;
+            dfPY -= dfT * dfDY;
+        }
+    }
+
+    return sqrt( dfPX * dfPX + dfPY * dfPY );
+}
+
+/************************************************************************/
+/*                         BlendClipSegment()                           */
+/*                                                                      */
+/*      Clip the segment (dfX0,dfY0)-(dfX0+dfDX,dfY0+dfDY) to a         */
+/*      rectangle (Liang-Barsky), returning the parameter range of      */
+/*      the part inside it, or FALSE if it does not intersect it.       */
+/************************************************************************/
+
+static int BlendClipSegment( double dfX0, double dfY0,
+                             double dfDX, double dfDY,
+                             double dfMinX, double dfMinY,
+                             double dfMaxX, double dfMaxY,
+                             double *pdfT0, double *pdfT1 )
+
+{
+    double adfP[4], adfQ[4];
+    int    i;
+
+    adfP[0] = -dfDX; adfQ[0] = dfX0 - dfMinX;
+    adfP[1] = dfDX;  adfQ[1] = dfMaxX - dfX0;
+    adfP[2] = -dfDY; adfQ[2] = dfY0 - dfMinY;
+    adfP[3] = dfDY;  adfQ[3] = dfMaxY - dfY0;
+
+    *pdfT0 = 0.0;
+    *pdfT1 = 1.0;
+
+    for( i = 0; i < 4; i++ )
+    {
+        if( adfP[i] == 0.0 )
+        {
+            /* Parallel to this edge: either fully outside or unconstrained */
+            if( adfQ[i] < 0.0 )
+                return FALSE;
+        }
+        else
+        {
+            double dfR = adfQ[i] / adfP[i];
+
+            if( adfP[i] < 0.0 )
+                *pdfT0 = MAX(*pdfT0, dfR);
+            else
+                *pdfT1 = MIN(*pdfT1, dfR);
+        }
+
+        if( *pdfT0 > *pdfT1 )
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
 /************************************************************************/
 /*                         BlendMaskGenerator()                         */
+/*                                                                      */
+/*      Scale the validity mask according to the distance of each       */
+/*      pixel center to the cutline edge.  Distances are computed       */
+/*      with a vector distance transform: every pixel of a grid         */
+/*      covering the chunk plus the blend distance is seeded with       */
+/*      the nearest cutline segment passing close to it, and the        */
+/*      nearest segment identities are then propagated over the         */
+/*      grid in two raster passes, the distance of each candidate       */
+/*      being computed exactly against the segment.  This keeps the     */
+/*      cost linear in the number of pixels and requires no GEOS.       */
 /************************************************************************/
 
 static CPLErr
@@ -47,154 +143,267 @@ BlendMaskGenerator( int nXOff, int nYOff, int nXSize, int nYSize,
                     OGRGeometryH hPolygon, double dfBlendDist )
 
 {
-#ifndef HAVE_GEOS 
-    CPLError( CE_Failure, CPLE_AppDefined, 
-              "Blend distance support not available without the GEOS library.");
-    return CE_Failure;
-
-#else /* HAVE_GEOS */
+/* -------------------------------------------------------------------- */
+/*      Work on a grid a bit bigger than the area of interest so        */
+/*      that edges just outside of the chunk are taken into account.    */
+/* -------------------------------------------------------------------- */
+    int nMargin = (int) ceil(dfBlendDist) + 1;
+    int nGridXSize = nXSize + 2 * nMargin;
+    int nGridYSize = nYSize + 2 * nMargin;
+    double dfGridXOff = nXOff - nMargin;
+    double dfGridYOff = nYOff - nMargin;
 
 /* -------------------------------------------------------------------- */
 /*      Convert the polygon into a collection of lines so that we       */
-/*      measure distance from the edge even on the inside.              */
+/*      measure distance from the edge even on the inside, and keep     */
+/*      only the segments relevant for this area of interest.           */
 /* -------------------------------------------------------------------- */
     OGRGeometry *poLines
         = OGRGeometryFactory::forceToMultiLineString( 
             ((OGRGeometry *) hPolygon)->clone() );
+    std::vector<double> adfSegs;
 
-/* -------------------------------------------------------------------- */
-/*      Prepare a clipping polygon a bit bigger than the area of        */
-/*      interest in the hopes of simplifying the cutline down to        */
-/*      stuff that will be relavent for this area of interest.          */
-/* -------------------------------------------------------------------- */
-    CPLString osClipRectWKT;
-
-    osClipRectWKT.Printf( "POLYGON((%g %g,%g %g,%g %g,%g %g,%g %g))", 
-                          nXOff - (dfBlendDist+1), 
-                          nYOff - (dfBlendDist+1), 
-                          nXOff + nXSize + (dfBlendDist+1), 
-                          nYOff - (dfBlendDist+1), 
-                          nXOff + nXSize + (dfBlendDist+1), 
-                          nYOff + nYSize + (dfBlendDist+1), 
-                          nXOff - (dfBlendDist+1), 
-                          nYOff + nYSize + (dfBlendDist+1), 
-                          nXOff - (dfBlendDist+1), 
-                          nYOff - (dfBlendDist+1) );
-    
-    OGRPolygon *poClipRect = NULL;
-    char *pszWKT = (char *) osClipRectWKT.c_str();
-    
-    OGRGeometryFactory::createFromWkt( &pszWKT, NULL, 
-                                       (OGRGeometry**) (&poClipRect) );
-
-    if( poClipRect )
+    if( poLines != NULL
+        && wkbFlatten(poLines->getGeometryType()) == wkbMultiLineString )
     {
+        OGRMultiLineString *poMLS = (OGRMultiLineString *) poLines;
+        int iGeom;
 
-        /***** if it doesnt intersect the polym zero the mask and return *****/
-
-        if ( ! ((OGRGeometry *) hPolygon)->Intersects( poClipRect ) )
+        for( iGeom = 0; iGeom < poMLS->getNumGeometries(); iGeom++ )
         {
-            
-            memset( pafValidityMask, 0, sizeof(float) * nXSize * nYSize );
+            OGRLineString *poLS =
+                (OGRLineString *) poMLS->getGeometryRef( iGeom );
+            int iPoint;
 
-            delete poLines;
-            delete poClipRect;
-
-            return CE_None;
+            for( iPoint = 0; iPoint + 1 < poLS->getNumPoints(); iPoint++ )
+            {
+                double dfX1 = poLS->getX(iPoint);
+                double dfY1 = poLS->getY(iPoint);
+                double dfX2 = poLS->getX(iPoint+1);
+                double dfY2 = poLS->getY(iPoint+1);
+
+                if( MAX(dfX1,dfX2) < dfGridXOff
+                    || MIN(dfX1,dfX2) > dfGridXOff + nGridXSize
+                    || MAX(dfY1,dfY2) < dfGridYOff
+                    || MIN(dfY1,dfY2) > dfGridYOff + nGridYSize )
+                    continue;
+
+                adfSegs.push_back( dfX1 );
+                adfSegs.push_back( dfY1 );
+                adfSegs.push_back( dfX2 );
+                adfSegs.push_back( dfY2 );
+            }
         }
+    }
+    delete poLines;
 
-        /***** if it doesnt intersect the line at all just return *****/
-         
-        else if ( ! ((OGRGeometry *) poLines)->Intersects( poClipRect ) )
-        {
-            delete poLines;
-            delete poClipRect;
+/* -------------------------------------------------------------------- */
+/*      If no edge is close to the chunk, the pixels are either all     */
+/*      inside or all outside the polygon.                              */
+/* -------------------------------------------------------------------- */
+    int i, nPixels = nXSize * nYSize;
 
-            return CE_None;
+    if( adfSegs.empty() )
+    {
+        for( i = 0; i < nPixels; i++ )
+        {
+            if( pabyPolyMask[i] == 0 )
+                pafValidityMask[i] = 0.0;
         }
+        return CE_None;
+    }
 
-        OGRGeometry *poClippedLines = 
-            poLines->Intersection( poClipRect );
-        delete poLines;
-        poLines = poClippedLines;
-        delete poClipRect;
+    int *panNearestSeg = (int *) 
+        VSIMalloc3( sizeof(int), nGridXSize, nGridYSize );
+    double *padfDist = (double *) 
+        VSIMalloc3( sizeof(double), nGridXSize, nGridYSize );
+    if( panNearestSeg == NULL || padfDist == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Cannot allocate blend distance buffers." );
+        CPLFree( panNearestSeg );
+        CPLFree( padfDist );
+        return CE_Failure;
+    }
+
+    int nGridPixels = nGridXSize * nGridYSize;
+    for( i = 0; i < nGridPixels; i++ )
+    {
+        panNearestSeg[i] = -1;
+        padfDist[i] = HUGE_VAL;
     }
 
 /* -------------------------------------------------------------------- */
-/*      Convert our polygon into GEOS format, and compute an            */
-/*      envelope to accelerate later distance operations.               */
+/*      Seed the pixels along each segment: walk the part of the        */
+/*      segment crossing the grid in half pixel steps and consider      */
+/*      the 3x3 neighbourhood of each step.                             */
 /* -------------------------------------------------------------------- */
-    OGREnvelope sEnvelope;
-    int iXMin, iYMin, iXMax, iYMax;
-    GEOSContextHandle_t hGEOSCtxt = OGRGeometry::createGEOSContext();
-    GEOSGeom poGEOSPoly;
-
-    poGEOSPoly = poLines->exportToGEOS(hGEOSCtxt);
-    OGR_G_GetEnvelope( hPolygon, &sEnvelope );
+    int iSeg, nSegs = (int) (adfSegs.size() / 4);
 
-    delete poLines;
-
-    /***** this check was already done in the calling *****/
-    /***** function and should never be true          *****/
+    for( iSeg = 0; iSeg < nSegs; iSeg++ )
+    {
+        const double *padfSeg = &adfSegs[iSeg * 4];
+        double dfDX = padfSeg[2] - padfSeg[0];
+        double dfDY = padfSeg[3] - padfSeg[1];
+        double dfT0, dfT1;
+
+        if( !BlendClipSegment( padfSeg[0] - dfGridXOff,
+                               padfSeg[1] - dfGridYOff, dfDX, dfDY,
+                               -1.0, -1.0,
+                               nGridXSize + 1.0, nGridYSize + 1.0,
+                               &dfT0, &dfT1 ) )
+            continue;
+
+        /* The clipped part is at most the grid diagonal long, the bound */
+        /* only guards against non finite coordinates. */
+        double dfLength = (dfT1 - dfT0) * MAX(fabs(dfDX), fabs(dfDY));
+        double dfMaxLength = (double) nGridXSize + nGridYSize + 4;
+        int nSteps = (int) ceil( 2.0 * MIN(dfLength, dfMaxLength) );
+        int iStep;
+
+        for( iStep = 0; iStep <= nSteps; iStep++ )
+        {
+            double dfT = (nSteps == 0) ? dfT0 :
+                dfT0 + (dfT1 - dfT0) * iStep / (double) nSteps;
+            double dfX = padfSeg[0] + dfT * dfDX - dfGridXOff;
+            double dfY = padfSeg[1] + dfT * dfDY - dfGridYOff;
 
-    /*if( sEnvelope.MinY - dfBlendDist > nYOff+nYSize 
-        || sEnvelope.MaxY + dfBlendDist < nYOff 
-        || sEnvelope.MinX - dfBlendDist > nXOff+nXSize
-        || sEnvelope.MaxX + dfBlendDist < nXOff )
-        return CE_None;
-    */
+            if( dfX < -1.0 || dfX > nGridXSize + 1.0
+                || dfY < -1.0 || dfY > nGridYSize + 1.0 )
+                continue;
 
+            int iXC = (int) floor(dfX);
+            int iYC = (int) floor(dfY);
+            int iX, iY;
 
-    iXMin = MAX(0,(int) floor(sEnvelope.MinX - dfBlendDist - nXOff));
-    iXMax = MIN(nXSize, (int) ceil(sEnvelope.MaxX + dfBlendDist - nXOff));
-    iYMin = MAX(0,(int) floor(sEnvelope.MinY - dfBlendDist - nYOff));
-    iYMax = MIN(nYSize, (int) ceil(sEnvelope.MaxY + dfBlendDist - nYOff));
+            for( iY = MAX(0, iYC - 1); iY <= MIN(nGridYSize - 1, iYC + 1); iY++ )
+            {
+                for( iX = MAX(0, iXC - 1); iX <= MIN(nGridXSize - 1, iXC + 1); iX++ )
+                {
+                    int iGrid = iX + iY * nGridXSize;
+
+                    if( panNearestSeg[iGrid] == iSeg )
+                        continue;
+
+                    double dfDist = BlendPointSegmentDist(
+                        iX + dfGridXOff + 0.5, iY + dfGridYOff + 0.5,
+                        padfSeg );
+
+                    if( dfDist < padfDist[iGrid] )
+                    {
+                        padfDist[iGrid] = dfDist;
+                        panNearestSeg[iGrid] = iSeg;
+                    }
+                }
+            }
+        }
+    }
 
 /* -------------------------------------------------------------------- */
-/*      Loop over potential area within blend line distance,            */
-/*      processing each pixel.                                          */
+/*      Propagate the nearest segments: a top-down pass looking at      */
+/*      the left and upper neighbours followed by a right to left       */
+/*      sweep, then the mirrored bottom-up pass.                        */
 /* -------------------------------------------------------------------- */
-    int iY, iX;
-    double dfLastDist;
-    
-    for( iY = 0; iY < nYSize; iY++ )
+#define BLEND_UPDATE(iGrid, iNeighbour)                                   \
+    do {                                                                  \
+        int iCandSeg = panNearestSeg[iNeighbour];                         \
+        if( iCandSeg >= 0 && iCandSeg != panNearestSeg[iGrid] )           \
+        {                                                                 \
+            double dfDist = BlendPointSegmentDist( dfPixelX, dfPixelY,    \
+                                            &adfSegs[iCandSeg * 4] );     \
+            if( dfDist < padfDist[iGrid] )                                \
+            {                                                             \
+                padfDist[iGrid] = dfDist;                                 \
+                panNearestSeg[iGrid] = iCandSeg;                          \
+            }                                                             \
+        }                                                                 \
+    } while(0)
+
+    int iX, iY;
+
+    for( iY = 0; iY < nGridYSize; iY++ )
     {
-        dfLastDist = 0.0;
+        double dfPixelY = iY + dfGridYOff + 0.5;
 
-        for( iX = 0; iX < nXSize; iX++ )
+        for( iX = 0; iX < nGridXSize; iX++ )
         {
-            if( iX < iXMin || iX >= iXMax
-                || iY < iYMin || iY > iYMax
-                || dfLastDist > dfBlendDist + 1.5 )
+            double dfPixelX = iX + dfGridXOff + 0.5;
+            int iGrid = iX + iY * nGridXSize;
+
+            if( iX > 0 )
+                BLEND_UPDATE( iGrid, iGrid - 1 );
+            if( iY > 0 )
             {
-                if( pabyPolyMask[iX + iY * nXSize] == 0 )
-                    pafValidityMask[iX + iY * nXSize] = 0.0;
+                if( iX > 0 )
+                    BLEND_UPDATE( iGrid, iGrid - nGridXSize - 1 );
+                BLEND_UPDATE( iGrid, iGrid - nGridXSize );
+                if( iX + 1 < nGridXSize )
+                    BLEND_UPDATE( iGrid, iGrid - nGridXSize + 1 );
+            }
+        }
 
-                dfLastDist -= 1.0;
-                continue;
+        for( iX = nGridXSize - 2; iX >= 0; iX-- )
+        {
+            double dfPixelX = iX + dfGridXOff + 0.5;
+            int iGrid = iX + iY * nGridXSize;
+
+            BLEND_UPDATE( iGrid, iGrid + 1 );
+        }
+    }
+
+    for( iY = nGridYSize - 1; iY >= 0; iY-- )
+    {
+        double dfPixelY = iY + dfGridYOff + 0.5;
+
+        for( iX = nGridXSize - 1; iX >= 0; iX-- )
+        {
+            double dfPixelX = iX + dfGridXOff + 0.5;
+            int iGrid = iX + iY * nGridXSize;
+
+            if( iX + 1 < nGridXSize )
+                BLEND_UPDATE( iGrid, iGrid + 1 );
+            if( iY + 1 < nGridYSize )
+            {
+                if( iX + 1 < nGridXSize )
+                    BLEND_UPDATE( iGrid, iGrid + nGridXSize + 1 );
+                BLEND_UPDATE( iGrid, iGrid + nGridXSize );
+                if( iX > 0 )
+                    BLEND_UPDATE( iGrid, iGrid + nGridXSize - 1 );
             }
-            
-            double dfDist, dfRatio;
-            CPLString osPointWKT;
-            GEOSGeom poGEOSPoint;
+        }
 
-            osPointWKT.Printf( "POINT(%d.5 %d.5)", iX + nXOff, iY + nYOff );
-            poGEOSPoint = GEOSGeomFromWKT_r( hGEOSCtxt, osPointWKT );
+        for( iX = 1; iX < nGridXSize; iX++ )
+        {
+            double dfPixelX = iX + dfGridXOff + 0.5;
+            int iGrid = iX + iY * nGridXSize;
 
-            GEOSDistance_r( hGEOSCtxt, poGEOSPoly, poGEOSPoint, &dfDist );
-            GEOSGeom_destroy_r( hGEOSCtxt, poGEOSPoint );
+            BLEND_UPDATE( iGrid, iGrid - 1 );
+        }
+    }
 
-            dfLastDist = dfDist;
+#undef BLEND_UPDATE
+
+/* -------------------------------------------------------------------- */
+/*      Apply the blend ratio to the pixels of the chunk.               */
+/* -------------------------------------------------------------------- */
+    for( iY = 0; iY < nYSize; iY++ )
+    {
+        for( iX = 0; iX < nXSize; iX++ )
+        {
+            int iPixel = iX + iY * nXSize;
+            double dfDist = 
+                padfDist[iX + nMargin + (iY + nMargin) * nGridXSize];
+            double dfRatio;
 
             if( dfDist > dfBlendDist )
             {
-                if( pabyPolyMask[iX + iY * nXSize] == 0 )
-                    pafValidityMask[iX + iY * nXSize] = 0.0;
+                if( pabyPolyMask[iPixel] == 0 )
+                    pafValidityMask[iPixel] = 0.0;
 
                 continue;
             }
 
-            if( pabyPolyMask[iX + iY * nXSize] == 0 )
+            if( pabyPolyMask[iPixel] == 0 )
             {
                 /* outside */
                 dfRatio = 0.5 - (dfDist / dfBlendDist) * 0.5;
@@ -205,19 +414,17 @@ BlendMaskGenerator( int nXOff, int nYOff, int nXSize, int nYSize,
                 dfRatio = 0.5 + (dfDist / dfBlendDist) * 0.5;
             }                
 
-            pafValidityMask[iX + iY * nXSize] *= (float)dfRatio;
+            pafValidityMask[iPixel] *= (float)dfRatio;
         }
     }
 
 /* -------------------------------------------------------------------- */
 /*      Cleanup                                                         */
 /* -------------------------------------------------------------------- */
-    GEOSGeom_destroy_r( hGEOSCtxt, poGEOSPoly );
-    OGRGeometry::freeGEOSContext( hGEOSCtxt );
+    CPLFree( panNearestSeg );
+    CPLFree( padfDist );
 
     return CE_None;
-
-#endif /* HAVE_GEOS */
 }
 
 /************************************************************************/
@@ -30,6 +30,8 @@
 
 #include "gdal_priv.h"
 #include "gdal_alg.h"
+#include "gdal_alg_priv.h"
+#include "cpl_atomic_ops.h"
 
 #ifdef SHAPE_DEBUG
 #include "/u/pkg/shapelib/shapefil.h"
@@ -51,6 +53,36 @@ CPL_C_END
 /* ==================================================================== */
 /************************************************************************/
 
+/* When the geolocation arrays are indexed rather than fully loaded,    */
+/* they are read through a cache of tiles aligned on a                  */
+/* GEOLOC_TILE_SIZE grid.  Tiles extend one pixel further so that the   */
+/* four corners of any cell whose top left corner is in the tile can    */
+/* be fetched from it.                                                  */
+#define GEOLOC_TILE_SIZE 128
+#define GEOLOC_TILE_MARGIN 1
+
+/* Number of geolocation cells, in each direction, covered by a block  */
+/* of the inverse index.                                                */
+#define GEOLOC_INDEX_BLOCK_SIZE 32
+
+/* Above this number of geolocation points, the inverse index is used  */
+/* by default rather than the full arrays and the backmap.  The tile    */
+/* cache holds up to that many points too, so it holds the whole        */
+/* arrays below it, and random access does not reload tiles.            */
+#define GEOLOC_INDEX_AUTO_THRESHOLD (16 * 1024 * 1024)
+
+typedef struct {
+    int         nTileX;
+    int         nTileY;
+    int         nXOff;
+    int         nYOff;
+    int         nXSize;
+    int         nYSize;
+    double      *padfX;
+    double      *padfY;
+    GUIntBig    nLastUse;
+} GeoLocCacheTile;
+
 typedef struct {
 
     GDALTransformerInfo sTI;
@@ -82,6 +114,31 @@ typedef struct {
     int              bHasNoData;
     double           dfNoDataX;
 
+    // Tiled access to the geolocation arrays and inverse index, used
+    // instead of padfGeoLocX/Y and the backmap for large arrays.
+    int              bUseIndex;
+    int              bRegularGrid;
+    int              nTilesX;
+    int              nTilesY;
+    int              nMaxTiles;
+    int              nUsedTiles;
+    GeoLocCacheTile  *pasTiles;         // nMaxTiles, allocated on first use.
+    GeoLocCacheTile  **papsTileMap;     // nTilesX*nTilesY, NULL if not cached.
+    GeoLocCacheTile  *psLastTile;
+    GUIntBig         nTileCounter;
+
+    int              nIndexBlocksX;
+    int              nIndexBlocksY;
+    double           *padfBlockExtents; // minx,miny,maxx,maxy per block.
+    int              nIndexGridWidth;
+    int              nIndexGridHeight;
+    double           dfIndexMinX;
+    double           dfIndexMinY;
+    double           dfIndexCellSize;
+    int              *panIndexGridStart; // nIndexGridWidth*nIndexGridHeight+1
+    int              *panIndexGridBlocks;
+    int              nLastBlock;
+
     // geolocation <-> base image mapping.
     double           dfPIXEL_OFFSET;
     double           dfPIXEL_STEP;
@@ -90,34 +147,50 @@ typedef struct {
 
     char **          papszGeolocationInfo;
 
+    // Number of transformers sharing the arrays, backmap and index above,
+    // which are read-only once built (see GDALCloneGeoLocTransformer()).
+    volatile int     *pnSharedRefCount;
+
 } GDALGeoLocTransformInfo;
 
 /************************************************************************/
-/*                         GeoLocLoadFullData()                         */
+/*                       GeoLocInitDimensions()                         */
 /************************************************************************/
 
-static int GeoLocLoadFullData( GDALGeoLocTransformInfo *psTransform )
+static void GeoLocInitDimensions( GDALGeoLocTransformInfo *psTransform )
 
 {
-    int nXSize, nYSize;
-
     int nXSize_XBand = GDALGetRasterXSize( psTransform->hDS_X );
     int nYSize_XBand = GDALGetRasterYSize( psTransform->hDS_X );
     int nXSize_YBand = GDALGetRasterXSize( psTransform->hDS_Y );
     int nYSize_YBand = GDALGetRasterYSize( psTransform->hDS_Y );
     if (nYSize_XBand == 1 && nYSize_YBand == 1)
     {
-        nXSize = nXSize_XBand;
-        nYSize = nXSize_YBand;
+        /* Case of regular grid */
+        psTransform->bRegularGrid = TRUE;
+        psTransform->nGeoLocXSize = nXSize_XBand;
+        psTransform->nGeoLocYSize = nXSize_YBand;
     }
     else
     {
-        nXSize = nXSize_XBand;
-        nYSize = nYSize_XBand;
+        psTransform->bRegularGrid = FALSE;
+        psTransform->nGeoLocXSize = nXSize_XBand;
+        psTransform->nGeoLocYSize = nYSize_XBand;
     }
 
-    psTransform->nGeoLocXSize = nXSize;
-    psTransform->nGeoLocYSize = nYSize;
+    psTransform->dfNoDataX = GDALGetRasterNoDataValue( psTransform->hBand_X, 
+                                                       &(psTransform->bHasNoData) );
+}
+
+/************************************************************************/
+/*                         GeoLocLoadFullData()                         */
+/************************************************************************/
+
+static int GeoLocLoadFullData( GDALGeoLocTransformInfo *psTransform )
+
+{
+    int nXSize = psTransform->nGeoLocXSize;
+    int nYSize = psTransform->nGeoLocYSize;
     
     psTransform->padfGeoLocY = (double *) 
         VSIMalloc3(sizeof(double), nXSize, nYSize);
@@ -132,7 +205,7 @@ static int GeoLocLoadFullData( GDALGeoLocTransformInfo *psTransform )
         return FALSE;
     }
 
-    if (nYSize_XBand == 1 && nYSize_YBand == 1)
+    if (psTransform->bRegularGrid)
     {
         /* Case of regular grid */
         /* The XBAND contains the x coordinates for all lines */
@@ -199,9 +272,6 @@ static int GeoLocLoadFullData( GDALGeoLocTransformInfo *psTransform )
             return FALSE;
     }
 
-    psTransform->dfNoDataX = GDALGetRasterNoDataValue( psTransform->hBand_X, 
-                                                       &(psTransform->bHasNoData) );
-
     return TRUE;
 }
 
@@ -469,6 +539,566 @@ static int GeoLocGenerateBackMap( GDALGeoLocTransformInfo *psTransform )
     return TRUE;
 }
 
+/************************************************************************/
+/*                          GeoLocGetTile()                             */
+/*                                                                      */
+/*      Return pointers to the geolocation values at (iX,iY), served    */
+/*      from the tile cache.  The values at (iX+1,iY), (iX,iY+1) and    */
+/*      (iX+1,iY+1), when inside the arrays, are available at the       */
+/*      returned pointers + 1, + *pnLineStride and + *pnLineStride+1.   */
+/************************************************************************/
+
+static int GeoLocGetTile( GDALGeoLocTransformInfo *psTransform,
+                          int iX, int iY,
+                          const double **ppadfX, const double **ppadfY,
+                          int *pnLineStride )
+
+{
+    int nTileX = iX / GEOLOC_TILE_SIZE;
+    int nTileY = iY / GEOLOC_TILE_SIZE;
+    GeoLocCacheTile *psTile = psTransform->psLastTile;
+    int iTile;
+
+/* -------------------------------------------------------------------- */
+/*      Allocate the cache on first use, with room for the whole        */
+/*      arrays up to GEOLOC_INDEX_AUTO_THRESHOLD points.                */
+/* -------------------------------------------------------------------- */
+    if( psTransform->pasTiles == NULL )
+    {
+        int nTilesX = (psTransform->nGeoLocXSize + GEOLOC_TILE_SIZE - 1)
+                            / GEOLOC_TILE_SIZE;
+        int nTilesY = (psTransform->nGeoLocYSize + GEOLOC_TILE_SIZE - 1)
+                            / GEOLOC_TILE_SIZE;
+
+        psTransform->nTilesX = nTilesX;
+        psTransform->nTilesY = nTilesY;
+        psTransform->nMaxTiles = 
+            MIN(nTilesX * nTilesY,
+                GEOLOC_INDEX_AUTO_THRESHOLD 
+                    / (GEOLOC_TILE_SIZE * GEOLOC_TILE_SIZE));
+        psTransform->nUsedTiles = 0;
+        psTransform->pasTiles = (GeoLocCacheTile *)
+            VSICalloc( sizeof(GeoLocCacheTile), psTransform->nMaxTiles );
+        psTransform->papsTileMap = (GeoLocCacheTile **)
+            VSICalloc( sizeof(GeoLocCacheTile *), nTilesX * nTilesY );
+        if( psTransform->pasTiles == NULL || psTransform->papsTileMap == NULL )
+        {
+            CPLError( CE_Failure, CPLE_OutOfMemory,
+                      "Cannot allocate geolocation tile cache." );
+            CPLFree( psTransform->pasTiles );
+            CPLFree( psTransform->papsTileMap );
+            psTransform->pasTiles = NULL;
+            psTransform->papsTileMap = NULL;
+            return FALSE;
+        }
+    }
+
+    psTransform->nTileCounter ++;
+
+    if( psTile == NULL
+        || psTile->nTileX != nTileX || psTile->nTileY != nTileY )
+        psTile = psTransform->papsTileMap[nTileX 
+                                          + nTileY * psTransform->nTilesX];
+
+/* -------------------------------------------------------------------- */
+/*      Not in cache: load it in a free slot, or in the least           */
+/*      recently used one.                                              */
+/* -------------------------------------------------------------------- */
+    if( psTile == NULL )
+    {
+        if( psTransform->nUsedTiles < psTransform->nMaxTiles )
+            psTile = psTransform->pasTiles + psTransform->nUsedTiles++;
+        else
+        {
+            psTile = psTransform->pasTiles;
+            for( iTile = 1; iTile < psTransform->nMaxTiles; iTile++ )
+            {
+                if( psTransform->pasTiles[iTile].nLastUse < psTile->nLastUse )
+                    psTile = psTransform->pasTiles + iTile;
+            }
+        }
+
+        if( psTile->padfX != NULL )
+            psTransform->papsTileMap[psTile->nTileX 
+                                     + psTile->nTileY * psTransform->nTilesX] = NULL;
+        psTransform->psLastTile = NULL;
+
+        int nXOff = nTileX * GEOLOC_TILE_SIZE;
+        int nYOff = nTileY * GEOLOC_TILE_SIZE;
+        int nXSize = MIN(GEOLOC_TILE_SIZE + GEOLOC_TILE_MARGIN,
+                         psTransform->nGeoLocXSize - nXOff);
+        int nYSize = MIN(GEOLOC_TILE_SIZE + GEOLOC_TILE_MARGIN,
+                         psTransform->nGeoLocYSize - nYOff);
+        const int nMaxValues = (GEOLOC_TILE_SIZE + GEOLOC_TILE_MARGIN)
+                             * (GEOLOC_TILE_SIZE + GEOLOC_TILE_MARGIN);
+        CPLErr eErr;
+
+        if( psTile->padfX == NULL )
+        {
+            psTile->padfX = (double *) VSIMalloc2( sizeof(double), nMaxValues );
+            psTile->padfY = (double *) VSIMalloc2( sizeof(double), nMaxValues );
+            if( psTile->padfX == NULL || psTile->padfY == NULL )
+            {
+                CPLError( CE_Failure, CPLE_OutOfMemory,
+                          "Cannot allocate geolocation cache tile." );
+                CPLFree( psTile->padfX );
+                CPLFree( psTile->padfY );
+                psTile->padfX = NULL;
+                psTile->padfY = NULL;
+                return FALSE;
+            }
+        }
+
+        if( psTransform->bRegularGrid )
+        {
+            /* The X band holds the x coordinates of the columns, and */
+            /* the Y band the y coordinates of the lines.             */
+            double adfLineX[GEOLOC_TILE_SIZE + GEOLOC_TILE_MARGIN];
+            double adfColY[GEOLOC_TILE_SIZE + GEOLOC_TILE_MARGIN];
+            int i, j;
+
+            eErr = GDALRasterIO( psTransform->hBand_X, GF_Read, 
+                                 nXOff, 0, nXSize, 1,
+                                 adfLineX, nXSize, 1, GDT_Float64, 0, 0 );
+            if( eErr == CE_None )
+                eErr = GDALRasterIO( psTransform->hBand_Y, GF_Read, 
+                                     nYOff, 0, nYSize, 1,
+                                     adfColY, nYSize, 1, GDT_Float64, 0, 0 );
+
+            for( j = 0; eErr == CE_None && j < nYSize; j++ )
+            {
+                for( i = 0; i < nXSize; i++ )
+                {
+                    psTile->padfX[i + j * nXSize] = adfLineX[i];
+                    psTile->padfY[i + j * nXSize] = adfColY[j];
+                }
+            }
+        }
+        else
+        {
+            eErr = GDALRasterIO( psTransform->hBand_X, GF_Read, 
+                                 nXOff, nYOff, nXSize, nYSize,
+                                 psTile->padfX, nXSize, nYSize, 
+                                 GDT_Float64, 0, 0 );
+            if( eErr == CE_None )
+                eErr = GDALRasterIO( psTransform->hBand_Y, GF_Read, 
+                                     nXOff, nYOff, nXSize, nYSize,
+                                     psTile->padfY, nXSize, nYSize, 
+                                     GDT_Float64, 0, 0 );
+        }
+
+        if( eErr != CE_None )
+        {
+            CPLFree( psTile->padfX );
+            CPLFree( psTile->padfY );
+            psTile->padfX = NULL;
+            psTile->padfY = NULL;
+            psTransform->psLastTile = NULL;
+            return FALSE;
+        }
+
+        psTile->nTileX = nTileX;
+        psTile->nTileY = nTileY;
+        psTile->nXOff = nXOff;
+        psTile->nYOff = nYOff;
+        psTile->nXSize = nXSize;
+        psTile->nYSize = nYSize;
+        psTransform->papsTileMap[nTileX + nTileY * psTransform->nTilesX] = psTile;
+    }
+
+    psTile->nLastUse = psTransform->nTileCounter;
+    psTransform->psLastTile = psTile;
+
+    int nOffset = (iX - psTile->nXOff) + (iY - psTile->nYOff) * psTile->nXSize;
+    *ppadfX = psTile->padfX + nOffset;
+    *ppadfY = psTile->padfY + nOffset;
+    *pnLineStride = psTile->nXSize;
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                         GeoLocBuildIndex()                           */
+/*                                                                      */
+/*      Build a memory bounded inverse index of the geolocation         */
+/*      arrays: the extent of each block of                             */
+/*      GEOLOC_INDEX_BLOCK_SIZE x GEOLOC_INDEX_BLOCK_SIZE cells is      */
+/*      computed in a single pass over the arrays, and a regular grid   */
+/*      over the georeferenced extent lists the blocks intersecting     */
+/*      each of its cells.                                              */
+/************************************************************************/
+
+static int GeoLocBuildIndex( GDALGeoLocTransformInfo *psTransform )
+
+{
+    int nXSize = psTransform->nGeoLocXSize;
+    int nYSize = psTransform->nGeoLocYSize;
+    int nBlocksX = (nXSize - 2) / GEOLOC_INDEX_BLOCK_SIZE + 1;
+    int nBlocksY = (nYSize - 2) / GEOLOC_INDEX_BLOCK_SIZE + 1;
+    int nBlocks = nBlocksX * nBlocksY;
+    int iBlock;
+
+    psTransform->nIndexBlocksX = nBlocksX;
+    psTransform->nIndexBlocksY = nBlocksY;
+    psTransform->nLastBlock = -1;
+    psTransform->padfBlockExtents = (double *) 
+        VSIMalloc3( sizeof(double) * 4, nBlocksX, nBlocksY );
+    if( psTransform->padfBlockExtents == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Unable to allocate inverse index for geolocation array transformer." );
+        return FALSE;
+    }
+
+    for( iBlock = 0; iBlock < nBlocks; iBlock++ )
+    {
+        double *padfExtent = psTransform->padfBlockExtents + 4 * iBlock;
+        padfExtent[0] = padfExtent[1] = HUGE_VAL;
+        padfExtent[2] = padfExtent[3] = -HUGE_VAL;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Scan the arrays tile by tile.  A vertex belongs to the blocks   */
+/*      of the cells it is a corner of.                                 */
+/* -------------------------------------------------------------------- */
+    double dfMinX = HUGE_VAL, dfMinY = HUGE_VAL;
+    double dfMaxX = -HUGE_VAL, dfMaxY = -HUGE_VAL;
+    int nTileX, nTileY;
+
+    for( nTileY = 0; nTileY * GEOLOC_TILE_SIZE < nYSize; nTileY++ )
+    {
+        for( nTileX = 0; nTileX * GEOLOC_TILE_SIZE < nXSize; nTileX++ )
+        {
+            const double *padfX, *padfY;
+            int nStride;
+            int nXOff = nTileX * GEOLOC_TILE_SIZE;
+            int nYOff = nTileY * GEOLOC_TILE_SIZE;
+            int iX, iY;
+
+            if( !GeoLocGetTile( psTransform, nXOff, nYOff,
+                                &padfX, &padfY, &nStride ) )
+                return FALSE;
+
+            for( iY = nYOff; iY < MIN(nYOff + GEOLOC_TILE_SIZE, nYSize); iY++ )
+            {
+                int iBlockY = MIN(iY / GEOLOC_INDEX_BLOCK_SIZE, nBlocksY - 1);
+                int iBlockYPrev = (iY - 1) / GEOLOC_INDEX_BLOCK_SIZE;
+
+                for( iX = nXOff; iX < MIN(nXOff + GEOLOC_TILE_SIZE, nXSize); iX++ )
+                {
+                    int nOffset = (iX - nXOff) + (iY - nYOff) * nStride;
+                    double dfX = padfX[nOffset];
+                    double dfY = padfY[nOffset];
+
+                    if( psTransform->bHasNoData
+                        && dfX == psTransform->dfNoDataX )
+                        continue;
+
+                    int iBlockX = MIN(iX / GEOLOC_INDEX_BLOCK_SIZE, nBlocksX - 1);
+                    int iBlockXPrev = (iX - 1) / GEOLOC_INDEX_BLOCK_SIZE;
+                    int anBlockX[2], anBlockY[2];
+                    int nBX = 1, nBY = 1, iBX, iBY;
+
+                    anBlockX[0] = iBlockX;
+                    if( iX > 0 && iBlockXPrev != iBlockX )
+                        anBlockX[nBX++] = iBlockXPrev;
+                    anBlockY[0] = iBlockY;
+                    if( iY > 0 && iBlockYPrev != iBlockY )
+                        anBlockY[nBY++] = iBlockYPrev;
+
+                    for( iBY = 0; iBY < nBY; iBY++ )
+                    {
+                        for( iBX = 0; iBX < nBX; iBX++ )
+                        {
+                            double *padfExtent = psTransform->padfBlockExtents
+                                + 4 * (anBlockX[iBX] + anBlockY[iBY] * nBlocksX);
+                            padfExtent[0] = MIN(padfExtent[0], dfX);
+                            padfExtent[1] = MIN(padfExtent[1], dfY);
+                            padfExtent[2] = MAX(padfExtent[2], dfX);
+                            padfExtent[3] = MAX(padfExtent[3], dfY);
+                        }
+                    }
+
+                    dfMinX = MIN(dfMinX, dfX);
+                    dfMinY = MIN(dfMinY, dfY);
+                    dfMaxX = MAX(dfMaxX, dfX);
+                    dfMaxY = MAX(dfMaxY, dfY);
+                }
+            }
+        }
+    }
+
+    if( dfMinX > dfMaxX )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "No valid value in geolocation arrays." );
+        return FALSE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Decide on the resolution of the grid: about two cells per       */
+/*      block.                                                          */
+/* -------------------------------------------------------------------- */
+    double dfCellSize = sqrt( MAX(dfMaxX - dfMinX, 1e-10)
+                              * MAX(dfMaxY - dfMinY, 1e-10) / (2.0 * nBlocks) );
+    int nGridWidth = MAX(1, (int) MIN(4096.0, (dfMaxX - dfMinX) / dfCellSize + 1));
+    int nGridHeight = MAX(1, (int) MIN(4096.0, (dfMaxY - dfMinY) / dfCellSize + 1));
+
+    dfCellSize = MAX( (dfMaxX - dfMinX) / nGridWidth,
+                      (dfMaxY - dfMinY) / nGridHeight ) * (1 + 1e-10);
+    if( dfCellSize == 0.0 )
+        dfCellSize = 1.0;
+
+    psTransform->nIndexGridWidth = nGridWidth;
+    psTransform->nIndexGridHeight = nGridHeight;
+    psTransform->dfIndexMinX = dfMinX;
+    psTransform->dfIndexMinY = dfMinY;
+    psTransform->dfIndexCellSize = dfCellSize;
+
+/* -------------------------------------------------------------------- */
+/*      Count the blocks per grid cell, then fill the lists.            */
+/* -------------------------------------------------------------------- */
+    int nGridCells = nGridWidth * nGridHeight;
+    int iPass, iCell;
+
+    psTransform->panIndexGridStart = (int *) 
+        VSICalloc( sizeof(int), nGridCells + 1 );
+    if( psTransform->panIndexGridStart == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Unable to allocate inverse index for geolocation array transformer." );
+        return FALSE;
+    }
+
+    for( iPass = 0; iPass < 2; iPass++ )
+    {
+        for( iBlock = 0; iBlock < nBlocks; iBlock++ )
+        {
+            const double *padfExtent = psTransform->padfBlockExtents + 4 * iBlock;
+            if( padfExtent[0] > padfExtent[2] )
+                continue;
+
+            int iCellX0 = (int) ((padfExtent[0] - dfMinX) / dfCellSize);
+            int iCellY0 = (int) ((padfExtent[1] - dfMinY) / dfCellSize);
+            int iCellX1 = MIN(nGridWidth - 1, (int) ((padfExtent[2] - dfMinX) / dfCellSize));
+            int iCellY1 = MIN(nGridHeight - 1, (int) ((padfExtent[3] - dfMinY) / dfCellSize));
+            int iCellX, iCellY;
+
+            for( iCellY = iCellY0; iCellY <= iCellY1; iCellY++ )
+            {
+                for( iCellX = iCellX0; iCellX <= iCellX1; iCellX++ )
+                {
+                    iCell = iCellX + iCellY * nGridWidth;
+                    if( iPass == 0 )
+                        psTransform->panIndexGridStart[iCell + 1] ++;
+                    else
+                        psTransform->panIndexGridBlocks[
+                            psTransform->panIndexGridStart[iCell] ++] = iBlock;
+                }
+            }
+        }
+
+        if( iPass == 0 )
+        {
+            for( iCell = 0; iCell < nGridCells; iCell++ )
+                psTransform->panIndexGridStart[iCell + 1] += 
+                    psTransform->panIndexGridStart[iCell];
+
+            psTransform->panIndexGridBlocks = (int *) VSIMalloc2( 
+                sizeof(int), MAX(1, psTransform->panIndexGridStart[nGridCells]) );
+            if( psTransform->panIndexGridBlocks == NULL )
+            {
+                CPLError( CE_Failure, CPLE_OutOfMemory,
+                          "Unable to allocate inverse index for geolocation array transformer." );
+                return FALSE;
+            }
+        }
+        else
+        {
+            /* The fill pass advanced each start to the next one. */
+            for( iCell = nGridCells; iCell > 0; iCell-- )
+                psTransform->panIndexGridStart[iCell] = 
+                    psTransform->panIndexGridStart[iCell - 1];
+            psTransform->panIndexGridStart[0] = 0;
+        }
+    }
+
+    CPLDebug( "GEOLOC", "Inverse index: %d x %d blocks, %d x %d grid.",
+              nBlocksX, nBlocksY, nGridWidth, nGridHeight );
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                        GeoLocInverseInBlock()                        */
+/*                                                                      */
+/*      Look for the geolocation array position of (dfGeoX,dfGeoY)      */
+/*      within a block of the inverse index.  The bilinear mapping of   */
+/*      the current cell is inverted with Newton iterations, and we     */
+/*      move to the cell in which the solution falls until it is in     */
+/*      the current one.                                                */
+/************************************************************************/
+
+static int GeoLocInverseInBlock( GDALGeoLocTransformInfo *psTransform,
+                                 int iBlock, double dfGeoX, double dfGeoY,
+                                 double *pdfGeoLocPixel,
+                                 double *pdfGeoLocLine )
+
+{
+    int iBlockX = iBlock % psTransform->nIndexBlocksX;
+    int iBlockY = iBlock / psTransform->nIndexBlocksX;
+    int iMinX = iBlockX * GEOLOC_INDEX_BLOCK_SIZE;
+    int iMinY = iBlockY * GEOLOC_INDEX_BLOCK_SIZE;
+    int iMaxX = MIN(iMinX + GEOLOC_INDEX_BLOCK_SIZE, psTransform->nGeoLocXSize - 1) - 1;
+    int iMaxY = MIN(iMinY + GEOLOC_INDEX_BLOCK_SIZE, psTransform->nGeoLocYSize - 1) - 1;
+    int iX = (iMinX + iMaxX) / 2;
+    int iY = (iMinY + iMaxY) / 2;
+    int iStep;
+    const double dfEps = 1e-8;
+
+    for( iStep = 0; iStep < 2 * GEOLOC_INDEX_BLOCK_SIZE; iStep++ )
+    {
+        const double *padfX, *padfY;
+        int nStride;
+
+        if( !GeoLocGetTile( psTransform, iX, iY, &padfX, &padfY, &nStride ) )
+            return FALSE;
+
+        if( psTransform->bHasNoData &&
+            (padfX[0] == psTransform->dfNoDataX ||
+             padfX[1] == psTransform->dfNoDataX ||
+             padfX[nStride] == psTransform->dfNoDataX ||
+             padfX[nStride + 1] == psTransform->dfNoDataX) )
+            return FALSE;
+
+        /* f(u,v) = P00 + u * A + v * B + u * v * C */
+        double dfAX = padfX[1] - padfX[0];
+        double dfAY = padfY[1] - padfY[0];
+        double dfBX = padfX[nStride] - padfX[0];
+        double dfBY = padfY[nStride] - padfY[0];
+        double dfCX = padfX[nStride + 1] - padfX[nStride] - dfAX;
+        double dfCY = padfY[nStride + 1] - padfY[nStride] - dfAY;
+        double dfU = 0.5, dfV = 0.5;
+        int iIter;
+
+        for( iIter = 0; iIter < 10; iIter++ )
+        {
+            double dfResX = padfX[0] + dfU * dfAX + dfV * dfBX
+                + dfU * dfV * dfCX - dfGeoX;
+            double dfResY = padfY[0] + dfU * dfAY + dfV * dfBY
+                + dfU * dfV * dfCY - dfGeoY;
+            double dfJXU = dfAX + dfV * dfCX;
+            double dfJXV = dfBX + dfU * dfCX;
+            double dfJYU = dfAY + dfV * dfCY;
+            double dfJYV = dfBY + dfU * dfCY;
+            double dfDet = dfJXU * dfJYV - dfJXV * dfJYU;
+
+            if( dfDet == 0.0 )
+                return FALSE;
+
+            double dfDU = (dfResX * dfJYV - dfResY * dfJXV) / dfDet;
+            double dfDV = (dfResY * dfJXU - dfResX * dfJYU) / dfDet;
+
+            dfU -= dfDU;
+            dfV -= dfDV;
+
+            if( fabs(dfDU) < 1e-12 && fabs(dfDV) < 1e-12 )
+                break;
+        }
+
+        if( dfU >= -dfEps && dfU <= 1 + dfEps
+            && dfV >= -dfEps && dfV <= 1 + dfEps )
+        {
+            *pdfGeoLocPixel = iX + dfU;
+            *pdfGeoLocLine = iY + dfV;
+            return TRUE;
+        }
+
+        /* Move towards the solution, staying in the block.  The        */
+        /* extrapolated solution may overshoot when the mapping is       */
+        /* curved, so after a few jumps only move by one cell at a time. */
+        double dfStepX = floor(dfU);
+        double dfStepY = floor(dfV);
+        if( iStep >= 4 )
+        {
+            dfStepX = MAX(-1.0, MIN(1.0, dfStepX));
+            dfStepY = MAX(-1.0, MIN(1.0, dfStepY));
+        }
+        int iNewX = (int) MAX(iMinX, MIN(iMaxX, iX + dfStepX));
+        int iNewY = (int) MAX(iMinY, MIN(iMaxY, iY + dfStepY));
+
+        if( iNewX == iX && iNewY == iY )
+            return FALSE;
+
+        iX = iNewX;
+        iY = iNewY;
+    }
+
+    return FALSE;
+}
+
+/************************************************************************/
+/*                         GeoLocInverseIndex()                         */
+/************************************************************************/
+
+static int GeoLocInverseIndex( GDALGeoLocTransformInfo *psTransform,
+                               double dfGeoX, double dfGeoY,
+                               double *pdfGeoLocPixel,
+                               double *pdfGeoLocLine )
+
+{
+    double dfCellX = (dfGeoX - psTransform->dfIndexMinX)
+                            / psTransform->dfIndexCellSize;
+    double dfCellY = (dfGeoY - psTransform->dfIndexMinY)
+                            / psTransform->dfIndexCellSize;
+
+    if( !(dfCellX >= 0 && dfCellY >= 0
+          && dfCellX < psTransform->nIndexGridWidth
+          && dfCellY < psTransform->nIndexGridHeight) )
+        return FALSE;
+
+    int iCell = (int) dfCellX + (int) dfCellY * psTransform->nIndexGridWidth;
+    int iStart = psTransform->panIndexGridStart[iCell];
+    int iEnd = psTransform->panIndexGridStart[iCell + 1];
+    int i;
+
+/* -------------------------------------------------------------------- */
+/*      Try first the block where the previous point was found, as      */
+/*      successive points are usually close to each other.              */
+/* -------------------------------------------------------------------- */
+    for( i = iStart - 1; i < iEnd; i++ )
+    {
+        int iBlock;
+
+        if( i < iStart )
+        {
+            iBlock = psTransform->nLastBlock;
+            if( iBlock < 0 )
+                continue;
+        }
+        else
+        {
+            iBlock = psTransform->panIndexGridBlocks[i];
+            if( iBlock == psTransform->nLastBlock )
+                continue;
+        }
+
+        const double *padfExtent = psTransform->padfBlockExtents + 4 * iBlock;
+        if( dfGeoX < padfExtent[0] || dfGeoY < padfExtent[1]
+            || dfGeoX > padfExtent[2] || dfGeoY > padfExtent[3] )
+            continue;
+
+        if( GeoLocInverseInBlock( psTransform, iBlock, dfGeoX, dfGeoY,
+                                  pdfGeoLocPixel, pdfGeoLocLine ) )
+        {
+            psTransform->nLastBlock = iBlock;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 /************************************************************************/
 /*                         FindGeoLocPosition()                         */
 /************************************************************************/
@@ -737,6 +1367,8 @@ void *GDALCreateGeoLocTransformer( GDALDatasetH hBaseDS,
         CPLCalloc(sizeof(GDALGeoLocTransformInfo),1);
 
     psTransform->bReversed = bReversed;
+    psTransform->pnSharedRefCount = (volatile int *) CPLMalloc(sizeof(int));
+    *(psTransform->pnSharedRefCount) = 1;
 
     strcpy( psTransform->sTI.szSignature, "GTI" );
     psTransform->sTI.pszClassName = "GDALGeoLocTransformer";
@@ -851,10 +1483,34 @@ void *GDALCreateGeoLocTransformer( GDALDatasetH hBaseDS,
     }
 
 /* -------------------------------------------------------------------- */
-/*      Load the geolocation array.                                     */
+/*      Load the geolocation array and build the backmap, or for        */
+/*      large arrays, build a memory bounded inverse index and read     */
+/*      the arrays on demand.  GDAL_GEOLOC_USE_INDEX=YES/NO can be      */
+/*      used to force either method.                                    */
 /* -------------------------------------------------------------------- */
-    if( !GeoLocLoadFullData( psTransform ) 
-        || !GeoLocGenerateBackMap( psTransform ) )
+    GeoLocInitDimensions( psTransform );
+
+    const char *pszUseIndex = CPLGetConfigOption( "GDAL_GEOLOC_USE_INDEX", NULL );
+    if( pszUseIndex != NULL )
+        psTransform->bUseIndex = CSLTestBoolean( pszUseIndex );
+    else
+        psTransform->bUseIndex = 
+            (double) psTransform->nGeoLocXSize * psTransform->nGeoLocYSize
+                > GEOLOC_INDEX_AUTO_THRESHOLD;
+
+    if( psTransform->nGeoLocXSize < 2 || psTransform->nGeoLocYSize < 2 )
+        psTransform->bUseIndex = FALSE;
+
+    if( psTransform->bUseIndex )
+    {
+        if( !GeoLocBuildIndex( psTransform ) )
+        {
+            GDALDestroyGeoLocTransformer( psTransform );
+            return NULL;
+        }
+    }
+    else if( !GeoLocLoadFullData( psTransform ) 
+             || !GeoLocGenerateBackMap( psTransform ) )
     {
         GDALDestroyGeoLocTransformer( psTransform );
         return NULL;
@@ -873,11 +1529,27 @@ void GDALDestroyGeoLocTransformer( void *pTransformAlg )
     GDALGeoLocTransformInfo *psTransform = 
         (GDALGeoLocTransformInfo *) pTransformAlg;
 
-    CPLFree( psTransform->pafBackMapX );
-    CPLFree( psTransform->pafBackMapY );
+    if( CPLAtomicDec( psTransform->pnSharedRefCount ) == 0 )
+    {
+        CPLFree( psTransform->pafBackMapX );
+        CPLFree( psTransform->pafBackMapY );
+        CPLFree( psTransform->padfGeoLocX );
+        CPLFree( psTransform->padfGeoLocY );
+        CPLFree( psTransform->padfBlockExtents );
+        CPLFree( psTransform->panIndexGridStart );
+        CPLFree( psTransform->panIndexGridBlocks );
+        CPLFree( (void *) psTransform->pnSharedRefCount );
+    }
+
     CSLDestroy( psTransform->papszGeolocationInfo );
-    CPLFree( psTransform->padfGeoLocX );
-    CPLFree( psTransform->padfGeoLocY );
+
+    for( int iTile = 0; iTile < psTransform->nUsedTiles; iTile++ )
+    {
+        CPLFree( psTransform->pasTiles[iTile].padfX );
+        CPLFree( psTransform->pasTiles[iTile].padfY );
+    }
+    CPLFree( psTransform->pasTiles );
+    CPLFree( psTransform->papsTileMap );
              
     if( psTransform->hDS_X != NULL 
         && GDALDereferenceDataset( psTransform->hDS_X ) == 0 )
@@ -890,6 +1562,90 @@ void GDALDestroyGeoLocTransformer( void *pTransformAlg )
     CPLFree( pTransformAlg );
 }
 
+/************************************************************************/
+/*                     GDALCloneGeoLocTransformer()                     */
+/************************************************************************/
+
+void *GDALCloneGeoLocTransformer( void *hTransformArg )
+
+{
+    VALIDATE_POINTER1( hTransformArg, "GDALCloneGeoLocTransformer", NULL );
+
+    GDALGeoLocTransformInfo *psTransform = 
+        (GDALGeoLocTransformInfo *) hTransformArg;
+
+    GDALGeoLocTransformInfo *psClone = (GDALGeoLocTransformInfo *)
+        CPLMalloc(sizeof(GDALGeoLocTransformInfo));
+
+    memcpy( psClone, psTransform, sizeof(GDALGeoLocTransformInfo) );
+    psClone->nUsedTiles = 0;
+    psClone->pasTiles = NULL;
+    psClone->papsTileMap = NULL;
+    psClone->psLastTile = NULL;
+    psClone->nTileCounter = 0;
+
+/* -------------------------------------------------------------------- */
+/*      When the arrays are loaded in memory, the datasets are not      */
+/*      read anymore and can be shared. Otherwise tiles are read on     */
+/*      demand, so the clone needs its own dataset handles.             */
+/* -------------------------------------------------------------------- */
+    if( !psTransform->bUseIndex )
+    {
+        GDALReferenceDataset( psClone->hDS_X );
+        GDALReferenceDataset( psClone->hDS_Y );
+    }
+    else
+    {
+        const char *pszXDS = CSLFetchNameValue( psTransform->papszGeolocationInfo,
+                                                "X_DATASET" );
+        const char *pszYDS = CSLFetchNameValue( psTransform->papszGeolocationInfo,
+                                                "Y_DATASET" );
+
+        psClone->hDS_X = NULL;
+        psClone->hDS_Y = NULL;
+        if( pszXDS != NULL && pszYDS != NULL )
+        {
+            psClone->hDS_X = GDALOpen( pszXDS, GA_ReadOnly );
+            if( EQUAL(pszXDS, pszYDS) )
+            {
+                psClone->hDS_Y = psClone->hDS_X;
+                if( psClone->hDS_Y != NULL )
+                    GDALReferenceDataset( psClone->hDS_Y );
+            }
+            else
+                psClone->hDS_Y = GDALOpen( pszYDS, GA_ReadOnly );
+        }
+
+        psClone->hBand_X = NULL;
+        psClone->hBand_Y = NULL;
+        if( psClone->hDS_X != NULL && psClone->hDS_Y != NULL )
+        {
+            psClone->hBand_X = GDALGetRasterBand( psClone->hDS_X,
+                                                  GDALGetBandNumber( psTransform->hBand_X ) );
+            psClone->hBand_Y = GDALGetRasterBand( psClone->hDS_Y,
+                                                  GDALGetBandNumber( psTransform->hBand_Y ) );
+        }
+
+        if( psClone->hBand_X == NULL || psClone->hBand_Y == NULL )
+        {
+            if( psClone->hDS_X != NULL 
+                && GDALDereferenceDataset( psClone->hDS_X ) == 0 )
+                GDALClose( psClone->hDS_X );
+            if( psClone->hDS_Y != NULL 
+                && GDALDereferenceDataset( psClone->hDS_Y ) == 0 )
+                GDALClose( psClone->hDS_Y );
+            CPLFree( psClone );
+            return NULL;
+        }
+    }
+
+    psClone->papszGeolocationInfo = 
+        CSLDuplicate( psTransform->papszGeolocationInfo );
+    CPLAtomicInc( psClone->pnSharedRefCount );
+
+    return psClone;
+}
+
 /************************************************************************/
 /*                        GDALGeoLocTransform()                         */
 /************************************************************************/
@@ -911,7 +1667,7 @@ int GDALGeoLocTransform( void *pTransformArg, int bDstToSrc,
 /* -------------------------------------------------------------------- */
     if( !bDstToSrc )
     {
-        int i, nXSize = psTransform->nGeoLocXSize;
+        int i;
 
         for( i = 0; i < nPointCount; i++ )
         {
@@ -933,8 +1689,26 @@ int GDALGeoLocTransform( void *pTransformArg, int bDstToSrc,
             iY = MAX(0,(int) dfGeoLocLine);
             iY = MIN(iY,psTransform->nGeoLocYSize-1);
 
-            double *padfGLX = psTransform->padfGeoLocX + iX + iY * nXSize;
-            double *padfGLY = psTransform->padfGeoLocY + iX + iY * nXSize;
+            const double *padfGLX, *padfGLY;
+            int nXSize;
+
+            if( psTransform->bUseIndex )
+            {
+                if( !GeoLocGetTile( psTransform, iX, iY,
+                                    &padfGLX, &padfGLY, &nXSize ) )
+                {
+                    panSuccess[i] = FALSE;
+                    padfX[i] = HUGE_VAL;
+                    padfY[i] = HUGE_VAL;
+                    continue;
+                }
+            }
+            else
+            {
+                nXSize = psTransform->nGeoLocXSize;
+                padfGLX = psTransform->padfGeoLocX + iX + iY * nXSize;
+                padfGLY = psTransform->padfGeoLocY + iX + iY * nXSize;
+            }
 
             if( psTransform->bHasNoData &&
                 padfGLX[0] == psTransform->dfNoDataX )
@@ -988,6 +1762,40 @@ int GDALGeoLocTransform( void *pTransformArg, int bDstToSrc,
         }
     }
 
+/* -------------------------------------------------------------------- */
+/*      geox/geoy to pixel/line using the inverse index.                */
+/* -------------------------------------------------------------------- */
+    else if( psTransform->bUseIndex )
+    {
+        int i;
+
+        for( i = 0; i < nPointCount; i++ )
+        {
+            double dfGeoLocPixel, dfGeoLocLine;
+
+            if( padfX[i] == HUGE_VAL || padfY[i] == HUGE_VAL )
+            {
+                panSuccess[i] = FALSE;
+                continue;
+            }
+
+            if( !GeoLocInverseIndex( psTransform, padfX[i], padfY[i],
+                                     &dfGeoLocPixel, &dfGeoLocLine ) )
+            {
+                panSuccess[i] = FALSE;
+                padfX[i] = HUGE_VAL;
+                padfY[i] = HUGE_VAL;
+                continue;
+            }
+
+            padfX[i] = dfGeoLocPixel * psTransform->dfPIXEL_STEP 
+                + psTransform->dfPIXEL_OFFSET;
+            padfY[i] = dfGeoLocLine * psTransform->dfLINE_STEP 
+                + psTransform->dfLINE_OFFSET;
+            panSuccess[i] = TRUE;
+        }
+    }
+
 /* -------------------------------------------------------------------- */
 /*      geox/geoy to pixel/line using backmap.                          */
 /* -------------------------------------------------------------------- */
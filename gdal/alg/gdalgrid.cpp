@@ -1507,7 +1507,6 @@ struct _GDALGridJob
     int               (*pfnProgress)(GDALGridJob* psJob);
     GDALDataType        eType;
 
-    void           *hThread;
     volatile int   *pnCounter;
     volatile int   *pbStop;
     void           *hCond;
@@ -1948,7 +1947,14 @@ GDALGridCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
     sJob.pbStop = &bStop;
     sJob.hCond = NULL;
     sJob.hCondMutex = NULL;
-    sJob.hThread = NULL;
+
+    CPLWorkerThreadPool* poThreadPool = NULL;
+    if( nThreads > 1 )
+    {
+        poThreadPool = CPLGetWorkerThreadPool(nThreads);
+        if( poThreadPool == NULL )
+            nThreads = 1;
+    }
 
     if( nThreads > 1 )
     {
@@ -1970,6 +1976,7 @@ GDALGridCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
     else
     {
         GDALGridJob* pasJobs = (GDALGridJob*) CPLMalloc(sizeof(GDALGridJob) * nThreads);
+        CPLJobGroup oJobGroup;
         int i;
 
         CPLDebug("GDAL_GRID", "Using %d threads", nThreads);
@@ -1979,22 +1986,28 @@ GDALGridCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
         sJob.pfnProgress = GDALGridProgressMultiThread;
 
 /* -------------------------------------------------------------------- */
-/*      Start threads.                                                  */
+/*      Submit jobs to the worker threads.                              */
 /* -------------------------------------------------------------------- */
         for(i = 0; i < nThreads && !bStop; i++)
         {
             memcpy(&pasJobs[i], &sJob, sizeof(GDALGridJob));
             pasJobs[i].nYStart = i;
-            pasJobs[i].hThread = CPLCreateJoinableThread( GDALGridJobProcess,
-                                                          (void*) &pasJobs[i] );
+            poThreadPool->SubmitJob( GDALGridJobProcess, (void*) &pasJobs[i],
+                                     &oJobGroup );
         }
 
 /* -------------------------------------------------------------------- */
-/*      Report progress.                                                */
+/*      Report progress.  Run ourselves the jobs no worker thread has   */
+/*      started yet, in case they are all busy.                         */
 /* -------------------------------------------------------------------- */
         while(nCounter < (int)nYSize && !bStop)
         {
-            CPLCondWait(sJob.hCond, sJob.hCondMutex);
+            CPLReleaseMutex(sJob.hCondMutex);
+            int bRanJob = poThreadPool->RunPendingJob(&oJobGroup);
+            CPLAcquireMutex(sJob.hCondMutex, 1.0);
+
+            if( !bRanJob && nCounter < (int)nYSize )
+                CPLCondWait(sJob.hCond, sJob.hCondMutex);
 
             int nLocalCounter = nCounter;
             CPLReleaseMutex(sJob.hCondMutex);
@@ -2008,18 +2021,14 @@ GDALGridCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             CPLAcquireMutex(sJob.hCondMutex, 1.0);
         }
 
-        /* Release mutex before joining threads, otherwise they will dead-lock */
-        /* forever in GDALGridProgressMultiThread() */
+        /* Release mutex before waiting for the jobs, otherwise they will */
+        /* dead-lock forever in GDALGridProgressMultiThread() */
         CPLReleaseMutex(sJob.hCondMutex);
 
 /* -------------------------------------------------------------------- */
-/*      Wait for all threads to complete and finish.                    */
+/*      Wait for all jobs to complete and finish.                       */
 /* -------------------------------------------------------------------- */
-        for(i=0;i<nThreads;i++)
-        {
-            if( pasJobs[i].hThread )
-                CPLJoinThread(pasJobs[i].hThread);
-        }
+        poThreadPool->WaitCompletion(&oJobGroup);
 
         CPLFree(pasJobs);
         CPLDestroyCond(sJob.hCond);
@@ -2325,6 +2325,44 @@ void GDALDestroyReprojectionTransformer( void *pTransformArg )
     CPLFree( psInfo );
 }
 
+/************************************************************************/
+/*                  GDALCloneReprojectionTransformer()                  */
+/************************************************************************/
+
+void *GDALCloneReprojectionTransformer( void *hTransformArg )
+
+{
+    VALIDATE_POINTER1( hTransformArg, "GDALCloneReprojectionTransformer", NULL );
+
+    GDALReprojectionTransformInfo *psInfo = 
+        (GDALReprojectionTransformInfo *) hTransformArg;
+
+/* -------------------------------------------------------------------- */
+/*      Build new coordinate transformations from the SRS objects of    */
+/*      the existing ones, which avoids going through WKT.              */
+/* -------------------------------------------------------------------- */
+    OGRCoordinateTransformation *poForwardTransform =
+        OGRCreateCoordinateTransformation(
+            psInfo->poForwardTransform->GetSourceCS(),
+            psInfo->poForwardTransform->GetTargetCS() );
+    if( poForwardTransform == NULL )
+        return NULL;
+
+    GDALReprojectionTransformInfo *psClonedInfo = 
+        (GDALReprojectionTransformInfo *) 
+        CPLMalloc(sizeof(GDALReprojectionTransformInfo));
+
+    memcpy( psClonedInfo, psInfo, sizeof(GDALReprojectionTransformInfo) );
+    psClonedInfo->poForwardTransform = poForwardTransform;
+    psClonedInfo->poReverseTransform = NULL;
+    if( psInfo->poReverseTransform != NULL )
+        psClonedInfo->poReverseTransform = OGRCreateCoordinateTransformation(
+            psInfo->poReverseTransform->GetSourceCS(),
+            psInfo->poReverseTransform->GetTargetCS() );
+
+    return psClonedInfo;
+}
+
 /************************************************************************/
 /*                     GDALReprojectionTransform()                      */
 /************************************************************************/
@@ -2456,8 +2494,418 @@ typedef struct
     double	      dfMaxError;
 
     int               bOwnSubtransformer;
+
+    int               bGrid2D;
+    struct _ApproxGridBand *psGridBand;    /* cache of the 2D grid mode */
 } ApproxTransformInfo;
 
+/************************************************************************/
+/* ==================================================================== */
+/*      Two-dimensional grid approximation.                             */
+/*                                                                      */
+/*      When enabled, calls made with points along a scanline (the      */
+/*      way the warp kernel transforms destination rows) are served     */
+/*      from a band of grid cells covering several consecutive          */
+/*      scanlines.  The exact transform is only computed at the cell    */
+/*      corners, and at the cell center to check that bilinear          */
+/*      interpolation inside the cell is within the error threshold.    */
+/*      Cells that are not are split in four, down to a minimum size,   */
+/*      below which the exact transform is used.                        */
+/* ==================================================================== */
+/************************************************************************/
+
+/* Number of input points spanned by the side of a top-level cell */
+#define APPROX_GRID_CELL_POINTS     64
+/* Maximum number of times a cell can be split in four */
+#define APPROX_GRID_MAX_DEPTH       4
+
+typedef struct
+{
+    double      dfXMin, dfXMax, dfYMin, dfYMax;
+
+    /* Transformed corners : (XMin,YMin), (XMax,YMin), (XMin,YMax), (XMax,YMax) */
+    double      adfX[4], adfY[4], adfZ[4];
+
+    int         bValid;         /* bilinear interpolation is within error */
+    int         iFirstChild;    /* first of the 4 sub-cells, or -1 */
+    int         nDepth;
+} ApproxGridCell;
+
+typedef struct _ApproxGridBand
+{
+    /* Key of the cached band */
+    int         bDstToSrc;
+    double      dfZ;
+    double      dfXOrigin;
+    double      dfCellSize;
+    int         nBand;          /* band covers [nBand, nBand+1] * dfCellSize in Y */
+    int         nCols;          /* number of top-level cells */
+
+    int         nCells;
+    int         nMaxCells;
+    ApproxGridCell *pasCells;   /* the nCols first ones are the top-level cells */
+} ApproxGridBand;
+
+static void GDALDestroyApproxGridBand( ApproxGridBand *psBand )
+
+{
+    if( psBand != NULL )
+    {
+        CPLFree( psBand->pasCells );
+        CPLFree( psBand );
+    }
+}
+
+/************************************************************************/
+/*                      GDALApproxGridCellError()                       */
+/*                                                                      */
+/*      Error of the bilinear interpolation at the center of the cell.  */
+/************************************************************************/
+
+static double GDALApproxGridCellError( const ApproxGridCell *psCell,
+                                       double dfCenterX, double dfCenterY )
+
+{
+    double dfX = (psCell->adfX[0] + psCell->adfX[1] +
+                  psCell->adfX[2] + psCell->adfX[3]) * 0.25;
+    double dfY = (psCell->adfY[0] + psCell->adfY[1] +
+                  psCell->adfY[2] + psCell->adfY[3]) * 0.25;
+
+    return fabs(dfX - dfCenterX) + fabs(dfY - dfCenterY);
+}
+
+/************************************************************************/
+/*                      GDALApproxGridSplitCell()                       */
+/*                                                                      */
+/*      Split a cell whose center was found too far from the bilinear   */
+/*      interpolation, and validate the sub-cells recursively.          */
+/************************************************************************/
+
+static void GDALApproxGridSplitCell( ApproxTransformInfo *psATInfo,
+                                     ApproxGridBand *psBand, int iCell,
+                                     double dfCenterX, double dfCenterY,
+                                     double dfCenterZ )
+
+{
+    if( psBand->pasCells[iCell].nDepth >= APPROX_GRID_MAX_DEPTH )
+        return;
+
+    if( psBand->nCells + 4 > psBand->nMaxCells )
+    {
+        psBand->nMaxCells = psBand->nMaxCells * 2 + 4;
+        psBand->pasCells = (ApproxGridCell *)
+            CPLRealloc( psBand->pasCells,
+                        sizeof(ApproxGridCell) * psBand->nMaxCells );
+    }
+
+    const ApproxGridCell sCell = psBand->pasCells[iCell];
+    const double dfXMid = (sCell.dfXMin + sCell.dfXMax) * 0.5;
+    const double dfYMid = (sCell.dfYMin + sCell.dfYMax) * 0.5;
+
+/* -------------------------------------------------------------------- */
+/*      Transform the middle of the 4 edges and the centers of the      */
+/*      sub-cells.                                                      */
+/* -------------------------------------------------------------------- */
+    double adfX[8], adfY[8], adfZ[8];
+    int    anSuccess[8], i;
+
+    adfX[0] = dfXMid;       adfY[0] = sCell.dfYMin;    /* top */
+    adfX[1] = sCell.dfXMin; adfY[1] = dfYMid;          /* left */
+    adfX[2] = sCell.dfXMax; adfY[2] = dfYMid;          /* right */
+    adfX[3] = dfXMid;       adfY[3] = sCell.dfYMax;    /* bottom */
+    adfX[4] = (sCell.dfXMin + dfXMid) * 0.5;
+    adfY[4] = (sCell.dfYMin + dfYMid) * 0.5;
+    adfX[5] = (dfXMid + sCell.dfXMax) * 0.5;
+    adfY[5] = adfY[4];
+    adfX[6] = adfX[4];
+    adfY[6] = (dfYMid + sCell.dfYMax) * 0.5;
+    adfX[7] = adfX[5];
+    adfY[7] = adfY[6];
+    for( i = 0; i < 8; i++ )
+        adfZ[i] = psBand->dfZ;
+
+    if( !psATInfo->pfnBaseTransformer( psATInfo->pBaseCBData,
+                                       psBand->bDstToSrc, 8,
+                                       adfX, adfY, adfZ, anSuccess ) )
+        return;
+    for( i = 0; i < 8; i++ )
+    {
+        if( !anSuccess[i] )
+            return;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Create the sub-cells.                                           */
+/* -------------------------------------------------------------------- */
+    /* Transformed values at the 3x3 nodes of the split cell */
+    const double adfNodeX[9] = { sCell.adfX[0], adfX[0], sCell.adfX[1],
+                                 adfX[1], dfCenterX, adfX[2],
+                                 sCell.adfX[2], adfX[3], sCell.adfX[3] };
+    const double adfNodeY[9] = { sCell.adfY[0], adfY[0], sCell.adfY[1],
+                                 adfY[1], dfCenterY, adfY[2],
+                                 sCell.adfY[2], adfY[3], sCell.adfY[3] };
+    const double adfNodeZ[9] = { sCell.adfZ[0], adfZ[0], sCell.adfZ[1],
+                                 adfZ[1], dfCenterZ, adfZ[2],
+                                 sCell.adfZ[2], adfZ[3], sCell.adfZ[3] };
+
+    const int iFirstChild = psBand->nCells;
+    psBand->pasCells[iCell].iFirstChild = iFirstChild;
+    psBand->nCells += 4;
+
+    for( i = 0; i < 4; i++ )
+    {
+        ApproxGridCell *psChild = psBand->pasCells + iFirstChild + i;
+        const int iCol = i % 2, iRow = i / 2;
+        const int iNode = iRow * 3 + iCol;
+
+        psChild->dfXMin = (iCol == 0) ? sCell.dfXMin : dfXMid;
+        psChild->dfXMax = (iCol == 0) ? dfXMid : sCell.dfXMax;
+        psChild->dfYMin = (iRow == 0) ? sCell.dfYMin : dfYMid;
+        psChild->dfYMax = (iRow == 0) ? dfYMid : sCell.dfYMax;
+
+        const int anNodes[4] = { iNode, iNode + 1, iNode + 3, iNode + 4 };
+        for( int iCorner = 0; iCorner < 4; iCorner++ )
+        {
+            psChild->adfX[iCorner] = adfNodeX[anNodes[iCorner]];
+            psChild->adfY[iCorner] = adfNodeY[anNodes[iCorner]];
+            psChild->adfZ[iCorner] = adfNodeZ[anNodes[iCorner]];
+        }
+        psChild->iFirstChild = -1;
+        psChild->nDepth = sCell.nDepth + 1;
+        psChild->bValid = GDALApproxGridCellError( psChild,
+                              adfX[4+i], adfY[4+i] ) <= psATInfo->dfMaxError;
+    }
+
+    /* pasCells may be reallocated by the recursive calls */
+    for( i = 0; i < 4; i++ )
+    {
+        if( !psBand->pasCells[iFirstChild + i].bValid )
+            GDALApproxGridSplitCell( psATInfo, psBand, iFirstChild + i,
+                                     adfX[4+i], adfY[4+i], adfZ[4+i] );
+    }
+}
+
+/************************************************************************/
+/*                       GDALApproxGridGetBand()                        */
+/*                                                                      */
+/*      Return the band of cells covering the passed scanline, reusing  */
+/*      the cached one when possible.                                   */
+/************************************************************************/
+
+static ApproxGridBand *GDALApproxGridGetBand( ApproxTransformInfo *psATInfo,
+                                              int bDstToSrc,
+                                              double dfXMin, double dfXMax,
+                                              double dfY, double dfZ,
+                                              double dfCellSize )
+
+{
+    const int nBand = (int) floor(dfY / dfCellSize);
+    const int nCols = (int) ceil((dfXMax - dfXMin) / dfCellSize);
+    ApproxGridBand *psBand = psATInfo->psGridBand;
+
+    if( psBand != NULL && psBand->bDstToSrc == bDstToSrc &&
+        psBand->dfZ == dfZ && psBand->dfXOrigin == dfXMin &&
+        psBand->dfCellSize == dfCellSize && psBand->nBand == nBand &&
+        psBand->nCols == nCols )
+        return psBand;
+
+    if( psBand == NULL )
+    {
+        psBand = (ApproxGridBand *) CPLCalloc( sizeof(ApproxGridBand), 1 );
+        psATInfo->psGridBand = psBand;
+    }
+
+    psBand->bDstToSrc = bDstToSrc;
+    psBand->dfZ = dfZ;
+    psBand->dfXOrigin = dfXMin;
+    psBand->dfCellSize = dfCellSize;
+    psBand->nBand = nBand;
+    psBand->nCols = nCols;
+    psBand->nCells = nCols;
+    if( psBand->nMaxCells < nCols )
+    {
+        psBand->nMaxCells = nCols * 2;
+        psBand->pasCells = (ApproxGridCell *)
+            CPLRealloc( psBand->pasCells,
+                        sizeof(ApproxGridCell) * psBand->nMaxCells );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Transform the top and bottom rows of the corners, and the       */
+/*      centers of the cells, in a single call.                         */
+/* -------------------------------------------------------------------- */
+    const int nPoints = 3 * nCols + 2;
+    double *padfX = (double *) CPLMalloc( sizeof(double) * nPoints * 3 );
+    double *padfY = padfX + nPoints;
+    double *padfZ = padfY + nPoints;
+    int    *panSuccess = (int *) CPLMalloc( sizeof(int) * nPoints );
+    const double dfYTop = nBand * dfCellSize;
+    int i;
+
+    for( i = 0; i <= nCols; i++ )
+    {
+        padfX[i] = dfXMin + i * dfCellSize;
+        padfY[i] = dfYTop;
+        padfX[nCols + 1 + i] = padfX[i];
+        padfY[nCols + 1 + i] = dfYTop + dfCellSize;
+    }
+    for( i = 0; i < nCols; i++ )
+    {
+        padfX[2 * nCols + 2 + i] = dfXMin + (i + 0.5) * dfCellSize;
+        padfY[2 * nCols + 2 + i] = dfYTop + 0.5 * dfCellSize;
+    }
+    for( i = 0; i < nPoints; i++ )
+        padfZ[i] = dfZ;
+
+    if( !psATInfo->pfnBaseTransformer( psATInfo->pBaseCBData, bDstToSrc,
+                                       nPoints, padfX, padfY, padfZ,
+                                       panSuccess ) )
+        memset( panSuccess, 0, sizeof(int) * nPoints );
+
+/* -------------------------------------------------------------------- */
+/*      Set up and validate the top-level cells.                        */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < nCols; i++ )
+    {
+        ApproxGridCell *psCell = psBand->pasCells + i;
+        const int anCorners[4] = { i, i + 1, nCols + 1 + i, nCols + 2 + i };
+        const int iCenter = 2 * nCols + 2 + i;
+
+        psCell->dfXMin = dfXMin + i * dfCellSize;
+        psCell->dfXMax = psCell->dfXMin + dfCellSize;
+        psCell->dfYMin = dfYTop;
+        psCell->dfYMax = dfYTop + dfCellSize;
+        psCell->iFirstChild = -1;
+        psCell->nDepth = 0;
+        psCell->bValid = panSuccess[iCenter];
+        for( int iCorner = 0; iCorner < 4; iCorner++ )
+        {
+            psCell->adfX[iCorner] = padfX[anCorners[iCorner]];
+            psCell->adfY[iCorner] = padfY[anCorners[iCorner]];
+            psCell->adfZ[iCorner] = padfZ[anCorners[iCorner]];
+            if( !panSuccess[anCorners[iCorner]] )
+                psCell->bValid = FALSE;
+        }
+        if( psCell->bValid &&
+            GDALApproxGridCellError( psCell, padfX[iCenter], padfY[iCenter] )
+                > psATInfo->dfMaxError )
+        {
+            psCell->bValid = FALSE;
+            GDALApproxGridSplitCell( psATInfo, psBand, i, padfX[iCenter],
+                                     padfY[iCenter], padfZ[iCenter] );
+        }
+    }
+
+    CPLFree( padfX );
+    CPLFree( panSuccess );
+
+    return psBand;
+}
+
+/************************************************************************/
+/*                     GDALApproxGridTransform()                        */
+/*                                                                      */
+/*      Returns FALSE if the points cannot be handled by the grid, in   */
+/*      which case nothing has been done.                               */
+/************************************************************************/
+
+static int GDALApproxGridTransform( ApproxTransformInfo *psATInfo,
+                                    int bDstToSrc, int nPoints,
+                                    double *x, double *y, double *z,
+                                    int *panSuccess, int *pbResult )
+
+{
+    const double dfXMin = x[0];
+    const double dfXMax = x[nPoints-1];
+    const double dfY = y[0];
+    const double dfZ = z[0];
+    int i;
+
+    if( !(dfXMax > dfXMin) )
+        return FALSE;
+
+    for( i = 0; i < nPoints; i++ )
+    {
+        if( y[i] != dfY || z[i] != dfZ || x[i] < dfXMin || x[i] > dfXMax )
+            return FALSE;
+    }
+
+    const double dfCellSize =
+        (dfXMax - dfXMin) * APPROX_GRID_CELL_POINTS / (nPoints - 1);
+    ApproxGridBand *psBand = GDALApproxGridGetBand( psATInfo, bDstToSrc,
+                                                    dfXMin, dfXMax, dfY, dfZ,
+                                                    dfCellSize );
+
+/* -------------------------------------------------------------------- */
+/*      Interpolate the points falling in valid cells, and compute      */
+/*      the others exactly, by runs of consecutive points.              */
+/* -------------------------------------------------------------------- */
+    int iExactStart = -1;
+
+    *pbResult = TRUE;
+    for( i = 0; i <= nPoints; i++ )
+    {
+        const ApproxGridCell *psCell = NULL;
+
+        if( i < nPoints )
+        {
+            int iCol = (int) ((x[i] - dfXMin) / dfCellSize);
+            iCol = MAX(0, MIN(psBand->nCols - 1, iCol));
+            psCell = psBand->pasCells + iCol;
+            while( psCell->iFirstChild >= 0 )
+            {
+                int iChild = psCell->iFirstChild;
+                if( x[i] >= (psCell->dfXMin + psCell->dfXMax) * 0.5 )
+                    iChild += 1;
+                if( dfY >= (psCell->dfYMin + psCell->dfYMax) * 0.5 )
+                    iChild += 2;
+                psCell = psBand->pasCells + iChild;
+            }
+            if( !psCell->bValid )
+            {
+                if( iExactStart < 0 )
+                    iExactStart = i;
+                continue;
+            }
+        }
+
+        if( iExactStart >= 0 )
+        {
+            if( !psATInfo->pfnBaseTransformer( psATInfo->pBaseCBData,
+                                               bDstToSrc, i - iExactStart,
+                                               x + iExactStart,
+                                               y + iExactStart,
+                                               z + iExactStart,
+                                               panSuccess + iExactStart ) )
+                *pbResult = FALSE;
+            iExactStart = -1;
+        }
+
+        if( psCell == NULL )
+            break;
+
+        const double dfU = (x[i] - psCell->dfXMin) /
+                           (psCell->dfXMax - psCell->dfXMin);
+        const double dfV = (dfY - psCell->dfYMin) /
+                           (psCell->dfYMax - psCell->dfYMin);
+        const double df00 = (1 - dfU) * (1 - dfV);
+        const double df10 = dfU * (1 - dfV);
+        const double df01 = (1 - dfU) * dfV;
+        const double df11 = dfU * dfV;
+
+        x[i] = df00 * psCell->adfX[0] + df10 * psCell->adfX[1] +
+               df01 * psCell->adfX[2] + df11 * psCell->adfX[3];
+        y[i] = df00 * psCell->adfY[0] + df10 * psCell->adfY[1] +
+               df01 * psCell->adfY[2] + df11 * psCell->adfY[3];
+        z[i] = df00 * psCell->adfZ[0] + df10 * psCell->adfZ[1] +
+               df01 * psCell->adfZ[2] + df11 * psCell->adfZ[3];
+        panSuccess[i] = TRUE;
+    }
+
+    return TRUE;
+}
+
+
 /************************************************************************/
 /*                    GDALCloneApproxTransformer()                      */
 /************************************************************************/
@@ -2473,6 +2921,7 @@ void* GDALCloneApproxTransformer( void *hTransformArg )
         CPLMalloc(sizeof(ApproxTransformInfo));
 
     memcpy(psClonedInfo, psInfo, sizeof(ApproxTransformInfo));
+    psClonedInfo->psGridBand = NULL;
     if( psClonedInfo->pBaseCBData )
     {
         psClonedInfo->pBaseCBData = GDALCloneTransformer( psInfo->pBaseCBData );
@@ -2505,6 +2954,8 @@ GDALSerializeApproxTransformer( void *pTransformArg )
 /* -------------------------------------------------------------------- */
     CPLCreateXMLElementAndValue( psTree, "MaxError", 
                                  CPLString().Printf("%g",psInfo->dfMaxError) );
+    if( psInfo->bGrid2D )
+        CPLCreateXMLElementAndValue( psTree, "Grid2D", "YES" );
 
 /* -------------------------------------------------------------------- */
 /*      Capture underlying transformer.                                 */
@@ -2554,6 +3005,17 @@ GDALSerializeApproxTransformer( void *pTransformArg )
  * circumstances as little internal validation is done, in order to keep things
  * fast. 
  *
+ * If the GDAL_APPROX_TRANSFORMER_2D configuration option is set to YES
+ * (GDAL >= 2.0), consecutive scanlines are approximated together: the exact
+ * transform is computed on a grid of cells spanning 64 points of a scanline
+ * in each direction, and bilinearly interpolated inside the cells whose
+ * center is within the error threshold.  Other cells are split in four, up
+ * to 4 times, and the exact transform is used in the cells that are still
+ * not accurate enough.  This saves most of the exact evaluations of
+ * expensive transformers (RPC, geolocation arrays, datum shift grids).
+ * The resulting transformer caches the last band of cells, so, like most
+ * transformers, it must not be used by several threads at the same time.
+ *
  * @param pfnBaseTransformer the high precision transformer which should be
  * approximated. 
  * @param pBaseTransformArg the callback argument for the high precision 
@@ -2576,6 +3038,9 @@ void *GDALCreateApproxTransformer( GDALTransformerFunc pfnBaseTransformer,
     psATInfo->pBaseCBData = pBaseTransformArg;
     psATInfo->dfMaxError = dfMaxError;
     psATInfo->bOwnSubtransformer = FALSE;
+    psATInfo->bGrid2D = CSLTestBoolean(
+        CPLGetConfigOption( "GDAL_APPROX_TRANSFORMER_2D", "NO" ) );
+    psATInfo->psGridBand = NULL;
 
     strcpy( psATInfo->sTI.szSignature, "GTI" );
     psATInfo->sTI.pszClassName = "GDALApproxTransformer";
@@ -2621,6 +3086,8 @@ void GDALDestroyApproxTransformer( void * pCBData )
     if( psATInfo->bOwnSubtransformer ) 
         GDALDestroyTransformer( psATInfo->pBaseCBData );
 
+    GDALDestroyApproxGridBand( psATInfo->psGridBand );
+
     CPLFree( pCBData );
 }
 
@@ -2637,11 +3104,40 @@ void GDALDestroyApproxTransformer( void * pCBData )
  * there. 
  */
  
+static int GDALApproxTransformInternal( ApproxTransformInfo *psATInfo,
+                                       int bDstToSrc, int nPoints,
+                                       double *x, double *y, double *z,
+                                       int *panSuccess );
+
 int GDALApproxTransform( void *pCBData, int bDstToSrc, int nPoints, 
                          double *x, double *y, double *z, int *panSuccess )
 
 {
     ApproxTransformInfo *psATInfo = (ApproxTransformInfo *) pCBData;
+    int bResult;
+
+    if( psATInfo->bGrid2D && psATInfo->dfMaxError > 0.0 &&
+        nPoints > 5 &&
+        GDALApproxGridTransform( psATInfo, bDstToSrc, nPoints,
+                                 x, y, z, panSuccess, &bResult ) )
+        return bResult;
+
+    return GDALApproxTransformInternal( psATInfo, bDstToSrc, nPoints,
+                                        x, y, z, panSuccess );
+}
+
+/************************************************************************/
+/*                    GDALApproxTransformInternal()                     */
+/*                                                                      */
+/*      Linear approximation along a single scanline.                   */
+/************************************************************************/
+
+static int GDALApproxTransformInternal( ApproxTransformInfo *psATInfo,
+                                        int bDstToSrc, int nPoints,
+                                        double *x, double *y, double *z,
+                                        int *panSuccess )
+
+{
     double x2[3], y2[3], z2[3], dfDeltaX, dfDeltaY, dfError, dfDist, dfDeltaZ;
     int nMiddle, anSuccess2[3], i, bSuccess;
 
@@ -2699,16 +3195,16 @@ int GDALApproxTransform( void *pCBData, int bDstToSrc, int nPoints,
 #endif
 
         bSuccess = 
-            GDALApproxTransform( psATInfo, bDstToSrc, nMiddle, 
-                                 x, y, z, panSuccess );
+            GDALApproxTransformInternal( psATInfo, bDstToSrc, nMiddle, 
+                                         x, y, z, panSuccess );
             
         if( !bSuccess )
             return FALSE;
 
         bSuccess = 
-            GDALApproxTransform( psATInfo, bDstToSrc, nPoints - nMiddle,
-                                 x+nMiddle, y+nMiddle, z+nMiddle,
-                                 panSuccess+nMiddle );
+            GDALApproxTransformInternal( psATInfo, bDstToSrc, nPoints - nMiddle,
+                                         x+nMiddle, y+nMiddle, z+nMiddle,
+                                         panSuccess+nMiddle );
 
         if( !bSuccess )
             return FALSE;
@@ -2770,6 +3266,8 @@ GDALDeserializeApproxTransformer( CPLXMLNode *psTree )
                                                            pBaseCBData, 
                                                            dfMaxError );
         GDALApproxTransformerOwnsSubtransformer( pApproxCBData, TRUE );
+        if( CSLTestBoolean( CPLGetXMLValue( psTree, "Grid2D", "NO" ) ) )
+            ((ApproxTransformInfo *) pApproxCBData)->bGrid2D = TRUE;
 
         return pApproxCBData;
     }
@@ -3125,7 +3623,6 @@ void *GDALCloneTransformer( void *pTransformArg )
     {
         pfnClone = GDALCloneTPSTransformer;
     }
-    /* TODO
     else if( EQUAL(psInfo->pszClassName,"GDALGeoLocTransformer") )
     {
         pfnClone = GDALCloneGeoLocTransformer;
@@ -3134,18 +3631,14 @@ void *GDALCloneTransformer( void *pTransformArg )
     {
         pfnClone = GDALCloneRPCTransformer;
     }
-    */
     else if( EQUAL(psInfo->pszClassName,"GDALGenImgProjTransformer") )
     {
         pfnClone = GDALCloneGenImgProjTransformer;
     }
-    /* Useless : serialization/deserialization is fine */
-    /*
     else if( EQUAL(psInfo->pszClassName,"GDALReprojectionTransformer") )
     {
         pfnClone = GDALCloneReprojectionTransformer;
     }
-    */
     else if( EQUAL(psInfo->pszClassName,"GDALApproxTransformer") )
     {
         pfnClone = GDALCloneApproxTransformer;
@@ -3181,3 +3674,163 @@ void *GDALCloneTransformer( void *pTransformArg )
         return pClonedTransformArg;
     }
 }
+
+/************************************************************************/
+/* ==================================================================== */
+/*                      GDALTransformerClonePool                        */
+/* ==================================================================== */
+/************************************************************************/
+
+struct _GDALTransformerClonePool
+{
+    void   *pTransformArg;
+    void   *hMutex;
+    int     nFreeClones;
+    int     nMaxFreeClones;
+    void  **papFreeClones;
+    GDALTransformerClonePool *psNext;
+};
+
+/* Existing pools, so that they can be found from their transformer */
+static GDALTransformerClonePool *psClonePoolList = NULL;
+static void *hClonePoolListMutex = NULL;
+
+/************************************************************************/
+/*                   GDALCreateTransformerClonePool()                   */
+/************************************************************************/
+
+/**
+ * Create a pool of clones of a transformer.
+ *
+ * Worker threads cannot share a transformer, so they use clones of it
+ * obtained with GDALCloneTransformer().  The pool keeps the clones once
+ * they have been released, so that a sequence of multi-threaded operations
+ * with the same transformer (for instance the warping of the chunks of a
+ * GDALWarpOperation) only pays the cost of the cloning once per thread.
+ *
+ * The pool can be found from the transformer with
+ * GDALGetTransformerClonePool().  The transformer must not be modified,
+ * nor destroyed, while the pool exists.
+ *
+ * @param pTransformArg the transformer to clone.
+ * @return the pool, to destroy with GDALDestroyTransformerClonePool().
+ */
+
+GDALTransformerClonePool *GDALCreateTransformerClonePool( void *pTransformArg )
+
+{
+    GDALTransformerClonePool *psPool = (GDALTransformerClonePool *)
+        CPLCalloc(sizeof(GDALTransformerClonePool), 1);
+
+    psPool->pTransformArg = pTransformArg;
+
+    CPLMutexHolderD( &hClonePoolListMutex );
+    psPool->psNext = psClonePoolList;
+    psClonePoolList = psPool;
+
+    return psPool;
+}
+
+/************************************************************************/
+/*                   GDALDestroyTransformerClonePool()                  */
+/************************************************************************/
+
+void GDALDestroyTransformerClonePool( GDALTransformerClonePool *psPool )
+
+{
+    if( psPool == NULL )
+        return;
+
+    {
+        CPLMutexHolderD( &hClonePoolListMutex );
+        GDALTransformerClonePool **ppsLink = &psClonePoolList;
+        while( *ppsLink != psPool )
+            ppsLink = &((*ppsLink)->psNext);
+        *ppsLink = psPool->psNext;
+    }
+
+    for( int i = 0; i < psPool->nFreeClones; i++ )
+        GDALDestroyTransformer( psPool->papFreeClones[i] );
+    CPLFree( psPool->papFreeClones );
+
+    if( psPool->hMutex != NULL )
+        CPLDestroyMutex( psPool->hMutex );
+
+    CPLFree( psPool );
+}
+
+/************************************************************************/
+/*                    GDALGetTransformerClonePool()                     */
+/************************************************************************/
+
+/**
+ * Find a pool of clones of a transformer.  Thread-safe.
+ *
+ * @param pTransformArg the transformer.
+ * @return a pool created with GDALCreateTransformerClonePool() for this
+ * transformer, or NULL if there is none.
+ */
+
+GDALTransformerClonePool *GDALGetTransformerClonePool( void *pTransformArg )
+
+{
+    CPLMutexHolderD( &hClonePoolListMutex );
+
+    GDALTransformerClonePool *psPool = psClonePoolList;
+    while( psPool != NULL && psPool->pTransformArg != pTransformArg )
+        psPool = psPool->psNext;
+
+    return psPool;
+}
+
+/************************************************************************/
+/*                    GDALTransformerClonePoolAcquire()                 */
+/************************************************************************/
+
+/**
+ * Get a clone of the transformer, either a previously released one or a
+ * new one.  Thread-safe.
+ *
+ * @return a clone to give back with GDALTransformerClonePoolRelease(), or
+ * NULL if the transformer cannot be cloned.
+ */
+
+void *GDALTransformerClonePoolAcquire( GDALTransformerClonePool *psPool )
+
+{
+    {
+        CPLMutexHolderD( &(psPool->hMutex) );
+        if( psPool->nFreeClones > 0 )
+            return psPool->papFreeClones[--psPool->nFreeClones];
+    }
+
+    return GDALCloneTransformer( psPool->pTransformArg );
+}
+
+/************************************************************************/
+/*                    GDALTransformerClonePoolRelease()                 */
+/************************************************************************/
+
+/**
+ * Give back a clone obtained with GDALTransformerClonePoolAcquire(), so
+ * that it can be reused.  Thread-safe.
+ */
+
+void GDALTransformerClonePoolRelease( GDALTransformerClonePool *psPool,
+                                      void *pClonedTransformArg )
+
+{
+    if( pClonedTransformArg == NULL )
+        return;
+
+    CPLMutexHolderD( &(psPool->hMutex) );
+
+    if( psPool->nFreeClones == psPool->nMaxFreeClones )
+    {
+        psPool->nMaxFreeClones = psPool->nMaxFreeClones * 2 + 8;
+        psPool->papFreeClones = (void **)
+            CPLRealloc( psPool->papFreeClones,
+                        sizeof(void*) * psPool->nMaxFreeClones );
+    }
+    psPool->papFreeClones[psPool->nFreeClones++] = pClonedTransformArg;
+}
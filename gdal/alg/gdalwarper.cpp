@@ -842,6 +842,8 @@ GDALWarpDstAlphaMasker( void *pMaskFuncArg, int nBandCount, GDALDataType eType,
  * - NUM_THREADS: (GDAL >= 1.10) Can be set to a numeric value or ALL_CPUS to
  * set the number of threads to use to parallelize the computation part of the
  * warping. If not set, computation will be done in a single thread.
+ * With GDALWarpOperation::ChunkAndWarpMulti() (gdalwarp -multi), this is
+ * also the number of chunks processed at the same time.
  */
 
 /************************************************************************/
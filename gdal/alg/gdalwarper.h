@@ -323,6 +323,8 @@ public:
 /*      masks.  Actual resampling is done by the GDALWarpKernel.        */
 /************************************************************************/
 
+typedef struct _GDALWarpChunkJob GDALWarpChunkJob;
+
 class CPL_DLL GDALWarpOperation {
 private:
     GDALWarpOptions *psOptions;
@@ -338,8 +340,30 @@ private:
     CPLErr          CreateKernelMask( GDALWarpKernel *, int iBand, 
                                       const char *pszType );
 
+    CPLErr          WarpRegionInternal( int nDstXOff, int nDstYOff,
+                                        int nDstXSize, int nDstYSize,
+                                        int nSrcXOff, int nSrcYOff,
+                                        int nSrcXSize, int nSrcYSize,
+                                        double dfProgressBase,
+                                        double dfProgressScale,
+                                        GDALWarpChunkJob *psJob );
+    CPLErr          WarpRegionToBufferInternal( int nDstXOff, int nDstYOff,
+                                        int nDstXSize, int nDstYSize,
+                                        void *pDataBuf,
+                                        GDALDataType eBufDataType,
+                                        int nSrcXOff, int nSrcYOff,
+                                        int nSrcXSize, int nSrcYSize,
+                                        double dfProgressBase,
+                                        double dfProgressScale,
+                                        GDALWarpChunkJob *psJob );
+    static void     ChunkThreadMain( void *pThreadData );
+
+    /* Unused: the mutexes of ChunkAndWarpMulti() are local to each call. */
+    /* Kept so that the layout of this exported class does not change. */
     void            *hIOMutex;
-    void            *hWarpMutex;
+
+    /* GDALTransformerClonePool of psOptions->pTransformerArg */
+    void            *hTransformerClonePool;
 
     int             nChunkListCount;
     int             nChunkListMax;
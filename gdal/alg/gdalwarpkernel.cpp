@@ -31,11 +31,20 @@
  ****************************************************************************/
 
 #include "gdalwarper.h"
+#include "gdal_priv.h"
 #include "gdal_alg_priv.h"
 #include "cpl_string.h"
 #include "gdalwarpkernel_opencl.h"
 #include "cpl_atomic_ops.h"
 #include "cpl_multiproc.h"
+#include <limits>
+
+/* SSE2 is part of the x86_64 instruction set, so no runtime CPU check */
+/* is needed; GDAL_USE_SSE=NO can still be used to select the scalar code */
+#if defined(HAVE_SSE_AT_COMPILE_TIME) && (defined(__x86_64) || defined(_M_X64))
+#define USE_SSE2
+#include <emmintrin.h>
+#endif
 
 CPL_CVSID("$Id$");
 
@@ -70,9 +79,16 @@ static CPLErr GWKNearestNoMasksShort( GDALWarpKernel *poWK );
 static CPLErr GWKBilinearNoMasksShort( GDALWarpKernel *poWK );
 static CPLErr GWKCubicNoMasksShort( GDALWarpKernel *poWK );
 static CPLErr GWKCubicSplineNoMasksShort( GDALWarpKernel *poWK );
+static CPLErr GWKBilinearNoMasksUShort( GDALWarpKernel *poWK );
+static CPLErr GWKCubicNoMasksUShort( GDALWarpKernel *poWK );
 static CPLErr GWKNearestShort( GDALWarpKernel *poWK );
 static CPLErr GWKNearestNoMasksFloat( GDALWarpKernel *poWK );
+static CPLErr GWKBilinearNoMasksFloat( GDALWarpKernel *poWK );
+static CPLErr GWKCubicNoMasksFloat( GDALWarpKernel *poWK );
 static CPLErr GWKNearestFloat( GDALWarpKernel *poWK );
+static CPLErr GWKBilinearNoMasksDouble( GDALWarpKernel *poWK );
+static CPLErr GWKCubicNoMasksDouble( GDALWarpKernel *poWK );
+static CPLErr GWKBilinearOrCubic( GDALWarpKernel *poWK );
 static CPLErr GWKAverageOrMode( GDALWarpKernel * );
 
 /************************************************************************/
@@ -83,7 +99,6 @@ typedef struct _GWKJobStruct GWKJobStruct;
 
 struct _GWKJobStruct
 {
-    void           *hThread;
     GDALWarpKernel *poWK;
     int             iYMin;
     int             iYMax;
@@ -93,8 +108,28 @@ struct _GWKJobStruct
     void           *hCondMutex;
     int           (*pfnProgress)(GWKJobStruct* psJob);
     void           *pTransformerArg;
+    void          (*pfnFunc)(void *pUserData);
 } ;
 
+/************************************************************************/
+/*                           GWKThreadJob()                             */
+/*                                                                      */
+/*      Run a job of GWKRun() in a worker thread.  The transformer may  */
+/*      read datasets (DEM, geolocation arrays) and so evict blocks     */
+/*      from the block cache.  Dirty blocks must not be written from    */
+/*      there, as they may belong to the destination dataset that       */
+/*      other jobs are evicting blocks from at the same time.           */
+/************************************************************************/
+
+static void GWKThreadJob( void* pData )
+{
+    GWKJobStruct* psJob = (GWKJobStruct*) pData;
+
+    GDALRasterBlock::EnterDisableDirtyBlockFlush();
+    psJob->pfnFunc( pData );
+    GDALRasterBlock::LeaveDisableDirtyBlockFlush();
+}
+
 /************************************************************************/
 /*                        GWKProgressThread()                           */
 /************************************************************************/
@@ -149,15 +184,38 @@ static CPLErr GWKGenericMonoThread( GDALWarpKernel *poWK,
     sThreadJob.pbStop = &bStop;
     sThreadJob.hCond = NULL;
     sThreadJob.hCondMutex = NULL;
-    sThreadJob.hThread = NULL;
     sThreadJob.pfnProgress = GWKProgressMonoThread;
     sThreadJob.pTransformerArg = poWK->pTransformerArg;
+    sThreadJob.pfnFunc = pfnFunc;
 
     pfnFunc(&sThreadJob);
 
     return !bStop ? CE_None : CE_Failure;
 }
 
+/************************************************************************/
+/*                       GWKReleaseTransformers()                       */
+/*                                                                      */
+/*      Give back the per-thread transformers to the clone pool, or     */
+/*      destroy them if there is none.                                  */
+/************************************************************************/
+
+static void GWKReleaseTransformers( GDALTransformerClonePool* psClonePool,
+                                    GWKJobStruct* pasThreadJob,
+                                    int nThreads )
+{
+    for( int i = 0; i < nThreads; i++ )
+    {
+        if( pasThreadJob[i].pTransformerArg == NULL )
+            continue;
+        if( psClonePool != NULL )
+            GDALTransformerClonePoolRelease( psClonePool,
+                                             pasThreadJob[i].pTransformerArg );
+        else
+            GDALDestroyTransformer( pasThreadJob[i].pTransformerArg );
+    }
+}
+
 /************************************************************************/
 /*                                GWKRun()                              */
 /************************************************************************/
@@ -196,7 +254,11 @@ static CPLErr GWKRun( GDALWarpKernel *poWK,
     if (nThreads >= nDstYSize / 2)
         nThreads = nDstYSize / 2;
 
-    if (nThreads <= 1)
+    CPLWorkerThreadPool* poThreadPool = NULL;
+    if (nThreads > 1)
+        poThreadPool = CPLGetWorkerThreadPool(nThreads);
+
+    if (poThreadPool == NULL)
     {
         return GWKGenericMonoThread(poWK, pfnFunc);
     }
@@ -206,14 +268,22 @@ static CPLErr GWKRun( GDALWarpKernel *poWK,
             (GWKJobStruct*)CPLCalloc(sizeof(GWKJobStruct), nThreads);
 
 /* -------------------------------------------------------------------- */
-/*      Duplicate pTransformerArg per thread.                           */
+/*      Duplicate pTransformerArg per thread, reusing the clones of     */
+/*      the previous chunks when the caller keeps them in a pool.       */
 /* -------------------------------------------------------------------- */
         int i;
         int bTransformerCloningSuccess = TRUE;
+        GDALTransformerClonePool* psClonePool =
+            GDALGetTransformerClonePool( poWK->pTransformerArg );
 
         for(i=0;i<nThreads;i++)
         {
-            pasThreadJob[i].pTransformerArg = GDALCloneTransformer(poWK->pTransformerArg);
+            if( psClonePool != NULL )
+                pasThreadJob[i].pTransformerArg =
+                    GDALTransformerClonePoolAcquire(psClonePool);
+            else
+                pasThreadJob[i].pTransformerArg =
+                    GDALCloneTransformer(poWK->pTransformerArg);
             if( pasThreadJob[i].pTransformerArg == NULL )
             {
                 CPLDebug("WARP", "Cannot deserialize transformer");
@@ -224,11 +294,7 @@ static CPLErr GWKRun( GDALWarpKernel *poWK,
 
         if (!bTransformerCloningSuccess)
         {
-            for(i=0;i<nThreads;i++)
-            {
-                if( pasThreadJob[i].pTransformerArg )
-                    GDALDestroyTransformer(pasThreadJob[i].pTransformerArg);
-            }
+            GWKReleaseTransformers(psClonePool, pasThreadJob, nThreads);
             CPLFree(pasThreadJob);
 
             CPLDebug("WARP", "Cannot duplicate transformer function. "
@@ -239,11 +305,7 @@ static CPLErr GWKRun( GDALWarpKernel *poWK,
         void* hCond = CPLCreateCond();
         if (hCond == NULL)
         {
-            for(i=0;i<nThreads;i++)
-            {
-                if( pasThreadJob[i].pTransformerArg )
-                    GDALDestroyTransformer(pasThreadJob[i].pTransformerArg);
-            }
+            GWKReleaseTransformers(psClonePool, pasThreadJob, nThreads);
             CPLFree(pasThreadJob);
 
             CPLDebug("WARP", "Multithreading disabled. "
@@ -257,9 +319,10 @@ static CPLErr GWKRun( GDALWarpKernel *poWK,
 
         volatile int bStop = FALSE;
         volatile int nCounter = 0;
+        CPLJobGroup oJobGroup;
 
 /* -------------------------------------------------------------------- */
-/*      Lannch worker threads                                           */
+/*      Submit jobs to the worker threads.                              */
 /* -------------------------------------------------------------------- */
         for(i=0;i<nThreads;i++)
         {
@@ -271,16 +334,24 @@ static CPLErr GWKRun( GDALWarpKernel *poWK,
             pasThreadJob[i].hCond = hCond;
             pasThreadJob[i].hCondMutex = hCondMutex;
             pasThreadJob[i].pfnProgress = GWKProgressThread;
-            pasThreadJob[i].hThread = CPLCreateJoinableThread( pfnFunc,
-                                                  (void*) &pasThreadJob[i] );
+            pasThreadJob[i].pfnFunc = pfnFunc;
+            poThreadPool->SubmitJob( GWKThreadJob, (void*) &pasThreadJob[i],
+                                     &oJobGroup );
         }
 
 /* -------------------------------------------------------------------- */
-/*      Report progress.                                                */
+/*      Report progress.  If all the worker threads are busy (for       */
+/*      instance when we are ourselves running in one of them), run     */
+/*      the jobs nobody has started yet.                                */
 /* -------------------------------------------------------------------- */
         while(nCounter < nDstYSize)
         {
-            CPLCondWait(hCond, hCondMutex);
+            CPLReleaseMutex(hCondMutex);
+            int bRanJob = poThreadPool->RunPendingJob(&oJobGroup);
+            CPLAcquireMutex(hCondMutex, 1000.0);
+
+            if( !bRanJob && nCounter < nDstYSize )
+                CPLCondWait(hCond, hCondMutex);
 
             if( !poWK->pfnProgress( poWK->dfProgressBase + poWK->dfProgressScale *
                                     (nCounter / (double) nDstYSize),
@@ -292,18 +363,16 @@ static CPLErr GWKRun( GDALWarpKernel *poWK,
             }
         }
 
-        /* Release mutex before joining threads, otherwise they will dead-lock */
-        /* forever in GWKProgressThread() */
+        /* Release mutex before waiting for the jobs, otherwise they will */
+        /* dead-lock forever in GWKProgressThread() */
         CPLReleaseMutex(hCondMutex);
 
 /* -------------------------------------------------------------------- */
-/*      Wait for all threads to complete and finish.                    */
+/*      Wait for all jobs to complete and finish.                       */
 /* -------------------------------------------------------------------- */
-        for(i=0;i<nThreads;i++)
-        {
-            CPLJoinThread(pasThreadJob[i].hThread);
-            GDALDestroyTransformer(pasThreadJob[i].pTransformerArg);
-        }
+        poThreadPool->WaitCompletion(&oJobGroup);
+
+        GWKReleaseTransformers(psClonePool, pasThreadJob, nThreads);
 
         CPLFree(pasThreadJob);
         CPLDestroyCond(hCond);
@@ -923,6 +992,24 @@ CPLErr GDALWarpKernel::PerformWarp()
         && pafDstDensity == NULL )
         return GWKBilinearNoMasksShort( this );
 
+    if( eWorkingDataType == GDT_UInt16
+        && eResample == GRA_Bilinear
+        && papanBandSrcValid == NULL
+        && panUnifiedSrcValid == NULL
+        && pafUnifiedSrcDensity == NULL
+        && panDstValid == NULL
+        && pafDstDensity == NULL )
+        return GWKBilinearNoMasksUShort( this );
+
+    if( eWorkingDataType == GDT_UInt16
+        && eResample == GRA_Cubic
+        && papanBandSrcValid == NULL
+        && panUnifiedSrcValid == NULL
+        && pafUnifiedSrcDensity == NULL
+        && panDstValid == NULL
+        && pafDstDensity == NULL )
+        return GWKCubicNoMasksUShort( this );
+
     if( (eWorkingDataType == GDT_Int16 || eWorkingDataType == GDT_UInt16)
         && eResample == GRA_NearestNeighbour )
         return GWKNearestShort( this );
@@ -940,6 +1027,52 @@ CPLErr GDALWarpKernel::PerformWarp()
         && eResample == GRA_NearestNeighbour )
         return GWKNearestFloat( this );
 
+    if( eWorkingDataType == GDT_Float32
+        && eResample == GRA_Bilinear
+        && papanBandSrcValid == NULL
+        && panUnifiedSrcValid == NULL
+        && pafUnifiedSrcDensity == NULL
+        && panDstValid == NULL
+        && pafDstDensity == NULL )
+        return GWKBilinearNoMasksFloat( this );
+
+    if( eWorkingDataType == GDT_Float32
+        && eResample == GRA_Cubic
+        && papanBandSrcValid == NULL
+        && panUnifiedSrcValid == NULL
+        && pafUnifiedSrcDensity == NULL
+        && panDstValid == NULL
+        && pafDstDensity == NULL )
+        return GWKCubicNoMasksFloat( this );
+
+    if( eWorkingDataType == GDT_Float64
+        && eResample == GRA_Bilinear
+        && papanBandSrcValid == NULL
+        && panUnifiedSrcValid == NULL
+        && pafUnifiedSrcDensity == NULL
+        && panDstValid == NULL
+        && pafDstDensity == NULL )
+        return GWKBilinearNoMasksDouble( this );
+
+    if( eWorkingDataType == GDT_Float64
+        && eResample == GRA_Cubic
+        && papanBandSrcValid == NULL
+        && panUnifiedSrcValid == NULL
+        && pafUnifiedSrcDensity == NULL
+        && panDstValid == NULL
+        && pafDstDensity == NULL )
+        return GWKCubicNoMasksDouble( this );
+
+    if( eResample == GRA_Bilinear || eResample == GRA_Cubic )
+    {
+        CPLErr eResult = GWKBilinearOrCubic( this );
+
+        // CE_Warning tells us there is no specialized version for this
+        // working data type, so we fall through to the general case.
+        if( eResult != CE_Warning )
+            return eResult;
+    }
+
     if( eResample == GRA_Average )
         return GWKAverageOrMode( this );
 
@@ -1317,82 +1450,150 @@ static int GWKGetPixelValue( GDALWarpKernel *poWK, int iBand,
 }
 
 /************************************************************************/
-/*                          GWKGetPixelRow()                            */
+/*                      GWKGetPixelRowValidity()                        */
+/*                                                                      */
+/*      Initialize the density of a row of source pixels from the       */
+/*      validity masks.  Returns FALSE if none of them is valid.        */
 /************************************************************************/
 
-/* It is assumed that adfImag[] is set to 0 by caller code for non-complex */
-/* data-types. */
-
-static int GWKGetPixelRow( GDALWarpKernel *poWK, int iBand, 
-                           int iSrcOffset, int nHalfSrcLen,
-                           double* padfDensity,
-                           double adfReal[],
-                           double* padfImag )
+static int GWKGetPixelRowValidity( GDALWarpKernel *poWK, int iBand,
+                                   int iSrcOffset, int nSrcLen,
+                                   double* padfDensity )
 {
-    // We know that nSrcLen is even, so we can *always* unroll loops 2x
-    int     nSrcLen = nHalfSrcLen * 2;
     int     bHasValid = FALSE;
     int     i;
+
+    // Init the density
+    for ( i = 0; i < nSrcLen; i += 2 )
+    {
+        padfDensity[i] = 1.0;
+        padfDensity[i+1] = 1.0;
+    }
     
-    if( padfDensity != NULL )
+    if ( poWK->panUnifiedSrcValid != NULL )
     {
-        // Init the density
         for ( i = 0; i < nSrcLen; i += 2 )
         {
-            padfDensity[i] = 1.0;
-            padfDensity[i+1] = 1.0;
+            if(poWK->panUnifiedSrcValid[(iSrcOffset+i)>>5]
+            & (0x01 << ((iSrcOffset+i) & 0x1f)))
+                bHasValid = TRUE;
+            else
+                padfDensity[i] = 0.0;
+            
+            if(poWK->panUnifiedSrcValid[(iSrcOffset+i+1)>>5]
+            & (0x01 << ((iSrcOffset+i+1) & 0x1f)))
+                bHasValid = TRUE;
+            else
+                padfDensity[i+1] = 0.0;
         }
-        
-        if ( poWK->panUnifiedSrcValid != NULL )
-        {
-            for ( i = 0; i < nSrcLen; i += 2 )
-            {
-                if(poWK->panUnifiedSrcValid[(iSrcOffset+i)>>5]
-                & (0x01 << ((iSrcOffset+i) & 0x1f)))
-                    bHasValid = TRUE;
-                else
-                    padfDensity[i] = 0.0;
-                
-                if(poWK->panUnifiedSrcValid[(iSrcOffset+i+1)>>5]
-                & (0x01 << ((iSrcOffset+i+1) & 0x1f)))
-                    bHasValid = TRUE;
-                else
-                    padfDensity[i+1] = 0.0;
-            }
 
-            // Reset or fail as needed
-            if ( bHasValid )
-                bHasValid = FALSE;
+        // Reset or fail as needed
+        if ( bHasValid )
+            bHasValid = FALSE;
+        else
+            return FALSE;
+    }
+    
+    if ( poWK->papanBandSrcValid != NULL
+        && poWK->papanBandSrcValid[iBand] != NULL)
+    {
+        for ( i = 0; i < nSrcLen; i += 2 )
+        {
+            if(poWK->papanBandSrcValid[iBand][(iSrcOffset+i)>>5]
+            & (0x01 << ((iSrcOffset+i) & 0x1f)))
+                bHasValid = TRUE;
+            else
+                padfDensity[i] = 0.0;
+            
+            if(poWK->papanBandSrcValid[iBand][(iSrcOffset+i+1)>>5]
+            & (0x01 << ((iSrcOffset+i+1) & 0x1f)))
+                bHasValid = TRUE;
             else
-                return FALSE;
+                padfDensity[i+1] = 0.0;
         }
         
-        if ( poWK->papanBandSrcValid != NULL
-            && poWK->papanBandSrcValid[iBand] != NULL)
+        // Reset or fail as needed
+        if ( !bHasValid )
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                       GWKGetPixelRowDensity()                        */
+/*                                                                      */
+/*      Combine the density computed by GWKGetPixelRowValidity() with   */
+/*      the unified source density.  Returns FALSE if no pixel of the   */
+/*      row has a significant density.                                  */
+/************************************************************************/
+
+static int GWKGetPixelRowDensity( GDALWarpKernel *poWK,
+                                  int iSrcOffset, int nSrcLen,
+                                  double* padfDensity )
+{
+    int     bHasValid = FALSE;
+    int     i;
+
+    if( poWK->pafUnifiedSrcDensity == NULL )
+    {
+        for ( i = 0; i < nSrcLen; i += 2 )
         {
-            for ( i = 0; i < nSrcLen; i += 2 )
+            // Take into account earlier calcs
+            if(padfDensity[i] > 0.000000001)
             {
-                if(poWK->papanBandSrcValid[iBand][(iSrcOffset+i)>>5]
-                & (0x01 << ((iSrcOffset+i) & 0x1f)))
-                    bHasValid = TRUE;
-                else
-                    padfDensity[i] = 0.0;
-                
-                if(poWK->papanBandSrcValid[iBand][(iSrcOffset+i+1)>>5]
-                & (0x01 << ((iSrcOffset+i+1) & 0x1f)))
-                    bHasValid = TRUE;
-                else
-                    padfDensity[i+1] = 0.0;
+                padfDensity[i] = 1.0;
+                bHasValid = TRUE;
             }
             
-            // Reset or fail as needed
-            if ( bHasValid )
-                bHasValid = FALSE;
-            else
-                return FALSE;
+            if(padfDensity[i+1] > 0.000000001)
+            {
+                padfDensity[i+1] = 1.0;
+                bHasValid = TRUE;
+            }
+        }
+    }
+    else
+    {
+        for ( i = 0; i < nSrcLen; i += 2 )
+        {
+            if(padfDensity[i] > 0.000000001)
+                padfDensity[i] = poWK->pafUnifiedSrcDensity[iSrcOffset+i];
+            if(padfDensity[i] > 0.000000001)
+                bHasValid = TRUE;
+            
+            if(padfDensity[i+1] > 0.000000001)
+                padfDensity[i+1] = poWK->pafUnifiedSrcDensity[iSrcOffset+i+1];
+            if(padfDensity[i+1] > 0.000000001)
+                bHasValid = TRUE;
         }
     }
     
+    return bHasValid;
+}
+
+/************************************************************************/
+/*                          GWKGetPixelRow()                            */
+/************************************************************************/
+
+/* It is assumed that adfImag[] is set to 0 by caller code for non-complex */
+/* data-types. */
+
+static int GWKGetPixelRow( GDALWarpKernel *poWK, int iBand, 
+                           int iSrcOffset, int nHalfSrcLen,
+                           double* padfDensity,
+                           double adfReal[],
+                           double* padfImag )
+{
+    // We know that nSrcLen is even, so we can *always* unroll loops 2x
+    int     nSrcLen = nHalfSrcLen * 2;
+    int     i;
+    
+    if( padfDensity != NULL
+        && !GWKGetPixelRowValidity( poWK, iBand, iSrcOffset, nSrcLen,
+                                    padfDensity ) )
+        return FALSE;
+    
     // Fetch data
     switch( poWK->eWorkingDataType )
     {
@@ -1551,86 +1752,67 @@ static int GWKGetPixelRow( GDALWarpKernel *poWK, int iBand,
     if( padfDensity == NULL )
         return TRUE;
 
-    if( poWK->pafUnifiedSrcDensity == NULL )
-    {
-        for ( i = 0; i < nSrcLen; i += 2 )
-        {
-            // Take into account earlier calcs
-            if(padfDensity[i] > 0.000000001)
-            {
-                padfDensity[i] = 1.0;
-                bHasValid = TRUE;
-            }
-            
-            if(padfDensity[i+1] > 0.000000001)
-            {
-                padfDensity[i+1] = 1.0;
-                bHasValid = TRUE;
-            }
-        }
-    }
-    else
-    {
-        for ( i = 0; i < nSrcLen; i += 2 )
-        {
-            if(padfDensity[i] > 0.000000001)
-                padfDensity[i] = poWK->pafUnifiedSrcDensity[iSrcOffset+i];
-            if(padfDensity[i] > 0.000000001)
-                bHasValid = TRUE;
-            
-            if(padfDensity[i+1] > 0.000000001)
-                padfDensity[i+1] = poWK->pafUnifiedSrcDensity[iSrcOffset+i+1];
-            if(padfDensity[i+1] > 0.000000001)
-                bHasValid = TRUE;
-        }
-    }
-    
-    return bHasValid;
+    return GWKGetPixelRowDensity( poWK, iSrcOffset, nSrcLen, padfDensity );
 }
 
 /************************************************************************/
-/*                          GWKGetPixelByte()                           */
+/*                          GWKGetPixelRowT()                           */
+/*                                                                      */
+/*      Same as GWKGetPixelRow() for a working data type known at       */
+/*      compile time.  T == void dispatches on eWorkingDataType at      */
+/*      runtime, which is what the complex data types need.             */
 /************************************************************************/
 
-static int GWKGetPixelByte( GDALWarpKernel *poWK, int iBand, 
-                            int iSrcOffset, double *pdfDensity, 
-                            GByte *pbValue )
-
+template<class T>
+static int GWKGetPixelRowT( GDALWarpKernel *poWK, int iBand, 
+                            int iSrcOffset, int nHalfSrcLen,
+                            double* padfDensity,
+                            double adfReal[],
+                            double* /* padfImag */ )
 {
-    GByte *pabySrc = poWK->papabySrcImage[iBand];
+    int     nSrcLen = nHalfSrcLen * 2;
+    int     i;
+    
+    if( padfDensity != NULL
+        && !GWKGetPixelRowValidity( poWK, iBand, iSrcOffset, nSrcLen,
+                                    padfDensity ) )
+        return FALSE;
 
-    if ( ( poWK->panUnifiedSrcValid != NULL
-           && !((poWK->panUnifiedSrcValid[iSrcOffset>>5]
-                 & (0x01 << (iSrcOffset & 0x1f))) ) )
-         || ( poWK->papanBandSrcValid != NULL
-              && poWK->papanBandSrcValid[iBand] != NULL
-              && !((poWK->papanBandSrcValid[iBand][iSrcOffset>>5]
-                    & (0x01 << (iSrcOffset & 0x1f)))) ) )
+    const T* pSrc = ((const T*) poWK->papabySrcImage[iBand]) + iSrcOffset;
+    for ( i = 0; i < nSrcLen; i += 2 )
     {
-        *pdfDensity = 0.0;
-        return FALSE;
+        adfReal[i] = pSrc[i];
+        adfReal[i+1] = pSrc[i+1];
     }
 
-    *pbValue = pabySrc[iSrcOffset];
+    if( padfDensity == NULL )
+        return TRUE;
 
-    if ( poWK->pafUnifiedSrcDensity == NULL )
-        *pdfDensity = 1.0;
-    else
-        *pdfDensity = poWK->pafUnifiedSrcDensity[iSrcOffset];
+    return GWKGetPixelRowDensity( poWK, iSrcOffset, nSrcLen, padfDensity );
+}
 
-    return *pdfDensity != 0.0;
+template<>
+int GWKGetPixelRowT<void>( GDALWarpKernel *poWK, int iBand, 
+                           int iSrcOffset, int nHalfSrcLen,
+                           double* padfDensity,
+                           double adfReal[],
+                           double* padfImag )
+{
+    return GWKGetPixelRow( poWK, iBand, iSrcOffset, nHalfSrcLen,
+                           padfDensity, adfReal, padfImag );
 }
 
 /************************************************************************/
-/*                          GWKGetPixelShort()                          */
+/*                            GWKGetPixelT()                            */
 /************************************************************************/
 
-static int GWKGetPixelShort( GDALWarpKernel *poWK, int iBand, 
-                             int iSrcOffset, double *pdfDensity, 
-                             GInt16 *piValue )
+template<class T>
+static int GWKGetPixelT( GDALWarpKernel *poWK, int iBand, 
+                         int iSrcOffset, double *pdfDensity, 
+                         T *pValue )
 
 {
-    GInt16 *pabySrc = (GInt16 *)poWK->papabySrcImage[iBand];
+    T *pSrc = (T *)poWK->papabySrcImage[iBand];
 
     if ( ( poWK->panUnifiedSrcValid != NULL
            && !((poWK->panUnifiedSrcValid[iSrcOffset>>5]
@@ -1644,7 +1826,7 @@ static int GWKGetPixelShort( GDALWarpKernel *poWK, int iBand,
         return FALSE;
     }
 
-    *piValue = pabySrc[iSrcOffset];
+    *pValue = pSrc[iSrcOffset];
 
     if ( poWK->pafUnifiedSrcDensity == NULL )
         *pdfDensity = 1.0;
@@ -1655,47 +1837,15 @@ static int GWKGetPixelShort( GDALWarpKernel *poWK, int iBand,
 }
 
 /************************************************************************/
-/*                          GWKGetPixelFloat()                          */
+/*                        GWKBilinearResampleT()                        */
+/*     Set of bilinear interpolators                                    */
 /************************************************************************/
 
-static int GWKGetPixelFloat( GDALWarpKernel *poWK, int iBand, 
-                             int iSrcOffset, double *pdfDensity, 
-                             float *pfValue )
-
-{
-    float *pabySrc = (float *)poWK->papabySrcImage[iBand];
-
-    if ( ( poWK->panUnifiedSrcValid != NULL
-           && !((poWK->panUnifiedSrcValid[iSrcOffset>>5]
-                 & (0x01 << (iSrcOffset & 0x1f))) ) )
-         || ( poWK->papanBandSrcValid != NULL
-              && poWK->papanBandSrcValid[iBand] != NULL
-              && !((poWK->papanBandSrcValid[iBand][iSrcOffset>>5]
-                    & (0x01 << (iSrcOffset & 0x1f)))) ) )
-    {
-        *pdfDensity = 0.0;
-        return FALSE;
-    }
-
-    *pfValue = pabySrc[iSrcOffset];
-
-    if ( poWK->pafUnifiedSrcDensity == NULL )
-        *pdfDensity = 1.0;
-    else
-        *pdfDensity = poWK->pafUnifiedSrcDensity[iSrcOffset];
-
-    return *pdfDensity != 0.0;
-}
-
-/************************************************************************/
-/*                        GWKBilinearResample()                         */
-/*     Set of bilinear interpolators                                    */
-/************************************************************************/
-
-static int GWKBilinearResample( GDALWarpKernel *poWK, int iBand, 
-                                double dfSrcX, double dfSrcY,
-                                double *pdfDensity, 
-                                double *pdfReal, double *pdfImag )
+template<class T>
+static int GWKBilinearResampleT( GDALWarpKernel *poWK, int iBand, 
+                                 double dfSrcX, double dfSrcY,
+                                 double *pdfDensity, 
+                                 double *pdfReal, double *pdfImag )
 
 {
     // Save as local variables to avoid following pointers
@@ -1736,7 +1886,7 @@ static int GWKBilinearResample( GDALWarpKernel *poWK, int iBand,
     // Get pixel row
     if ( iSrcY >= 0 && iSrcY < nSrcYSize
          && iSrcOffset >= 0 && iSrcOffset < nSrcXSize * nSrcYSize
-         && GWKGetPixelRow( poWK, iBand, iSrcOffset, 1,
+         && GWKGetPixelRowT<T>( poWK, iBand, iSrcOffset, 1,
                             adfDensity, adfReal, adfImag ) )
     {
         double dfMult1 = dfRatioX * dfRatioY;
@@ -1777,7 +1927,7 @@ static int GWKBilinearResample( GDALWarpKernel *poWK, int iBand,
     if ( iSrcY+1 >= 0 && iSrcY+1 < nSrcYSize
          && iSrcOffset+nSrcXSize >= 0
          && iSrcOffset+nSrcXSize < nSrcXSize * nSrcYSize
-         && GWKGetPixelRow( poWK, iBand, iSrcOffset+nSrcXSize, 1,
+         && GWKGetPixelRowT<T>( poWK, iBand, iSrcOffset+nSrcXSize, 1,
                            adfDensity, adfReal, adfImag ) )
     {
         double dfMult1 = dfRatioX * (1.0-dfRatioY);
@@ -1840,102 +1990,135 @@ static int GWKBilinearResample( GDALWarpKernel *poWK, int iBand,
     }
 }
 
-static int GWKBilinearResampleNoMasksByte( GDALWarpKernel *poWK, int iBand, 
-                                           double dfSrcX, double dfSrcY,
-                                           GByte *pbValue )
+/************************************************************************/
+/*                          GWKRoundValueT()                            */
+/*                                                                      */
+/*      Convert an interpolated value to the working data type,         */
+/*      clamping it to the range of integer types.                      */
+/************************************************************************/
+
+template<class T> static T GWKRoundValueT( double dfValue );
 
+template<> GByte GWKRoundValueT<GByte>( double dfValue )
 {
-    double  dfAccumulator = 0.0;
-    double  dfAccumulatorDivisor = 0.0;
+    if( dfValue < 0.0 )
+        return 0;
+    else if( dfValue > 255.0 )
+        return 255;
+    else
+        return (GByte)(0.5 + dfValue);
+}
 
-    int     iSrcX = (int) floor(dfSrcX - 0.5);
-    int     iSrcY = (int) floor(dfSrcY - 0.5);
-    int     iSrcOffset = iSrcX + iSrcY * poWK->nSrcXSize;
-    double  dfRatioX = 1.5 - (dfSrcX - iSrcX);
-    double  dfRatioY = 1.5 - (dfSrcY - iSrcY);
+template<> GInt16 GWKRoundValueT<GInt16>( double dfValue )
+{
+    if( dfValue < -32768.0 )
+        return -32768;
+    else if( dfValue > 32767.0 )
+        return 32767;
+    else
+        return (GInt16)floor(0.5 + dfValue);
+}
 
-    // Upper Left Pixel
-    if( iSrcX >= 0 && iSrcX < poWK->nSrcXSize
-        && iSrcY >= 0 && iSrcY < poWK->nSrcYSize )
-    {
-        double dfMult = dfRatioX * dfRatioY;
+template<> GUInt16 GWKRoundValueT<GUInt16>( double dfValue )
+{
+    if( dfValue < 0.0 )
+        return 0;
+    else if( dfValue > 65535.0 )
+        return 65535;
+    else
+        return (GUInt16)(0.5 + dfValue);
+}
 
-        dfAccumulatorDivisor += dfMult;
+template<> float GWKRoundValueT<float>( double dfValue )
+{
+    return (float)dfValue;
+}
 
-        dfAccumulator +=
-            (double)poWK->papabySrcImage[iBand][iSrcOffset] * dfMult;
-    }
-        
-    // Upper Right Pixel
-    if( iSrcX+1 >= 0 && iSrcX+1 < poWK->nSrcXSize
-        && iSrcY >= 0 && iSrcY < poWK->nSrcYSize )
-    {
-        double dfMult = (1.0-dfRatioX) * dfRatioY;
+template<> double GWKRoundValueT<double>( double dfValue )
+{
+    return dfValue;
+}
 
-        dfAccumulatorDivisor += dfMult;
+/************************************************************************/
+/*                          GWKSetPixelValueT()                         */
+/*                                                                      */
+/*      Same as GWKSetPixelValue() for a non complex working data       */
+/*      type known at compile time.                                     */
+/************************************************************************/
 
-        dfAccumulator +=
-            (double)poWK->papabySrcImage[iBand][iSrcOffset+1] * dfMult;
-    }
-        
-    // Lower Right Pixel
-    if( iSrcX+1 >= 0 && iSrcX+1 < poWK->nSrcXSize
-        && iSrcY+1 >= 0 && iSrcY+1 < poWK->nSrcYSize )
+template<class T>
+static void GWKAvoidNoDataT( GDALWarpKernel *poWK, int iBand, T *pValue )
+{
+    // Avoid using the destination nodata value for integer datatypes
+    // if by chance it is equal to the computed pixel value.
+    if( poWK->padfDstNoDataReal != NULL
+        && poWK->padfDstNoDataReal[iBand] == (double)*pValue )
     {
-        double dfMult = (1.0-dfRatioX) * (1.0-dfRatioY);
+        if( *pValue == std::numeric_limits<T>::min() )
+            *pValue = std::numeric_limits<T>::min() + 1;
+        else
+            (*pValue) --;
+    }
+}
 
-        dfAccumulatorDivisor += dfMult;
+template<> void GWKAvoidNoDataT<float>( GDALWarpKernel *, int, float * ) {}
+template<> void GWKAvoidNoDataT<double>( GDALWarpKernel *, int, double * ) {}
 
-        dfAccumulator +=
-            (double)poWK->papabySrcImage[iBand][iSrcOffset+1+poWK->nSrcXSize]
-            * dfMult;
-    }
-        
-    // Lower Left Pixel
-    if( iSrcX >= 0 && iSrcX < poWK->nSrcXSize
-        && iSrcY+1 >= 0 && iSrcY+1 < poWK->nSrcYSize )
+template<class T>
+static int GWKSetPixelValueT( GDALWarpKernel *poWK, int iBand, 
+                              int iDstOffset, double dfDensity, 
+                              double dfReal )
+
+{
+    T *pDst = (T *) poWK->papabyDstImage[iBand];
+
+/* -------------------------------------------------------------------- */
+/*      If the source density is less than 100% we need to fetch the    */
+/*      existing destination value, and mix it with the source to       */
+/*      get the new "to apply" value.  Also compute composite           */
+/*      density.                                                        */
+/* -------------------------------------------------------------------- */
+    if( dfDensity < 0.9999 )
     {
-        double dfMult = dfRatioX * (1.0-dfRatioY);
+        double dfDstReal, dfDstDensity = 1.0;
 
-        dfAccumulatorDivisor += dfMult;
+        if( dfDensity < 0.0001 )
+            return TRUE;
 
-        dfAccumulator +=
-            (double)poWK->papabySrcImage[iBand][iSrcOffset+poWK->nSrcXSize]
-            * dfMult;
+        if( poWK->pafDstDensity != NULL )
+            dfDstDensity = poWK->pafDstDensity[iDstOffset];
+        else if( poWK->panDstValid != NULL 
+                 && !((poWK->panDstValid[iDstOffset>>5]
+                       & (0x01 << (iDstOffset & 0x1f))) ) )
+            dfDstDensity = 0.0;
+
+        dfDstReal = pDst[iDstOffset];
+
+        // the destination density is really only relative to the portion
+        // not occluded by the overlay.
+        double dfDstInfluence = (1.0 - dfDensity) * dfDstDensity;
+
+        dfReal = (dfReal * dfDensity + dfDstReal * dfDstInfluence) 
+            / (dfDensity + dfDstInfluence);
     }
 
 /* -------------------------------------------------------------------- */
-/*      Return result.                                                  */
+/*      Actually apply the destination value.                           */
 /* -------------------------------------------------------------------- */
-    double      dfValue;
-
-    if( dfAccumulatorDivisor < 0.00001 )
-    {
-        *pbValue = 0;
-        return FALSE;
-    }
-    else if( dfAccumulatorDivisor == 1.0 )
-    {
-        dfValue = dfAccumulator;
-    }
-    else
-    {
-        dfValue = dfAccumulator / dfAccumulatorDivisor;
-    }
+    pDst[iDstOffset] = GWKRoundValueT<T>( dfReal );
+    GWKAvoidNoDataT<T>( poWK, iBand, pDst + iDstOffset );
 
-    if ( dfValue < 0.0 )
-        *pbValue = 0;
-    else if ( dfValue > 255.0 )
-        *pbValue = 255;
-    else
-        *pbValue = (GByte)(0.5 + dfValue);
-    
     return TRUE;
 }
 
-static int GWKBilinearResampleNoMasksShort( GDALWarpKernel *poWK, int iBand, 
-                                            double dfSrcX, double dfSrcY,
-                                            GInt16 *piValue )
+/************************************************************************/
+/*                    GWKBilinearResampleNoMasksT()                     */
+/************************************************************************/
+
+template<class T>
+static int GWKBilinearResampleNoMasksT( GDALWarpKernel *poWK, int iBand,
+                                        double dfSrcX, double dfSrcY,
+                                        T *pValue )
 
 {
     double  dfAccumulator = 0.0;
@@ -1946,6 +2129,7 @@ static int GWKBilinearResampleNoMasksShort( GDALWarpKernel *poWK, int iBand,
     int     iSrcOffset = iSrcX + iSrcY * poWK->nSrcXSize;
     double  dfRatioX = 1.5 - (dfSrcX - iSrcX);
     double  dfRatioY = 1.5 - (dfSrcY - iSrcY);
+    const T *pSrc = (const T *) poWK->papabySrcImage[iBand];
 
     // Upper Left Pixel
     if( iSrcX >= 0 && iSrcX < poWK->nSrcXSize
@@ -1955,9 +2139,7 @@ static int GWKBilinearResampleNoMasksShort( GDALWarpKernel *poWK, int iBand,
 
         dfAccumulatorDivisor += dfMult;
 
-        dfAccumulator +=
-            (double)((GInt16 *)poWK->papabySrcImage[iBand])[iSrcOffset]
-            * dfMult;
+        dfAccumulator += (double)pSrc[iSrcOffset] * dfMult;
     }
         
     // Upper Right Pixel
@@ -1968,8 +2150,7 @@ static int GWKBilinearResampleNoMasksShort( GDALWarpKernel *poWK, int iBand,
 
         dfAccumulatorDivisor += dfMult;
 
-        dfAccumulator +=
-            (double)((GInt16 *)poWK->papabySrcImage[iBand])[iSrcOffset+1] * dfMult;
+        dfAccumulator += (double)pSrc[iSrcOffset+1] * dfMult;
     }
         
     // Lower Right Pixel
@@ -1981,8 +2162,7 @@ static int GWKBilinearResampleNoMasksShort( GDALWarpKernel *poWK, int iBand,
         dfAccumulatorDivisor += dfMult;
 
         dfAccumulator +=
-            (double)((GInt16 *)poWK->papabySrcImage[iBand])[iSrcOffset+1+poWK->nSrcXSize]
-            * dfMult;
+            (double)pSrc[iSrcOffset+1+poWK->nSrcXSize] * dfMult;
     }
         
     // Lower Left Pixel
@@ -1994,32 +2174,30 @@ static int GWKBilinearResampleNoMasksShort( GDALWarpKernel *poWK, int iBand,
         dfAccumulatorDivisor += dfMult;
 
         dfAccumulator +=
-            (double)((GInt16 *)poWK->papabySrcImage[iBand])[iSrcOffset+poWK->nSrcXSize]
-            * dfMult;
+            (double)pSrc[iSrcOffset+poWK->nSrcXSize] * dfMult;
     }
 
 /* -------------------------------------------------------------------- */
 /*      Return result.                                                  */
 /* -------------------------------------------------------------------- */
-    if( dfAccumulatorDivisor == 1.0 )
+    if( dfAccumulatorDivisor < 0.00001 )
     {
-        *piValue = (GInt16)(0.5 + dfAccumulator);
-        return TRUE;
+        *pValue = 0;
+        return FALSE;
     }
-    else if( dfAccumulatorDivisor < 0.00001 )
+    else if( dfAccumulatorDivisor == 1.0 )
     {
-        *piValue = 0;
-        return FALSE;
+        *pValue = GWKRoundValueT<T>( dfAccumulator );
     }
     else
     {
-        *piValue = (GInt16)(0.5 + dfAccumulator / dfAccumulatorDivisor);
-        return TRUE;
+        *pValue = GWKRoundValueT<T>( dfAccumulator / dfAccumulatorDivisor );
     }
-}
 
+    return TRUE;
+}
 /************************************************************************/
-/*                        GWKCubicResample()                            */
+/*                        GWKCubicResampleT()                           */
 /*     Set of bicubic interpolators using cubic convolution.            */
 /************************************************************************/
 #define CubicConvolution(distance1,distance2,distance3,f0,f1,f2,f3) \
@@ -2028,10 +2206,11 @@ static int GWKBilinearResampleNoMasksShort( GDALWarpKernel *poWK, int iBand,
       + distance2*0.5*(2.0*f0 - 5.0*f1 + 4.0*f2 - f3)               \
       + distance3*0.5*(3.0*(f1 - f2) + f3 - f0))
 
-static int GWKCubicResample( GDALWarpKernel *poWK, int iBand,
-                             double dfSrcX, double dfSrcY,
-                             double *pdfDensity,
-                             double *pdfReal, double *pdfImag )
+template<class T>
+static int GWKCubicResampleT( GDALWarpKernel *poWK, int iBand,
+                              double dfSrcX, double dfSrcY,
+                              double *pdfDensity,
+                              double *pdfReal, double *pdfImag )
 
 {
     int     iSrcX = (int) (dfSrcX - 0.5);
@@ -2050,20 +2229,21 @@ static int GWKCubicResample( GDALWarpKernel *poWK, int iBand,
     // Get the bilinear interpolation at the image borders
     if ( iSrcX - 1 < 0 || iSrcX + 2 >= poWK->nSrcXSize
          || iSrcY - 1 < 0 || iSrcY + 2 >= poWK->nSrcYSize )
-        return GWKBilinearResample( poWK, iBand, dfSrcX, dfSrcY,
-                                    pdfDensity, pdfReal, pdfImag );
+        return GWKBilinearResampleT<T>( poWK, iBand, dfSrcX, dfSrcY,
+                                        pdfDensity, pdfReal, pdfImag );
 
     for ( i = -1; i < 3; i++ )
     {
-        if ( !GWKGetPixelRow(poWK, iBand, iSrcOffset + i * poWK->nSrcXSize - 1,
-                             2, adfDensity, adfReal, adfImag)
+        if ( !GWKGetPixelRowT<T>(poWK, iBand,
+                                 iSrcOffset + i * poWK->nSrcXSize - 1,
+                                 2, adfDensity, adfReal, adfImag)
              || adfDensity[0] < 0.000000001
              || adfDensity[1] < 0.000000001
              || adfDensity[2] < 0.000000001
              || adfDensity[3] < 0.000000001 )
         {
-            return GWKBilinearResample( poWK, iBand, dfSrcX, dfSrcY,
-                                       pdfDensity, pdfReal, pdfImag );
+            return GWKBilinearResampleT<T>( poWK, iBand, dfSrcX, dfSrcY,
+                                            pdfDensity, pdfReal, pdfImag );
         }
 
         adfValueDens[i + 1] = CubicConvolution(dfDeltaX, dfDeltaX2, dfDeltaX3,
@@ -2094,9 +2274,10 @@ static int GWKCubicResample( GDALWarpKernel *poWK, int iBand,
     return TRUE;
 }
 
-static int GWKCubicResampleNoMasksByte( GDALWarpKernel *poWK, int iBand,
-                                        double dfSrcX, double dfSrcY,
-                                        GByte *pbValue )
+template<class T>
+static int GWKCubicResampleNoMasksT( GDALWarpKernel *poWK, int iBand,
+                                     double dfSrcX, double dfSrcY,
+                                     T *pValue )
 
 {
     int     iSrcX = (int) (dfSrcX - 0.5);
@@ -2110,86 +2291,32 @@ static int GWKCubicResampleNoMasksByte( GDALWarpKernel *poWK, int iBand,
     double  dfDeltaY3 = dfDeltaY2 * dfDeltaY;
     double  adfValue[4];
     int     i;
+    const T *pSrc = (const T *) poWK->papabySrcImage[iBand];
 
     // Get the bilinear interpolation at the image borders
     if ( iSrcX - 1 < 0 || iSrcX + 2 >= poWK->nSrcXSize
          || iSrcY - 1 < 0 || iSrcY + 2 >= poWK->nSrcYSize )
-        return GWKBilinearResampleNoMasksByte( poWK, iBand, dfSrcX, dfSrcY,
-                                               pbValue);
+        return GWKBilinearResampleNoMasksT<T>( poWK, iBand, dfSrcX, dfSrcY,
+                                               pValue );
 
     for ( i = -1; i < 3; i++ )
     {
         int     iOffset = iSrcOffset + i * poWK->nSrcXSize;
 
         adfValue[i + 1] = CubicConvolution(dfDeltaX, dfDeltaX2, dfDeltaX3,
-                            (double)poWK->papabySrcImage[iBand][iOffset - 1],
-                            (double)poWK->papabySrcImage[iBand][iOffset],
-                            (double)poWK->papabySrcImage[iBand][iOffset + 1],
-                            (double)poWK->papabySrcImage[iBand][iOffset + 2]);
+                                           (double)pSrc[iOffset - 1],
+                                           (double)pSrc[iOffset],
+                                           (double)pSrc[iOffset + 1],
+                                           (double)pSrc[iOffset + 2]);
     }
 
     double dfValue = CubicConvolution(dfDeltaY, dfDeltaY2, dfDeltaY3,
                         adfValue[0], adfValue[1], adfValue[2], adfValue[3]);
 
-    if ( dfValue < 0.0 )
-        *pbValue = 0;
-    else if ( dfValue > 255.0 )
-        *pbValue = 255;
-    else
-        *pbValue = (GByte)(0.5 + dfValue);
-    
-    return TRUE;
-}
-
-static int GWKCubicResampleNoMasksShort( GDALWarpKernel *poWK, int iBand,
-                                         double dfSrcX, double dfSrcY,
-                                         GInt16 *piValue )
-
-{
-    int     iSrcX = (int) (dfSrcX - 0.5);
-    int     iSrcY = (int) (dfSrcY - 0.5);
-    int     iSrcOffset = iSrcX + iSrcY * poWK->nSrcXSize;
-    double  dfDeltaX = dfSrcX - 0.5 - iSrcX;
-    double  dfDeltaY = dfSrcY - 0.5 - iSrcY;
-    double  dfDeltaX2 = dfDeltaX * dfDeltaX;
-    double  dfDeltaY2 = dfDeltaY * dfDeltaY;
-    double  dfDeltaX3 = dfDeltaX2 * dfDeltaX;
-    double  dfDeltaY3 = dfDeltaY2 * dfDeltaY;
-    double  adfValue[4];
-    int     i;
-
-    // Get the bilinear interpolation at the image borders
-    if ( iSrcX - 1 < 0 || iSrcX + 2 >= poWK->nSrcXSize
-         || iSrcY - 1 < 0 || iSrcY + 2 >= poWK->nSrcYSize )
-        return GWKBilinearResampleNoMasksShort( poWK, iBand, dfSrcX, dfSrcY,
-                                                piValue);
+    *pValue = GWKRoundValueT<T>( dfValue );
 
-    for ( i = -1; i < 3; i++ )
-    {
-        int     iOffset = iSrcOffset + i * poWK->nSrcXSize;
-
-        adfValue[i + 1] =CubicConvolution(dfDeltaX, dfDeltaX2, dfDeltaX3,
-                (double)((GInt16 *)poWK->papabySrcImage[iBand])[iOffset - 1],
-                (double)((GInt16 *)poWK->papabySrcImage[iBand])[iOffset],
-                (double)((GInt16 *)poWK->papabySrcImage[iBand])[iOffset + 1],
-                (double)((GInt16 *)poWK->papabySrcImage[iBand])[iOffset + 2]);
-    }
-
-    double dfValue = CubicConvolution(
-        dfDeltaY, dfDeltaY2, dfDeltaY3,
-        adfValue[0], adfValue[1], adfValue[2], adfValue[3]);
-    
-    if ( dfValue < -32768.0 )
-        *piValue = -32768;
-    else if ( dfValue > 32767.0 )
-        *piValue = 32767;
-    else
-        *piValue = (GInt16)floor(0.5 + dfValue);
-    
     return TRUE;
 }
-
-
 /************************************************************************/
 /*                          GWKLanczosSinc()                            */
 /************************************************************************/
@@ -2868,7 +2995,7 @@ static int GWKCubicSplineResampleNoMasksByte( GDALWarpKernel *poWK, int iBand,
     // Politely refusing to process invalid coordinates or obscenely small image
     if ( iSrcX >= nSrcXSize || iSrcY >= nSrcYSize
          || nXRadius > nSrcXSize || nYRadius > nSrcYSize )
-        return GWKBilinearResampleNoMasksByte( poWK, iBand, dfSrcX, dfSrcY, pbValue);
+        return GWKBilinearResampleNoMasksT<GByte>( poWK, iBand, dfSrcX, dfSrcY, pbValue);
 
     // Loop over all rows in the kernel
     int     j, jC;
@@ -2957,7 +3084,7 @@ static int GWKCubicSplineResampleNoMasksShort( GDALWarpKernel *poWK, int iBand,
     // Politely refusing to process invalid coordinates or obscenely small image
     if ( iSrcX >= nSrcXSize || iSrcY >= nSrcYSize
          || nXRadius > nSrcXSize || nYRadius > nSrcYSize )
-        return GWKBilinearResampleNoMasksShort( poWK, iBand, dfSrcX, dfSrcY, piValue);
+        return GWKBilinearResampleNoMasksT<GInt16>( poWK, iBand, dfSrcX, dfSrcY, piValue);
 
     // Loop over all pixels in the kernel
     int     j, jC;
@@ -3481,19 +3608,19 @@ static void GWKGeneralCaseThread( void* pData)
                 }
                 else if ( poWK->eResample == GRA_Bilinear )
                 {
-                    GWKBilinearResample( poWK, iBand, 
-                                         padfX[iDstX]-poWK->nSrcXOff,
-                                         padfY[iDstX]-poWK->nSrcYOff,
-                                         &dfBandDensity, 
-                                         &dfValueReal, &dfValueImag );
+                    GWKBilinearResampleT<void>( poWK, iBand, 
+                                                padfX[iDstX]-poWK->nSrcXOff,
+                                                padfY[iDstX]-poWK->nSrcYOff,
+                                                &dfBandDensity, 
+                                                &dfValueReal, &dfValueImag );
                 }
                 else if ( poWK->eResample == GRA_Cubic )
                 {
-                    GWKCubicResample( poWK, iBand, 
-                                      padfX[iDstX]-poWK->nSrcXOff,
-                                      padfY[iDstX]-poWK->nSrcYOff,
-                                      &dfBandDensity, 
-                                      &dfValueReal, &dfValueImag );
+                    GWKCubicResampleT<void>( poWK, iBand, 
+                                             padfX[iDstX]-poWK->nSrcXOff,
+                                             padfY[iDstX]-poWK->nSrcYOff,
+                                             &dfBandDensity, 
+                                             &dfValueReal, &dfValueImag );
                 }
                 else if ( poWK->eResample == GRA_CubicSpline
                           || poWK->eResample == GRA_Lanczos )
@@ -3557,21 +3684,18 @@ static void GWKGeneralCaseThread( void* pData)
 }
 
 /************************************************************************/
-/*                       GWKNearestNoMasksByte()                        */
+/*                         GWKResampleThreadT()                         */
 /*                                                                      */
-/*      Case for 8bit input data with nearest neighbour resampling      */
-/*      without concerning about masking. Should be as fast as          */
-/*      possible for this particular transformation type.               */
+/*      Same as GWKGeneralCaseThread() for bilinear and cubic           */
+/*      convolution resampling, specialized at compile time for the     */
+/*      working data type so that source fetching and destination      */
+/*      writing do not go through a switch for each pixel.  Validity    */
+/*      and density masks are handled.                                  */
 /************************************************************************/
 
-static void GWKNearestNoMasksByteThread(void* pData);
-
-static CPLErr GWKNearestNoMasksByte( GDALWarpKernel *poWK )
-{
-    return GWKRun( poWK, "GWKNearestNoMasksByte", GWKNearestNoMasksByteThread );
-}
+template<class T, GDALResampleAlg eResample>
+static void GWKResampleThreadT( void* pData )
 
-static void GWKNearestNoMasksByteThread(void* pData)
 {
     GWKJobStruct* psJob = (GWKJobStruct*) pData;
     GDALWarpKernel *poWK = psJob->poWK;
@@ -3623,29 +3747,106 @@ static void GWKNearestNoMasksByteThread(void* pData)
 /* ==================================================================== */
         for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
         {
+            int iDstOffset;
+
             COMPUTE_iSrcOffset(pabSuccess, iDstX, padfX, padfY, poWK, nSrcXSize, nSrcYSize);
 
+/* -------------------------------------------------------------------- */
+/*      Do not try to apply transparent/invalid source pixels to the    */
+/*      destination.  This currently ignores the multi-pixel input      */
+/*      of bilinear and cubic resamples.                                */
+/* -------------------------------------------------------------------- */
+            double  dfDensity = 1.0;
+
+            if( poWK->pafUnifiedSrcDensity != NULL )
+            {
+                dfDensity = poWK->pafUnifiedSrcDensity[iSrcOffset];
+                if( dfDensity < 0.00001 )
+                    continue;
+            }
+
+            if( poWK->panUnifiedSrcValid != NULL
+                && !(poWK->panUnifiedSrcValid[iSrcOffset>>5]
+                     & (0x01 << (iSrcOffset & 0x1f))) )
+                continue;
+
 /* ==================================================================== */
 /*      Loop processing each band.                                      */
 /* ==================================================================== */
             int iBand;
-            int iDstOffset;
-
+            int bHasFoundDensity = FALSE;
+            
             iDstOffset = iDstX + iDstY * nDstXSize;
-
             for( iBand = 0; iBand < poWK->nBands; iBand++ )
             {
-                poWK->papabyDstImage[iBand][iDstOffset] = 
-                    poWK->papabySrcImage[iBand][iSrcOffset];
-            }
-        }
+                double dfBandDensity = 0.0;
+                double dfValueReal = 0.0;
+                double dfValueImag = 0.0;
 
 /* -------------------------------------------------------------------- */
-/*      Report progress to the user, and optionally cancel out.         */
+/*      Collect the source value.                                       */
 /* -------------------------------------------------------------------- */
-        if (psJob->pfnProgress(psJob))
-            break;
-    }
+                if ( nSrcXSize == 1 || nSrcYSize == 1 )
+                {
+                    T value = 0;
+
+                    GWKGetPixelT<T>( poWK, iBand, iSrcOffset,
+                                     &dfBandDensity, &value );
+                    dfValueReal = value;
+                }
+                else if ( eResample == GRA_Bilinear )
+                {
+                    GWKBilinearResampleT<T>( poWK, iBand, 
+                                             padfX[iDstX]-poWK->nSrcXOff,
+                                             padfY[iDstX]-poWK->nSrcYOff,
+                                             &dfBandDensity, 
+                                             &dfValueReal, &dfValueImag );
+                }
+                else
+                {
+                    GWKCubicResampleT<T>( poWK, iBand, 
+                                          padfX[iDstX]-poWK->nSrcXOff,
+                                          padfY[iDstX]-poWK->nSrcYOff,
+                                          &dfBandDensity, 
+                                          &dfValueReal, &dfValueImag );
+                }
+
+                // If we didn't find any valid inputs skip to next band.
+                if ( dfBandDensity < 0.0000000001 )
+                    continue;
+
+                bHasFoundDensity = TRUE;
+
+/* -------------------------------------------------------------------- */
+/*      We have a computed value from the source.  Now apply it to      */
+/*      the destination pixel.                                          */
+/* -------------------------------------------------------------------- */
+                GWKSetPixelValueT<T>( poWK, iBand, iDstOffset,
+                                      dfBandDensity, dfValueReal );
+            }
+
+            if (!bHasFoundDensity)
+              continue;
+
+/* -------------------------------------------------------------------- */
+/*      Update destination density/validity masks.                      */
+/* -------------------------------------------------------------------- */
+            GWKOverlayDensity( poWK, iDstOffset, dfDensity );
+
+            if( poWK->panDstValid != NULL )
+            {
+                poWK->panDstValid[iDstOffset>>5] |= 
+                    0x01 << (iDstOffset & 0x1f);
+            }
+
+        } /* Next iDstX */
+
+/* -------------------------------------------------------------------- */
+/*      Report progress to the user, and optionally cancel out.         */
+/* -------------------------------------------------------------------- */
+        if (psJob->pfnProgress(psJob))
+            break;
+    }
 
 /* -------------------------------------------------------------------- */
 /*      Cleanup and return.                                             */
@@ -3657,21 +3858,61 @@ static void GWKNearestNoMasksByteThread(void* pData)
 }
 
 /************************************************************************/
-/*                       GWKBilinearNoMasksByte()                       */
+/*                         GWKBilinearOrCubic()                         */
 /*                                                                      */
-/*      Case for 8bit input data with bilinear resampling without       */
-/*      concerning about masking. Should be as fast as possible         */
-/*      for this particular transformation type.                        */
+/*      Bilinear and cubic convolution resampling of Byte, Int16,       */
+/*      UInt16, Float32 and Float64 data with validity or density       */
+/*      masks.  Returns CE_Warning, without doing anything, for the     */
+/*      other working data types that must go through the general       */
+/*      case.                                                           */
 /************************************************************************/
 
-static void GWKBilinearNoMasksByteThread(void* pData);
+#define GWK_RESAMPLE_CASE(eDT, T, pszName)                              \
+      case eDT:                                                         \
+        if( poWK->eResample == GRA_Bilinear )                           \
+            return GWKRun( poWK, "GWKBilinear" pszName,                 \
+                           GWKResampleThreadT<T, GRA_Bilinear> );       \
+        else                                                            \
+            return GWKRun( poWK, "GWKCubic" pszName,                    \
+                           GWKResampleThreadT<T, GRA_Cubic> );
+
+static CPLErr GWKBilinearOrCubic( GDALWarpKernel *poWK )
 
-static CPLErr GWKBilinearNoMasksByte( GDALWarpKernel *poWK )
 {
-    return GWKRun( poWK, "GWKBilinearNoMasksByte", GWKBilinearNoMasksByteThread );
+    CPLAssert( poWK->eResample == GRA_Bilinear
+               || poWK->eResample == GRA_Cubic );
+
+    switch( poWK->eWorkingDataType )
+    {
+      GWK_RESAMPLE_CASE(GDT_Byte, GByte, "Byte")
+      GWK_RESAMPLE_CASE(GDT_Int16, GInt16, "Short")
+      GWK_RESAMPLE_CASE(GDT_UInt16, GUInt16, "UShort")
+      GWK_RESAMPLE_CASE(GDT_Float32, float, "Float")
+      GWK_RESAMPLE_CASE(GDT_Float64, double, "Double")
+
+      default:
+        return CE_Warning;
+    }
 }
 
-static void GWKBilinearNoMasksByteThread(void* pData)
+#undef GWK_RESAMPLE_CASE
+
+/************************************************************************/
+/*                       GWKNearestNoMasksByte()                        */
+/*                                                                      */
+/*      Case for 8bit input data with nearest neighbour resampling      */
+/*      without concerning about masking. Should be as fast as          */
+/*      possible for this particular transformation type.               */
+/************************************************************************/
+
+static void GWKNearestNoMasksByteThread(void* pData);
+
+static CPLErr GWKNearestNoMasksByte( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKNearestNoMasksByte", GWKNearestNoMasksByteThread );
+}
+
+static void GWKNearestNoMasksByteThread(void* pData)
 {
     GWKJobStruct* psJob = (GWKJobStruct*) pData;
     GDALWarpKernel *poWK = psJob->poWK;
@@ -3735,10 +3976,8 @@ static void GWKBilinearNoMasksByteThread(void* pData)
 
             for( iBand = 0; iBand < poWK->nBands; iBand++ )
             {
-                GWKBilinearResampleNoMasksByte( poWK, iBand,
-                                                padfX[iDstX]-poWK->nSrcXOff,
-                                                padfY[iDstX]-poWK->nSrcYOff,
-                                                &poWK->papabyDstImage[iBand][iDstOffset] );
+                poWK->papabyDstImage[iBand][iDstOffset] = 
+                    poWK->papabySrcImage[iBand][iSrcOffset];
             }
         }
 
@@ -3759,21 +3998,208 @@ static void GWKBilinearNoMasksByteThread(void* pData)
 }
 
 /************************************************************************/
-/*                       GWKCubicNoMasksByte()                          */
+/*                     GWKComputeKernelWeightsT()                       */
 /*                                                                      */
-/*      Case for 8bit input data with cubic resampling without          */
-/*      concerning about masking. Should be as fast as possible         */
-/*      for this particular transformation type.                        */
+/*      Compute the offset of the top left source pixel and the         */
+/*      separable weights of the bilinear (nKernelSize == 2) or         */
+/*      cubic convolution (nKernelSize == 4) kernel.  The X weights     */
+/*      are stored in padfWeights[0..3] and the Y weights in            */
+/*      padfWeights[4..7].  Returns FALSE if the kernel does not fit    */
+/*      entirely in the source window, in which case the caller must    */
+/*      use the scalar resamplers that know how to handle the borders.  */
 /************************************************************************/
 
-static void GWKCubicNoMasksByteThread(void* pData);
+template<int nKernelSize>
+static int GWKComputeKernelWeightsT( GDALWarpKernel *poWK,
+                                     double dfSrcX, double dfSrcY,
+                                     int *piSrcOffset, double *padfWeights )
 
-static CPLErr GWKCubicNoMasksByte( GDALWarpKernel *poWK )
 {
-    return GWKRun( poWK, "GWKCubicNoMasksByte", GWKCubicNoMasksByteThread );
+    if( nKernelSize == 2 )
+    {
+        int     iSrcX = (int) floor(dfSrcX - 0.5);
+        int     iSrcY = (int) floor(dfSrcY - 0.5);
+
+        if( iSrcX < 0 || iSrcX + 1 >= poWK->nSrcXSize
+            || iSrcY < 0 || iSrcY + 1 >= poWK->nSrcYSize )
+            return FALSE;
+
+        double  dfRatioX = 1.5 - (dfSrcX - iSrcX);
+        double  dfRatioY = 1.5 - (dfSrcY - iSrcY);
+
+        *piSrcOffset = iSrcX + iSrcY * poWK->nSrcXSize;
+        padfWeights[0] = dfRatioX;
+        padfWeights[1] = 1.0 - dfRatioX;
+        padfWeights[4] = dfRatioY;
+        padfWeights[5] = 1.0 - dfRatioY;
+    }
+    else
+    {
+        int     iSrcX = (int) (dfSrcX - 0.5);
+        int     iSrcY = (int) (dfSrcY - 0.5);
+
+        if( iSrcX - 1 < 0 || iSrcX + 2 >= poWK->nSrcXSize
+            || iSrcY - 1 < 0 || iSrcY + 2 >= poWK->nSrcYSize )
+            return FALSE;
+
+        double  dfDeltaX = dfSrcX - 0.5 - iSrcX;
+        double  dfDeltaY = dfSrcY - 0.5 - iSrcY;
+        double  dfDeltaX2 = dfDeltaX * dfDeltaX;
+        double  dfDeltaY2 = dfDeltaY * dfDeltaY;
+        double  dfDeltaX3 = dfDeltaX2 * dfDeltaX;
+        double  dfDeltaY3 = dfDeltaY2 * dfDeltaY;
+
+        *piSrcOffset = (iSrcX - 1) + (iSrcY - 1) * poWK->nSrcXSize;
+
+        // CubicConvolution() expanded as weights of f0, f1, f2 and f3
+        padfWeights[0] = 0.5 * (-dfDeltaX + 2.0 * dfDeltaX2 - dfDeltaX3);
+        padfWeights[1] = 1.0 + 0.5 * (-5.0 * dfDeltaX2 + 3.0 * dfDeltaX3);
+        padfWeights[2] = 0.5 * (dfDeltaX + 4.0 * dfDeltaX2 - 3.0 * dfDeltaX3);
+        padfWeights[3] = 0.5 * (-dfDeltaX2 + dfDeltaX3);
+        padfWeights[4] = 0.5 * (-dfDeltaY + 2.0 * dfDeltaY2 - dfDeltaY3);
+        padfWeights[5] = 1.0 + 0.5 * (-5.0 * dfDeltaY2 + 3.0 * dfDeltaY3);
+        padfWeights[6] = 0.5 * (dfDeltaY + 4.0 * dfDeltaY2 - 3.0 * dfDeltaY3);
+        padfWeights[7] = 0.5 * (-dfDeltaY2 + dfDeltaY3);
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                       GWKConvolveKernelT()                           */
+/*                                                                      */
+/*      Apply the weights computed by GWKComputeKernelWeightsT() to     */
+/*      the source pixels.  The columns are first combined with the     */
+/*      Y weights, and then with the X weights, in the same order as    */
+/*      the SSE2 version so that both give identical results.           */
+/************************************************************************/
+
+template<class T, int nKernelSize>
+static double GWKConvolveKernelT( const T *pSrc, int nSrcXSize,
+                                  const double *padfWeights )
+
+{
+    double  adfColumn[4];
+    int     i, j;
+
+    for( i = 0; i < nKernelSize; i++ )
+        adfColumn[i] = (double)pSrc[i] * padfWeights[4];
+    for( j = 1; j < nKernelSize; j++ )
+    {
+        pSrc += nSrcXSize;
+        for( i = 0; i < nKernelSize; i++ )
+            adfColumn[i] += (double)pSrc[i] * padfWeights[4 + j];
+    }
+
+    if( nKernelSize == 2 )
+        return adfColumn[0] * padfWeights[0] + adfColumn[1] * padfWeights[1];
+
+    return (adfColumn[0] * padfWeights[0] + adfColumn[2] * padfWeights[2])
+        + (adfColumn[1] * padfWeights[1] + adfColumn[3] * padfWeights[3]);
+}
+
+#ifdef USE_SSE2
+
+/************************************************************************/
+/*                         GWKLoad2SSE2()                               */
+/*                         GWKLoad4SSE2()                               */
+/************************************************************************/
+
+template<class T>
+static CPL_INLINE __m128d GWKLoad2SSE2( const T *pSrc )
+{
+    return _mm_set_pd( (double)pSrc[1], (double)pSrc[0] );
 }
 
-static void GWKCubicNoMasksByteThread( void* pData )
+template<class T>
+static CPL_INLINE void GWKLoad4SSE2( const T *pSrc, __m128d &xLow, __m128d &xHigh )
+{
+    xLow = _mm_set_pd( (double)pSrc[1], (double)pSrc[0] );
+    xHigh = _mm_set_pd( (double)pSrc[3], (double)pSrc[2] );
+}
+
+template<>
+CPL_INLINE void GWKLoad4SSE2<GByte>( const GByte *pSrc, __m128d &xLow, __m128d &xHigh )
+{
+    int nWord;
+    memcpy( &nWord, pSrc, 4 );
+    __m128i xZero = _mm_setzero_si128();
+    __m128i xInt = _mm_cvtsi32_si128( nWord );
+    xInt = _mm_unpacklo_epi8( xInt, xZero );
+    xInt = _mm_unpacklo_epi16( xInt, xZero );
+    xLow = _mm_cvtepi32_pd( xInt );
+    xHigh = _mm_cvtepi32_pd( _mm_shuffle_epi32( xInt, _MM_SHUFFLE(3,2,3,2) ) );
+}
+
+template<>
+CPL_INLINE void GWKLoad4SSE2<float>( const float *pSrc, __m128d &xLow, __m128d &xHigh )
+{
+    __m128 xFloat = _mm_loadu_ps( pSrc );
+    xLow = _mm_cvtps_pd( xFloat );
+    xHigh = _mm_cvtps_pd( _mm_movehl_ps( xFloat, xFloat ) );
+}
+
+/************************************************************************/
+/*                     GWKConvolveKernelSSE2()                          */
+/*                                                                      */
+/*      SSE2 version of GWKConvolveKernelT().  Returns the two          */
+/*      partial sums that remain to be added together, so that the     */
+/*      caller can finish two destination pixels with one horizontal    */
+/*      add.                                                            */
+/************************************************************************/
+
+template<class T, int nKernelSize>
+static CPL_INLINE __m128d GWKConvolveKernelSSE2( const T *pSrc, int nSrcXSize,
+                                                 const double *padfWeights )
+
+{
+    if( nKernelSize == 2 )
+    {
+        __m128d xColumn = _mm_mul_pd( GWKLoad2SSE2( pSrc ),
+                                      _mm_set1_pd( padfWeights[4] ) );
+        xColumn = _mm_add_pd( xColumn,
+                              _mm_mul_pd( GWKLoad2SSE2( pSrc + nSrcXSize ),
+                                          _mm_set1_pd( padfWeights[5] ) ) );
+        return _mm_mul_pd( xColumn, _mm_loadu_pd( padfWeights ) );
+    }
+
+    __m128d xLow, xHigh, xWeightY;
+    __m128d xColumnLow, xColumnHigh;
+    int     j;
+
+    GWKLoad4SSE2( pSrc, xLow, xHigh );
+    xWeightY = _mm_set1_pd( padfWeights[4] );
+    xColumnLow = _mm_mul_pd( xLow, xWeightY );
+    xColumnHigh = _mm_mul_pd( xHigh, xWeightY );
+    for( j = 1; j < 4; j++ )
+    {
+        pSrc += nSrcXSize;
+        GWKLoad4SSE2( pSrc, xLow, xHigh );
+        xWeightY = _mm_set1_pd( padfWeights[4 + j] );
+        xColumnLow = _mm_add_pd( xColumnLow, _mm_mul_pd( xLow, xWeightY ) );
+        xColumnHigh = _mm_add_pd( xColumnHigh, _mm_mul_pd( xHigh, xWeightY ) );
+    }
+
+    return _mm_add_pd( _mm_mul_pd( xColumnLow, _mm_loadu_pd( padfWeights ) ),
+                       _mm_mul_pd( xColumnHigh, _mm_loadu_pd( padfWeights + 2 ) ) );
+}
+
+#endif /* def USE_SSE2 */
+
+/************************************************************************/
+/*                     GWKResampleNoMasksThreadT()                      */
+/*                                                                      */
+/*      Bilinear (nKernelSize == 2) and cubic convolution               */
+/*      (nKernelSize == 4) resampling without concerning about          */
+/*      masking.  The kernel position and weights of each output        */
+/*      pixel are computed once per scanline and shared by all the      */
+/*      bands.  Pixels whose kernel fits in the source window are then  */
+/*      interpolated two at a time with SSE2 when available, the        */
+/*      other ones go through the scalar resamplers.                    */
+/************************************************************************/
+
+template<class T, int nKernelSize>
+static void GWKResampleNoMasksThreadT( void* pData )
 
 {
     GWKJobStruct* psJob = (GWKJobStruct*) pData;
@@ -3785,6 +4211,10 @@ static void GWKCubicNoMasksByteThread( void* pData )
     int nDstXSize = poWK->nDstXSize;
     int nSrcXSize = poWK->nSrcXSize, nSrcYSize = poWK->nSrcYSize;
 
+#ifdef USE_SSE2
+    int bUseSSE2 = CSLTestBoolean(CPLGetConfigOption("GDAL_USE_SSE", "YES"));
+#endif
+
 /* -------------------------------------------------------------------- */
 /*      Allocate x,y,z coordinate arrays for transformation ... one     */
 /*      scanlines worth of positions.                                   */
@@ -3797,12 +4227,23 @@ static void GWKCubicNoMasksByteThread( void* pData )
     padfZ = (double *) CPLMalloc(sizeof(double) * nDstXSize);
     pabSuccess = (int *) CPLMalloc(sizeof(int) * nDstXSize);
 
+/* -------------------------------------------------------------------- */
+/*      Kernel positions and weights of one scanline.                   */
+/* -------------------------------------------------------------------- */
+    int    *panKernelDstX, *panKernelSrcOffset;
+    double *padfKernelWeights;
+
+    panKernelDstX = (int *) CPLMalloc(sizeof(int) * nDstXSize);
+    panKernelSrcOffset = (int *) CPLMalloc(sizeof(int) * nDstXSize);
+    padfKernelWeights = (double *) CPLMalloc(sizeof(double) * 8 * nDstXSize);
+
 /* ==================================================================== */
 /*      Loop over output lines.                                         */
 /* ==================================================================== */
     for( iDstY = iYMin; iDstY < iYMax; iDstY++ )
     {
         int iDstX;
+        int nKernelPixels = 0;
 
 /* -------------------------------------------------------------------- */
 /*      Setup points to transform to source image space.                */
@@ -3822,26 +4263,82 @@ static void GWKCubicNoMasksByteThread( void* pData )
                               padfX, padfY, padfZ, pabSuccess );
 
 /* ==================================================================== */
-/*      Loop over pixels in output scanline.                            */
+/*      Compute the kernel of each pixel in output scanline, and        */
+/*      directly resample the ones on the source window borders.        */
 /* ==================================================================== */
         for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
         {
             COMPUTE_iSrcOffset(pabSuccess, iDstX, padfX, padfY, poWK, nSrcXSize, nSrcYSize);
 
+            double dfSrcX = padfX[iDstX] - poWK->nSrcXOff;
+            double dfSrcY = padfY[iDstX] - poWK->nSrcYOff;
+
+            if( GWKComputeKernelWeightsT<nKernelSize>(
+                    poWK, dfSrcX, dfSrcY,
+                    panKernelSrcOffset + nKernelPixels,
+                    padfKernelWeights + 8 * nKernelPixels ) )
+            {
+                panKernelDstX[nKernelPixels++] = iDstX;
+                continue;
+            }
+
+            int iBand;
+            int iDstOffset = iDstX + iDstY * nDstXSize;
+
+            for( iBand = 0; iBand < poWK->nBands; iBand++ )
+            {
+                T* pDst = ((T *) poWK->papabyDstImage[iBand]) + iDstOffset;
+
+                if( nKernelSize == 2 )
+                    GWKBilinearResampleNoMasksT<T>( poWK, iBand,
+                                                    dfSrcX, dfSrcY, pDst );
+                else
+                    GWKCubicResampleNoMasksT<T>( poWK, iBand,
+                                                 dfSrcX, dfSrcY, pDst );
+            }
+        }
+
 /* ==================================================================== */
 /*      Loop processing each band.                                      */
 /* ==================================================================== */
-            int iBand;
-            int iDstOffset;
+        int iBand;
 
-            iDstOffset = iDstX + iDstY * nDstXSize;
+        for( iBand = 0; iBand < poWK->nBands; iBand++ )
+        {
+            const T *pSrc = (const T *) poWK->papabySrcImage[iBand];
+            T *pDst = ((T *) poWK->papabyDstImage[iBand]) + iDstY * nDstXSize;
+            int i = 0;
 
-            for( iBand = 0; iBand < poWK->nBands; iBand++ )
+#ifdef USE_SSE2
+            if( bUseSSE2 )
             {
-                GWKCubicResampleNoMasksByte( poWK, iBand,
-                                             padfX[iDstX]-poWK->nSrcXOff,
-                                             padfY[iDstX]-poWK->nSrcYOff,
-                                             &poWK->papabyDstImage[iBand][iDstOffset] );
+                double adfValue[2];
+
+                for( ; i + 1 < nKernelPixels; i += 2 )
+                {
+                    __m128d xPixel1 = GWKConvolveKernelSSE2<T, nKernelSize>(
+                        pSrc + panKernelSrcOffset[i], nSrcXSize,
+                        padfKernelWeights + 8 * i );
+                    __m128d xPixel2 = GWKConvolveKernelSSE2<T, nKernelSize>(
+                        pSrc + panKernelSrcOffset[i + 1], nSrcXSize,
+                        padfKernelWeights + 8 * (i + 1) );
+
+                    _mm_storeu_pd( adfValue,
+                        _mm_add_pd( _mm_unpacklo_pd( xPixel1, xPixel2 ),
+                                    _mm_unpackhi_pd( xPixel1, xPixel2 ) ) );
+
+                    pDst[panKernelDstX[i]] = GWKRoundValueT<T>( adfValue[0] );
+                    pDst[panKernelDstX[i + 1]] = GWKRoundValueT<T>( adfValue[1] );
+                }
+            }
+#endif
+
+            for( ; i < nKernelPixels; i++ )
+            {
+                pDst[panKernelDstX[i]] = GWKRoundValueT<T>(
+                    GWKConvolveKernelT<T, nKernelSize>(
+                        pSrc + panKernelSrcOffset[i], nSrcXSize,
+                        padfKernelWeights + 8 * i ) );
             }
         }
 
@@ -3859,8 +4356,105 @@ static void GWKCubicNoMasksByteThread( void* pData )
     CPLFree( padfY );
     CPLFree( padfZ );
     CPLFree( pabSuccess );
+    CPLFree( panKernelDstX );
+    CPLFree( panKernelSrcOffset );
+    CPLFree( padfKernelWeights );
+}
+
+/************************************************************************/
+/*                       GWKBilinearNoMasksByte()                       */
+/*                       GWKCubicNoMasksByte()                          */
+/*                                                                      */
+/*      Case for 8bit input data with bilinear or cubic resampling      */
+/*      without concerning about masking. Should be as fast as          */
+/*      possible for this particular transformation type.               */
+/************************************************************************/
+
+static CPLErr GWKBilinearNoMasksByte( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKBilinearNoMasksByte",
+                   GWKResampleNoMasksThreadT<GByte, 2> );
+}
+
+static CPLErr GWKCubicNoMasksByte( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKCubicNoMasksByte",
+                   GWKResampleNoMasksThreadT<GByte, 4> );
+}
+
+/************************************************************************/
+/*                       GWKBilinearNoMasksShort()                      */
+/*                       GWKCubicNoMasksShort()                         */
+/*                       GWKBilinearNoMasksUShort()                     */
+/*                       GWKCubicNoMasksUShort()                        */
+/*                                                                      */
+/*      Case for 16bit signed and unsigned input data with bilinear     */
+/*      or cubic resampling without concerning about masking.           */
+/************************************************************************/
+
+static CPLErr GWKBilinearNoMasksShort( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKBilinearNoMasksShort",
+                   GWKResampleNoMasksThreadT<GInt16, 2> );
+}
+
+static CPLErr GWKCubicNoMasksShort( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKCubicNoMasksShort",
+                   GWKResampleNoMasksThreadT<GInt16, 4> );
+}
+
+static CPLErr GWKBilinearNoMasksUShort( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKBilinearNoMasksUShort",
+                   GWKResampleNoMasksThreadT<GUInt16, 2> );
+}
+
+static CPLErr GWKCubicNoMasksUShort( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKCubicNoMasksUShort",
+                   GWKResampleNoMasksThreadT<GUInt16, 4> );
+}
+
+/************************************************************************/
+/*                       GWKBilinearNoMasksFloat()                      */
+/*                       GWKCubicNoMasksFloat()                         */
+/*                                                                      */
+/*      Case for 32bit float input data with bilinear or cubic          */
+/*      resampling without concerning about masking.                    */
+/************************************************************************/
+
+static CPLErr GWKBilinearNoMasksFloat( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKBilinearNoMasksFloat",
+                   GWKResampleNoMasksThreadT<float, 2> );
+}
+
+static CPLErr GWKCubicNoMasksFloat( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKCubicNoMasksFloat",
+                   GWKResampleNoMasksThreadT<float, 4> );
+}
+
+/************************************************************************/
+/*                       GWKBilinearNoMasksDouble()                     */
+/*                       GWKCubicNoMasksDouble()                        */
+/*                                                                      */
+/*      Case for 64bit float input data with bilinear or cubic          */
+/*      resampling without concerning about masking.                    */
+/************************************************************************/
+
+static CPLErr GWKBilinearNoMasksDouble( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKBilinearNoMasksDouble",
+                   GWKResampleNoMasksThreadT<double, 2> );
 }
 
+static CPLErr GWKCubicNoMasksDouble( GDALWarpKernel *poWK )
+{
+    return GWKRun( poWK, "GWKCubicNoMasksDouble",
+                   GWKResampleNoMasksThreadT<double, 4> );
+}
 /************************************************************************/
 /*                   GWKCubicSplineNoMasksByte()                        */
 /*                                                                      */
@@ -4076,8 +4670,8 @@ static void GWKNearestByteThread( void* pData )
 /* -------------------------------------------------------------------- */
 /*      Collect the source value.                                       */
 /* -------------------------------------------------------------------- */
-                if ( GWKGetPixelByte( poWK, iBand, iSrcOffset, &dfBandDensity,
-                                      &bValue ) )
+                if ( GWKGetPixelT<GByte>( poWK, iBand, iSrcOffset, &dfBandDensity,
+                                          &bValue ) )
                 {
                     if( dfBandDensity < 1.0 )
                     {
@@ -4229,216 +4823,6 @@ static void GWKNearestNoMasksShortThread( void* pData )
     CPLFree( pabSuccess );
 }
 
-/************************************************************************/
-/*                       GWKBilinearNoMasksShort()                      */
-/*                                                                      */
-/*      Case for 16bit input data with cubic resampling without         */
-/*      concerning about masking. Should be as fast as possible         */
-/*      for this particular transformation type.                        */
-/************************************************************************/
-
-static void GWKBilinearNoMasksShortThread(void* pData);
-
-static CPLErr GWKBilinearNoMasksShort( GDALWarpKernel *poWK )
-{
-    return GWKRun( poWK, "GWKBilinearNoMasksShort", GWKBilinearNoMasksShortThread );
-}
-
-static void GWKBilinearNoMasksShortThread( void* pData )
-
-{
-    GWKJobStruct* psJob = (GWKJobStruct*) pData;
-    GDALWarpKernel *poWK = psJob->poWK;
-    int iYMin = psJob->iYMin;
-    int iYMax = psJob->iYMax;
-
-    int iDstY;
-    int nDstXSize = poWK->nDstXSize;
-    int nSrcXSize = poWK->nSrcXSize, nSrcYSize = poWK->nSrcYSize;
-
-/* -------------------------------------------------------------------- */
-/*      Allocate x,y,z coordinate arrays for transformation ... one     */
-/*      scanlines worth of positions.                                   */
-/* -------------------------------------------------------------------- */
-    double *padfX, *padfY, *padfZ;
-    int    *pabSuccess;
-
-    padfX = (double *) CPLMalloc(sizeof(double) * nDstXSize);
-    padfY = (double *) CPLMalloc(sizeof(double) * nDstXSize);
-    padfZ = (double *) CPLMalloc(sizeof(double) * nDstXSize);
-    pabSuccess = (int *) CPLMalloc(sizeof(int) * nDstXSize);
-
-/* ==================================================================== */
-/*      Loop over output lines.                                         */
-/* ==================================================================== */
-    for( iDstY = iYMin; iDstY < iYMax; iDstY++ )
-    {
-        int iDstX;
-
-/* -------------------------------------------------------------------- */
-/*      Setup points to transform to source image space.                */
-/* -------------------------------------------------------------------- */
-        for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
-        {
-            padfX[iDstX] = iDstX + 0.5 + poWK->nDstXOff;
-            padfY[iDstX] = iDstY + 0.5 + poWK->nDstYOff;
-            padfZ[iDstX] = 0.0;
-        }
-
-/* -------------------------------------------------------------------- */
-/*      Transform the points from destination pixel/line coordinates    */
-/*      to source pixel/line coordinates.                               */
-/* -------------------------------------------------------------------- */
-        poWK->pfnTransformer( psJob->pTransformerArg, TRUE, nDstXSize,
-                              padfX, padfY, padfZ, pabSuccess );
-
-/* ==================================================================== */
-/*      Loop over pixels in output scanline.                            */
-/* ==================================================================== */
-        for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
-        {
-            COMPUTE_iSrcOffset(pabSuccess, iDstX, padfX, padfY, poWK, nSrcXSize, nSrcYSize);
-
-/* ==================================================================== */
-/*      Loop processing each band.                                      */
-/* ==================================================================== */
-            int iBand;
-            int iDstOffset;
-
-            iDstOffset = iDstX + iDstY * nDstXSize;
-
-            for( iBand = 0; iBand < poWK->nBands; iBand++ )
-            {
-                GInt16  iValue = 0;
-                GWKBilinearResampleNoMasksShort( poWK, iBand,
-                                                 padfX[iDstX]-poWK->nSrcXOff,
-                                                 padfY[iDstX]-poWK->nSrcYOff,
-                                                 &iValue );
-                ((GInt16 *)poWK->papabyDstImage[iBand])[iDstOffset] = iValue;
-            }
-        }
-
-/* -------------------------------------------------------------------- */
-/*      Report progress to the user, and optionally cancel out.         */
-/* -------------------------------------------------------------------- */
-        if (psJob->pfnProgress(psJob))
-            break;
-    }
-
-/* -------------------------------------------------------------------- */
-/*      Cleanup and return.                                             */
-/* -------------------------------------------------------------------- */
-    CPLFree( padfX );
-    CPLFree( padfY );
-    CPLFree( padfZ );
-    CPLFree( pabSuccess );
-}
-
-/************************************************************************/
-/*                       GWKCubicNoMasksShort()                         */
-/*                                                                      */
-/*      Case for 16bit input data with cubic resampling without         */
-/*      concerning about masking. Should be as fast as possible         */
-/*      for this particular transformation type.                        */
-/************************************************************************/
-
-static void GWKCubicNoMasksShortThread(void* pData);
-
-static CPLErr GWKCubicNoMasksShort( GDALWarpKernel *poWK )
-{
-    return GWKRun( poWK, "GWKCubicNoMasksShort", GWKCubicNoMasksShortThread );
-}
-
-static void GWKCubicNoMasksShortThread( void* pData )
-
-{
-    GWKJobStruct* psJob = (GWKJobStruct*) pData;
-    GDALWarpKernel *poWK = psJob->poWK;
-    int iYMin = psJob->iYMin;
-    int iYMax = psJob->iYMax;
-
-    int iDstY;
-    int nDstXSize = poWK->nDstXSize;
-    int nSrcXSize = poWK->nSrcXSize, nSrcYSize = poWK->nSrcYSize;
-
-/* -------------------------------------------------------------------- */
-/*      Allocate x,y,z coordinate arrays for transformation ... one     */
-/*      scanlines worth of positions.                                   */
-/* -------------------------------------------------------------------- */
-    double *padfX, *padfY, *padfZ;
-    int    *pabSuccess;
-
-    padfX = (double *) CPLMalloc(sizeof(double) * nDstXSize);
-    padfY = (double *) CPLMalloc(sizeof(double) * nDstXSize);
-    padfZ = (double *) CPLMalloc(sizeof(double) * nDstXSize);
-    pabSuccess = (int *) CPLMalloc(sizeof(int) * nDstXSize);
-
-/* ==================================================================== */
-/*      Loop over output lines.                                         */
-/* ==================================================================== */
-    for( iDstY = iYMin; iDstY < iYMax; iDstY++ )
-    {
-        int iDstX;
-
-/* -------------------------------------------------------------------- */
-/*      Setup points to transform to source image space.                */
-/* -------------------------------------------------------------------- */
-        for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
-        {
-            padfX[iDstX] = iDstX + 0.5 + poWK->nDstXOff;
-            padfY[iDstX] = iDstY + 0.5 + poWK->nDstYOff;
-            padfZ[iDstX] = 0.0;
-        }
-
-/* -------------------------------------------------------------------- */
-/*      Transform the points from destination pixel/line coordinates    */
-/*      to source pixel/line coordinates.                               */
-/* -------------------------------------------------------------------- */
-        poWK->pfnTransformer( psJob->pTransformerArg, TRUE, nDstXSize,
-                              padfX, padfY, padfZ, pabSuccess );
-
-/* ==================================================================== */
-/*      Loop over pixels in output scanline.                            */
-/* ==================================================================== */
-        for( iDstX = 0; iDstX < nDstXSize; iDstX++ )
-        {
-            COMPUTE_iSrcOffset(pabSuccess, iDstX, padfX, padfY, poWK, nSrcXSize, nSrcYSize);
-
-/* ==================================================================== */
-/*      Loop processing each band.                                      */
-/* ==================================================================== */
-            int iBand;
-            int iDstOffset;
-
-            iDstOffset = iDstX + iDstY * nDstXSize;
-
-            for( iBand = 0; iBand < poWK->nBands; iBand++ )
-            {
-                GInt16  iValue = 0;
-                GWKCubicResampleNoMasksShort( poWK, iBand,
-                                              padfX[iDstX]-poWK->nSrcXOff,
-                                              padfY[iDstX]-poWK->nSrcYOff,
-                                              &iValue );
-                ((GInt16 *)poWK->papabyDstImage[iBand])[iDstOffset] = iValue;
-            }
-        }
-
-/* -------------------------------------------------------------------- */
-/*      Report progress to the user, and optionally cancel out.         */
-/* -------------------------------------------------------------------- */
-        if (psJob->pfnProgress(psJob))
-            break;
-    }
-
-/* -------------------------------------------------------------------- */
-/*      Cleanup and return.                                             */
-/* -------------------------------------------------------------------- */
-    CPLFree( padfX );
-    CPLFree( padfY );
-    CPLFree( padfZ );
-    CPLFree( pabSuccess );
-}
-
 /************************************************************************/
 /*                    GWKCubicSplineNoMasksShort()                      */
 /*                                                                      */
@@ -4656,8 +5040,8 @@ static void GWKNearestShortThread(void* pData)
 /* -------------------------------------------------------------------- */
 /*      Collect the source value.                                       */
 /* -------------------------------------------------------------------- */
-                if ( GWKGetPixelShort( poWK, iBand, iSrcOffset, &dfBandDensity,
-                                       &iValue ) )
+                if ( GWKGetPixelT<GInt16>( poWK, iBand, iSrcOffset, &dfBandDensity,
+                                           &iValue ) )
                 {
                     if( dfBandDensity < 1.0 )
                     {
@@ -4915,8 +5299,8 @@ static void GWKNearestFloatThread( void* pData )
 /* -------------------------------------------------------------------- */
 /*      Collect the source value.                                       */
 /* -------------------------------------------------------------------- */
-                if ( GWKGetPixelFloat( poWK, iBand, iSrcOffset, &dfBandDensity,
-                                       &fValue ) )
+                if ( GWKGetPixelT<float>( poWK, iBand, iSrcOffset, &dfBandDensity,
+                                          &fValue ) )
                 {
                     if( dfBandDensity < 1.0 )
                     {
@@ -29,6 +29,8 @@
  ****************************************************************************/
 
 #include "gdalwarper.h"
+#include "gdal_alg_priv.h"
+#include "gdal_priv.h"
 #include "cpl_string.h"
 #include "cpl_multiproc.h"
 #include "ogr_api.h"
@@ -123,7 +125,7 @@ GDALWarpOperation::GDALWarpOperation()
     psOptions = NULL;
 
     hIOMutex = NULL;
-    hWarpMutex = NULL;
+    hTransformerClonePool = NULL;
 
     nChunkListCount = 0;
     nChunkListMax = 0;
@@ -142,12 +144,6 @@ GDALWarpOperation::~GDALWarpOperation()
 {
     WipeOptions();
 
-    if( hIOMutex != NULL )
-    {
-        CPLDestroyMutex( hIOMutex );
-        CPLDestroyMutex( hWarpMutex );
-    }
-
     WipeChunkList();
 }
 
@@ -173,6 +169,10 @@ void GDALWarpOperation::WipeOptions()
         GDALDestroyWarpOptions( psOptions );
         psOptions = NULL;
     }
+
+    GDALDestroyTransformerClonePool(
+        (GDALTransformerClonePool *) hTransformerClonePool );
+    hTransformerClonePool = NULL;
 }
 
 /************************************************************************/
@@ -420,6 +420,15 @@ CPLErr GDALWarpOperation::Initialize( const GDALWarpOptions *psNewOptions )
     psOptions->papszWarpOptions = CSLAddNameValue(psOptions->papszWarpOptions,
         "EXTRA_ELTS", CPLSPrintf("%d", WARP_EXTRA_ELTS));
 
+/* -------------------------------------------------------------------- */
+/*      The clones of the transformer made for the threads of the       */
+/*      warp kernel are kept from one chunk to the next.  The kernel    */
+/*      finds the pool from the transformer.                            */
+/* -------------------------------------------------------------------- */
+    if( psOptions->pTransformerArg != NULL )
+        hTransformerClonePool =
+            GDALCreateTransformerClonePool( psOptions->pTransformerArg );
+
 /* -------------------------------------------------------------------- */
 /*      Default band mapping if missing.                                */
 /* -------------------------------------------------------------------- */
@@ -739,61 +748,240 @@ CPLErr GDALChunkAndWarpImage( GDALWarpOperationH hOperation,
 /*                          ChunkThreadMain()                           */
 /************************************************************************/
 
+/* State shared by all the chunks processed by ChunkAndWarpMulti() */
 typedef struct
+{
+    void              *hIOMutex;     /* destination and shared source access */
+    void              *hWarpMutex;   /* warp kernel and transformer */
+    void              *hWriteMutex;  /* protects nNextChunkToWrite */
+    void              *hWriteCond;
+    int                nNextChunkToWrite;
+} GDALWarpChunkSync;
+
+struct _GDALWarpChunkJob
 {
     GDALWarpOperation *poOperation;
+    GDALWarpChunkSync *psSync;
+
+    /* Options to use for source access : either the operation options */
+    /* or a shallow copy of them pointing to a private source dataset. */
+    GDALWarpOptions   *psSrcOptions;
+    int                bPrivateSrcDS;
+
     int               *panChunkInfo;
-    void              *hThreadHandle;
+    int                iChunk;
+    int                bJobSubmitted;
     CPLErr             eErr;
     double             dfProgressBase;
     double             dfProgressScale;
-    void              *hIOMutex;
 
-    void              *hCondMutex;
     int                bIOMutexTaken;
-    void              *hCond;
-} ChunkThreadData;
+    int                bWarpMutexTaken;
+    int                bDirtyFlushDisabled;
+    int                bWriteTurnTaken;
+};
 
+/************************************************************************/
+/*                     GDALWarpChunkAcquireMutex()                      */
+/************************************************************************/
 
-static void ChunkThreadMain( void *pThreadData )
+static int GDALWarpChunkAcquireMutex( void *hMutex, const char *pszName )
 
 {
-    volatile ChunkThreadData* psData = (volatile ChunkThreadData*) pThreadData;
+    if( !CPLAcquireMutex( hMutex, 600.0 ) )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Failed to acquire %s in WarpRegion().", pszName );
+        return FALSE;
+    }
+    return TRUE;
+}
 
-    int *panChunkInfo = psData->panChunkInfo;
+/************************************************************************/
+/*                      GDALWarpChunkBeginRead()                        */
+/*                                                                      */
+/*      Chunks reading a private source dataset run their read phase    */
+/*      without lock, and must not flush dirty blocks of the            */
+/*      destination that another chunk may be writing.  The others      */
+/*      hold the IO mutex during the whole read phase.                  */
+/************************************************************************/
 
-/* -------------------------------------------------------------------- */
-/*      Acquire IO mutex.                                               */
-/* -------------------------------------------------------------------- */
-    if( !CPLAcquireMutex( psData->hIOMutex, 600.0 ) )
+static int GDALWarpChunkBeginRead( GDALWarpChunkJob *psJob )
+
+{
+    if( psJob->bPrivateSrcDS )
     {
-        CPLError( CE_Failure, CPLE_AppDefined,
-                    "Failed to acquire IOMutex in WarpRegion()." );
-        psData->eErr = CE_Failure;
+        GDALRasterBlock::EnterDisableDirtyBlockFlush();
+        psJob->bDirtyFlushDisabled = TRUE;
+        return TRUE;
     }
-    else
+
+    psJob->bIOMutexTaken =
+        GDALWarpChunkAcquireMutex( psJob->psSync->hIOMutex, "IOMutex" );
+    return psJob->bIOMutexTaken;
+}
+
+/************************************************************************/
+/*                    GDALWarpChunkLockDestination()                    */
+/*                                                                      */
+/*      Protect an access to the destination dataset during the read    */
+/*      phase of a chunk that does not already hold the IO mutex.       */
+/************************************************************************/
+
+static int GDALWarpChunkLockDestination( GDALWarpChunkJob *psJob )
+
+{
+    if( psJob == NULL || psJob->bIOMutexTaken )
+        return TRUE;
+
+    psJob->bIOMutexTaken =
+        GDALWarpChunkAcquireMutex( psJob->psSync->hIOMutex, "IOMutex" );
+    if( psJob->bIOMutexTaken && psJob->bDirtyFlushDisabled )
     {
-        if (psData->hCond != NULL)
-        {
-            CPLAcquireMutex( psData->hCondMutex, 1.0 );
-            psData->bIOMutexTaken = TRUE;
-            CPLCondSignal(psData->hCond);
-            CPLReleaseMutex( psData->hCondMutex );
-        }
+        GDALRasterBlock::LeaveDisableDirtyBlockFlush();
+        psJob->bDirtyFlushDisabled = FALSE;
+    }
+    return psJob->bIOMutexTaken;
+}
+
+static void GDALWarpChunkUnlockDestination( GDALWarpChunkJob *psJob )
+
+{
+    if( psJob == NULL || !psJob->bPrivateSrcDS || !psJob->bIOMutexTaken )
+        return;
+
+    GDALRasterBlock::EnterDisableDirtyBlockFlush();
+    psJob->bDirtyFlushDisabled = TRUE;
+    CPLReleaseMutex( psJob->psSync->hIOMutex );
+    psJob->bIOMutexTaken = FALSE;
+}
+
+/************************************************************************/
+/*                       GDALWarpChunkBeginWarp()                       */
+/************************************************************************/
+
+static int GDALWarpChunkBeginWarp( GDALWarpChunkJob *psJob )
+
+{
+    if( psJob->bIOMutexTaken )
+    {
+        CPLReleaseMutex( psJob->psSync->hIOMutex );
+        psJob->bIOMutexTaken = FALSE;
+    }
+    if( psJob->bDirtyFlushDisabled )
+    {
+        GDALRasterBlock::LeaveDisableDirtyBlockFlush();
+        psJob->bDirtyFlushDisabled = FALSE;
+    }
+
+    psJob->bWarpMutexTaken =
+        GDALWarpChunkAcquireMutex( psJob->psSync->hWarpMutex, "WarpMutex" );
+    return psJob->bWarpMutexTaken;
+}
+
+/************************************************************************/
+/*                       GDALWarpChunkWaitTurn()                        */
+/*                                                                      */
+/*      Wait for all the previous chunks to be written, so that the     */
+/*      destination is written in the order of the chunk list.          */
+/************************************************************************/
+
+static void GDALWarpChunkWaitTurn( GDALWarpChunkJob *psJob )
+
+{
+    GDALWarpChunkSync *psSync = psJob->psSync;
+
+    if( psJob->bWriteTurnTaken )
+        return;
+
+    CPLAcquireMutex( psSync->hWriteMutex, 1000.0 );
+    while( psSync->nNextChunkToWrite != psJob->iChunk )
+        CPLCondWait( psSync->hWriteCond, psSync->hWriteMutex );
+    CPLReleaseMutex( psSync->hWriteMutex );
+
+    psJob->bWriteTurnTaken = TRUE;
+}
+
+/************************************************************************/
+/*                      GDALWarpChunkBeginWrite()                       */
+/************************************************************************/
+
+static int GDALWarpChunkBeginWrite( GDALWarpChunkJob *psJob )
+
+{
+    if( psJob->bWarpMutexTaken )
+    {
+        CPLReleaseMutex( psJob->psSync->hWarpMutex );
+        psJob->bWarpMutexTaken = FALSE;
+    }
+
+    GDALWarpChunkWaitTurn( psJob );
+
+    psJob->bIOMutexTaken =
+        GDALWarpChunkAcquireMutex( psJob->psSync->hIOMutex, "IOMutex" );
+    return psJob->bIOMutexTaken;
+}
+
+/************************************************************************/
+/*                          GDALWarpChunkEnd()                          */
+/*                                                                      */
+/*      Release whatever the chunk still holds, and give its turn to    */
+/*      the next chunk, even on failure.                                */
+/************************************************************************/
+
+static void GDALWarpChunkEnd( GDALWarpChunkJob *psJob )
+
+{
+    GDALWarpChunkSync *psSync = psJob->psSync;
+
+    if( psJob->bIOMutexTaken )
+    {
+        CPLReleaseMutex( psSync->hIOMutex );
+        psJob->bIOMutexTaken = FALSE;
+    }
+    if( psJob->bWarpMutexTaken )
+    {
+        CPLReleaseMutex( psSync->hWarpMutex );
+        psJob->bWarpMutexTaken = FALSE;
+    }
+    if( psJob->bDirtyFlushDisabled )
+    {
+        GDALRasterBlock::LeaveDisableDirtyBlockFlush();
+        psJob->bDirtyFlushDisabled = FALSE;
+    }
+
+    GDALWarpChunkWaitTurn( psJob );
+
+    CPLAcquireMutex( psSync->hWriteMutex, 1000.0 );
+    psSync->nNextChunkToWrite = psJob->iChunk + 1;
+    CPLCondBroadcast( psSync->hWriteCond );
+    CPLReleaseMutex( psSync->hWriteMutex );
+}
+
+void GDALWarpOperation::ChunkThreadMain( void *pThreadData )
+
+{
+    GDALWarpChunkJob *psJob = (GDALWarpChunkJob *) pThreadData;
+    int *panChunkInfo = psJob->panChunkInfo;
 
-        psData->eErr = psData->poOperation->WarpRegion(
+    psJob->bIOMutexTaken = FALSE;
+    psJob->bWarpMutexTaken = FALSE;
+    psJob->bDirtyFlushDisabled = FALSE;
+    psJob->bWriteTurnTaken = FALSE;
+
+    if( !GDALWarpChunkBeginRead( psJob ) )
+        psJob->eErr = CE_Failure;
+    else
+        psJob->eErr = psJob->poOperation->WarpRegionInternal(
                                     panChunkInfo[0], panChunkInfo[1],
                                     panChunkInfo[2], panChunkInfo[3],
                                     panChunkInfo[4], panChunkInfo[5],
                                     panChunkInfo[6], panChunkInfo[7],
-                                    psData->dfProgressBase,
-                                    psData->dfProgressScale);
+                                    psJob->dfProgressBase,
+                                    psJob->dfProgressScale,
+                                    psJob );
 
-    /* -------------------------------------------------------------------- */
-    /*      Release the IO mutex.                                           */
-    /* -------------------------------------------------------------------- */
-        CPLReleaseMutex( psData->hIOMutex );
-    }
+    GDALWarpChunkEnd( psJob );
 }
 
 /************************************************************************/
@@ -810,7 +998,19 @@ static void ChunkThreadMain( void *pThreadData )
  *
  * Externally this method operates the same as ChunkAndWarpImage(), but
  * internally this method uses multiple threads to interleave input/output
- * for one region while the processing is being done for another.
+ * for one region while the processing is being done for another.  The
+ * threads are taken from the process-wide pool returned by
+ * CPLGetWorkerThreadPool().
+ *
+ * Up to NUM_THREADS chunks (warp option, or GDAL_NUM_THREADS configuration
+ * option, with a minimum of 2) are in flight at the same time.  When more
+ * than one thread is requested, the source dataset is reopened for each
+ * chunk slot if its driver supports concurrent reads (see
+ * GDALReopenDatasetForReading()), so that source reads run concurrently.
+ * Otherwise source reads are serialized.  The warping itself is
+ * serialized, as it uses the shared transformer, and destination chunks
+ * are written in order.  The warp memory limit is split between the chunks
+ * in flight, so that together they do not use more than it.
  *
  * @param nDstXOff X offset to window of destination data to be produced.
  * @param nDstYOff Y offset to window of destination data to be produced.
@@ -824,126 +1024,173 @@ CPLErr GDALWarpOperation::ChunkAndWarpMulti(
     int nDstXOff, int nDstYOff,  int nDstXSize, int nDstYSize )
 
 {
-    hIOMutex = CPLCreateMutex();
-    hWarpMutex = CPLCreateMutex();
+/* -------------------------------------------------------------------- */
+/*      How many chunks can be in flight ?                              */
+/* -------------------------------------------------------------------- */
+    const char* pszWarpThreads =
+        CSLFetchNameValue(psOptions->papszWarpOptions, "NUM_THREADS");
+    int nThreads;
+    if (pszWarpThreads == NULL)
+        pszWarpThreads = CPLGetConfigOption("GDAL_NUM_THREADS", "1");
+    if (EQUAL(pszWarpThreads, "ALL_CPUS"))
+        nThreads = CPLGetNumCPUs();
+    else
+        nThreads = atoi(pszWarpThreads);
+    if (nThreads > 128)
+        nThreads = 128;
+    const int nSlots = MAX(2, nThreads);
 
-    CPLReleaseMutex( hIOMutex );
-    CPLReleaseMutex( hWarpMutex );
+    CPLWorkerThreadPool* poThreadPool = CPLGetWorkerThreadPool(nSlots);
+    if( poThreadPool == NULL )
+    {
+        CPLDebug( "GDAL", "No worker thread available. "
+                  "Falling back to ChunkAndWarpImage()" );
+        return ChunkAndWarpImage( nDstXOff, nDstYOff, nDstXSize, nDstYSize );
+    }
+
+    GDALWarpChunkSync sSync;
+    sSync.hIOMutex = CPLCreateMutex();
+    sSync.hWarpMutex = CPLCreateMutex();
+    sSync.hWriteMutex = CPLCreateMutex();
+    sSync.hWriteCond = CPLCreateCond();
+    sSync.nNextChunkToWrite = 0;
 
-    void* hCond = CPLCreateCond();
-    void* hCondMutex = CPLCreateMutex();
-    CPLReleaseMutex(hCondMutex);
+    CPLReleaseMutex( sSync.hIOMutex );
+    CPLReleaseMutex( sSync.hWarpMutex );
+    CPLReleaseMutex( sSync.hWriteMutex );
 
 /* -------------------------------------------------------------------- */
-/*      Collect the list of chunks to operate on.                       */
+/*      Collect the list of chunks to operate on.  Each chunk in        */
+/*      flight gets its share of the memory limit.                      */
 /* -------------------------------------------------------------------- */
+    const double dfWarpMemoryLimit = psOptions->dfWarpMemoryLimit;
+
+    psOptions->dfWarpMemoryLimit = dfWarpMemoryLimit / nSlots;
     WipeChunkList();
     CollectChunkList( nDstXOff, nDstYOff, nDstXSize, nDstYSize );
+    psOptions->dfWarpMemoryLimit = dfWarpMemoryLimit;
 
     /* Sort chucks from top to bottom, and for equal y, from left to right */
     qsort(panChunkList, nChunkListCount, sizeof(WarpChunk), OrderWarpChunk); 
 
 /* -------------------------------------------------------------------- */
-/*      Process them one at a time, updating the progress               */
-/*      information for each region.                                    */
+/*      Set up the chunk slots, with a private source dataset when      */
+/*      several threads are requested and the source can be reopened.   */
 /* -------------------------------------------------------------------- */
-    ChunkThreadData volatile asThreadData[2];
-    memset((void*)&asThreadData, 0, sizeof(asThreadData));
-    asThreadData[0].poOperation = this;
-    asThreadData[0].hIOMutex = hIOMutex;
-    asThreadData[1].poOperation = this;
-    asThreadData[1].hIOMutex = hIOMutex;
+    GDALWarpChunkJob *pasJobs = (GDALWarpChunkJob *)
+        CPLCalloc( sizeof(GDALWarpChunkJob), nSlots );
+    CPLJobGroup *paoJobGroups = new CPLJobGroup[nSlots];
+    int iSlot;
+    int nPrivateSrcDS = 0;
+
+    for( iSlot = 0; iSlot < nSlots; iSlot++ )
+    {
+        GDALWarpChunkJob *psJob = pasJobs + iSlot;
+
+        psJob->poOperation = this;
+        psJob->psSync = &sSync;
+        psJob->psSrcOptions = psOptions;
 
+        GDALDataset *poSrcDS = NULL;
+        if( iSlot > 0 && nThreads > 1 && nChunkListCount > 1 )
+            poSrcDS = GDALReopenDatasetForReading(
+                                        (GDALDataset *) psOptions->hSrcDS );
+        if( poSrcDS != NULL )
+        {
+            psJob->psSrcOptions = (GDALWarpOptions *)
+                CPLMalloc( sizeof(GDALWarpOptions) );
+            memcpy( psJob->psSrcOptions, psOptions, sizeof(GDALWarpOptions) );
+            psJob->psSrcOptions->hSrcDS = (GDALDatasetH) poSrcDS;
+            psJob->bPrivateSrcDS = TRUE;
+            nPrivateSrcDS++;
+        }
+    }
+
+    CPLDebug( "GDAL", "ChunkAndWarpMulti(): %d chunks, %d in flight, "
+              "%d private source dataset(s).",
+              nChunkListCount, nSlots, nPrivateSrcDS );
+
+/* -------------------------------------------------------------------- */
+/*      Process the chunks, keeping up to nSlots of them in flight,     */
+/*      and waiting for them in order.                                  */
+/* -------------------------------------------------------------------- */
     int iChunk;
     double dfPixelsProcessed=0.0, dfTotalPixels = nDstXSize*(double)nDstYSize;
 
     CPLErr eErr = CE_None;
-    for( iChunk = 0; iChunk < nChunkListCount+1; iChunk++ )
+    for( iChunk = 0; iChunk < nChunkListCount; iChunk++ )
     {
-        int    iThread = iChunk % 2;
+        GDALWarpChunkJob *psJob = pasJobs + iChunk % nSlots;
 
 /* -------------------------------------------------------------------- */
-/*      Launch thread for this chunk.                                   */
+/*      Wait for the chunk previously using this slot.                  */
 /* -------------------------------------------------------------------- */
-        if( iChunk < nChunkListCount )
+        if( psJob->bJobSubmitted )
         {
-            int *panThisChunk = panChunkList + iChunk*8;
-            double dfChunkPixels = panThisChunk[2] * (double) panThisChunk[3];
+            poThreadPool->WaitCompletion( &paoJobGroups[iChunk % nSlots] );
+            psJob->bJobSubmitted = FALSE;
 
-            asThreadData[iThread].dfProgressBase = dfPixelsProcessed / dfTotalPixels;
-            asThreadData[iThread].dfProgressScale = dfChunkPixels / dfTotalPixels;
+            CPLDebug( "GDAL", "Finished chunk %d.", psJob->iChunk );
 
-            dfPixelsProcessed += dfChunkPixels;
+            eErr = psJob->eErr;
+            if( eErr != CE_None )
+                break;
+        }
 
-            asThreadData[iThread].panChunkInfo = panThisChunk;
+/* -------------------------------------------------------------------- */
+/*      Launch job for this chunk.                                      */
+/* -------------------------------------------------------------------- */
+        int *panThisChunk = panChunkList + iChunk*8;
+        double dfChunkPixels = panThisChunk[2] * (double) panThisChunk[3];
 
-            if ( iChunk == 0 )
-            {
-                asThreadData[iThread].hCond = hCond;
-                asThreadData[iThread].hCondMutex = hCondMutex;
-            }
-            else
-            {
-                asThreadData[iThread].hCond = NULL;
-                asThreadData[iThread].hCondMutex = NULL;
-            }
-            asThreadData[iThread].bIOMutexTaken = FALSE;
+        psJob->dfProgressBase = dfPixelsProcessed / dfTotalPixels;
+        psJob->dfProgressScale = dfChunkPixels / dfTotalPixels;
 
-            CPLDebug( "GDAL", "Start chunk %d.", iChunk );
-            asThreadData[iThread].hThreadHandle =
-                CPLCreateJoinableThread( ChunkThreadMain, (void*) &asThreadData[iThread] );
-            if( asThreadData[iThread].hThreadHandle == NULL )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined, 
-                          "CPLCreateJoinableThread() failed in ChunkAndWarpMulti()" );
-                eErr = CE_Failure;
-                break;
-            }
+        dfPixelsProcessed += dfChunkPixels;
 
-            /* Wait that the first thread has acquired the IO mutex before proceeding. */
-            /* (This will ensure that the first thread will run before the second one). */
-            if( iChunk == 0 )
-            {
-                CPLAcquireMutex(hCondMutex, 1.0);
-                while (asThreadData[iThread].bIOMutexTaken == FALSE)
-                    CPLCondWait(hCond, hCondMutex);
-                CPLReleaseMutex(hCondMutex);
-            }
-        }
+        psJob->panChunkInfo = panThisChunk;
+        psJob->iChunk = iChunk;
+        psJob->eErr = CE_None;
+
+        CPLDebug( "GDAL", "Start chunk %d.", iChunk );
+        psJob->bJobSubmitted = TRUE;
+        poThreadPool->SubmitJob( ChunkThreadMain, psJob,
+                                 &paoJobGroups[iChunk % nSlots] );
+    }
 
-        
 /* -------------------------------------------------------------------- */
-/*      Wait for previous chunks thread to complete.                    */
+/*      Wait for all jobs to complete, in chunk order.                  */
 /* -------------------------------------------------------------------- */
-        if( iChunk > 0 )
-        {
-            iThread = (iChunk-1) % 2;
-            
-            /* Wait for thread to finish. */
-            CPLJoinThread(asThreadData[iThread].hThreadHandle);
-            asThreadData[iThread].hThreadHandle = NULL;
+    for( iChunk = MAX(0, iChunk - nSlots); iChunk < nChunkListCount; iChunk++ )
+    {
+        GDALWarpChunkJob *psJob = pasJobs + iChunk % nSlots;
+        if( !psJob->bJobSubmitted || psJob->iChunk != iChunk )
+            continue;
 
-            CPLDebug( "GDAL", "Finished chunk %d.", iChunk-1 );
+        poThreadPool->WaitCompletion( &paoJobGroups[iChunk % nSlots] );
+        psJob->bJobSubmitted = FALSE;
 
-            eErr = asThreadData[iThread].eErr;
+        CPLDebug( "GDAL", "Finished chunk %d.", iChunk );
 
-            if( eErr != CE_None )
-                break;
-        }
+        if( eErr == CE_None )
+            eErr = psJob->eErr;
     }
 
-    /* -------------------------------------------------------------------- */
-    /*      Wait for all threads to complete.                               */
-    /* -------------------------------------------------------------------- */
-    int iThread;
-    for(iThread = 0; iThread < 2; iThread ++)
+    for( iSlot = 0; iSlot < nSlots; iSlot++ )
     {
-        if (asThreadData[iThread].hThreadHandle)
-            CPLJoinThread(asThreadData[iThread].hThreadHandle);
+        if( pasJobs[iSlot].bPrivateSrcDS )
+        {
+            GDALClose( pasJobs[iSlot].psSrcOptions->hSrcDS );
+            CPLFree( pasJobs[iSlot].psSrcOptions );
+        }
     }
+    CPLFree( pasJobs );
+    delete[] paoJobGroups;
 
-    CPLDestroyCond(hCond);
-    CPLDestroyMutex(hCondMutex);
+    CPLDestroyCond( sSync.hWriteCond );
+    CPLDestroyMutex( sSync.hWriteMutex );
+    CPLDestroyMutex( sSync.hWarpMutex );
+    CPLDestroyMutex( sSync.hIOMutex );
 
     WipeChunkList();
 
@@ -1207,6 +1454,28 @@ CPLErr GDALWarpOperation::WarpRegion( int nDstXOff, int nDstYOff,
                                       double dfProgressBase,
                                       double dfProgressScale)
 
+{
+    return WarpRegionInternal( nDstXOff, nDstYOff, nDstXSize, nDstYSize,
+                               nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
+                               dfProgressBase, dfProgressScale, NULL );
+}
+
+/************************************************************************/
+/*                         WarpRegionInternal()                         */
+/*                                                                      */
+/*      psJob is set when called from ChunkAndWarpMulti(), in which      */
+/*      case the accesses to the datasets and the warping are           */
+/*      synchronized with the other chunks in flight.                   */
+/************************************************************************/
+
+CPLErr GDALWarpOperation::WarpRegionInternal( int nDstXOff, int nDstYOff,
+                                              int nDstXSize, int nDstYSize,
+                                              int nSrcXOff, int nSrcYOff,
+                                              int nSrcXSize, int nSrcYSize,
+                                              double dfProgressBase,
+                                              double dfProgressScale,
+                                              GDALWarpChunkJob *psJob )
+
 {
     CPLErr eErr;
     int   iBand;
@@ -1308,6 +1577,11 @@ CPLErr GDALWarpOperation::WarpRegion( int nDstXOff, int nDstYOff,
 /* -------------------------------------------------------------------- */
     if( pszInitDest == NULL )
     {
+        if( !GDALWarpChunkLockDestination( psJob ) )
+        {
+            CPLFree( pDstBuffer );
+            return CE_Failure;
+        }
         eErr = GDALDatasetRasterIO( psOptions->hDstDS, GF_Read, 
                                     nDstXOff, nDstYOff, nDstXSize, nDstYSize,
                                     pDstBuffer, nDstXSize, nDstYSize, 
@@ -1315,6 +1589,7 @@ CPLErr GDALWarpOperation::WarpRegion( int nDstXOff, int nDstYOff,
                                     psOptions->nBandCount, 
                                     psOptions->panDstBands,
                                     0, 0, 0 );
+        GDALWarpChunkUnlockDestination( psJob );
 
         if( eErr != CE_None )
         {
@@ -1328,10 +1603,10 @@ CPLErr GDALWarpOperation::WarpRegion( int nDstXOff, int nDstYOff,
 /* -------------------------------------------------------------------- */
 /*      Perform the warp.                                               */
 /* -------------------------------------------------------------------- */
-    eErr = WarpRegionToBuffer( nDstXOff, nDstYOff, nDstXSize, nDstYSize, 
-                               pDstBuffer, psOptions->eWorkingDataType, 
-                               nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
-                               dfProgressBase, dfProgressScale);
+    eErr = WarpRegionToBufferInternal( nDstXOff, nDstYOff, nDstXSize, nDstYSize,
+                                       pDstBuffer, psOptions->eWorkingDataType,
+                                       nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
+                                       dfProgressBase, dfProgressScale, psJob );
 
 /* -------------------------------------------------------------------- */
 /*      Write the output data back to disk if all went well.            */
@@ -1437,6 +1712,24 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
     int nSrcXOff, int nSrcYOff, int nSrcXSize, int nSrcYSize,
     double dfProgressBase, double dfProgressScale)
 
+{
+    return WarpRegionToBufferInternal( nDstXOff, nDstYOff, nDstXSize, nDstYSize,
+                                       pDataBuf, eBufDataType,
+                                       nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize,
+                                       dfProgressBase, dfProgressScale, NULL );
+}
+
+/************************************************************************/
+/*                     WarpRegionToBufferInternal()                     */
+/************************************************************************/
+
+CPLErr GDALWarpOperation::WarpRegionToBufferInternal(
+    int nDstXOff, int nDstYOff, int nDstXSize, int nDstYSize,
+    void *pDataBuf, GDALDataType eBufDataType,
+    int nSrcXOff, int nSrcYOff, int nSrcXSize, int nSrcYSize,
+    double dfProgressBase, double dfProgressScale,
+    GDALWarpChunkJob *psJob )
+
 {
     CPLErr eErr = CE_None;
     int    i;
@@ -1445,14 +1738,25 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
     (void) eBufDataType;
     CPLAssert( eBufDataType == psOptions->eWorkingDataType );
 
+    /* Options to use for source access, possibly on a private dataset */
+    GDALWarpOptions *psSrcOptions = psJob ? psJob->psSrcOptions : psOptions;
+
 /* -------------------------------------------------------------------- */
 /*      If not given a corresponding source window compute one now.     */
+/*      The transformer is shared with the chunk being warped.          */
 /* -------------------------------------------------------------------- */
     if( nSrcXSize == 0 && nSrcYSize == 0 )
     {
+        if( psJob != NULL &&
+            !GDALWarpChunkAcquireMutex( psJob->psSync->hWarpMutex, "WarpMutex" ) )
+            return CE_Failure;
+
         eErr = ComputeSourceWindow( nDstXOff, nDstYOff, nDstXSize, nDstYSize,
                                     &nSrcXOff, &nSrcYOff, 
                                     &nSrcXSize, &nSrcYSize );
+
+        if( psJob != NULL )
+            CPLReleaseMutex( psJob->psSync->hWarpMutex );
     
         if( eErr != CE_None )
             return eErr;
@@ -1519,7 +1823,7 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
 
     if( eErr == CE_None && nSrcXSize > 0 && nSrcYSize > 0 )
         eErr = 
-            GDALDatasetRasterIO( psOptions->hSrcDS, GF_Read, 
+            GDALDatasetRasterIO( psSrcOptions->hSrcDS, GF_Read, 
                                  nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize, 
                                  oWK.papabySrcImage[0], nSrcXSize, nSrcYSize,
                                  psOptions->eWorkingDataType, 
@@ -1564,7 +1868,7 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
         
         if( eErr == CE_None )
             eErr = 
-                GDALWarpSrcAlphaMasker( psOptions, 
+                GDALWarpSrcAlphaMasker( psSrcOptions, 
                                         psOptions->nBandCount, 
                                         psOptions->eWorkingDataType,
                                         oWK.nSrcXOff, oWK.nSrcYOff, 
@@ -1613,7 +1917,10 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
 
         eErr = CreateKernelMask( &oWK, i, "DstDensity" );
         
+        if( eErr == CE_None && !GDALWarpChunkLockDestination( psJob ) )
+            eErr = CE_Failure;
         if( eErr == CE_None )
+        {
             eErr = 
                 GDALWarpDstAlphaMasker( psOptions, 
                                         psOptions->nBandCount, 
@@ -1622,6 +1929,8 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
                                         oWK.nDstXSize, oWK.nDstYSize,
                                         oWK.papabyDstImage,
                                         TRUE, oWK.pafDstDensity );
+            GDALWarpChunkUnlockDestination( psJob );
+        }
     }
     
 /* -------------------------------------------------------------------- */
@@ -1689,7 +1998,7 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
 /* -------------------------------------------------------------------- */
     GDALRasterBandH hSrcBand = NULL;
     if( psOptions->nBandCount > 0 )
-        hSrcBand = GDALGetRasterBand(psOptions->hSrcDS,
+        hSrcBand = GDALGetRasterBand(psSrcOptions->hSrcDS,
                                      psOptions->panSrcBands[0]);
     
     if( eErr == CE_None 
@@ -1702,7 +2011,7 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
         
         if( eErr == CE_None )
             eErr = 
-                GDALWarpSrcMaskMasker( psOptions, 
+                GDALWarpSrcMaskMasker( psSrcOptions, 
                                        psOptions->nBandCount, 
                                        psOptions->eWorkingDataType,
                                        oWK.nSrcXOff, oWK.nSrcYOff, 
@@ -1768,16 +2077,8 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
 /* -------------------------------------------------------------------- */
 /*      Release IO Mutex, and acquire warper mutex.                     */
 /* -------------------------------------------------------------------- */
-    if( hIOMutex != NULL )
-    {
-        CPLReleaseMutex( hIOMutex );
-        if( !CPLAcquireMutex( hWarpMutex, 600.0 ) )
-        {
-            CPLError( CE_Failure, CPLE_AppDefined, 
-                      "Failed to acquire WarpMutex in WarpRegion()." );
-            return CE_Failure;
-        }
-    }
+    if( psJob != NULL && !GDALWarpChunkBeginWarp( psJob ) )
+        eErr = CE_Failure;
 
 /* -------------------------------------------------------------------- */
 /*      Optional application provided prewarp chunk processor.          */
@@ -1803,18 +2104,11 @@ CPLErr GDALWarpOperation::WarpRegionToBuffer(
             (void *) &oWK, psOptions->pPostWarpProcessorArg );
 
 /* -------------------------------------------------------------------- */
-/*      Release Warp Mutex, and acquire io mutex.                       */
+/*      Release Warp Mutex, and acquire io mutex once the previous      */
+/*      chunks have been written.                                       */
 /* -------------------------------------------------------------------- */
-    if( hIOMutex != NULL )
-    {
-        CPLReleaseMutex( hWarpMutex );
-        if( !CPLAcquireMutex( hIOMutex, 600.0 ) )
-        {
-            CPLError( CE_Failure, CPLE_AppDefined, 
-                      "Failed to acquire IOMutex in WarpRegion()." );
-            return CE_Failure;
-        }
-    }
+    if( psJob != NULL && !GDALWarpChunkBeginWrite( psJob ) )
+        eErr = CE_Failure;
         
 /* -------------------------------------------------------------------- */
 /*      Write destination alpha if available.                           */
@@ -37,19 +37,22 @@
 #endif
 
 #include "thinplatespline.h"
+#include "cpl_multiproc.h"
+
+#include <vector>
 
 /////////////////////////////////////////////////////////////////////////////////////
 //// vizGeorefSpline2D
 /////////////////////////////////////////////////////////////////////////////////////
 
 #define A(r,c) _AA[ _nof_eqs * (r) + (c) ]
-#define Ainv(r,c) _Ainv[ _nof_eqs * (r) + (c) ]
 
 
 #define VIZ_GEOREF_SPLINE_DEBUG 0
 
 #ifndef HAVE_ARMADILLO
-static int matrixInvert( int N, double input[], double output[] );
+static int matrixSolve( int N, double* padfA, int nRHS, double** papadfB,
+                        int nThreads );
 #endif
 
 void VizGeorefSpline2D::grow_points()
@@ -359,7 +362,7 @@ static void VizGeorefSpline2DBase_func4( double* res,
 }
 #endif
 
-int VizGeorefSpline2D::solve(void)
+int VizGeorefSpline2D::solve( int nThreads )
 {
     int r, c;
     int p;
@@ -476,13 +479,10 @@ int VizGeorefSpline2D::solve(void)
     }
 	
     double* _AA = ( double * )VSICalloc( _nof_eqs * _nof_eqs, sizeof( double ) );
-    double* _Ainv = ( double * )VSICalloc( _nof_eqs * _nof_eqs, sizeof( double ) );
     
-    if( _AA == NULL || _Ainv == NULL )
+    if( _AA == NULL )
     {
         CPLError(CE_Failure, CPLE_AppDefined, "Out-of-memory while allocating temporary arrays. Computation aborted.");
-        VSIFree(_AA);
-        VSIFree(_Ainv);
         return 0;
     }
 	
@@ -523,6 +523,7 @@ int VizGeorefSpline2D::solve(void)
 
     int ret  = 4;
 #ifdef HAVE_ARMADILLO
+    (void) nThreads;
     try
     {
         arma::mat matA(_AA,_nof_eqs,_nof_eqs,false);
@@ -550,29 +551,18 @@ int VizGeorefSpline2D::solve(void)
         ret = 0;
     }
 #else
-    // Invert the matrix
-    int status = matrixInvert( _nof_eqs, _AA, _Ainv );
-			
-    if ( !status )
+    // Factorize the matrix in place and solve for the coefficients
+    for ( int v = 0; v < _nof_vars; v++ )
+        memcpy( coef[v], rhs[v], sizeof(double) * _nof_eqs );
+
+    if ( !matrixSolve( _nof_eqs, _AA, _nof_vars, coef, nThreads ) )
     {
         CPLError(CE_Failure, CPLE_AppDefined, "There is a problem to invert the interpolation matrix.");
         ret = 0;
     }
-    else
-    {
-        // calc the coefs
-        for ( int v = 0; v < _nof_vars; v++ )
-            for ( r = 0; r < _nof_eqs; r++ )
-            {
-                coef[v][r] = 0.0;
-                for ( c = 0; c < _nof_eqs; c++ )
-                    coef[v][r] += Ainv(r,c) * rhs[v][c];
-            }
-    }
 #endif
 
     VSIFree(_AA);
-    VSIFree(_Ainv);
 
     return(ret);
 }
@@ -672,141 +662,305 @@ int VizGeorefSpline2D::get_point( const double Px, const double Py, double *vars
 	return(1);
 }
 
-#ifndef HAVE_ARMADILLO
-static int matrixInvert( int N, double input[], double output[] )
+/* Number of GCPs whose coordinates and coefficients are kept in cache while */
+/* get_points() accumulates their contribution over all the points */
+#define TPS_EVAL_GCP_BLOCK 512
+
+int VizGeorefSpline2D::get_points( int nPoints,
+                                   const double *padfPx, const double *padfPy,
+                                   double **papadfVars )
 {
-    // Receives an array of dimension NxN as input.  This is passed as a one-
-    // dimensional array of N-squared size.  It produces the inverse of the
-    // input matrix, returned as output, also of size N-squared.  The Gauss-
-    // Jordan Elimination method is used.  (Adapted from a BASIC routine in
-    // "Basic Scientific Subroutines Vol. 1", courtesy of Scott Edwards.)
-	
-    // Array elements 0...N-1 are for the first row, N...2N-1 are for the
-    // second row, etc.
-	
-    // We need to have a temporary array of size N x 2N.  We'll refer to the
-    // "left" and "right" halves of this array.
-	
-    int row, col;
-	
-#if 0
-    fprintf(stderr, "Matrix Inversion input matrix (N=%d)\n", N);
-    for ( row=0; row<N; row++ )
+    int i, v, r;
+
+    if ( type != VIZ_GEOREF_SPLINE_FULL )
     {
-        for ( col=0; col<N; col++ )
+        int ret = 1;
+        for ( i = 0; i < nPoints; i++ )
         {
-            fprintf(stderr, "%5.2f ", input[row*N + col ]  );
+            double vars[VIZGEOREF_MAX_VARS];
+            if ( !get_point( padfPx[i], padfPy[i], vars ) )
+                ret = 0;
+            for ( v = 0; v < _nof_vars; v++ )
+                papadfVars[v][i] = vars[v];
         }
-        fprintf(stderr, "\n");
+        return ret;
     }
-#endif
-	
-    int tempSize = 2 * N * N;
-    double* temp = (double*) new double[ tempSize ];
-    double ftemp;
-	
-    if (temp == 0) {
-		
-        CPLError(CE_Failure, CPLE_AppDefined, "matrixInvert(): ERROR - memory allocation failed.");
-        return false;
+
+    // Same computation as get_point(), but the loop on the GCPs is split
+    // in blocks that are applied to all the points, so that the GCP
+    // arrays are read from memory once per block and not once per point.
+    // The terms are accumulated in the same order, so the results are
+    // the ones of get_point().
+    for ( i = 0; i < nPoints; i++ )
+        for ( v = 0; v < _nof_vars; v++ )
+            papadfVars[v][i] = coef[v][0] + coef[v][1] * padfPx[i] +
+                               coef[v][2] * padfPy[i];
+
+    const int nPoints4 = _nof_points & (~3);
+    for ( int r0 = 0; r0 < nPoints4; r0 += TPS_EVAL_GCP_BLOCK )
+    {
+        const int r1 = MIN( r0 + TPS_EVAL_GCP_BLOCK, nPoints4 );
+        for ( i = 0; i < nPoints; i++ )
+        {
+            double Pxy[2] = { padfPx[i], padfPy[i] };
+            double vars[VIZGEOREF_MAX_VARS];
+            for ( v = 0; v < _nof_vars; v++ )
+                vars[v] = papadfVars[v][i];
+            for ( r = r0; r < r1; r += 4 )
+            {
+                double tmp[4];
+                VizGeorefSpline2DBase_func4( tmp, Pxy, &x[r], &y[r] );
+                for ( v = 0; v < _nof_vars; v++ )
+                    vars[v] += coef[v][r+3] * tmp[0] +
+                            coef[v][r+3+1] * tmp[1] +
+                            coef[v][r+3+2] * tmp[2] +
+                            coef[v][r+3+3] * tmp[3];
+            }
+            for ( v = 0; v < _nof_vars; v++ )
+                papadfVars[v][i] = vars[v];
+        }
     }
-	
-    // First create a double-width matrix with the input array on the left
-    // and the identity matrix on the right.
-	
-    for ( row=0; row<N; row++ )
+
+    for ( i = 0; i < nPoints; i++ )
     {
-        for ( col=0; col<N; col++ )
+        for ( r = nPoints4; r < _nof_points; r++ )
         {
-            // Our index into the temp array is X2 because it's twice as wide
-            // as the input matrix.
-			
-            temp[ 2*row*N + col ] = input[ row*N+col ];	// left = input matrix
-            temp[ 2*row*N + col + N ] = 0.0f;			// right = 0
+            double tmp = VizGeorefSpline2DBase_func( padfPx[i], padfPy[i],
+                                                     x[r], y[r] );
+            for ( v = 0; v < _nof_vars; v++ )
+                papadfVars[v][i] += coef[v][r+3] * tmp;
         }
-        temp[ 2*row*N + row + N ] = 1.0f;		// 1 on the diagonal of RHS
     }
-	
-    // Now perform row-oriented operations to convert the left hand side
-    // of temp to the identity matrix.  The inverse of input will then be
-    // on the right.
-	
-    int max;
-    int k=0;
-    for (k = 0; k < N; k++)
+
+    return 1;
+}
+
+#ifndef HAVE_ARMADILLO
+
+/* Width of the column panels of the blocked LU factorization */
+#define TPS_LU_BLOCK_SIZE        64
+/* Width of the column tiles of the trailing update, so that the rows of */
+/* the current panel that are read by the update remain in cache */
+#define TPS_LU_UPDATE_TILE       256
+/* Minimum number of trailing rows given to a worker thread */
+#define TPS_LU_MIN_ROWS_PER_JOB  128
+
+typedef struct
+{
+    int     N;
+    double *padfA;
+    int     nK0;
+    int     nKB;
+    int     nRowStart;
+    int     nRowEnd;
+} TPSLUUpdateJob;
+
+/************************************************************************/
+/*                        matrixLUUpdateRows()                          */
+/*                                                                      */
+/*      Subtract L21 * U12 from rows [nRowStart, nRowEnd[ of the        */
+/*      trailing matrix once the panel [nK0, nK0+nKB[ is factorized.    */
+/************************************************************************/
+
+static void matrixLUUpdateRows( void* pData )
+{
+    TPSLUUpdateJob* psJob = (TPSLUUpdateJob*) pData;
+    const int N = psJob->N;
+    double* const padfA = psJob->padfA;
+    const int nK0 = psJob->nK0;
+    const int nKEnd = psJob->nK0 + psJob->nKB;
+
+    for( int nCol0 = nKEnd; nCol0 < N; nCol0 += TPS_LU_UPDATE_TILE )
     {
-        if (k+1 < N)	// if not on the last row
-        {              
-            max = k;
-            for (row = k+1; row < N; row++) // find the maximum element
-            {  
-                if (fabs( temp[row*2*N + k] ) > fabs( temp[max*2*N + k] ))
+        const int nCol1 = MIN(nCol0 + TPS_LU_UPDATE_TILE, N);
+        for( int i = psJob->nRowStart; i < psJob->nRowEnd; i++ )
+        {
+            double* padfRow = padfA + (size_t)i * N;
+            int k = nK0;
+            for( ; k + 3 < nKEnd; k += 4 )
+            {
+                const double l0 = padfRow[k];
+                const double l1 = padfRow[k+1];
+                const double l2 = padfRow[k+2];
+                const double l3 = padfRow[k+3];
+                const double* r0 = padfA + (size_t)k * N;
+                const double* r1 = r0 + N;
+                const double* r2 = r1 + N;
+                const double* r3 = r2 + N;
+                for( int j = nCol0; j < nCol1; j++ )
+                    padfRow[j] -= l0 * r0[j] + l1 * r1[j] +
+                                  l2 * r2[j] + l3 * r3[j];
+            }
+            for( ; k < nKEnd; k++ )
+            {
+                const double l = padfRow[k];
+                const double* r = padfA + (size_t)k * N;
+                for( int j = nCol0; j < nCol1; j++ )
+                    padfRow[j] -= l * r[j];
+            }
+        }
+    }
+}
+
+/************************************************************************/
+/*                            matrixSolve()                             */
+/************************************************************************/
+
+static int matrixSolve( int N, double* padfA, int nRHS, double** papadfB,
+                        int nThreads )
+{
+    // Solves A * X = B for nRHS right-hand sides, A being a NxN row-major
+    // matrix and each papadfB[v] an array of N values that is replaced by
+    // the solution.  A is overwritten by its LU factorization.
+    //
+    // A right-looking blocked LU factorization with partial pivoting is
+    // used : each panel of TPS_LU_BLOCK_SIZE columns is factorized, and
+    // the trailing matrix is then updated with a rank-TPS_LU_BLOCK_SIZE
+    // product, which is where almost all the time goes and which is
+    // split in bands of rows between worker threads.  This needs N^2
+    // doubles and 2/3 N^3 flops, instead of the 2 N^2 doubles for the
+    // temporary array and the ~3 N^3 flops of the Gauss-Jordan inversion
+    // used previously.
+
+    CPLWorkerThreadPool* poThreadPool = NULL;
+    if( nThreads > 1 && N >= 2 * TPS_LU_MIN_ROWS_PER_JOB )
+        poThreadPool = CPLGetWorkerThreadPool( nThreads - 1 );
+
+    std::vector<TPSLUUpdateJob> asJobs( MAX(nThreads, 1) );
+
+    for( int nK0 = 0; nK0 < N; nK0 += TPS_LU_BLOCK_SIZE )
+    {
+        const int nKB = MIN(TPS_LU_BLOCK_SIZE, N - nK0);
+        const int nKEnd = nK0 + nKB;
+
+/* -------------------------------------------------------------------- */
+/*      Factorize the panel made of columns [nK0, nKEnd[.               */
+/* -------------------------------------------------------------------- */
+        for( int j = nK0; j < nKEnd; j++ )
+        {
+            int nPivot = j;
+            double dfMax = fabs( padfA[(size_t)j * N + j] );
+            for( int i = j + 1; i < N; i++ )
+            {
+                const double dfVal = fabs( padfA[(size_t)i * N + j] );
+                if( dfVal > dfMax )
                 {
-                    max = row;
+                    dfMax = dfVal;
+                    nPivot = i;
                 }
             }
-			
-            if (max != k)	// swap all the elements in the two rows
-            {        
-                for (col=k; col<2*N; col++)
+
+            if( dfMax == 0.0 ) // matrix is singular
+                return FALSE;
+
+            double* padfRowJ = padfA + (size_t)j * N;
+            if( nPivot != j )
+            {
+                double* padfRowP = padfA + (size_t)nPivot * N;
+                for( int c = 0; c < N; c++ )
+                {
+                    const double dfTmp = padfRowJ[c];
+                    padfRowJ[c] = padfRowP[c];
+                    padfRowP[c] = dfTmp;
+                }
+                for( int v = 0; v < nRHS; v++ )
                 {
-                    ftemp = temp[k*2*N + col];
-                    temp[k*2*N + col] = temp[max*2*N + col];
-                    temp[max*2*N + col] = ftemp;
+                    const double dfTmp = papadfB[v][j];
+                    papadfB[v][j] = papadfB[v][nPivot];
+                    papadfB[v][nPivot] = dfTmp;
                 }
             }
+
+            const double dfPivot = padfRowJ[j];
+            for( int i = j + 1; i < N; i++ )
+            {
+                double* padfRowI = padfA + (size_t)i * N;
+                const double l = (padfRowI[j] /= dfPivot);
+                if( l == 0.0 )
+                    continue;
+                for( int c = j + 1; c < nKEnd; c++ )
+                    padfRowI[c] -= l * padfRowJ[c];
+            }
         }
-		
-        ftemp = temp[ k*2*N + k ];
-        if ( ftemp == 0.0f ) // matrix cannot be inverted
+
+        if( nKEnd == N )
+            break;
+
+/* -------------------------------------------------------------------- */
+/*      Compute the U12 block : rows [nK0, nKEnd[ right of the panel.   */
+/* -------------------------------------------------------------------- */
+        for( int j = nK0; j < nKEnd; j++ )
         {
-            delete[] temp;
-            return false;
+            const double* padfRowJ = padfA + (size_t)j * N;
+            for( int i = j + 1; i < nKEnd; i++ )
+            {
+                double* padfRowI = padfA + (size_t)i * N;
+                const double l = padfRowI[j];
+                if( l == 0.0 )
+                    continue;
+                for( int c = nKEnd; c < N; c++ )
+                    padfRowI[c] -= l * padfRowJ[c];
+            }
         }
-		
-        for ( col=k; col<2*N; col++ )
+
+/* -------------------------------------------------------------------- */
+/*      Update the trailing matrix, in parallel if possible.            */
+/* -------------------------------------------------------------------- */
+        const int nRows = N - nKEnd;
+        int nJobs = 1;
+        if( poThreadPool != NULL )
+            nJobs = MAX(1, MIN(nThreads, nRows / TPS_LU_MIN_ROWS_PER_JOB));
+
+        for( int iJob = 0; iJob < nJobs; iJob++ )
         {
-            temp[ k*2*N + col ] /= ftemp;
+            asJobs[iJob].N = N;
+            asJobs[iJob].padfA = padfA;
+            asJobs[iJob].nK0 = nK0;
+            asJobs[iJob].nKB = nKB;
+            asJobs[iJob].nRowStart =
+                nKEnd + (int)((GIntBig)nRows * iJob / nJobs);
+            asJobs[iJob].nRowEnd =
+                nKEnd + (int)((GIntBig)nRows * (iJob + 1) / nJobs);
         }
-		
-        int i2 = k*2*N ;
-        for ( row=0; row<N; row++ )
+
+        if( nJobs == 1 )
+            matrixLUUpdateRows( &asJobs[0] );
+        else
         {
-            if ( row != k )
-            {
-                int i1 = row*2*N;
-                ftemp = temp[ i1 + k ];
-                for ( col=k; col<2*N; col++ ) 
-                {
-                    temp[ i1 + col ] -= ftemp * temp[ i2 + col ];
-                }
-            }
+            CPLJobGroup oJobGroup;
+            for( int iJob = 1; iJob < nJobs; iJob++ )
+                poThreadPool->SubmitJob( matrixLUUpdateRows, &asJobs[iJob],
+                                         &oJobGroup );
+            matrixLUUpdateRows( &asJobs[0] );
+            poThreadPool->WaitCompletion( &oJobGroup );
         }
     }
-	
-    // Retrieve inverse from the right side of temp
-	
-    for (row = 0; row < N; row++)
+
+/* -------------------------------------------------------------------- */
+/*      Forward substitution with the unit lower triangular L, then     */
+/*      back substitution with U.                                       */
+/* -------------------------------------------------------------------- */
+    for( int v = 0; v < nRHS; v++ )
     {
-        for (col = 0; col < N; col++)
+        double* padfB = papadfB[v];
+        for( int i = 1; i < N; i++ )
         {
-            output[row*N + col] = temp[row*2*N + col + N ];
+            const double* padfRowI = padfA + (size_t)i * N;
+            double dfSum = padfB[i];
+            for( int k = 0; k < i; k++ )
+                dfSum -= padfRowI[k] * padfB[k];
+            padfB[i] = dfSum;
         }
-    }
-	
-#if 0
-    fprintf(stderr, "Matrix Inversion result matrix:\n");
-    for ( row=0; row<N; row++ )
-    {
-        for ( col=0; col<N; col++ )
+        for( int i = N - 1; i >= 0; i-- )
         {
-            fprintf(stderr, "%5.2f ", output[row*N + col ]  );
+            const double* padfRowI = padfA + (size_t)i * N;
+            double dfSum = padfB[i];
+            for( int k = i + 1; k < N; k++ )
+                dfSum -= padfRowI[k] * padfB[k];
+            padfB[i] = dfSum / padfRowI[i];
         }
-        fprintf(stderr, "\n");
     }
-#endif
-	
-    delete [] temp;       // free memory
-    return true;
+
+    return TRUE;
 }
 #endif
@@ -135,13 +135,15 @@ class VizGeorefSpline2D
     void grow_points();
     int add_point( const double Px, const double Py, const double *Pvars );
     int get_point( const double Px, const double Py, double *Pvars );
+    int get_points( int nPoints, const double *padfPx, const double *padfPy,
+                    double **papadfVars );
 #if 0
     int delete_point(const double Px, const double Py );
     bool get_xy(int index, double& x, double& y);
     bool change_point(int index, double x, double y, double* Pvars);
     void reset(void) { _nof_points = 0; }
 #endif
-    int solve(void);
+    int solve( int nThreads = 1 );
 
   private:	
 
@@ -123,7 +123,11 @@ available GCPs.</dd>
 <dt> <b>-rpc</b>:</dt> <dd>Force use of RPCs.</dd>
 <dt> <b>-geoloc</b>:</dt><dd>Force use of Geolocation Arrays.</dd>
 <dt> <b>-et</b> <em>err_threshold</em>:</dt><dd> error threshold for
-transformation approximation (in pixel units - defaults to 0.125).</dd>
+transformation approximation (in pixel units - defaults to 0.125).
+Starting with GDAL 2.0, setting the GDAL_APPROX_TRANSFORMER_2D configuration
+option to YES approximates the transformation on a 2D grid of cells instead of
+scanline by scanline, which saves most of the exact transformations for
+expensive transformers (RPC, geolocation arrays, ...).</dd>
 <dt> <b>-refine_gcps</b> <em>tolerance minimum_gcps</em>:</dt><dd>  (GDAL >= 1.9.0) refines the GCPs by automatically eliminating outliers.
 Outliers will be eliminated until minimum_gcps are left or when no outliers can be detected.
 The tolerance is passed to adjust when a GCP will be eliminated.
@@ -176,7 +180,10 @@ nodata (unset/transparent) pixels. </dd>
 megabytes) that the warp API is allowed to use for caching.</dd>
 <dt> <b>-multi</b>:</dt><dd> Use multithreaded warping implementation.
 Multiple threads will be used to process chunks of image and perform
-input/output operation simultaneously.</dd>
+input/output operation simultaneously. The number of chunks processed at
+the same time is set by the NUM_THREADS warping option (or the
+GDAL_NUM_THREADS configuration option), with a minimum of 2. The memory
+set with <b>-wm</b> is shared between those chunks.</dd>
 <dt> <b>-q</b>:</dt><dd> Be quiet.</dd>
 <dt> <b>-of</b> <em>format</em>:</dt><dd> Select the output format. The default is GeoTIFF (GTiff). Use the short format name. </dd>
 <dt> <b>-co</b> <em>"NAME=VALUE"</em>:</dt><dd> passes a creation option to
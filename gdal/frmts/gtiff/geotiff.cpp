@@ -247,6 +247,95 @@ enum
     ENDIANNESS_BIG
 };
 
+/************************************************************************/
+/*                         GTiffCompressionJob                          */
+/*                                                                      */
+/*      Strip/tile compressed by a worker thread (see NUM_THREADS).     */
+/************************************************************************/
+
+struct GTiffCompressionJob
+{
+    CPLJobGroup     oJobGroup;
+    CPLString       osTmpFilename;
+    int             bPending;
+    int             bSuccess;
+
+    int             nStripOrTile;
+    GByte          *pabyBuffer;
+    int             nBufferSize;
+    int             nBufferAlloc;
+
+    int             bBigEndian;
+    uint32          nWidth;
+    uint32          nHeight;
+    uint16          nCompression;
+    uint16          nPredictor;
+    uint16          nPhotometric;
+    uint16          nBitsPerSample;
+    uint16          nSampleFormat;
+    uint16          nSamplesPerPixel;
+    uint16          nYCbCrSubH;
+    uint16          nYCbCrSubV;
+    int             nZLevel;
+    int             nLZMAPreset;
+    int             nJpegQuality;
+    int             nJpegColorMode;
+
+    toff_t          nCompressedOffset;
+    toff_t          nCompressedSize;
+};
+
+/************************************************************************/
+/*                           GTiffReadHandle                            */
+/*                                                                      */
+/*      Additional handle on the file used by a decompression job.      */
+/************************************************************************/
+
+struct GTiffReadHandle
+{
+    VSILFILE       *fpL;
+    TIFF           *hTIFF;
+    int             bInUse;
+};
+
+/************************************************************************/
+/*                           GTiffDecodeJob                             */
+/*                                                                      */
+/*      Strip/tile decompressed by a worker thread into the block       */
+/*      cache, for RasterIO() requests covering several blocks.         */
+/************************************************************************/
+
+/************************************************************************/
+/*                             GTiffRange                               */
+/************************************************************************/
+
+typedef struct
+{
+    vsi_l_offset    nOffset;
+    size_t          nSize;
+} GTiffRange;
+
+static int GTiffRangeCompare( const void* pA, const void* pB )
+{
+    vsi_l_offset nA = ((const GTiffRange*) pA)->nOffset;
+    vsi_l_offset nB = ((const GTiffRange*) pB)->nOffset;
+    return (nA < nB) ? -1 : (nA > nB) ? 1 : 0;
+}
+
+class GTiffDataset;
+
+struct GTiffDecodeJob
+{
+    GTiffDataset      *poDS;
+    int                nBlockId;
+    int                nBlockBufSize;
+    int                nBlockReqSize;
+    int                nJpegColorMode;
+    int                bSuccess;
+    GByte            **papabyDest;  /* per band, NULL if already cached */
+    GDALRasterBlock  **papoBlocks;
+};
+
 /************************************************************************/
 /* ==================================================================== */
 /*				GTiffDataset				*/
@@ -371,6 +460,39 @@ class GTiffDataset : public GDALPamDataset
     int          WriteEncodedTile(uint32 tile, GByte* pabyData, int bPreserveDataBuffer);
     int          WriteEncodedStrip(uint32 strip, GByte* pabyData, int bPreserveDataBuffer);
 
+    /* Multi-threaded (de)compression of strips/tiles (NUM_THREADS) */
+    int           nNumThreads;
+    CPLWorkerThreadPool *poThreadPool;
+    GTiffCompressionJob *pasCompressionJobs;
+    int           nCompressionJobs;
+    int           iNextCompressionJob;
+    int           nPendingCompressionJobs;
+    void          InitNumThreads( char** papszOptions,
+                                  int bUseConfigOption = TRUE );
+    int           SubmitCompressionJob( int nStripOrTile, GByte* pabyData,
+                                        int cc, int nHeight );
+    CPLErr        FinishCompressionJob( GTiffCompressionJob* psJob );
+    CPLErr        WaitCompressionJobs();
+
+    void         *hReadHandlesMutex;
+    int           nReadHandles;
+    GTiffReadHandle **papsReadHandles;
+    GTiffReadHandle *AcquireReadHandle( int nJpegColorMode );
+    void          ReleaseReadHandle( GTiffReadHandle* psHandle );
+    static void   DecodeJobRun( void* pData );
+    void          CacheBlocksMultiThreaded( int nXOff, int nYOff,
+                                            int nXSize, int nYSize,
+                                            int nBandCount, int *panBandMap );
+
+    int           nCachedRanges;
+    void        **ppCachedData;
+    vsi_l_offset *panCachedOffsets;
+    size_t       *panCachedSizes;
+    int           CacheMultiRange( int nXOff, int nYOff,
+                                   int nXSize, int nYSize,
+                                   int nBandCount, int *panBandMap );
+    void          ClearCachedRanges();
+
     GTiffDataset* poMaskDS;
     GTiffDataset* poBaseDS;
 
@@ -764,7 +886,7 @@ CPLErr GTiffJPEGOverviewBand::IReadBlock( int nBlockXOff, int nBlockYOff, void *
             VSIFWriteL(&ch, 1, 1, fp);
             GByte* pabyBuffer = VSIGetMemFileBuffer( poGDS->osTmpFilename, NULL, FALSE);
             memcpy(pabyBuffer, poGDS->pabyJPEGTable, poGDS->nJPEGTableSize);
-            VSILFILE* fpTIF = (VSILFILE*) TIFFClientdata( hTIFF );
+            VSILFILE* fpTIF = VSI_TIFFGetVSILFile( TIFFClientdata( hTIFF ) );
             VSIFSeekL(fpTIF, nOffset, SEEK_SET);
             VSIFReadL(pabyBuffer + poGDS->nJPEGTableSize, 1, (size_t)nByteCount, fpTIF);
         }
@@ -1284,7 +1406,7 @@ CPLErr GTiffRasterBand::DirectIO( GDALRWFlag eRWFlag,
     /* Extract data from the file */
     if (eErr == CE_None)
     {
-        VSILFILE* fp = (VSILFILE*) TIFFClientdata( poGDS->hTIFF );
+        VSILFILE* fp = VSI_TIFFGetVSILFile( TIFFClientdata( poGDS->hTIFF ) );
         int nRet = VSIFReadMultiRangeL(nReqYSize, ppData, panOffsets, panSizes, fp);
         if (nRet != 0)
             eErr = CE_Failure;
@@ -1440,7 +1562,7 @@ CPLVirtualMem* GTiffRasterBand::GetVirtualMemAutoInternal( GDALRWFlag eRWFlag,
         }
     }
 
-    VSILFILE* fp = (VSILFILE*) TIFFClientdata( poGDS->hTIFF );
+    VSILFILE* fp = VSI_TIFFGetVSILFile( TIFFClientdata( poGDS->hTIFF ) );
 
     vsi_l_offset nLength = (vsi_l_offset)nRasterYSize * nLineSize;
 
@@ -1660,12 +1782,25 @@ CPLErr GTiffDataset::IRasterIO( GDALRWFlag eRWFlag,
         }
     }
 
+    int bCachedRanges = FALSE;
+    if( eRWFlag == GF_Read && nXSize == nBufXSize && nYSize == nBufYSize )
+    {
+        bCachedRanges = CacheMultiRange( nXOff, nYOff, nXSize, nYSize,
+                                         nBandCount, panBandMap );
+        CacheBlocksMultiThreaded( nXOff, nYOff, nXSize, nYSize,
+                                  nBandCount, panBandMap );
+    }
+
     nJPEGOverviewVisibilityFlag ++;
     eErr =  GDALPamDataset::IRasterIO(
                 eRWFlag, nXOff, nYOff, nXSize, nYSize,
                 pData, nBufXSize, nBufYSize, eBufType,
                 nBandCount, panBandMap, nPixelSpace, nLineSpace, nBandSpace);
     nJPEGOverviewVisibilityFlag --;
+
+    if( bCachedRanges )
+        ClearCachedRanges();
+
     return eErr;
 }
 
@@ -1721,12 +1856,24 @@ CPLErr GTiffRasterBand::IRasterIO( GDALRWFlag eRWFlag,
         }
     }
 
+    int bCachedRanges = FALSE;
+    if( eRWFlag == GF_Read && nXSize == nBufXSize && nYSize == nBufYSize )
+    {
+        bCachedRanges = poGDS->CacheMultiRange( nXOff, nYOff, nXSize, nYSize,
+                                                1, &nBand );
+        poGDS->CacheBlocksMultiThreaded( nXOff, nYOff, nXSize, nYSize,
+                                         1, &nBand );
+    }
+
     poGDS->nJPEGOverviewVisibilityFlag ++;
     eErr = GDALPamRasterBand::IRasterIO(eRWFlag, nXOff, nYOff, nXSize, nYSize,
                                         pData, nBufXSize, nBufYSize, eBufType,
                                         nPixelSpace, nLineSpace);
     poGDS->nJPEGOverviewVisibilityFlag --;
 
+    if( bCachedRanges )
+        poGDS->ClearCachedRanges();
+
     poGDS->bLoadingOtherBands = FALSE;
 
     return eErr;
@@ -4091,6 +4238,22 @@ GTiffDataset::GTiffDataset()
     nTempWriteBufferSize = 0;
     pabyTempWriteBuffer = NULL;
 
+    nNumThreads = 0;
+    poThreadPool = NULL;
+    pasCompressionJobs = NULL;
+    nCompressionJobs = 0;
+    iNextCompressionJob = 0;
+    nPendingCompressionJobs = 0;
+
+    hReadHandlesMutex = NULL;
+    nReadHandles = 0;
+    papsReadHandles = NULL;
+
+    nCachedRanges = 0;
+    ppCachedData = NULL;
+    panCachedOffsets = NULL;
+    panCachedSizes = NULL;
+
     poMaskDS = NULL;
     poBaseDS = NULL;
 
@@ -4244,6 +4407,38 @@ int GTiffDataset::Finalize()
         delete poColorTable;
     poColorTable = NULL;
 
+    if( pasCompressionJobs != NULL )
+    {
+        /* Normally already written by FlushCache() */
+        for( int i = 0; i < nCompressionJobs; i++ )
+        {
+            if( pasCompressionJobs[i].bPending )
+            {
+                poThreadPool->WaitCompletion(
+                                        &(pasCompressionJobs[i].oJobGroup) );
+                VSIUnlink( pasCompressionJobs[i].osTmpFilename );
+            }
+            CPLFree( pasCompressionJobs[i].pabyBuffer );
+        }
+        delete[] pasCompressionJobs;
+        pasCompressionJobs = NULL;
+        nCompressionJobs = 0;
+        nPendingCompressionJobs = 0;
+    }
+
+    for( int i = 0; i < nReadHandles; i++ )
+    {
+        XTIFFClose( papsReadHandles[i]->hTIFF );
+        VSIFCloseL( papsReadHandles[i]->fpL );
+        CPLFree( papsReadHandles[i] );
+    }
+    CPLFree( papsReadHandles );
+    papsReadHandles = NULL;
+    nReadHandles = 0;
+    if( hReadHandlesMutex != NULL )
+        CPLDestroyMutex( hReadHandlesMutex );
+    hReadHandlesMutex = NULL;
+
     if( bBase || bCloseTIFFHandle )
     {
         XTIFFClose( hTIFF );
@@ -4369,6 +4564,10 @@ void GTiffDataset::FillEmptyTiles()
     if (!SetDirectory())
         return;
 
+    /* Blocks still being compressed are not yet accounted in the byte counts */
+    if( WaitCompressionJobs() != CE_None )
+        return;
+
 /* -------------------------------------------------------------------- */
 /*      How many blocks are there in this file?                         */
 /* -------------------------------------------------------------------- */
@@ -4425,6 +4624,880 @@ void GTiffDataset::FillEmptyTiles()
     CPLFree( pabyData );
 }
 
+/************************************************************************/
+/* ==================================================================== */
+/*                     Multi-threaded compression                       */
+/* ==================================================================== */
+/*                                                                      */
+/*      When NUM_THREADS is set, strips/tiles are compressed by the     */
+/*      worker thread pool. Each job encodes its block as the single    */
+/*      strip of a temporary in-memory TIFF file sharing the codec      */
+/*      settings of the dataset, and the main thread then copies the    */
+/*      compressed bytes with TIFFWriteRawTile/Strip(), in submission   */
+/*      order.                                                          */
+/************************************************************************/
+
+/************************************************************************/
+/*                       GTiffCompressionJobRun()                       */
+/************************************************************************/
+
+static void GTiffCompressionJobRun( void* pData )
+
+{
+    GTiffCompressionJob* psJob = (GTiffCompressionJob*) pData;
+
+    psJob->bSuccess = FALSE;
+
+    VSILFILE* fpTmp = VSIFOpenL( psJob->osTmpFilename, "w+b" );
+    if( fpTmp == NULL )
+        return;
+
+    TIFF* hTIFFTmp = VSI_TIFFOpen( psJob->osTmpFilename,
+                                   psJob->bBigEndian ? "w+b" : "w+l", fpTmp );
+    if( hTIFFTmp == NULL )
+    {
+        VSIFCloseL( fpTmp );
+        return;
+    }
+
+    TIFFSetField( hTIFFTmp, TIFFTAG_IMAGEWIDTH, psJob->nWidth );
+    TIFFSetField( hTIFFTmp, TIFFTAG_IMAGELENGTH, psJob->nHeight );
+    TIFFSetField( hTIFFTmp, TIFFTAG_ROWSPERSTRIP, psJob->nHeight );
+    TIFFSetField( hTIFFTmp, TIFFTAG_BITSPERSAMPLE, psJob->nBitsPerSample );
+    TIFFSetField( hTIFFTmp, TIFFTAG_SAMPLEFORMAT, psJob->nSampleFormat );
+    TIFFSetField( hTIFFTmp, TIFFTAG_SAMPLESPERPIXEL, psJob->nSamplesPerPixel );
+    TIFFSetField( hTIFFTmp, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG );
+    TIFFSetField( hTIFFTmp, TIFFTAG_PHOTOMETRIC, psJob->nPhotometric );
+    TIFFSetField( hTIFFTmp, TIFFTAG_COMPRESSION, psJob->nCompression );
+
+    if( psJob->nPredictor != PREDICTOR_NONE )
+        TIFFSetField( hTIFFTmp, TIFFTAG_PREDICTOR, psJob->nPredictor );
+    if( psJob->nZLevel > 0 )
+        TIFFSetField( hTIFFTmp, TIFFTAG_ZIPQUALITY, psJob->nZLevel );
+    if( psJob->nLZMAPreset > 0 )
+        TIFFSetField( hTIFFTmp, TIFFTAG_LZMAPRESET, psJob->nLZMAPreset );
+
+    if( psJob->nCompression == COMPRESSION_JPEG )
+    {
+        if( psJob->nPhotometric == PHOTOMETRIC_YCBCR )
+        {
+            TIFFSetField( hTIFFTmp, TIFFTAG_YCBCRSUBSAMPLING,
+                          psJob->nYCbCrSubH, psJob->nYCbCrSubV );
+        }
+        if( psJob->nJpegQuality > 0 )
+            TIFFSetField( hTIFFTmp, TIFFTAG_JPEGQUALITY, psJob->nJpegQuality );
+        if( psJob->nJpegColorMode >= 0 )
+            TIFFSetField( hTIFFTmp, TIFFTAG_JPEGCOLORMODE, psJob->nJpegColorMode );
+
+        /* The main file has no shared JPEGTables for these blocks, so */
+        /* each of them must carry its own tables. */
+        TIFFSetField( hTIFFTmp, TIFFTAG_JPEGTABLESMODE, 0 );
+    }
+
+    if( TIFFWriteEncodedStrip( hTIFFTmp, 0, psJob->pabyBuffer,
+                               psJob->nBufferSize ) != -1 )
+    {
+        toff_t *panOffsets = NULL, *panByteCounts = NULL;
+
+        if( TIFFGetField( hTIFFTmp, TIFFTAG_STRIPOFFSETS, &panOffsets ) &&
+            TIFFGetField( hTIFFTmp, TIFFTAG_STRIPBYTECOUNTS, &panByteCounts ) &&
+            panOffsets != NULL && panByteCounts != NULL )
+        {
+            psJob->nCompressedOffset = panOffsets[0];
+            psJob->nCompressedSize = panByteCounts[0];
+            psJob->bSuccess = TRUE;
+        }
+    }
+
+    XTIFFClose( hTIFFTmp );
+    VSIFCloseL( fpTmp );
+}
+
+/************************************************************************/
+/*                           InitNumThreads()                           */
+/*                                                                      */
+/*      Fetch the number of (de)compression threads from the            */
+/*      NUM_THREADS creation or open option, or, if bUseConfigOption    */
+/*      is set, from GDAL_NUM_THREADS otherwise.                        */
+/************************************************************************/
+
+void GTiffDataset::InitNumThreads( char** papszOptions, int bUseConfigOption )
+
+{
+    const char* pszValue = CSLFetchNameValue( papszOptions, "NUM_THREADS" );
+    if( pszValue == NULL && bUseConfigOption )
+        pszValue = CPLGetConfigOption( "GDAL_NUM_THREADS", NULL );
+    if( pszValue == NULL )
+        return;
+
+    if( EQUAL(pszValue, "ALL_CPUS") )
+        nNumThreads = CPLGetNumCPUs();
+    else
+        nNumThreads = atoi(pszValue);
+    if( nNumThreads > 128 )
+        nNumThreads = 128;
+    if( nNumThreads > 1 )
+        CPLDebug( "GTiff", "Using up to %d threads for (de)compression",
+                  nNumThreads );
+}
+
+/************************************************************************/
+/*                        SubmitCompressionJob()                        */
+/*                                                                      */
+/*      Queue the compression of a strip/tile of nHeight rows whose     */
+/*      uncompressed content is pabyData[0..cc-1]. Returns FALSE if     */
+/*      the block must be written synchronously by the caller, and -1   */
+/*      if writing a previously compressed block failed.                */
+/************************************************************************/
+
+int GTiffDataset::SubmitCompressionJob( int nStripOrTile, GByte* pabyData,
+                                        int cc, int nHeight )
+
+{
+    if( nNumThreads <= 1 )
+        return FALSE;
+
+    if( nCompression != COMPRESSION_ADOBE_DEFLATE &&
+        nCompression != COMPRESSION_DEFLATE &&
+        nCompression != COMPRESSION_LZW &&
+        nCompression != COMPRESSION_PACKBITS &&
+        nCompression != COMPRESSION_LZMA &&
+        nCompression != COMPRESSION_JPEG )
+        return FALSE;
+
+    /* Subsampled YCbCr data is only supported through the JPEG codec */
+    /* converting from RGB */
+    if( nPhotometric == PHOTOMETRIC_YCBCR &&
+        nCompression != COMPRESSION_JPEG )
+        return FALSE;
+
+    if( pasCompressionJobs == NULL )
+    {
+        poThreadPool = CPLGetWorkerThreadPool( nNumThreads );
+        if( poThreadPool == NULL )
+        {
+            nNumThreads = 0;
+            return FALSE;
+        }
+
+        /* Allow a few blocks in advance per thread so that workers do */
+        /* not starve while the main thread writes */
+        nCompressionJobs = 2 * nNumThreads;
+        pasCompressionJobs = new GTiffCompressionJob[nCompressionJobs];
+        for( int i = 0; i < nCompressionJobs; i++ )
+        {
+            GTiffCompressionJob* psJob = &pasCompressionJobs[i];
+            psJob->osTmpFilename.Printf( "/vsimem/gtiff/compress_%p", psJob );
+            psJob->bPending = FALSE;
+            psJob->bSuccess = FALSE;
+            psJob->pabyBuffer = NULL;
+            psJob->nBufferSize = 0;
+            psJob->nBufferAlloc = 0;
+        }
+        iNextCompressionJob = 0;
+
+        /* TIFFWriteRawTile/Strip() do not allocate the libtiff raw data */
+        /* buffer, which later block reads on a new file would need. */
+        TIFFWriteBufferSetup( hTIFF, NULL, -1 );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Wait for the oldest job if all slots are in use.                */
+/* -------------------------------------------------------------------- */
+    GTiffCompressionJob* psJob = &pasCompressionJobs[iNextCompressionJob];
+    if( psJob->bPending && FinishCompressionJob( psJob ) != CE_None )
+        return -1;
+
+    if( cc > psJob->nBufferAlloc )
+    {
+        GByte* pabyNewBuffer = (GByte*) VSIRealloc( psJob->pabyBuffer, cc );
+        if( pabyNewBuffer == NULL )
+            return FALSE;
+        psJob->pabyBuffer = pabyNewBuffer;
+        psJob->nBufferAlloc = cc;
+    }
+    memcpy( psJob->pabyBuffer, pabyData, cc );
+    psJob->nBufferSize = cc;
+
+/* -------------------------------------------------------------------- */
+/*      Capture the codec settings of the dataset.                      */
+/* -------------------------------------------------------------------- */
+    psJob->nStripOrTile = nStripOrTile;
+    psJob->bBigEndian = TIFFIsBigEndian( hTIFF );
+    psJob->nWidth = nBlockXSize;
+    psJob->nHeight = nHeight;
+    psJob->nCompression = nCompression;
+    psJob->nPhotometric = nPhotometric;
+    if( psJob->nPhotometric == PHOTOMETRIC_PALETTE )
+        psJob->nPhotometric = PHOTOMETRIC_MINISBLACK; /* no color map needed */
+    psJob->nBitsPerSample = nBitsPerSample;
+    psJob->nSampleFormat = nSampleFormat;
+    psJob->nSamplesPerPixel =
+        (nPlanarConfig == PLANARCONFIG_CONTIG) ? nSamplesPerPixel : 1;
+
+    psJob->nPredictor = PREDICTOR_NONE;
+    psJob->nZLevel = -1;
+    psJob->nLZMAPreset = -1;
+    psJob->nJpegQuality = -1;
+    psJob->nJpegColorMode = -1;
+    psJob->nYCbCrSubH = 2;
+    psJob->nYCbCrSubV = 2;
+    if( nCompression == COMPRESSION_JPEG )
+    {
+        TIFFGetField( hTIFF, TIFFTAG_JPEGQUALITY, &(psJob->nJpegQuality) );
+        TIFFGetField( hTIFF, TIFFTAG_JPEGCOLORMODE, &(psJob->nJpegColorMode) );
+        TIFFGetFieldDefaulted( hTIFF, TIFFTAG_YCBCRSUBSAMPLING,
+                               &(psJob->nYCbCrSubH), &(psJob->nYCbCrSubV) );
+    }
+    else
+    {
+        TIFFGetField( hTIFF, TIFFTAG_PREDICTOR, &(psJob->nPredictor) );
+        if( nCompression == COMPRESSION_LZMA )
+            TIFFGetField( hTIFF, TIFFTAG_LZMAPRESET, &(psJob->nLZMAPreset) );
+        else if( nCompression == COMPRESSION_ADOBE_DEFLATE ||
+                 nCompression == COMPRESSION_DEFLATE )
+            TIFFGetField( hTIFF, TIFFTAG_ZIPQUALITY, &(psJob->nZLevel) );
+    }
+
+    psJob->bPending = TRUE;
+    nPendingCompressionJobs ++;
+    poThreadPool->SubmitJob( GTiffCompressionJobRun, psJob,
+                                     &(psJob->oJobGroup) );
+
+    iNextCompressionJob = (iNextCompressionJob + 1) % nCompressionJobs;
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                        FinishCompressionJob()                        */
+/*                                                                      */
+/*      Wait for a job and write its compressed block. The directory    */
+/*      of this dataset must be the current one.                        */
+/************************************************************************/
+
+CPLErr GTiffDataset::FinishCompressionJob( GTiffCompressionJob* psJob )
+
+{
+    CPLErr eErr = CE_None;
+
+    poThreadPool->WaitCompletion( &(psJob->oJobGroup) );
+    psJob->bPending = FALSE;
+    nPendingCompressionJobs --;
+
+    vsi_l_offset nDataLength = 0;
+    GByte* pabyData = VSIGetMemFileBuffer( psJob->osTmpFilename,
+                                           &nDataLength, FALSE );
+
+    if( !psJob->bSuccess || pabyData == NULL ||
+        psJob->nCompressedOffset + psJob->nCompressedSize > nDataLength )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Compression of block %d failed.", psJob->nStripOrTile );
+        eErr = CE_Failure;
+    }
+    else
+    {
+        tsize_t nSize = (tsize_t) psJob->nCompressedSize;
+        tsize_t nWritten;
+
+        /* Make TIFFAppendToStrip() start a fresh block, either in place */
+        /* of a previous version of it if large enough, or at the end of */
+        /* the file, rather than appending to the last written block. */
+        TIFFSetWriteOffset( hTIFF, 0 );
+
+        if( TIFFIsTiled( hTIFF ) )
+            nWritten = TIFFWriteRawTile( hTIFF, psJob->nStripOrTile,
+                                         pabyData + psJob->nCompressedOffset,
+                                         nSize );
+        else
+            nWritten = TIFFWriteRawStrip( hTIFF, psJob->nStripOrTile,
+                                          pabyData + psJob->nCompressedOffset,
+                                          nSize );
+        if( nWritten != nSize )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "TIFFWriteRawTile/Strip() failed." );
+            eErr = CE_Failure;
+        }
+    }
+
+    VSIUnlink( psJob->osTmpFilename );
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                        WaitCompressionJobs()                         */
+/*                                                                      */
+/*      Write all the pending compressed blocks, in submission order.   */
+/************************************************************************/
+
+CPLErr GTiffDataset::WaitCompressionJobs()
+
+{
+    if( nPendingCompressionJobs == 0 )
+        return CE_None;
+
+    if( TIFFCurrentDirOffset(hTIFF) != nDirOffset && !SetDirectory() )
+        return CE_Failure;
+
+    CPLErr eErr = CE_None;
+    for( int i = 0; i < nCompressionJobs; i++ )
+    {
+        GTiffCompressionJob* psJob = 
+            &pasCompressionJobs[(iNextCompressionJob + i) % nCompressionJobs];
+        if( psJob->bPending && FinishCompressionJob( psJob ) != CE_None )
+            eErr = CE_Failure;
+    }
+
+    return eErr;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                    Multi-threaded decompression                      */
+/* ==================================================================== */
+/*                                                                      */
+/*      With the NUM_THREADS open option, RasterIO() requests on        */
+/*      read-only datasets that cover several strips/tiles first decode */
+/*      them in parallel into the block cache. Each worker uses its own */
+/*      TIFF handle on the file, so the reads are parallel too.         */
+/************************************************************************/
+
+/************************************************************************/
+/*                         AcquireReadHandle()                          */
+/*                                                                      */
+/*      Return a TIFF handle on the directory of this dataset that is   */
+/*      not used by another job, opening a new one if needed.           */
+/************************************************************************/
+
+GTiffReadHandle* GTiffDataset::AcquireReadHandle( int nJpegColorMode )
+
+{
+    CPLMutexHolderD( &hReadHandlesMutex );
+
+    for( int i = 0; i < nReadHandles; i++ )
+    {
+        if( !papsReadHandles[i]->bInUse )
+        {
+            papsReadHandles[i]->bInUse = TRUE;
+            return papsReadHandles[i];
+        }
+    }
+
+    /* Internal overviews and masks do not know the file name */
+    GTiffDataset* poRootDS = this;
+    while( poRootDS->poBaseDS != NULL )
+        poRootDS = poRootDS->poBaseDS;
+
+    VSILFILE* fpNewL = VSIFOpenL( poRootDS->osFilename, "rb" );
+    if( fpNewL == NULL )
+        return NULL;
+
+    TIFF* hTIFFNew = VSI_TIFFOpen( poRootDS->osFilename, "rc", fpNewL );
+    if( hTIFFNew == NULL )
+    {
+        VSIFCloseL( fpNewL );
+        return NULL;
+    }
+
+    if( !TIFFSetSubDirectory( hTIFFNew, nDirOffset ) )
+    {
+        XTIFFClose( hTIFFNew );
+        VSIFCloseL( fpNewL );
+        return NULL;
+    }
+
+    if( nJpegColorMode >= 0 )
+        TIFFSetField( hTIFFNew, TIFFTAG_JPEGCOLORMODE, nJpegColorMode );
+
+    GTiffReadHandle* psHandle =
+        (GTiffReadHandle*) CPLMalloc( sizeof(GTiffReadHandle) );
+    psHandle->fpL = fpNewL;
+    psHandle->hTIFF = hTIFFNew;
+    psHandle->bInUse = TRUE;
+
+    papsReadHandles = (GTiffReadHandle**)
+        CPLRealloc( papsReadHandles, (nReadHandles+1) * sizeof(void*) );
+    papsReadHandles[nReadHandles++] = psHandle;
+
+    return psHandle;
+}
+
+/************************************************************************/
+/*                         ReleaseReadHandle()                          */
+/************************************************************************/
+
+void GTiffDataset::ReleaseReadHandle( GTiffReadHandle* psHandle )
+
+{
+    CPLMutexHolderD( &hReadHandlesMutex );
+    psHandle->bInUse = FALSE;
+}
+
+/************************************************************************/
+/*                            DecodeJobRun()                            */
+/************************************************************************/
+
+void GTiffDataset::DecodeJobRun( void* pData )
+
+{
+    GTiffDecodeJob* psJob = (GTiffDecodeJob*) pData;
+    GTiffDataset* poDS = psJob->poDS;
+
+    psJob->bSuccess = FALSE;
+
+    /* Failed blocks are read again, and errors reported, by IReadBlock() */
+    CPLPushErrorHandler( CPLQuietErrorHandler );
+
+    GTiffReadHandle* psHandle = poDS->AcquireReadHandle( psJob->nJpegColorMode );
+    if( psHandle == NULL )
+    {
+        CPLPopErrorHandler();
+        return;
+    }
+    VSI_TIFFSetCachedRanges( TIFFClientdata( psHandle->hTIFF ),
+                             poDS->nCachedRanges, poDS->ppCachedData,
+                             poDS->panCachedOffsets, poDS->panCachedSizes );
+
+    int bPixelInterleaved = 
+        poDS->nBands > 1 && poDS->nPlanarConfig == PLANARCONFIG_CONTIG;
+    GByte* pabyBuffer;
+    if( bPixelInterleaved )
+        pabyBuffer = (GByte*) VSIMalloc( psJob->nBlockBufSize );
+    else
+        pabyBuffer = psJob->papabyDest[0];
+
+    if( pabyBuffer != NULL )
+    {
+        int nRet;
+
+        if( psJob->nBlockReqSize < psJob->nBlockBufSize )
+            memset( pabyBuffer, 0, psJob->nBlockBufSize );
+
+        if( TIFFIsTiled( psHandle->hTIFF ) )
+            nRet = TIFFReadEncodedTile( psHandle->hTIFF, psJob->nBlockId,
+                                        pabyBuffer, psJob->nBlockReqSize );
+        else
+            nRet = TIFFReadEncodedStrip( psHandle->hTIFF, psJob->nBlockId,
+                                         pabyBuffer, psJob->nBlockReqSize );
+
+        if( nRet != -1 )
+        {
+            psJob->bSuccess = TRUE;
+
+/* -------------------------------------------------------------------- */
+/*      Dispatch pixel interleaved data to the blocks of each band.     */
+/* -------------------------------------------------------------------- */
+            if( bPixelInterleaved )
+            {
+                GDALDataType eDT = poDS->GetRasterBand(1)->GetRasterDataType();
+                int nWordBytes = poDS->nBitsPerSample / 8;
+                int nBlockPixels = poDS->nBlockXSize * poDS->nBlockYSize;
+
+                for( int iBand = 0; iBand < poDS->nBands; iBand++ )
+                {
+                    if( psJob->papabyDest[iBand] == NULL )
+                        continue;
+                    GDALCopyWords( pabyBuffer + iBand * nWordBytes, eDT,
+                                   poDS->nBands * nWordBytes,
+                                   psJob->papabyDest[iBand], eDT, nWordBytes,
+                                   nBlockPixels );
+                }
+            }
+        }
+
+        if( bPixelInterleaved )
+            CPLFree( pabyBuffer );
+    }
+
+    VSI_TIFFSetCachedRanges( TIFFClientdata( psHandle->hTIFF ),
+                             0, NULL, NULL, NULL );
+    poDS->ReleaseReadHandle( psHandle );
+
+    CPLPopErrorHandler();
+}
+
+/************************************************************************/
+/*                      CacheBlocksMultiThreaded()                      */
+/*                                                                      */
+/*      Decode in parallel the blocks intersecting a window of the      */
+/*      requested bands that are not yet in the block cache.            */
+/************************************************************************/
+
+void GTiffDataset::CacheBlocksMultiThreaded( int nXOff, int nYOff,
+                                             int nXSize, int nYSize,
+                                             int nBandCount, int *panBandMap )
+
+{
+    if( nNumThreads <= 1 || eAccess != GA_ReadOnly ||
+        nCompression == COMPRESSION_NONE ||
+        bTreatAsRGBA || bTreatAsSplit || bTreatAsSplitBitmap )
+        return;
+
+/* -------------------------------------------------------------------- */
+/*      Only handle bands whose blocks are a plain copy of the          */
+/*      decoded data (no GTiffOddBitsBand for instance).                */
+/* -------------------------------------------------------------------- */
+    GDALDataType eDT = GetRasterBand(1)->GetRasterDataType();
+    if( (nBitsPerSample % 8) != 0 ||
+        nBitsPerSample != GDALGetDataTypeSize(eDT) )
+        return;
+
+    GTiffDataset* poRootDS = this;
+    while( poRootDS->poBaseDS != NULL )
+        poRootDS = poRootDS->poBaseDS;
+    if( poRootDS->osFilename.size() == 0 ||
+        strcmp(poRootDS->osFilename, "/vsistdin/") == 0 )
+        return;
+
+    int nBlockX1 = nXOff / nBlockXSize;
+    int nBlockY1 = nYOff / nBlockYSize;
+    int nBlockX2 = (nXOff + nXSize - 1) / nBlockXSize;
+    int nBlockY2 = (nYOff + nYSize - 1) / nBlockYSize;
+    int nBlocks = (nBlockX2 - nBlockX1 + 1) * (nBlockY2 - nBlockY1 + 1);
+    if( nBlocks < 2 )
+        return;
+
+    int bPixelInterleaved = nBands > 1 && nPlanarConfig == PLANARCONFIG_CONTIG;
+    /* All bands are decoded together in the pixel interleaved case */
+    int nDecodedBands = bPixelInterleaved ? nBands : nBandCount;
+    int nWordBytes = nBitsPerSample / 8;
+    GIntBig nBlockBytes = (GIntBig)nBlockXSize * nBlockYSize * nWordBytes;
+
+    /* Decoded blocks would be evicted before the request gets to them */
+    if( nBlockBytes * nDecodedBands * nBlocks > GDALGetCacheMax64() / 2 )
+        return;
+
+    if( !SetDirectory() )
+        return;
+
+    int nBlockBufSize;
+    if( TIFFIsTiled( hTIFF ) )
+        nBlockBufSize = TIFFTileSize( hTIFF );
+    else
+        nBlockBufSize = TIFFStripSize( hTIFF );
+    if( nBlockBufSize != nBlockBytes * (bPixelInterleaved ? nBands : 1) )
+        return;
+
+    int nJpegColorMode = -1;
+    if( nCompression == COMPRESSION_JPEG )
+        TIFFGetField( hTIFF, TIFFTAG_JPEGCOLORMODE, &nJpegColorMode );
+
+    if( poThreadPool == NULL )
+    {
+        poThreadPool = CPLGetWorkerThreadPool( nNumThreads );
+        if( poThreadPool == NULL )
+        {
+            nNumThreads = 0;
+            return;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Create the (locked) cache blocks to decode into.                */
+/* -------------------------------------------------------------------- */
+    int nBlocksPerRow = DIV_ROUND_UP(nRasterXSize, nBlockXSize);
+    int nDestPerJob = bPixelInterleaved ? nBands : 1;
+    int nMaxJobs = bPixelInterleaved ? nBlocks : nBlocks * nBandCount;
+    GTiffDecodeJob* pasJobs = (GTiffDecodeJob*)
+        CPLMalloc( nMaxJobs * sizeof(GTiffDecodeJob) );
+    GByte** papabyDest = (GByte**)
+        CPLCalloc( nMaxJobs * nDestPerJob, sizeof(GByte*) );
+    GDALRasterBlock** papoBlocks = (GDALRasterBlock**)
+        CPLCalloc( nMaxJobs * nDestPerJob, sizeof(GDALRasterBlock*) );
+    int nJobs = 0;
+
+    for( int iY = nBlockY1; iY <= nBlockY2; iY++ )
+    {
+        /* Same as in GTiffRasterBand::IReadBlock() */
+        int nBlockReqSize = nBlockBufSize;
+        if( (iY+1) * (int)nBlockYSize > nRasterYSize )
+        {
+            nBlockReqSize = (nBlockBufSize / nBlockYSize) 
+                * (nBlockYSize - (((iY+1) * nBlockYSize) % nRasterYSize));
+        }
+
+        for( int iX = nBlockX1; iX <= nBlockX2; iX++ )
+        {
+            int nBlockIdBand0 = iX + iY * nBlocksPerRow;
+
+            for( int iJobBand = 0;
+                 iJobBand < (bPixelInterleaved ? 1 : nBandCount);
+                 iJobBand++ )
+            {
+                GTiffDecodeJob* psJob = &pasJobs[nJobs];
+                int nBlockId = nBlockIdBand0;
+                if( !bPixelInterleaved && nPlanarConfig == PLANARCONFIG_SEPARATE )
+                    nBlockId += (panBandMap[iJobBand] - 1) * nBlocksPerBand;
+
+                if( !IsBlockAvailable( nBlockId ) )
+                    continue;
+
+                psJob->poDS = this;
+                psJob->nBlockId = nBlockId;
+                psJob->nBlockBufSize = nBlockBufSize;
+                psJob->nBlockReqSize = nBlockReqSize;
+                psJob->nJpegColorMode = nJpegColorMode;
+                psJob->papabyDest = papabyDest + nJobs * nDestPerJob;
+                psJob->papoBlocks = papoBlocks + nJobs * nDestPerJob;
+
+                int bNeeded = FALSE;
+                for( int iDest = 0; iDest < nDestPerJob; iDest++ )
+                {
+                    GTiffRasterBand* poBand = (GTiffRasterBand*) GetRasterBand(
+                        bPixelInterleaved ? iDest + 1 : panBandMap[iJobBand] );
+
+                    GDALRasterBlock* poBlock =
+                        poBand->TryGetLockedBlockRef( iX, iY );
+                    if( poBlock != NULL )
+                    {
+                        poBlock->DropLock();
+                        continue;
+                    }
+
+                    poBlock = poBand->GetLockedBlockRef( iX, iY, TRUE );
+                    if( poBlock == NULL )
+                        continue;
+
+                    psJob->papoBlocks[iDest] = poBlock;
+                    psJob->papabyDest[iDest] = (GByte*) poBlock->GetDataRef();
+                    bNeeded = TRUE;
+                }
+
+                if( bNeeded )
+                    nJobs ++;
+            }
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Decode, and discard blocks that failed so that IReadBlock()     */
+/*      handles them the usual way.                                     */
+/* -------------------------------------------------------------------- */
+    if( nJobs > 0 )
+    {
+        CPLJobGroup oJobGroup;
+
+        CPLDebug( "GTiff", "Decoding %d blocks with %d threads",
+                  nJobs, nNumThreads );
+
+        for( int i = 0; i < nJobs; i++ )
+            poThreadPool->SubmitJob( DecodeJobRun, &pasJobs[i], &oJobGroup );
+        poThreadPool->WaitCompletion( &oJobGroup );
+    }
+
+    for( int i = 0; i < nJobs; i++ )
+    {
+        for( int iDest = 0; iDest < nDestPerJob; iDest++ )
+        {
+            GDALRasterBlock* poBlock = pasJobs[i].papoBlocks[iDest];
+            if( poBlock == NULL )
+                continue;
+
+            int nXBlockOff = poBlock->GetXOff();
+            int nYBlockOff = poBlock->GetYOff();
+            GDALRasterBand* poBand = poBlock->GetBand();
+            poBlock->DropLock();
+            if( !pasJobs[i].bSuccess )
+                poBand->FlushBlock( nXBlockOff, nYBlockOff, FALSE );
+        }
+    }
+
+    CPLFree( pasJobs );
+    CPLFree( papabyDest );
+    CPLFree( papoBlocks );
+}
+
+/************************************************************************/
+/*                          CacheMultiRange()                           */
+/*                                                                      */
+/*      For remote files, fetch the strips/tiles of a RasterIO()        */
+/*      request that are not yet in the block cache with a single       */
+/*      VSIFReadMultiRangeL() call, rather than with one request per    */
+/*      block. libtiff then reads them from memory. Returns TRUE if     */
+/*      ClearCachedRanges() must be called at the end of the request.   */
+/************************************************************************/
+
+int GTiffDataset::CacheMultiRange( int nXOff, int nYOff,
+                                   int nXSize, int nYSize,
+                                   int nBandCount, int *panBandMap )
+
+{
+    if( nCachedRanges > 0 || eAccess != GA_ReadOnly ||
+        bTreatAsSplit || bTreatAsSplitBitmap )
+        return FALSE;
+
+    GTiffDataset* poRootDS = this;
+    while( poRootDS->poBaseDS != NULL )
+        poRootDS = poRootDS->poBaseDS;
+    if( strncmp(poRootDS->osFilename, "/vsicurl/", strlen("/vsicurl/")) != 0 )
+        return FALSE;
+
+    int nBlockX1 = nXOff / nBlockXSize;
+    int nBlockY1 = nYOff / nBlockYSize;
+    int nBlockX2 = (nXOff + nXSize - 1) / nBlockXSize;
+    int nBlockY2 = (nYOff + nYSize - 1) / nBlockYSize;
+    int nBlocks = (nBlockX2 - nBlockX1 + 1) * (nBlockY2 - nBlockY1 + 1);
+    if( nBlocks < 2 )
+        return FALSE;
+
+    if( !SetDirectory() )
+        return FALSE;
+
+    toff_t *panByteOffsets = NULL, *panByteCounts = NULL;
+    if( TIFFIsTiled( hTIFF ) )
+    {
+        TIFFGetField( hTIFF, TIFFTAG_TILEOFFSETS, &panByteOffsets );
+        TIFFGetField( hTIFF, TIFFTAG_TILEBYTECOUNTS, &panByteCounts );
+    }
+    else
+    {
+        TIFFGetField( hTIFF, TIFFTAG_STRIPOFFSETS, &panByteOffsets );
+        TIFFGetField( hTIFF, TIFFTAG_STRIPBYTECOUNTS, &panByteCounts );
+    }
+    if( panByteOffsets == NULL || panByteCounts == NULL )
+        return FALSE;
+
+/* -------------------------------------------------------------------- */
+/*      Collect the blocks that are needed.                             */
+/* -------------------------------------------------------------------- */
+    int bSeparate = nPlanarConfig == PLANARCONFIG_SEPARATE;
+    int nBlocksPerRow = DIV_ROUND_UP(nRasterXSize, nBlockXSize);
+    int nMaxRanges = bSeparate ? nBlocks * nBandCount : nBlocks;
+    GTiffRange* pasRanges = (GTiffRange*)
+        CPLMalloc( nMaxRanges * sizeof(GTiffRange) );
+    int nRanges = 0;
+
+    for( int iY = nBlockY1; iY <= nBlockY2; iY++ )
+    {
+        for( int iX = nBlockX1; iX <= nBlockX2; iX++ )
+        {
+            for( int iBand = 0; iBand < (bSeparate ? nBandCount : 1); iBand++ )
+            {
+                int nBlockId = iX + iY * nBlocksPerRow;
+                if( bSeparate )
+                    nBlockId += (panBandMap[iBand] - 1) * nBlocksPerBand;
+
+                if( panByteCounts[nBlockId] == 0 )
+                    continue;
+
+                /* Skip blocks that are already in the block cache */
+                int bCached = TRUE;
+                for( int i = 0; bCached && i < nBandCount; i++ )
+                {
+                    if( bSeparate && i != iBand )
+                        continue;
+                    GDALRasterBlock* poBlock = ((GTiffRasterBand*)
+                        GetRasterBand(panBandMap[i]))->TryGetLockedBlockRef( iX, iY );
+                    if( poBlock == NULL )
+                        bCached = FALSE;
+                    else
+                        poBlock->DropLock();
+                }
+                if( bCached )
+                    continue;
+
+                pasRanges[nRanges].nOffset = panByteOffsets[nBlockId];
+                pasRanges[nRanges].nSize = (size_t) panByteCounts[nBlockId];
+                nRanges ++;
+            }
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Sort the ranges and drop the ones that overlap a previous one   */
+/*      (only possible in odd files), as VSIFReadMultiRangeL() does     */
+/*      not accept them.                                                */
+/* -------------------------------------------------------------------- */
+    qsort( pasRanges, nRanges, sizeof(GTiffRange), GTiffRangeCompare );
+
+    GIntBig nTotalSize = 0;
+    int nKeptRanges = 0;
+    for( int i = 0; i < nRanges; i++ )
+    {
+        if( nKeptRanges > 0 &&
+            pasRanges[i].nOffset < pasRanges[nKeptRanges-1].nOffset +
+                                   pasRanges[nKeptRanges-1].nSize )
+            continue;
+        pasRanges[nKeptRanges++] = pasRanges[i];
+        nTotalSize += pasRanges[i].nSize;
+    }
+
+    if( nKeptRanges < 2 || nTotalSize > GDALGetCacheMax64() / 2 ||
+        (GIntBig)(size_t)nTotalSize != nTotalSize )
+    {
+        CPLFree( pasRanges );
+        return FALSE;
+    }
+
+    GByte* pabyData = (GByte*) VSIMalloc( (size_t)nTotalSize );
+    if( pabyData == NULL )
+    {
+        CPLFree( pasRanges );
+        return FALSE;
+    }
+
+    ppCachedData = (void**) CPLMalloc( nKeptRanges * sizeof(void*) );
+    panCachedOffsets = (vsi_l_offset*)
+        CPLMalloc( nKeptRanges * sizeof(vsi_l_offset) );
+    panCachedSizes = (size_t*) CPLMalloc( nKeptRanges * sizeof(size_t) );
+
+    size_t nAccSize = 0;
+    for( int i = 0; i < nKeptRanges; i++ )
+    {
+        /* The first pointer is the one of the whole buffer */
+        ppCachedData[i] = pabyData + nAccSize;
+        panCachedOffsets[i] = pasRanges[i].nOffset;
+        panCachedSizes[i] = pasRanges[i].nSize;
+        nAccSize += pasRanges[i].nSize;
+    }
+    CPLFree( pasRanges );
+    nCachedRanges = nKeptRanges;
+
+    VSILFILE* fp = VSI_TIFFGetVSILFile( TIFFClientdata( hTIFF ) );
+    vsi_l_offset nCurOffset = VSIFTellL( fp );
+    int nRet = VSIFReadMultiRangeL( nCachedRanges, ppCachedData,
+                                    panCachedOffsets, panCachedSizes, fp );
+    VSIFSeekL( fp, nCurOffset, SEEK_SET );
+
+    if( nRet != 0 )
+    {
+        /* Let the regular path read the blocks and report errors */
+        CPLErrorReset();
+        ClearCachedRanges();
+        return FALSE;
+    }
+
+    VSI_TIFFSetCachedRanges( TIFFClientdata( hTIFF ), nCachedRanges,
+                             ppCachedData, panCachedOffsets, panCachedSizes );
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                         ClearCachedRanges()                          */
+/************************************************************************/
+
+void GTiffDataset::ClearCachedRanges()
+
+{
+    if( nCachedRanges == 0 )
+        return;
+
+    VSI_TIFFSetCachedRanges( TIFFClientdata( hTIFF ), 0, NULL, NULL, NULL );
+
+    CPLFree( ppCachedData[0] );
+    CPLFree( ppCachedData );
+    CPLFree( panCachedOffsets );
+    CPLFree( panCachedSizes );
+    ppCachedData = NULL;
+    panCachedOffsets = NULL;
+    panCachedSizes = NULL;
+    nCachedRanges = 0;
+}
+
 /************************************************************************/
 /*                        WriteEncodedTile()                            */
 /************************************************************************/
@@ -4519,6 +5592,10 @@ int GTiffDataset::WriteEncodedTile(uint32 tile, GByte *pabyData,
         }
     }
 
+    int nRet = SubmitCompressionJob(tile, pabyData, cc, nBlockYSize);
+    if( nRet != FALSE )
+        return (nRet < 0) ? -1 : cc;
+
     return TIFFWriteEncodedTile(hTIFF, tile, pabyData, cc);
 }
 
@@ -4537,15 +5614,23 @@ int  GTiffDataset::WriteEncodedStrip(uint32 strip, GByte* pabyData,
 /*      amount of valid data we have. (#2748)                           */
 /* -------------------------------------------------------------------- */
     int nStripWithinBand = strip % nBlocksPerBand;
+    int nStripHeight = nRowsPerStrip;
 
     if( (int) ((nStripWithinBand+1) * nRowsPerStrip) > GetRasterYSize() )
     {
-        cc = (cc / nRowsPerStrip)
-            * (GetRasterYSize() - nStripWithinBand * nRowsPerStrip);
+        nStripHeight = GetRasterYSize() - nStripWithinBand * nRowsPerStrip;
+        cc = (cc / nRowsPerStrip) * nStripHeight;
         CPLDebug( "GTiff", "Adjusted bytes to write from %d to %d.", 
                   (int) TIFFStripSize(hTIFF), cc );
     }
 
+/* -------------------------------------------------------------------- */
+/*      Hand the strip to a worker thread if NUM_THREADS is used.       */
+/* -------------------------------------------------------------------- */
+    int nRet = SubmitCompressionJob(strip, pabyData, cc, nStripHeight);
+    if( nRet != FALSE )
+        return (nRet < 0) ? -1 : cc;
+
 /* -------------------------------------------------------------------- */
 /*      TIFFWriteEncodedStrip can alter the passed buffer if            */
 /*      byte-swapping is necessary so we use a temporary buffer         */
@@ -4901,6 +5986,9 @@ void GTiffCacheOffsetOrCount8(VSILFILE* fp,
 int GTiffDataset::IsBlockAvailable( int nBlockId )
 
 {
+    if( nPendingCompressionJobs > 0 )
+        WaitCompressionJobs();
+
 #ifdef INTERNAL_LIBTIFF
 
     /* Optimization to avoid fetching the whole Strip/TileCounts and Strip/TileOffsets arrays */
@@ -4939,7 +6027,7 @@ int GTiffDataset::IsBlockAvailable( int nBlockId )
         if( ~(hTIFF->tif_dir.td_stripoffset[nBlockId]) == 0 ||
             ~(hTIFF->tif_dir.td_stripbytecount[nBlockId]) == 0 )
         {
-            VSILFILE* fp = (VSILFILE*)hTIFF->tif_clientdata;
+            VSILFILE* fp = VSI_TIFFGetVSILFile(hTIFF->tif_clientdata);
             vsi_l_offset nCurOffset = VSIFTellL(fp);
             if( ~(hTIFF->tif_dir.td_stripoffset[nBlockId]) == 0 )
             {
@@ -5036,6 +6124,9 @@ void GTiffDataset::FlushCache()
 void GTiffDataset::FlushDirectory()
 
 {
+    /* Blocks must be written before the directory that references them */
+    WaitCompressionJobs();
+
     if( GetAccess() == GA_Update )
     {
         if( bMetadataChanged )
@@ -5249,6 +6340,7 @@ CPLErr GTiffDataset::RegisterNewOverviewDataset(toff_t nOverviewOffset)
                         nOverviewCount * (sizeof(void*)));
         papoOverviewDS[nOverviewCount-1] = poODS;
         poODS->poBaseDS = this;
+        poODS->nNumThreads = nNumThreads;
         return CE_None;
     }
 }
@@ -7079,6 +8171,8 @@ GDALDataset *GTiffDataset::Open( GDALOpenInfo * poOpenInfo )
         return NULL;
     }
 
+    poDS->InitNumThreads( poOpenInfo->papszOpenOptions, FALSE );
+
 /* -------------------------------------------------------------------- */
 /*      Initialize any PAM information.                                 */
 /* -------------------------------------------------------------------- */
@@ -7516,6 +8610,7 @@ GDALDataset *GTiffDataset::OpenDir( GDALOpenInfo * poOpenInfo )
     }
     else
     {
+        poDS->InitNumThreads( poOpenInfo->papszOpenOptions, FALSE );
         poDS->bCloseTIFFHandle = TRUE;
         return poDS;
     }
@@ -7927,6 +9022,12 @@ CPLErr GTiffDataset::OpenOffset( TIFF *hTIFFIn,
 
     this->eAccess = eAccess;
 
+    /* GDAL_NUM_THREADS only enables multi-threaded compression of */
+    /* datasets opened in update mode. Parallel decoding of read-only */
+    /* datasets is requested with the NUM_THREADS open option, see Open() */
+    if( eAccess == GA_Update )
+        InitNumThreads( NULL );
+
 /* -------------------------------------------------------------------- */
 /*      Capture some information from the file that is of interest.     */
 /* -------------------------------------------------------------------- */
@@ -8700,6 +9801,7 @@ void GTiffDataset::ScanDirectories()
                                nOverviewCount * (sizeof(void*)));
                 papoOverviewDS[nOverviewCount-1] = poODS;
                 poODS->poBaseDS = this;
+                poODS->nNumThreads = nNumThreads;
             }
         }
             
@@ -8734,6 +9836,7 @@ void GTiffDataset::ScanDirectories()
             {
                 CPLDebug( "GTiff", "Opened band mask.\n");
                 poMaskDS->poBaseDS = this;
+                poMaskDS->nNumThreads = nNumThreads;
                     
                 poMaskDS->bPromoteTo8Bits = CSLTestBoolean(CPLGetConfigOption("GDAL_TIFF_INTERNAL_MASK_TO_8BIT", "YES"));
             }
@@ -8765,6 +9868,7 @@ void GTiffDataset::ScanDirectories()
                         CPLDebug( "GTiff", "Opened band mask for %dx%d overview.\n",
                                   poDS->GetRasterXSize(), poDS->GetRasterYSize());
                         ((GTiffDataset*)papoOverviewDS[i])->poMaskDS = poDS;
+                        poDS->nNumThreads = nNumThreads;
                         poDS->bPromoteTo8Bits = CSLTestBoolean(CPLGetConfigOption("GDAL_TIFF_INTERNAL_MASK_TO_8BIT", "YES"));
                         poDS->poBaseDS = this;
                         break;
@@ -9604,6 +10708,7 @@ GDALDataset *GTiffDataset::Create( const char * pszFilename,
 /*      to decide if a TFW file should be written).                     */
 /* -------------------------------------------------------------------- */
     poDS->papszCreationOptions = CSLDuplicate( papszParmList );
+    poDS->InitNumThreads( papszParmList );
 
     poDS->nZLevel = GTiffGetZLevel(papszParmList);
     poDS->nLZMAPreset = GTiffGetLZMAPreset(papszParmList);
@@ -10330,6 +11435,7 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
     poDS->osProfile = pszProfile;
     poDS->CloneInfo( poSrcDS, GCIF_PAM_DEFAULT & ~GCIF_MASK );
     poDS->papszCreationOptions = CSLDuplicate( papszOptions );
+    poDS->InitNumThreads( papszOptions );
     poDS->bDontReloadFirstBlock = bDontReloadFirstBlock;
 
 /* -------------------------------------------------------------------- */
@@ -11195,7 +12301,7 @@ void GTiffDataset::LoadEXIFMetadata()
     if (!SetDirectory())
         return;
 
-    VSILFILE* fp = (VSILFILE*) TIFFClientdata( hTIFF );
+    VSILFILE* fp = VSI_TIFFGetVSILFile( TIFFClientdata( hTIFF ) );
 
     GByte          abyHeader[2];
     VSIFSeekL(fp, 0, SEEK_SET);
@@ -11639,7 +12745,7 @@ void GDALRegister_GTiff()
     if( GDALGetDriverByName( "GTiff" ) == NULL )
     {
         GDALDriver	*poDriver;
-        char szCreateOptions[4556];
+        char szCreateOptions[4700];
         char szOptionalCompressItems[500];
         int bHasJPEG = FALSE, bHasLZW = FALSE, bHasDEFLATE = FALSE, bHasLZMA = FALSE;
 
@@ -11732,6 +12838,7 @@ void GDALRegister_GTiff()
             strcat( szCreateOptions, ""
 "   <Option name='LZMA_PRESET' type='int' description='LZMA compression level 0(fast)-9(slow)' default='6'/>");
         strcat( szCreateOptions, ""
+"   <Option name='NUM_THREADS' type='string' description='Number of worker threads for compression. Can be set to ALL_CPUS' default='1'/>"
 "   <Option name='NBITS' type='int' description='BITS for sub-byte files (1-7), sub-uint16 (9-15), sub-uint32 (17-31)'/>"
 "   <Option name='INTERLEAVE' type='string-select' default='PIXEL'>"
 "       <Value>BAND</Value>"
@@ -11811,6 +12918,10 @@ void GDALRegister_GTiff()
                                    "Float64 CInt16 CInt32 CFloat32 CFloat64" );
         poDriver->SetMetadataItem( GDAL_DMD_CREATIONOPTIONLIST, 
                                    szCreateOptions );
+        poDriver->SetMetadataItem( GDAL_DMD_OPENOPTIONLIST, 
+"<OpenOptionList>"
+"   <Option name='NUM_THREADS' type='string' description='Number of worker threads for decompression of the blocks of multi-block requests. Can be set to ALL_CPUS' default='1'/>"
+"</OpenOptionList>" );
         poDriver->SetMetadataItem( GDAL_DMD_SUBDATASETS, "YES" );
         poDriver->SetMetadataItem( GDAL_DCAP_VIRTUALIO, "YES" );
 
@@ -34,6 +34,7 @@
  * TIFF Library UNIX-specific Routines.
  */
 #include "cpl_vsi.h"
+#include "cpl_conv.h"
 #include "tifvsi.h"
 
 #include <errno.h>
@@ -54,44 +55,89 @@ extern TIFF CPL_DLL * XTIFFClientOpen(const char* name, const char* mode,
                                       TIFFMapFileProc, TIFFUnmapFileProc);
 CPL_C_END
 
+/* Client data of the TIFF handles opened with VSI_TIFFOpen() */
+typedef struct
+{
+    VSILFILE           *fpL;
+
+    /* Ranges prefetched with VSIFReadMultiRangeL(), sorted by offset */
+    int                 nCachedRanges;
+    void              **ppCachedData;
+    const vsi_l_offset *panCachedOffsets;
+    const size_t       *panCachedSizes;
+} GDALTiffHandle;
+
 static tsize_t
-_tiffReadProc(thandle_t fd, tdata_t buf, tsize_t size)
+_tiffReadProc(thandle_t th, tdata_t buf, tsize_t size)
 {
-    return VSIFReadL( buf, 1, size, (VSILFILE *) fd );
+    GDALTiffHandle* psGTH = (GDALTiffHandle*) th;
+
+    if( psGTH->nCachedRanges > 0 )
+    {
+        vsi_l_offset nCurOffset = VSIFTellL( psGTH->fpL );
+
+        /* Find the last range starting at or before the current offset */
+        int iLow = 0, iHigh = psGTH->nCachedRanges - 1;
+        while( iLow < iHigh )
+        {
+            int iMid = (iLow + iHigh + 1) / 2;
+            if( psGTH->panCachedOffsets[iMid] <= nCurOffset )
+                iLow = iMid;
+            else
+                iHigh = iMid - 1;
+        }
+
+        if( psGTH->panCachedOffsets[iLow] <= nCurOffset &&
+            nCurOffset + size <= psGTH->panCachedOffsets[iLow] +
+                                 psGTH->panCachedSizes[iLow] )
+        {
+            memcpy( buf, (GByte*) psGTH->ppCachedData[iLow] +
+                         (nCurOffset - psGTH->panCachedOffsets[iLow]), size );
+            VSIFSeekL( psGTH->fpL, nCurOffset + size, SEEK_SET );
+            return size;
+        }
+    }
+
+    return VSIFReadL( buf, 1, size, psGTH->fpL );
 }
 
 static tsize_t
-_tiffWriteProc(thandle_t fd, tdata_t buf, tsize_t size)
+_tiffWriteProc(thandle_t th, tdata_t buf, tsize_t size)
 {
-    tsize_t nRet = VSIFWriteL( buf, 1, size, (VSILFILE *) fd );
+    VSILFILE* fd = ((GDALTiffHandle*) th)->fpL;
+    tsize_t nRet = VSIFWriteL( buf, 1, size, fd );
     if (nRet < size)
     {
-        TIFFErrorExt( fd, "_tiffWriteProc", "%s", VSIStrerror( errno ) );
+        TIFFErrorExt( th, "_tiffWriteProc", "%s", VSIStrerror( errno ) );
     }
     return nRet;
 }
 
 static toff_t
-_tiffSeekProc(thandle_t fd, toff_t off, int whence)
+_tiffSeekProc(thandle_t th, toff_t off, int whence)
 {
-    if( VSIFSeekL( (VSILFILE *) fd, off, whence ) == 0 )
-        return (toff_t) VSIFTellL( (VSILFILE *) fd );
+    VSILFILE* fd = ((GDALTiffHandle*) th)->fpL;
+    if( VSIFSeekL( fd, off, whence ) == 0 )
+        return (toff_t) VSIFTellL( fd );
     else
     {
-        TIFFErrorExt( fd, "_tiffSeekProc", "%s", VSIStrerror( errno ) );
+        TIFFErrorExt( th, "_tiffSeekProc", "%s", VSIStrerror( errno ) );
         return (toff_t) -1;
     }
 }
 
 static int
-_tiffCloseProc(thandle_t fd)
+_tiffCloseProc(thandle_t th)
 {
+    /* The VSILFILE itself is closed by the caller */
+    CPLFree( th );
     return 0;
 }
 
 static toff_t
-_tiffSizeProc(thandle_t fd)
+_tiffSizeProc(thandle_t th)
 {
+    VSILFILE* fd = ((GDALTiffHandle*) th)->fpL;
     vsi_l_offset  old_off;
     toff_t        file_size;
 
@@ -143,12 +189,43 @@ TIFF* VSI_TIFFOpen(const char* name, const char* mode,
 
     strcat( access, "b" );
 
+    GDALTiffHandle* psGTH =
+        (GDALTiffHandle*) CPLCalloc( 1, sizeof(GDALTiffHandle) );
+    psGTH->fpL = fp;
+
     VSIFSeekL(fp, 0, SEEK_SET);
     tif = XTIFFClientOpen(name, mode,
-                          (thandle_t) fp,
+                          (thandle_t) psGTH,
                           _tiffReadProc, _tiffWriteProc,
                           _tiffSeekProc, _tiffCloseProc, _tiffSizeProc,
                           _tiffMapProc, _tiffUnmapProc);
+    if( tif == NULL )
+        CPLFree( psGTH );
 
     return tif;
 }
+
+/*
+ * Return the VSILFILE* of a handle opened with VSI_TIFFOpen().
+ */
+VSILFILE* VSI_TIFFGetVSILFile(thandle_t th)
+{
+    return ((GDALTiffHandle*) th)->fpL;
+}
+
+/*
+ * Make reads that fall inside one of the ranges be served from memory
+ * rather than from the file. Ranges must be sorted by increasing offsets.
+ * The arrays are not copied and must be kept alive until this is called
+ * again with nRanges = 0.
+ */
+void VSI_TIFFSetCachedRanges(thandle_t th, int nRanges, void** ppData,
+                             const vsi_l_offset* panOffsets,
+                             const size_t* panSizes)
+{
+    GDALTiffHandle* psGTH = (GDALTiffHandle*) th;
+    psGTH->nCachedRanges = nRanges;
+    psGTH->ppCachedData = ppData;
+    psGTH->panCachedOffsets = panOffsets;
+    psGTH->panCachedSizes = panSizes;
+}
@@ -36,5 +36,9 @@
 #include "tiffio.h"
 
 TIFF* VSI_TIFFOpen(const char* name, const char* mode, VSILFILE* fp);
+VSILFILE* VSI_TIFFGetVSILFile(thandle_t th);
+void VSI_TIFFSetCachedRanges(thandle_t th, int nRanges, void** ppData,
+                             const vsi_l_offset* panOffsets,
+                             const size_t* panSizes);
 
 #endif // TIFVSI_H_INCLUDED
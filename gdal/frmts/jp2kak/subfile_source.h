@@ -102,7 +102,7 @@ class subfile_source : public kdu_compressed_source {
 
           if ( bCached )
           {
-              file = (VSILFILE*)VSICreateCachedFile( (VSIVirtualHandle*)file, IO_CHUNK_SIZE, IO_BUFFER_SIZE );
+              file = (VSILFILE*)VSICreateCachedFile( (VSIVirtualHandle*)file, IO_CHUNK_SIZE, IO_BUFFER_SIZE, real_filename );
               if( file == NULL )
               {
                   kdu_error e;
@@ -211,6 +211,13 @@ class CPL_DLL VRTWarpedDataset : public VRTDataset
 
     friend class VRTWarpedRasterBand;
 
+    int               nImplicitOverviewCount;
+    VRTWarpedDataset  **papoImplicitOverviews;
+    int               bImplicitOverviewsTried;
+
+    VRTWarpedDataset *CreateOverviewDataset( int nOXSize, int nOYSize );
+    void              CreateImplicitOverviews();
+
   protected:
     virtual int         CloseDependentDatasets();
 
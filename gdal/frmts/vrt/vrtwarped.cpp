@@ -33,6 +33,7 @@
 #include "cpl_string.h"
 #include "gdalwarper.h"
 #include "gdal_alg_priv.h"
+#include "gdal_proxy.h"
 #include <cassert>
 
 CPL_CVSID("$Id$");
@@ -285,6 +286,10 @@ VRTWarpedDataset::VRTWarpedDataset( int nXSize, int nYSize )
 
     nOverviewCount = 0;
     papoOverviews = NULL;
+
+    nImplicitOverviewCount = 0;
+    papoImplicitOverviews = NULL;
+    bImplicitOverviewsTried = FALSE;
 }
 
 /************************************************************************/
@@ -328,6 +333,16 @@ int VRTWarpedDataset::CloseDependentDatasets()
     nOverviewCount = 0;
     papoOverviews = NULL;
 
+    for( iOverview = 0; iOverview < nImplicitOverviewCount; iOverview++ )
+    {
+        delete papoImplicitOverviews[iOverview];
+        bHasDroppedRef = TRUE;
+    }
+
+    CPLFree( papoImplicitOverviews );
+    nImplicitOverviewCount = 0;
+    papoImplicitOverviews = NULL;
+
 /* -------------------------------------------------------------------- */
 /*      Cleanup warper if one is in effect.                             */
 /* -------------------------------------------------------------------- */
@@ -455,6 +470,10 @@ typedef struct {
 
     double            dfXOverviewFactor;
     double            dfYOverviewFactor;
+
+    /* Decimation of the source overview warped from, 1 for full res */
+    double            dfXSrcOverviewFactor;
+    double            dfYSrcOverviewFactor;
 } VWOTInfo;
 
 
@@ -462,7 +481,9 @@ static
 void* VRTCreateWarpedOverviewTransformer( GDALTransformerFunc pfnBaseTransformer,
                                           void *pBaseTransformArg,
                                           double dfXOverviewFactor,
-                                          double dfYOverviewFactor );
+                                          double dfYOverviewFactor,
+                                          double dfXSrcOverviewFactor = 1.0,
+                                          double dfYSrcOverviewFactor = 1.0 );
 static
 void VRTDestroyWarpedOverviewTransformer(void* pTransformArg);
 
@@ -484,6 +505,15 @@ VRTSerializeWarpedOverviewTransformer( void *pTransformArg )
     CPLCreateXMLElementAndValue( psTree, "YFactor",
                                  CPLString().Printf("%g",psInfo->dfYOverviewFactor) );
 
+    if( psInfo->dfXSrcOverviewFactor != 1.0
+        || psInfo->dfYSrcOverviewFactor != 1.0 )
+    {
+        CPLCreateXMLElementAndValue( psTree, "SrcXFactor",
+                    CPLString().Printf("%.17g",psInfo->dfXSrcOverviewFactor) );
+        CPLCreateXMLElementAndValue( psTree, "SrcYFactor",
+                    CPLString().Printf("%.17g",psInfo->dfYSrcOverviewFactor) );
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Capture underlying transformer.                                 */
 /* -------------------------------------------------------------------- */
@@ -523,6 +553,10 @@ void* VRTDeserializeWarpedOverviewTransformer( CPLXMLNode *psTree )
 {
     double dfXOverviewFactor = atof(CPLGetXMLValue( psTree, "XFactor",  "1" ));
     double dfYOverviewFactor = atof(CPLGetXMLValue( psTree, "YFactor",  "1" ));
+    double dfXSrcOverviewFactor =
+        CPLAtof(CPLGetXMLValue( psTree, "SrcXFactor",  "1" ));
+    double dfYSrcOverviewFactor =
+        CPLAtof(CPLGetXMLValue( psTree, "SrcYFactor",  "1" ));
     CPLXMLNode *psContainer;
     GDALTransformerFunc pfnBaseTransform = NULL;
     void *pBaseTransformerArg = NULL;
@@ -549,7 +583,9 @@ void* VRTDeserializeWarpedOverviewTransformer( CPLXMLNode *psTree )
                        VRTCreateWarpedOverviewTransformer( pfnBaseTransform,
                                                            pBaseTransformerArg,
                                                            dfXOverviewFactor,
-                                                           dfYOverviewFactor );
+                                                           dfYOverviewFactor,
+                                                           dfXSrcOverviewFactor,
+                                                           dfYSrcOverviewFactor );
         VRTWarpedOverviewTransformerOwnsSubtransformer( pApproxCBData, TRUE );
 
         return pApproxCBData;
@@ -565,7 +601,9 @@ static
 void* VRTCreateWarpedOverviewTransformer( GDALTransformerFunc pfnBaseTransformer,
                                           void *pBaseTransformerArg,
                                           double dfXOverviewFactor,
-                                          double dfYOverviewFactor)
+                                          double dfYOverviewFactor,
+                                          double dfXSrcOverviewFactor,
+                                          double dfYSrcOverviewFactor )
 
 {
     VWOTInfo *psSCTInfo;
@@ -579,6 +617,8 @@ void* VRTCreateWarpedOverviewTransformer( GDALTransformerFunc pfnBaseTransformer
     psSCTInfo->pBaseTransformerArg = pBaseTransformerArg;
     psSCTInfo->dfXOverviewFactor = dfXOverviewFactor;
     psSCTInfo->dfYOverviewFactor = dfYOverviewFactor;
+    psSCTInfo->dfXSrcOverviewFactor = dfXSrcOverviewFactor;
+    psSCTInfo->dfYSrcOverviewFactor = dfYSrcOverviewFactor;
     psSCTInfo->bOwnSubtransformer = FALSE;
 
     strcpy( psSCTInfo->sTI.szSignature, "GTI" );
@@ -626,6 +666,15 @@ int VRTWarpedOverviewTransform( void *pTransformArg, int bDstToSrc,
             padfY[i] *= psInfo->dfYOverviewFactor;
         }
     }
+    else if( psInfo->dfXSrcOverviewFactor != 1.0
+             || psInfo->dfYSrcOverviewFactor != 1.0 )
+    {
+        for( i = 0; i < nPointCount; i++ )
+        {
+            padfX[i] *= psInfo->dfXSrcOverviewFactor;
+            padfY[i] *= psInfo->dfYSrcOverviewFactor;
+        }
+    }
 
     bSuccess = psInfo->pfnBaseTransformer( psInfo->pBaseTransformerArg,
                                            bDstToSrc,
@@ -640,10 +689,381 @@ int VRTWarpedOverviewTransform( void *pTransformArg, int bDstToSrc,
             padfY[i] /= psInfo->dfYOverviewFactor;
         }
     }
+    else if( psInfo->dfXSrcOverviewFactor != 1.0
+             || psInfo->dfYSrcOverviewFactor != 1.0 )
+    {
+        for( i = 0; i < nPointCount; i++ )
+        {
+            padfX[i] /= psInfo->dfXSrcOverviewFactor;
+            padfY[i] /= psInfo->dfYSrcOverviewFactor;
+        }
+    }
 
     return bSuccess;
 }
 
+/************************************************************************/
+/* ==================================================================== */
+/*                    VRTWarpedSrcOverviewDataset                       */
+/*                                                                      */
+/*      Thin dataset exposing one overview level of the bands of a      */
+/*      source dataset, so that the overviews of a warped VRT can be    */
+/*      computed from the source overview of matching resolution        */
+/*      rather than from the full resolution source.                    */
+/* ==================================================================== */
+/************************************************************************/
+
+class VRTWarpedSrcOverviewDataset : public GDALDataset
+{
+    GDALDataset      *poMainDS;
+
+  public:
+                      VRTWarpedSrcOverviewDataset( GDALDataset *poMainDS,
+                                                   int iOvr );
+                     ~VRTWarpedSrcOverviewDataset();
+
+    static VRTWarpedSrcOverviewDataset *Create( GDALDatasetH hSrcDS,
+                                                int iOvr );
+};
+
+class VRTWarpedSrcOverviewBand : public GDALProxyRasterBand
+{
+    GDALRasterBand   *poUnderlyingBand;
+
+  protected:
+    virtual GDALRasterBand *RefUnderlyingRasterBand()
+                                        { return poUnderlyingBand; }
+
+  public:
+                      VRTWarpedSrcOverviewBand( GDALDataset *poDS, int nBand,
+                                                GDALRasterBand *poOvrBand );
+};
+
+/************************************************************************/
+/*                     VRTWarpedSrcOverviewBand()                       */
+/************************************************************************/
+
+VRTWarpedSrcOverviewBand::VRTWarpedSrcOverviewBand( GDALDataset *poDSIn,
+                                                    int nBandIn,
+                                                    GDALRasterBand *poOvrBand )
+
+{
+    poDS = poDSIn;
+    nBand = nBandIn;
+    poUnderlyingBand = poOvrBand;
+
+    nRasterXSize = poOvrBand->GetXSize();
+    nRasterYSize = poOvrBand->GetYSize();
+    eDataType = poOvrBand->GetRasterDataType();
+    poOvrBand->GetBlockSize( &nBlockXSize, &nBlockYSize );
+}
+
+/************************************************************************/
+/*                    VRTWarpedSrcOverviewDataset()                     */
+/************************************************************************/
+
+VRTWarpedSrcOverviewDataset::VRTWarpedSrcOverviewDataset( GDALDataset *poMainDSIn,
+                                                          int iOvr )
+
+{
+    poMainDS = poMainDSIn;
+    poMainDS->Reference();
+
+    GDALRasterBand *poOvrBand = poMainDS->GetRasterBand(1)->GetOverview(iOvr);
+    nRasterXSize = poOvrBand->GetXSize();
+    nRasterYSize = poOvrBand->GetYSize();
+
+    for( int iBand = 0; iBand < poMainDS->GetRasterCount(); iBand++ )
+    {
+        poOvrBand = poMainDS->GetRasterBand(iBand+1)->GetOverview(iOvr);
+        SetBand( iBand+1,
+                 new VRTWarpedSrcOverviewBand( this, iBand+1, poOvrBand ) );
+    }
+
+    SetDescription( poMainDS->GetDescription() );
+}
+
+/************************************************************************/
+/*                   ~VRTWarpedSrcOverviewDataset()                     */
+/************************************************************************/
+
+VRTWarpedSrcOverviewDataset::~VRTWarpedSrcOverviewDataset()
+
+{
+    FlushCache();
+
+    for( int iBand = 0; iBand < nBands; iBand++ )
+        delete papoBands[iBand];
+    nBands = 0;
+
+    if( poMainDS->Dereference() < 1 )
+    {
+        poMainDS->Reference();
+        GDALClose( (GDALDatasetH) poMainDS );
+    }
+}
+
+/************************************************************************/
+/*                               Create()                               */
+/*                                                                      */
+/*      Returns NULL if some band lacks overview iOvr, or if the        */
+/*      overviews of that level do not all have the same size.         */
+/************************************************************************/
+
+VRTWarpedSrcOverviewDataset *
+VRTWarpedSrcOverviewDataset::Create( GDALDatasetH hSrcDS, int iOvr )
+
+{
+    GDALDataset *poSrcDS = (GDALDataset *) hSrcDS;
+
+    if( poSrcDS == NULL || poSrcDS->GetRasterCount() == 0 )
+        return NULL;
+
+    int nOvrXSize = 0, nOvrYSize = 0;
+
+    for( int iBand = 0; iBand < poSrcDS->GetRasterCount(); iBand++ )
+    {
+        GDALRasterBand *poBand = poSrcDS->GetRasterBand(iBand+1);
+        if( iOvr >= poBand->GetOverviewCount() )
+            return NULL;
+
+        GDALRasterBand *poOvrBand = poBand->GetOverview(iOvr);
+        if( poOvrBand == NULL )
+            return NULL;
+
+        if( iBand == 0 )
+        {
+            nOvrXSize = poOvrBand->GetXSize();
+            nOvrYSize = poOvrBand->GetYSize();
+        }
+        else if( poOvrBand->GetXSize() != nOvrXSize
+                 || poOvrBand->GetYSize() != nOvrYSize )
+            return NULL;
+    }
+
+    return new VRTWarpedSrcOverviewDataset( poSrcDS, iOvr );
+}
+
+/************************************************************************/
+/*                  VRTWarpedGetSrcPixelsPerDstPixel()                  */
+/*                                                                      */
+/*      Estimate the linear number of source pixels covered by one      */
+/*      destination pixel, from the local jacobian of the transformer   */
+/*      at the center of the destination raster.                        */
+/************************************************************************/
+
+static double
+VRTWarpedGetSrcPixelsPerDstPixel( const GDALWarpOptions *psWO,
+                                  int nDstXSize, int nDstYSize )
+
+{
+    double adfX[3], adfY[3], adfZ[3] = { 0.0, 0.0, 0.0 };
+    int    anSuccess[3] = { FALSE, FALSE, FALSE };
+    double dfCenterX = nDstXSize * 0.5, dfCenterY = nDstYSize * 0.5;
+
+    adfX[0] = dfCenterX;       adfY[0] = dfCenterY;
+    adfX[1] = dfCenterX + 1.0; adfY[1] = dfCenterY;
+    adfX[2] = dfCenterX;       adfY[2] = dfCenterY + 1.0;
+
+    if( psWO->pfnTransformer == NULL
+        || !psWO->pfnTransformer( psWO->pTransformerArg, TRUE, 3,
+                                  adfX, adfY, adfZ, anSuccess )
+        || !anSuccess[0] || !anSuccess[1] || !anSuccess[2] )
+        return 1.0;
+
+    double dfDet = fabs( (adfX[1] - adfX[0]) * (adfY[2] - adfY[0])
+                         - (adfX[2] - adfX[0]) * (adfY[1] - adfY[0]) );
+
+    if( !(dfDet > 0.0) || CPLIsInf(dfDet) )
+        return 1.0;
+
+    return sqrt( dfDet );
+}
+
+/************************************************************************/
+/*                    VRTWarpedGetSrcOverviewLevel()                    */
+/*                                                                      */
+/*      Return the coarsest source overview level whose decimation      */
+/*      does not exceed dfDecimation (with some tolerance for the       */
+/*      rounding of overview sizes), or -1 for full resolution.         */
+/************************************************************************/
+
+static int VRTWarpedGetSrcOverviewLevel( GDALDatasetH hSrcDS,
+                                         double dfDecimation )
+
+{
+    if( hSrcDS == NULL || GDALGetRasterCount( hSrcDS ) == 0 )
+        return -1;
+
+    GDALRasterBandH hBand = GDALGetRasterBand( hSrcDS, 1 );
+    int    nOvrCount = GDALGetOverviewCount( hBand );
+    int    iBestOvr = -1;
+    double dfBestFactor = 1.0;
+
+    for( int iOvr = 0; iOvr < nOvrCount; iOvr++ )
+    {
+        GDALRasterBandH hOvrBand = GDALGetOverview( hBand, iOvr );
+        if( hOvrBand == NULL || GDALGetRasterBandXSize( hOvrBand ) == 0 )
+            continue;
+
+        double dfFactor = GDALGetRasterBandXSize( hBand )
+            / (double) GDALGetRasterBandXSize( hOvrBand );
+
+        if( dfFactor > dfBestFactor && dfFactor < dfDecimation + 0.1 )
+        {
+            dfBestFactor = dfFactor;
+            iBestOvr = iOvr;
+        }
+    }
+
+    return iBestOvr;
+}
+
+/************************************************************************/
+/*                       CreateOverviewDataset()                        */
+/*                                                                      */
+/*      Create a warped dataset of the requested size, using the        */
+/*      same warp options as this one, with an extra layer of           */
+/*      transformation to apply the downsampling.  When the source      */
+/*      has overviews, the one closest to the resolution of the         */
+/*      overview (without being coarser) is warped from.                */
+/************************************************************************/
+
+VRTWarpedDataset *VRTWarpedDataset::CreateOverviewDataset( int nOXSize,
+                                                           int nOYSize )
+
+{
+    int iBand;
+    VRTWarpedDataset *poOverviewDS = new VRTWarpedDataset( nOXSize, nOYSize );
+
+    for( iBand = 0; iBand < GetRasterCount(); iBand++ )
+    {
+        GDALRasterBand *poOldBand = GetRasterBand(iBand+1);
+        VRTWarpedRasterBand *poNewBand =
+            new VRTWarpedRasterBand( poOverviewDS, iBand+1,
+                                     poOldBand->GetRasterDataType() );
+
+        poNewBand->CopyCommonInfoFrom( poOldBand );
+        poOverviewDS->SetBand( iBand+1, poNewBand );
+    }
+
+    GDALWarpOptions *psWO = (GDALWarpOptions *) poWarper->GetOptions();
+    double dfXFactor = GetRasterXSize() / (double) nOXSize;
+    double dfYFactor = GetRasterYSize() / (double) nOYSize;
+
+/* -------------------------------------------------------------------- */
+/*      Pick the source overview matching the overview resolution.      */
+/* -------------------------------------------------------------------- */
+    GDALDatasetH hSrcDSBase = psWO->hSrcDS;
+    VRTWarpedSrcOverviewDataset *poSrcOvrDS = NULL;
+    double dfXSrcFactor = 1.0, dfYSrcFactor = 1.0;
+
+    if( hSrcDSBase != NULL && GDALGetRasterCount( hSrcDSBase ) > 0
+        && GDALGetOverviewCount( GDALGetRasterBand( hSrcDSBase, 1 ) ) > 0 )
+    {
+        double dfDecimation =
+            VRTWarpedGetSrcPixelsPerDstPixel( psWO, GetRasterXSize(),
+                                              GetRasterYSize() )
+            * MIN( dfXFactor, dfYFactor );
+        int iSrcOvr = VRTWarpedGetSrcOverviewLevel( hSrcDSBase, dfDecimation );
+
+        if( iSrcOvr >= 0 )
+            poSrcOvrDS = VRTWarpedSrcOverviewDataset::Create( hSrcDSBase,
+                                                              iSrcOvr );
+        if( poSrcOvrDS != NULL )
+        {
+            dfXSrcFactor = GDALGetRasterXSize( hSrcDSBase )
+                / (double) poSrcOvrDS->GetRasterXSize();
+            dfYSrcFactor = GDALGetRasterYSize( hSrcDSBase )
+                / (double) poSrcOvrDS->GetRasterYSize();
+
+            CPLDebug( "VRT", "Warped overview %dx%d computed from source "
+                      "overview %d (%dx%d)", nOXSize, nOYSize, iSrcOvr,
+                      poSrcOvrDS->GetRasterXSize(),
+                      poSrcOvrDS->GetRasterYSize() );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Initialize the new dataset with adjusted warp options, and      */
+/*      then restore to original condition.                             */
+/* -------------------------------------------------------------------- */
+    GDALTransformerFunc pfnTransformerBase = psWO->pfnTransformer;
+    void* pTransformerBaseArg = psWO->pTransformerArg;
+
+    psWO->pfnTransformer = VRTWarpedOverviewTransform;
+    psWO->pTransformerArg = VRTCreateWarpedOverviewTransformer(
+                                    pfnTransformerBase,
+                                    pTransformerBaseArg,
+                                    dfXFactor, dfYFactor,
+                                    dfXSrcFactor, dfYSrcFactor );
+    if( poSrcOvrDS != NULL )
+        psWO->hSrcDS = (GDALDatasetH) poSrcOvrDS;
+
+    poOverviewDS->Initialize( psWO );
+
+    psWO->pfnTransformer = pfnTransformerBase;
+    psWO->pTransformerArg = pTransformerBaseArg;
+    psWO->hSrcDS = hSrcDSBase;
+
+    // The overview dataset now holds its own reference on the wrapper.
+    if( poSrcOvrDS != NULL )
+        poSrcOvrDS->Dereference();
+
+    return poOverviewDS;
+}
+
+/************************************************************************/
+/*                      CreateImplicitOverviews()                       */
+/*                                                                      */
+/*      When no overviews have been explicitly built, expose one        */
+/*      overview per overview level of the source, each warped from     */
+/*      the matching source overview.  Those are not serialized.        */
+/************************************************************************/
+
+void VRTWarpedDataset::CreateImplicitOverviews()
+
+{
+    if( bImplicitOverviewsTried || poWarper == NULL )
+        return;
+    bImplicitOverviewsTried = TRUE;
+
+    const GDALWarpOptions *psWO = poWarper->GetOptions();
+    if( psWO->hSrcDS == NULL || GDALGetRasterCount( psWO->hSrcDS ) == 0 )
+        return;
+
+    GDALRasterBandH hSrcBand = GDALGetRasterBand( psWO->hSrcDS, 1 );
+    int nSrcOvrCount = GDALGetOverviewCount( hSrcBand );
+
+    for( int iOvr = 0; iOvr < nSrcOvrCount; iOvr++ )
+    {
+        GDALRasterBandH hOvrBand = GDALGetOverview( hSrcBand, iOvr );
+        if( hOvrBand == NULL )
+            continue;
+
+        double dfXRatio = GDALGetRasterBandXSize( hOvrBand )
+            / (double) GDALGetRasterBandXSize( hSrcBand );
+        double dfYRatio = GDALGetRasterBandYSize( hOvrBand )
+            / (double) GDALGetRasterBandYSize( hSrcBand );
+        int nOXSize = (int) (GetRasterXSize() * dfXRatio + 0.5);
+        int nOYSize = (int) (GetRasterYSize() * dfYRatio + 0.5);
+
+        if( nOXSize < 1 || nOYSize < 1 )
+            break;
+        if( nImplicitOverviewCount > 0
+            && papoImplicitOverviews[nImplicitOverviewCount-1]
+                            ->GetRasterXSize() <= nOXSize )
+            continue;
+
+        nImplicitOverviewCount++;
+        papoImplicitOverviews = (VRTWarpedDataset **)
+            CPLRealloc( papoImplicitOverviews,
+                        sizeof(void*) * nImplicitOverviewCount );
+        papoImplicitOverviews[nImplicitOverviewCount-1] =
+            CreateOverviewDataset( nOXSize, nOYSize );
+    }
+}
+
 /************************************************************************/
 /*                           BuildOverviews()                           */
 /*                                                                      */
@@ -705,9 +1125,8 @@ VRTWarpedDataset::IBuildOverviews( const char *pszResampling,
 /* -------------------------------------------------------------------- */
     for( i = 0; i < nNewOverviews; i++ )
     {
-        int    nOXSize, nOYSize, iBand;
-        VRTWarpedDataset *poOverviewDS;
-        
+        int    nOXSize, nOYSize;
+
 /* -------------------------------------------------------------------- */
 /*      What size should this overview be.                              */
 /* -------------------------------------------------------------------- */
@@ -720,49 +1139,12 @@ VRTWarpedDataset::IBuildOverviews( const char *pszResampling,
 /* -------------------------------------------------------------------- */
 /*      Create the overview dataset.                                    */
 /* -------------------------------------------------------------------- */
-        poOverviewDS = new VRTWarpedDataset( nOXSize, nOYSize );
-        
-        for( iBand = 0; iBand < GetRasterCount(); iBand++ )
-        {
-            GDALRasterBand *poOldBand = GetRasterBand(iBand+1);
-            VRTWarpedRasterBand *poNewBand = 
-                new VRTWarpedRasterBand( poOverviewDS, iBand+1, 
-                                         poOldBand->GetRasterDataType() );
-            
-            poNewBand->CopyCommonInfoFrom( poOldBand );
-            poOverviewDS->SetBand( iBand+1, poNewBand );
-        }
-
         nOverviewCount++;
         papoOverviews = (VRTWarpedDataset **)
             CPLRealloc( papoOverviews, sizeof(void*) * nOverviewCount );
 
-        papoOverviews[nOverviewCount-1] = poOverviewDS;
-        
-/* -------------------------------------------------------------------- */
-/*      Prepare update transformation information that will apply       */
-/*      the overview decimation.                                        */
-/* -------------------------------------------------------------------- */
-        GDALWarpOptions *psWO = (GDALWarpOptions *) poWarper->GetOptions();
-
-/* -------------------------------------------------------------------- */
-/*      Initialize the new dataset with adjusted warp options, and      */
-/*      then restore to original condition.                             */
-/* -------------------------------------------------------------------- */
-        GDALTransformerFunc pfnTransformerBase = psWO->pfnTransformer;
-        void* pTransformerBaseArg = psWO->pTransformerArg;
-
-        psWO->pfnTransformer = VRTWarpedOverviewTransform;
-        psWO->pTransformerArg = VRTCreateWarpedOverviewTransformer(
-                                        pfnTransformerBase,
-                                        pTransformerBaseArg,
-                                        GetRasterXSize() / (double) nOXSize,
-                                        GetRasterYSize() / (double) nOYSize );
-
-        poOverviewDS->Initialize( psWO );
-
-        psWO->pfnTransformer = pfnTransformerBase;
-        psWO->pTransformerArg = pTransformerBaseArg;
+        papoOverviews[nOverviewCount-1] =
+            CreateOverviewDataset( nOXSize, nOYSize );
     }
 
     CPLFree( panNewOverviewList );
@@ -1368,7 +1750,12 @@ int VRTWarpedRasterBand::GetOverviewCount()
 {
     VRTWarpedDataset *poWDS = (VRTWarpedDataset *) poDS;
 
-    return poWDS->nOverviewCount;
+    if( poWDS->nOverviewCount > 0 )
+        return poWDS->nOverviewCount;
+
+    poWDS->CreateImplicitOverviews();
+
+    return poWDS->nImplicitOverviewCount;
 }
 
 /************************************************************************/
@@ -1380,9 +1767,11 @@ GDALRasterBand *VRTWarpedRasterBand::GetOverview( int iOverview )
 {
     VRTWarpedDataset *poWDS = (VRTWarpedDataset *) poDS;
 
-    if( iOverview < 0 || iOverview >= poWDS->nOverviewCount )
+    if( iOverview < 0 || iOverview >= GetOverviewCount() )
         return NULL;
-    else
+    else if( poWDS->nOverviewCount > 0 )
         return poWDS->papoOverviews[iOverview]->GetRasterBand( nBand );
+    else
+        return poWDS->papoImplicitOverviews[iOverview]->GetRasterBand( nBand );
 }
 
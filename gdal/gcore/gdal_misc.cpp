@@ -3099,6 +3099,94 @@ int GDALCheckBandCount( int nBands, int bIsZeroAllowed )
 
 CPL_C_END
 
+/************************************************************************/
+/*                 GDALDriverSupportsConcurrentReads()                  */
+/************************************************************************/
+
+/**
+ * \brief Return whether datasets of a driver can be read concurrently.
+ *
+ * This is TRUE when separate handles opened by the driver on the same file
+ * share no state, neither between themselves nor through the underlying
+ * library, so that each of them can be read from a different thread.
+ * The default list is GTiff, HFA, ENVI, EHdr, PNG and JPEG.  It can be
+ * replaced by setting the GDAL_CONCURRENT_READ_DRIVERS configuration option
+ * to a comma separated list of driver short names (or to an empty string to
+ * disable concurrent reads).  Drivers relying on libraries that are not
+ * thread-safe (netCDF, HDF4, HDF5, GRIB, ...) or sharing their sources
+ * between handles (VRT) must not be listed.
+ *
+ * @param poDriver the driver, or NULL.
+ *
+ * @return TRUE if concurrent reads through separate handles are safe.
+ */
+
+int GDALDriverSupportsConcurrentReads( GDALDriver *poDriver )
+{
+    if( poDriver == NULL )
+        return FALSE;
+
+    const char *pszDrivers =
+        CPLGetConfigOption( "GDAL_CONCURRENT_READ_DRIVERS",
+                            "GTiff,HFA,ENVI,EHdr,PNG,JPEG" );
+    char **papszDrivers = CSLTokenizeString2( pszDrivers, ", ", 0 );
+    int bRet = CSLFindString( papszDrivers, poDriver->GetDescription() ) >= 0;
+    CSLDestroy( papszDrivers );
+
+    return bRet;
+}
+
+/************************************************************************/
+/*                    GDALReopenDatasetForReading()                     */
+/************************************************************************/
+
+/**
+ * \brief Open another read-only handle on the file of a dataset.
+ *
+ * The returned handle can be used from another thread than the one using
+ * poDS.  Only datasets opened read-only from a file that can be reopened
+ * identically, by a driver for which GDALDriverSupportsConcurrentReads()
+ * returns TRUE, are handled.
+ *
+ * @param poDS the dataset to reopen.
+ *
+ * @return a new dataset to close with GDALClose(), or NULL.
+ */
+
+GDALDataset *GDALReopenDatasetForReading( GDALDataset *poDS )
+{
+    const char *pszFilename = poDS->GetDescription();
+    if( poDS->GetAccess() != GA_ReadOnly ||
+        pszFilename == NULL || pszFilename[0] == '\0' ||
+        !GDALDriverSupportsConcurrentReads( poDS->GetDriver() ) )
+        return NULL;
+
+    VSIStatBufL sStat;
+    if( VSIStatL( pszFilename, &sStat ) != 0 )
+        return NULL;
+
+    CPLPushErrorHandler( CPLQuietErrorHandler );
+    GDALDataset *poNewDS = (GDALDataset *) GDALOpen( pszFilename, GA_ReadOnly );
+    CPLPopErrorHandler();
+    if( poNewDS == NULL )
+        return NULL;
+
+    int bSame = poNewDS->GetRasterXSize() == poDS->GetRasterXSize() &&
+                poNewDS->GetRasterYSize() == poDS->GetRasterYSize() &&
+                poNewDS->GetRasterCount() == poDS->GetRasterCount() &&
+                poNewDS->GetDriver() == poDS->GetDriver();
+    for( int iBand = 1; bSame && iBand <= poDS->GetRasterCount(); iBand++ )
+        bSame = poNewDS->GetRasterBand(iBand)->GetRasterDataType() ==
+                poDS->GetRasterBand(iBand)->GetRasterDataType();
+    if( !bSame )
+    {
+        GDALClose( (GDALDatasetH) poNewDS );
+        return NULL;
+    }
+
+    return poNewDS;
+}
+
 
 /************************************************************************/
 /*                     GDALSerializeGCPListToXML()                      */
@@ -57,6 +57,7 @@ class GDALAsyncReader;
 #include "cpl_conv.h"
 #include "cpl_string.h"
 #include "cpl_minixml.h"
+#include "cpl_atomic_ops.h"
 #include <vector>
 #include <map>
 #include "ogr_core.h"
@@ -454,7 +455,7 @@ class CPL_DLL GDALRasterBlock
     GDALDataType        eType;
     
     int                 bDirty;
-    int                 nLockCount;
+    volatile int        nLockCount;
 
     int                 nXOff;
     int                 nYOff;
@@ -477,8 +478,8 @@ class CPL_DLL GDALRasterBlock
     void        Touch( void );      
     void        MarkDirty( void );  
     void        MarkClean( void );
-    void        AddLock( void ) { nLockCount++; }
-    void        DropLock( void ) { nLockCount--; }
+    void        AddLock( void ) { CPLAtomicInc(&nLockCount); }
+    void        DropLock( void ) { CPLAtomicDec(&nLockCount); }
     void        Detach();
 
     CPLErr      Write();
@@ -498,6 +499,8 @@ class CPL_DLL GDALRasterBlock
     GDALRasterBand *GetBand() { return poBand; }
 
     static int  FlushCacheBlock();
+    static void EnterDisableDirtyBlockFlush();
+    static void LeaveDisableDirtyBlockFlush();
     static void Verify();
 
     static int  SafeLockBlock( GDALRasterBlock ** );
@@ -546,6 +549,7 @@ class CPL_DLL GDALRasterBand : public GDALMajorObject
     CPLErr eFlushBlockErr;
 
     void           SetFlushBlockErr( CPLErr eErr );
+    int            UnreferenceBlock( GDALRasterBlock* poBlock );
 
     friend class GDALRasterBlock;
 
@@ -1006,6 +1010,9 @@ CPLErr CPL_DLL GDALParseGMLCoverage( CPLXMLNode *psTree,
                                      double *padfGeoTransform,
                                      char **ppszProjection );
 
+int CPL_DLL GDALDriverSupportsConcurrentReads( GDALDriver *poDriver );
+GDALDataset CPL_DLL *GDALReopenDatasetForReading( GDALDataset *poDS );
+
 /* ==================================================================== */
 /*  Infrastructure to check that dataset characteristics are valid      */
 /* ==================================================================== */
@@ -219,6 +219,11 @@ GDALDriverManager::~GDALDriverManager()
 /* -------------------------------------------------------------------- */
     PamCleanProxyDB();
 
+/* -------------------------------------------------------------------- */
+/*      Stop the worker threads.                                        */
+/* -------------------------------------------------------------------- */
+    CPLCleanupWorkerThreadPool();
+
 /* -------------------------------------------------------------------- */
 /*      Blow away all the finder hints paths.  We really shouldn't      */
 /*      be doing all of them, but it is currently hard to keep track    */
@@ -1050,6 +1050,52 @@ CPLErr GDALRasterBand::FlushBlock( int nXBlockOff, int nYBlockOff, int bWriteDir
     return eErr;
 }
 
+/************************************************************************/
+/*                          UnreferenceBlock()                          */
+/*                                                                      */
+/*      Clear the entry of the block array pointing to the passed       */
+/*      block, if it still does.  Called by                             */
+/*      GDALRasterBlock::FlushCacheBlock() with the mutex of the        */
+/*      block cache shard of the block held.                            */
+/*                                                                      */
+/*      Private method.                                                 */
+/************************************************************************/
+
+int GDALRasterBand::UnreferenceBlock( GDALRasterBlock* poBlock )
+
+{
+    GDALRasterBlock **ppoSlot;
+    int nXBlockOff = poBlock->GetXOff();
+    int nYBlockOff = poBlock->GetYOff();
+
+    if( papoBlocks == NULL )
+        return FALSE;
+
+    if( !bSubBlockingActive )
+    {
+        ppoSlot = papoBlocks + nXBlockOff + nYBlockOff * nBlocksPerRow;
+    }
+    else
+    {
+        int nSubBlock = TO_SUBBLOCK(nXBlockOff) 
+            + TO_SUBBLOCK(nYBlockOff) * nSubBlocksPerRow;
+        GDALRasterBlock **papoSubBlockGrid = 
+            (GDALRasterBlock **) papoBlocks[nSubBlock];
+
+        if( papoSubBlockGrid == NULL )
+            return FALSE;
+
+        ppoSlot = papoSubBlockGrid + WITHIN_SUBBLOCK(nXBlockOff)
+            + WITHIN_SUBBLOCK(nYBlockOff) * SUBBLOCK_SIZE;
+    }
+
+    if( *ppoSlot != poBlock )
+        return FALSE;
+
+    *ppoSlot = NULL;
+    return TRUE;
+}
+
 /************************************************************************/
 /*                        TryGetLockedBlockRef()                        */
 /************************************************************************/
@@ -38,11 +38,71 @@ static int bCacheMaxInitialized = FALSE;
 static GIntBig nCacheMax = 40 * 1024*1024;
 static volatile GIntBig nCacheUsed = 0;
 
-static volatile GDALRasterBlock *poOldest = NULL;    /* tail */
-static volatile GDALRasterBlock *poNewest = NULL;    /* head */
+/* -------------------------------------------------------------------- */
+/*      The block cache is split into shards, each one with its own     */
+/*      LRU list and mutex, so that threads working on different        */
+/*      blocks do not serialize on a single lock.  A block is assigned  */
+/*      to a shard from its address, which is stable during its whole   */
+/*      lifetime.  FlushCacheBlock() visits the shards in round robin   */
+/*      order from nEvictionCursor, so that an eviction only ever       */
+/*      holds one shard lock at a time.                                 */
+/* -------------------------------------------------------------------- */
 
+#define RB_SHARD_COUNT  32      /* must be a power of 2 */
+
+typedef struct
+{
+    void                      *hMutex;
+    GDALRasterBlock           *poOldest;    /* tail */
+    GDALRasterBlock           *poNewest;    /* head */
+} GDALRBCacheShard;
+
+static GDALRBCacheShard asShards[RB_SHARD_COUNT];
+static volatile int bShardsInitialized = FALSE;
+static volatile int nEvictionCursor = 0;
+
+/* Protects shard initialization and nCacheUsed */
 static void *hRBMutex = NULL;
 
+/************************************************************************/
+/*                          GDALRBGetShard()                            */
+/************************************************************************/
+
+static GDALRBCacheShard* GDALRBGetShard( const GDALRasterBlock* poBlock )
+{
+    if( !bShardsInitialized )
+    {
+        CPLMutexHolderD( &hRBMutex );
+        if( !bShardsInitialized )
+        {
+            for( int i = 0; i < RB_SHARD_COUNT; i++ )
+            {
+                asShards[i].hMutex = CPLCreateMutex();
+                CPLReleaseMutex( asShards[i].hMutex );
+                asShards[i].poOldest = NULL;
+                asShards[i].poNewest = NULL;
+            }
+            bShardsInitialized = TRUE;
+        }
+    }
+
+    /* Blocks are heap allocated, so the low bits carry no information */
+    size_t nHash = (size_t) poBlock;
+    nHash = (nHash >> 6) ^ (nHash >> 12) ^ (nHash >> 18);
+    return &asShards[nHash & (RB_SHARD_COUNT - 1)];
+}
+
+/************************************************************************/
+/*                       GDALRBAddToCacheUsed()                         */
+/************************************************************************/
+
+static GIntBig GDALRBAddToCacheUsed( GIntBig nDelta )
+{
+    CPLMutexHolderD( &hRBMutex );
+    nCacheUsed += nDelta;
+    return nCacheUsed;
+}
+
 /************************************************************************/
 /*                          GDALSetCacheMax()                           */
 /************************************************************************/
@@ -310,36 +370,107 @@ int CPL_STDCALL GDALFlushCacheBlock()
 int GDALRasterBlock::FlushCacheBlock()
 
 {
-    int nXOff, nYOff;
-    GDALRasterBand *poBand;
+    GDALRasterBlock *poTarget = NULL;
 
-    {
-        CPLMutexHolderD( &hRBMutex );
-        GDALRasterBlock *poTarget = (GDALRasterBlock *) poOldest;
+    GDALRBGetShard( NULL ); /* make sure shards are initialized */
 
-        while( poTarget != NULL && poTarget->GetLockCount() > 0 ) 
-            poTarget = poTarget->poPrevious;
-        
-        if( poTarget == NULL )
-            return FALSE;
+    /* Dirty blocks might belong to a dataset being written by another */
+    /* thread, in which case they must not be flushed from this one */
+    const int bSkipDirty = CPLGetTLS(CTLS_GDALRASTERBLOCK_NODIRTYFLUSH) != NULL;
 
-        poTarget->Detach();
+/* -------------------------------------------------------------------- */
+/*      Starting from the shard designated by the eviction cursor,      */
+/*      take the oldest unlocked block of the first shard that has      */
+/*      one.  Blocks are spread evenly over the shards, so the oldest   */
+/*      block of a shard is among the oldest blocks of the whole        */
+/*      cache: this approximates a global LRU without ever locking      */
+/*      more than one shard.                                            */
+/* -------------------------------------------------------------------- */
+    const unsigned int iFirstShard =
+        (unsigned int) CPLAtomicInc( &nEvictionCursor );
+
+    for( int i = 0; poTarget == NULL && i < RB_SHARD_COUNT; i++ )
+    {
+        GDALRBCacheShard *psShard =
+            &asShards[(iFirstShard + i) & (RB_SHARD_COUNT - 1)];
+        CPLMutexHolderOptionalLockD( psShard->hMutex );
+
+        GDALRasterBlock *poCandidate = psShard->poOldest;
+        while( poCandidate != NULL && (poCandidate->GetLockCount() > 0 ||
+                                       (bSkipDirty && poCandidate->GetDirty())) )
+            poCandidate = poCandidate->poPrevious;
+        
+        if( poCandidate == NULL )
+            continue;
 
-        nXOff = poTarget->GetXOff();
-        nYOff = poTarget->GetYOff();
-        poBand = poTarget->GetBand();
+/* -------------------------------------------------------------------- */
+/*      Remove the block from the block array of its band while the     */
+/*      shard mutex is still held: SafeLockBlock() checks the array     */
+/*      under that mutex, so no other thread can lock the block once    */
+/*      we release it.                                                  */
+/* -------------------------------------------------------------------- */
+        poCandidate->Detach();
+        if( poCandidate->GetBand()->UnreferenceBlock( poCandidate ) )
+            poTarget = poCandidate;
     }
 
-    CPLErr eErr = poBand->FlushBlock( nXOff, nYOff );
+    if( poTarget == NULL )
+        return FALSE;
+
+/* -------------------------------------------------------------------- */
+/*      No other thread can reach the block anymore: write it if it     */
+/*      is dirty and free it without holding any lock.                  */
+/* -------------------------------------------------------------------- */
+    CPLErr eErr = poTarget->Write();
     if (eErr != CE_None)
     {
         /* Save the error for later reporting */
-        poBand->SetFlushBlockErr(eErr);
+        poTarget->GetBand()->SetFlushBlockErr(eErr);
     }
 
+    delete poTarget;
+
     return TRUE;
 }
 
+/************************************************************************/
+/*                    EnterDisableDirtyBlockFlush()                     */
+/************************************************************************/
+
+/**
+ * Start preventing the calling thread from flushing dirty blocks.
+ *
+ * This is used by code that reads a dataset in a thread while another
+ * thread writes to another dataset, so that cache evictions triggered by
+ * the reads do not write blocks of the dataset being written concurrently.
+ * Clean blocks are still flushed. Calls can be nested, and must be balanced
+ * by LeaveDisableDirtyBlockFlush().
+ */
+
+void GDALRasterBlock::EnterDisableDirtyBlockFlush()
+
+{
+    size_t nCounter = (size_t) CPLGetTLS(CTLS_GDALRASTERBLOCK_NODIRTYFLUSH);
+    CPLSetTLS(CTLS_GDALRASTERBLOCK_NODIRTYFLUSH, (void*)(nCounter + 1), FALSE);
+}
+
+/************************************************************************/
+/*                    LeaveDisableDirtyBlockFlush()                     */
+/************************************************************************/
+
+/**
+ * End the effect of EnterDisableDirtyBlockFlush().
+ */
+
+void GDALRasterBlock::LeaveDisableDirtyBlockFlush()
+
+{
+    size_t nCounter = (size_t) CPLGetTLS(CTLS_GDALRASTERBLOCK_NODIRTYFLUSH);
+    CPLAssert( nCounter > 0 );
+    if( nCounter > 0 )
+        CPLSetTLS(CTLS_GDALRASTERBLOCK_NODIRTYFLUSH, (void*)(nCounter - 1), FALSE);
+}
+
 /************************************************************************/
 /*                          GDALRasterBlock()                           */
 /************************************************************************/
@@ -402,10 +533,7 @@ GDALRasterBlock::~GDALRasterBlock()
 
         nSizeInBytes = nXSize * nYSize * (GDALGetDataTypeSize(eType) / 8);
 
-        {
-            CPLMutexHolderD( &hRBMutex );
-            nCacheUsed -= nSizeInBytes;
-        }
+        GDALRBAddToCacheUsed( -nSizeInBytes );
     }
 
     CPLAssert( nLockCount == 0 );
@@ -431,14 +559,15 @@ GDALRasterBlock::~GDALRasterBlock()
 void GDALRasterBlock::Detach()
 
 {
-    CPLMutexHolderD( &hRBMutex );
+    GDALRBCacheShard *psShard = GDALRBGetShard( this );
+    CPLMutexHolderOptionalLockD( psShard->hMutex );
 
-    if( poOldest == this )
-        poOldest = poPrevious;
+    if( psShard->poOldest == this )
+        psShard->poOldest = poPrevious;
 
-    if( poNewest == this )
+    if( psShard->poNewest == this )
     {
-        poNewest = poNext;
+        psShard->poNewest = poNext;
     }
 
     if( poPrevious != NULL )
@@ -456,35 +585,43 @@ void GDALRasterBlock::Detach()
 /************************************************************************/
 
 /**
- * Confirms (via assertions) that the block cache linked list is in a
+ * Confirms (via assertions) that the block cache linked lists are in a
  * consistent state. 
  */
 
 void GDALRasterBlock::Verify()
 
 {
-    CPLMutexHolderD( &hRBMutex );
+    GDALRBGetShard( NULL ); /* make sure shards are initialized */
 
-    CPLAssert( (poNewest == NULL && poOldest == NULL)
-               || (poNewest != NULL && poOldest != NULL) );
-
-    if( poNewest != NULL )
+    for( int i = 0; i < RB_SHARD_COUNT; i++ )
     {
-        CPLAssert( poNewest->poPrevious == NULL );
-        CPLAssert( poOldest->poNext == NULL );
-        
-        for( GDALRasterBlock *poBlock = (GDALRasterBlock *) poNewest; 
-             poBlock != NULL;
-             poBlock = poBlock->poNext )
+        GDALRBCacheShard *psShard = &asShards[i];
+        CPLMutexHolderOptionalLockD( psShard->hMutex );
+
+        CPLAssert( (psShard->poNewest == NULL && psShard->poOldest == NULL)
+                   || (psShard->poNewest != NULL && psShard->poOldest != NULL) );
+
+        if( psShard->poNewest != NULL )
         {
-            if( poBlock->poPrevious )
-            {
-                CPLAssert( poBlock->poPrevious->poNext == poBlock );
-            }
+            CPLAssert( psShard->poNewest->poPrevious == NULL );
+            CPLAssert( psShard->poOldest->poNext == NULL );
 
-            if( poBlock->poNext )
+            for( GDALRasterBlock *poBlock = psShard->poNewest;
+                 poBlock != NULL;
+                 poBlock = poBlock->poNext )
             {
-                CPLAssert( poBlock->poNext->poPrevious == poBlock );
+                CPLAssert( GDALRBGetShard( poBlock ) == psShard );
+
+                if( poBlock->poPrevious )
+                {
+                    CPLAssert( poBlock->poPrevious->poNext == poBlock );
+                }
+
+                if( poBlock->poNext )
+                {
+                    CPLAssert( poBlock->poNext->poPrevious == poBlock );
+                }
             }
         }
     }
@@ -535,13 +672,14 @@ CPLErr GDALRasterBlock::Write()
 void GDALRasterBlock::Touch()
 
 {
-    CPLMutexHolderD( &hRBMutex );
+    GDALRBCacheShard *psShard = GDALRBGetShard( this );
+    CPLMutexHolderOptionalLockD( psShard->hMutex );
 
-    if( poNewest == this )
+    if( psShard->poNewest == this )
         return;
 
-    if( poOldest == this )
-        poOldest = this->poPrevious;
+    if( psShard->poOldest == this )
+        psShard->poOldest = this->poPrevious;
     
     if( poPrevious != NULL )
         poPrevious->poNext = poNext;
@@ -550,19 +688,19 @@ void GDALRasterBlock::Touch()
         poNext->poPrevious = poPrevious;
 
     poPrevious = NULL;
-    poNext = (GDALRasterBlock *) poNewest;
+    poNext = psShard->poNewest;
 
-    if( poNewest != NULL )
+    if( psShard->poNewest != NULL )
     {
-        CPLAssert( poNewest->poPrevious == NULL );
-        poNewest->poPrevious = this;
+        CPLAssert( psShard->poNewest->poPrevious == NULL );
+        psShard->poNewest->poPrevious = this;
     }
-    poNewest = this;
+    psShard->poNewest = this;
     
-    if( poOldest == NULL )
+    if( psShard->poOldest == NULL )
     {
         CPLAssert( poPrevious == NULL && poNext == NULL );
-        poOldest = this;
+        psShard->poOldest = this;
     }
 #ifdef ENABLE_DEBUG
     Verify();
@@ -587,7 +725,6 @@ void GDALRasterBlock::Touch()
 CPLErr GDALRasterBlock::Internalize()
 
 {
-    CPLMutexHolderD( &hRBMutex );
     void        *pNewData;
     int         nSizeInBytes;
     GIntBig     nCurCacheMax = GDALGetCacheMax64();
@@ -614,15 +751,17 @@ CPLErr GDALRasterBlock::Internalize()
 /* -------------------------------------------------------------------- */
     AddLock(); /* don't flush this block! */
 
-    nCacheUsed += nSizeInBytes;
-    while( nCacheUsed > nCurCacheMax )
+/* -------------------------------------------------------------------- */
+/*      No lock is held while flushing, so that other threads can keep  */
+/*      on using the cache while dirty blocks are written.              */
+/* -------------------------------------------------------------------- */
+    GIntBig nCurCacheUsed = GDALRBAddToCacheUsed( nSizeInBytes );
+    while( nCurCacheUsed > nCurCacheMax )
     {
-        GIntBig nOldCacheUsed = nCacheUsed;
-
-        GDALFlushCacheBlock();
-
-        if( nCacheUsed == nOldCacheUsed )
+        if( !GDALFlushCacheBlock() )
             break;
+
+        nCurCacheUsed = nCacheUsed;
     }
 
 /* -------------------------------------------------------------------- */
@@ -677,10 +816,10 @@ void GDALRasterBlock::MarkClean()
  * \brief Safely lock block.
  *
  * This method locks a GDALRasterBlock (and touches it) in a thread-safe
- * manner.  The global block cache mutex is held while locking the block,
- * in order to avoid race conditions with other threads that might be
- * trying to expire the block at the same time.  The block pointer may be
- * safely NULL, in which case this method does nothing. 
+ * manner.  The mutex of the block cache shard the block belongs to is held
+ * while locking the block, in order to avoid race conditions with other
+ * threads that might be trying to expire the block at the same time.  The
+ * block pointer may be safely NULL, in which case this method does nothing. 
  *
  * @param ppBlock Pointer to the block pointer to try and lock/touch.
  */
@@ -690,17 +829,24 @@ int GDALRasterBlock::SafeLockBlock( GDALRasterBlock ** ppBlock )
 {
     CPLAssert( NULL != ppBlock );
 
-    CPLMutexHolderD( &hRBMutex );
-
-    if( *ppBlock != NULL )
+    for( ;; )
     {
-        (*ppBlock)->AddLock();
-        (*ppBlock)->Touch();
+        GDALRasterBlock *poBlock = *((GDALRasterBlock * volatile *) ppBlock);
+        if( poBlock == NULL )
+            return FALSE;
+
+        GDALRBCacheShard *psShard = GDALRBGetShard( poBlock );
+        CPLMutexHolderOptionalLockD( psShard->hMutex );
+
+        /* The slot may have been changed before we got the shard mutex */
+        if( *ppBlock != poBlock )
+            continue;
+
+        poBlock->AddLock();
+        poBlock->Touch();
         
         return TRUE;
     }
-    else
-        return FALSE;
 }
 
 /************************************************************************/
@@ -709,6 +855,16 @@ int GDALRasterBlock::SafeLockBlock( GDALRasterBlock ** ppBlock )
 
 void GDALRasterBlock::DestroyRBMutex()
 {
+    if( bShardsInitialized )
+    {
+        for( int i = 0; i < RB_SHARD_COUNT; i++ )
+        {
+            CPLDestroyMutex( asShards[i].hMutex );
+            asShards[i].hMutex = NULL;
+        }
+        bShardsInitialized = FALSE;
+    }
+
     if( hRBMutex != NULL )
         CPLDestroyMutex(hRBMutex);
     hRBMutex = NULL;
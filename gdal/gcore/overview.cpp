@@ -29,6 +29,14 @@
  ****************************************************************************/
 
 #include "gdal_priv.h"
+#include "cpl_multiproc.h"
+
+// SSE2 is part of the x86_64 instruction set, so no runtime check is needed
+// for the factor 2 downsampling kernels.
+#if defined(__x86_64) || defined(_M_X64)
+#define HAVE_SSE2_OVERVIEW 1
+#include <emmintrin.h>
+#endif
 
 CPL_CVSID("$Id$");
 
@@ -45,6 +53,114 @@ typedef CPLErr (*GDALDownsampleFunction)
                         GDALColorTable* poColorTable,
                         GDALDataType eSrcDataType);
 
+#ifdef HAVE_SSE2_OVERVIEW
+
+/************************************************************************/
+/*                      GDALDownsampleNear2SSE2()                       */
+/*                                                                      */
+/*      Take one source pixel out of two.  Return the number of         */
+/*      destination pixels computed.  The source pixel after the last   */
+/*      one taken is never read.                                        */
+/************************************************************************/
+
+static int GDALDownsampleNear2SSE2( const GByte* pabySrc, GByte* pabyDst,
+                                    int nDstXWidth )
+{
+    const __m128i xmm_mask = _mm_set1_epi16(0xff);
+    int iDstPixel = 0;
+    for( ; iDstPixel + 16 < nDstXWidth; iDstPixel += 16 )
+    {
+        __m128i xmm0 = _mm_loadu_si128((const __m128i*)(pabySrc + 2 * iDstPixel));
+        __m128i xmm1 = _mm_loadu_si128((const __m128i*)(pabySrc + 2 * iDstPixel + 16));
+        xmm0 = _mm_and_si128(xmm0, xmm_mask);
+        xmm1 = _mm_and_si128(xmm1, xmm_mask);
+        _mm_storeu_si128((__m128i*)(pabyDst + iDstPixel),
+                         _mm_packus_epi16(xmm0, xmm1));
+    }
+    return iDstPixel;
+}
+
+static int GDALDownsampleNear2SSE2( const float* pafSrc, float* pafDst,
+                                    int nDstXWidth )
+{
+    int iDstPixel = 0;
+    for( ; iDstPixel + 4 < nDstXWidth; iDstPixel += 4 )
+    {
+        __m128 xmm0 = _mm_loadu_ps(pafSrc + 2 * iDstPixel);
+        __m128 xmm1 = _mm_loadu_ps(pafSrc + 2 * iDstPixel + 4);
+        _mm_storeu_ps(pafDst + iDstPixel,
+                      _mm_shuffle_ps(xmm0, xmm1, _MM_SHUFFLE(2,0,2,0)));
+    }
+    return iDstPixel;
+}
+
+/************************************************************************/
+/*                    GDALDownsampleAverage2x2SSE2()                    */
+/*                                                                      */
+/*      Average 2x2 source pixels, with the same rounding as the        */
+/*      scalar code.  Return the number of destination pixels           */
+/*      computed.                                                       */
+/************************************************************************/
+
+static int GDALDownsampleAverage2x2SSE2( const GByte* pabySrc, int nSrcLineSize,
+                                         GByte* pabyDst, int nDstXWidth )
+{
+    const __m128i xmm_mask = _mm_set1_epi16(0xff);
+    const __m128i xmm_two = _mm_set1_epi16(2);
+    int iDstPixel = 0;
+    for( ; iDstPixel + 16 <= nDstXWidth; iDstPixel += 16 )
+    {
+        __m128i axmmSum[2];
+        for( int i = 0; i < 2; i++ )
+        {
+            const GByte* pabyLine0 = pabySrc + 2 * iDstPixel + 16 * i;
+            const GByte* pabyLine1 = pabyLine0 + nSrcLineSize;
+            __m128i xmm0 = _mm_loadu_si128((const __m128i*)pabyLine0);
+            __m128i xmm1 = _mm_loadu_si128((const __m128i*)pabyLine1);
+            /* Sum of even and odd pixels of both lines on 16 bit */
+            __m128i xmmSum = _mm_add_epi16(
+                _mm_add_epi16(_mm_and_si128(xmm0, xmm_mask),
+                              _mm_srli_epi16(xmm0, 8)),
+                _mm_add_epi16(_mm_and_si128(xmm1, xmm_mask),
+                              _mm_srli_epi16(xmm1, 8)));
+            axmmSum[i] = _mm_srli_epi16(_mm_add_epi16(xmmSum, xmm_two), 2);
+        }
+        _mm_storeu_si128((__m128i*)(pabyDst + iDstPixel),
+                         _mm_packus_epi16(axmmSum[0], axmmSum[1]));
+    }
+    return iDstPixel;
+}
+
+static int GDALDownsampleAverage2x2SSE2( const float* pafSrc, int nSrcLineSize,
+                                         float* pafDst, int nDstXWidth )
+{
+    /* Sum in double precision and in the same order as the scalar code */
+    const __m128d xmm_quarter = _mm_set1_pd(0.25);
+    int iDstPixel = 0;
+    for( ; iDstPixel + 2 <= nDstXWidth; iDstPixel += 2 )
+    {
+        const float* pafLine0 = pafSrc + 2 * iDstPixel;
+        const float* pafLine1 = pafLine0 + nSrcLineSize;
+        __m128 xmm0 = _mm_loadu_ps(pafLine0);
+        __m128 xmm1 = _mm_loadu_ps(pafLine1);
+        /* Starting from 0, so that -0 values give +0 as the scalar code */
+        __m128d xmmTotal = _mm_add_pd(_mm_setzero_pd(), _mm_cvtps_pd(
+            _mm_shuffle_ps(xmm0, xmm0, _MM_SHUFFLE(2,0,2,0))));
+        xmmTotal = _mm_add_pd(xmmTotal, _mm_cvtps_pd(
+            _mm_shuffle_ps(xmm0, xmm0, _MM_SHUFFLE(3,1,3,1))));
+        xmmTotal = _mm_add_pd(xmmTotal, _mm_cvtps_pd(
+            _mm_shuffle_ps(xmm1, xmm1, _MM_SHUFFLE(2,0,2,0))));
+        xmmTotal = _mm_add_pd(xmmTotal, _mm_cvtps_pd(
+            _mm_shuffle_ps(xmm1, xmm1, _MM_SHUFFLE(3,1,3,1))));
+        /* Multiplying by 0.25 is exact, as dividing by 4 */
+        __m128 xmmRes = _mm_cvtpd_ps(_mm_mul_pd(xmmTotal, xmm_quarter));
+        _mm_storel_pi((__m64*)(pafDst + iDstPixel), xmmRes);
+    }
+    return iDstPixel;
+}
+
+#endif /* HAVE_SSE2_OVERVIEW */
+
 /************************************************************************/
 /*                     GDALDownsampleChunk32R_Near()                    */
 /************************************************************************/
@@ -117,6 +233,7 @@ GDALDownsampleChunk32R_NearT( int nSrcWidth, int nSrcHeight,
 /*      Precompute inner loop constants.                                */
 /* ==================================================================== */
     int iDstPixel;
+    int bSrcXSpacingIsTwo = TRUE;
     for( iDstPixel = nDstXOff; iDstPixel < nDstXOff2; iDstPixel++ )
     {
         int   nSrcXOff;
@@ -127,6 +244,8 @@ GDALDownsampleChunk32R_NearT( int nSrcWidth, int nSrcHeight,
             nSrcXOff = nChunkXOff;
 
         panSrcXOff[iDstPixel - nDstXOff] = nSrcXOff;
+        if( nSrcXOff != panSrcXOff[0] + 2 * (iDstPixel - nDstXOff) )
+            bSrcXSpacingIsTwo = FALSE;
     }
 
 /* ==================================================================== */
@@ -146,7 +265,13 @@ GDALDownsampleChunk32R_NearT( int nSrcWidth, int nSrcHeight,
 /* -------------------------------------------------------------------- */
 /*      Loop over destination pixels                                    */
 /* -------------------------------------------------------------------- */
-        for( iDstPixel = 0; iDstPixel < nDstXWidth; iDstPixel++ )
+        iDstPixel = 0;
+#ifdef HAVE_SSE2_OVERVIEW
+        if( bSrcXSpacingIsTwo )
+            iDstPixel = GDALDownsampleNear2SSE2( pSrcScanline + panSrcXOff[0],
+                                                 pDstScanline, nDstXWidth );
+#endif
+        for( ; iDstPixel < nDstXWidth; iDstPixel++ )
         {
             pDstScanline[iDstPixel] = pSrcScanline[panSrcXOff[iDstPixel]];
         }
@@ -350,7 +475,15 @@ GDALDownsampleChunk32R_AverageT( int nSrcWidth, int nSrcHeight,
             {
                 /* Optimized case : no nodata, overview by a factor of 2 and regular x and y src spacing */
                 T* pSrcScanlineShifted = pChunk + panSrcXOffShifted[0] + (nSrcYOff - nChunkYOff) * nChunkXSize;
-                for( iDstPixel = 0; iDstPixel < nDstXWidth; iDstPixel++ )
+                iDstPixel = 0;
+#ifdef HAVE_SSE2_OVERVIEW
+                iDstPixel = GDALDownsampleAverage2x2SSE2( pSrcScanlineShifted,
+                                                          nChunkXSize,
+                                                          pDstScanline,
+                                                          nDstXWidth );
+                pSrcScanlineShifted += 2 * iDstPixel;
+#endif
+                for( ; iDstPixel < nDstXWidth; iDstPixel++ )
                 {
                     Tsum nTotal;
 
@@ -368,7 +501,18 @@ GDALDownsampleChunk32R_AverageT( int nSrcWidth, int nSrcHeight,
                 nSrcYOff -= nChunkYOff;
                 nSrcYOff2 -= nChunkYOff;
 
-                for( iDstPixel = 0; iDstPixel < nDstXWidth; iDstPixel++ )
+                iDstPixel = 0;
+#ifdef HAVE_SSE2_OVERVIEW
+                if (bSrcXSpacingIsTwo && nSrcYOff2 == nSrcYOff + 2 &&
+                    pabyChunkNodataMask == NULL && eWrkDataType == GDT_Float32)
+                {
+                    /* Same factor 2 case for floating point values */
+                    iDstPixel = GDALDownsampleAverage2x2SSE2(
+                        pChunk + panSrcXOffShifted[0] + nSrcYOff * nChunkXSize,
+                        nChunkXSize, pDstScanline, nDstXWidth );
+                }
+#endif
+                for( ; iDstPixel < nDstXWidth; iDstPixel++ )
                 {
                     int  nSrcXOff = panSrcXOffShifted[2 * iDstPixel],
                          nSrcXOff2 = panSrcXOffShifted[2 * iDstPixel + 1];
@@ -1513,6 +1657,257 @@ static GDALDataType GDALGetOvrWorkDataType(const char* pszResampling,
         return GDT_Float32;
 }
 
+/************************************************************************/
+/*                           GDALOvrJobBand                             */
+/*                                                                      */
+/*      Stand-in for an overview band, given to the downsampling        */
+/*      functions when they run in a worker thread.  The lines they     */
+/*      write are kept in memory, and written to the real overview      */
+/*      band, in the same order, by the thread that owns the            */
+/*      datasets.                                                       */
+/************************************************************************/
+
+typedef struct
+{
+    int          nXOff;
+    int          nYOff;
+    int          nXSize;
+    int          nYSize;
+    GDALDataType eBufType;
+    void        *pData;
+} GDALOvrJobWrite;
+
+class GDALOvrJobBand : public GDALRasterBand
+{
+    int              nWrites;
+    int              nMaxWrites;
+    GDALOvrJobWrite *pasWrites;
+
+  protected:
+    virtual CPLErr IReadBlock( int, int, void * );
+    virtual CPLErr IRasterIO( GDALRWFlag, int, int, int, int,
+                              void *, int, int, GDALDataType,
+                              int, int );
+
+  public:
+                   GDALOvrJobBand( GDALRasterBand* poOverview );
+    virtual       ~GDALOvrJobBand();
+
+    CPLErr         WriteTo( GDALRasterBand* poOverview );
+};
+
+GDALOvrJobBand::GDALOvrJobBand( GDALRasterBand* poOverview )
+
+{
+    nRasterXSize = poOverview->GetXSize();
+    nRasterYSize = poOverview->GetYSize();
+    eDataType = poOverview->GetRasterDataType();
+    nBlockXSize = nRasterXSize;
+    nBlockYSize = 1;
+    bForceCachedIO = FALSE;
+
+    nWrites = 0;
+    nMaxWrites = 0;
+    pasWrites = NULL;
+}
+
+GDALOvrJobBand::~GDALOvrJobBand()
+
+{
+    for( int i = 0; i < nWrites; i++ )
+        CPLFree( pasWrites[i].pData );
+    CPLFree( pasWrites );
+}
+
+CPLErr GDALOvrJobBand::IReadBlock( int, int, void * )
+
+{
+    CPLError( CE_Failure, CPLE_NotSupported,
+              "GDALOvrJobBand::IReadBlock() not supported." );
+    return CE_Failure;
+}
+
+CPLErr GDALOvrJobBand::IRasterIO( GDALRWFlag eRWFlag,
+                                  int nXOff, int nYOff, int nXSize, int nYSize,
+                                  void * pData, int nBufXSize, int nBufYSize,
+                                  GDALDataType eBufType,
+                                  int nPixelSpace, int nLineSpace )
+
+{
+    int nWordSize = GDALGetDataTypeSize(eBufType) / 8;
+
+    if( eRWFlag != GF_Write || nBufXSize != nXSize || nBufYSize != nYSize ||
+        nPixelSpace != nWordSize || nLineSpace != nPixelSpace * nBufXSize )
+    {
+        CPLError( CE_Failure, CPLE_NotSupported,
+                  "GDALOvrJobBand::IRasterIO() only supports writing "
+                  "packed buffers." );
+        return CE_Failure;
+    }
+
+    if( nWrites == nMaxWrites )
+    {
+        nMaxWrites = nMaxWrites * 2 + 16;
+        pasWrites = (GDALOvrJobWrite*)
+            CPLRealloc( pasWrites, nMaxWrites * sizeof(GDALOvrJobWrite) );
+    }
+
+    void* pCopy = VSIMalloc3( nWordSize, nXSize, nYSize );
+    if( pCopy == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "GDALOvrJobBand::IRasterIO(): Out of memory." );
+        return CE_Failure;
+    }
+    memcpy( pCopy, pData, (size_t)nWordSize * nXSize * nYSize );
+
+    pasWrites[nWrites].nXOff = nXOff;
+    pasWrites[nWrites].nYOff = nYOff;
+    pasWrites[nWrites].nXSize = nXSize;
+    pasWrites[nWrites].nYSize = nYSize;
+    pasWrites[nWrites].eBufType = eBufType;
+    pasWrites[nWrites].pData = pCopy;
+    nWrites++;
+
+    return CE_None;
+}
+
+CPLErr GDALOvrJobBand::WriteTo( GDALRasterBand* poOverview )
+
+{
+    CPLErr eErr = CE_None;
+    for( int i = 0; i < nWrites && eErr == CE_None; i++ )
+    {
+        GDALOvrJobWrite* psWrite = pasWrites + i;
+        eErr = poOverview->RasterIO( GF_Write, psWrite->nXOff, psWrite->nYOff,
+                                     psWrite->nXSize, psWrite->nYSize,
+                                     psWrite->pData,
+                                     psWrite->nXSize, psWrite->nYSize,
+                                     psWrite->eBufType, 0, 0 );
+    }
+    return eErr;
+}
+
+/************************************************************************/
+/*                             GDALOvrJob                               */
+/************************************************************************/
+
+typedef struct
+{
+    /* NULL for complex data, processed by GDALDownsampleChunkC32R() */
+    GDALDownsampleFunction pfnDownsampleFn;
+    int             nSrcWidth;
+    int             nSrcHeight;
+    GDALDataType    eWrkDataType;
+    void           *pChunk;
+    GByte          *pabyChunkNodataMask;
+    int             nChunkXOff;
+    int             nChunkXSize;
+    int             nChunkYOff;
+    int             nChunkYSize;
+    GDALRasterBand *poOverview;
+    GDALOvrJobBand *poJobBand;
+    const char     *pszResampling;
+    int             bHasNoData;
+    float           fNoDataValue;
+    GDALColorTable *poColorTable;
+    GDALDataType    eSrcDataType;
+    CPLErr          eErr;
+} GDALOvrJob;
+
+static void GDALOvrJobRun( void* pData )
+
+{
+    GDALOvrJob* psJob = (GDALOvrJob*) pData;
+
+    if( psJob->pfnDownsampleFn != NULL )
+        psJob->eErr = psJob->pfnDownsampleFn( psJob->nSrcWidth,
+                                              psJob->nSrcHeight,
+                                              psJob->eWrkDataType,
+                                              psJob->pChunk,
+                                              psJob->pabyChunkNodataMask,
+                                              psJob->nChunkXOff,
+                                              psJob->nChunkXSize,
+                                              psJob->nChunkYOff,
+                                              psJob->nChunkYSize,
+                                              psJob->poJobBand,
+                                              psJob->pszResampling,
+                                              psJob->bHasNoData,
+                                              psJob->fNoDataValue,
+                                              psJob->poColorTable,
+                                              psJob->eSrcDataType );
+    else
+        psJob->eErr = GDALDownsampleChunkC32R( psJob->nSrcWidth,
+                                               psJob->nSrcHeight,
+                                               (float*) psJob->pChunk,
+                                               psJob->nChunkYOff,
+                                               psJob->nChunkYSize,
+                                               psJob->poJobBand,
+                                               psJob->pszResampling );
+}
+
+/************************************************************************/
+/*                       GDALOvrGetThreadCount()                        */
+/*                                                                      */
+/*      Overviews are computed in the calling thread, unless            */
+/*      GDAL_NUM_THREADS is set.                                        */
+/************************************************************************/
+
+static int GDALOvrGetThreadCount()
+
+{
+    const char* pszThreads = CPLGetConfigOption("GDAL_NUM_THREADS", "1");
+    int nThreads;
+    if( EQUAL(pszThreads, "ALL_CPUS") )
+        nThreads = CPLGetNumCPUs();
+    else
+        nThreads = atoi(pszThreads);
+    if( nThreads > 128 )
+        nThreads = 128;
+    return nThreads;
+}
+
+/************************************************************************/
+/*                         GDALOvrSubmitJob()                           */
+/************************************************************************/
+
+static void GDALOvrSubmitJob( CPLWorkerThreadPool* poThreadPool,
+                              CPLJobGroup* poJobGroup, GDALOvrJob* psJob )
+
+{
+    psJob->poJobBand = new GDALOvrJobBand( psJob->poOverview );
+    psJob->eErr = CE_None;
+    poThreadPool->SubmitJob( GDALOvrJobRun, psJob, poJobGroup );
+}
+
+/************************************************************************/
+/*                        GDALOvrFinishJobs()                           */
+/*                                                                      */
+/*      Wait for a group of jobs, and write their results to the        */
+/*      overview bands in submission order.                             */
+/************************************************************************/
+
+static CPLErr GDALOvrFinishJobs( CPLWorkerThreadPool* poThreadPool,
+                                 CPLJobGroup* poJobGroup,
+                                 GDALOvrJob* pasJobs, int nJobs,
+                                 CPLErr eErr )
+
+{
+    poThreadPool->WaitCompletion( poJobGroup );
+
+    for( int i = 0; i < nJobs; i++ )
+    {
+        if( eErr == CE_None )
+            eErr = pasJobs[i].eErr;
+        if( eErr == CE_None )
+            eErr = pasJobs[i].poJobBand->WriteTo( pasJobs[i].poOverview );
+        delete pasJobs[i].poJobBand;
+        pasJobs[i].poJobBand = NULL;
+    }
+
+    return eErr;
+}
+
 /************************************************************************/
 /*                      GDALRegenerateOverviews()                       */
 /************************************************************************/
@@ -1535,6 +1930,11 @@ static GDALDataType GDALGetOvrWorkDataType(const char* pszResampling,
  * that only a given RGB triplet (in case of a RGB image) will be considered as the
  * nodata value and not each value of the triplet independantly per band.
  *
+ * Starting with GDAL 2.0, if the GDAL_NUM_THREADS configuration option is set
+ * to a value greater than 1 (or ALL_CPUS), the downsampling is done by that
+ * many worker threads while the next source chunks are read.  The result is
+ * the same as with a single thread.
+ *
  * @param hSrcBand the source (base level) band. 
  * @param nOverviewCount the number of downsampled bands being generated.
  * @param pahOvrBands the list of downsampled bands to be generated.
@@ -1641,10 +2041,12 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
                                                  pProgressData );
 
 /* -------------------------------------------------------------------- */
-/*      Setup one horizontal swath to read from the raw buffer.         */
+/*      Setup one horizontal swath to read from the raw buffer, or      */
+/*      one per thread if the downsampling is done by worker threads    */
+/*      while the next swathes are read.                                */
 /* -------------------------------------------------------------------- */
-    void *pChunk;
-    GByte *pabyChunkNodataMask = NULL;
+    void **papChunks;
+    GByte **papabyChunkNodataMask;
 
     poSrcBand->GetBlockSize( &nFRXBlockSize, &nFRYBlockSize );
     
@@ -1659,36 +2061,87 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
         eType = GDALGetOvrWorkDataType(pszResampling, poSrcBand->GetRasterDataType());
 
     nWidth = poSrcBand->GetXSize();
-    pChunk = 
-        VSIMalloc3((GDALGetDataTypeSize(eType)/8), nFullResYChunk, nWidth );
-    if (bUseNoDataMask)
+
+    CPLWorkerThreadPool* poThreadPool = NULL;
+    int nThreads = GDALOvrGetThreadCount();
+    if( nThreads > 1 )
+        poThreadPool = CPLGetWorkerThreadPool( nThreads );
+    int nSlots = (poThreadPool != NULL) ? nThreads : 1;
+    int iSlot;
+    int bOutOfMemory = FALSE;
+
+    papChunks = (void **) CPLCalloc( nSlots, sizeof(void*) );
+    papabyChunkNodataMask = (GByte **) CPLCalloc( nSlots, sizeof(GByte*) );
+    for( iSlot = 0; iSlot < nSlots; iSlot++ )
     {
-        pabyChunkNodataMask = (GByte *) 
-            (GByte*) VSIMalloc2( nFullResYChunk, nWidth );
+        papChunks[iSlot] =
+            VSIMalloc3((GDALGetDataTypeSize(eType)/8), nFullResYChunk, nWidth );
+        if (bUseNoDataMask)
+        {
+            papabyChunkNodataMask[iSlot] = (GByte *) 
+                VSIMalloc2( nFullResYChunk, nWidth );
+        }
+
+        if( papChunks[iSlot] == NULL ||
+            (bUseNoDataMask && papabyChunkNodataMask[iSlot] == NULL) )
+            bOutOfMemory = TRUE;
     }
 
-    if( pChunk == NULL || (bUseNoDataMask && pabyChunkNodataMask == NULL))
+    if( bOutOfMemory )
     {
-        CPLFree(pChunk);
-        CPLFree(pabyChunkNodataMask);
+        for( iSlot = 0; iSlot < nSlots; iSlot++ )
+        {
+            CPLFree(papChunks[iSlot]);
+            CPLFree(papabyChunkNodataMask[iSlot]);
+        }
+        CPLFree(papChunks);
+        CPLFree(papabyChunkNodataMask);
         CPLError( CE_Failure, CPLE_OutOfMemory, 
                   "Out of memory in GDALRegenerateOverviews()." );
 
         return CE_Failure;
     }
 
+    GDALOvrJob* pasJobs = NULL;
+    CPLJobGroup* paoJobGroups = NULL;
+    int* pabSlotBusy = NULL;
+    if( poThreadPool != NULL )
+    {
+        CPLDebug( "GDAL", "Computing overviews with %d threads", nThreads );
+        pasJobs = (GDALOvrJob*)
+            CPLCalloc( nSlots * nOverviewCount, sizeof(GDALOvrJob) );
+        paoJobGroups = new CPLJobGroup[nSlots];
+        pabSlotBusy = (int*) CPLCalloc( nSlots, sizeof(int) );
+    }
+
     fNoDataValue = (float) poSrcBand->GetNoDataValue(&bHasNoData);
 
 /* -------------------------------------------------------------------- */
 /*      Loop over image operating on chunks.                            */
 /* -------------------------------------------------------------------- */
     int  nChunkYOff = 0;
+    int  iChunk = 0;
     CPLErr eErr = CE_None;
 
     for( nChunkYOff = 0; 
          nChunkYOff < poSrcBand->GetYSize() && eErr == CE_None; 
-         nChunkYOff += nFullResYChunk )
+         nChunkYOff += nFullResYChunk, iChunk++ )
     {
+        iSlot = iChunk % nSlots;
+        void* pChunk = papChunks[iSlot];
+        GByte* pabyChunkNodataMask = papabyChunkNodataMask[iSlot];
+
+        /* Wait for the jobs still using this swath */
+        if( pabSlotBusy != NULL && pabSlotBusy[iSlot] )
+        {
+            eErr = GDALOvrFinishJobs( poThreadPool, &paoJobGroups[iSlot],
+                                      pasJobs + iSlot * nOverviewCount,
+                                      nOverviewCount, eErr );
+            pabSlotBusy[iSlot] = FALSE;
+            if( eErr != CE_None )
+                break;
+        }
+
         if( !pfnProgress( nChunkYOff / (double) poSrcBand->GetYSize(), 
                           NULL, pProgressData ) )
         {
@@ -1765,6 +2218,37 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
                 CPLAssert(0);
         }
         
+        if( poThreadPool != NULL && eErr == CE_None )
+        {
+            for( int iOverview = 0; iOverview < nOverviewCount; iOverview++ )
+            {
+                GDALOvrJob* psJob = &pasJobs[iSlot * nOverviewCount + iOverview];
+
+                psJob->pfnDownsampleFn =
+                    ( eType == GDT_Byte || eType == GDT_Float32 ) ?
+                        pfnDownsampleFn : NULL;
+                psJob->nSrcWidth = nWidth;
+                psJob->nSrcHeight = poSrcBand->GetYSize();
+                psJob->eWrkDataType = eType;
+                psJob->pChunk = pChunk;
+                psJob->pabyChunkNodataMask = pabyChunkNodataMask;
+                psJob->nChunkXOff = 0;
+                psJob->nChunkXSize = nWidth;
+                psJob->nChunkYOff = nChunkYOff;
+                psJob->nChunkYSize = nFullResYChunk;
+                psJob->poOverview = papoOvrBands[iOverview];
+                psJob->pszResampling = pszResampling;
+                psJob->bHasNoData = bHasNoData;
+                psJob->fNoDataValue = fNoDataValue;
+                psJob->poColorTable = poColorTable;
+                psJob->eSrcDataType = poSrcBand->GetRasterDataType();
+
+                GDALOvrSubmitJob( poThreadPool, &paoJobGroups[iSlot], psJob );
+            }
+            pabSlotBusy[iSlot] = TRUE;
+            continue;
+        }
+
         for( int iOverview = 0; iOverview < nOverviewCount && eErr == CE_None; iOverview++ )
         {
             if( eType == GDT_Byte || eType == GDT_Float32 )
@@ -1784,8 +2268,31 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
         }
     }
 
-    VSIFree( pChunk );
-    VSIFree( pabyChunkNodataMask );
+/* -------------------------------------------------------------------- */
+/*      Wait for the remaining jobs, oldest first.                      */
+/* -------------------------------------------------------------------- */
+    if( poThreadPool != NULL )
+    {
+        for( int i = 0; i < nSlots; i++ )
+        {
+            iSlot = (iChunk + i) % nSlots;
+            if( pabSlotBusy[iSlot] )
+                eErr = GDALOvrFinishJobs( poThreadPool, &paoJobGroups[iSlot],
+                                          pasJobs + iSlot * nOverviewCount,
+                                          nOverviewCount, eErr );
+        }
+        CPLFree( pasJobs );
+        delete[] paoJobGroups;
+        CPLFree( pabSlotBusy );
+    }
+
+    for( iSlot = 0; iSlot < nSlots; iSlot++ )
+    {
+        VSIFree( papChunks[iSlot] );
+        VSIFree( papabyChunkNodataMask[iSlot] );
+    }
+    CPLFree( papChunks );
+    CPLFree( papabyChunkNodataMask );
     
 /* -------------------------------------------------------------------- */
 /*      Renormalized overview mean / stddev if needed.                  */
@@ -1847,6 +2354,10 @@ GDALRegenerateOverviews( GDALRasterBandH hSrcBand,
  * that only a given RGB triplet (in case of a RGB image) will be considered as the
  * nodata value and not each value of the triplet independantly per band.
  *
+ * Starting with GDAL 2.0, the GDAL_NUM_THREADS configuration option can be
+ * set to compute the overview blocks in worker threads, as with
+ * GDALRegenerateOverviews().
+ *
  * @param nBands the number of bands, size of papoSrcBands and size of
  *               first dimension of papapoOverviewBands
  * @param papoSrcBands the list of source bands to downsample
@@ -1967,6 +2478,13 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
         pafNoDataValue[iBand] = (float) papoSrcBands[iBand]->GetNoDataValue(&pabHasNoData[iBand]);
     }
 
+    CPLWorkerThreadPool* poThreadPool = NULL;
+    int nThreads = GDALOvrGetThreadCount();
+    if( nThreads > 1 )
+        poThreadPool = CPLGetWorkerThreadPool( nThreads );
+    if( poThreadPool != NULL )
+        CPLDebug( "GDAL", "Computing overviews with %d threads", nThreads );
+
     /* Second pass to do the real job ! */
     double dfCurPixelCount = 0;
     for(iOverview=0;iOverview<nOverviews && eErr == CE_None;iOverview++)
@@ -1993,44 +2511,60 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
         int nFullResXChunk = (nDstBlockXSize * nSrcWidth) / nDstWidth;
         int nFullResYChunk = (nDstBlockYSize * nSrcHeight) / nDstHeight;
 
-        void** papaChunk = (void**) CPLMalloc(nBands * sizeof(void*));
-        GByte* pabyChunkNoDataMask = NULL;
-        for(iBand=0;iBand<nBands;iBand++)
+        /* One set of chunks per thread when the downsampling is done by */
+        /* worker threads, while the next chunks are read */
+        int nSlots = (poThreadPool != NULL) ? nThreads : 1;
+        int iSlot;
+        int bOutOfMemory = FALSE;
+        void*** papapChunks = (void***) CPLCalloc(nSlots, sizeof(void**));
+        GByte** papabyChunkNoDataMask = (GByte**) CPLCalloc(nSlots, sizeof(GByte*));
+        for(iSlot=0;iSlot<nSlots;iSlot++)
         {
-            papaChunk[iBand] = VSIMalloc3(nFullResXChunk, nFullResYChunk, GDALGetDataTypeSize(eWrkDataType) / 8);
-            if( papaChunk[iBand] == NULL )
+            papapChunks[iSlot] = (void**) CPLCalloc(nBands, sizeof(void*));
+            for(iBand=0;iBand<nBands;iBand++)
             {
-                while ( --iBand >= 0)
-                    CPLFree(papaChunk[iBand]);
-                CPLFree(papaChunk);
-                CPLFree(pabHasNoData);
-                CPLFree(pafNoDataValue);
-
-                CPLError( CE_Failure, CPLE_OutOfMemory,
-                        "GDALRegenerateOverviewsMultiBand: Out of memory." );
-                return CE_Failure;
+                papapChunks[iSlot][iBand] = VSIMalloc3(nFullResXChunk, nFullResYChunk, GDALGetDataTypeSize(eWrkDataType) / 8);
+                if( papapChunks[iSlot][iBand] == NULL )
+                    bOutOfMemory = TRUE;
+            }
+            if (bUseNoDataMask)
+            {
+                papabyChunkNoDataMask[iSlot] = (GByte*) VSIMalloc2(nFullResXChunk, nFullResYChunk);
+                if( papabyChunkNoDataMask[iSlot] == NULL )
+                    bOutOfMemory = TRUE;
             }
         }
-        if (bUseNoDataMask)
+        if( bOutOfMemory )
         {
-            pabyChunkNoDataMask = (GByte*) VSIMalloc2(nFullResXChunk, nFullResYChunk);
-            if( pabyChunkNoDataMask == NULL )
+            for(iSlot=0;iSlot<nSlots;iSlot++)
             {
                 for(iBand=0;iBand<nBands;iBand++)
-                {
-                    CPLFree(papaChunk[iBand]);
-                }
-                CPLFree(papaChunk);
-                CPLFree(pabHasNoData);
-                CPLFree(pafNoDataValue);
-
-                CPLError( CE_Failure, CPLE_OutOfMemory,
-                        "GDALRegenerateOverviewsMultiBand: Out of memory." );
-                return CE_Failure;
+                    CPLFree(papapChunks[iSlot][iBand]);
+                CPLFree(papapChunks[iSlot]);
+                CPLFree(papabyChunkNoDataMask[iSlot]);
             }
+            CPLFree(papapChunks);
+            CPLFree(papabyChunkNoDataMask);
+            CPLFree(pabHasNoData);
+            CPLFree(pafNoDataValue);
+
+            CPLError( CE_Failure, CPLE_OutOfMemory,
+                    "GDALRegenerateOverviewsMultiBand: Out of memory." );
+            return CE_Failure;
+        }
+
+        GDALOvrJob* pasJobs = NULL;
+        CPLJobGroup* paoJobGroups = NULL;
+        int* pabSlotBusy = NULL;
+        if( poThreadPool != NULL )
+        {
+            pasJobs = (GDALOvrJob*) CPLCalloc(nSlots * nBands, sizeof(GDALOvrJob));
+            paoJobGroups = new CPLJobGroup[nSlots];
+            pabSlotBusy = (int*) CPLCalloc(nSlots, sizeof(int));
         }
 
         int nChunkYOff;
+        int iChunk = 0;
         /* Iterate on destination overview, block by block */
         for( nChunkYOff = 0; nChunkYOff < nSrcHeight && eErr == CE_None; nChunkYOff += nFullResYChunk )
         {
@@ -2048,7 +2582,7 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
             }
 
             int nChunkXOff;
-            for( nChunkXOff = 0; nChunkXOff < nSrcWidth && eErr == CE_None; nChunkXOff += nFullResXChunk )
+            for( nChunkXOff = 0; nChunkXOff < nSrcWidth && eErr == CE_None; nChunkXOff += nFullResXChunk, iChunk++ )
             {
                 int nXCount;
                 if  (nChunkXOff + nFullResXChunk <= nSrcWidth)
@@ -2056,6 +2590,21 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
                 else
                     nXCount = nSrcWidth - nChunkXOff;
 
+                iSlot = iChunk % nSlots;
+                void** papaChunk = papapChunks[iSlot];
+                GByte* pabyChunkNoDataMask = papabyChunkNoDataMask[iSlot];
+
+                /* Wait for the jobs still using this set of chunks */
+                if( pabSlotBusy != NULL && pabSlotBusy[iSlot] )
+                {
+                    eErr = GDALOvrFinishJobs( poThreadPool, &paoJobGroups[iSlot],
+                                              pasJobs + iSlot * nBands,
+                                              nBands, eErr );
+                    pabSlotBusy[iSlot] = FALSE;
+                    if( eErr != CE_None )
+                        break;
+                }
+
                 /* Read the source buffers for all the bands */
                 for(iBand=0;iBand<nBands && eErr == CE_None;iBand++)
                 {
@@ -2087,6 +2636,37 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
                                                                GDT_Byte, 0, 0 );
                 }
 
+                /* Compute the resulting overview block in worker threads */
+                if( poThreadPool != NULL && eErr == CE_None )
+                {
+                    for(iBand=0;iBand<nBands;iBand++)
+                    {
+                        GDALOvrJob* psJob = &pasJobs[iSlot * nBands + iBand];
+
+                        psJob->pfnDownsampleFn = pfnDownsampleFn;
+                        psJob->nSrcWidth = nSrcWidth;
+                        psJob->nSrcHeight = nSrcHeight;
+                        psJob->eWrkDataType = eWrkDataType;
+                        psJob->pChunk = papaChunk[iBand];
+                        psJob->pabyChunkNodataMask = pabyChunkNoDataMask;
+                        psJob->nChunkXOff = nChunkXOff;
+                        psJob->nChunkXSize = nXCount;
+                        psJob->nChunkYOff = nChunkYOff;
+                        psJob->nChunkYSize = nYCount;
+                        psJob->poOverview = papapoOverviewBands[iBand][iOverview];
+                        psJob->pszResampling = pszResampling;
+                        psJob->bHasNoData = pabHasNoData[iBand];
+                        psJob->fNoDataValue = pafNoDataValue[iBand];
+                        psJob->poColorTable = NULL;
+                        psJob->eSrcDataType = eDataType;
+
+                        GDALOvrSubmitJob( poThreadPool, &paoJobGroups[iSlot],
+                                          psJob );
+                    }
+                    pabSlotBusy[iSlot] = TRUE;
+                    continue;
+                }
+
                 /* Compute the resulting overview block */
                 for(iBand=0;iBand<nBands && eErr == CE_None;iBand++)
                 {
@@ -2108,14 +2688,37 @@ GDALRegenerateOverviewsMultiBand(int nBands, GDALRasterBand** papoSrcBands,
             dfCurPixelCount += (double)nYCount * nSrcWidth;
         }
 
+        /* Wait for the remaining jobs, oldest first, as the next level */
+        /* may be computed from this one */
+        if( poThreadPool != NULL )
+        {
+            for( int i = 0; i < nSlots; i++ )
+            {
+                iSlot = (iChunk + i) % nSlots;
+                if( pabSlotBusy[iSlot] )
+                    eErr = GDALOvrFinishJobs( poThreadPool, &paoJobGroups[iSlot],
+                                              pasJobs + iSlot * nBands,
+                                              nBands, eErr );
+            }
+            CPLFree(pasJobs);
+            delete[] paoJobGroups;
+            CPLFree(pabSlotBusy);
+        }
+
         /* Flush the data to overviews */
         for(iBand=0;iBand<nBands;iBand++)
         {
-            CPLFree(papaChunk[iBand]);
             papapoOverviewBands[iBand][iOverview]->FlushCache();
         }
-        CPLFree(papaChunk);
-        CPLFree(pabyChunkNoDataMask);
+        for(iSlot=0;iSlot<nSlots;iSlot++)
+        {
+            for(iBand=0;iBand<nBands;iBand++)
+                CPLFree(papapChunks[iSlot][iBand]);
+            CPLFree(papapChunks[iSlot]);
+            CPLFree(papabyChunkNoDataMask[iSlot]);
+        }
+        CPLFree(papapChunks);
+        CPLFree(papabyChunkNoDataMask);
 
     }
 
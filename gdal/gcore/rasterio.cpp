@@ -30,6 +30,8 @@
  ****************************************************************************/
 
 #include "gdal_priv.h"
+#include "cpl_multiproc.h"
+#include <vector>
 
 // Define a list of "C++" compilers that have broken template support or
 // broken scoping so we can fall back on the legacy implementation of
@@ -47,6 +49,13 @@
 #define USE_NEW_COPYWORDS 1
 #endif
 
+// SSE2 is part of the x86_64 instruction set, so no runtime check is needed
+// for the packed conversion kernels of GDALCopyWords().
+#if defined(USE_NEW_COPYWORDS) && (defined(__x86_64) || defined(_M_X64))
+#define HAVE_SSE2_COPYWORDS 1
+#include <emmintrin.h>
+#endif
+
 
 CPL_CVSID("$Id$");
 
@@ -863,9 +872,9 @@ inline void CopyWord(const float fValueIn, unsigned int &nValueOut)
  */
 
 template <class Tin, class Tout>
-static void GDALCopyWordsT(const Tin* const pSrcData, int nSrcPixelStride,
-                           Tout* const pDstData, int nDstPixelStride,
-                           int nWordCount)
+static void GDALCopyWordsGenericT(const Tin* const pSrcData, int nSrcPixelStride,
+                                  Tout* const pDstData, int nDstPixelStride,
+                                  int nWordCount)
 {
     std::ptrdiff_t nDstOffset = 0;
 
@@ -882,6 +891,252 @@ static void GDALCopyWordsT(const Tin* const pSrcData, int nSrcPixelStride,
     }
 }
 
+template <class Tin, class Tout>
+static void GDALCopyWordsT(const Tin* const pSrcData, int nSrcPixelStride,
+                           Tout* const pDstData, int nDstPixelStride,
+                           int nWordCount)
+{
+    GDALCopyWordsGenericT(pSrcData, nSrcPixelStride,
+                          pDstData, nDstPixelStride, nWordCount);
+}
+
+#ifdef HAVE_SSE2_COPYWORDS
+
+/************************************************************************/
+/*                     SSE2 packed conversion kernels                   */
+/************************************************************************/
+/*
+ * Each kernel converts as many words as possible by groups of 8 or 16,
+ * with the same rounding and clamping rules as CopyWord(), including for
+ * NaN that are converted to 0, and returns the number of words processed.
+ * The remaining ones are processed by GDALCopyWordsGenericT().
+ */
+
+/* Replace NaN by 0, as the scalar code ends up doing */
+static inline __m128 GDALSSE2ZeroNaN(__m128 xmm)
+{
+    return _mm_and_ps(xmm, _mm_cmpeq_ps(xmm, xmm));
+}
+
+/* Round half up and clamp to [xmm_min, xmm_max], and truncate */
+static inline __m128i GDALSSE2RoundClampPositive(const float* pSrc,
+                                                  __m128 xmm_min,
+                                                  __m128 xmm_max)
+{
+    __m128 xmm = GDALSSE2ZeroNaN(_mm_loadu_ps(pSrc));
+    xmm = _mm_add_ps(xmm, _mm_set1_ps(0.5f));
+    xmm = _mm_min_ps(_mm_max_ps(xmm, xmm_min), xmm_max);
+    return _mm_cvttps_epi32(xmm);
+}
+
+static int GDALCopyFloat32ToByteSSE2(const float* pSrc, GByte* pDst,
+                                     int nWordCount)
+{
+    const __m128 xmm_min = _mm_setzero_ps();
+    const __m128 xmm_max = _mm_set1_ps(255.0f);
+    int n = 0;
+    for( ; n + 16 <= nWordCount; n += 16 )
+    {
+        __m128i xmm0 = GDALSSE2RoundClampPositive(pSrc + n, xmm_min, xmm_max);
+        __m128i xmm1 = GDALSSE2RoundClampPositive(pSrc + n + 4, xmm_min, xmm_max);
+        __m128i xmm2 = GDALSSE2RoundClampPositive(pSrc + n + 8, xmm_min, xmm_max);
+        __m128i xmm3 = GDALSSE2RoundClampPositive(pSrc + n + 12, xmm_min, xmm_max);
+        xmm0 = _mm_packs_epi32(xmm0, xmm1);
+        xmm2 = _mm_packs_epi32(xmm2, xmm3);
+        _mm_storeu_si128((__m128i*)(pDst + n), _mm_packus_epi16(xmm0, xmm2));
+    }
+    return n;
+}
+
+static int GDALCopyFloat32ToUInt16SSE2(const float* pSrc, GUInt16* pDst,
+                                       int nWordCount)
+{
+    const __m128 xmm_min = _mm_setzero_ps();
+    const __m128 xmm_max = _mm_set1_ps(65535.0f);
+    /* No unsigned saturated 32->16 packing in SSE2: shift into the */
+    /* signed range and back */
+    const __m128i xmm_bias32 = _mm_set1_epi32(32768);
+    const __m128i xmm_bias16 = _mm_set1_epi16((short)0x8000);
+    int n = 0;
+    for( ; n + 8 <= nWordCount; n += 8 )
+    {
+        __m128i xmm0 = GDALSSE2RoundClampPositive(pSrc + n, xmm_min, xmm_max);
+        __m128i xmm1 = GDALSSE2RoundClampPositive(pSrc + n + 4, xmm_min, xmm_max);
+        xmm0 = _mm_sub_epi32(xmm0, xmm_bias32);
+        xmm1 = _mm_sub_epi32(xmm1, xmm_bias32);
+        xmm0 = _mm_xor_si128(_mm_packs_epi32(xmm0, xmm1), xmm_bias16);
+        _mm_storeu_si128((__m128i*)(pDst + n), xmm0);
+    }
+    return n;
+}
+
+static int GDALCopyFloat32ToInt16SSE2(const float* pSrc, GInt16* pDst,
+                                      int nWordCount)
+{
+    const __m128 xmm_min = _mm_set1_ps(-32768.0f);
+    const __m128 xmm_max = _mm_set1_ps(32767.0f);
+    const __m128 xmm_sign = _mm_set1_ps(-0.0f);
+    const __m128 xmm_half = _mm_set1_ps(0.5f);
+    int n = 0;
+    for( ; n + 8 <= nWordCount; n += 8 )
+    {
+        __m128i axmm[2];
+        for( int i = 0; i < 2; i++ )
+        {
+            __m128 xmm = GDALSSE2ZeroNaN(_mm_loadu_ps(pSrc + n + 4 * i));
+            /* Round half away from zero */
+            xmm = _mm_add_ps(xmm, _mm_or_ps(_mm_and_ps(xmm, xmm_sign), xmm_half));
+            xmm = _mm_min_ps(_mm_max_ps(xmm, xmm_min), xmm_max);
+            axmm[i] = _mm_cvttps_epi32(xmm);
+        }
+        _mm_storeu_si128((__m128i*)(pDst + n), _mm_packs_epi32(axmm[0], axmm[1]));
+    }
+    return n;
+}
+
+static int GDALCopyByteToFloat32SSE2(const GByte* pSrc, float* pDst,
+                                     int nWordCount)
+{
+    const __m128i xmm_zero = _mm_setzero_si128();
+    int n = 0;
+    for( ; n + 16 <= nWordCount; n += 16 )
+    {
+        __m128i xmm = _mm_loadu_si128((const __m128i*)(pSrc + n));
+        __m128i xmm_lo = _mm_unpacklo_epi8(xmm, xmm_zero);
+        __m128i xmm_hi = _mm_unpackhi_epi8(xmm, xmm_zero);
+        _mm_storeu_ps(pDst + n,
+                      _mm_cvtepi32_ps(_mm_unpacklo_epi16(xmm_lo, xmm_zero)));
+        _mm_storeu_ps(pDst + n + 4,
+                      _mm_cvtepi32_ps(_mm_unpackhi_epi16(xmm_lo, xmm_zero)));
+        _mm_storeu_ps(pDst + n + 8,
+                      _mm_cvtepi32_ps(_mm_unpacklo_epi16(xmm_hi, xmm_zero)));
+        _mm_storeu_ps(pDst + n + 12,
+                      _mm_cvtepi32_ps(_mm_unpackhi_epi16(xmm_hi, xmm_zero)));
+    }
+    return n;
+}
+
+static int GDALCopyUInt16ToFloat32SSE2(const GUInt16* pSrc, float* pDst,
+                                       int nWordCount)
+{
+    const __m128i xmm_zero = _mm_setzero_si128();
+    int n = 0;
+    for( ; n + 8 <= nWordCount; n += 8 )
+    {
+        __m128i xmm = _mm_loadu_si128((const __m128i*)(pSrc + n));
+        _mm_storeu_ps(pDst + n,
+                      _mm_cvtepi32_ps(_mm_unpacklo_epi16(xmm, xmm_zero)));
+        _mm_storeu_ps(pDst + n + 4,
+                      _mm_cvtepi32_ps(_mm_unpackhi_epi16(xmm, xmm_zero)));
+    }
+    return n;
+}
+
+static int GDALCopyInt16ToFloat32SSE2(const GInt16* pSrc, float* pDst,
+                                      int nWordCount)
+{
+    int n = 0;
+    for( ; n + 8 <= nWordCount; n += 8 )
+    {
+        __m128i xmm = _mm_loadu_si128((const __m128i*)(pSrc + n));
+        /* Sign extend by putting the value in the upper half and shifting */
+        __m128i xmm_lo = _mm_srai_epi32(_mm_unpacklo_epi16(xmm, xmm), 16);
+        __m128i xmm_hi = _mm_srai_epi32(_mm_unpackhi_epi16(xmm, xmm), 16);
+        _mm_storeu_ps(pDst + n, _mm_cvtepi32_ps(xmm_lo));
+        _mm_storeu_ps(pDst + n + 4, _mm_cvtepi32_ps(xmm_hi));
+    }
+    return n;
+}
+
+static int GDALCopyUInt16ToByteSSE2(const GUInt16* pSrc, GByte* pDst,
+                                    int nWordCount)
+{
+    const __m128i xmm_255 = _mm_set1_epi16(255);
+    int n = 0;
+    for( ; n + 16 <= nWordCount; n += 16 )
+    {
+        __m128i xmm0 = _mm_loadu_si128((const __m128i*)(pSrc + n));
+        __m128i xmm1 = _mm_loadu_si128((const __m128i*)(pSrc + n + 8));
+        /* Unsigned min(x, 255) computed as x - max(x - 255, 0) */
+        xmm0 = _mm_sub_epi16(xmm0, _mm_subs_epu16(xmm0, xmm_255));
+        xmm1 = _mm_sub_epi16(xmm1, _mm_subs_epu16(xmm1, xmm_255));
+        _mm_storeu_si128((__m128i*)(pDst + n), _mm_packus_epi16(xmm0, xmm1));
+    }
+    return n;
+}
+
+static int GDALCopyInt16ToByteSSE2(const GInt16* pSrc, GByte* pDst,
+                                   int nWordCount)
+{
+    int n = 0;
+    for( ; n + 16 <= nWordCount; n += 16 )
+    {
+        __m128i xmm0 = _mm_loadu_si128((const __m128i*)(pSrc + n));
+        __m128i xmm1 = _mm_loadu_si128((const __m128i*)(pSrc + n + 8));
+        _mm_storeu_si128((__m128i*)(pDst + n), _mm_packus_epi16(xmm0, xmm1));
+    }
+    return n;
+}
+
+static int GDALCopyByteToInt16SSE2(const GByte* pSrc, GInt16* pDst,
+                                   int nWordCount)
+{
+    const __m128i xmm_zero = _mm_setzero_si128();
+    int n = 0;
+    for( ; n + 16 <= nWordCount; n += 16 )
+    {
+        __m128i xmm = _mm_loadu_si128((const __m128i*)(pSrc + n));
+        _mm_storeu_si128((__m128i*)(pDst + n), _mm_unpacklo_epi8(xmm, xmm_zero));
+        _mm_storeu_si128((__m128i*)(pDst + n + 8), _mm_unpackhi_epi8(xmm, xmm_zero));
+    }
+    return n;
+}
+
+/************************************************************************/
+/*              GDALCopyWordsT() specializations for SSE2               */
+/************************************************************************/
+
+#define DEFINE_SSE2_COPYWORDS(Tin, Tout, pfnKernel, pSrcCast, pDstCast)   \
+template<>                                                                \
+void GDALCopyWordsT(const Tin* const pSrcData, int nSrcPixelStride,       \
+                    Tout* const pDstData, int nDstPixelStride,            \
+                    int nWordCount)                                       \
+{                                                                         \
+    int n = 0;                                                            \
+    if( nSrcPixelStride == (int)sizeof(Tin) &&                            \
+        nDstPixelStride == (int)sizeof(Tout) )                            \
+    {                                                                     \
+        n = pfnKernel((pSrcCast) pSrcData, (pDstCast) pDstData,           \
+                      nWordCount);                                        \
+    }                                                                     \
+    GDALCopyWordsGenericT(pSrcData + n, nSrcPixelStride,                  \
+                          pDstData + n, nDstPixelStride,                  \
+                          nWordCount - n);                                \
+}
+
+DEFINE_SSE2_COPYWORDS(float, unsigned char, GDALCopyFloat32ToByteSSE2,
+                      const float*, GByte*)
+DEFINE_SSE2_COPYWORDS(float, unsigned short, GDALCopyFloat32ToUInt16SSE2,
+                      const float*, GUInt16*)
+DEFINE_SSE2_COPYWORDS(float, short, GDALCopyFloat32ToInt16SSE2,
+                      const float*, GInt16*)
+DEFINE_SSE2_COPYWORDS(unsigned char, float, GDALCopyByteToFloat32SSE2,
+                      const GByte*, float*)
+DEFINE_SSE2_COPYWORDS(unsigned short, float, GDALCopyUInt16ToFloat32SSE2,
+                      const GUInt16*, float*)
+DEFINE_SSE2_COPYWORDS(short, float, GDALCopyInt16ToFloat32SSE2,
+                      const GInt16*, float*)
+DEFINE_SSE2_COPYWORDS(unsigned short, unsigned char, GDALCopyUInt16ToByteSSE2,
+                      const GUInt16*, GByte*)
+DEFINE_SSE2_COPYWORDS(short, unsigned char, GDALCopyInt16ToByteSSE2,
+                      const GInt16*, GByte*)
+DEFINE_SSE2_COPYWORDS(unsigned char, short, GDALCopyByteToInt16SSE2,
+                      const GByte*, GInt16*)
+DEFINE_SSE2_COPYWORDS(unsigned char, unsigned short, GDALCopyByteToInt16SSE2,
+                      const GByte*, GInt16*)
+
+#endif /* HAVE_SSE2_COPYWORDS */
+
 /************************************************************************/
 /*                   GDALCopyWordsComplexT()                            */
 /************************************************************************/
@@ -905,6 +1160,17 @@ inline void GDALCopyWordsComplexT(const Tin* const pSrcData, int nSrcPixelStride
                                   Tout* const pDstData, int nDstPixelStride,
                                   int nWordCount)
 {
+    // Packed complex buffers are packed buffers of twice as many real
+    // words, which may benefit from the specialized GDALCopyWordsT().
+    if( nSrcPixelStride == (int)(2 * sizeof(Tin)) &&
+        nDstPixelStride == (int)(2 * sizeof(Tout)) &&
+        nWordCount < INT_MAX / 2 )
+    {
+        GDALCopyWordsT(pSrcData, (int)sizeof(Tin),
+                       pDstData, (int)sizeof(Tout), nWordCount * 2);
+        return;
+    }
+
     std::ptrdiff_t nDstOffset = 0;
     const char* const pSrcDataPtr = reinterpret_cast<const char*>(pSrcData);
     char* const pDstDataPtr = reinterpret_cast<char*>(pDstData);
@@ -2812,6 +3078,321 @@ static void GDALCopyWholeRasterGetSwathSize(GDALRasterBand *poSrcPrototypeBand,
     *pnSwathLines = nSwathLines;
 }
 
+/************************************************************************/
+/*                            GDALCopySwath                             */
+/************************************************************************/
+
+typedef struct
+{
+    int         nBand;      /* band number, or 0 for all bands interleaved */
+    int         nXOff;
+    int         nYOff;
+    int         nXSize;
+    int         nYSize;
+    double      dfProgress; /* progress once the swath is written */
+} GDALCopySwath;
+
+/************************************************************************/
+/*                           GDALCopySwathIO()                          */
+/************************************************************************/
+
+static CPLErr GDALCopySwathIO( GDALRWFlag eRWFlag,
+                               GDALDataset *poDS, GDALRasterBand *poBand,
+                               int nBandCount, GDALDataType eDT,
+                               const GDALCopySwath *psSwath, void *pBuffer )
+{
+    if( poBand != NULL )
+        return poBand->RasterIO( eRWFlag,
+                                 psSwath->nXOff, psSwath->nYOff,
+                                 psSwath->nXSize, psSwath->nYSize,
+                                 pBuffer, psSwath->nXSize, psSwath->nYSize,
+                                 eDT, 0, 0 );
+
+    int nBand = psSwath->nBand;
+    return poDS->RasterIO( eRWFlag,
+                           psSwath->nXOff, psSwath->nYOff,
+                           psSwath->nXSize, psSwath->nYSize,
+                           pBuffer, psSwath->nXSize, psSwath->nYSize,
+                           eDT, (nBand > 0) ? 1 : nBandCount,
+                           (nBand > 0) ? &nBand : NULL,
+                           0, 0, 0 );
+}
+
+/************************************************************************/
+/*                         GDALCopySwathReadJob                         */
+/************************************************************************/
+
+typedef struct
+{
+    GDALDataset         *poSrcDS;
+    GDALRasterBand      *poSrcBand;
+    int                  nBandCount;
+    GDALDataType         eDT;
+    const GDALCopySwath *psSwath;
+    void                *pBuffer;
+    CPLErr               eErr;
+} GDALCopySwathReadJob;
+
+static void GDALCopySwathReadJobRun( void *pData )
+{
+    GDALCopySwathReadJob *psJob = (GDALCopySwathReadJob *) pData;
+
+    /* The destination dataset is written by another thread, so its */
+    /* dirty blocks must not be flushed by the evictions of this one */
+    GDALRasterBlock::EnterDisableDirtyBlockFlush();
+    psJob->eErr = GDALCopySwathIO( GF_Read, psJob->poSrcDS, psJob->poSrcBand,
+                                   psJob->nBandCount, psJob->eDT,
+                                   psJob->psSwath, psJob->pBuffer );
+    GDALRasterBlock::LeaveDisableDirtyBlockFlush();
+}
+
+/************************************************************************/
+/*                       GDALCopySwathSubmitRead()                      */
+/************************************************************************/
+
+static void GDALCopySwathSubmitRead( CPLWorkerThreadPool *poThreadPool,
+                                     GDALCopySwathReadJob *psJob,
+                                     CPLJobGroup *poJobGroup,
+                                     GDALDataset *poSrcDS,
+                                     GDALRasterBand *poSrcBand,
+                                     int nBandCount, GDALDataType eDT,
+                                     const GDALCopySwath *psSwath,
+                                     void *pBuffer )
+{
+    psJob->poSrcDS = poSrcDS;
+    psJob->poSrcBand = poSrcBand;
+    psJob->nBandCount = nBandCount;
+    psJob->eDT = eDT;
+    psJob->psSwath = psSwath;
+    psJob->pBuffer = pBuffer;
+    psJob->eErr = CE_None;
+    poThreadPool->SubmitJob( GDALCopySwathReadJobRun, psJob, poJobGroup );
+}
+
+/************************************************************************/
+/*                   GDALCopyWholeRasterGetThreadCount()                */
+/*                                                                      */
+/*      Threaded copies are an explicit opt-in, through the NUM_THREADS */
+/*      option or the GDAL_COPY_NUM_THREADS configuration option, and   */
+/*      are not enabled by the general GDAL_NUM_THREADS option.         */
+/************************************************************************/
+
+static int GDALCopyWholeRasterGetThreadCount( char **papszOptions )
+{
+    const char *pszThreads = CSLFetchNameValue( papszOptions, "NUM_THREADS" );
+    if( pszThreads == NULL )
+        pszThreads = CPLGetConfigOption( "GDAL_COPY_NUM_THREADS", "1" );
+
+    int nThreads;
+    if( EQUAL(pszThreads, "ALL_CPUS") )
+        nThreads = CPLGetNumCPUs();
+    else
+        nThreads = atoi(pszThreads);
+    if( nThreads > 128 )
+        nThreads = 128;
+    return nThreads;
+}
+
+/************************************************************************/
+/*                    GDALCopyWholeRasterOpenReaders()                  */
+/*                                                                      */
+/*      Open additional read-only handles on the source dataset, so     */
+/*      that several swaths can be read at the same time. Only done     */
+/*      for sources that can be reopened identically.                   */
+/************************************************************************/
+
+static void GDALCopyWholeRasterOpenReaders( GDALDataset *poSrcDS, int nReaders,
+                                            std::vector<GDALDataset*> &apoReaders )
+{
+    for( int i = 1; i < nReaders; i++ )
+    {
+        GDALDataset *poReader = GDALReopenDatasetForReading( poSrcDS );
+        if( poReader == NULL )
+            break;
+        apoReaders.push_back( poReader );
+    }
+}
+
+/************************************************************************/
+/*                      GDALCopyWholeRasterSwaths()                     */
+/*                                                                      */
+/*      Copy the swaths from the source dataset (or band) to the        */
+/*      destination.  When several threads are allowed, the next        */
+/*      swaths are read in worker threads while the current one is      */
+/*      written, so that the copy is bounded by the slower of reading   */
+/*      and writing rather than their sum.                              */
+/************************************************************************/
+
+static CPLErr GDALCopyWholeRasterSwaths( GDALDataset *poSrcDS,
+                                         GDALRasterBand *poSrcBand,
+                                         GDALDataset *poDstDS,
+                                         GDALRasterBand *poDstBand,
+                                         int nBandCount, GDALDataType eDT,
+                                         const std::vector<GDALCopySwath> &asSwaths,
+                                         void *pSwathBuf, size_t nSwathBufSize,
+                                         int nThreads,
+                                         GDALProgressFunc pfnProgress,
+                                         void *pProgressData )
+{
+    const int nSwaths = (int) asSwaths.size();
+    CPLErr eErr = CE_None;
+
+/* -------------------------------------------------------------------- */
+/*      Reads happen in worker threads while the main thread writes,    */
+/*      so only do that for sources whose driver is known to support    */
+/*      it.                                                             */
+/* -------------------------------------------------------------------- */
+    if( nThreads > 1 )
+    {
+        GDALDataset *poSrcDSForDriver =
+            (poSrcDS != NULL) ? poSrcDS : poSrcBand->GetDataset();
+        GDALDriver *poSrcDriver =
+            (poSrcDSForDriver != NULL) ? poSrcDSForDriver->GetDriver() : NULL;
+        if( !GDALDriverSupportsConcurrentReads( poSrcDriver ) )
+        {
+            CPLDebug( "GDAL", "GDALCopyWholeRasterSwaths(): source driver %s "
+                      "does not support concurrent reads, using 1 thread",
+                      (poSrcDriver != NULL) ? poSrcDriver->GetDescription() : "(none)" );
+            nThreads = 1;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Set up the readers and their buffers.  All the swath buffers    */
+/*      together are bounded by half of the block cache size, except    */
+/*      that the read-ahead buffer is always allowed.                   */
+/* -------------------------------------------------------------------- */
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    std::vector<GDALDataset*> apoReaders;
+    std::vector<void*> apBuffers;
+
+    apBuffers.push_back( pSwathBuf );
+    if( nThreads > 1 && nSwaths > 1 )
+    {
+        GIntBig nMaxBuffers = (GDALGetCacheMax64() / 2) / MAX(1, (GIntBig)nSwathBufSize);
+        int nMaxReaders = (int) MIN( (GIntBig)nThreads - 1, MAX(2, nMaxBuffers) - 1 );
+
+        poThreadPool = CPLGetWorkerThreadPool( nMaxReaders );
+        if( poSrcDS != NULL && poThreadPool != NULL )
+            GDALCopyWholeRasterOpenReaders( poSrcDS, nMaxReaders, apoReaders );
+
+        const int nReaders = 1 + (int) apoReaders.size();
+        for( int i = 0; poThreadPool != NULL && i < nReaders; i++ )
+        {
+            void *pBuffer = VSIMalloc( nSwathBufSize );
+            if( pBuffer == NULL )
+                break;
+            apBuffers.push_back( pBuffer );
+        }
+        /* Not enough memory : keep as many readers as we have spare buffers */
+        while( !apoReaders.empty() &&
+               (int) apBuffers.size() < (int) apoReaders.size() + 2 )
+        {
+            GDALClose( (GDALDatasetH) apoReaders.back() );
+            apoReaders.pop_back();
+        }
+        if( apBuffers.size() < 2 )
+            poThreadPool = NULL;
+    }
+
+/* ==================================================================== */
+/*      Synchronous case : read then write each swath.                  */
+/* ==================================================================== */
+    if( poThreadPool == NULL )
+    {
+        for( int i = 0; i < nSwaths && eErr == CE_None; i++ )
+        {
+            eErr = GDALCopySwathIO( GF_Read, poSrcDS, poSrcBand, nBandCount,
+                                    eDT, &asSwaths[i], pSwathBuf );
+
+            if( eErr == CE_None )
+                eErr = GDALCopySwathIO( GF_Write, poDstDS, poDstBand, nBandCount,
+                                        eDT, &asSwaths[i], pSwathBuf );
+
+            if( eErr == CE_None
+                && !pfnProgress( asSwaths[i].dfProgress, NULL, pProgressData ) )
+            {
+                eErr = CE_Failure;
+                CPLError( CE_Failure, CPLE_UserInterrupt,
+                          "User terminated CreateCopy()" );
+            }
+        }
+        return eErr;
+    }
+
+/* ==================================================================== */
+/*      Pipelined case : swath i uses buffer i % nBuffers and is read   */
+/*      by reader i % nReaders, while up to nReaders swaths after the   */
+/*      one being written are read.                                     */
+/* ==================================================================== */
+    const int nReaders = 1 + (int) apoReaders.size();
+    const int nBuffers = nReaders + 1;
+
+    CPLDebug( "GDAL", "GDALCopyWholeRasterSwaths(): %d reader(s), %d buffers",
+              nReaders, nBuffers );
+
+    std::vector<GDALCopySwathReadJob> asJobs( nBuffers );
+    CPLJobGroup *paoJobGroups = new CPLJobGroup[nBuffers];
+
+    int iNextRead;
+    for( iNextRead = 0; iNextRead < nSwaths && iNextRead < nReaders; iNextRead++ )
+    {
+        int iReader = iNextRead % nReaders;
+        GDALCopySwathSubmitRead( poThreadPool, &asJobs[iNextRead % nBuffers],
+                                 &paoJobGroups[iNextRead % nBuffers],
+                                 (iReader == 0) ? poSrcDS : apoReaders[iReader - 1],
+                                 poSrcBand, nBandCount, eDT,
+                                 &asSwaths[iNextRead],
+                                 apBuffers[iNextRead % nBuffers] );
+    }
+
+    for( int i = 0; i < nSwaths && eErr == CE_None; i++ )
+    {
+        const int iSlot = i % nBuffers;
+        poThreadPool->WaitCompletion( &paoJobGroups[iSlot] );
+        eErr = asJobs[iSlot].eErr;
+        if( eErr != CE_None )
+            break;
+
+        if( iNextRead < nSwaths )
+        {
+            int iReader = iNextRead % nReaders;
+            GDALCopySwathSubmitRead( poThreadPool, &asJobs[iNextRead % nBuffers],
+                                     &paoJobGroups[iNextRead % nBuffers],
+                                     (iReader == 0) ? poSrcDS : apoReaders[iReader - 1],
+                                     poSrcBand, nBandCount, eDT,
+                                     &asSwaths[iNextRead],
+                                     apBuffers[iNextRead % nBuffers] );
+            iNextRead ++;
+        }
+
+        eErr = GDALCopySwathIO( GF_Write, poDstDS, poDstBand, nBandCount,
+                                eDT, &asSwaths[i], apBuffers[iSlot] );
+
+        if( eErr == CE_None
+            && !pfnProgress( asSwaths[i].dfProgress, NULL, pProgressData ) )
+        {
+            eErr = CE_Failure;
+            CPLError( CE_Failure, CPLE_UserInterrupt,
+                      "User terminated CreateCopy()" );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Wait for the reads still in flight before releasing buffers.    */
+/* -------------------------------------------------------------------- */
+    for( int i = 0; i < nBuffers; i++ )
+        poThreadPool->WaitCompletion( &paoJobGroups[i] );
+    delete[] paoJobGroups;
+
+    for( size_t i = 1; i < apBuffers.size(); i++ )
+        VSIFree( apBuffers[i] );
+    for( size_t i = 0; i < apoReaders.size(); i++ )
+        GDALClose( (GDALDatasetH) apoReaders[i] );
+
+    return eErr;
+}
+
 /************************************************************************/
 /*                     GDALDatasetCopyWholeRaster()                     */
 /************************************************************************/
@@ -2830,9 +3411,20 @@ static void GDALCopyWholeRasterGetSwathSize(GDALRasterBand *poSrcPrototypeBand,
  * performing the transfer in a pixel interleaved fashion.
  *
  * Currently the only papszOptions value supported are : "INTERLEAVE=PIXEL"
- * to force pixel interleaved operation and "COMPRESSED=YES" to force alignment
- * on target dataset block sizes to achieve best compression.  More options may be supported in
- * the future.  
+ * to force pixel interleaved operation, "COMPRESSED=YES" to force alignment
+ * on target dataset block sizes to achieve best compression and
+ * "NUM_THREADS=number_of_threads" (or ALL_CPUS).  More options may be
+ * supported in the future.
+ *
+ * Starting with GDAL 2.0, when NUM_THREADS (or, if not specified, the
+ * GDAL_COPY_NUM_THREADS configuration option) is 2 or more, the next swath
+ * is read in a worker thread while the current one is written. With 3
+ * threads or more, and if the source dataset is a read-only dataset that can
+ * be reopened, several swaths are read at the same time through additional
+ * handles on the source.  This is only done when the driver of the source
+ * supports concurrent reads (see GDALDriverSupportsConcurrentReads()), and
+ * the number of swath buffers is limited so that they use at most half of
+ * the block cache size.
  *
  * @param hSrcDS the source dataset
  * @param hDstDS the destination dataset
@@ -2954,105 +3546,52 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
             "GDALDatasetCopyWholeRaster(): %d*%d swaths, bInterleave=%d", 
             nSwathCols, nSwathLines, bInterleave );
 
-/* ==================================================================== */
-/*      Band oriented (uninterleaved) case.                             */
-/* ==================================================================== */
-    if( !bInterleave )
-    {
-        int iBand, iX, iY;
-
-        for( iBand = 0; iBand < nBandCount && eErr == CE_None; iBand++ )
-        {
-            int nBand = iBand+1;
-
-            for( iY = 0; iY < nYSize && eErr == CE_None; iY += nSwathLines )
-            {
-                int nThisLines = nSwathLines;
-
-                if( iY + nThisLines > nYSize )
-                    nThisLines = nYSize - iY;
-
-                for( iX = 0; iX < nXSize && eErr == CE_None; iX += nSwathCols )
-                {
-                    int nThisCols = nSwathCols;
-
-                    if( iX + nThisCols > nXSize )
-                        nThisCols = nXSize - iX;
-
-                    eErr = poSrcDS->RasterIO( GF_Read, 
-                                            iX, iY, nThisCols, nThisLines,
-                                            pSwathBuf, nThisCols, nThisLines, 
-                                            eDT, 1, &nBand, 
-                                            0, 0, 0 );
-
-                    if( eErr == CE_None )
-                        eErr = poDstDS->RasterIO( GF_Write, 
-                                                iX, iY, nThisCols, nThisLines,
-                                                pSwathBuf, nThisCols, nThisLines, 
-                                                eDT, 1, &nBand,
-                                                0, 0, 0 );
-
-                    if( eErr == CE_None 
-                        && !pfnProgress( 
-                            iBand / (float)nBandCount
-                            + (iY+nThisLines) / (float) (nYSize*nBandCount),
-                            NULL, pProgressData ) )
-                    {
-                        eErr = CE_Failure;
-                        CPLError( CE_Failure, CPLE_UserInterrupt, 
-                                "User terminated CreateCopy()" );
-                    }
-                }
-            }
-        }
-    }
+/* -------------------------------------------------------------------- */
+/*      Build the list of swaths, band after band in the band           */
+/*      oriented (uninterleaved) case.                                  */
+/* -------------------------------------------------------------------- */
+    std::vector<GDALCopySwath> asSwaths;
+    int iBand, iX, iY;
 
-/* ==================================================================== */
-/*      Pixel interleaved case.                                         */
-/* ==================================================================== */
-    else /* if( bInterleave ) */
+    for( iBand = 0; iBand < (bInterleave ? 1 : nBandCount); iBand++ )
     {
-        int iY, iX;
-
-        for( iY = 0; iY < nYSize && eErr == CE_None; iY += nSwathLines )
+        for( iY = 0; iY < nYSize; iY += nSwathLines )
         {
             int nThisLines = nSwathLines;
 
             if( iY + nThisLines > nYSize )
                 nThisLines = nYSize - iY;
 
-            for( iX = 0; iX < nXSize && eErr == CE_None; iX += nSwathCols )
+            for( iX = 0; iX < nXSize; iX += nSwathCols )
             {
                 int nThisCols = nSwathCols;
 
                 if( iX + nThisCols > nXSize )
                     nThisCols = nXSize - iX;
 
-                eErr = poSrcDS->RasterIO( GF_Read, 
-                                        iX, iY, nThisCols, nThisLines,
-                                        pSwathBuf, nThisCols, nThisLines, 
-                                        eDT, nBandCount, NULL, 
-                                        0, 0, 0 );
-
-                if( eErr == CE_None )
-                    eErr = poDstDS->RasterIO( GF_Write, 
-                                            iX, iY, nThisCols, nThisLines,
-                                            pSwathBuf, nThisCols, nThisLines, 
-                                            eDT, nBandCount, NULL, 
-                                            0, 0, 0 );
-
-                if( eErr == CE_None 
-                    && !pfnProgress( (iY+nThisLines) / (float) nYSize,
-                                    NULL, pProgressData ) )
-                {
-                    eErr = CE_Failure;
-                    CPLError( CE_Failure, CPLE_UserInterrupt, 
-                            "User terminated CreateCopy()" );
-                }
+                GDALCopySwath sSwath;
+                sSwath.nBand = bInterleave ? 0 : iBand + 1;
+                sSwath.nXOff = iX;
+                sSwath.nYOff = iY;
+                sSwath.nXSize = nThisCols;
+                sSwath.nYSize = nThisLines;
+                if( bInterleave )
+                    sSwath.dfProgress = (iY+nThisLines) / (float) nYSize;
+                else
+                    sSwath.dfProgress = iBand / (float)nBandCount
+                        + (iY+nThisLines) / (float) (nYSize*nBandCount);
+                asSwaths.push_back( sSwath );
             }
         }
     }
 
+    eErr = GDALCopyWholeRasterSwaths( poSrcDS, NULL, poDstDS, NULL,
+                                      nBandCount, eDT, asSwaths,
+                                      pSwathBuf,
+                                      (size_t)nSwathCols * nSwathLines * nPixelSize,
+                                      GDALCopyWholeRasterGetThreadCount(papszOptions),
+                                      pfnProgress, pProgressData );
+
 /* -------------------------------------------------------------------- */
 /*      Cleanup                                                         */
 /* -------------------------------------------------------------------- */
@@ -3077,8 +3616,11 @@ CPLErr CPL_STDCALL GDALDatasetCopyWholeRaster(
  * It implements efficient copying, in particular "chunking" the copy in
  * substantial blocks.
  *
- * Currently the only papszOptions value supported is : "COMPRESSED=YES" to
- * force alignment on target dataset block sizes to achieve best compression.
+ * Currently the only papszOptions value supported are : "COMPRESSED=YES" to
+ * force alignment on target dataset block sizes to achieve best compression
+ * and "NUM_THREADS=number_of_threads" (or ALL_CPUS), to read the next swath
+ * in a worker thread while the current one is written, as in
+ * GDALDatasetCopyWholeRaster().
  * More options may be supported in the future.
  *
  * @param hSrcBand the source band
@@ -3166,49 +3708,44 @@ CPLErr CPL_STDCALL GDALRasterBandCopyWholeRaster(
             "GDALRasterBandCopyWholeRaster(): %d*%d swaths",
             nSwathCols, nSwathLines );
 
-/* ==================================================================== */
-/*      Band oriented (uninterleaved) case.                             */
-/* ==================================================================== */
-
+/* -------------------------------------------------------------------- */
+/*      Build the list of swaths.                                       */
+/* -------------------------------------------------------------------- */
+    std::vector<GDALCopySwath> asSwaths;
     int iX, iY;
 
-    for( iY = 0; iY < nYSize && eErr == CE_None; iY += nSwathLines )
+    for( iY = 0; iY < nYSize; iY += nSwathLines )
     {
         int nThisLines = nSwathLines;
 
         if( iY + nThisLines > nYSize )
             nThisLines = nYSize - iY;
 
-        for( iX = 0; iX < nXSize && eErr == CE_None; iX += nSwathCols )
+        for( iX = 0; iX < nXSize; iX += nSwathCols )
         {
             int nThisCols = nSwathCols;
 
             if( iX + nThisCols > nXSize )
                 nThisCols = nXSize - iX;
 
-            eErr = poSrcBand->RasterIO( GF_Read,
-                                    iX, iY, nThisCols, nThisLines,
-                                    pSwathBuf, nThisCols, nThisLines,
-                                    eDT, 0, 0 );
-
-            if( eErr == CE_None )
-                eErr = poDstBand->RasterIO( GF_Write,
-                                        iX, iY, nThisCols, nThisLines,
-                                        pSwathBuf, nThisCols, nThisLines,
-                                        eDT, 0, 0 );
-
-            if( eErr == CE_None
-                && !pfnProgress(
-                    (iY+nThisLines) / (float) (nYSize),
-                    NULL, pProgressData ) )
-            {
-                eErr = CE_Failure;
-                CPLError( CE_Failure, CPLE_UserInterrupt,
-                        "User terminated CreateCopy()" );
-            }
+            GDALCopySwath sSwath;
+            sSwath.nBand = 1;
+            sSwath.nXOff = iX;
+            sSwath.nYOff = iY;
+            sSwath.nXSize = nThisCols;
+            sSwath.nYSize = nThisLines;
+            sSwath.dfProgress = (iY+nThisLines) / (float) (nYSize);
+            asSwaths.push_back( sSwath );
         }
     }
 
+    eErr = GDALCopyWholeRasterSwaths( NULL, poSrcBand, NULL, poDstBand,
+                                      1, eDT, asSwaths,
+                                      pSwathBuf,
+                                      (size_t)nSwathCols * nSwathLines * nPixelSize,
+                                      GDALCopyWholeRasterGetThreadCount(papszOptions),
+                                      pfnProgress, pProgressData );
+
 /* -------------------------------------------------------------------- */
 /*      Cleanup                                                         */
 /* -------------------------------------------------------------------- */
@@ -384,6 +384,7 @@ class CPL_DLL OGRFeatureQuery
   private:
     OGRFeatureDefn *poTargetDefn;
     void           *pSWQExpr;
+    void           *pSWQProgram;
 
     char          **FieldCollector( void *, char ** );
 
@@ -149,4 +149,19 @@ char CPL_DLL * OGRGeometryToHexEWKB( OGRGeometry * poGeometry, int nSRSId );
 
 OGRErr OGRReadWKBGeometryType( unsigned char * pabyData, OGRwkbGeometryType *eGeometryType, OGRBoolean *b3D );
 
+void OGRReadWKBPoints( const GByte *pabyData, int nPointCount, int bSwap,
+                       OGRRawPoint *paoPoints, double *padfZ );
+void OGRWriteWKBPoints( GByte *pabyData, int nPointCount, int bSwap,
+                        const OGRRawPoint *paoPoints, const double *padfZ,
+                        int b3D );
+
+/************************************************************************/
+/*                     Bulk coordinate buffer kernels                   */
+/************************************************************************/
+
+void OGRGetPointsEnvelope( int nPointCount, const OGRRawPoint *paoPoints,
+                           OGREnvelope *psEnvelope );
+void OGRGetValuesRange( int nCount, const double *padfValues,
+                        double *pdfMin, double *pdfMax );
+
 #endif /* ndef OGR_P_H_INCLUDED */
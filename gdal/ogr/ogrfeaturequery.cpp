@@ -34,6 +34,7 @@
 #include "ogr_feature.h"
 #include "ogr_p.h"
 #include "ogr_attrind.h"
+#include <vector>
 
 CPL_CVSID("$Id$");
 
@@ -46,6 +47,798 @@ const char* SpecialFieldNames[SPECIAL_FIELD_COUNT]
 const swq_field_type SpecialFieldTypes[SPECIAL_FIELD_COUNT] 
 = {SWQ_INTEGER, SWQ_STRING, SWQ_STRING, SWQ_STRING, SWQ_FLOAT};
 
+/************************************************************************/
+/*                         OGRFeatureFetcher()                          */
+/************************************************************************/
+
+static swq_expr_node *OGRFeatureFetcher( swq_expr_node *op, void *pFeatureIn )
+
+{
+    OGRFeature *poFeature = (OGRFeature *) pFeatureIn;
+    swq_expr_node *poRetNode = NULL;
+
+    if( op->field_type == SWQ_GEOMETRY )
+    {
+        int iField = op->field_index - (poFeature->GetFieldCount() + SPECIAL_FIELD_COUNT);
+        poRetNode = new swq_expr_node( poFeature->GetGeomFieldRef(iField) );
+        return poRetNode;
+    }
+
+    switch( op->field_type )
+    {
+      case SWQ_INTEGER:
+      case SWQ_BOOLEAN:
+        poRetNode = new swq_expr_node( 
+            poFeature->GetFieldAsInteger(op->field_index) );
+        break;
+
+      case SWQ_FLOAT:
+        poRetNode = new swq_expr_node( 
+            poFeature->GetFieldAsDouble(op->field_index) );
+        break;
+
+      default:
+        poRetNode = new swq_expr_node( 
+            poFeature->GetFieldAsString(op->field_index) );
+        break;
+    }
+
+    poRetNode->is_null = !(poFeature->IsFieldSet(op->field_index));
+
+    return poRetNode;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                        OGRFeatureQueryProgram                        */
+/*                                                                      */
+/*      Flat, typed form of a WHERE expression tree, evaluated against  */
+/*      a feature without allocating any swq_expr_node.  Each node is   */
+/*      assigned a value slot at compile time, and the instructions     */
+/*      are laid out in post order.  The evaluation rules are those of  */
+/*      SWQGeneralEvaluator(), including its handling of NULL values.   */
+/*      Subtrees that cannot be compiled (functions, casts, string      */
+/*      producing operations, ...) are evaluated through                */
+/*      swq_expr_node::Evaluate() and their result copied in a slot.    */
+/* ==================================================================== */
+/************************************************************************/
+
+typedef enum
+{
+    SWQP_INT,       /* SWQ_INTEGER and SWQ_BOOLEAN */
+    SWQP_FLOAT,
+    SWQP_STRING     /* SWQ_STRING and the date/time types */
+} swqp_class;
+
+typedef enum
+{
+    SWQPI_LOAD_INT,
+    SWQPI_LOAD_FLOAT,
+    SWQPI_LOAD_STRING_RAW,  /* regular OFTString field, no copy needed */
+    SWQPI_LOAD_STRING,
+    SWQPI_FALLBACK,
+    SWQPI_JUMP_IF_FALSE,
+    SWQPI_JUMP_IF_TRUE,
+    SWQPI_ISNULL,
+    SWQPI_FLOAT_OP,
+    SWQPI_INT_OP,
+    SWQPI_STRING_OP
+} swqp_opcode;
+
+typedef struct
+{
+    swqp_opcode    eOpcode;
+    int            nOperation;
+    swq_field_type eNodeType;
+    int            nDst;
+    int            nFirstArg;
+    int            nArgCount;
+    int            nField;
+    int            nTarget;
+    swq_expr_node *poNode;
+} swqp_instr;
+
+class swqp_slot
+{
+  public:
+    swqp_slot() : eClass(SWQP_INT), bIsNull(FALSE), nValue(0),
+                  dfValue(0.0), pszValue("") {}
+
+    swqp_class  eClass;
+    int         bIsNull;
+    int         nValue;
+    double      dfValue;
+    const char *pszValue;
+    CPLString   osBuffer;   /* holds pszValue when it must be copied */
+};
+
+class OGRFeatureQueryProgram
+{
+    OGRFeatureDefn          *poDefn;
+    std::vector<swqp_instr>  asInstr;
+    std::vector<int>         anArgs;
+    std::vector<swqp_slot>   aoSlots;
+    int                      nFallbackCount;
+    int                      nResultSlot;
+
+    int         NewSlot( swqp_class eClass );
+    int         EmitFallback( swq_expr_node *poNode );
+    int         CompileNode( swq_expr_node *poNode );
+    int         CompileOperation( swq_expr_node *poNode );
+
+    static void SetNull( swqp_slot &oDst, swq_field_type eNodeType );
+    double      GetDouble( const swqp_slot &oSlot ) const
+                    { return oSlot.eClass == SWQP_INT ? (double) oSlot.nValue
+                                                      : oSlot.dfValue; }
+
+  public:
+                OGRFeatureQueryProgram( OGRFeatureDefn *poDefn );
+
+    int         Compile( swq_expr_node *poExpr );
+    int         IsWorthIt() const
+                    { return !(asInstr.size() == 1 && nFallbackCount == 1); }
+    int         Evaluate( OGRFeature *poFeature );
+};
+
+/************************************************************************/
+/*                       OGRFeatureQueryProgram()                       */
+/************************************************************************/
+
+OGRFeatureQueryProgram::OGRFeatureQueryProgram( OGRFeatureDefn *poDefnIn )
+
+{
+    poDefn = poDefnIn;
+    nFallbackCount = 0;
+    nResultSlot = -1;
+}
+
+/************************************************************************/
+/*                              NewSlot()                               */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::NewSlot( swqp_class eClass )
+
+{
+    aoSlots.push_back( swqp_slot() );
+    aoSlots.back().eClass = eClass;
+
+    return (int) aoSlots.size() - 1;
+}
+
+/************************************************************************/
+/*                            EmitFallback()                            */
+/*                                                                      */
+/*      Evaluate the node through the expression tree.  Returns -1 if   */
+/*      its result could not be stored in a slot.                       */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::EmitFallback( swq_expr_node *poNode )
+
+{
+    swqp_class eClass;
+
+    switch( poNode->field_type )
+    {
+      case SWQ_INTEGER:
+      case SWQ_BOOLEAN:
+        eClass = SWQP_INT;
+        break;
+
+      case SWQ_FLOAT:
+        eClass = SWQP_FLOAT;
+        break;
+
+      case SWQ_STRING:
+      case SWQ_DATE:
+      case SWQ_TIME:
+      case SWQ_TIMESTAMP:
+        eClass = SWQP_STRING;
+        break;
+
+      default:
+        return -1;
+    }
+
+    swqp_instr sInstr;
+
+    memset( &sInstr, 0, sizeof(sInstr) );
+    sInstr.eOpcode = SWQPI_FALLBACK;
+    sInstr.nDst = NewSlot( eClass );
+    sInstr.poNode = poNode;
+    asInstr.push_back( sInstr );
+    nFallbackCount++;
+
+    return sInstr.nDst;
+}
+
+/************************************************************************/
+/*                            CompileNode()                             */
+/*                                                                      */
+/*      Returns the slot holding the value of the node, or -1 if it     */
+/*      cannot be represented in a slot.                                */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::CompileNode( swq_expr_node *poNode )
+
+{
+    swqp_instr sInstr;
+
+    memset( &sInstr, 0, sizeof(sInstr) );
+
+/* -------------------------------------------------------------------- */
+/*      Constants are stored once in their slot.                        */
+/* -------------------------------------------------------------------- */
+    if( poNode->eNodeType == SNT_CONSTANT )
+    {
+        int iSlot;
+
+        switch( poNode->field_type )
+        {
+          case SWQ_INTEGER:
+          case SWQ_BOOLEAN:
+            iSlot = NewSlot( SWQP_INT );
+            aoSlots[iSlot].nValue = poNode->int_value;
+            break;
+
+          case SWQ_FLOAT:
+            iSlot = NewSlot( SWQP_FLOAT );
+            aoSlots[iSlot].dfValue = poNode->float_value;
+            break;
+
+          case SWQ_STRING:
+          case SWQ_DATE:
+          case SWQ_TIME:
+          case SWQ_TIMESTAMP:
+            if( poNode->string_value == NULL )
+                return -1;
+            iSlot = NewSlot( SWQP_STRING );
+            aoSlots[iSlot].pszValue = poNode->string_value;
+            break;
+
+          default:
+            return -1;
+        }
+
+        aoSlots[iSlot].bIsNull = poNode->is_null;
+        return iSlot;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Fields are fetched the way OGRFeatureFetcher() does.            */
+/* -------------------------------------------------------------------- */
+    if( poNode->eNodeType == SNT_COLUMN )
+    {
+        sInstr.nField = poNode->field_index;
+
+        switch( poNode->field_type )
+        {
+          case SWQ_INTEGER:
+          case SWQ_BOOLEAN:
+            sInstr.eOpcode = SWQPI_LOAD_INT;
+            sInstr.nDst = NewSlot( SWQP_INT );
+            break;
+
+          case SWQ_FLOAT:
+            sInstr.eOpcode = SWQPI_LOAD_FLOAT;
+            sInstr.nDst = NewSlot( SWQP_FLOAT );
+            break;
+
+          case SWQ_GEOMETRY:
+            return -1;
+
+          default:
+            if( poNode->field_index < poDefn->GetFieldCount()
+                && poDefn->GetFieldDefn(poNode->field_index)->GetType()
+                                                        == OFTString )
+                sInstr.eOpcode = SWQPI_LOAD_STRING_RAW;
+            else
+                sInstr.eOpcode = SWQPI_LOAD_STRING;
+            sInstr.nDst = NewSlot( SWQP_STRING );
+            break;
+        }
+
+        asInstr.push_back( sInstr );
+        return sInstr.nDst;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Operations: compile natively if we can, otherwise fallback.     */
+/* -------------------------------------------------------------------- */
+    size_t nInstrCount = asInstr.size();
+    size_t nArgCount = anArgs.size();
+    size_t nSlotCount = aoSlots.size();
+    int    nFallbackCountBefore = nFallbackCount;
+
+    int iSlot = CompileOperation( poNode );
+    if( iSlot >= 0 )
+        return iSlot;
+
+    asInstr.resize( nInstrCount );
+    anArgs.resize( nArgCount );
+    aoSlots.resize( nSlotCount );
+    nFallbackCount = nFallbackCountBefore;
+
+    return EmitFallback( poNode );
+}
+
+/************************************************************************/
+/*                          CompileOperation()                          */
+/*                                                                      */
+/*      Returns -1 if the operation cannot be compiled natively, in     */
+/*      which case the caller rolls back what has been emitted.         */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::CompileOperation( swq_expr_node *poNode )
+
+{
+    const swq_operation *poOp =
+        swq_op_registrar::GetOperator( (swq_op) poNode->nOperation );
+    int nOperation = poNode->nOperation;
+    int nSubExprCount = poNode->nSubExprCount;
+    int i;
+
+    if( poOp == NULL || poOp->pfnEvaluator != SWQGeneralEvaluator
+        || nSubExprCount < 1 )
+        return -1;
+
+    switch( nOperation )
+    {
+      case SWQ_AND: case SWQ_OR: case SWQ_NOT:
+      case SWQ_EQ: case SWQ_NE: case SWQ_GT: case SWQ_LT:
+      case SWQ_GE: case SWQ_LE: case SWQ_IN: case SWQ_BETWEEN:
+      case SWQ_LIKE: case SWQ_ISNULL:
+      case SWQ_ADD: case SWQ_SUBTRACT: case SWQ_MULTIPLY:
+      case SWQ_DIVIDE: case SWQ_MODULUS:
+        break;
+
+      default:
+        return -1;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Compile the arguments.  The second argument of AND / OR is      */
+/*      skipped when the first one decides of the result, which is      */
+/*      only safe when both are boolean operations (never NULL).        */
+/* -------------------------------------------------------------------- */
+    int bShortCircuit =
+        (nOperation == SWQ_AND || nOperation == SWQ_OR)
+        && nSubExprCount == 2
+        && poNode->papoSubExpr[0]->eNodeType == SNT_OPERATION
+        && poNode->papoSubExpr[0]->field_type == SWQ_BOOLEAN
+        && poNode->papoSubExpr[1]->eNodeType == SNT_OPERATION
+        && poNode->papoSubExpr[1]->field_type == SWQ_BOOLEAN;
+    int iJumpInstr = -1;
+    std::vector<int> anSubSlots;
+
+    for( i = 0; i < nSubExprCount; i++ )
+    {
+        int iSubSlot = CompileNode( poNode->papoSubExpr[i] );
+        if( iSubSlot < 0 )
+            return -1;
+        anSubSlots.push_back( iSubSlot );
+
+        if( i == 0 && bShortCircuit )
+        {
+            swqp_instr sJump;
+
+            memset( &sJump, 0, sizeof(sJump) );
+            sJump.eOpcode = (nOperation == SWQ_AND) ? SWQPI_JUMP_IF_FALSE
+                                                    : SWQPI_JUMP_IF_TRUE;
+            sJump.nFirstArg = iSubSlot;
+            iJumpInstr = (int) asInstr.size();
+            asInstr.push_back( sJump );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Pick the branch SWQGeneralEvaluator() would take, and check     */
+/*      that every argument is read consistently in it.                 */
+/* -------------------------------------------------------------------- */
+    swqp_class eClass0 = aoSlots[anSubSlots[0]].eClass;
+    swqp_class eClass1 = nSubExprCount > 1 ? aoSlots[anSubSlots[1]].eClass
+                                           : eClass0;
+    swqp_instr sInstr;
+    swqp_class eResultClass = SWQP_INT;
+    swq_field_type eNodeType = poNode->field_type;
+    int bComparison = !(nOperation == SWQ_ADD || nOperation == SWQ_SUBTRACT
+                        || nOperation == SWQ_MULTIPLY
+                        || nOperation == SWQ_DIVIDE
+                        || nOperation == SWQ_MODULUS);
+
+    memset( &sInstr, 0, sizeof(sInstr) );
+
+    if( nOperation == SWQ_ISNULL )
+    {
+        if( eNodeType != SWQ_BOOLEAN )
+            return -1;
+        sInstr.eOpcode = SWQPI_ISNULL;
+    }
+    else if( eClass0 == SWQP_FLOAT
+             || (nSubExprCount > 1 && eClass1 == SWQP_FLOAT) )
+    {
+        if( nOperation == SWQ_AND || nOperation == SWQ_OR
+            || nOperation == SWQ_NOT || nOperation == SWQ_LIKE )
+            return -1;
+        for( i = 0; i < nSubExprCount; i++ )
+        {
+            swqp_class eClass = aoSlots[anSubSlots[i]].eClass;
+            if( i < 2 ? eClass == SWQP_STRING : eClass != SWQP_FLOAT )
+                return -1;
+        }
+        if( nOperation == SWQ_MODULUS )
+            eResultClass = SWQP_INT;
+        else if( bComparison ? eNodeType != SWQ_BOOLEAN
+                             : eNodeType != SWQ_FLOAT )
+            return -1;
+        else if( !bComparison )
+            eResultClass = SWQP_FLOAT;
+        sInstr.eOpcode = SWQPI_FLOAT_OP;
+    }
+    else if( eClass0 == SWQP_INT )
+    {
+        if( nOperation == SWQ_LIKE )
+            return -1;
+        for( i = 1; i < nSubExprCount; i++ )
+        {
+            if( aoSlots[anSubSlots[i]].eClass != SWQP_INT )
+                return -1;
+        }
+        if( bComparison ? eNodeType != SWQ_BOOLEAN
+                        : eNodeType != SWQ_INTEGER )
+            return -1;
+        sInstr.eOpcode = SWQPI_INT_OP;
+    }
+    else
+    {
+        if( !bComparison || nOperation == SWQ_AND || nOperation == SWQ_OR
+            || nOperation == SWQ_NOT || eNodeType != SWQ_BOOLEAN )
+            return -1;
+        for( i = 1; i < nSubExprCount; i++ )
+        {
+            if( aoSlots[anSubSlots[i]].eClass != SWQP_STRING )
+                return -1;
+        }
+        sInstr.eOpcode = SWQPI_STRING_OP;
+    }
+
+    if( (nOperation == SWQ_NOT || nOperation == SWQ_ISNULL)
+        ? nSubExprCount != 1
+        : (nOperation == SWQ_BETWEEN ? nSubExprCount != 3
+           : nOperation == SWQ_IN ? nSubExprCount < 2
+           : nOperation == SWQ_LIKE ? (nSubExprCount != 2
+                                       && nSubExprCount != 3)
+           : nSubExprCount != 2) )
+        return -1;
+
+    sInstr.nOperation = nOperation;
+    sInstr.eNodeType = eNodeType;
+    sInstr.nDst = NewSlot( eResultClass );
+    sInstr.nFirstArg = (int) anArgs.size();
+    sInstr.nArgCount = nSubExprCount;
+    for( i = 0; i < nSubExprCount; i++ )
+        anArgs.push_back( anSubSlots[i] );
+    asInstr.push_back( sInstr );
+
+    if( iJumpInstr >= 0 )
+    {
+        asInstr[iJumpInstr].nDst = sInstr.nDst;
+        asInstr[iJumpInstr].nTarget = (int) asInstr.size();
+    }
+
+    return sInstr.nDst;
+}
+
+/************************************************************************/
+/*                              Compile()                               */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::Compile( swq_expr_node *poExpr )
+
+{
+    nResultSlot = CompileNode( poExpr );
+
+    return nResultSlot >= 0 && aoSlots[nResultSlot].eClass == SWQP_INT;
+}
+
+/************************************************************************/
+/*                              SetNull()                               */
+/*                                                                      */
+/*      Result of an operation having a NULL argument.                  */
+/************************************************************************/
+
+void OGRFeatureQueryProgram::SetNull( swqp_slot &oDst,
+                                      swq_field_type eNodeType )
+
+{
+    oDst.nValue = 0;
+    oDst.dfValue = 0.0;
+    oDst.bIsNull = (eNodeType != SWQ_BOOLEAN);
+}
+
+/************************************************************************/
+/*                              Evaluate()                              */
+/*                                                                      */
+/*      Returns the boolean result, or -1 if the program cannot         */
+/*      evaluate this feature and the expression tree must be used.     */
+/************************************************************************/
+
+int OGRFeatureQueryProgram::Evaluate( OGRFeature *poFeature )
+
+{
+    int nInstrCount = (int) asInstr.size();
+    swqp_slot *pasSlots = &aoSlots[0];
+    const int *panArgs = anArgs.empty() ? NULL : &anArgs[0];
+
+    for( int iInstr = 0; iInstr < nInstrCount; iInstr++ )
+    {
+        const swqp_instr &sInstr = asInstr[iInstr];
+        swqp_slot &oDst = pasSlots[sInstr.nDst];
+        const int *panOpArgs = NULL;
+        int i;
+
+        if( sInstr.eOpcode >= SWQPI_ISNULL )
+            panOpArgs = panArgs + sInstr.nFirstArg;
+
+        switch( sInstr.eOpcode )
+        {
+          case SWQPI_LOAD_INT:
+            oDst.nValue = poFeature->GetFieldAsInteger( sInstr.nField );
+            oDst.bIsNull = !poFeature->IsFieldSet( sInstr.nField );
+            break;
+
+          case SWQPI_LOAD_FLOAT:
+            oDst.dfValue = poFeature->GetFieldAsDouble( sInstr.nField );
+            oDst.bIsNull = !poFeature->IsFieldSet( sInstr.nField );
+            break;
+
+          case SWQPI_LOAD_STRING_RAW:
+            oDst.bIsNull = !poFeature->IsFieldSet( sInstr.nField );
+            oDst.pszValue = oDst.bIsNull ? "" :
+                poFeature->GetRawFieldRef( sInstr.nField )->String;
+            break;
+
+          case SWQPI_LOAD_STRING:
+            // GetFieldAsString() may return a temporary buffer of the
+            // feature, invalidated by the next call.
+            oDst.osBuffer = poFeature->GetFieldAsString( sInstr.nField );
+            oDst.pszValue = oDst.osBuffer.c_str();
+            oDst.bIsNull = !poFeature->IsFieldSet( sInstr.nField );
+            break;
+
+          case SWQPI_FALLBACK:
+          {
+              swq_expr_node *poResult =
+                  sInstr.poNode->Evaluate( OGRFeatureFetcher, poFeature );
+              if( poResult == NULL )
+                  return -1;
+
+              int nClass = -1;
+              if( poResult->field_type == SWQ_FLOAT )
+                  nClass = SWQP_FLOAT;
+              else if( poResult->field_type == SWQ_INTEGER
+                       || poResult->field_type == SWQ_BOOLEAN )
+                  nClass = SWQP_INT;
+              else if( poResult->string_value != NULL )
+                  nClass = SWQP_STRING;
+
+              if( nClass != (int) oDst.eClass )
+              {
+                  delete poResult;
+                  return -1;
+              }
+
+              oDst.nValue = poResult->int_value;
+              oDst.dfValue = poResult->float_value;
+              oDst.bIsNull = poResult->is_null;
+              if( nClass == SWQP_STRING )
+              {
+                  oDst.osBuffer = poResult->string_value;
+                  oDst.pszValue = oDst.osBuffer.c_str();
+              }
+              delete poResult;
+              break;
+          }
+
+          case SWQPI_JUMP_IF_FALSE:
+            if( !pasSlots[sInstr.nFirstArg].nValue )
+            {
+                oDst.nValue = FALSE;
+                oDst.bIsNull = FALSE;
+                iInstr = sInstr.nTarget - 1;
+            }
+            break;
+
+          case SWQPI_JUMP_IF_TRUE:
+            if( pasSlots[sInstr.nFirstArg].nValue )
+            {
+                oDst.nValue = TRUE;
+                oDst.bIsNull = FALSE;
+                iInstr = sInstr.nTarget - 1;
+            }
+            break;
+
+          case SWQPI_ISNULL:
+            oDst.nValue = pasSlots[panOpArgs[0]].bIsNull;
+            oDst.bIsNull = FALSE;
+            break;
+
+          case SWQPI_FLOAT_OP:
+          {
+              for( i = 0; i < sInstr.nArgCount; i++ )
+              {
+                  if( pasSlots[panOpArgs[i]].bIsNull )
+                      break;
+              }
+              if( i < sInstr.nArgCount )
+              {
+                  SetNull( oDst, sInstr.eNodeType );
+                  break;
+              }
+
+              double dfA = GetDouble( pasSlots[panOpArgs[0]] );
+              double dfB = GetDouble( pasSlots[panOpArgs[1]] );
+
+              oDst.bIsNull = FALSE;
+              switch( sInstr.nOperation )
+              {
+                case SWQ_EQ: oDst.nValue = dfA == dfB; break;
+                case SWQ_NE: oDst.nValue = dfA != dfB; break;
+                case SWQ_GT: oDst.nValue = dfA > dfB; break;
+                case SWQ_LT: oDst.nValue = dfA < dfB; break;
+                case SWQ_GE: oDst.nValue = dfA >= dfB; break;
+                case SWQ_LE: oDst.nValue = dfA <= dfB; break;
+
+                case SWQ_IN:
+                  oDst.nValue = dfA == dfB;
+                  for( i = 2; i < sInstr.nArgCount && !oDst.nValue; i++ )
+                      oDst.nValue = dfA == pasSlots[panOpArgs[i]].dfValue;
+                  break;
+
+                case SWQ_BETWEEN:
+                  oDst.nValue = dfA >= dfB
+                      && dfA <= pasSlots[panOpArgs[2]].dfValue;
+                  break;
+
+                case SWQ_ADD: oDst.dfValue = dfA + dfB; break;
+                case SWQ_SUBTRACT: oDst.dfValue = dfA - dfB; break;
+                case SWQ_MULTIPLY: oDst.dfValue = dfA * dfB; break;
+
+                case SWQ_DIVIDE:
+                  oDst.dfValue = (dfB == 0) ? INT_MAX : dfA / dfB;
+                  break;
+
+                case SWQ_MODULUS:
+                {
+                    int nRight = (int) dfB;
+                    oDst.nValue = (nRight == 0) ? INT_MAX
+                                                : ((int) dfA) % nRight;
+                    break;
+                }
+
+                default:
+                  return -1;
+              }
+              break;
+          }
+
+          case SWQPI_INT_OP:
+          {
+              for( i = 0; i < sInstr.nArgCount; i++ )
+              {
+                  if( pasSlots[panOpArgs[i]].bIsNull )
+                      break;
+              }
+              if( i < sInstr.nArgCount )
+              {
+                  SetNull( oDst, sInstr.eNodeType );
+                  break;
+              }
+
+              int nA = pasSlots[panOpArgs[0]].nValue;
+              int nB = sInstr.nArgCount > 1 ?
+                  pasSlots[panOpArgs[1]].nValue : 0;
+
+              oDst.bIsNull = FALSE;
+              switch( sInstr.nOperation )
+              {
+                case SWQ_AND: oDst.nValue = nA && nB; break;
+                case SWQ_OR: oDst.nValue = nA || nB; break;
+                case SWQ_NOT: oDst.nValue = !nA; break;
+                case SWQ_EQ: oDst.nValue = nA == nB; break;
+                case SWQ_NE: oDst.nValue = nA != nB; break;
+                case SWQ_GT: oDst.nValue = nA > nB; break;
+                case SWQ_LT: oDst.nValue = nA < nB; break;
+                case SWQ_GE: oDst.nValue = nA >= nB; break;
+                case SWQ_LE: oDst.nValue = nA <= nB; break;
+
+                case SWQ_IN:
+                  oDst.nValue = nA == nB;
+                  for( i = 2; i < sInstr.nArgCount && !oDst.nValue; i++ )
+                      oDst.nValue = nA == pasSlots[panOpArgs[i]].nValue;
+                  break;
+
+                case SWQ_BETWEEN:
+                  oDst.nValue = nA >= nB
+                      && nA <= pasSlots[panOpArgs[2]].nValue;
+                  break;
+
+                case SWQ_ADD: oDst.nValue = nA + nB; break;
+                case SWQ_SUBTRACT: oDst.nValue = nA - nB; break;
+                case SWQ_MULTIPLY: oDst.nValue = nA * nB; break;
+
+                case SWQ_DIVIDE:
+                  oDst.nValue = (nB == 0) ? INT_MAX : nA / nB;
+                  break;
+
+                case SWQ_MODULUS:
+                  oDst.nValue = (nB == 0) ? INT_MAX : nA % nB;
+                  break;
+
+                default:
+                  return -1;
+              }
+              break;
+          }
+
+          case SWQPI_STRING_OP:
+          {
+              for( i = 0; i < sInstr.nArgCount; i++ )
+              {
+                  if( pasSlots[panOpArgs[i]].bIsNull )
+                      break;
+              }
+              if( i < sInstr.nArgCount )
+              {
+                  SetNull( oDst, sInstr.eNodeType );
+                  break;
+              }
+
+              const char *pszA = pasSlots[panOpArgs[0]].pszValue;
+              const char *pszB = pasSlots[panOpArgs[1]].pszValue;
+
+              oDst.bIsNull = FALSE;
+              switch( sInstr.nOperation )
+              {
+                case SWQ_EQ: oDst.nValue = strcasecmp(pszA, pszB) == 0; break;
+                case SWQ_NE: oDst.nValue = strcasecmp(pszA, pszB) != 0; break;
+                case SWQ_GT: oDst.nValue = strcasecmp(pszA, pszB) > 0; break;
+                case SWQ_LT: oDst.nValue = strcasecmp(pszA, pszB) < 0; break;
+                case SWQ_GE: oDst.nValue = strcasecmp(pszA, pszB) >= 0; break;
+                case SWQ_LE: oDst.nValue = strcasecmp(pszA, pszB) <= 0; break;
+
+                case SWQ_IN:
+                  oDst.nValue = strcasecmp(pszA, pszB) == 0;
+                  for( i = 2; i < sInstr.nArgCount && !oDst.nValue; i++ )
+                      oDst.nValue = strcasecmp(
+                          pszA, pasSlots[panOpArgs[i]].pszValue) == 0;
+                  break;
+
+                case SWQ_BETWEEN:
+                  oDst.nValue = strcasecmp(pszA, pszB) >= 0
+                      && strcasecmp(pszA,
+                                    pasSlots[panOpArgs[2]].pszValue) <= 0;
+                  break;
+
+                case SWQ_LIKE:
+                {
+                    char chEscape = '\0';
+                    if( sInstr.nArgCount == 3 )
+                        chEscape = pasSlots[panOpArgs[2]].pszValue[0];
+                    oDst.nValue = swq_test_like( pszA, pszB, chEscape );
+                    break;
+                }
+
+                default:
+                  return -1;
+              }
+              break;
+          }
+        }
+    }
+
+    return pasSlots[nResultSlot].nValue;
+}
+
 /************************************************************************/
 /*                          OGRFeatureQuery()                           */
 /************************************************************************/
@@ -55,6 +848,7 @@ OGRFeatureQuery::OGRFeatureQuery()
 {
     poTargetDefn = NULL;
     pSWQExpr = NULL;
+    pSWQProgram = NULL;
 }
 
 /************************************************************************/
@@ -64,6 +858,7 @@ OGRFeatureQuery::OGRFeatureQuery()
 OGRFeatureQuery::~OGRFeatureQuery()
 
 {
+    delete (OGRFeatureQueryProgram *) pSWQProgram;
     delete (swq_expr_node *) pSWQExpr;
 }
 
@@ -83,6 +878,8 @@ OGRErr OGRFeatureQuery::Compile( OGRFeatureDefn *poDefn,
         delete (swq_expr_node *) pSWQExpr;
         pSWQExpr = NULL;
     }
+    delete (OGRFeatureQueryProgram *) pSWQProgram;
+    pSWQProgram = NULL;
 
 /* -------------------------------------------------------------------- */
 /*      Build list of fields.                                           */
@@ -168,49 +965,23 @@ OGRErr OGRFeatureQuery::Compile( OGRFeatureDefn *poDefn,
     CPLFree( papszFieldNames );
     CPLFree( paeFieldTypes );
 
-
-    return eErr;
-}
-
-/************************************************************************/
-/*                         OGRFeatureFetcher()                          */
-/************************************************************************/
-
-static swq_expr_node *OGRFeatureFetcher( swq_expr_node *op, void *pFeatureIn )
-
-{
-    OGRFeature *poFeature = (OGRFeature *) pFeatureIn;
-    swq_expr_node *poRetNode = NULL;
-
-    if( op->field_type == SWQ_GEOMETRY )
-    {
-        int iField = op->field_index - (poFeature->GetFieldCount() + SPECIAL_FIELD_COUNT);
-        poRetNode = new swq_expr_node( poFeature->GetGeomFieldRef(iField) );
-        return poRetNode;
-    }
-
-    switch( op->field_type )
+/* -------------------------------------------------------------------- */
+/*      Compile the expression tree to a flat program, unless it would  */
+/*      just evaluate the whole tree.                                   */
+/* -------------------------------------------------------------------- */
+    if( pSWQExpr != NULL
+        && CSLTestBoolean(CPLGetConfigOption("OGR_SQL_COMPILE_WHERE", "YES")) )
     {
-      case SWQ_INTEGER:
-      case SWQ_BOOLEAN:
-        poRetNode = new swq_expr_node( 
-            poFeature->GetFieldAsInteger(op->field_index) );
-        break;
+        OGRFeatureQueryProgram *poProgram = new OGRFeatureQueryProgram( poDefn );
 
-      case SWQ_FLOAT:
-        poRetNode = new swq_expr_node( 
-            poFeature->GetFieldAsDouble(op->field_index) );
-        break;
-
-      default:
-        poRetNode = new swq_expr_node( 
-            poFeature->GetFieldAsString(op->field_index) );
-        break;
+        if( poProgram->Compile( (swq_expr_node *) pSWQExpr )
+            && poProgram->IsWorthIt() )
+            pSWQProgram = poProgram;
+        else
+            delete poProgram;
     }
 
-    poRetNode->is_null = !(poFeature->IsFieldSet(op->field_index));
-
-    return poRetNode;
+    return eErr;
 }
 
 /************************************************************************/
@@ -223,6 +994,13 @@ int OGRFeatureQuery::Evaluate( OGRFeature *poFeature )
     if( pSWQExpr == NULL )
         return FALSE;
 
+    if( pSWQProgram != NULL )
+    {
+        int bResult = ((OGRFeatureQueryProgram *) pSWQProgram)->Evaluate( poFeature );
+        if( bResult >= 0 )
+            return bResult;
+    }
+
     swq_expr_node *poResult;
 
     poResult = ((swq_expr_node *) pSWQExpr)->Evaluate( OGRFeatureFetcher,
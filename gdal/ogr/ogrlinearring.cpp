@@ -180,40 +180,10 @@ OGRErr OGRLinearRing::_importFromWkb( OGRwkbByteOrder eByteOrder, int b3D,
         Make2D();
     
 /* -------------------------------------------------------------------- */
-/*      Get the vertices                                                */
+/*      Get the vertices, byte swapping them on the fly if needed.      */
 /* -------------------------------------------------------------------- */
-    int i = 0;
-
-    if( !b3D )
-    {
-        memcpy( paoPoints, pabyData + 4, 16 * nPointCount );
-    }
-    else
-    {
-        for( int i = 0; i < nPointCount; i++ )
-        {
-            memcpy( &(paoPoints[i].x), pabyData + 4 + 24 * i, 8 );
-            memcpy( &(paoPoints[i].y), pabyData + 4 + 24 * i + 8, 8 );
-            memcpy( padfZ + i, pabyData + 4 + 24 * i + 16, 8 );
-        }
-    }
-    
-/* -------------------------------------------------------------------- */
-/*      Byte swap if needed.                                            */
-/* -------------------------------------------------------------------- */
-    if( OGR_SWAP( eByteOrder ) )
-    {
-        for( i = 0; i < nPointCount; i++ )
-        {
-            CPL_SWAPDOUBLE( &(paoPoints[i].x) );
-            CPL_SWAPDOUBLE( &(paoPoints[i].y) );
-
-            if( b3D )
-            {
-                CPL_SWAPDOUBLE( padfZ + i );
-            }
-        }
-    }
+    OGRReadWKBPoints( pabyData + 4, nPointCount, OGR_SWAP( eByteOrder ),
+                      paoPoints, b3D ? padfZ : NULL );
 
     return OGRERR_NONE;
 }
@@ -229,50 +199,24 @@ OGRErr  OGRLinearRing::_exportToWkb( OGRwkbByteOrder eByteOrder, int b3D,
                                      unsigned char * pabyData ) const
 
 {
-    int   i, nWords;
-
 /* -------------------------------------------------------------------- */
-/*      Copy in the raw data.                                           */
+/*      Copy in the point count.                                        */
 /* -------------------------------------------------------------------- */
     memcpy( pabyData, &nPointCount, 4 );
 
-/* -------------------------------------------------------------------- */
-/*      Copy in the raw data.                                           */
-/* -------------------------------------------------------------------- */
-    if( b3D )
-    {
-        nWords = 3 * nPointCount;
-        for( i = 0; i < nPointCount; i++ )
-        {
-            memcpy( pabyData+4+i*24, &(paoPoints[i].x), 8 );
-            memcpy( pabyData+4+i*24+8, &(paoPoints[i].y), 8 );
-            if( padfZ == NULL )
-                memset( pabyData+4+i*24+16, 0, 8 );
-            else
-                memcpy( pabyData+4+i*24+16, padfZ + i, 8 );
-        }
-    }
-    else
-    {
-        nWords = 2 * nPointCount; 
-        memcpy( pabyData+4, paoPoints, 16 * nPointCount );
-    }
-
-/* -------------------------------------------------------------------- */
-/*      Swap if needed.                                                 */
-/* -------------------------------------------------------------------- */
     if( OGR_SWAP( eByteOrder ) )
     {
         int     nCount;
 
         nCount = CPL_SWAP32( nPointCount );
         memcpy( pabyData, &nCount, 4 );
-
-        for( i = 0; i < nWords; i++ )
-        {
-            CPL_SWAPDOUBLE( pabyData + 4 + 8 * i );
-        }
     }
+
+/* -------------------------------------------------------------------- */
+/*      Copy in the raw data, swapping it on the fly if needed.         */
+/* -------------------------------------------------------------------- */
+    OGRWriteWKBPoints( pabyData + 4, nPointCount, OGR_SWAP( eByteOrder ),
+                       paoPoints, padfZ, b3D );
     
     return OGRERR_NONE;
 }
@@ -894,42 +894,10 @@ OGRErr OGRLineString::importFromWkb( unsigned char * pabyData,
         Make2D();
     
 /* -------------------------------------------------------------------- */
-/*      Get the vertex.                                                 */
+/*      Get the vertices, byte swapping them on the fly if needed.      */
 /* -------------------------------------------------------------------- */
-    int i = 0;
-    
-    if( bIs3D )
-    {
-        for( i = 0; i < nPointCount; i++ )
-        {
-            memcpy( paoPoints + i, pabyData + 9 + i*24, 16 );
-            memcpy( padfZ + i, pabyData + 9 + 16 + i*24, 8 );
-        }
-    }
-    else
-    {
-        memcpy( paoPoints, pabyData + 9, 16 * nPointCount );
-    }
-    
-/* -------------------------------------------------------------------- */
-/*      Byte swap if needed.                                            */
-/* -------------------------------------------------------------------- */
-    if( OGR_SWAP( eByteOrder ) )
-    {
-        for( i = 0; i < nPointCount; i++ )
-        {
-            CPL_SWAPDOUBLE( &(paoPoints[i].x) );
-            CPL_SWAPDOUBLE( &(paoPoints[i].y) );
-        }
-
-        if( bIs3D )
-        {
-            for( i = 0; i < nPointCount; i++ )
-            {
-                CPL_SWAPDOUBLE( padfZ + i );
-            }
-        }
-    }
+    OGRReadWKBPoints( pabyData + 9, nPointCount, OGR_SWAP( eByteOrder ),
+                      paoPoints, bIs3D ? padfZ : NULL );
     
     return OGRERR_NONE;
 }
@@ -970,37 +938,19 @@ OGRErr  OGRLineString::exportToWkb( OGRwkbByteOrder eByteOrder,
 /* -------------------------------------------------------------------- */
     memcpy( pabyData+5, &nPointCount, 4 );
 
-/* -------------------------------------------------------------------- */
-/*      Copy in the raw data.                                           */
-/* -------------------------------------------------------------------- */
-    int         i;
-    
-    if( getCoordinateDimension() == 3 )
-    {
-        for( i = 0; i < nPointCount; i++ )
-        {
-            memcpy( pabyData + 9 + 24*i, paoPoints+i, 16 );
-            memcpy( pabyData + 9 + 16 + 24*i, padfZ+i, 8 );
-        }
-    }
-    else
-        memcpy( pabyData+9, paoPoints, 16 * nPointCount );
-
-/* -------------------------------------------------------------------- */
-/*      Swap if needed.                                                 */
-/* -------------------------------------------------------------------- */
     if( OGR_SWAP( eByteOrder ) )
     {
         int     nCount;
 
         nCount = CPL_SWAP32( nPointCount );
         memcpy( pabyData+5, &nCount, 4 );
-
-        for( i = getCoordinateDimension() * nPointCount - 1; i >= 0; i-- )
-        {
-            CPL_SWAP64PTR( pabyData + 9 + 8 * i );
-        }
     }
+
+/* -------------------------------------------------------------------- */
+/*      Copy in the raw data, swapping it on the fly if needed.         */
+/* -------------------------------------------------------------------- */
+    OGRWriteWKBPoints( pabyData + 9, nPointCount, OGR_SWAP( eByteOrder ),
+                       paoPoints, padfZ, getCoordinateDimension() == 3 );
     
     return OGRERR_NONE;
 }
@@ -1563,8 +1513,6 @@ OGRLineString* OGRLineString::getSubLine(double dfDistanceFrom, double dfDistanc
 void OGRLineString::getEnvelope( OGREnvelope * psEnvelope ) const
 
 {
-    double      dfMinX, dfMinY, dfMaxX, dfMaxY;
-
     if( IsEmpty() )
     {
         psEnvelope->MinX = 0;
@@ -1574,25 +1522,7 @@ void OGRLineString::getEnvelope( OGREnvelope * psEnvelope ) const
         return;
     }
     
-    dfMinX = dfMaxX = paoPoints[0].x;
-    dfMinY = dfMaxY = paoPoints[0].y;
-
-    for( int iPoint = 1; iPoint < nPointCount; iPoint++ )
-    {
-        if( dfMaxX < paoPoints[iPoint].x )
-            dfMaxX = paoPoints[iPoint].x;
-        if( dfMaxY < paoPoints[iPoint].y )
-            dfMaxY = paoPoints[iPoint].y;
-        if( dfMinX > paoPoints[iPoint].x )
-            dfMinX = paoPoints[iPoint].x;
-        if( dfMinY > paoPoints[iPoint].y )
-            dfMinY = paoPoints[iPoint].y;
-    }
-
-    psEnvelope->MinX = dfMinX;
-    psEnvelope->MaxX = dfMaxX;
-    psEnvelope->MinY = dfMinY;
-    psEnvelope->MaxY = dfMaxY;
+    OGRGetPointsEnvelope( nPointCount, paoPoints, psEnvelope );
 }
 
 
@@ -1605,8 +1535,6 @@ void OGRLineString::getEnvelope( OGREnvelope3D * psEnvelope ) const
 {
     getEnvelope((OGREnvelope*)psEnvelope);
 
-    double      dfMinZ, dfMaxZ;
-
     if( IsEmpty() || padfZ == NULL )
     {
         psEnvelope->MinZ = 0;
@@ -1614,18 +1542,8 @@ void OGRLineString::getEnvelope( OGREnvelope3D * psEnvelope ) const
         return;
     }
 
-    dfMinZ = dfMaxZ = padfZ[0];
-
-    for( int iPoint = 1; iPoint < nPointCount; iPoint++ )
-    {
-        if( dfMinZ > padfZ[iPoint] )
-            dfMinZ = padfZ[iPoint];
-        if( dfMaxZ < padfZ[iPoint] )
-            dfMaxZ = padfZ[iPoint];
-    }
-
-    psEnvelope->MinZ = dfMinZ;
-    psEnvelope->MaxZ = dfMaxZ;
+    OGRGetValuesRange( nPointCount, padfZ,
+                       &psEnvelope->MinZ, &psEnvelope->MaxZ );
 }
 
 /************************************************************************/
@@ -1695,11 +1613,11 @@ OGRErr OGRLineString::transform( OGRCoordinateTransformation *poCT )
     {
         xyz[i  ] = paoPoints[i].x;
         xyz[i+nPointCount] = paoPoints[i].y;
-        if( padfZ )
-            xyz[i+nPointCount*2] = padfZ[i];
-        else
-            xyz[i+nPointCount*2] = 0.0;
     }
+    if( padfZ )
+        memcpy( xyz + nPointCount*2, padfZ, sizeof(double) * nPointCount );
+    else
+        memset( xyz + nPointCount*2, 0, sizeof(double) * nPointCount );
 
 /* -------------------------------------------------------------------- */
 /*      Transform and reapply.                                          */
@@ -1707,6 +1625,34 @@ OGRErr OGRLineString::transform( OGRCoordinateTransformation *poCT )
     poCT->TransformEx( nPointCount, xyz, xyz + nPointCount,
                        xyz+nPointCount*2, pabSuccess );
 
+/* -------------------------------------------------------------------- */
+/*      Common case: every point was transformed.  Write the result     */
+/*      straight back into the point buffers, without going through     */
+/*      the compaction pass and the reallocation done by setPoints().   */
+/* -------------------------------------------------------------------- */
+    for( i = 0; i < nPointCount && pabSuccess[i]; i++ ) {}
+
+    if( i == nPointCount && nPointCount != 0 )
+    {
+        const double *padfX = xyz;
+        const double *padfY = xyz + nPointCount;
+
+        for( i = 0; i < nPointCount; i++ )
+        {
+            paoPoints[i].x = padfX[i];
+            paoPoints[i].y = padfY[i];
+        }
+        if( padfZ )
+            memcpy( padfZ, xyz + nPointCount*2, sizeof(double) * nPointCount );
+
+        CPLFree( xyz );
+        CPLFree( pabSuccess );
+
+        assignSpatialReference( poCT->GetTargetCS() );
+
+        return OGRERR_NONE;
+    }
+
     const char* pszEnablePartialReprojection = NULL;
 
     for( i = 0, j = 0; i < nPointCount; i++ )
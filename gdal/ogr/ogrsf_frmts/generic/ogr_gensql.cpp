@@ -53,1710 +53,4161 @@ class OGRGenSQLGeomFieldDefn: public OGRGeomFieldDefn
 };
 
 /************************************************************************/
-/*               OGRGenSQLResultsLayerHasSpecialField()                 */
+/* ==================================================================== */
+/*                          OGRGenSQLJoinHash                           */
+/*                                                                      */
+/*      In memory hash table of the features of a joined layer, keyed   */
+/*      by the value of their join field.  It is built with a single    */
+/*      scan of the joined layer, so that the matching secondary        */
+/*      feature of each primary feature can be found without            */
+/*      installing an attribute filter and rescanning the layer.        */
+/* ==================================================================== */
 /************************************************************************/
 
-static
-int OGRGenSQLResultsLayerHasSpecialField(swq_expr_node* expr,
-                                         int nMinIndexForSpecialField)
+typedef enum
 {
-    if (expr->eNodeType == SNT_COLUMN)
+    JK_NONE,
+    JK_NUMERIC,
+    JK_STRING
+} OGRGenSQLJoinKeyType;
+
+typedef struct
+{
+    char       *pszKey;     /* lower cased string key, NULL for numeric keys */
+    double      dfKey;
+    long        nFID;
+    OGRFeature *poFeature;  /* NULL when only the FID is kept */
+} OGRGenSQLJoinHashEntry;
+
+class OGRGenSQLJoinHash
+{
+    OGRLayer            *poLayer;
+    OGRGenSQLJoinKeyType eKeyType;
+    int                  bKeepFeatures;
+    CPLHashSet          *hSet;
+
+  public:
+                         OGRGenSQLJoinHash( OGRLayer *poLayer,
+                                            OGRGenSQLJoinKeyType eKeyType );
+                        ~OGRGenSQLJoinHash();
+
+    int                  Build( int iField );
+    OGRFeature          *Lookup( OGRGenSQLJoinHashEntry *psKey,
+                                 int *pbOwned );
+};
+
+/************************************************************************/
+/*                     OGRGenSQLGetJoinKeyType()                        */
+/*                                                                      */
+/*      Which key comparison reproduces the semantics of the            */
+/*      "secondary_field = <primary value>" filter that would           */
+/*      otherwise be used, or JK_NONE if we cannot hash it.             */
+/************************************************************************/
+
+static OGRGenSQLJoinKeyType
+OGRGenSQLGetJoinKeyType( OGRFieldType ePrimaryType, OGRFieldType eSecondaryType )
+
+{
+    int bPrimaryNumeric = (ePrimaryType == OFTInteger || ePrimaryType == OFTReal);
+    int bSecondaryNumeric =
+        (eSecondaryType == OFTInteger || eSecondaryType == OFTReal);
+
+    if( bPrimaryNumeric && (bSecondaryNumeric || eSecondaryType == OFTString) )
+        return JK_NUMERIC;
+    if( ePrimaryType == OFTString && bSecondaryNumeric )
+        return JK_NUMERIC;
+    if( ePrimaryType == OFTString && eSecondaryType == OFTString )
+        return JK_STRING;
+
+    return JK_NONE;
+}
+
+/************************************************************************/
+/*                     OGRGenSQLSetJoinHashKey()                        */
+/*                                                                      */
+/*      Fill the key of psEntry from a field value.  The string key    */
+/*      is lower cased since the SQL engine compares strings with       */
+/*      strcasecmp().  Returns FALSE if the value can never match.      */
+/************************************************************************/
+
+static int OGRGenSQLSetJoinHashKey( OGRGenSQLJoinHashEntry *psEntry,
+                                    OGRGenSQLJoinKeyType eKeyType,
+                                    OGRFieldType eFieldType,
+                                    int bIsPrimary,
+                                    OGRField *psField )
+
+{
+    psEntry->pszKey = NULL;
+    psEntry->dfKey = 0.0;
+
+    if( eKeyType == JK_STRING )
     {
-        if (expr->table_index == 0)
-        {
-            return expr->field_index >= nMinIndexForSpecialField &&
-                   expr->field_index < nMinIndexForSpecialField + SPECIAL_FIELD_COUNT;
-        }
+        char *pszKey = CPLStrdup( psField->String );
+        for( char *pszIter = pszKey; *pszIter != '\0'; pszIter++ )
+            *pszIter = (char) tolower( (unsigned char) *pszIter );
+        psEntry->pszKey = pszKey;
+        return TRUE;
     }
-    else if (expr->eNodeType == SNT_OPERATION)
+
+    switch( eFieldType )
     {
-        for( int i = 0; i < expr->nSubExprCount; i++ )
-        {
-            if (OGRGenSQLResultsLayerHasSpecialField(expr->papoSubExpr[i],
-                                                     nMinIndexForSpecialField))
-                return TRUE;
-        }
+      case OFTInteger:
+        psEntry->dfKey = psField->Integer;
+        break;
+
+      case OFTReal:
+        // The attribute filter formats the primary value with %.16g.
+        if( bIsPrimary )
+            psEntry->dfKey = CPLAtof( CPLSPrintf( "%.16g", psField->Real ) );
+        else
+            psEntry->dfKey = psField->Real;
+        break;
+
+      case OFTString:
+        // Primary strings are converted by SWQAutoConvertStringToNumeric(),
+        // secondary ones by CAST(... AS FLOAT).
+        if( bIsPrimary )
+            psEntry->dfKey = CPLStrtod( psField->String, NULL );
+        else
+            psEntry->dfKey = CPLAtof( psField->String );
+        break;
+
+      default:
+        return FALSE;
     }
-    return FALSE;
+
+    if( CPLIsNan(psEntry->dfKey) )
+        return FALSE;
+
+    // So that -0.0 and 0.0 hash the same.
+    if( psEntry->dfKey == 0.0 )
+        psEntry->dfKey = 0.0;
+
+    return TRUE;
 }
 
 /************************************************************************/
-/*                       OGRGenSQLResultsLayer()                        */
+/*                      OGRGenSQLJoinHashFunc()                         */
 /************************************************************************/
 
-OGRGenSQLResultsLayer::OGRGenSQLResultsLayer( GDALDataset *poSrcDS,
-                                              void *pSelectInfo, 
-                                              OGRGeometry *poSpatFilter,
-                                              const char *pszWHERE,
-                                              const char *pszDialect )
+static unsigned long OGRGenSQLJoinHashFunc( const void *elt )
 
 {
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    const OGRGenSQLJoinHashEntry *psEntry =
+        (const OGRGenSQLJoinHashEntry *) elt;
 
-    this->poSrcDS = poSrcDS;
-    this->pSelectInfo = pSelectInfo;
-    poDefn = NULL;
-    poSummaryFeature = NULL;
-    panFIDIndex = NULL;
-    bOrderByValid = FALSE;
-    nIndexSize = 0;
-    nNextIndexFID = 0;
-    nExtraDSCount = 0;
-    papoExtraDS = NULL;
-    panGeomFieldToSrcGeomField = NULL;
+    if( psEntry->pszKey != NULL )
+        return CPLHashSetHashStr( psEntry->pszKey );
 
-/* -------------------------------------------------------------------- */
-/*      Identify all the layers involved in the SELECT.                 */
-/* -------------------------------------------------------------------- */
-    int iTable;
+    GUIntBig nBits;
+    memcpy( &nBits, &(psEntry->dfKey), sizeof(nBits) );
+    GUInt32 nLow = (GUInt32) nBits;
+    GUInt32 nHigh = (GUInt32) (nBits >> 32);
 
-    papoTableLayers = (OGRLayer **) 
-        CPLCalloc( sizeof(OGRLayer *), psSelectInfo->table_count );
+    return (unsigned long) ((nLow ^ (nHigh * 2654435761U)) * 2246822519U);
+}
 
-    for( iTable = 0; iTable < psSelectInfo->table_count; iTable++ )
-    {
-        swq_table_def *psTableDef = psSelectInfo->table_defs + iTable;
-        GDALDataset *poTableDS = poSrcDS;
+/************************************************************************/
+/*                      OGRGenSQLJoinEqualFunc()                        */
+/************************************************************************/
 
-        if( psTableDef->data_source != NULL )
-        {
-            poTableDS = (GDALDataset*) GDALOpenEx( psTableDef->data_source,
-                            GDAL_OF_VECTOR | GDAL_OF_SHARED, NULL, NULL, NULL );
-            if( poTableDS == NULL )
-            {
-                if( strlen(CPLGetLastErrorMsg()) == 0 )
-                    CPLError( CE_Failure, CPLE_AppDefined, 
-                              "Unable to open secondary datasource\n"
-                              "`%s' required by JOIN.",
-                              psTableDef->data_source );
-                return;
-            }
+static int OGRGenSQLJoinEqualFunc( const void *elt1, const void *elt2 )
 
-            papoExtraDS = (GDALDataset **)
-                CPLRealloc( papoExtraDS, sizeof(void*) * ++nExtraDSCount );
+{
+    const OGRGenSQLJoinHashEntry *psEntry1 =
+        (const OGRGenSQLJoinHashEntry *) elt1;
+    const OGRGenSQLJoinHashEntry *psEntry2 =
+        (const OGRGenSQLJoinHashEntry *) elt2;
+
+    if( psEntry1->pszKey != NULL && psEntry2->pszKey != NULL )
+        return strcmp( psEntry1->pszKey, psEntry2->pszKey ) == 0;
+    if( psEntry1->pszKey != NULL || psEntry2->pszKey != NULL )
+        return FALSE;
 
-            papoExtraDS[nExtraDSCount-1] = poTableDS;
-        }
+    return psEntry1->dfKey == psEntry2->dfKey;
+}
 
-        papoTableLayers[iTable] = 
-            poTableDS->GetLayerByName( psTableDef->table_name );
-        
-        CPLAssert( papoTableLayers[iTable] != NULL );
+/************************************************************************/
+/*                       OGRGenSQLJoinFreeFunc()                        */
+/************************************************************************/
 
-        if( papoTableLayers[iTable] == NULL )
-            return;
-    }
-    
-    poSrcLayer = papoTableLayers[0];
+static void OGRGenSQLJoinFreeFunc( void *elt )
 
-/* -------------------------------------------------------------------- */
-/*      If the user has explicitely requested a OGRSQL dialect, then    */
-/*      we should avoid to forward the where clause to the source layer */
-/*      when there is a risk it cannot understand it (#4022)            */
-/* -------------------------------------------------------------------- */
-    int bForwardWhereToSourceLayer = TRUE;
-    if( pszWHERE )
-    {
-        if( psSelectInfo->where_expr && pszDialect != NULL &&
-            EQUAL(pszDialect, "OGRSQL") )
-        {
-            int nMinIndexForSpecialField = poSrcLayer->GetLayerDefn()->GetFieldCount();
-            bForwardWhereToSourceLayer = !OGRGenSQLResultsLayerHasSpecialField
-                            (psSelectInfo->where_expr, nMinIndexForSpecialField);
-        }
-        if (bForwardWhereToSourceLayer)
-            this->pszWHERE = CPLStrdup(pszWHERE);
-        else
-            this->pszWHERE = NULL;
-    }
-    else
-        this->pszWHERE = NULL;
+{
+    OGRGenSQLJoinHashEntry *psEntry = (OGRGenSQLJoinHashEntry *) elt;
 
-/* -------------------------------------------------------------------- */
-/*      Prepare a feature definition based on the query.                */
-/* -------------------------------------------------------------------- */
-    OGRFeatureDefn *poSrcDefn = poSrcLayer->GetLayerDefn();
+    CPLFree( psEntry->pszKey );
+    delete psEntry->poFeature;
+    CPLFree( psEntry );
+}
 
-    poDefn = new OGRFeatureDefn( psSelectInfo->table_defs[0].table_alias );
-    SetDescription( poDefn->GetName() );
-    poDefn->SetGeomType(wkbNone);
-    poDefn->Reference();
+/************************************************************************/
+/*                     OGRGenSQLJoinDropFeature()                       */
+/************************************************************************/
 
-    iFIDFieldIndex = poSrcDefn->GetFieldCount();
+static int OGRGenSQLJoinDropFeature( void *elt, void * /* pUserData */ )
 
-    /* + 1 since we can add an implicit geometry field */
-    panGeomFieldToSrcGeomField = (int*) CPLMalloc(sizeof(int) * (1 + psSelectInfo->result_columns));
+{
+    OGRGenSQLJoinHashEntry *psEntry = (OGRGenSQLJoinHashEntry *) elt;
 
-    for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
-    {
-        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
-        OGRFieldDefn oFDefn( "", OFTInteger );
-        OGRGeomFieldDefn oGFDefn( "", wkbUnknown );
-        OGRFieldDefn *poSrcFDefn = NULL;
-        OGRGeomFieldDefn *poSrcGFDefn = NULL;
-        int bIsGeometry = FALSE;
-        OGRFeatureDefn *poLayerDefn = NULL;
-        int iSrcGeomField = -1;
+    delete psEntry->poFeature;
+    psEntry->poFeature = NULL;
 
-        if( psColDef->table_index != -1 )
-            poLayerDefn = 
-                papoTableLayers[psColDef->table_index]->GetLayerDefn();
+    return TRUE;
+}
 
-        if( psColDef->field_index > -1 
-            && poLayerDefn != NULL
-            && psColDef->field_index < poLayerDefn->GetFieldCount() )
+/************************************************************************/
+/*                       OGRGenSQLJoinHash()                            */
+/************************************************************************/
+
+OGRGenSQLJoinHash::OGRGenSQLJoinHash( OGRLayer *poLayerIn,
+                                      OGRGenSQLJoinKeyType eKeyTypeIn )
+
+{
+    poLayer = poLayerIn;
+    eKeyType = eKeyTypeIn;
+    bKeepFeatures = TRUE;
+    hSet = CPLHashSetNew( OGRGenSQLJoinHashFunc, OGRGenSQLJoinEqualFunc,
+                          OGRGenSQLJoinFreeFunc );
+}
+
+/************************************************************************/
+/*                      ~OGRGenSQLJoinHash()                            */
+/************************************************************************/
+
+OGRGenSQLJoinHash::~OGRGenSQLJoinHash()
+
+{
+    CPLHashSetDestroy( hSet );
+}
+
+/************************************************************************/
+/*                               Build()                                */
+/*                                                                      */
+/*      Scan the joined layer and index its features by key.  Only     */
+/*      the first feature of a given key is kept, as the attribute      */
+/*      filter approach would return.  The features are kept in         */
+/*      memory up to OGR_GENSQL_JOIN_HASH_MAX_MEMORY megabytes          */
+/*      (default 256).  Past that, only their FIDs are kept if the      */
+/*      layer supports random reading, otherwise FALSE is returned      */
+/*      and the caller should fall back to attribute filtering.         */
+/************************************************************************/
+
+int OGRGenSQLJoinHash::Build( int iField )
+
+{
+    GIntBig nMaxMemory = (GIntBig)
+        atoi(CPLGetConfigOption( "OGR_GENSQL_JOIN_HASH_MAX_MEMORY", "256" ))
+        * 1024 * 1024;
+    GIntBig nMemory = 0;
+    OGRFieldType eFieldType =
+        poLayer->GetLayerDefn()->GetFieldDefn( iField )->GetType();
+    OGRFeature *poFeature;
+
+    poLayer->SetAttributeFilter( NULL );
+    poLayer->ResetReading();
+
+    while( (poFeature = poLayer->GetNextFeature()) != NULL )
+    {
+        OGRGenSQLJoinHashEntry sEntry;
+
+        if( !poFeature->IsFieldSet( iField )
+            || !OGRGenSQLSetJoinHashKey( &sEntry, eKeyType, eFieldType, FALSE,
+                                         poFeature->GetRawFieldRef( iField ) ) )
         {
-            poSrcFDefn = poLayerDefn->GetFieldDefn(psColDef->field_index);
+            delete poFeature;
+            continue;
         }
 
-        if( poLayerDefn != NULL &&
-            IS_GEOM_FIELD_INDEX(poLayerDefn, psColDef->field_index) )
+        if( CPLHashSetLookup( hSet, &sEntry ) != NULL )
         {
-            bIsGeometry = TRUE;
-            iSrcGeomField =
-                ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(poLayerDefn, psColDef->field_index);
-            poSrcGFDefn = poLayerDefn->GetGeomFieldDefn(iSrcGeomField);
+            CPLFree( sEntry.pszKey );
+            delete poFeature;
+            continue;
         }
 
-        if( psColDef->target_type == SWQ_GEOMETRY )
-            bIsGeometry = TRUE;
+        OGRGenSQLJoinHashEntry *psEntry = (OGRGenSQLJoinHashEntry *)
+            CPLMalloc( sizeof(OGRGenSQLJoinHashEntry) );
+        *psEntry = sEntry;
+        psEntry->nFID = poFeature->GetFID();
+        psEntry->poFeature = NULL;
+        CPLHashSetInsert( hSet, psEntry );
 
-        if( psColDef->col_func == SWQCF_COUNT )
-            bIsGeometry = FALSE;
+        nMemory += sizeof(OGRGenSQLJoinHashEntry) + 32;
+        if( psEntry->pszKey != NULL )
+            nMemory += strlen( psEntry->pszKey ) + 1;
 
-        if( strlen(psColDef->field_name) == 0 && !bIsGeometry )
+        if( !bKeepFeatures )
         {
-            CPLFree( psColDef->field_name );
-            psColDef->field_name = (char *) CPLMalloc(40);
-            sprintf( psColDef->field_name, "FIELD_%d", poDefn->GetFieldCount()+1 );
+            delete poFeature;
+            continue;
         }
 
-        if( psColDef->field_alias != NULL )
-        {
-            if( bIsGeometry )
-                oGFDefn.SetName(psColDef->field_alias);
-            else
-                oFDefn.SetName(psColDef->field_alias);
-        }
-        else if( psColDef->col_func != SWQCF_NONE )
-        {
-            const swq_operation *op = swq_op_registrar::GetOperator( 
-                (swq_op) psColDef->col_func );
+/* -------------------------------------------------------------------- */
+/*      Approximate the memory held by the feature.                     */
+/* -------------------------------------------------------------------- */
+        OGRFeatureDefn *poFDefn = poFeature->GetDefnRef();
 
-            oFDefn.SetName( CPLSPrintf( "%s_%s",
-                                        op->pszName,
-                                        psColDef->field_name ) );
+        nMemory += sizeof(OGRFeature)
+            + poFDefn->GetFieldCount() * sizeof(OGRField);
+        for( int i = 0; i < poFDefn->GetFieldCount(); i++ )
+        {
+            if( poFDefn->GetFieldDefn(i)->GetType() == OFTString
+                && poFeature->IsFieldSet(i) )
+                nMemory += strlen( poFeature->GetFieldAsString(i) ) + 1;
         }
-        else
+        for( int i = 0; i < poFeature->GetGeomFieldCount(); i++ )
         {
-            if( bIsGeometry )
-                oGFDefn.SetName(psColDef->field_name);
-            else
-                oFDefn.SetName( psColDef->field_name );
+            OGRGeometry *poGeom = poFeature->GetGeomFieldRef(i);
+            if( poGeom != NULL )
+                nMemory += poGeom->WkbSize();
         }
 
-        if( psColDef->col_func == SWQCF_COUNT )
-            oFDefn.SetType( OFTInteger );
-        else if( poSrcFDefn != NULL )
+        psEntry->poFeature = poFeature;
+
+        if( nMemory > nMaxMemory )
         {
-            if( psColDef->col_func != SWQCF_AVG ||
-                psColDef->field_type == SWQ_DATE ||
-                psColDef->field_type == SWQ_TIME ||
-                psColDef->field_type == SWQ_TIMESTAMP )
-                oFDefn.SetType( poSrcFDefn->GetType() );
-            else
-                oFDefn.SetType( OFTReal );
-            if( psColDef->col_func != SWQCF_AVG &&
-                psColDef->col_func != SWQCF_SUM )
+            if( !poLayer->TestCapability( OLCRandomRead ) )
             {
-                oFDefn.SetWidth( poSrcFDefn->GetWidth() );
-                oFDefn.SetPrecision( poSrcFDefn->GetPrecision() );
+                CPLDebug( "GenSQL",
+                          "Join hash table for layer %s exceeds "
+                          "OGR_GENSQL_JOIN_HASH_MAX_MEMORY, "
+                          "using attribute filters instead.",
+                          poLayer->GetName() );
+                poLayer->ResetReading();
+                return FALSE;
             }
-        }
-        else if( poSrcGFDefn != NULL )
-        {
-            oGFDefn.SetType( poSrcGFDefn->GetType() );
-            oGFDefn.SetSpatialRef( poSrcGFDefn->GetSpatialRef() );
-        }
-        else if ( psColDef->field_index >= iFIDFieldIndex )
-        {
-            switch ( SpecialFieldTypes[psColDef->field_index-iFIDFieldIndex] )
-            {
-              case SWQ_INTEGER:
-                oFDefn.SetType( OFTInteger );
-                break;
-              case SWQ_FLOAT:
-                oFDefn.SetType( OFTReal );
-                break;
-              default:
-                oFDefn.SetType( OFTString );
-                break;
-            }
-        }
-        else
-        {
-            switch( psColDef->field_type )
-            {
-              case SWQ_INTEGER:
-              case SWQ_BOOLEAN:
-                oFDefn.SetType( OFTInteger );
-                break;
-                
-              case SWQ_FLOAT:
-                oFDefn.SetType( OFTReal );
-                break;
 
-              default:
-                oFDefn.SetType( OFTString );
-                break;
-            }
+            CPLDebug( "GenSQL",
+                      "Join hash table for layer %s exceeds "
+                      "OGR_GENSQL_JOIN_HASH_MAX_MEMORY, "
+                      "keeping only feature ids.",
+                      poLayer->GetName() );
+            CPLHashSetForeach( hSet, OGRGenSQLJoinDropFeature, NULL );
+            bKeepFeatures = FALSE;
         }
+    }
 
-        /* setting up the target_type */
-        switch (psColDef->target_type)
-        {
-          case SWQ_OTHER:
-            break;
-          case SWQ_INTEGER:
-          case SWQ_BOOLEAN:
-            oFDefn.SetType( OFTInteger );
-            break;
-          case SWQ_FLOAT:
-            oFDefn.SetType( OFTReal );
-            break;
-          case SWQ_STRING:
-            oFDefn.SetType( OFTString );
-            break;
-          case SWQ_TIMESTAMP:
-            oFDefn.SetType( OFTDateTime );
-            break;
-          case SWQ_DATE:
-            oFDefn.SetType( OFTDate );
-            break;
-          case SWQ_TIME:
-            oFDefn.SetType( OFTTime );
-            break;
-          case SWQ_GEOMETRY:
-            break;
+    poLayer->ResetReading();
 
-          default:
-            CPLAssert( FALSE );
-            oFDefn.SetType( OFTString );
-            break;
-        }
+    return TRUE;
+}
 
-        if (psColDef->field_length > 0)
-        {
-            oFDefn.SetWidth( psColDef->field_length );
-        }
+/************************************************************************/
+/*                               Lookup()                               */
+/*                                                                      */
+/*      The returned feature belongs to the hash table unless          */
+/*      *pbOwned is set to TRUE.                                        */
+/************************************************************************/
 
-        if (psColDef->field_precision >= 0)
-        {
-            oFDefn.SetPrecision( psColDef->field_precision );
-        }
+OGRFeature *OGRGenSQLJoinHash::Lookup( OGRGenSQLJoinHashEntry *psKey,
+                                       int *pbOwned )
 
-        if( bIsGeometry )
-        {
-            panGeomFieldToSrcGeomField[poDefn->GetGeomFieldCount()] = iSrcGeomField;
-            /* Hack while drivers haven't been updated so that */
-            /* poSrcDefn->GetGeomFieldDefn(0)->GetSpatialRef() == poSrcLayer->GetSpatialRef() */
-            if( iSrcGeomField == 0 &&
-                poSrcDefn->GetGeomFieldCount() == 1 &&
-                oGFDefn.GetSpatialRef() == NULL )
-            {
-                oGFDefn.SetSpatialRef(poSrcLayer->GetSpatialRef());
-            }
-            int bForceGeomType = FALSE;
-            if( psColDef->eGeomType != wkbUnknown )
-            {
-                oGFDefn.SetType( psColDef->eGeomType );
-                bForceGeomType = TRUE;
-            }
-            if( psColDef->nSRID > 0 )
-            {
-                OGRSpatialReference* poSRS = new OGRSpatialReference();
-                if( poSRS->importFromEPSG( psColDef->nSRID ) == OGRERR_NONE )
-                {
-                    oGFDefn.SetSpatialRef( poSRS );
-                }
-                poSRS->Release();
-            }
+{
+    OGRGenSQLJoinHashEntry *psEntry =
+        (OGRGenSQLJoinHashEntry *) CPLHashSetLookup( hSet, psKey );
 
-            OGRGenSQLGeomFieldDefn* poMyGeomFieldDefn =
-                new OGRGenSQLGeomFieldDefn(&oGFDefn);
-            poMyGeomFieldDefn->bForceGeomType = bForceGeomType;
-            poDefn->AddGeomFieldDefn( poMyGeomFieldDefn, FALSE );
-        }
-        else
-            poDefn->AddFieldDefn( &oFDefn );
-    }
+    *pbOwned = FALSE;
+    if( psEntry == NULL )
+        return NULL;
 
-/* -------------------------------------------------------------------- */
-/*      Add implicit geometry field.                                    */
-/* -------------------------------------------------------------------- */
-    if( psSelectInfo->query_mode == SWQM_RECORDSET &&
-        poDefn->GetGeomFieldCount() == 0 &&
-        poSrcDefn->GetGeomFieldCount() == 1 )
-    {
-        psSelectInfo->result_columns++;
+    if( psEntry->poFeature != NULL )
+        return psEntry->poFeature;
 
-        psSelectInfo->column_defs = (swq_col_def *) 
-            CPLRealloc( psSelectInfo->column_defs, sizeof(swq_col_def) * psSelectInfo->result_columns );
+    *pbOwned = TRUE;
+    return poLayer->GetFeature( psEntry->nFID );
+}
 
-        swq_col_def *col_def = psSelectInfo->column_defs + psSelectInfo->result_columns - 1;
+/************************************************************************/
+/* ==================================================================== */
+/*                        OGRGenSQLGroupTable                           */
+/*                                                                      */
+/*      In memory hash table of the groups of a GROUP BY query, each    */
+/*      with the running summaries of the aggregated columns.  Once     */
+/*      the table uses more than its memory budget, the rows of new     */
+/*      groups are written to one of several partition files, by hash   */
+/*      of their key, and aggregated in a later pass.  A group is thus  */
+/*      never split between the table and a partition.                  */
+/* ==================================================================== */
+/************************************************************************/
 
-        memset( col_def, 0, sizeof(swq_col_def) );
-        const char* pszName = poSrcDefn->GetGeomFieldDefn(0)->GetNameRef();
-        if( *pszName != '\0' )
-            col_def->field_name = CPLStrdup( pszName );
-        else
-            col_def->field_name = CPLStrdup( OGR_GEOMETRY_DEFAULT_NON_EMPTY_NAME );
-        col_def->field_alias = NULL;
-        col_def->table_index = 0;
-        col_def->field_index = GEOM_FIELD_INDEX_TO_ALL_FIELD_INDEX(poSrcDefn, 0);
-        col_def->field_type = SWQ_GEOMETRY;
-        col_def->target_type = SWQ_GEOMETRY;
+#define GROUP_BY_PARTITION_COUNT    8
 
-        panGeomFieldToSrcGeomField[poDefn->GetGeomFieldCount()] = 0;
+/* Tags of the values of the group keys and of the result rows. */
+#define GROUP_VALUE_NULL            0
+#define GROUP_VALUE_INTEGER         1
+#define GROUP_VALUE_REAL            2
+#define GROUP_VALUE_STRING          3
+#define GROUP_VALUE_DATE            4
 
-        OGRGenSQLGeomFieldDefn* poMyGeomFieldDefn =
-            new OGRGenSQLGeomFieldDefn(poSrcDefn->GetGeomFieldDefn(0));
-        poDefn->AddGeomFieldDefn( poMyGeomFieldDefn, FALSE );
+typedef struct
+{
+    GByte        *pabyKey;
+    int           nKeySize;
+    unsigned long nHash;
+    swq_summary  *pasSummaries;  /* one per result column */
+} OGRGenSQLGroupEntry;
 
-        /* Hack while drivers haven't been updated so that */
-        /* poSrcDefn->GetGeomFieldDefn(0)->GetSpatialRef() == poSrcLayer->GetSpatialRef() */
-        if( poSrcDefn->GetGeomFieldDefn(0)->GetSpatialRef() == NULL )
-        {
-            poDefn->GetGeomFieldDefn(0)->SetSpatialRef(poSrcLayer->GetSpatialRef());
-        }
-    }
+typedef struct
+{
+    CPLString     osFilename;
+    int           nLevel;
+} OGRGenSQLGroupPartition;
 
-/* -------------------------------------------------------------------- */
-/*      Now that we have poSrcLayer, we can install a spatial filter    */
-/*      if there is one.                                                */
-/* -------------------------------------------------------------------- */
-    if( poSpatFilter != NULL )
-        SetSpatialFilter( 0, poSpatFilter );
+class OGRGenSQLGroupRows;
 
-    ResetReading();
+class OGRGenSQLGroupTable
+{
+    swq_select  *psSelectInfo;
+    int          nLevel;
+    GIntBig      nMaxMemory;
+    GIntBig      nMemory;
+    CPLHashSet  *hSet;
+    std::vector<OGRGenSQLGroupEntry *> apsGroups;
+    VSILFILE    *afpPartitions[GROUP_BY_PARTITION_COUNT];
+    CPLString    aosPartitionNames[GROUP_BY_PARTITION_COUNT];
+
+    unsigned long HashKey( const GByte *pabyKey, int nKeySize );
+
+  public:
+                 OGRGenSQLGroupTable( swq_select *psSelectInfo, int nLevel,
+                                      GIntBig nMaxMemory );
+                ~OGRGenSQLGroupTable();
+
+    OGRGenSQLGroupEntry *FindGroup( const std::vector<GByte> &abyKey,
+                                    VSILFILE **pfpSpill );
+    const char  *AddValue( OGRGenSQLGroupEntry *psGroup, int iField,
+                           const char *pszValue );
+    int          AddPartition( const char *pszFilename );
+    int          Flush( OGRGenSQLGroupRows *poRows,
+                        std::vector<OGRGenSQLGroupPartition> &aoPending );
+};
 
-    FindAndSetIgnoredFields();
+/************************************************************************/
+/* ==================================================================== */
+/*                         OGRGenSQLGroupRows                           */
+/*                                                                      */
+/*      Result rows of a GROUP BY query.  A row is made of the group    */
+/*      key followed by the value of each aggregated column.  Rows      */
+/*      are kept in memory until they use more than the memory          */
+/*      budget, and are then appended to a temporary file.              */
+/* ==================================================================== */
+/************************************************************************/
 
-    if( !bForwardWhereToSourceLayer )
-        SetAttributeFilter( pszWHERE );
-}
+class OGRGenSQLGroupRows
+{
+    GIntBig      nMaxMemory;
+    std::vector<GByte> abyBuffer;
+    std::vector<GByte> abyScratch;
+    std::vector<vsi_l_offset> anOffsets;
+    CPLString    osFilename;
+    VSILFILE    *fp;
+    vsi_l_offset nFileSize;
+
+  public:
+                 OGRGenSQLGroupRows( GIntBig nMaxMemory );
+                ~OGRGenSQLGroupRows();
+
+    int          Append( const std::vector<GByte> &abyRow );
+    int          GetCount() { return (int) anOffsets.size(); }
+    const GByte *Get( int iRow );
+};
 
 /************************************************************************/
-/*                       ~OGRGenSQLResultsLayer()                       */
+/*                     OGRGenSQLEncodeGroupValue()                      */
 /************************************************************************/
 
-OGRGenSQLResultsLayer::~OGRGenSQLResultsLayer()
+static void OGRGenSQLEncodeGroupValue( std::vector<GByte> &abyBuf,
+                                       int nTag, const OGRField *psField )
 
 {
-    if( m_nFeaturesRead > 0 && poDefn != NULL )
+    abyBuf.push_back( (GByte) nTag );
+
+    switch( nTag )
     {
-        CPLDebug( "GenSQL", "%d features read on layer '%s'.",
-                  (int) m_nFeaturesRead, 
-                  poDefn->GetName() );
+      case GROUP_VALUE_INTEGER:
+        abyBuf.insert( abyBuf.end(), (const GByte *) &(psField->Integer),
+                       (const GByte *) &(psField->Integer) + sizeof(int) );
+        break;
+
+      case GROUP_VALUE_REAL:
+      {
+        double dfValue = psField->Real;
+        // So that -0.0 and 0.0 are the same key.
+        if( dfValue == 0.0 )
+            dfValue = 0.0;
+        abyBuf.insert( abyBuf.end(), (const GByte *) &dfValue,
+                       (const GByte *) &dfValue + sizeof(double) );
+        break;
+      }
+
+      case GROUP_VALUE_STRING:
+      {
+        int nLen = (int) strlen( psField->String );
+        abyBuf.insert( abyBuf.end(), (const GByte *) &nLen,
+                       (const GByte *) &nLen + sizeof(int) );
+        abyBuf.insert( abyBuf.end(), (const GByte *) psField->String,
+                       (const GByte *) psField->String + nLen + 1 );
+        break;
+      }
+
+      case GROUP_VALUE_DATE:
+        abyBuf.insert( abyBuf.end(), (const GByte *) &(psField->Date),
+                       (const GByte *) &(psField->Date) 
+                       + sizeof(psField->Date) );
+        break;
+
+      default:
+        break;
     }
+}
 
-    ClearFilters();
+/************************************************************************/
+/*                     OGRGenSQLDecodeGroupValue()                      */
+/*                                                                      */
+/*      Decode a value written by OGRGenSQLEncodeGroupValue().  String  */
+/*      values point into the buffer.  Returns the position of the      */
+/*      next value.                                                     */
+/************************************************************************/
 
-/* -------------------------------------------------------------------- */
-/*      Free various datastructures.                                    */
-/* -------------------------------------------------------------------- */
-    CPLFree( papoTableLayers );
-    papoTableLayers = NULL;
-             
-    CPLFree( panFIDIndex );
-    CPLFree( panGeomFieldToSrcGeomField );
+static const GByte *OGRGenSQLDecodeGroupValue( const GByte *pabyIter,
+                                               int *pnTag, OGRField *psField )
 
-    delete poSummaryFeature;
-    delete (swq_select *) pSelectInfo;
+{
+    *pnTag = *(pabyIter++);
 
-    if( poDefn != NULL )
+    switch( *pnTag )
     {
-        poDefn->Release();
-    }
+      case GROUP_VALUE_INTEGER:
+        memcpy( &(psField->Integer), pabyIter, sizeof(int) );
+        pabyIter += sizeof(int);
+        break;
 
-/* -------------------------------------------------------------------- */
-/*      Release any additional datasources being used in joins.         */
-/* -------------------------------------------------------------------- */
-    for( int iEDS = 0; iEDS < nExtraDSCount; iEDS++ )
-        GDALClose( (GDALDatasetH)papoExtraDS[iEDS] );
+      case GROUP_VALUE_REAL:
+        memcpy( &(psField->Real), pabyIter, sizeof(double) );
+        pabyIter += sizeof(double);
+        break;
 
-    CPLFree( papoExtraDS );
-    CPLFree( pszWHERE );
+      case GROUP_VALUE_STRING:
+      {
+        int nLen;
+        memcpy( &nLen, pabyIter, sizeof(int) );
+        psField->String = (char *) (pabyIter + sizeof(int));
+        pabyIter += sizeof(int) + nLen + 1;
+        break;
+      }
+
+      case GROUP_VALUE_DATE:
+        memcpy( &(psField->Date), pabyIter, sizeof(psField->Date) );
+        pabyIter += sizeof(psField->Date);
+        break;
+
+      default:
+        psField->Set.nMarker1 = OGRUnsetMarker;
+        psField->Set.nMarker2 = OGRUnsetMarker;
+        break;
+    }
+
+    return pabyIter;
 }
 
 /************************************************************************/
-/*                            ClearFilters()                            */
+/*                      OGRGenSQLReadGroupKey()                         */
 /*                                                                      */
-/*      Clear up all filters currently in place on the target layer,    */
-/*      and joined layers.  We try not to leave them installed          */
-/*      except when actively fetching features.                         */
+/*      Encode the GROUP BY fields of a source feature.                 */
 /************************************************************************/
 
-void OGRGenSQLResultsLayer::ClearFilters()
+static void OGRGenSQLReadGroupKey( swq_select *psSelectInfo,
+                                   OGRFeature *poSrcFeat, int iFIDFieldIndex,
+                                   std::vector<GByte> &abyKey )
 
 {
-/* -------------------------------------------------------------------- */
-/*      Clear any filters installed on the target layer.                */
-/* -------------------------------------------------------------------- */
-    if( poSrcLayer != NULL )
-    {
-        poSrcLayer->SetAttributeFilter( "" );
-        poSrcLayer->SetSpatialFilter( NULL );
-    }
+    abyKey.resize( 0 );
 
-/* -------------------------------------------------------------------- */
-/*      Clear any attribute filter installed on the joined layers.      */
-/* -------------------------------------------------------------------- */
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
-    int iJoin;
-
-    if( psSelectInfo != NULL )
+    for( int iGroup = 0; iGroup < psSelectInfo->group_specs; iGroup++ )
     {
-        for( iJoin = 0; iJoin < psSelectInfo->join_count; iJoin++ )
+        int iField = psSelectInfo->group_defs[iGroup].field_index;
+        OGRField sField;
+        CPLString osValue;
+        int nTag;
+
+        if( !poSrcFeat->IsFieldSet( iField ) )
+            nTag = GROUP_VALUE_NULL;
+        else if( iField >= iFIDFieldIndex )
         {
-            swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
-            OGRLayer *poJoinLayer = 
-                papoTableLayers[psJoinInfo->secondary_table];
-            
-            poJoinLayer->SetAttributeFilter( "" );
-        }
-    }
-
-/* -------------------------------------------------------------------- */
-/*      Clear any ignored field lists installed on source layers        */
-/* -------------------------------------------------------------------- */
-    if( psSelectInfo != NULL )
-    {
-        for( int iTable = 0; iTable < psSelectInfo->table_count; iTable++ )
+            switch( SpecialFieldTypes[iField - iFIDFieldIndex] )
+            {
+              case SWQ_INTEGER:
+                nTag = GROUP_VALUE_INTEGER;
+                sField.Integer = poSrcFeat->GetFieldAsInteger( iField );
+                break;
+
+              case SWQ_FLOAT:
+                nTag = GROUP_VALUE_REAL;
+                sField.Real = poSrcFeat->GetFieldAsDouble( iField );
+                break;
+
+              default:
+                nTag = GROUP_VALUE_STRING;
+                osValue = poSrcFeat->GetFieldAsString( iField );
+                sField.String = (char *) osValue.c_str();
+                break;
+            }
+        }
+        else
         {
-            OGRLayer* poLayer = papoTableLayers[iTable];
-            poLayer->SetIgnoredFields(NULL);
+            OGRField *psSrcField = poSrcFeat->GetRawFieldRef( iField );
+
+            switch( poSrcFeat->GetFieldDefnRef( iField )->GetType() )
+            {
+              case OFTInteger:
+                nTag = GROUP_VALUE_INTEGER;
+                break;
+
+              case OFTReal:
+                nTag = GROUP_VALUE_REAL;
+                break;
+
+              case OFTString:
+                nTag = GROUP_VALUE_STRING;
+                break;
+
+              case OFTDate:
+              case OFTTime:
+              case OFTDateTime:
+                nTag = GROUP_VALUE_DATE;
+                break;
+
+              default:
+                // Rejected by swq_select::parse_group_by().
+                CPLAssert( FALSE );
+                nTag = GROUP_VALUE_NULL;
+                break;
+            }
+            sField = *psSrcField;
         }
+
+        OGRGenSQLEncodeGroupValue( abyKey, nTag, &sField );
     }
 }
 
 /************************************************************************/
-/*                    MustEvaluateSpatialFilterOnGenSQL()               */
+/*                     OGRGenSQLGetGroupKeyIndex()                      */
+/*                                                                      */
+/*      Position in the group key of a field of the primary table.      */
 /************************************************************************/
 
-int OGRGenSQLResultsLayer::MustEvaluateSpatialFilterOnGenSQL()
+static int OGRGenSQLGetGroupKeyIndex( swq_select *psSelectInfo,
+                                      int nFieldIndex )
+
 {
-    int bEvaluateSpatialFilter = FALSE;
-    if( m_poFilterGeom != NULL &&
-        m_iGeomFieldFilter >= 0 &&
-        m_iGeomFieldFilter < GetLayerDefn()->GetGeomFieldCount() )
+    for( int iGroup = 0; iGroup < psSelectInfo->group_specs; iGroup++ )
     {
-        int iSrcGeomField = panGeomFieldToSrcGeomField[m_iGeomFieldFilter];
-        if( iSrcGeomField < 0 )
-            bEvaluateSpatialFilter = TRUE;
+        if( psSelectInfo->group_defs[iGroup].field_index == nFieldIndex )
+            return iGroup;
     }
-    return bEvaluateSpatialFilter;
+
+    return -1;
 }
 
 /************************************************************************/
-/*                       ApplyFiltersToSource()                         */
+/*                     OGRGenSQLGroupHashFunc()                         */
 /************************************************************************/
 
-void OGRGenSQLResultsLayer::ApplyFiltersToSource()
-{
-    poSrcLayer->SetAttributeFilter( pszWHERE );
-    if( m_iGeomFieldFilter >= 0 &&
-        m_iGeomFieldFilter < GetLayerDefn()->GetGeomFieldCount() )
-    {
-        int iSrcGeomField = panGeomFieldToSrcGeomField[m_iGeomFieldFilter];
-        if( iSrcGeomField >= 0 )
-            poSrcLayer->SetSpatialFilter( iSrcGeomField, m_poFilterGeom );
-    }
+static unsigned long OGRGenSQLGroupHashFunc( const void *elt )
 
-    poSrcLayer->ResetReading();
+{
+    return ((const OGRGenSQLGroupEntry *) elt)->nHash;
 }
 
 /************************************************************************/
-/*                            ResetReading()                            */
+/*                     OGRGenSQLGroupEqualFunc()                        */
 /************************************************************************/
 
-void OGRGenSQLResultsLayer::ResetReading() 
+static int OGRGenSQLGroupEqualFunc( const void *elt1, const void *elt2 )
 
 {
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    const OGRGenSQLGroupEntry *psEntry1 = (const OGRGenSQLGroupEntry *) elt1;
+    const OGRGenSQLGroupEntry *psEntry2 = (const OGRGenSQLGroupEntry *) elt2;
 
-    if( psSelectInfo->query_mode == SWQM_RECORDSET )
-    {
-        ApplyFiltersToSource();
-    }
-
-    nNextIndexFID = 0;
+    return psEntry1->nKeySize == psEntry2->nKeySize
+        && memcmp( psEntry1->pabyKey, psEntry2->pabyKey,
+                   psEntry1->nKeySize ) == 0;
 }
 
 /************************************************************************/
-/*                           SetNextByIndex()                           */
-/*                                                                      */
-/*      If we already have an FID list, we can easily resposition       */
-/*      ourselves in it.                                                */
+/*                        OGRGenSQLGroupTable()                         */
 /************************************************************************/
 
-OGRErr OGRGenSQLResultsLayer::SetNextByIndex( long nIndex )
+OGRGenSQLGroupTable::OGRGenSQLGroupTable( swq_select *psSelectInfoIn,
+                                          int nLevelIn,
+                                          GIntBig nMaxMemoryIn )
 
 {
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    psSelectInfo = psSelectInfoIn;
+    nLevel = nLevelIn;
+    nMaxMemory = nMaxMemoryIn;
+    nMemory = 0;
+    hSet = CPLHashSetNew( OGRGenSQLGroupHashFunc, OGRGenSQLGroupEqualFunc,
+                          NULL );
+
+    for( int i = 0; i < GROUP_BY_PARTITION_COUNT; i++ )
+        afpPartitions[i] = NULL;
+}
 
-    CreateOrderByIndex();
+/************************************************************************/
+/*                       ~OGRGenSQLGroupTable()                         */
+/************************************************************************/
 
-    if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD 
-        || psSelectInfo->query_mode == SWQM_DISTINCT_LIST 
-        || panFIDIndex != NULL )
+OGRGenSQLGroupTable::~OGRGenSQLGroupTable()
+
+{
+    for( size_t i = 0; i < apsGroups.size(); i++ )
     {
-        nNextIndexFID = nIndex;
-        return OGRERR_NONE;
+        swq_summary_free( apsGroups[i]->pasSummaries,
+                          psSelectInfo->result_columns );
+        CPLFree( apsGroups[i]->pasSummaries );
+        CPLFree( apsGroups[i]->pabyKey );
+        CPLFree( apsGroups[i] );
     }
-    else
+
+    CPLHashSetDestroy( hSet );
+
+    /* Partitions that were not handed over by Flush() */
+    for( int i = 0; i < GROUP_BY_PARTITION_COUNT; i++ )
     {
-        return poSrcLayer->SetNextByIndex( nIndex );
+        if( afpPartitions[i] != NULL )
+        {
+            VSIFCloseL( afpPartitions[i] );
+            VSIUnlink( aosPartitionNames[i] );
+        }
     }
 }
 
 /************************************************************************/
-/*                             GetExtent()                              */
+/*                              HashKey()                               */
+/*                                                                      */
+/*      FNV-1a hash of a key, seeded with the level so that the         */
+/*      groups of a partition spread over the partitions of the next    */
+/*      level.                                                          */
 /************************************************************************/
 
-OGRErr OGRGenSQLResultsLayer::GetExtent( int iGeomField,
-                                         OGREnvelope *psExtent, 
-                                         int bForce )
+unsigned long OGRGenSQLGroupTable::HashKey( const GByte *pabyKey,
+                                            int nKeySize )
 
 {
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    GUInt32 nHash = 2166136261U ^ ((GUInt32) nLevel * 2654435761U);
 
-    if( iGeomField < 0 || iGeomField >= GetLayerDefn()->GetGeomFieldCount() ||
-        GetLayerDefn()->GetGeomFieldDefn(iGeomField)->GetType() == wkbNone )
+    for( int i = 0; i < nKeySize; i++ )
     {
-        if( iGeomField != 0 )
-        {
-            CPLError(CE_Failure, CPLE_AppDefined,
-                     "Invalid geometry field index : %d", iGeomField);
-        }
-        return OGRERR_FAILURE;
+        nHash ^= pabyKey[i];
+        nHash *= 16777619U;
     }
 
-    if( psSelectInfo->query_mode == SWQM_RECORDSET )
-    {
-        int iSrcGeomField = panGeomFieldToSrcGeomField[iGeomField];
-        if( iSrcGeomField >= 0 )
-            return poSrcLayer->GetExtent( iSrcGeomField, psExtent, bForce );
-        else if( iGeomField == 0 )
-            return OGRLayer::GetExtent( psExtent, bForce );
-        else
-            return OGRLayer::GetExtent( iGeomField, psExtent, bForce );
-    }
-    else
-        return OGRERR_FAILURE;
+    return nHash;
 }
 
 /************************************************************************/
-/*                          GetFeatureCount()                           */
+/*                             FindGroup()                              */
+/*                                                                      */
+/*      Find or create the group of a key.  If the group is not in the  */
+/*      table and the table is full, the key is written to the          */
+/*      partition file returned in *pfpSpill, where the caller must     */
+/*      write the values of the row, and NULL is returned.              */
 /************************************************************************/
 
-int OGRGenSQLResultsLayer::GetFeatureCount( int bForce )
+OGRGenSQLGroupEntry *
+OGRGenSQLGroupTable::FindGroup( const std::vector<GByte> &abyKey,
+                                VSILFILE **pfpSpill )
 
 {
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    OGRGenSQLGroupEntry sKey;
+    int nKeySize = (int) abyKey.size();
 
-    CreateOrderByIndex();
+    *pfpSpill = NULL;
 
-    if( psSelectInfo->query_mode == SWQM_DISTINCT_LIST )
+    sKey.pabyKey = nKeySize ? (GByte *) &abyKey[0] : NULL;
+    sKey.nKeySize = nKeySize;
+    sKey.nHash = HashKey( sKey.pabyKey, nKeySize );
+
+    OGRGenSQLGroupEntry *psGroup = (OGRGenSQLGroupEntry *)
+        CPLHashSetLookup( hSet, &sKey );
+    if( psGroup != NULL )
+        return psGroup;
+
+/* -------------------------------------------------------------------- */
+/*      Add a new group while we are below our memory budget.  We       */
+/*      always accept one group so that each pass makes progress.      */
+/* -------------------------------------------------------------------- */
+    if( nMemory < nMaxMemory || apsGroups.empty() )
     {
-        if( !PrepareSummary() )
-            return 0;
+        psGroup = (OGRGenSQLGroupEntry *)
+            CPLMalloc( sizeof(OGRGenSQLGroupEntry) );
+        psGroup->pabyKey = (GByte *) CPLMalloc( MAX(1, nKeySize) );
+        if( nKeySize )
+            memcpy( psGroup->pabyKey, &abyKey[0], nKeySize );
+        psGroup->nKeySize = nKeySize;
+        psGroup->nHash = sKey.nHash;
+        psGroup->pasSummaries = (swq_summary *)
+            CPLMalloc( sizeof(swq_summary) * psSelectInfo->result_columns );
+        swq_summary_init( psGroup->pasSummaries, 
+                          psSelectInfo->result_columns );
+
+        CPLHashSetInsert( hSet, psGroup );
+        apsGroups.push_back( psGroup );
+
+        nMemory += sizeof(OGRGenSQLGroupEntry) + nKeySize
+            + sizeof(swq_summary) * psSelectInfo->result_columns
+            + 4 * sizeof(void *);
+
+        return psGroup;
+    }
 
-        swq_summary *psSummary = psSelectInfo->column_summary + 0;
+/* -------------------------------------------------------------------- */
+/*      Otherwise write the key to its partition.                       */
+/* -------------------------------------------------------------------- */
+    int iPartition = (int) ((sKey.nHash >> 24) % GROUP_BY_PARTITION_COUNT);
 
-        if( psSummary == NULL )
-            return 0;
+    if( afpPartitions[iPartition] == NULL )
+    {
+        aosPartitionNames[iPartition] =
+            CPLGenerateTempFilename( "ogrgensql_group" );
+        afpPartitions[iPartition] =
+            VSIFOpenL( aosPartitionNames[iPartition], "wb+" );
+        if( afpPartitions[iPartition] == NULL )
+        {
+            CPLError( CE_Failure, CPLE_FileIO,
+                      "Cannot create temporary file %s.",
+                      aosPartitionNames[iPartition].c_str() );
+            return NULL;
+        }
+    }
 
-        return psSummary->count;
+    *pfpSpill = afpPartitions[iPartition];
+
+    if( VSIFWriteL( &nKeySize, sizeof(int), 1, *pfpSpill ) != 1
+        || (nKeySize > 0
+            && (int) VSIFWriteL( &abyKey[0], 1, nKeySize, *pfpSpill )
+               != nKeySize) )
+    {
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Cannot write to temporary file %s.",
+                  aosPartitionNames[iPartition].c_str() );
+        *pfpSpill = NULL;
     }
-    else if( psSelectInfo->query_mode != SWQM_RECORDSET )
-        return 1;
-    else if( m_poAttrQuery == NULL && !MustEvaluateSpatialFilterOnGenSQL() )
-        return poSrcLayer->GetFeatureCount( bForce );
-    else
-        return OGRLayer::GetFeatureCount( bForce );
+
+    return NULL;
 }
 
 /************************************************************************/
-/*                           TestCapability()                           */
+/*                              AddValue()                              */
 /************************************************************************/
 
-int OGRGenSQLResultsLayer::TestCapability( const char *pszCap )
+const char *OGRGenSQLGroupTable::AddValue( OGRGenSQLGroupEntry *psGroup,
+                                           int iField, const char *pszValue )
 
 {
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+    swq_summary *psSummary = psGroup->pasSummaries + iField;
+    int nCountBefore = psSummary->count;
 
-    if( EQUAL(pszCap,OLCFastSetNextByIndex) )
-    {
-        if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD 
-            || psSelectInfo->query_mode == SWQM_DISTINCT_LIST 
-            || panFIDIndex != NULL )
-            return TRUE;
-        else 
-            return poSrcLayer->TestCapability( pszCap );
-    }
+    const char *pszError =
+        swq_summary_add_value( psColDef, psSummary, pszValue );
 
-    if( psSelectInfo->query_mode == SWQM_RECORDSET
-        && (EQUAL(pszCap,OLCFastFeatureCount) 
-            || EQUAL(pszCap,OLCRandomRead) 
-            || EQUAL(pszCap,OLCFastGetExtent)) )
-        return poSrcLayer->TestCapability( pszCap );
+    /* Account for the values added to the distinct list. */
+    if( psColDef->distinct_flag && psSummary->count != nCountBefore )
+        nMemory += (pszValue != NULL ? strlen(pszValue) + 1 : 0)
+            + 4 * sizeof(void *);
 
-    else if( psSelectInfo->query_mode != SWQM_RECORDSET )
-    {
-        if( EQUAL(pszCap,OLCFastFeatureCount) )
-            return TRUE;
-    }
-    return FALSE;
+    return pszError;
 }
 
 /************************************************************************/
-/*                        ContainGeomSpecialField()                     */
+/*                     OGRGenSQLWriteSpillValue()                       */
 /************************************************************************/
 
-int OGRGenSQLResultsLayer::ContainGeomSpecialField(swq_expr_node* expr)
+static int OGRGenSQLWriteSpillValue( VSILFILE *fp, const char *pszValue )
+
 {
-    if (expr->eNodeType == SNT_COLUMN)
-    {
-        if( expr->table_index == 0 && expr->field_index != -1 )
-        {
-            OGRLayer* poLayer = papoTableLayers[expr->table_index];
-            int nSpecialFieldIdx = expr->field_index -
-                            poLayer->GetLayerDefn()->GetFieldCount();
-            if( nSpecialFieldIdx == SPF_OGR_GEOMETRY ||
-                nSpecialFieldIdx == SPF_OGR_GEOM_WKT ||
-                nSpecialFieldIdx == SPF_OGR_GEOM_AREA )
-                return TRUE;
-            if( expr->field_index ==
-                    GEOM_FIELD_INDEX_TO_ALL_FIELD_INDEX(poLayer->GetLayerDefn(), 0) )
-                return TRUE;
-            return FALSE;
-        }
-    }
-    else if (expr->eNodeType == SNT_OPERATION)
+    int nLen = (pszValue != NULL) ? (int) strlen(pszValue) : -1;
+
+    if( VSIFWriteL( &nLen, sizeof(int), 1, fp ) != 1
+        || (nLen > 0 && (int) VSIFWriteL( pszValue, 1, nLen, fp ) != nLen) )
     {
-        for( int i = 0; i < expr->nSubExprCount; i++ )
-        {
-            if (ContainGeomSpecialField(expr->papoSubExpr[i]))
-                return TRUE;
-        }
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Cannot write to GROUP BY temporary file." );
+        return FALSE;
     }
-    return FALSE;
+
+    return TRUE;
 }
 
 /************************************************************************/
-/*                           PrepareSummary()                           */
+/*                            AddPartition()                            */
+/*                                                                      */
+/*      Aggregate the rows of a partition file written by FindGroup()   */
+/*      at the previous level.                                          */
 /************************************************************************/
 
-int OGRGenSQLResultsLayer::PrepareSummary()
+int OGRGenSQLGroupTable::AddPartition( const char *pszFilename )
 
 {
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    VSILFILE *fp = VSIFOpenL( pszFilename, "rb" );
+    if( fp == NULL )
+    {
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Cannot open temporary file %s.", pszFilename );
+        return FALSE;
+    }
 
-    if( poSummaryFeature != NULL )
-        return TRUE;
+    std::vector<GByte> abyKey;
+    std::vector<char> achValue;
+    int nKeySize, iField;
+    int bOK = TRUE;
 
-    poSummaryFeature = new OGRFeature( poDefn );
-    poSummaryFeature->SetFID( 0 );
+    while( bOK && VSIFReadL( &nKeySize, sizeof(int), 1, fp ) == 1 )
+    {
+        abyKey.resize( nKeySize );
+        if( nKeySize > 0
+            && (int) VSIFReadL( &abyKey[0], 1, nKeySize, fp ) != nKeySize )
+        {
+            bOK = FALSE;
+            break;
+        }
 
-/* -------------------------------------------------------------------- */
-/*      Ensure our query parameters are in place on the source          */
-/*      layer.  And initialize reading.                                 */
-/* -------------------------------------------------------------------- */
-    ApplyFiltersToSource();
+        VSILFILE *fpSpill = NULL;
+        OGRGenSQLGroupEntry *psGroup = FindGroup( abyKey, &fpSpill );
+        if( psGroup == NULL && fpSpill == NULL )
+        {
+            bOK = FALSE;
+            break;
+        }
 
-/* -------------------------------------------------------------------- */
-/*      Ignore geometry reading if no spatial filter in place and that  */
-/*      the where clause and no column references OGR_GEOMETRY,         */
-/*      OGR_GEOM_WKT or OGR_GEOM_AREA special fields.                   */
-/* -------------------------------------------------------------------- */
-    int bSaveIsGeomIgnored = poSrcLayer->GetLayerDefn()->IsGeometryIgnored();
-    if ( m_poFilterGeom == NULL && ( psSelectInfo->where_expr == NULL ||
-                !ContainGeomSpecialField(psSelectInfo->where_expr) ) )
-    {
-        int bFoundGeomExpr = FALSE;
-        for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+        for( iField = 0; bOK && iField < psSelectInfo->result_columns;
+             iField++ )
         {
             swq_col_def *psColDef = psSelectInfo->column_defs + iField;
-            if (psColDef->table_index == 0 && psColDef->field_index != -1)
+            const char *pszValue = NULL;
+            int nLen;
+
+            if( psColDef->col_func == SWQCF_NONE )
+                continue;
+
+            if( VSIFReadL( &nLen, sizeof(int), 1, fp ) != 1 )
             {
-                OGRLayer* poLayer = papoTableLayers[psColDef->table_index];
-                int nSpecialFieldIdx = psColDef->field_index -
-                                poLayer->GetLayerDefn()->GetFieldCount();
-                if (nSpecialFieldIdx == SPF_OGR_GEOMETRY ||
-                    nSpecialFieldIdx == SPF_OGR_GEOM_WKT ||
-                    nSpecialFieldIdx == SPF_OGR_GEOM_AREA)
-                {
-                    bFoundGeomExpr = TRUE;
-                    break;
-                }
-                if( psColDef->field_index ==
-                        GEOM_FIELD_INDEX_TO_ALL_FIELD_INDEX(poLayer->GetLayerDefn(), 0) )
+                bOK = FALSE;
+                break;
+            }
+            if( nLen >= 0 )
+            {
+                achValue.resize( nLen + 1 );
+                if( (int) VSIFReadL( &achValue[0], 1, nLen, fp ) != nLen )
                 {
-                    bFoundGeomExpr = TRUE;
+                    bOK = FALSE;
                     break;
                 }
+                achValue[nLen] = '\0';
+                pszValue = &achValue[0];
             }
-            if (psColDef->expr != NULL && ContainGeomSpecialField(psColDef->expr))
+
+            if( psGroup != NULL )
             {
-                bFoundGeomExpr = TRUE;
-                break;
+                const char *pszError = AddValue( psGroup, iField, pszValue );
+                if( pszError != NULL )
+                {
+                    CPLError( CE_Failure, CPLE_AppDefined, "%s", pszError );
+                    bOK = FALSE;
+                }
             }
+            else
+                bOK = OGRGenSQLWriteSpillValue( fpSpill, pszValue );
         }
-        if (!bFoundGeomExpr)
-            poSrcLayer->GetLayerDefn()->SetGeometryIgnored(TRUE);
     }
 
-/* -------------------------------------------------------------------- */
-/*      We treat COUNT(*) as a special case, and fill with              */
-/*      GetFeatureCount().                                              */
-/* -------------------------------------------------------------------- */
+    VSIFCloseL( fp );
 
-    if( psSelectInfo->result_columns == 1 
-        && psSelectInfo->column_defs[0].col_func == SWQCF_COUNT
-        && psSelectInfo->column_defs[0].field_index < 0 )
-    {
-        poSummaryFeature->SetField( 0, poSrcLayer->GetFeatureCount( TRUE ) );
-        poSrcLayer->GetLayerDefn()->SetGeometryIgnored(bSaveIsGeomIgnored);
-        return TRUE;
-    }
+    return bOK;
+}
 
-/* -------------------------------------------------------------------- */
-/*      Otherwise, process all source feature through the summary       */
-/*      building facilities of SWQ.                                     */
-/* -------------------------------------------------------------------- */
-    const char *pszError;
-    OGRFeature *poSrcFeature;
+/************************************************************************/
+/*                               Flush()                                */
+/*                                                                      */
+/*      Append the result rows of the groups of the table to poRows,    */
+/*      and hand over the partition files to process to aoPending.      */
+/************************************************************************/
+
+int OGRGenSQLGroupTable::Flush( OGRGenSQLGroupRows *poRows,
+                                std::vector<OGRGenSQLGroupPartition> &aoPending )
+
+{
+    std::vector<GByte> abyRow;
     int iField;
 
-    while( (poSrcFeature = poSrcLayer->GetNextFeature()) != NULL )
+    for( size_t iGroup = 0; iGroup < apsGroups.size(); iGroup++ )
     {
+        OGRGenSQLGroupEntry *psGroup = apsGroups[iGroup];
+
+        abyRow.resize( 0 );
+        abyRow.insert( abyRow.end(), psGroup->pabyKey,
+                       psGroup->pabyKey + psGroup->nKeySize );
+
         for( iField = 0; iField < psSelectInfo->result_columns; iField++ )
         {
             swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+            swq_summary *psSummary = psGroup->pasSummaries + iField;
+            int bIsDate = psColDef->field_type == SWQ_DATE ||
+                          psColDef->field_type == SWQ_TIME ||
+                          psColDef->field_type == SWQ_TIMESTAMP;
+            OGRField sField;
+            CPLString osValue;
+            int nTag = GROUP_VALUE_REAL;
+
+            if( psColDef->col_func == SWQCF_NONE )
+                continue;
 
-            if (psColDef->col_func == SWQCF_COUNT)
+            if( psColDef->col_func == SWQCF_COUNT )
             {
-                /* psColDef->field_index can be -1 in the case of a COUNT(*) */
-                if (psColDef->field_index < 0)
-                    pszError = swq_select_summarize( psSelectInfo, iField, "" );
-                else if (IS_GEOM_FIELD_INDEX(poSrcLayer->GetLayerDefn(), psColDef->field_index) )
-                {
-                    int iSrcGeomField = ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(
-                            poSrcLayer->GetLayerDefn(), psColDef->field_index);
-                    OGRGeometry* poGeom = poSrcFeature->GetGeomFieldRef(iSrcGeomField);
-                    if( poGeom != NULL )
-                        pszError = swq_select_summarize( psSelectInfo, iField, "" );
-                    else
-                        pszError = NULL;
-                }
-                else if (poSrcFeature->IsFieldSet(psColDef->field_index))
-                    pszError = swq_select_summarize( psSelectInfo, iField, poSrcFeature->GetFieldAsString(
-                                                psColDef->field_index ) );
-                else
-                    pszError = NULL;
+                nTag = GROUP_VALUE_INTEGER;
+                sField.Integer = psSummary->count;
             }
-            else
+            /* The other aggregates are NULL if no value was accumulated. */
+            else if( psSummary->count == 0 )
+                nTag = GROUP_VALUE_NULL;
+            else if( psColDef->col_func == SWQCF_AVG && bIsDate )
             {
-                const char* pszVal = NULL;
-                if (poSrcFeature->IsFieldSet(psColDef->field_index))
-                    pszVal = poSrcFeature->GetFieldAsString(
-                                                psColDef->field_index );
-                pszError = swq_select_summarize( psSelectInfo, iField, pszVal );
+                struct tm brokendowntime;
+                CPLUnixTimeToYMDHMS(
+                    (GIntBig)(psSummary->sum / psSummary->count),
+                    &brokendowntime );
+                osValue.Printf( "%04d/%02d/%02d %02d:%02d:%02d",
+                                brokendowntime.tm_year + 1900,
+                                brokendowntime.tm_mon + 1,
+                                brokendowntime.tm_mday,
+                                brokendowntime.tm_hour,
+                                brokendowntime.tm_min,
+                                brokendowntime.tm_sec );
+                nTag = GROUP_VALUE_STRING;
             }
-            
-            if( pszError != NULL )
+            else if( psColDef->col_func == SWQCF_AVG )
+                sField.Real = psSummary->sum / psSummary->count;
+            else if( psColDef->col_func == SWQCF_MIN && bIsDate )
             {
-                delete poSrcFeature;
-                delete poSummaryFeature;
-                poSummaryFeature = NULL;
+                osValue = psSummary->szMin;
+                nTag = GROUP_VALUE_STRING;
+            }
+            else if( psColDef->col_func == SWQCF_MIN )
+                sField.Real = psSummary->min;
+            else if( psColDef->col_func == SWQCF_MAX && bIsDate )
+            {
+                osValue = psSummary->szMax;
+                nTag = GROUP_VALUE_STRING;
+            }
+            else if( psColDef->col_func == SWQCF_MAX )
+                sField.Real = psSummary->max;
+            else
+                sField.Real = psSummary->sum;
 
-                poSrcLayer->GetLayerDefn()->SetGeometryIgnored(bSaveIsGeomIgnored);
+            if( nTag == GROUP_VALUE_STRING )
+                sField.String = (char *) osValue.c_str();
 
-                CPLError( CE_Failure, CPLE_AppDefined, "%s", pszError );
-                return FALSE;
-            }
+            OGRGenSQLEncodeGroupValue( abyRow, nTag, &sField );
         }
 
-        delete poSrcFeature;
+        if( !poRows->Append( abyRow ) )
+            return FALSE;
     }
 
-    poSrcLayer->GetLayerDefn()->SetGeometryIgnored(bSaveIsGeomIgnored);
+    for( int i = 0; i < GROUP_BY_PARTITION_COUNT; i++ )
+    {
+        if( afpPartitions[i] == NULL )
+            continue;
 
-    pszError = swq_select_finish_summarize( psSelectInfo );
-    if( pszError != NULL )
+        VSIFCloseL( afpPartitions[i] );
+        afpPartitions[i] = NULL;
+
+        OGRGenSQLGroupPartition oPartition;
+        oPartition.osFilename = aosPartitionNames[i];
+        oPartition.nLevel = nLevel + 1;
+        aoPending.push_back( oPartition );
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                         OGRGenSQLGroupRows()                         */
+/************************************************************************/
+
+OGRGenSQLGroupRows::OGRGenSQLGroupRows( GIntBig nMaxMemoryIn )
+
+{
+    nMaxMemory = nMaxMemoryIn;
+    fp = NULL;
+    nFileSize = 0;
+}
+
+/************************************************************************/
+/*                        ~OGRGenSQLGroupRows()                         */
+/************************************************************************/
+
+OGRGenSQLGroupRows::~OGRGenSQLGroupRows()
+
+{
+    if( fp != NULL )
     {
-        delete poSummaryFeature;
-        poSummaryFeature = NULL;
-        
-        CPLError( CE_Failure, CPLE_AppDefined, "%s", pszError );
-        return FALSE;
+        VSIFCloseL( fp );
+        VSIUnlink( osFilename );
     }
+}
 
-/* -------------------------------------------------------------------- */
-/*      If we have run out of features on the source layer, clear       */
-/*      away the filters we have installed till a next run through      */
-/*      the features.                                                   */
-/* -------------------------------------------------------------------- */
-    if( poSrcFeature == NULL )
-        ClearFilters();
+/************************************************************************/
+/*                               Append()                               */
+/************************************************************************/
+
+int OGRGenSQLGroupRows::Append( const std::vector<GByte> &abyRow )
+
+{
+    anOffsets.push_back( nFileSize + abyBuffer.size() );
+    abyBuffer.insert( abyBuffer.end(), abyRow.begin(), abyRow.end() );
+
+    if( (GIntBig) abyBuffer.size() <= nMaxMemory )
+        return TRUE;
 
 /* -------------------------------------------------------------------- */
-/*      Now apply the values to the summary feature.  If we are in      */
-/*      DISTINCT_LIST mode we don't do this step.                       */
+/*      Move the buffered rows to the end of our temporary file.        */
 /* -------------------------------------------------------------------- */
-    if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD )
+    if( fp == NULL )
     {
-        for( iField = 0; iField < psSelectInfo->result_columns; iField++ )
+        osFilename = CPLGenerateTempFilename( "ogrgensql_group" );
+        fp = VSIFOpenL( osFilename, "wb+" );
+        if( fp == NULL )
         {
-            swq_col_def *psColDef = psSelectInfo->column_defs + iField;
-            if (psSelectInfo->column_summary != NULL)
-            {
-                swq_summary *psSummary = psSelectInfo->column_summary + iField;
-
-                if( psColDef->col_func == SWQCF_AVG )
-                {
-                    if( psColDef->field_type == SWQ_DATE ||
-                        psColDef->field_type == SWQ_TIME ||
-                        psColDef->field_type == SWQ_TIMESTAMP)
-                    {
-                        struct tm brokendowntime;
-                        CPLUnixTimeToYMDHMS((GIntBig)(psSummary->sum / psSummary->count), &brokendowntime);
-                        poSummaryFeature->SetField( iField,
-                                                    brokendowntime.tm_year + 1900,
-                                                    brokendowntime.tm_mon + 1,
-                                                    brokendowntime.tm_mday,
-                                                    brokendowntime.tm_hour,
-                                                    brokendowntime.tm_min,
-                                                    brokendowntime.tm_sec, 0);
-                    }
-                    else
-                        poSummaryFeature->SetField( iField,
-                                                    psSummary->sum / psSummary->count );
-                }
-                else if( psColDef->col_func == SWQCF_MIN )
-                {
-                    if( psColDef->field_type == SWQ_DATE ||
-                        psColDef->field_type == SWQ_TIME ||
-                        psColDef->field_type == SWQ_TIMESTAMP)
-                        poSummaryFeature->SetField( iField, psSummary->szMin );
-                    else
-                        poSummaryFeature->SetField( iField, psSummary->min );
-                }
-                else if( psColDef->col_func == SWQCF_MAX )
-                {
-                    if( psColDef->field_type == SWQ_DATE ||
-                        psColDef->field_type == SWQ_TIME ||
-                        psColDef->field_type == SWQ_TIMESTAMP)
-                        poSummaryFeature->SetField( iField, psSummary->szMax );
-                    else
-                        poSummaryFeature->SetField( iField, psSummary->max );
-                }
-                else if( psColDef->col_func == SWQCF_COUNT )
-                    poSummaryFeature->SetField( iField, psSummary->count );
-                else if( psColDef->col_func == SWQCF_SUM )
-                    poSummaryFeature->SetField( iField, psSummary->sum );
-            }
-            else if ( psColDef->col_func == SWQCF_COUNT )
-                poSummaryFeature->SetField( iField, 0 );
+            CPLError( CE_Failure, CPLE_FileIO,
+                      "Cannot create temporary file %s.",
+                      osFilename.c_str() );
+            return FALSE;
         }
     }
 
+    if( VSIFSeekL( fp, nFileSize, SEEK_SET ) != 0
+        || VSIFWriteL( &abyBuffer[0], 1, abyBuffer.size(), fp )
+           != abyBuffer.size() )
+    {
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Cannot write to temporary file %s.",
+                  osFilename.c_str() );
+        return FALSE;
+    }
+
+    nFileSize += abyBuffer.size();
+    abyBuffer.resize( 0 );
+
     return TRUE;
 }
 
 /************************************************************************/
-/*                       OGRMultiFeatureFetcher()                       */
+/*                                Get()                                 */
+/*                                                                      */
+/*      Fetch a row.  The returned buffer is valid until the next       */
+/*      call.                                                           */
 /************************************************************************/
 
-static swq_expr_node *OGRMultiFeatureFetcher( swq_expr_node *op, 
-                                              void *pFeatureList )
+const GByte *OGRGenSQLGroupRows::Get( int iRow )
 
 {
-    std::vector<OGRFeature*> *papoFeatures = 
-        (std::vector<OGRFeature*> *) pFeatureList;
-    OGRFeature *poFeature;
-    swq_expr_node *poRetNode = NULL;
+    if( iRow < 0 || iRow >= GetCount() )
+        return NULL;
 
-    CPLAssert( op->eNodeType == SNT_COLUMN );
+    vsi_l_offset nStart = anOffsets[iRow];
+    if( nStart >= nFileSize )
+        return &abyBuffer[0] + (size_t) (nStart - nFileSize);
 
-/* -------------------------------------------------------------------- */
-/*      What feature are we using?  The primary or one of the joined ones?*/
-/* -------------------------------------------------------------------- */
-    if( op->table_index < 0 || op->table_index >= (int)papoFeatures->size() )
+    /* Rows are flushed whole, so this one is entirely in the file. */
+    vsi_l_offset nEnd = (iRow + 1 < GetCount()) ? anOffsets[iRow + 1]
+                                                 : nFileSize;
+    if( nEnd > nFileSize )
+        nEnd = nFileSize;
+
+    size_t nSize = (size_t) (nEnd - nStart);
+    abyScratch.resize( MAX(1, nSize) );
+    if( VSIFSeekL( fp, nStart, SEEK_SET ) != 0
+        || VSIFReadL( &abyScratch[0], 1, nSize, fp ) != nSize )
     {
-        CPLError( CE_Failure, CPLE_AppDefined,
-                  "Request for unexpected table_index (%d) in field fetcher.",
-                  op->table_index );
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Cannot read temporary file %s.", osFilename.c_str() );
         return NULL;
     }
-    
-    poFeature = (*papoFeatures)[op->table_index];
 
-/* -------------------------------------------------------------------- */
-/*      Fetch the value.                                                */
-/* -------------------------------------------------------------------- */
-    switch( op->field_type )
-    {
-      case SWQ_INTEGER:
-      case SWQ_BOOLEAN:
-        if( poFeature == NULL 
-            || !poFeature->IsFieldSet(op->field_index) )
-        {
-            poRetNode = new swq_expr_node(0);
-            poRetNode->is_null = TRUE;
-        }
-        else
-            poRetNode = new swq_expr_node( 
-                poFeature->GetFieldAsInteger(op->field_index) );
-        break;
+    return &abyScratch[0];
+}
 
-      case SWQ_FLOAT:
-        if( poFeature == NULL 
-            || !poFeature->IsFieldSet(op->field_index) )
+/************************************************************************/
+/*               OGRGenSQLResultsLayerHasSpecialField()                 */
+/************************************************************************/
+
+static
+int OGRGenSQLResultsLayerHasSpecialField(swq_expr_node* expr,
+                                         int nMinIndexForSpecialField)
+{
+    if (expr->eNodeType == SNT_COLUMN)
+    {
+        if (expr->table_index == 0)
         {
-            poRetNode = new swq_expr_node( 0.0 );
-            poRetNode->is_null = TRUE;
+            return expr->field_index >= nMinIndexForSpecialField &&
+                   expr->field_index < nMinIndexForSpecialField + SPECIAL_FIELD_COUNT;
         }
-        else
-            poRetNode = new swq_expr_node( 
-                poFeature->GetFieldAsDouble(op->field_index) );
-        break;
-        
-      case SWQ_GEOMETRY:
-        if( poFeature == NULL )
+    }
+    else if (expr->eNodeType == SNT_OPERATION)
+    {
+        for( int i = 0; i < expr->nSubExprCount; i++ )
         {
-            poRetNode = new swq_expr_node( (OGRGeometry*) NULL );
+            if (OGRGenSQLResultsLayerHasSpecialField(expr->papoSubExpr[i],
+                                                     nMinIndexForSpecialField))
+                return TRUE;
         }
-        else
+    }
+    return FALSE;
+}
+
+/************************************************************************/
+/*                       OGRGenSQLResultsLayer()                        */
+/************************************************************************/
+
+OGRGenSQLResultsLayer::OGRGenSQLResultsLayer( GDALDataset *poSrcDS,
+                                              void *pSelectInfo, 
+                                              OGRGeometry *poSpatFilter,
+                                              const char *pszWHERE,
+                                              const char *pszDialect )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    this->poSrcDS = poSrcDS;
+    this->pSelectInfo = pSelectInfo;
+    poDefn = NULL;
+    poSummaryFeature = NULL;
+    panFIDIndex = NULL;
+    bOrderByValid = FALSE;
+    nIndexSize = 0;
+    nNextIndexFID = 0;
+    nIteratedFeatures = 0;
+    nExtraDSCount = 0;
+    papoExtraDS = NULL;
+    panGeomFieldToSrcGeomField = NULL;
+    bJoinHashesBuilt = FALSE;
+    papoJoinHashes = NULL;
+    poGroupRows = NULL;
+
+/* -------------------------------------------------------------------- */
+/*      Identify all the layers involved in the SELECT.                 */
+/* -------------------------------------------------------------------- */
+    int iTable;
+
+    papoTableLayers = (OGRLayer **) 
+        CPLCalloc( sizeof(OGRLayer *), psSelectInfo->table_count );
+
+    for( iTable = 0; iTable < psSelectInfo->table_count; iTable++ )
+    {
+        swq_table_def *psTableDef = psSelectInfo->table_defs + iTable;
+        GDALDataset *poTableDS = poSrcDS;
+
+        if( psTableDef->data_source != NULL )
         {
-            int iSrcGeomField = ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(
+            poTableDS = (GDALDataset*) GDALOpenEx( psTableDef->data_source,
+                            GDAL_OF_VECTOR | GDAL_OF_SHARED, NULL, NULL, NULL );
+            if( poTableDS == NULL )
+            {
+                if( strlen(CPLGetLastErrorMsg()) == 0 )
+                    CPLError( CE_Failure, CPLE_AppDefined, 
+                              "Unable to open secondary datasource\n"
+                              "`%s' required by JOIN.",
+                              psTableDef->data_source );
+                return;
+            }
+
+            papoExtraDS = (GDALDataset **)
+                CPLRealloc( papoExtraDS, sizeof(void*) * ++nExtraDSCount );
+
+            papoExtraDS[nExtraDSCount-1] = poTableDS;
+        }
+
+        papoTableLayers[iTable] = 
+            poTableDS->GetLayerByName( psTableDef->table_name );
+        
+        CPLAssert( papoTableLayers[iTable] != NULL );
+
+        if( papoTableLayers[iTable] == NULL )
+            return;
+    }
+    
+    poSrcLayer = papoTableLayers[0];
+
+/* -------------------------------------------------------------------- */
+/*      If the user has explicitely requested a OGRSQL dialect, then    */
+/*      we should avoid to forward the where clause to the source layer */
+/*      when there is a risk it cannot understand it (#4022)            */
+/* -------------------------------------------------------------------- */
+    int bForwardWhereToSourceLayer = TRUE;
+    if( pszWHERE )
+    {
+        if( psSelectInfo->where_expr && pszDialect != NULL &&
+            EQUAL(pszDialect, "OGRSQL") )
+        {
+            int nMinIndexForSpecialField = poSrcLayer->GetLayerDefn()->GetFieldCount();
+            bForwardWhereToSourceLayer = !OGRGenSQLResultsLayerHasSpecialField
+                            (psSelectInfo->where_expr, nMinIndexForSpecialField);
+        }
+        if (bForwardWhereToSourceLayer)
+            this->pszWHERE = CPLStrdup(pszWHERE);
+        else
+            this->pszWHERE = NULL;
+    }
+    else
+        this->pszWHERE = NULL;
+
+/* -------------------------------------------------------------------- */
+/*      Prepare a feature definition based on the query.                */
+/* -------------------------------------------------------------------- */
+    OGRFeatureDefn *poSrcDefn = poSrcLayer->GetLayerDefn();
+
+    poDefn = new OGRFeatureDefn( psSelectInfo->table_defs[0].table_alias );
+    SetDescription( poDefn->GetName() );
+    poDefn->SetGeomType(wkbNone);
+    poDefn->Reference();
+
+    iFIDFieldIndex = poSrcDefn->GetFieldCount();
+
+    /* + 1 since we can add an implicit geometry field */
+    panGeomFieldToSrcGeomField = (int*) CPLMalloc(sizeof(int) * (1 + psSelectInfo->result_columns));
+
+    for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+    {
+        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+        OGRFieldDefn oFDefn( "", OFTInteger );
+        OGRGeomFieldDefn oGFDefn( "", wkbUnknown );
+        OGRFieldDefn *poSrcFDefn = NULL;
+        OGRGeomFieldDefn *poSrcGFDefn = NULL;
+        int bIsGeometry = FALSE;
+        OGRFeatureDefn *poLayerDefn = NULL;
+        int iSrcGeomField = -1;
+
+        if( psColDef->table_index != -1 )
+            poLayerDefn = 
+                papoTableLayers[psColDef->table_index]->GetLayerDefn();
+
+        if( psColDef->field_index > -1 
+            && poLayerDefn != NULL
+            && psColDef->field_index < poLayerDefn->GetFieldCount() )
+        {
+            poSrcFDefn = poLayerDefn->GetFieldDefn(psColDef->field_index);
+        }
+
+        if( poLayerDefn != NULL &&
+            IS_GEOM_FIELD_INDEX(poLayerDefn, psColDef->field_index) )
+        {
+            bIsGeometry = TRUE;
+            iSrcGeomField =
+                ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(poLayerDefn, psColDef->field_index);
+            poSrcGFDefn = poLayerDefn->GetGeomFieldDefn(iSrcGeomField);
+        }
+
+        if( psColDef->target_type == SWQ_GEOMETRY )
+            bIsGeometry = TRUE;
+
+        if( psColDef->col_func == SWQCF_COUNT )
+            bIsGeometry = FALSE;
+
+        if( strlen(psColDef->field_name) == 0 && !bIsGeometry )
+        {
+            CPLFree( psColDef->field_name );
+            psColDef->field_name = (char *) CPLMalloc(40);
+            sprintf( psColDef->field_name, "FIELD_%d", poDefn->GetFieldCount()+1 );
+        }
+
+        if( psColDef->field_alias != NULL )
+        {
+            if( bIsGeometry )
+                oGFDefn.SetName(psColDef->field_alias);
+            else
+                oFDefn.SetName(psColDef->field_alias);
+        }
+        else if( psColDef->col_func != SWQCF_NONE )
+        {
+            const swq_operation *op = swq_op_registrar::GetOperator( 
+                (swq_op) psColDef->col_func );
+
+            oFDefn.SetName( CPLSPrintf( "%s_%s",
+                                        op->pszName,
+                                        psColDef->field_name ) );
+        }
+        else
+        {
+            if( bIsGeometry )
+                oGFDefn.SetName(psColDef->field_name);
+            else
+                oFDefn.SetName( psColDef->field_name );
+        }
+
+        if( psColDef->col_func == SWQCF_COUNT )
+            oFDefn.SetType( OFTInteger );
+        else if( poSrcFDefn != NULL )
+        {
+            if( psColDef->col_func != SWQCF_AVG ||
+                psColDef->field_type == SWQ_DATE ||
+                psColDef->field_type == SWQ_TIME ||
+                psColDef->field_type == SWQ_TIMESTAMP )
+                oFDefn.SetType( poSrcFDefn->GetType() );
+            else
+                oFDefn.SetType( OFTReal );
+            if( psColDef->col_func != SWQCF_AVG &&
+                psColDef->col_func != SWQCF_SUM )
+            {
+                oFDefn.SetWidth( poSrcFDefn->GetWidth() );
+                oFDefn.SetPrecision( poSrcFDefn->GetPrecision() );
+            }
+        }
+        else if( poSrcGFDefn != NULL )
+        {
+            oGFDefn.SetType( poSrcGFDefn->GetType() );
+            oGFDefn.SetSpatialRef( poSrcGFDefn->GetSpatialRef() );
+        }
+        else if ( psColDef->field_index >= iFIDFieldIndex )
+        {
+            switch ( SpecialFieldTypes[psColDef->field_index-iFIDFieldIndex] )
+            {
+              case SWQ_INTEGER:
+                oFDefn.SetType( OFTInteger );
+                break;
+              case SWQ_FLOAT:
+                oFDefn.SetType( OFTReal );
+                break;
+              default:
+                oFDefn.SetType( OFTString );
+                break;
+            }
+        }
+        else
+        {
+            switch( psColDef->field_type )
+            {
+              case SWQ_INTEGER:
+              case SWQ_BOOLEAN:
+                oFDefn.SetType( OFTInteger );
+                break;
+                
+              case SWQ_FLOAT:
+                oFDefn.SetType( OFTReal );
+                break;
+
+              default:
+                oFDefn.SetType( OFTString );
+                break;
+            }
+        }
+
+        /* setting up the target_type */
+        switch (psColDef->target_type)
+        {
+          case SWQ_OTHER:
+            break;
+          case SWQ_INTEGER:
+          case SWQ_BOOLEAN:
+            oFDefn.SetType( OFTInteger );
+            break;
+          case SWQ_FLOAT:
+            oFDefn.SetType( OFTReal );
+            break;
+          case SWQ_STRING:
+            oFDefn.SetType( OFTString );
+            break;
+          case SWQ_TIMESTAMP:
+            oFDefn.SetType( OFTDateTime );
+            break;
+          case SWQ_DATE:
+            oFDefn.SetType( OFTDate );
+            break;
+          case SWQ_TIME:
+            oFDefn.SetType( OFTTime );
+            break;
+          case SWQ_GEOMETRY:
+            break;
+
+          default:
+            CPLAssert( FALSE );
+            oFDefn.SetType( OFTString );
+            break;
+        }
+
+        if (psColDef->field_length > 0)
+        {
+            oFDefn.SetWidth( psColDef->field_length );
+        }
+
+        if (psColDef->field_precision >= 0)
+        {
+            oFDefn.SetPrecision( psColDef->field_precision );
+        }
+
+        if( bIsGeometry )
+        {
+            panGeomFieldToSrcGeomField[poDefn->GetGeomFieldCount()] = iSrcGeomField;
+            /* Hack while drivers haven't been updated so that */
+            /* poSrcDefn->GetGeomFieldDefn(0)->GetSpatialRef() == poSrcLayer->GetSpatialRef() */
+            if( iSrcGeomField == 0 &&
+                poSrcDefn->GetGeomFieldCount() == 1 &&
+                oGFDefn.GetSpatialRef() == NULL )
+            {
+                oGFDefn.SetSpatialRef(poSrcLayer->GetSpatialRef());
+            }
+            int bForceGeomType = FALSE;
+            if( psColDef->eGeomType != wkbUnknown )
+            {
+                oGFDefn.SetType( psColDef->eGeomType );
+                bForceGeomType = TRUE;
+            }
+            if( psColDef->nSRID > 0 )
+            {
+                OGRSpatialReference* poSRS = new OGRSpatialReference();
+                if( poSRS->importFromEPSG( psColDef->nSRID ) == OGRERR_NONE )
+                {
+                    oGFDefn.SetSpatialRef( poSRS );
+                }
+                poSRS->Release();
+            }
+
+            OGRGenSQLGeomFieldDefn* poMyGeomFieldDefn =
+                new OGRGenSQLGeomFieldDefn(&oGFDefn);
+            poMyGeomFieldDefn->bForceGeomType = bForceGeomType;
+            poDefn->AddGeomFieldDefn( poMyGeomFieldDefn, FALSE );
+        }
+        else
+            poDefn->AddFieldDefn( &oFDefn );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Add implicit geometry field.                                    */
+/* -------------------------------------------------------------------- */
+    if( psSelectInfo->query_mode == SWQM_RECORDSET &&
+        poDefn->GetGeomFieldCount() == 0 &&
+        poSrcDefn->GetGeomFieldCount() == 1 )
+    {
+        psSelectInfo->result_columns++;
+
+        psSelectInfo->column_defs = (swq_col_def *) 
+            CPLRealloc( psSelectInfo->column_defs, sizeof(swq_col_def) * psSelectInfo->result_columns );
+
+        swq_col_def *col_def = psSelectInfo->column_defs + psSelectInfo->result_columns - 1;
+
+        memset( col_def, 0, sizeof(swq_col_def) );
+        const char* pszName = poSrcDefn->GetGeomFieldDefn(0)->GetNameRef();
+        if( *pszName != '\0' )
+            col_def->field_name = CPLStrdup( pszName );
+        else
+            col_def->field_name = CPLStrdup( OGR_GEOMETRY_DEFAULT_NON_EMPTY_NAME );
+        col_def->field_alias = NULL;
+        col_def->table_index = 0;
+        col_def->field_index = GEOM_FIELD_INDEX_TO_ALL_FIELD_INDEX(poSrcDefn, 0);
+        col_def->field_type = SWQ_GEOMETRY;
+        col_def->target_type = SWQ_GEOMETRY;
+
+        panGeomFieldToSrcGeomField[poDefn->GetGeomFieldCount()] = 0;
+
+        OGRGenSQLGeomFieldDefn* poMyGeomFieldDefn =
+            new OGRGenSQLGeomFieldDefn(poSrcDefn->GetGeomFieldDefn(0));
+        poDefn->AddGeomFieldDefn( poMyGeomFieldDefn, FALSE );
+
+        /* Hack while drivers haven't been updated so that */
+        /* poSrcDefn->GetGeomFieldDefn(0)->GetSpatialRef() == poSrcLayer->GetSpatialRef() */
+        if( poSrcDefn->GetGeomFieldDefn(0)->GetSpatialRef() == NULL )
+        {
+            poDefn->GetGeomFieldDefn(0)->SetSpatialRef(poSrcLayer->GetSpatialRef());
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Now that we have poSrcLayer, we can install a spatial filter    */
+/*      if there is one.                                                */
+/* -------------------------------------------------------------------- */
+    if( poSpatFilter != NULL )
+        SetSpatialFilter( 0, poSpatFilter );
+
+    ResetReading();
+
+    FindAndSetIgnoredFields();
+
+    if( !bForwardWhereToSourceLayer )
+        SetAttributeFilter( pszWHERE );
+}
+
+/************************************************************************/
+/*                       ~OGRGenSQLResultsLayer()                       */
+/************************************************************************/
+
+OGRGenSQLResultsLayer::~OGRGenSQLResultsLayer()
+
+{
+    if( m_nFeaturesRead > 0 && poDefn != NULL )
+    {
+        CPLDebug( "GenSQL", "%d features read on layer '%s'.",
+                  (int) m_nFeaturesRead, 
+                  poDefn->GetName() );
+    }
+
+    ClearFilters();
+
+/* -------------------------------------------------------------------- */
+/*      Free various datastructures.                                    */
+/* -------------------------------------------------------------------- */
+    CPLFree( papoTableLayers );
+    papoTableLayers = NULL;
+             
+    CPLFree( panFIDIndex );
+    CPLFree( panGeomFieldToSrcGeomField );
+
+    delete poSummaryFeature;
+    delete poGroupRows;
+
+    if( papoJoinHashes != NULL )
+    {
+        for( int iJoin = 0; iJoin < ((swq_select *) pSelectInfo)->join_count;
+             iJoin++ )
+            delete papoJoinHashes[iJoin];
+        CPLFree( papoJoinHashes );
+    }
+
+    delete (swq_select *) pSelectInfo;
+
+    if( poDefn != NULL )
+    {
+        poDefn->Release();
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Release any additional datasources being used in joins.         */
+/* -------------------------------------------------------------------- */
+    for( int iEDS = 0; iEDS < nExtraDSCount; iEDS++ )
+        GDALClose( (GDALDatasetH)papoExtraDS[iEDS] );
+
+    CPLFree( papoExtraDS );
+    CPLFree( pszWHERE );
+}
+
+/************************************************************************/
+/*                            ClearFilters()                            */
+/*                                                                      */
+/*      Clear up all filters currently in place on the target layer,    */
+/*      and joined layers.  We try not to leave them installed          */
+/*      except when actively fetching features.                         */
+/************************************************************************/
+
+void OGRGenSQLResultsLayer::ClearFilters()
+
+{
+/* -------------------------------------------------------------------- */
+/*      Clear any filters installed on the target layer.                */
+/* -------------------------------------------------------------------- */
+    if( poSrcLayer != NULL )
+    {
+        poSrcLayer->SetAttributeFilter( "" );
+        poSrcLayer->SetSpatialFilter( NULL );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Clear any attribute filter installed on the joined layers.      */
+/* -------------------------------------------------------------------- */
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    int iJoin;
+
+    if( psSelectInfo != NULL )
+    {
+        for( iJoin = 0; iJoin < psSelectInfo->join_count; iJoin++ )
+        {
+            swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+            OGRLayer *poJoinLayer = 
+                papoTableLayers[psJoinInfo->secondary_table];
+            
+            poJoinLayer->SetAttributeFilter( "" );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Clear any ignored field lists installed on source layers        */
+/* -------------------------------------------------------------------- */
+    if( psSelectInfo != NULL )
+    {
+        for( int iTable = 0; iTable < psSelectInfo->table_count; iTable++ )
+        {
+            OGRLayer* poLayer = papoTableLayers[iTable];
+            poLayer->SetIgnoredFields(NULL);
+        }
+    }
+}
+
+/************************************************************************/
+/*                    MustEvaluateSpatialFilterOnGenSQL()               */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::MustEvaluateSpatialFilterOnGenSQL()
+{
+    int bEvaluateSpatialFilter = FALSE;
+    if( m_poFilterGeom != NULL &&
+        m_iGeomFieldFilter >= 0 &&
+        m_iGeomFieldFilter < GetLayerDefn()->GetGeomFieldCount() )
+    {
+        int iSrcGeomField = panGeomFieldToSrcGeomField[m_iGeomFieldFilter];
+        if( iSrcGeomField < 0 )
+            bEvaluateSpatialFilter = TRUE;
+    }
+    return bEvaluateSpatialFilter;
+}
+
+/************************************************************************/
+/*                       ApplyFiltersToSource()                         */
+/************************************************************************/
+
+void OGRGenSQLResultsLayer::ApplyFiltersToSource()
+{
+    poSrcLayer->SetAttributeFilter( pszWHERE );
+    if( m_iGeomFieldFilter >= 0 &&
+        m_iGeomFieldFilter < GetLayerDefn()->GetGeomFieldCount() )
+    {
+        int iSrcGeomField = panGeomFieldToSrcGeomField[m_iGeomFieldFilter];
+        if( iSrcGeomField >= 0 )
+            poSrcLayer->SetSpatialFilter( iSrcGeomField, m_poFilterGeom );
+    }
+
+    poSrcLayer->ResetReading();
+}
+
+/************************************************************************/
+/*                            ResetReading()                            */
+/************************************************************************/
+
+void OGRGenSQLResultsLayer::ResetReading() 
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    if( psSelectInfo->query_mode == SWQM_RECORDSET )
+    {
+        ApplyFiltersToSource();
+    }
+
+    nNextIndexFID = 0;
+    nIteratedFeatures = 0;
+}
+
+/************************************************************************/
+/*                           SetNextByIndex()                           */
+/*                                                                      */
+/*      If we already have an FID list, we can easily resposition       */
+/*      ourselves in it.                                                */
+/************************************************************************/
+
+OGRErr OGRGenSQLResultsLayer::SetNextByIndex( long nIndex )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    CreateOrderByIndex();
+
+    nIteratedFeatures = nIndex;
+
+    if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD 
+        || psSelectInfo->query_mode == SWQM_DISTINCT_LIST 
+        || psSelectInfo->query_mode == SWQM_GROUP_BY 
+        || panFIDIndex != NULL )
+    {
+        nNextIndexFID = nIndex;
+        return OGRERR_NONE;
+    }
+    else
+    {
+        return poSrcLayer->SetNextByIndex( nIndex );
+    }
+}
+
+/************************************************************************/
+/*                             GetExtent()                              */
+/************************************************************************/
+
+OGRErr OGRGenSQLResultsLayer::GetExtent( int iGeomField,
+                                         OGREnvelope *psExtent, 
+                                         int bForce )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    if( iGeomField < 0 || iGeomField >= GetLayerDefn()->GetGeomFieldCount() ||
+        GetLayerDefn()->GetGeomFieldDefn(iGeomField)->GetType() == wkbNone )
+    {
+        if( iGeomField != 0 )
+        {
+            CPLError(CE_Failure, CPLE_AppDefined,
+                     "Invalid geometry field index : %d", iGeomField);
+        }
+        return OGRERR_FAILURE;
+    }
+
+    if( psSelectInfo->query_mode == SWQM_RECORDSET )
+    {
+        int iSrcGeomField = panGeomFieldToSrcGeomField[iGeomField];
+        if( iSrcGeomField >= 0 )
+            return poSrcLayer->GetExtent( iSrcGeomField, psExtent, bForce );
+        else if( iGeomField == 0 )
+            return OGRLayer::GetExtent( psExtent, bForce );
+        else
+            return OGRLayer::GetExtent( iGeomField, psExtent, bForce );
+    }
+    else
+        return OGRERR_FAILURE;
+}
+
+/************************************************************************/
+/*                          GetFeatureCount()                           */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::GetFeatureCount( int bForce )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    int nRet;
+
+    CreateOrderByIndex();
+
+    if( psSelectInfo->query_mode == SWQM_DISTINCT_LIST )
+    {
+        if( !PrepareSummary() )
+            return 0;
+
+        swq_summary *psSummary = psSelectInfo->column_summary + 0;
+
+        if( psSummary == NULL )
+            return 0;
+
+        nRet = psSummary->count;
+    }
+    else if( psSelectInfo->query_mode == SWQM_GROUP_BY )
+    {
+        if( m_poAttrQuery != NULL )
+            nRet = OGRLayer::GetFeatureCount( bForce );
+        else if( !PrepareGroupBy() )
+            return 0;
+        else
+            nRet = poGroupRows->GetCount();
+    }
+    else if( psSelectInfo->query_mode != SWQM_RECORDSET )
+        nRet = 1;
+    else if( m_poAttrQuery == NULL && !MustEvaluateSpatialFilterOnGenSQL() )
+        nRet = poSrcLayer->GetFeatureCount( bForce );
+    else
+        nRet = OGRLayer::GetFeatureCount( bForce );
+
+    if( psSelectInfo->limit >= 0 && nRet > psSelectInfo->limit )
+        nRet = (int) psSelectInfo->limit;
+
+    return nRet;
+}
+
+/************************************************************************/
+/*                           TestCapability()                           */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::TestCapability( const char *pszCap )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    if( EQUAL(pszCap,OLCFastSetNextByIndex) )
+    {
+        if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD 
+            || psSelectInfo->query_mode == SWQM_DISTINCT_LIST 
+            || psSelectInfo->query_mode == SWQM_GROUP_BY 
+            || panFIDIndex != NULL )
+            return TRUE;
+        else 
+            return poSrcLayer->TestCapability( pszCap );
+    }
+
+    if( psSelectInfo->query_mode == SWQM_RECORDSET
+        && (EQUAL(pszCap,OLCFastFeatureCount) 
+            || EQUAL(pszCap,OLCRandomRead) 
+            || EQUAL(pszCap,OLCFastGetExtent)) )
+        return poSrcLayer->TestCapability( pszCap );
+
+    else if( psSelectInfo->query_mode == SWQM_GROUP_BY )
+    {
+        if( EQUAL(pszCap,OLCFastFeatureCount) )
+            return m_poAttrQuery == NULL;
+        if( EQUAL(pszCap,OLCRandomRead) )
+            return TRUE;
+    }
+    else if( psSelectInfo->query_mode != SWQM_RECORDSET )
+    {
+        if( EQUAL(pszCap,OLCFastFeatureCount) )
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/************************************************************************/
+/*                        ContainGeomSpecialField()                     */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::ContainGeomSpecialField(swq_expr_node* expr)
+{
+    if (expr->eNodeType == SNT_COLUMN)
+    {
+        if( expr->table_index == 0 && expr->field_index != -1 )
+        {
+            OGRLayer* poLayer = papoTableLayers[expr->table_index];
+            int nSpecialFieldIdx = expr->field_index -
+                            poLayer->GetLayerDefn()->GetFieldCount();
+            if( nSpecialFieldIdx == SPF_OGR_GEOMETRY ||
+                nSpecialFieldIdx == SPF_OGR_GEOM_WKT ||
+                nSpecialFieldIdx == SPF_OGR_GEOM_AREA )
+                return TRUE;
+            if( expr->field_index ==
+                    GEOM_FIELD_INDEX_TO_ALL_FIELD_INDEX(poLayer->GetLayerDefn(), 0) )
+                return TRUE;
+            return FALSE;
+        }
+    }
+    else if (expr->eNodeType == SNT_OPERATION)
+    {
+        for( int i = 0; i < expr->nSubExprCount; i++ )
+        {
+            if (ContainGeomSpecialField(expr->papoSubExpr[i]))
+                return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/************************************************************************/
+/*                     OGRGenSQLGetSummaryValue()                       */
+/*                                                                      */
+/*      Value of a source feature to accumulate in the summary of an    */
+/*      aggregated column, or NULL.                                     */
+/************************************************************************/
+
+static const char *OGRGenSQLGetSummaryValue( OGRFeature *poSrcFeature,
+                                             swq_col_def *psColDef )
+
+{
+    if( psColDef->col_func == SWQCF_COUNT )
+    {
+        /* psColDef->field_index can be -1 in the case of a COUNT(*) */
+        if( psColDef->field_index < 0 )
+            return "";
+
+        OGRFeatureDefn *poSrcDefn = poSrcFeature->GetDefnRef();
+        if( IS_GEOM_FIELD_INDEX(poSrcDefn, psColDef->field_index) )
+        {
+            int iSrcGeomField = ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(
+                    poSrcDefn, psColDef->field_index);
+            if( poSrcFeature->GetGeomFieldRef(iSrcGeomField) != NULL )
+                return "";
+            return NULL;
+        }
+    }
+
+    if( poSrcFeature->IsFieldSet(psColDef->field_index) )
+        return poSrcFeature->GetFieldAsString( psColDef->field_index );
+
+    return NULL;
+}
+
+/************************************************************************/
+/*                         IsSourceGeomField()                          */
+/*                                                                      */
+/*      Whether a field index of the primary table is its first         */
+/*      geometry field or one of the special fields derived from it.    */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::IsSourceGeomField( int nFieldIndex )
+
+{
+    if( nFieldIndex == -1 )
+        return FALSE;
+
+    OGRFeatureDefn *poSrcDefn = poSrcLayer->GetLayerDefn();
+    int nSpecialFieldIdx = nFieldIndex - poSrcDefn->GetFieldCount();
+
+    return nSpecialFieldIdx == SPF_OGR_GEOMETRY ||
+           nSpecialFieldIdx == SPF_OGR_GEOM_WKT ||
+           nSpecialFieldIdx == SPF_OGR_GEOM_AREA ||
+           nFieldIndex == GEOM_FIELD_INDEX_TO_ALL_FIELD_INDEX(poSrcDefn, 0);
+}
+
+/************************************************************************/
+/*                         NeedSourceGeometry()                         */
+/*                                                                      */
+/*      Geometry reading can be ignored in summary and GROUP BY         */
+/*      queries if no spatial filter is in place and that the where     */
+/*      clause, the columns and the GROUP BY fields do not reference    */
+/*      the geometry or the OGR_GEOMETRY, OGR_GEOM_WKT or               */
+/*      OGR_GEOM_AREA special fields.                                   */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::NeedSourceGeometry()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    if( m_poFilterGeom != NULL )
+        return TRUE;
+
+    if( psSelectInfo->where_expr != NULL &&
+        ContainGeomSpecialField(psSelectInfo->where_expr) )
+        return TRUE;
+
+    for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+    {
+        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+        if (psColDef->table_index == 0 && 
+            IsSourceGeomField(psColDef->field_index))
+            return TRUE;
+        if (psColDef->expr != NULL && ContainGeomSpecialField(psColDef->expr))
+            return TRUE;
+    }
+
+    for( int iGroup = 0; iGroup < psSelectInfo->group_specs; iGroup++ )
+    {
+        if( IsSourceGeomField(psSelectInfo->group_defs[iGroup].field_index) )
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/************************************************************************/
+/*                           PrepareSummary()                           */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::PrepareSummary()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    if( poSummaryFeature != NULL )
+        return TRUE;
+
+    poSummaryFeature = new OGRFeature( poDefn );
+    poSummaryFeature->SetFID( 0 );
+
+/* -------------------------------------------------------------------- */
+/*      Ensure our query parameters are in place on the source          */
+/*      layer.  And initialize reading.                                 */
+/* -------------------------------------------------------------------- */
+    ApplyFiltersToSource();
+
+/* -------------------------------------------------------------------- */
+/*      Ignore geometry reading if we do not need it.                   */
+/* -------------------------------------------------------------------- */
+    int bSaveIsGeomIgnored = poSrcLayer->GetLayerDefn()->IsGeometryIgnored();
+    if( !NeedSourceGeometry() )
+        poSrcLayer->GetLayerDefn()->SetGeometryIgnored(TRUE);
+
+/* -------------------------------------------------------------------- */
+/*      We treat COUNT(*) as a special case, and fill with              */
+/*      GetFeatureCount().                                              */
+/* -------------------------------------------------------------------- */
+
+    if( psSelectInfo->result_columns == 1 
+        && psSelectInfo->column_defs[0].col_func == SWQCF_COUNT
+        && psSelectInfo->column_defs[0].field_index < 0 )
+    {
+        poSummaryFeature->SetField( 0, poSrcLayer->GetFeatureCount( TRUE ) );
+        poSrcLayer->GetLayerDefn()->SetGeometryIgnored(bSaveIsGeomIgnored);
+        return TRUE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Otherwise, process all source feature through the summary       */
+/*      building facilities of SWQ.                                     */
+/* -------------------------------------------------------------------- */
+    const char *pszError;
+    OGRFeature *poSrcFeature;
+    int iField;
+
+    while( (poSrcFeature = poSrcLayer->GetNextFeature()) != NULL )
+    {
+        for( iField = 0; iField < psSelectInfo->result_columns; iField++ )
+        {
+            swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+
+            pszError = swq_select_summarize( psSelectInfo, iField,
+                OGRGenSQLGetSummaryValue( poSrcFeature, psColDef ) );
+            
+            if( pszError != NULL )
+            {
+                delete poSrcFeature;
+                delete poSummaryFeature;
+                poSummaryFeature = NULL;
+
+                poSrcLayer->GetLayerDefn()->SetGeometryIgnored(bSaveIsGeomIgnored);
+
+                CPLError( CE_Failure, CPLE_AppDefined, "%s", pszError );
+                return FALSE;
+            }
+        }
+
+        delete poSrcFeature;
+    }
+
+    poSrcLayer->GetLayerDefn()->SetGeometryIgnored(bSaveIsGeomIgnored);
+
+    pszError = swq_select_finish_summarize( psSelectInfo );
+    if( pszError != NULL )
+    {
+        delete poSummaryFeature;
+        poSummaryFeature = NULL;
+        
+        CPLError( CE_Failure, CPLE_AppDefined, "%s", pszError );
+        return FALSE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      If we have run out of features on the source layer, clear       */
+/*      away the filters we have installed till a next run through      */
+/*      the features.                                                   */
+/* -------------------------------------------------------------------- */
+    if( poSrcFeature == NULL )
+        ClearFilters();
+
+/* -------------------------------------------------------------------- */
+/*      Now apply the values to the summary feature.  If we are in      */
+/*      DISTINCT_LIST mode we don't do this step.                       */
+/* -------------------------------------------------------------------- */
+    if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD )
+    {
+        for( iField = 0; iField < psSelectInfo->result_columns; iField++ )
+        {
+            swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+            if (psSelectInfo->column_summary != NULL)
+            {
+                swq_summary *psSummary = psSelectInfo->column_summary + iField;
+
+                if( psColDef->col_func == SWQCF_AVG )
+                {
+                    if( psColDef->field_type == SWQ_DATE ||
+                        psColDef->field_type == SWQ_TIME ||
+                        psColDef->field_type == SWQ_TIMESTAMP)
+                    {
+                        struct tm brokendowntime;
+                        CPLUnixTimeToYMDHMS((GIntBig)(psSummary->sum / psSummary->count), &brokendowntime);
+                        poSummaryFeature->SetField( iField,
+                                                    brokendowntime.tm_year + 1900,
+                                                    brokendowntime.tm_mon + 1,
+                                                    brokendowntime.tm_mday,
+                                                    brokendowntime.tm_hour,
+                                                    brokendowntime.tm_min,
+                                                    brokendowntime.tm_sec, 0);
+                    }
+                    else
+                        poSummaryFeature->SetField( iField,
+                                                    psSummary->sum / psSummary->count );
+                }
+                else if( psColDef->col_func == SWQCF_MIN )
+                {
+                    if( psColDef->field_type == SWQ_DATE ||
+                        psColDef->field_type == SWQ_TIME ||
+                        psColDef->field_type == SWQ_TIMESTAMP)
+                        poSummaryFeature->SetField( iField, psSummary->szMin );
+                    else
+                        poSummaryFeature->SetField( iField, psSummary->min );
+                }
+                else if( psColDef->col_func == SWQCF_MAX )
+                {
+                    if( psColDef->field_type == SWQ_DATE ||
+                        psColDef->field_type == SWQ_TIME ||
+                        psColDef->field_type == SWQ_TIMESTAMP)
+                        poSummaryFeature->SetField( iField, psSummary->szMax );
+                    else
+                        poSummaryFeature->SetField( iField, psSummary->max );
+                }
+                else if( psColDef->col_func == SWQCF_COUNT )
+                    poSummaryFeature->SetField( iField, psSummary->count );
+                else if( psColDef->col_func == SWQCF_SUM )
+                    poSummaryFeature->SetField( iField, psSummary->sum );
+            }
+            else if ( psColDef->col_func == SWQCF_COUNT )
+                poSummaryFeature->SetField( iField, 0 );
+        }
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                       OGRMultiFeatureFetcher()                       */
+/************************************************************************/
+
+static swq_expr_node *OGRMultiFeatureFetcher( swq_expr_node *op, 
+                                              void *pFeatureList )
+
+{
+    std::vector<OGRFeature*> *papoFeatures = 
+        (std::vector<OGRFeature*> *) pFeatureList;
+    OGRFeature *poFeature;
+    swq_expr_node *poRetNode = NULL;
+
+    CPLAssert( op->eNodeType == SNT_COLUMN );
+
+/* -------------------------------------------------------------------- */
+/*      What feature are we using?  The primary or one of the joined ones?*/
+/* -------------------------------------------------------------------- */
+    if( op->table_index < 0 || op->table_index >= (int)papoFeatures->size() )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Request for unexpected table_index (%d) in field fetcher.",
+                  op->table_index );
+        return NULL;
+    }
+    
+    poFeature = (*papoFeatures)[op->table_index];
+
+/* -------------------------------------------------------------------- */
+/*      Fetch the value.                                                */
+/* -------------------------------------------------------------------- */
+    switch( op->field_type )
+    {
+      case SWQ_INTEGER:
+      case SWQ_BOOLEAN:
+        if( poFeature == NULL 
+            || !poFeature->IsFieldSet(op->field_index) )
+        {
+            poRetNode = new swq_expr_node(0);
+            poRetNode->is_null = TRUE;
+        }
+        else
+            poRetNode = new swq_expr_node( 
+                poFeature->GetFieldAsInteger(op->field_index) );
+        break;
+
+      case SWQ_FLOAT:
+        if( poFeature == NULL 
+            || !poFeature->IsFieldSet(op->field_index) )
+        {
+            poRetNode = new swq_expr_node( 0.0 );
+            poRetNode->is_null = TRUE;
+        }
+        else
+            poRetNode = new swq_expr_node( 
+                poFeature->GetFieldAsDouble(op->field_index) );
+        break;
+        
+      case SWQ_GEOMETRY:
+        if( poFeature == NULL )
+        {
+            poRetNode = new swq_expr_node( (OGRGeometry*) NULL );
+        }
+        else
+        {
+            int iSrcGeomField = ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(
                 poFeature->GetDefnRef(), op->field_index);
             poRetNode = new swq_expr_node(
                 poFeature->GetGeomFieldRef(iSrcGeomField) );
         }
-        break;
+        break;
+
+      default:
+        if( poFeature == NULL 
+            || !poFeature->IsFieldSet(op->field_index) )
+        {
+            poRetNode = new swq_expr_node("");
+            poRetNode->is_null = TRUE;
+        }
+        else
+            poRetNode = new swq_expr_node( 
+                poFeature->GetFieldAsString(op->field_index) );
+        break;
+    }
+
+    return poRetNode;
+}
+
+/************************************************************************/
+/*                          BuildJoinHashes()                           */
+/*                                                                      */
+/*      Build the hash table of each joined layer whose key types       */
+/*      allow it.  Joins without a hash table are resolved by           */
+/*      installing an attribute filter on the joined layer for each     */
+/*      primary feature.                                                */
+/************************************************************************/
+
+void OGRGenSQLResultsLayer::BuildJoinHashes()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    bJoinHashesBuilt = TRUE;
+    if( psSelectInfo->join_count == 0 )
+        return;
+
+    papoJoinHashes = (OGRGenSQLJoinHash **)
+        CPLCalloc( sizeof(OGRGenSQLJoinHash*), psSelectInfo->join_count );
+
+    for( int iJoin = 0; iJoin < psSelectInfo->join_count; iJoin++ )
+    {
+        swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+        OGRLayer *poJoinLayer = papoTableLayers[psJoinInfo->secondary_table];
+
+        // Scanning the primary layer would disturb the current reading.
+        if( poJoinLayer == poSrcLayer )
+            continue;
+
+        OGRGenSQLJoinKeyType eKeyType = OGRGenSQLGetJoinKeyType(
+            poSrcLayer->GetLayerDefn()->
+                GetFieldDefn( psJoinInfo->primary_field )->GetType(),
+            poJoinLayer->GetLayerDefn()->
+                GetFieldDefn( psJoinInfo->secondary_field )->GetType() );
+        if( eKeyType == JK_NONE )
+            continue;
+
+        OGRGenSQLJoinHash *poHash = new OGRGenSQLJoinHash( poJoinLayer,
+                                                           eKeyType );
+        if( poHash->Build( psJoinInfo->secondary_field ) )
+            papoJoinHashes[iJoin] = poHash;
+        else
+            delete poHash;
+    }
+}
+
+/************************************************************************/
+/*                          FetchJoinFeature()                          */
+/*                                                                      */
+/*      Fetch the feature of the iJoin-th joined layer matching the     */
+/*      primary feature.  *pbOwned is set to FALSE if the returned      */
+/*      feature belongs to the join hash table.                         */
+/************************************************************************/
+
+OGRFeature *OGRGenSQLResultsLayer::FetchJoinFeature( int iJoin,
+                                                     OGRFeature *poSrcFeat,
+                                                     int *pbOwned )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    CPLString osFilter;
+
+    *pbOwned = TRUE;
+
+    if( !bJoinHashesBuilt )
+        BuildJoinHashes();
+
+    swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+
+    OGRLayer *poJoinLayer = papoTableLayers[psJoinInfo->secondary_table];
+    
+    // if source key is null, we can't do join.
+    if( !poSrcFeat->IsFieldSet( psJoinInfo->primary_field ) )
+        return NULL;
+    
+    OGRFieldDefn* poSecondaryFieldDefn =
+        poJoinLayer->GetLayerDefn()->GetFieldDefn( 
+                 psJoinInfo->secondary_field );
+    OGRFieldType ePrimaryFieldType = poSrcLayer->GetLayerDefn()->
+                GetFieldDefn(psJoinInfo->primary_field )->GetType();
+    OGRFieldType eSecondaryFieldType = poSecondaryFieldDefn->GetType();
+
+    OGRField *psSrcField = 
+        poSrcFeat->GetRawFieldRef(psJoinInfo->primary_field);
+
+/* -------------------------------------------------------------------- */
+/*      Probe the join hash table if we have one.                       */
+/* -------------------------------------------------------------------- */
+    if( papoJoinHashes != NULL && papoJoinHashes[iJoin] != NULL )
+    {
+        OGRGenSQLJoinHashEntry sKey;
+
+        if( !OGRGenSQLSetJoinHashKey( &sKey,
+                OGRGenSQLGetJoinKeyType( ePrimaryFieldType,
+                                         eSecondaryFieldType ),
+                ePrimaryFieldType, TRUE, psSrcField ) )
+            return NULL;
+
+        OGRFeature *poJoinFeature =
+            papoJoinHashes[iJoin]->Lookup( &sKey, pbOwned );
+        CPLFree( sKey.pszKey );
+
+        return poJoinFeature;
+    }
+
+    // Prepare attribute query to express fetching on the joined variable
+    
+    // If joining a (primary) numeric column with a (secondary) string column
+    // then add implicit casting of the secondary column to numeric. This behaviour
+    // worked in GDAL < 1.8, and it is consistant with how sqlite behaves too. See #4321
+    // For the reverse case, joining a string column with a numeric column, the
+    // string constant will be cast to float by SWQAutoConvertStringToNumeric (#4259)
+    if( eSecondaryFieldType == OFTString &&
+        (ePrimaryFieldType == OFTInteger || ePrimaryFieldType == OFTReal) )
+        osFilter.Printf("CAST(%s AS FLOAT) = ", poSecondaryFieldDefn->GetNameRef() );
+    else
+        osFilter.Printf("%s = ", poSecondaryFieldDefn->GetNameRef() );
+
+    switch( ePrimaryFieldType )
+    {
+      case OFTInteger:
+        osFilter += CPLString().Printf("%d", psSrcField->Integer );
+        break;
+
+      case OFTReal:
+        osFilter += CPLString().Printf("%.16g", psSrcField->Real );
+        break;
+
+      case OFTString:
+      {
+          char *pszEscaped = CPLEscapeString( psSrcField->String, 
+                                              strlen(psSrcField->String),
+                                              CPLES_SQL );
+          osFilter += "'";
+          osFilter += pszEscaped;
+          osFilter += "'";
+          CPLFree( pszEscaped );
+      }
+      break;
+
+      default:
+        CPLAssert( FALSE );
+        return NULL;
+    }
+
+    OGRFeature *poJoinFeature = NULL;
+
+    poJoinLayer->ResetReading();
+    if( poJoinLayer->SetAttributeFilter( osFilter.c_str() ) == OGRERR_NONE )
+        poJoinFeature = poJoinLayer->GetNextFeature();
+
+    return poJoinFeature;
+}
+
+/************************************************************************/
+/*                          TranslateFeature()                          */
+/************************************************************************/
+
+OGRFeature *OGRGenSQLResultsLayer::TranslateFeature( OGRFeature *poSrcFeat )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    OGRFeature *poDstFeat;
+    std::vector<OGRFeature*> apoFeatures;
+
+    if( poSrcFeat == NULL )
+        return NULL;
+
+    m_nFeaturesRead++;
+
+    apoFeatures.push_back( poSrcFeat );
+
+/* -------------------------------------------------------------------- */
+/*      Fetch the corresponding features from any jointed tables.       */
+/* -------------------------------------------------------------------- */
+    int iJoin;
+
+    std::vector<int> abOwnedJoinFeatures;
+
+    for( iJoin = 0; iJoin < psSelectInfo->join_count; iJoin++ )
+    {
+        /* OGRMultiFeatureFetcher assumes that the features are pushed in */
+        /* apoFeatures with increasing secondary_table, so make sure */
+        /* we have taken care of this */
+        CPLAssert(psSelectInfo->join_defs[iJoin].secondary_table == iJoin + 1);
+
+        int bOwned = TRUE;
+        apoFeatures.push_back( FetchJoinFeature( iJoin, poSrcFeat, &bOwned ) );
+        abOwnedJoinFeatures.push_back( bOwned );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Create destination feature.                                     */
+/* -------------------------------------------------------------------- */
+    poDstFeat = new OGRFeature( poDefn );
+
+    poDstFeat->SetFID( poSrcFeat->GetFID() );
+
+    poDstFeat->SetStyleString( poSrcFeat->GetStyleString() );
+
+/* -------------------------------------------------------------------- */
+/*      Evaluate fields that are complex expressions.                   */
+/* -------------------------------------------------------------------- */
+    int iRegularField = 0;
+    int iGeomField = 0;
+    for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+    {
+        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+        swq_expr_node *poResult;
+
+        if( psColDef->field_index != -1 )
+        {
+            if( psColDef->field_type == SWQ_GEOMETRY ||
+                psColDef->target_type == SWQ_GEOMETRY )
+                iGeomField++;
+            else
+                iRegularField++;
+            continue;
+        }
+
+        poResult = psColDef->expr->Evaluate( OGRMultiFeatureFetcher, 
+                                             (void *) &apoFeatures );
+        
+        if( poResult == NULL )
+        {
+            delete poDstFeat;
+            return NULL;
+        }
+
+        if( poResult->is_null )
+        {
+            if( poResult->field_type == SWQ_GEOMETRY )
+                iGeomField++;
+            else
+                iRegularField++;
+            delete poResult;
+            continue;
+        }
+
+        switch( poResult->field_type )
+        {
+          case SWQ_INTEGER:
+            poDstFeat->SetField( iRegularField++, poResult->int_value );
+            break;
+            
+          case SWQ_FLOAT:
+            poDstFeat->SetField( iRegularField++, poResult->float_value );
+            break;
+            
+          case SWQ_GEOMETRY:
+          {
+            OGRGenSQLGeomFieldDefn* poGeomFieldDefn =
+                (OGRGenSQLGeomFieldDefn*) poDstFeat->GetGeomFieldDefnRef(iGeomField);
+            if( poGeomFieldDefn->bForceGeomType &&
+                poResult->geometry_value != NULL )
+            {
+                OGRwkbGeometryType eCurType =
+                    wkbFlatten(poResult->geometry_value->getGeometryType());
+                OGRwkbGeometryType eReqType =
+                    wkbFlatten(poGeomFieldDefn->GetType());
+                if( eCurType == wkbPolygon && eReqType == wkbMultiPolygon )
+                {
+                    poResult->geometry_value = (OGRGeometry*)
+                        OGR_G_ForceToMultiPolygon( (OGRGeometryH) poResult->geometry_value );
+                }
+                else if( (eCurType == wkbMultiPolygon || eCurType == wkbGeometryCollection) &&
+                         eReqType == wkbPolygon )
+                {
+                    poResult->geometry_value = (OGRGeometry*)
+                        OGR_G_ForceToPolygon( (OGRGeometryH) poResult->geometry_value );
+                }
+                else if( eCurType == wkbLineString && eReqType == wkbMultiLineString )
+                {
+                    poResult->geometry_value = (OGRGeometry*)
+                        OGR_G_ForceToMultiLineString( (OGRGeometryH) poResult->geometry_value );
+                }
+                else if( (eCurType == wkbMultiLineString || eCurType == wkbGeometryCollection) &&
+                         eReqType == wkbLineString )
+                {
+                    poResult->geometry_value = (OGRGeometry*)
+                        OGR_G_ForceToLineString( (OGRGeometryH) poResult->geometry_value );
+                }
+            }
+            poDstFeat->SetGeomField( iGeomField++, poResult->geometry_value );
+            break;
+          }
+            
+          default:
+            poDstFeat->SetField( iRegularField++, poResult->string_value );
+            break;
+        }
+
+        delete poResult;
+    }
+    
+/* -------------------------------------------------------------------- */
+/*      Copy fields from primary record to the destination feature.     */
+/* -------------------------------------------------------------------- */
+    iRegularField = 0;
+    iGeomField = 0;
+    for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+    {
+        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+
+        if( psColDef->table_index != 0 )
+        {
+            if( psColDef->field_type == SWQ_GEOMETRY ||
+                psColDef->target_type == SWQ_GEOMETRY )
+                iGeomField++;
+            else
+                iRegularField++;
+            continue;
+        }
+
+        if( IS_GEOM_FIELD_INDEX(poSrcFeat->GetDefnRef(), psColDef->field_index) )
+        {
+            int iSrcGeomField = ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(
+                poSrcFeat->GetDefnRef(), psColDef->field_index);
+            poDstFeat->SetGeomField( iGeomField ++,
+                                     poSrcFeat->GetGeomFieldRef(iSrcGeomField) );
+        }
+        else if( psColDef->field_index >= iFIDFieldIndex &&
+                 psColDef->field_index < iFIDFieldIndex + SPECIAL_FIELD_COUNT )
+        {
+            switch (SpecialFieldTypes[psColDef->field_index - iFIDFieldIndex])
+            {
+              case SWQ_INTEGER:
+                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsInteger(psColDef->field_index) );
+                break;
+              case SWQ_FLOAT:
+                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsDouble(psColDef->field_index) );
+                break;
+              default:
+                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsString(psColDef->field_index) );
+            }
+            iRegularField ++;
+        }
+        else
+        {
+            switch (psColDef->target_type)
+            {
+              case SWQ_INTEGER:
+                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsInteger(psColDef->field_index) );
+                break;
+
+              case SWQ_FLOAT:
+                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsDouble(psColDef->field_index) );
+                break;
+              
+              case SWQ_STRING:
+              case SWQ_TIMESTAMP:
+              case SWQ_DATE:
+              case SWQ_TIME:
+                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsString(psColDef->field_index) );
+                break;
+                
+              case SWQ_GEOMETRY:
+                  CPLAssert(0);
+                  break;
+
+              default:
+                poDstFeat->SetField( iRegularField,
+                         poSrcFeat->GetRawFieldRef( psColDef->field_index ) );
+            }
+            iRegularField ++;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Copy values from any joined tables.                             */
+/* -------------------------------------------------------------------- */
+    for( iJoin = 0; iJoin < psSelectInfo->join_count; iJoin++ )
+    {
+        CPLString osFilter;
+
+        swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+        OGRFeature *poJoinFeature = apoFeatures[iJoin+1];
+
+        if( poJoinFeature == NULL )
+            continue;
+
+        // Copy over selected field values. 
+        iRegularField = 0;
+        for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+        {
+            swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+
+            if( psColDef->field_type == SWQ_GEOMETRY ||
+                psColDef->target_type == SWQ_GEOMETRY )
+                continue;
+
+            if( psColDef->table_index == psJoinInfo->secondary_table )
+                poDstFeat->SetField( iRegularField,
+                                     poJoinFeature->GetRawFieldRef( 
+                                         psColDef->field_index ) );
+
+            iRegularField ++;
+        }
+
+        if( abOwnedJoinFeatures[iJoin] )
+            delete poJoinFeature;
+    }
+
+    return poDstFeat;
+}
+
+/************************************************************************/
+/*                           GetNextFeature()                           */
+/************************************************************************/
+
+OGRFeature *OGRGenSQLResultsLayer::GetNextFeature()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    CreateOrderByIndex();
+
+    if( psSelectInfo->limit >= 0 && nIteratedFeatures >= psSelectInfo->limit )
+        return NULL;
+
+/* -------------------------------------------------------------------- */
+/*      Handle summary sets.                                            */
+/* -------------------------------------------------------------------- */
+    if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD 
+        || psSelectInfo->query_mode == SWQM_DISTINCT_LIST )
+    {
+        OGRFeature *poFeature = GetFeature( nNextIndexFID++ );
+        if( poFeature != NULL )
+            nIteratedFeatures++;
+        return poFeature;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Handle the rows of a GROUP BY query, to which an attribute      */
+/*      filter on the result columns may apply.                         */
+/* -------------------------------------------------------------------- */
+    if( psSelectInfo->query_mode == SWQM_GROUP_BY )
+    {
+        OGRFeature *poFeature;
+
+        while( (poFeature = GetGroupFeature( nNextIndexFID++ )) != NULL )
+        {
+            if( m_poAttrQuery == NULL || m_poAttrQuery->Evaluate( poFeature ) )
+            {
+                nIteratedFeatures++;
+                return poFeature;
+            }
+            delete poFeature;
+        }
+        return NULL;
+    }
+
+    int bEvaluateSpatialFilter = MustEvaluateSpatialFilterOnGenSQL();
+
+/* -------------------------------------------------------------------- */
+/*      Handle ordered sets.                                            */
+/* -------------------------------------------------------------------- */
+    while( TRUE )
+    {
+        OGRFeature *poFeature;
+
+        if( panFIDIndex != NULL )
+            poFeature =  GetFeature( nNextIndexFID++ );
+        else
+        {
+            OGRFeature *poSrcFeat = poSrcLayer->GetNextFeature();
+
+            if( poSrcFeat == NULL )
+                return NULL;
+            
+            poFeature = TranslateFeature( poSrcFeat );
+            delete poSrcFeat;
+        }
+
+        if( poFeature == NULL )
+            return NULL;
+
+        if( (m_poAttrQuery == NULL
+            || m_poAttrQuery->Evaluate( poFeature )) &&
+            (!bEvaluateSpatialFilter ||
+             FilterGeometry( poFeature->GetGeomFieldRef(m_iGeomFieldFilter) )) )
+        {
+            nIteratedFeatures++;
+            return poFeature;
+        }
+
+        delete poFeature;
+    }
+
+    return NULL;
+}
+
+/************************************************************************/
+/*                             GetFeature()                             */
+/************************************************************************/
+
+OGRFeature *OGRGenSQLResultsLayer::GetFeature( long nFID )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    CreateOrderByIndex();
+
+/* -------------------------------------------------------------------- */
+/*      Handle request for summary record.                              */
+/* -------------------------------------------------------------------- */
+    if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD )
+    {
+        if( !PrepareSummary() || nFID != 0 || poSummaryFeature == NULL )
+            return NULL;
+        else
+            return poSummaryFeature->Clone();
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Handle request for a GROUP BY record.                           */
+/* -------------------------------------------------------------------- */
+    if( psSelectInfo->query_mode == SWQM_GROUP_BY )
+        return GetGroupFeature( nFID );
+
+/* -------------------------------------------------------------------- */
+/*      Handle request for distinct list record.                        */
+/* -------------------------------------------------------------------- */
+    if( psSelectInfo->query_mode == SWQM_DISTINCT_LIST )
+    {
+        if( !PrepareSummary() )
+            return NULL;
+
+        swq_summary *psSummary = psSelectInfo->column_summary + 0;
+
+        if( psSummary == NULL )
+            return NULL;
+
+        if( nFID < 0 || nFID >= psSummary->count )
+            return NULL;
+
+        if( psSummary->distinct_list[nFID] != NULL )
+            poSummaryFeature->SetField( 0, psSummary->distinct_list[nFID] );
+        else
+            poSummaryFeature->UnsetField( 0 );
+        poSummaryFeature->SetFID( nFID );
+
+        return poSummaryFeature->Clone();
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Are we running in sorted mode?  If so, run the fid through      */
+/*      the index.                                                      */
+/* -------------------------------------------------------------------- */
+    if( panFIDIndex != NULL )
+    {
+        if( nFID < 0 || nFID >= nIndexSize )
+            return NULL;
+        else
+            nFID = panFIDIndex[nFID];
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Handle request for random record.                               */
+/* -------------------------------------------------------------------- */
+    OGRFeature *poSrcFeature = poSrcLayer->GetFeature( nFID );
+    OGRFeature *poResult;
+
+    if( poSrcFeature == NULL )
+        return NULL;
+
+    poResult = TranslateFeature( poSrcFeature );
+    poResult->SetFID( nFID );
+    
+    delete poSrcFeature;
+
+    return poResult;
+}
+
+/************************************************************************/
+/*                          GetSpatialFilter()                          */
+/************************************************************************/
+
+OGRGeometry *OGRGenSQLResultsLayer::GetSpatialFilter() 
+
+{
+    return NULL;
+}
+
+/************************************************************************/
+/*                            GetLayerDefn()                            */
+/************************************************************************/
+
+OGRFeatureDefn *OGRGenSQLResultsLayer::GetLayerDefn()
+
+{
+    return poDefn;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          OGRGenSQLSortRun                            */
+/*                                                                      */
+/*      Sequential reader of one of the sorted runs that                */
+/*      CreateOrderByIndex() spills to a temporary file when the sort   */
+/*      keys do not fit in memory.  A record is made of the sequence    */
+/*      number of the source feature, its FID and its sort keys.        */
+/*      String keys are written as their length (-1 if unset)           */
+/*      followed by their characters, other keys as a raw OGRField.     */
+/* ==================================================================== */
+/************************************************************************/
+
+#define SORT_RUN_BUFFER_SIZE    65536
+
+class OGRGenSQLSortRun
+{
+    VSILFILE    *fp;
+    vsi_l_offset nNextOffset;
+    vsi_l_offset nEndOffset;
+    int          nRemaining;
+    int          nOrderItems;
+    const int   *pabStringKey;
+
+    GByte       *pabyBuffer;
+    int          nBufferPos;
+    int          nBufferFill;
+
+    int          ReadBytes( void *pDest, int nBytes );
+    void         FreeStrings();
+
+  public:
+    long         nSeq;
+    long         nFID;
+    OGRField    *pasFields;
+
+                 OGRGenSQLSortRun( VSILFILE *fp,
+                                   vsi_l_offset nStartOffset,
+                                   vsi_l_offset nEndOffset,
+                                   int nRecords, int nOrderItems,
+                                   const int *pabStringKey );
+                ~OGRGenSQLSortRun();
+
+    int          IsExhausted() { return nRemaining == 0; }
+    int          Next();
+};
+
+/************************************************************************/
+/*                      OGRGenSQLFreeIndexFields()                      */
+/************************************************************************/
+
+static void OGRGenSQLFreeIndexFields( OGRField *pasIndexFields,
+                                      int nEntries, int nOrderItems,
+                                      const int *pabStringKey )
+
+{
+    for( int iKey = 0; iKey < nOrderItems; iKey++ )
+    {
+        if( !pabStringKey[iKey] )
+            continue;
+
+        for( int i = 0; i < nEntries; i++ )
+        {
+            OGRField *psField = pasIndexFields + iKey + i * nOrderItems;
+
+            if( psField->Set.nMarker1 != OGRUnsetMarker 
+                || psField->Set.nMarker2 != OGRUnsetMarker )
+                CPLFree( psField->String );
+        }
+    }
+}
+
+/************************************************************************/
+/*                          OGRGenSQLSortRun()                          */
+/************************************************************************/
+
+OGRGenSQLSortRun::OGRGenSQLSortRun( VSILFILE *fpIn,
+                                    vsi_l_offset nStartOffset,
+                                    vsi_l_offset nEndOffsetIn,
+                                    int nRecords, int nOrderItemsIn,
+                                    const int *pabStringKeyIn )
+
+{
+    fp = fpIn;
+    nNextOffset = nStartOffset;
+    nEndOffset = nEndOffsetIn;
+    nRemaining = nRecords;
+    nOrderItems = nOrderItemsIn;
+    pabStringKey = pabStringKeyIn;
+
+    pabyBuffer = (GByte *) CPLMalloc( SORT_RUN_BUFFER_SIZE );
+    nBufferPos = 0;
+    nBufferFill = 0;
+
+    nSeq = -1;
+    nFID = OGRNullFID;
+    pasFields = (OGRField *) CPLCalloc( sizeof(OGRField), nOrderItems );
+    FreeStrings();
+}
+
+/************************************************************************/
+/*                         ~OGRGenSQLSortRun()                          */
+/************************************************************************/
+
+OGRGenSQLSortRun::~OGRGenSQLSortRun()
+
+{
+    FreeStrings();
+    CPLFree( pasFields );
+    CPLFree( pabyBuffer );
+}
+
+/************************************************************************/
+/*                            FreeStrings()                             */
+/************************************************************************/
+
+void OGRGenSQLSortRun::FreeStrings()
 
-      default:
-        if( poFeature == NULL 
-            || !poFeature->IsFieldSet(op->field_index) )
+{
+    OGRGenSQLFreeIndexFields( pasFields, 1, nOrderItems, pabStringKey );
+
+    for( int iKey = 0; iKey < nOrderItems; iKey++ )
+    {
+        if( pabStringKey[iKey] )
         {
-            poRetNode = new swq_expr_node("");
-            poRetNode->is_null = TRUE;
+            pasFields[iKey].Set.nMarker1 = OGRUnsetMarker;
+            pasFields[iKey].Set.nMarker2 = OGRUnsetMarker;
         }
-        else
-            poRetNode = new swq_expr_node( 
-                poFeature->GetFieldAsString(op->field_index) );
-        break;
     }
-
-    return poRetNode;
 }
 
 /************************************************************************/
-/*                          TranslateFeature()                          */
+/*                             ReadBytes()                              */
 /************************************************************************/
 
-OGRFeature *OGRGenSQLResultsLayer::TranslateFeature( OGRFeature *poSrcFeat )
+int OGRGenSQLSortRun::ReadBytes( void *pDest, int nBytes )
 
 {
-    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
-    OGRFeature *poDstFeat;
-    std::vector<OGRFeature*> apoFeatures;
+    GByte *pabyDest = (GByte *) pDest;
 
-    if( poSrcFeat == NULL )
-        return NULL;
+    while( nBytes > 0 )
+    {
+        if( nBufferPos == nBufferFill )
+        {
+            vsi_l_offset nToRead = nEndOffset - nNextOffset;
 
-    m_nFeaturesRead++;
+            if( nToRead > SORT_RUN_BUFFER_SIZE )
+                nToRead = SORT_RUN_BUFFER_SIZE;
 
-    apoFeatures.push_back( poSrcFeat );
+            if( nToRead == 0
+                || VSIFSeekL( fp, nNextOffset, SEEK_SET ) != 0
+                || VSIFReadL( pabyBuffer, 1, (size_t) nToRead, fp )
+                   != (size_t) nToRead )
+            {
+                CPLError( CE_Failure, CPLE_FileIO,
+                          "Failed to read ORDER BY sort run from "
+                          "temporary file." );
+                return FALSE;
+            }
 
-/* -------------------------------------------------------------------- */
-/*      Fetch the corresponding features from any jointed tables.       */
-/* -------------------------------------------------------------------- */
-    int iJoin;
+            nNextOffset += nToRead;
+            nBufferPos = 0;
+            nBufferFill = (int) nToRead;
+        }
 
-    for( iJoin = 0; iJoin < psSelectInfo->join_count; iJoin++ )
-    {
-        CPLString osFilter;
+        int nCopy = MIN( nBytes, nBufferFill - nBufferPos );
 
-        swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
+        memcpy( pabyDest, pabyBuffer + nBufferPos, nCopy );
+        pabyDest += nCopy;
+        nBufferPos += nCopy;
+        nBytes -= nCopy;
+    }
 
-        /* OGRMultiFeatureFetcher assumes that the features are pushed in */
-        /* apoFeatures with increasing secondary_table, so make sure */
-        /* we have taken care of this */
-        CPLAssert(psJoinInfo->secondary_table == iJoin + 1);
+    return TRUE;
+}
 
-        OGRLayer *poJoinLayer = papoTableLayers[psJoinInfo->secondary_table];
-        
-        // if source key is null, we can't do join.
-        if( !poSrcFeat->IsFieldSet( psJoinInfo->primary_field ) )
+/************************************************************************/
+/*                                Next()                                */
+/*                                                                      */
+/*      Load the next record of the run.  Callers must check            */
+/*      IsExhausted() first; FALSE is only returned on read errors.     */
+/************************************************************************/
+
+int OGRGenSQLSortRun::Next()
+
+{
+    FreeStrings();
+
+    if( nRemaining == 0 )
+        return FALSE;
+    nRemaining--;
+
+    if( !ReadBytes( &nSeq, sizeof(long) ) 
+        || !ReadBytes( &nFID, sizeof(long) ) )
+        return FALSE;
+
+    for( int iKey = 0; iKey < nOrderItems; iKey++ )
+    {
+        OGRField *psField = pasFields + iKey;
+
+        if( !pabStringKey[iKey] )
         {
-            apoFeatures.push_back( NULL );
+            if( !ReadBytes( psField, sizeof(OGRField) ) )
+                return FALSE;
             continue;
         }
-        
-        OGRFieldDefn* poSecondaryFieldDefn =
-            poJoinLayer->GetLayerDefn()->GetFieldDefn( 
-                     psJoinInfo->secondary_field );
-        OGRFieldType ePrimaryFieldType = poSrcLayer->GetLayerDefn()->
-                    GetFieldDefn(psJoinInfo->primary_field )->GetType();
-        OGRFieldType eSecondaryFieldType = poSecondaryFieldDefn->GetType();
-
-        // Prepare attribute query to express fetching on the joined variable
-        
-        // If joining a (primary) numeric column with a (secondary) string column
-        // then add implicit casting of the secondary column to numeric. This behaviour
-        // worked in GDAL < 1.8, and it is consistant with how sqlite behaves too. See #4321
-        // For the reverse case, joining a string column with a numeric column, the
-        // string constant will be cast to float by SWQAutoConvertStringToNumeric (#4259)
-        if( eSecondaryFieldType == OFTString &&
-            (ePrimaryFieldType == OFTInteger || ePrimaryFieldType == OFTReal) )
-            osFilter.Printf("CAST(%s AS FLOAT) = ", poSecondaryFieldDefn->GetNameRef() );
-        else
-            osFilter.Printf("%s = ", poSecondaryFieldDefn->GetNameRef() );
 
-        OGRField *psSrcField = 
-            poSrcFeat->GetRawFieldRef(psJoinInfo->primary_field);
+        int nLength;
 
-        switch( ePrimaryFieldType )
+        if( !ReadBytes( &nLength, sizeof(int) ) )
+            return FALSE;
+
+        if( nLength >= 0 )
         {
-          case OFTInteger:
-            osFilter += CPLString().Printf("%d", psSrcField->Integer );
-            break;
+            psField->String = (char *) CPLMalloc( nLength + 1 );
+            psField->String[nLength] = '\0';
+            if( !ReadBytes( psField->String, nLength ) )
+                return FALSE;
+        }
+    }
 
-          case OFTReal:
-            osFilter += CPLString().Printf("%.16g", psSrcField->Real );
-            break;
+    return TRUE;
+}
 
-          case OFTString:
-          {
-              char *pszEscaped = CPLEscapeString( psSrcField->String, 
-                                                  strlen(psSrcField->String),
-                                                  CPLES_SQL );
-              osFilter += "'";
-              osFilter += pszEscaped;
-              osFilter += "'";
-              CPLFree( pszEscaped );
-          }
-          break;
+/************************************************************************/
+/*                           PrepareGroupBy()                           */
+/*                                                                      */
+/*      Aggregate the source features of a GROUP BY query in a hash     */
+/*      table of the groups.  The table and the result rows use at      */
+/*      most OGR_GENSQL_GROUP_BY_MAX_MEMORY megabytes (default 256)     */
+/*      each; past that, rows of new groups are partitioned to          */
+/*      temporary files that are aggregated in later passes, and the    */
+/*      result rows are written to a temporary file.                    */
+/************************************************************************/
 
-          default:
-            CPLAssert( FALSE );
-            continue;
-        }
+int OGRGenSQLResultsLayer::PrepareGroupBy()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
 
-        OGRFeature *poJoinFeature = NULL;
+    if( poGroupRows != NULL )
+        return TRUE;
 
-        poJoinLayer->ResetReading();
-        if( poJoinLayer->SetAttributeFilter( osFilter.c_str() ) == OGRERR_NONE )
-            poJoinFeature = poJoinLayer->GetNextFeature();
+    GIntBig nMaxMemory = (GIntBig)
+        (CPLAtof(CPLGetConfigOption( "OGR_GENSQL_GROUP_BY_MAX_MEMORY", "256" ))
+         * 1024 * 1024);
 
-        apoFeatures.push_back( poJoinFeature );
-    }
+    poGroupRows = new OGRGenSQLGroupRows( nMaxMemory );
 
 /* -------------------------------------------------------------------- */
-/*      Create destination feature.                                     */
+/*      Ensure our query parameters are in place on the source          */
+/*      layer.  And initialize reading.                                 */
 /* -------------------------------------------------------------------- */
-    poDstFeat = new OGRFeature( poDefn );
-
-    poDstFeat->SetFID( poSrcFeat->GetFID() );
+    ApplyFiltersToSource();
 
-    poDstFeat->SetStyleString( poSrcFeat->GetStyleString() );
+    int bSaveIsGeomIgnored = poSrcLayer->GetLayerDefn()->IsGeometryIgnored();
+    if( !NeedSourceGeometry() )
+        poSrcLayer->GetLayerDefn()->SetGeometryIgnored(TRUE);
 
 /* -------------------------------------------------------------------- */
-/*      Evaluate fields that are complex expressions.                   */
+/*      Process all source features in a first pass.                    */
 /* -------------------------------------------------------------------- */
-    int iRegularField = 0;
-    int iGeomField = 0;
-    for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+    std::vector<OGRGenSQLGroupPartition> aoPending;
+    std::vector<GByte> abyKey;
+    OGRGenSQLGroupTable *poTable = 
+        new OGRGenSQLGroupTable( psSelectInfo, 0, nMaxMemory );
+    OGRFeature *poSrcFeature = NULL;
+    int iField, bOK = TRUE;
+
+    while( bOK && (poSrcFeature = poSrcLayer->GetNextFeature()) != NULL )
     {
-        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
-        swq_expr_node *poResult;
+        OGRGenSQLReadGroupKey( psSelectInfo, poSrcFeature, iFIDFieldIndex,
+                               abyKey );
 
-        if( psColDef->field_index != -1 )
-        {
-            if( psColDef->field_type == SWQ_GEOMETRY ||
-                psColDef->target_type == SWQ_GEOMETRY )
-                iGeomField++;
-            else
-                iRegularField++;
-            continue;
-        }
+        VSILFILE *fpSpill = NULL;
+        OGRGenSQLGroupEntry *psGroup = poTable->FindGroup( abyKey, &fpSpill );
+        if( psGroup == NULL && fpSpill == NULL )
+            bOK = FALSE;
 
-        poResult = psColDef->expr->Evaluate( OGRMultiFeatureFetcher, 
-                                             (void *) &apoFeatures );
-        
-        if( poResult == NULL )
+        for( iField = 0; bOK && iField < psSelectInfo->result_columns;
+             iField++ )
         {
-            delete poDstFeat;
-            return NULL;
-        }
+            swq_col_def *psColDef = psSelectInfo->column_defs + iField;
 
-        if( poResult->is_null )
-        {
-            if( poResult->field_type == SWQ_GEOMETRY )
-                iGeomField++;
-            else
-                iRegularField++;
-            delete poResult;
-            continue;
-        }
+            if( psColDef->col_func == SWQCF_NONE )
+                continue;
 
-        switch( poResult->field_type )
-        {
-          case SWQ_INTEGER:
-            poDstFeat->SetField( iRegularField++, poResult->int_value );
-            break;
-            
-          case SWQ_FLOAT:
-            poDstFeat->SetField( iRegularField++, poResult->float_value );
-            break;
-            
-          case SWQ_GEOMETRY:
-          {
-            OGRGenSQLGeomFieldDefn* poGeomFieldDefn =
-                (OGRGenSQLGeomFieldDefn*) poDstFeat->GetGeomFieldDefnRef(iGeomField);
-            if( poGeomFieldDefn->bForceGeomType &&
-                poResult->geometry_value != NULL )
+            const char *pszValue =
+                OGRGenSQLGetSummaryValue( poSrcFeature, psColDef );
+
+            if( psGroup != NULL )
             {
-                OGRwkbGeometryType eCurType =
-                    wkbFlatten(poResult->geometry_value->getGeometryType());
-                OGRwkbGeometryType eReqType =
-                    wkbFlatten(poGeomFieldDefn->GetType());
-                if( eCurType == wkbPolygon && eReqType == wkbMultiPolygon )
-                {
-                    poResult->geometry_value = (OGRGeometry*)
-                        OGR_G_ForceToMultiPolygon( (OGRGeometryH) poResult->geometry_value );
-                }
-                else if( (eCurType == wkbMultiPolygon || eCurType == wkbGeometryCollection) &&
-                         eReqType == wkbPolygon )
-                {
-                    poResult->geometry_value = (OGRGeometry*)
-                        OGR_G_ForceToPolygon( (OGRGeometryH) poResult->geometry_value );
-                }
-                else if( eCurType == wkbLineString && eReqType == wkbMultiLineString )
-                {
-                    poResult->geometry_value = (OGRGeometry*)
-                        OGR_G_ForceToMultiLineString( (OGRGeometryH) poResult->geometry_value );
-                }
-                else if( (eCurType == wkbMultiLineString || eCurType == wkbGeometryCollection) &&
-                         eReqType == wkbLineString )
+                const char *pszError =
+                    poTable->AddValue( psGroup, iField, pszValue );
+                if( pszError != NULL )
                 {
-                    poResult->geometry_value = (OGRGeometry*)
-                        OGR_G_ForceToLineString( (OGRGeometryH) poResult->geometry_value );
+                    CPLError( CE_Failure, CPLE_AppDefined, "%s", pszError );
+                    bOK = FALSE;
                 }
             }
-            poDstFeat->SetGeomField( iGeomField++, poResult->geometry_value );
-            break;
-          }
-            
-          default:
-            poDstFeat->SetField( iRegularField++, poResult->string_value );
-            break;
+            else
+                bOK = OGRGenSQLWriteSpillValue( fpSpill, pszValue );
         }
 
-        delete poResult;
+        delete poSrcFeature;
     }
-    
+
+    poSrcLayer->GetLayerDefn()->SetGeometryIgnored(bSaveIsGeomIgnored);
+
+    ClearFilters();
+
+    bOK = bOK && poTable->Flush( poGroupRows, aoPending );
+    delete poTable;
+
 /* -------------------------------------------------------------------- */
-/*      Copy fields from primary record to the destination feature.     */
+/*      Then aggregate the partitions, which may in turn be             */
+/*      partitioned further.                                            */
 /* -------------------------------------------------------------------- */
-    iRegularField = 0;
-    iGeomField = 0;
-    for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+    while( !aoPending.empty() )
     {
-        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+        OGRGenSQLGroupPartition oPartition = aoPending.back();
+        aoPending.pop_back();
 
-        if( psColDef->table_index != 0 )
+        if( bOK )
         {
-            if( psColDef->field_type == SWQ_GEOMETRY ||
-                psColDef->target_type == SWQ_GEOMETRY )
-                iGeomField++;
-            else
-                iRegularField++;
-            continue;
+            CPLDebug( "GenSQL", "Aggregating GROUP BY partition of level %d.",
+                      oPartition.nLevel );
+
+            poTable = new OGRGenSQLGroupTable( psSelectInfo,
+                                               oPartition.nLevel,
+                                               nMaxMemory );
+            bOK = poTable->AddPartition( oPartition.osFilename )
+                && poTable->Flush( poGroupRows, aoPending );
+            delete poTable;
         }
 
-        if( IS_GEOM_FIELD_INDEX(poSrcFeat->GetDefnRef(), psColDef->field_index) )
-        {
-            int iSrcGeomField = ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(
-                poSrcFeat->GetDefnRef(), psColDef->field_index);
-            poDstFeat->SetGeomField( iGeomField ++,
-                                     poSrcFeat->GetGeomFieldRef(iSrcGeomField) );
-        }
-        else if( psColDef->field_index >= iFIDFieldIndex &&
-                 psColDef->field_index < iFIDFieldIndex + SPECIAL_FIELD_COUNT )
-        {
-            switch (SpecialFieldTypes[psColDef->field_index - iFIDFieldIndex])
-            {
-              case SWQ_INTEGER:
-                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsInteger(psColDef->field_index) );
-                break;
-              case SWQ_FLOAT:
-                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsDouble(psColDef->field_index) );
-                break;
-              default:
-                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsString(psColDef->field_index) );
-            }
-            iRegularField ++;
-        }
-        else
-        {
-            switch (psColDef->target_type)
-            {
-              case SWQ_INTEGER:
-                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsInteger(psColDef->field_index) );
-                break;
+        VSIUnlink( oPartition.osFilename );
+    }
+
+    if( !bOK )
+    {
+        delete poGroupRows;
+        poGroupRows = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                       CreateGroupOrderIndex()                        */
+/*                                                                      */
+/*      Sort the result rows of a GROUP BY query on the ORDER BY        */
+/*      fields, which are GROUP BY fields, into panFIDIndex.            */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::CreateGroupOrderIndex()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    int      i, iKey, nOrderItems = psSelectInfo->order_specs;
+    int      nRows = poGroupRows->GetCount();
+
+    CPLFree( panFIDIndex );
+    panFIDIndex = NULL;
+    nIndexSize = 0;
+
+    if( nRows == 0 )
+        return TRUE;
+
+    OGRField *pasIndexFields = (OGRField *) 
+        VSICalloc( sizeof(OGRField) * nOrderItems, nRows );
+    panFIDIndex = (long *) VSIMalloc2( sizeof(long), nRows );
+    if( pasIndexFields == NULL || panFIDIndex == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Cannot allocate ORDER BY index of %d groups.", nRows );
+        CPLFree( pasIndexFields );
+        CPLFree( panFIDIndex );
+        panFIDIndex = NULL;
+        return FALSE;
+    }
 
-              case SWQ_FLOAT:
-                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsDouble(psColDef->field_index) );
-                break;
-              
-              case SWQ_STRING:
-              case SWQ_TIMESTAMP:
-              case SWQ_DATE:
-              case SWQ_TIME:
-                poDstFeat->SetField( iRegularField, poSrcFeat->GetFieldAsString(psColDef->field_index) );
-                break;
-                
-              case SWQ_GEOMETRY:
-                  CPLAssert(0);
-                  break;
+    int *pabStringKey = (int *) CPLMalloc( sizeof(int) * nOrderItems );
+    int *panKeyIndex = (int *) CPLMalloc( sizeof(int) * nOrderItems );
+    OGRField *pasKey = (OGRField *) 
+        CPLMalloc( sizeof(OGRField) * psSelectInfo->group_specs );
+    int *panTags = (int *) CPLMalloc( sizeof(int) * psSelectInfo->group_specs );
 
-              default:
-                poDstFeat->SetField( iRegularField,
-                         poSrcFeat->GetRawFieldRef( psColDef->field_index ) );
-            }
-            iRegularField ++;
-        }
+    for( iKey = 0; iKey < nOrderItems; iKey++ )
+    {
+        pabStringKey[iKey] = OrderKeyIsString( iKey );
+        panKeyIndex[iKey] = OGRGenSQLGetGroupKeyIndex( psSelectInfo,
+            psSelectInfo->order_defs[iKey].field_index );
     }
 
 /* -------------------------------------------------------------------- */
-/*      Copy values from any joined tables.                             */
+/*      Decode the ORDER BY fields of each row.                         */
 /* -------------------------------------------------------------------- */
-    for( iJoin = 0; iJoin < psSelectInfo->join_count; iJoin++ )
+    int bOK = TRUE;
+
+    for( i = 0; bOK && i < nRows; i++ )
     {
-        CPLString osFilter;
+        const GByte *pabyIter = poGroupRows->Get( i );
+        int iGroup;
 
-        swq_join_def *psJoinInfo = psSelectInfo->join_defs + iJoin;
-        OGRFeature *poJoinFeature = apoFeatures[iJoin+1];
+        if( pabyIter == NULL )
+        {
+            bOK = FALSE;
+            break;
+        }
 
-        if( poJoinFeature == NULL )
-            continue;
+        for( iGroup = 0; iGroup < psSelectInfo->group_specs; iGroup++ )
+            pabyIter = OGRGenSQLDecodeGroupValue( pabyIter, panTags + iGroup,
+                                                  pasKey + iGroup );
 
-        // Copy over selected field values. 
-        iRegularField = 0;
-        for( int iField = 0; iField < psSelectInfo->result_columns; iField++ )
+        for( iKey = 0; iKey < nOrderItems; iKey++ )
         {
-            swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+            OGRField *psDstField = pasIndexFields + i * nOrderItems + iKey;
 
-            if( psColDef->field_type == SWQ_GEOMETRY ||
-                psColDef->target_type == SWQ_GEOMETRY )
-                continue;
+            *psDstField = pasKey[panKeyIndex[iKey]];
+            if( panTags[panKeyIndex[iKey]] == GROUP_VALUE_STRING )
+                psDstField->String = CPLStrdup( psDstField->String );
+        }
 
-            if( psColDef->table_index == psJoinInfo->secondary_table )
-                poDstFeat->SetField( iRegularField,
-                                     poJoinFeature->GetRawFieldRef( 
-                                         psColDef->field_index ) );
+        panFIDIndex[i] = i;
+    }
 
-            iRegularField ++;
+    /* Leave the unused entries unset so that they can be freed. */
+    for( ; i < nRows; i++ )
+    {
+        for( iKey = 0; iKey < nOrderItems; iKey++ )
+        {
+            pasIndexFields[i * nOrderItems + iKey].Set.nMarker1 = OGRUnsetMarker;
+            pasIndexFields[i * nOrderItems + iKey].Set.nMarker2 = OGRUnsetMarker;
         }
+    }
 
-        delete poJoinFeature;
+    if( bOK )
+    {
+        nIndexSize = nRows;
+        SortIndexSection( pasIndexFields, 0, nRows );
+    }
+    else
+    {
+        CPLFree( panFIDIndex );
+        panFIDIndex = NULL;
     }
 
-    return poDstFeat;
+    OGRGenSQLFreeIndexFields( pasIndexFields, nRows, nOrderItems,
+                              pabStringKey );
+    CPLFree( pasIndexFields );
+    CPLFree( pabStringKey );
+    CPLFree( panKeyIndex );
+    CPLFree( pasKey );
+    CPLFree( panTags );
+
+    return bOK;
 }
 
 /************************************************************************/
-/*                           GetNextFeature()                           */
+/*                          GetGroupFeature()                           */
 /************************************************************************/
 
-OGRFeature *OGRGenSQLResultsLayer::GetNextFeature()
+OGRFeature *OGRGenSQLResultsLayer::GetGroupFeature( long nFID )
 
 {
     swq_select *psSelectInfo = (swq_select *) pSelectInfo;
 
-    CreateOrderByIndex();
+    if( !PrepareGroupBy() )
+        return NULL;
 
-/* -------------------------------------------------------------------- */
-/*      Handle summary sets.                                            */
-/* -------------------------------------------------------------------- */
-    if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD 
-        || psSelectInfo->query_mode == SWQM_DISTINCT_LIST )
-        return GetFeature( nNextIndexFID++ );
+    if( nFID < 0 || nFID >= poGroupRows->GetCount() )
+        return NULL;
 
-    int bEvaluateSpatialFilter = MustEvaluateSpatialFilterOnGenSQL();
+    long iRow = nFID;
+
+    if( psSelectInfo->order_specs > 0 )
+    {
+        if( panFIDIndex == NULL && !CreateGroupOrderIndex() )
+            return NULL;
+        iRow = panFIDIndex[nFID];
+    }
+
+    const GByte *pabyIter = poGroupRows->Get( (int) iRow );
+    if( pabyIter == NULL )
+        return NULL;
 
 /* -------------------------------------------------------------------- */
-/*      Handle ordered sets.                                            */
+/*      Decode the group key, then set each column from it or from      */
+/*      the next aggregated value.                                      */
 /* -------------------------------------------------------------------- */
-    while( TRUE )
+    std::vector<OGRField> asKey( psSelectInfo->group_specs );
+    std::vector<int> anTags( psSelectInfo->group_specs );
+    int iField;
+
+    for( iField = 0; iField < psSelectInfo->group_specs; iField++ )
+        pabyIter = OGRGenSQLDecodeGroupValue( pabyIter, &anTags[iField],
+                                              &asKey[iField] );
+
+    OGRFeature *poFeature = new OGRFeature( poDefn );
+
+    for( iField = 0; iField < psSelectInfo->result_columns; iField++ )
     {
-        OGRFeature *poFeature;
+        swq_col_def *psColDef = psSelectInfo->column_defs + iField;
+        OGRField sField;
+        int nTag;
 
-        if( panFIDIndex != NULL )
-            poFeature =  GetFeature( nNextIndexFID++ );
+        if( psColDef->col_func == SWQCF_NONE )
+        {
+            int iGroup = OGRGenSQLGetGroupKeyIndex( psSelectInfo,
+                                                    psColDef->field_index );
+            nTag = anTags[iGroup];
+            sField = asKey[iGroup];
+        }
         else
+            pabyIter = OGRGenSQLDecodeGroupValue( pabyIter, &nTag, &sField );
+
+        switch( nTag )
         {
-            OGRFeature *poSrcFeat = poSrcLayer->GetNextFeature();
+          case GROUP_VALUE_INTEGER:
+            poFeature->SetField( iField, sField.Integer );
+            break;
 
-            if( poSrcFeat == NULL )
-                return NULL;
-            
-            poFeature = TranslateFeature( poSrcFeat );
-            delete poSrcFeat;
-        }
+          case GROUP_VALUE_REAL:
+            poFeature->SetField( iField, sField.Real );
+            break;
 
-        if( poFeature == NULL )
-            return NULL;
+          case GROUP_VALUE_STRING:
+            poFeature->SetField( iField, sField.String );
+            break;
 
-        if( (m_poAttrQuery == NULL
-            || m_poAttrQuery->Evaluate( poFeature )) &&
-            (!bEvaluateSpatialFilter ||
-             FilterGeometry( poFeature->GetGeomFieldRef(m_iGeomFieldFilter) )) )
-            return poFeature;
+          case GROUP_VALUE_DATE:
+            poFeature->SetField( iField, &sField );
+            break;
 
-        delete poFeature;
+          default:
+            break;
+        }
     }
 
-    return NULL;
+    poFeature->SetFID( nFID );
+
+    return poFeature;
 }
 
 /************************************************************************/
-/*                             GetFeature()                             */
+/*                         CreateOrderByIndex()                         */
+/*                                                                      */
+/*      This method is responsible for creating an index providing      */
+/*      ordered access to the features according to the supplied        */
+/*      ORDER BY clauses.                                               */
+/*                                                                      */
+/*      This is accomplished by making one pass through all the         */
+/*      eligible source features, and capturing the order by fields     */
+/*      of the records.  When a LIMIT applies to the sorted records,    */
+/*      only the best ones are retained in a heap.  Otherwise the       */
+/*      keys are sorted in memory as long as they fit in                */
+/*      OGR_GENSQL_SORT_MAX_MEMORY megabytes (default 256), and past    */
+/*      that sorted runs are spilled to a temporary file and merged.    */
 /************************************************************************/
 
-OGRFeature *OGRGenSQLResultsLayer::GetFeature( long nFID )
+void OGRGenSQLResultsLayer::CreateOrderByIndex()
 
 {
     swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    int      i, nOrderItems = psSelectInfo->order_specs;
 
-    CreateOrderByIndex();
+    if( ! (psSelectInfo->order_specs > 0
+           && psSelectInfo->query_mode == SWQM_RECORDSET
+           && nOrderItems != 0 ) )
+        return;
+
+    if( bOrderByValid )
+        return;
+
+    bOrderByValid = TRUE;
+
+    ResetReading();
+
+    panFIDIndex = NULL;
+    nIndexSize = 0;
 
 /* -------------------------------------------------------------------- */
-/*      Handle request for summary record.                              */
+/*      The LIMIT can only be applied while sorting if no filter is     */
+/*      evaluated on our side afterwards.                               */
 /* -------------------------------------------------------------------- */
-    if( psSelectInfo->query_mode == SWQM_SUMMARY_RECORD )
+    GIntBig nMaxMemory = (GIntBig)
+        (CPLAtof(CPLGetConfigOption( "OGR_GENSQL_SORT_MAX_MEMORY", "256" ))
+         * 1024 * 1024);
+    long nLimit = -1;
+
+    if( psSelectInfo->limit >= 0 && m_poAttrQuery == NULL
+        && !MustEvaluateSpatialFilterOnGenSQL() )
+        nLimit = psSelectInfo->limit;
+
+    int *pabStringKey = (int *) CPLMalloc( sizeof(int) * nOrderItems );
+    for( i = 0; i < nOrderItems; i++ )
+        pabStringKey[i] = OrderKeyIsString( i );
+
+    int bAlreadySorted = TRUE;
+    int bOK;
+
+    if( nLimit >= 0 && nLimit <= nMaxMemory / GetIndexTupleSize() )
+        bOK = CreateTopNIndex( (int) nLimit, pabStringKey, &bAlreadySorted );
+    else
+        bOK = CreateSortedIndex( nMaxMemory, nLimit, pabStringKey,
+                                 &bAlreadySorted );
+
+    CPLFree( pabStringKey );
+
+    //CPLDebug("GenSQL", "CreateOrderByIndex() = %d features", nIndexSize);
+
+    /* If it is already sorted, then free than panFIDIndex array */
+    /* so that GetNextFeature() can call a sequential GetNextFeature() */
+    /* on the source array. Very usefull for layers where random access */
+    /* is slow. */
+    /* Use case: the GML result of a WFS GetFeature with a SORTBY */
+    if (!bOK || bAlreadySorted)
     {
-        if( !PrepareSummary() || nFID != 0 || poSummaryFeature == NULL )
-            return NULL;
-        else
-            return poSummaryFeature->Clone();
+        CPLFree( panFIDIndex );
+        panFIDIndex = NULL;
+
+        nIndexSize = 0;
     }
 
-/* -------------------------------------------------------------------- */
-/*      Handle request for distinct list record.                        */
-/* -------------------------------------------------------------------- */
-    if( psSelectInfo->query_mode == SWQM_DISTINCT_LIST )
+    ResetReading();
+}
+
+/************************************************************************/
+/*                         GetIndexTupleSize()                          */
+/*                                                                      */
+/*      Approximate memory used by the index per feature, not           */
+/*      counting the strings.                                           */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::GetIndexTupleSize()
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+
+    return (int) (sizeof(OGRField) * psSelectInfo->order_specs
+                  + 3 * sizeof(long));
+}
+
+/************************************************************************/
+/*                          OrderKeyIsString()                          */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::OrderKeyIsString( int iKey )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
+
+    if ( psKeyDef->field_index >= iFIDFieldIndex )
     {
-        if( !PrepareSummary() )
-            return NULL;
+        return psKeyDef->field_index < iFIDFieldIndex + SPECIAL_FIELD_COUNT
+            && SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex]
+               == SWQ_STRING;
+    }
 
-        swq_summary *psSummary = psSelectInfo->column_summary + 0;
+    return poSrcLayer->GetLayerDefn()->GetFieldDefn( 
+        psKeyDef->field_index )->GetType() == OFTString;
+}
 
-        if( psSummary == NULL )
-            return NULL;
+/************************************************************************/
+/*                          ReadIndexFields()                           */
+/*                                                                      */
+/*      Capture the order by fields of a source feature.  Returns the   */
+/*      number of bytes allocated for string keys.                      */
+/************************************************************************/
 
-        if( nFID < 0 || nFID >= psSummary->count )
-            return NULL;
+int OGRGenSQLResultsLayer::ReadIndexFields( OGRFeature *poSrcFeat,
+                                            OGRField *pasIndexFields )
 
-        if( psSummary->distinct_list[nFID] != NULL )
-            poSummaryFeature->SetField( 0, psSummary->distinct_list[nFID] );
-        else
-            poSummaryFeature->UnsetField( 0 );
-        poSummaryFeature->SetFID( nFID );
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    int      iKey, nOrderItems = psSelectInfo->order_specs;
+    int      nStringBytes = 0;
+
+    for( iKey = 0; iKey < nOrderItems; iKey++ )
+    {
+        swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
+        OGRFieldDefn *poFDefn;
+        OGRField *psSrcField, *psDstField;
+
+        psDstField = pasIndexFields + iKey;
+
+        if ( psKeyDef->field_index >= iFIDFieldIndex)
+        {
+            if ( psKeyDef->field_index < iFIDFieldIndex + SPECIAL_FIELD_COUNT )
+            {
+                switch (SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex])
+                {
+                  case SWQ_INTEGER:
+                    psDstField->Integer = poSrcFeat->GetFieldAsInteger(psKeyDef->field_index);
+                    break;
+
+                  case SWQ_FLOAT:
+                    psDstField->Real = poSrcFeat->GetFieldAsDouble(psKeyDef->field_index);
+                    break;
+
+                  default:
+                    psDstField->String = CPLStrdup( poSrcFeat->GetFieldAsString(psKeyDef->field_index) );
+                    nStringBytes += (int)strlen(psDstField->String) + 1;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        poFDefn = poSrcLayer->GetLayerDefn()->GetFieldDefn( 
+            psKeyDef->field_index );
+
+        psSrcField = poSrcFeat->GetRawFieldRef( psKeyDef->field_index );
+
+        if( poFDefn->GetType() == OFTInteger 
+            || poFDefn->GetType() == OFTReal
+            || poFDefn->GetType() == OFTDate
+            || poFDefn->GetType() == OFTTime
+            || poFDefn->GetType() == OFTDateTime)
+            memcpy( psDstField, psSrcField, sizeof(OGRField) );
+        else if( poFDefn->GetType() == OFTString )
+        {
+            if( poSrcFeat->IsFieldSet( psKeyDef->field_index ) )
+            {
+                psDstField->String = CPLStrdup( psSrcField->String );
+                nStringBytes += (int)strlen(psDstField->String) + 1;
+            }
+            else
+                memcpy( psDstField, psSrcField, sizeof(OGRField) );
+        }
+    }
+
+    return nStringBytes;
+}
+
+/************************************************************************/
+/*                          CreateTopNIndex()                           */
+/*                                                                      */
+/*      Build the index of the nLimit first features in sort order,     */
+/*      keeping them in a heap whose root is the last of them so        */
+/*      that each new feature only needs to be compared with it.        */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::CreateTopNIndex( int nLimit,
+                                            const int *pabStringKey,
+                                            int *pbAlreadySorted )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    int      i, nOrderItems = psSelectInfo->order_specs;
+
+    if( nLimit == 0 )
+        return TRUE;
+
+    OGRField *pasIndexFields = (OGRField *) 
+        VSICalloc( sizeof(OGRField) * nOrderItems, nLimit );
+    OGRField **papasTuples = (OGRField **) 
+        VSIMalloc2( sizeof(OGRField *), nLimit );
+    long *panFIDList = (long *) VSIMalloc2( sizeof(long), nLimit );
+    long *panSeqList = (long *) VSIMalloc2( sizeof(long), nLimit );
+    int *panHeap = (int *) VSIMalloc2( sizeof(int), nLimit );
 
-        return poSummaryFeature->Clone();
+    if( pasIndexFields == NULL || papasTuples == NULL || panFIDList == NULL
+        || panSeqList == NULL || panHeap == NULL )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Cannot allocate ORDER BY index of %d features.", nLimit );
+        CPLFree( pasIndexFields );
+        CPLFree( papasTuples );
+        CPLFree( panFIDList );
+        CPLFree( panSeqList );
+        CPLFree( panHeap );
+        return FALSE;
     }
 
+    for( i = 0; i < nLimit; i++ )
+        papasTuples[i] = pasIndexFields + i * nOrderItems;
+
 /* -------------------------------------------------------------------- */
-/*      Are we running in sorted mode?  If so, run the fid through      */
-/*      the index.                                                      */
+/*      Read the features, replacing the last retained one whenever     */
+/*      a feature sorts before it.                                      */
 /* -------------------------------------------------------------------- */
-    if( panFIDIndex != NULL )
+    OGRField *pasCandidate = (OGRField *) 
+        CPLCalloc( sizeof(OGRField), nOrderItems );
+    OGRFeature *poSrcFeat;
+    long nSeq = 0;
+
+    while( (poSrcFeat = poSrcLayer->GetNextFeature()) != NULL )
     {
-        if( nFID < 0 || nFID >= nIndexSize )
-            return NULL;
+        if( nIndexSize < nLimit )
+        {
+            ReadIndexFields( poSrcFeat, papasTuples[nIndexSize] );
+            panFIDList[nIndexSize] = poSrcFeat->GetFID();
+            panSeqList[nIndexSize] = nSeq;
+            panHeap[nIndexSize] = nIndexSize;
+            nIndexSize++;
+
+            if( nIndexSize == nLimit )
+            {
+                for( i = nIndexSize / 2 - 1; i >= 0; i-- )
+                    SiftDownHeap( panHeap, nIndexSize, i,
+                                  papasTuples, panSeqList, -1 );
+            }
+        }
         else
-            nFID = panFIDIndex[nFID];
-    }
+        {
+            int iLast = panHeap[0];
 
-/* -------------------------------------------------------------------- */
-/*      Handle request for random record.                               */
-/* -------------------------------------------------------------------- */
-    OGRFeature *poSrcFeature = poSrcLayer->GetFeature( nFID );
-    OGRFeature *poResult;
+            ReadIndexFields( poSrcFeat, pasCandidate );
 
-    if( poSrcFeature == NULL )
-        return NULL;
+            if( CompareWithSeq( pasCandidate, nSeq,
+                                papasTuples[iLast], panSeqList[iLast] ) > 0 )
+            {
+                OGRGenSQLFreeIndexFields( papasTuples[iLast], 1, nOrderItems,
+                                          pabStringKey );
+                memcpy( papasTuples[iLast], pasCandidate,
+                        sizeof(OGRField) * nOrderItems );
+                panFIDList[iLast] = poSrcFeat->GetFID();
+                panSeqList[iLast] = nSeq;
+
+                SiftDownHeap( panHeap, nIndexSize, 0,
+                              papasTuples, panSeqList, -1 );
+            }
+            else
+                OGRGenSQLFreeIndexFields( pasCandidate, 1, nOrderItems,
+                                          pabStringKey );
+        }
 
-    poResult = TranslateFeature( poSrcFeature );
-    poResult->SetFID( nFID );
-    
-    delete poSrcFeature;
+        delete poSrcFeat;
+        nSeq++;
+    }
 
-    return poResult;
-}
+    CPLFree( pasCandidate );
 
-/************************************************************************/
-/*                          GetSpatialFilter()                          */
-/************************************************************************/
+    if( nIndexSize < nLimit )
+    {
+        for( i = nIndexSize / 2 - 1; i >= 0; i-- )
+            SiftDownHeap( panHeap, nIndexSize, i,
+                          papasTuples, panSeqList, -1 );
+    }
 
-OGRGeometry *OGRGenSQLResultsLayer::GetSpatialFilter() 
+/* -------------------------------------------------------------------- */
+/*      Pop the heap from its end to get the features in order.         */
+/* -------------------------------------------------------------------- */
+    for( i = nIndexSize - 1; i > 0; i-- )
+    {
+        int iTmp = panHeap[0];
+        panHeap[0] = panHeap[i];
+        panHeap[i] = iTmp;
 
-{
-    return NULL;
-}
+        SiftDownHeap( panHeap, i, 0, papasTuples, panSeqList, -1 );
+    }
 
-/************************************************************************/
-/*                            GetLayerDefn()                            */
-/************************************************************************/
+    panFIDIndex = (long *) CPLMalloc(sizeof(long) * nIndexSize);
+    for( i = 0; i < nIndexSize; i++ )
+    {
+        if( panSeqList[panHeap[i]] != i )
+            *pbAlreadySorted = FALSE;
+        panFIDIndex[i] = panFIDList[panHeap[i]];
+    }
 
-OGRFeatureDefn *OGRGenSQLResultsLayer::GetLayerDefn()
+    OGRGenSQLFreeIndexFields( pasIndexFields, nIndexSize, nOrderItems,
+                              pabStringKey );
+    CPLFree( pasIndexFields );
+    CPLFree( papasTuples );
+    CPLFree( panFIDList );
+    CPLFree( panSeqList );
+    CPLFree( panHeap );
 
-{
-    return poDefn;
+    return TRUE;
 }
 
 /************************************************************************/
-/*                         CreateOrderByIndex()                         */
-/*                                                                      */
-/*      This method is responsible for creating an index providing      */
-/*      ordered access to the features according to the supplied        */
-/*      ORDER BY clauses.                                               */
-/*                                                                      */
-/*      This is accomplished by making one pass through all the         */
-/*      eligible source features, and capturing the order by fields     */
-/*      of all records in memory.  A quick sort is then applied to      */
-/*      this in memory copy of the order-by fields to create the        */
-/*      required index.                                                 */
+/*                         CreateSortedIndex()                          */
 /*                                                                      */
-/*      Keeping all the key values in memory will *not* scale up to     */
-/*      very large input datasets.                                      */
+/*      Build the index of all the features (or of the nLimit first     */
+/*      ones if nLimit >= 0).  The keys are accumulated in memory       */
+/*      until they use more than nMaxMemory bytes, at which point       */
+/*      they are sorted and written to a temporary file as a run.       */
+/*      If any run was written, the runs are finally merged.            */
 /************************************************************************/
 
-void OGRGenSQLResultsLayer::CreateOrderByIndex()
+int OGRGenSQLResultsLayer::CreateSortedIndex( GIntBig nMaxMemory,
+                                              long nLimit,
+                                              const int *pabStringKey,
+                                              int *pbAlreadySorted )
 
 {
     swq_select *psSelectInfo = (swq_select *) pSelectInfo;
-    OGRField *pasIndexFields;
     int      i, nOrderItems = psSelectInfo->order_specs;
-    long     *panFIDList;
-
-    if( ! (psSelectInfo->order_specs > 0
-           && psSelectInfo->query_mode == SWQM_RECORDSET
-           && nOrderItems != 0 ) )
-        return;
-
-    if( bOrderByValid )
-        return;
-
-    bOrderByValid = TRUE;
-
-    ResetReading();
+    int      nTupleSize = GetIndexTupleSize();
 
 /* -------------------------------------------------------------------- */
 /*      Allocate set of key values, and the output index.               */
 /* -------------------------------------------------------------------- */
     int nFeaturesAlloc = 100;
-
-    panFIDIndex = NULL;
-    pasIndexFields = (OGRField *) 
+    OGRField *pasIndexFields = (OGRField *) 
         CPLCalloc(sizeof(OGRField), nOrderItems * nFeaturesAlloc);
-    panFIDList = (long *) CPLMalloc(sizeof(long) * nFeaturesAlloc);
+    long *panFIDList = (long *) CPLMalloc(sizeof(long) * nFeaturesAlloc);
+
+    CPLString osTmpFilename;
+    VSILFILE *fpRuns = NULL;
+    std::vector<vsi_l_offset> anRunOffsets;
+    std::vector<int> anRunCounts;
+    int nRunSize = 0, nFeatureCount = 0;
+    GIntBig nRunMemory = 0;
+    int bOK = TRUE;
 
 /* -------------------------------------------------------------------- */
 /*      Read in all the key values.                                     */
 /* -------------------------------------------------------------------- */
     OGRFeature *poSrcFeat;
-    nIndexSize = 0;
 
     while( (poSrcFeat = poSrcLayer->GetNextFeature()) != NULL )
     {
-        int iKey;
-
-        if (nIndexSize == nFeaturesAlloc)
+        if (nRunSize == nFeaturesAlloc)
         {
             int nNewFeaturesAlloc = (nFeaturesAlloc * 4) / 3;
             OGRField* pasNewIndexFields = (OGRField *)
                 VSIRealloc(pasIndexFields,
                            sizeof(OGRField) * nOrderItems * nNewFeaturesAlloc);
-            if (pasNewIndexFields == NULL)
+            long* panNewFIDList = NULL;
+            if (pasNewIndexFields != NULL)
             {
-                VSIFree(pasIndexFields);
-                VSIFree(panFIDList);
-                nIndexSize = 0;
-                return;
+                pasIndexFields = pasNewIndexFields;
+                panNewFIDList = (long *)
+                    VSIRealloc(panFIDList, sizeof(long) *  nNewFeaturesAlloc);
             }
-            pasIndexFields = pasNewIndexFields;
-
-            long* panNewFIDList = (long *)
-                VSIRealloc(panFIDList, sizeof(long) *  nNewFeaturesAlloc);
             if (panNewFIDList == NULL)
             {
-                VSIFree(pasIndexFields);
-                VSIFree(panFIDList);
-                nIndexSize = 0;
-                return;
+                CPLError( CE_Failure, CPLE_OutOfMemory,
+                          "Cannot allocate ORDER BY index of %d features.",
+                          nNewFeaturesAlloc );
+                delete poSrcFeat;
+                bOK = FALSE;
+                break;
             }
             panFIDList = panNewFIDList;
 
-            memset(pasIndexFields + nFeaturesAlloc, 0,
+            memset(pasIndexFields + nFeaturesAlloc * nOrderItems, 0,
                    sizeof(OGRField) * nOrderItems * (nNewFeaturesAlloc - nFeaturesAlloc));
 
             nFeaturesAlloc = nNewFeaturesAlloc;
         }
 
-        for( iKey = 0; iKey < nOrderItems; iKey++ )
-        {
-            swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
-            OGRFieldDefn *poFDefn;
-            OGRField *psSrcField, *psDstField;
-
-            psDstField = pasIndexFields + nIndexSize * nOrderItems + iKey;
-
-            if ( psKeyDef->field_index >= iFIDFieldIndex)
-            {
-                if ( psKeyDef->field_index < iFIDFieldIndex + SPECIAL_FIELD_COUNT )
-                {
-                    switch (SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex])
-                    {
-                      case SWQ_INTEGER:
-                        psDstField->Integer = poSrcFeat->GetFieldAsInteger(psKeyDef->field_index);
-                        break;
-
-                      case SWQ_FLOAT:
-                        psDstField->Real = poSrcFeat->GetFieldAsDouble(psKeyDef->field_index);
-                        break;
+        nRunMemory += nTupleSize 
+            + ReadIndexFields( poSrcFeat,
+                               pasIndexFields + nRunSize * nOrderItems );
+        panFIDList[nRunSize] = poSrcFeat->GetFID();
+        delete poSrcFeat;
 
-                      default:
-                        psDstField->String = CPLStrdup( poSrcFeat->GetFieldAsString(psKeyDef->field_index) );
-                        break;
-                    }
-                }
-                continue;
-            }
-            
-            poFDefn = poSrcLayer->GetLayerDefn()->GetFieldDefn( 
-                psKeyDef->field_index );
+        nRunSize++;
+        nFeatureCount++;
 
-            psSrcField = poSrcFeat->GetRawFieldRef( psKeyDef->field_index );
+        if( nRunMemory <= nMaxMemory )
+            continue;
 
-            if( poFDefn->GetType() == OFTInteger 
-                || poFDefn->GetType() == OFTReal
-                || poFDefn->GetType() == OFTDate
-                || poFDefn->GetType() == OFTTime
-                || poFDefn->GetType() == OFTDateTime)
-                memcpy( psDstField, psSrcField, sizeof(OGRField) );
-            else if( poFDefn->GetType() == OFTString )
+/* -------------------------------------------------------------------- */
+/*      Spill the keys read so far as a sorted run.                     */
+/* -------------------------------------------------------------------- */
+        if( fpRuns == NULL )
+        {
+            osTmpFilename = CPLGenerateTempFilename( "ogrgensql_sort" );
+            fpRuns = VSIFOpenL( osTmpFilename, "wb+" );
+            if( fpRuns == NULL )
             {
-                if( poSrcFeat->IsFieldSet( psKeyDef->field_index ) )
-                    psDstField->String = CPLStrdup( psSrcField->String );
-                else
-                    memcpy( psDstField, psSrcField, sizeof(OGRField) );
+                CPLError( CE_Failure, CPLE_OpenFailed,
+                          "Cannot create temporary file %s for ORDER BY.",
+                          osTmpFilename.c_str() );
+                bOK = FALSE;
+                break;
             }
+
+            CPLDebug( "GenSQL",
+                      "ORDER BY keys exceed OGR_GENSQL_SORT_MAX_MEMORY, "
+                      "spilling sorted runs to %s.",
+                      osTmpFilename.c_str() );
+            anRunOffsets.push_back( 0 );
         }
 
-        panFIDList[nIndexSize] = poSrcFeat->GetFID();
-        delete poSrcFeat;
+        bOK = SpillSortRun( fpRuns, pasIndexFields, panFIDList, nRunSize,
+                            nFeatureCount - nRunSize, pabStringKey );
+        if( !bOK )
+        {
+            nRunSize = 0;
+            break;
+        }
 
-        nIndexSize++;
+        anRunCounts.push_back( nRunSize );
+        anRunOffsets.push_back( VSIFTellL( fpRuns ) );
+        nRunSize = 0;
+        nRunMemory = 0;
     }
 
-    //CPLDebug("GenSQL", "CreateOrderByIndex() = %d features", nIndexSize);
-
 /* -------------------------------------------------------------------- */
-/*      Initialize panFIDIndex                                          */
+/*      If everything fitted in memory, sort the keys in place.         */
 /* -------------------------------------------------------------------- */
-    panFIDIndex = (long *) CPLMalloc(sizeof(long) * nIndexSize);
-    for( i = 0; i < nIndexSize; i++ )
-        panFIDIndex[i] = i;
+    if( bOK && fpRuns == NULL )
+    {
+        panFIDIndex = (long *) CPLMalloc(sizeof(long) * nRunSize);
+        for( i = 0; i < nRunSize; i++ )
+            panFIDIndex[i] = i;
+
+        SortIndexSection( pasIndexFields, 0, nRunSize );
+
+        nIndexSize = nRunSize;
+        if( nLimit >= 0 && nLimit < nIndexSize )
+            nIndexSize = (int) nLimit;
 
 /* -------------------------------------------------------------------- */
-/*      Quick sort the records.                                         */
+/*      Rework the FID map to map to real FIDs.                         */
 /* -------------------------------------------------------------------- */
-    SortIndexSection( pasIndexFields, 0, nIndexSize );
+        for( i = 0; i < nIndexSize; i++ )
+        {
+            if (panFIDIndex[i] != i)
+                *pbAlreadySorted = FALSE;
+            panFIDIndex[i] = panFIDList[panFIDIndex[i]];
+        }
+    }
 
 /* -------------------------------------------------------------------- */
-/*      Rework the FID map to map to real FIDs.                         */
+/*      Otherwise spill the last run and merge them all.                */
 /* -------------------------------------------------------------------- */
-    int bAlreadySorted = TRUE;
-    for( i = 0; i < nIndexSize; i++ )
+    else if( bOK )
     {
-        if (panFIDIndex[i] != i)
-            bAlreadySorted = FALSE;
-        panFIDIndex[i] = panFIDList[panFIDIndex[i]];
-    }
+        if( nRunSize > 0 )
+        {
+            bOK = SpillSortRun( fpRuns, pasIndexFields, panFIDList, nRunSize,
+                                nFeatureCount - nRunSize, pabStringKey );
+            anRunCounts.push_back( nRunSize );
+            anRunOffsets.push_back( VSIFTellL( fpRuns ) );
+            nRunSize = 0;
+        }
 
-    CPLFree( panFIDList );
+        if( bOK )
+        {
+            CPLDebug( "GenSQL", "Merging %d sorted runs of %d features.",
+                      (int) anRunCounts.size(), nFeatureCount );
+            bOK = MergeSortRuns( fpRuns, (int) anRunCounts.size(),
+                                 &anRunOffsets[0], &anRunCounts[0],
+                                 nFeatureCount, nLimit, pabStringKey,
+                                 pbAlreadySorted );
+        }
+    }
 
 /* -------------------------------------------------------------------- */
 /*      Free the key field values.                                      */
 /* -------------------------------------------------------------------- */
-    for( int iKey = 0; iKey < nOrderItems; iKey++ )
+    OGRGenSQLFreeIndexFields( pasIndexFields, nRunSize, nOrderItems,
+                              pabStringKey );
+    CPLFree( pasIndexFields );
+    CPLFree( panFIDList );
+
+    if( fpRuns != NULL )
     {
-        swq_order_def *psKeyDef = psSelectInfo->order_defs + iKey;
-        OGRFieldDefn *poFDefn;
+        VSIFCloseL( fpRuns );
+        VSIUnlink( osTmpFilename );
+    }
+
+    return bOK;
+}
+
+/************************************************************************/
+/*                            SpillSortRun()                            */
+/*                                                                      */
+/*      Sort nEntries keys and append them to the temporary file as     */
+/*      a run.  The string keys are freed in all cases.                 */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::SpillSortRun( VSILFILE *fp,
+                                         OGRField *pasIndexFields,
+                                         long *panFIDList, int nEntries,
+                                         int nFirstSeq,
+                                         const int *pabStringKey )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    int      i, nOrderItems = psSelectInfo->order_specs;
+    int      bOK = TRUE;
+
+    panFIDIndex = (long *) CPLMalloc(sizeof(long) * nEntries);
+    for( i = 0; i < nEntries; i++ )
+        panFIDIndex[i] = i;
+
+    SortIndexSection( pasIndexFields, 0, nEntries );
+
+    for( i = 0; bOK && i < nEntries; i++ )
+    {
+        long iEntry = panFIDIndex[i];
+        long nSeq = nFirstSeq + iEntry;
+        OGRField *pasTuple = pasIndexFields + iEntry * nOrderItems;
+
+        bOK = VSIFWriteL( &nSeq, sizeof(long), 1, fp ) == 1
+            && VSIFWriteL( panFIDList + iEntry, sizeof(long), 1, fp ) == 1;
 
-        if ( psKeyDef->field_index >= iFIDFieldIndex &&
-            psKeyDef->field_index < iFIDFieldIndex + SPECIAL_FIELD_COUNT )
+        for( int iKey = 0; bOK && iKey < nOrderItems; iKey++ )
         {
-            /* warning: only special fields of type string should be deallocated */
-            if (SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex] == SWQ_STRING)
+            OGRField *psField = pasTuple + iKey;
+
+            if( !pabStringKey[iKey] )
             {
-                for( i = 0; i < nIndexSize; i++ )
-                {
-                    OGRField *psField = pasIndexFields + iKey + i * nOrderItems;
-                    CPLFree( psField->String );
-                }
+                bOK = VSIFWriteL( psField, sizeof(OGRField), 1, fp ) == 1;
+            }
+            else if( psField->Set.nMarker1 == OGRUnsetMarker 
+                     && psField->Set.nMarker2 == OGRUnsetMarker )
+            {
+                int nLength = -1;
+                bOK = VSIFWriteL( &nLength, sizeof(int), 1, fp ) == 1;
+            }
+            else
+            {
+                int nLength = (int) strlen( psField->String );
+                bOK = VSIFWriteL( &nLength, sizeof(int), 1, fp ) == 1
+                    && (int) VSIFWriteL( psField->String, 1, nLength, fp )
+                       == nLength;
             }
-            continue;
         }
+    }
 
-        poFDefn = poSrcLayer->GetLayerDefn()->GetFieldDefn( 
-            psKeyDef->field_index );
+    CPLFree( panFIDIndex );
+    panFIDIndex = NULL;
+
+    OGRGenSQLFreeIndexFields( pasIndexFields, nEntries, nOrderItems,
+                              pabStringKey );
+
+    if( !bOK )
+        CPLError( CE_Failure, CPLE_FileIO,
+                  "Failed to write ORDER BY sort run to temporary file." );
+
+    return bOK;
+}
+
+/************************************************************************/
+/*                           MergeSortRuns()                            */
+/*                                                                      */
+/*      Merge the sorted runs of the temporary file into panFIDIndex,   */
+/*      using a heap of the current record of each run.                 */
+/************************************************************************/
+
+int OGRGenSQLResultsLayer::MergeSortRuns( VSILFILE *fp, int nRuns,
+                                          const vsi_l_offset *panRunOffsets,
+                                          const int *panRunCounts,
+                                          int nFeatureCount, long nLimit,
+                                          const int *pabStringKey,
+                                          int *pbAlreadySorted )
+
+{
+    swq_select *psSelectInfo = (swq_select *) pSelectInfo;
+    int      i, iRun, nOrderItems = psSelectInfo->order_specs;
+    int      bOK = TRUE;
+
+    OGRGenSQLSortRun **papoRuns = (OGRGenSQLSortRun **)
+        CPLMalloc( sizeof(OGRGenSQLSortRun *) * nRuns );
+    OGRField **papasTuples = (OGRField **)
+        CPLMalloc( sizeof(OGRField *) * nRuns );
+    long *panSeqList = (long *) CPLMalloc( sizeof(long) * nRuns );
+    int *panHeap = (int *) CPLMalloc( sizeof(int) * nRuns );
+    int nHeapSize = 0;
+
+    for( iRun = 0; iRun < nRuns; iRun++ )
+    {
+        papoRuns[iRun] = new OGRGenSQLSortRun( fp, panRunOffsets[iRun],
+                                               panRunOffsets[iRun+1],
+                                               panRunCounts[iRun],
+                                               nOrderItems, pabStringKey );
+        papasTuples[iRun] = papoRuns[iRun]->pasFields;
+
+        if( !papoRuns[iRun]->Next() )
+            bOK = FALSE;
+        panSeqList[iRun] = papoRuns[iRun]->nSeq;
+        panHeap[nHeapSize++] = iRun;
+    }
+
+    for( i = nHeapSize / 2 - 1; i >= 0; i-- )
+        SiftDownHeap( panHeap, nHeapSize, i, papasTuples, panSeqList, 1 );
+
+/* -------------------------------------------------------------------- */
+/*      Take the first record of the heap until the index is full.      */
+/* -------------------------------------------------------------------- */
+    nIndexSize = nFeatureCount;
+    if( nLimit >= 0 && nLimit < nIndexSize )
+        nIndexSize = (int) nLimit;
+
+    panFIDIndex = (long *) VSIMalloc2( sizeof(long), nIndexSize );
+    if( panFIDIndex == NULL && nIndexSize > 0 )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Cannot allocate ORDER BY index of %d features.",
+                  nIndexSize );
+        bOK = FALSE;
+    }
+
+    for( i = 0; bOK && i < nIndexSize; i++ )
+    {
+        OGRGenSQLSortRun *poRun = papoRuns[panHeap[0]];
+
+        if( poRun->nSeq != i )
+            *pbAlreadySorted = FALSE;
+        panFIDIndex[i] = poRun->nFID;
+
+        if( poRun->IsExhausted() )
+            panHeap[0] = panHeap[--nHeapSize];
+        else if( poRun->Next() )
+            panSeqList[panHeap[0]] = poRun->nSeq;
+        else
+            bOK = FALSE;
 
-        if( poFDefn->GetType() == OFTString )
+        SiftDownHeap( panHeap, nHeapSize, 0, papasTuples, panSeqList, 1 );
+    }
+
+    for( iRun = 0; iRun < nRuns; iRun++ )
+        delete papoRuns[iRun];
+    CPLFree( papoRuns );
+    CPLFree( papasTuples );
+    CPLFree( panSeqList );
+    CPLFree( panHeap );
+
+    return bOK;
+}
+
+/************************************************************************/
+/*                            SiftDownHeap()                            */
+/*                                                                      */
+/*      Restore the heap property below iPos.  With nDirection == 1     */
+/*      the root is the tuple sorting first, with nDirection == -1      */
+/*      it is the tuple sorting last.                                   */
+/************************************************************************/
+
+void OGRGenSQLResultsLayer::SiftDownHeap( int *panHeap, int nHeapSize,
+                                          int iPos, OGRField **papasTuples,
+                                          long *panSeqList, int nDirection )
+
+{
+    while( TRUE )
+    {
+        int iBest = iPos;
+
+        for( int iChild = 2 * iPos + 1;
+             iChild <= 2 * iPos + 2 && iChild < nHeapSize; iChild++ )
         {
-            for( i = 0; i < nIndexSize; i++ )
-            {
-                OGRField *psField = pasIndexFields + iKey + i * nOrderItems;
-                
-                if( psField->Set.nMarker1 != OGRUnsetMarker 
-                    || psField->Set.nMarker2 != OGRUnsetMarker )
-                    CPLFree( psField->String );
-            }
+            if( nDirection * CompareWithSeq( papasTuples[panHeap[iChild]],
+                                             panSeqList[panHeap[iChild]],
+                                             papasTuples[panHeap[iBest]],
+                                             panSeqList[panHeap[iBest]] ) > 0 )
+                iBest = iChild;
         }
+
+        if( iBest == iPos )
+            return;
+
+        int iTmp = panHeap[iPos];
+        panHeap[iPos] = panHeap[iBest];
+        panHeap[iBest] = iTmp;
+        iPos = iBest;
     }
+}
 
-    CPLFree( pasIndexFields );
+/************************************************************************/
+/*                           CompareWithSeq()                           */
+/*                                                                      */
+/*      Same as Compare(), but tuples with equal keys are ordered by    */
+/*      the sequence number of their feature in the source layer.      */
+/************************************************************************/
 
-    /* If it is already sorted, then free than panFIDIndex array */
-    /* so that GetNextFeature() can call a sequential GetNextFeature() */
-    /* on the source array. Very usefull for layers where random access */
-    /* is slow. */
-    /* Use case: the GML result of a WFS GetFeature with a SORTBY */
-    if (bAlreadySorted)
-    {
-        CPLFree( panFIDIndex );
-        panFIDIndex = NULL;
+int OGRGenSQLResultsLayer::CompareWithSeq( OGRField *pasFirstTuple,
+                                           long nFirstSeq,
+                                           OGRField *pasSecondTuple,
+                                           long nSecondSeq )
 
-        nIndexSize = 0;
+{
+    int nResult = Compare( pasFirstTuple, pasSecondTuple );
+
+    if( nResult == 0 )
+    {
+        if( nFirstSeq < nSecondSeq )
+            nResult = 1;
+        else if( nFirstSeq > nSecondSeq )
+            nResult = -1;
     }
 
-    ResetReading();
+    return nResult;
 }
 
 /************************************************************************/
@@ -1846,11 +4297,22 @@ int OGRGenSQLResultsLayer::Compare( OGRField *pasFirstTuple,
             poFDefn = poSrcLayer->GetLayerDefn()->GetFieldDefn( 
                 psKeyDef->field_index );
         
-        if( (pasFirstTuple[iKey].Set.nMarker1 == OGRUnsetMarker 
-             && pasFirstTuple[iKey].Set.nMarker2 == OGRUnsetMarker)
-            || (pasSecondTuple[iKey].Set.nMarker1 == OGRUnsetMarker 
-                && pasSecondTuple[iKey].Set.nMarker2 == OGRUnsetMarker) )
-            nResult = 0;
+        int bFirstUnset = 
+            pasFirstTuple[iKey].Set.nMarker1 == OGRUnsetMarker 
+            && pasFirstTuple[iKey].Set.nMarker2 == OGRUnsetMarker;
+        int bSecondUnset = 
+            pasSecondTuple[iKey].Set.nMarker1 == OGRUnsetMarker 
+            && pasSecondTuple[iKey].Set.nMarker2 == OGRUnsetMarker;
+
+        /* Unset values sort before any other value, so that the */
+        /* ordering is total as the merge of sorted runs requires. */
+        if( bFirstUnset || bSecondUnset )
+        {
+            if( !bFirstUnset )
+                nResult = 1;
+            else if( !bSecondUnset )
+                nResult = -1;
+        }
         else if ( poFDefn == NULL )
         {
             switch (SpecialFieldTypes[psKeyDef->field_index - iFIDFieldIndex])
@@ -1987,6 +4449,12 @@ void OGRGenSQLResultsLayer::FindAndSetIgnoredFields()
         AddFieldDefnToSet(psOrderDef->table_index, psOrderDef->field_index, hSet);
     }
 
+    for( int iGroup = 0; iGroup < psSelectInfo->group_specs; iGroup++ )
+    {
+        swq_group_def *psGroupDef = psSelectInfo->group_defs + iGroup;
+        AddFieldDefnToSet(psGroupDef->table_index, psGroupDef->field_index, hSet);
+    }
+
 /* -------------------------------------------------------------------- */
 /*      2nd phase : now, we can exclude the unused fields               */
 /* -------------------------------------------------------------------- */
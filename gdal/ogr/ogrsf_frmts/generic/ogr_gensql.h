@@ -45,6 +45,9 @@
 #define ALL_FIELD_INDEX_TO_GEOM_FIELD_INDEX(poFDefn, idx) \
     ((idx) - ((poFDefn)->GetFieldCount() + SPECIAL_FIELD_COUNT))
 
+class OGRGenSQLJoinHash;
+class OGRGenSQLGroupRows;
+
 /************************************************************************/
 /*                        OGRGenSQLResultsLayer                         */
 /************************************************************************/
@@ -63,6 +66,14 @@ class CPL_DLL OGRGenSQLResultsLayer : public OGRLayer
     OGRFeatureDefn *poDefn;
 
     int         PrepareSummary();
+    int         NeedSourceGeometry();
+    int         IsSourceGeomField( int nFieldIndex );
+
+    OGRGenSQLGroupRows *poGroupRows;
+
+    int         PrepareGroupBy();
+    int         CreateGroupOrderIndex();
+    OGRFeature *GetGroupFeature( long nFID );
     
     int        *panGeomFieldToSrcGeomField;
 
@@ -71,6 +82,7 @@ class CPL_DLL OGRGenSQLResultsLayer : public OGRLayer
     int         bOrderByValid;
 
     int         nNextIndexFID;
+    long        nIteratedFeatures;
     OGRFeature  *poSummaryFeature;
 
     int         iFIDFieldIndex;
@@ -78,11 +90,41 @@ class CPL_DLL OGRGenSQLResultsLayer : public OGRLayer
     int         nExtraDSCount;
     GDALDataset **papoExtraDS;
 
+    int         bJoinHashesBuilt;
+    OGRGenSQLJoinHash **papoJoinHashes;
+
+    void        BuildJoinHashes();
+    OGRFeature *FetchJoinFeature( int iJoin, OGRFeature *poSrcFeat,
+                                  int *pbOwned );
+
     OGRFeature *TranslateFeature( OGRFeature * );
     void        CreateOrderByIndex();
+    int         GetIndexTupleSize();
+    int         OrderKeyIsString( int iKey );
+    int         ReadIndexFields( OGRFeature *poSrcFeat,
+                                 OGRField *pasIndexFields );
+    int         CreateTopNIndex( int nLimit, const int *pabStringKey,
+                                 int *pbAlreadySorted );
+    int         CreateSortedIndex( GIntBig nMaxMemory, long nLimit,
+                                   const int *pabStringKey,
+                                   int *pbAlreadySorted );
+    int         SpillSortRun( VSILFILE *fp, OGRField *pasIndexFields,
+                              long *panFIDList, int nEntries, int nFirstSeq,
+                              const int *pabStringKey );
+    int         MergeSortRuns( VSILFILE *fp, int nRuns,
+                               const vsi_l_offset *panRunOffsets,
+                               const int *panRunCounts,
+                               int nFeatureCount, long nLimit,
+                               const int *pabStringKey,
+                               int *pbAlreadySorted );
+    void        SiftDownHeap( int *panHeap, int nHeapSize, int iPos,
+                              OGRField **papasTuples, long *panSeqList,
+                              int nDirection );
     void        SortIndexSection( OGRField *pasIndexFields, 
                                   int nStart, int nEntries );
     int         Compare( OGRField *pasFirst, OGRField *pasSecond );
+    int         CompareWithSeq( OGRField *pasFirst, long nFirstSeq,
+                                OGRField *pasSecond, long nSecondSeq );
 
     void        ClearFilters();
     void        ApplyFiltersToSource();
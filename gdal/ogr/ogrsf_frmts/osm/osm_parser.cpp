@@ -33,6 +33,7 @@
 #include "cpl_conv.h"
 #include "cpl_string.h"
 #include "cpl_vsi.h"
+#include "cpl_vsi_virtual.h"
 
 #ifdef HAVE_EXPAT
 #include "ogr_expat.h"
@@ -2194,6 +2195,9 @@ OSMContext* OSM_Open( const char* pszFilename,
 
     VSIFSeekL(fp, 0, SEEK_SET);
 
+    /* Read the next blobs in a background thread if VSI_READAHEAD is set */
+    fp = (VSILFILE*) VSICreateReadAheadHandleIfNeeded((VSIVirtualHandle*)fp);
+
     psCtxt = (OSMContext*) VSIMalloc(sizeof(OSMContext));
     if (psCtxt == NULL)
     {
@@ -1240,3 +1240,197 @@ OGRErr OGRReadWKBGeometryType( unsigned char * pabyData, OGRwkbGeometryType *peG
     
     return OGRERR_NONE;
 }
+
+/************************************************************************/
+/*                         OGRCopyDoubles64()                           */
+/*                                                                      */
+/*      Copy nCount doubles between possibly unaligned buffers,         */
+/*      optionally reversing the byte order of each of them.  The       */
+/*      swapping variant is written as a plain byte shuffle so that     */
+/*      the compiler can turn it into vector byte permutes.             */
+/************************************************************************/
+
+static void OGRCopyDoubles64( GByte *pabyDst, int nDstStride,
+                              const GByte *pabySrc, int nSrcStride,
+                              int nCount, int bSwap )
+
+{
+    int i;
+
+    if( !bSwap )
+    {
+        if( nDstStride == 8 && nSrcStride == 8 )
+        {
+            memcpy( pabyDst, pabySrc, 8 * (size_t)nCount );
+            return;
+        }
+        for( i = 0; i < nCount; i++ )
+            memcpy( pabyDst + (size_t)i * nDstStride,
+                    pabySrc + (size_t)i * nSrcStride, 8 );
+        return;
+    }
+
+    for( i = 0; i < nCount; i++ )
+    {
+        GByte       *pabyD = pabyDst + (size_t)i * nDstStride;
+        const GByte *pabyS = pabySrc + (size_t)i * nSrcStride;
+
+        pabyD[0] = pabyS[7];
+        pabyD[1] = pabyS[6];
+        pabyD[2] = pabyS[5];
+        pabyD[3] = pabyS[4];
+        pabyD[4] = pabyS[3];
+        pabyD[5] = pabyS[2];
+        pabyD[6] = pabyS[1];
+        pabyD[7] = pabyS[0];
+    }
+}
+
+/************************************************************************/
+/*                          OGRReadWKBPoints()                          */
+/*                                                                      */
+/*      Decode nPointCount WKB points into the point buffers of a       */
+/*      line string.  The input is 3D when padfZ is not NULL.  Byte     */
+/*      swapping is done while copying, in a single pass over the       */
+/*      buffer.                                                         */
+/************************************************************************/
+
+void OGRReadWKBPoints( const GByte *pabyData, int nPointCount, int bSwap,
+                       OGRRawPoint *paoPoints, double *padfZ )
+
+{
+    GByte *pabyXY = (GByte *) paoPoints;
+
+    if( padfZ == NULL )
+    {
+        OGRCopyDoubles64( pabyXY, 8, pabyData, 8, 2 * nPointCount, bSwap );
+        return;
+    }
+
+    OGRCopyDoubles64( pabyXY, 16, pabyData, 24, nPointCount, bSwap );
+    OGRCopyDoubles64( pabyXY + 8, 16, pabyData + 8, 24, nPointCount, bSwap );
+    OGRCopyDoubles64( (GByte *) padfZ, 8, pabyData + 16, 24,
+                      nPointCount, bSwap );
+}
+
+/************************************************************************/
+/*                         OGRWriteWKBPoints()                          */
+/*                                                                      */
+/*      Encode the point buffers of a line string as nPointCount WKB    */
+/*      points.  When b3D is set and padfZ is NULL, zero Z values are   */
+/*      written.                                                        */
+/************************************************************************/
+
+void OGRWriteWKBPoints( GByte *pabyData, int nPointCount, int bSwap,
+                        const OGRRawPoint *paoPoints, const double *padfZ,
+                        int b3D )
+
+{
+    const GByte *pabyXY = (const GByte *) paoPoints;
+
+    if( !b3D )
+    {
+        OGRCopyDoubles64( pabyData, 8, pabyXY, 8, 2 * nPointCount, bSwap );
+        return;
+    }
+
+    OGRCopyDoubles64( pabyData, 24, pabyXY, 16, nPointCount, bSwap );
+    OGRCopyDoubles64( pabyData + 8, 24, pabyXY + 8, 16, nPointCount, bSwap );
+    if( padfZ != NULL )
+        OGRCopyDoubles64( pabyData + 16, 24, (const GByte *) padfZ, 8,
+                          nPointCount, bSwap );
+    else
+    {
+        for( int i = 0; i < nPointCount; i++ )
+            memset( pabyData + 16 + (size_t)i * 24, 0, 8 );
+    }
+}
+
+/************************************************************************/
+/*                        OGRGetPointsEnvelope()                        */
+/*                                                                      */
+/*      Compute the 2D extent of a point buffer.  Two independent       */
+/*      sets of accumulators are used so that consecutive points do     */
+/*      not depend on each other, which lets the compiler use packed    */
+/*      min/max instructions.  nPointCount must be at least 1.          */
+/************************************************************************/
+
+void OGRGetPointsEnvelope( int nPointCount, const OGRRawPoint *paoPoints,
+                           OGREnvelope *psEnvelope )
+
+{
+    double dfMinX0, dfMinY0, dfMaxX0, dfMaxY0;
+    double dfMinX1, dfMinY1, dfMaxX1, dfMaxY1;
+    int    i;
+
+    dfMinX0 = dfMaxX0 = dfMinX1 = dfMaxX1 = paoPoints[0].x;
+    dfMinY0 = dfMaxY0 = dfMinY1 = dfMaxY1 = paoPoints[0].y;
+
+    for( i = 1; i + 1 < nPointCount; i += 2 )
+    {
+        const double dfX0 = paoPoints[i].x;
+        const double dfY0 = paoPoints[i].y;
+        const double dfX1 = paoPoints[i+1].x;
+        const double dfY1 = paoPoints[i+1].y;
+
+        dfMinX0 = (dfX0 < dfMinX0) ? dfX0 : dfMinX0;
+        dfMinY0 = (dfY0 < dfMinY0) ? dfY0 : dfMinY0;
+        dfMaxX0 = (dfX0 > dfMaxX0) ? dfX0 : dfMaxX0;
+        dfMaxY0 = (dfY0 > dfMaxY0) ? dfY0 : dfMaxY0;
+        dfMinX1 = (dfX1 < dfMinX1) ? dfX1 : dfMinX1;
+        dfMinY1 = (dfY1 < dfMinY1) ? dfY1 : dfMinY1;
+        dfMaxX1 = (dfX1 > dfMaxX1) ? dfX1 : dfMaxX1;
+        dfMaxY1 = (dfY1 > dfMaxY1) ? dfY1 : dfMaxY1;
+    }
+    if( i < nPointCount )
+    {
+        const double dfX0 = paoPoints[i].x;
+        const double dfY0 = paoPoints[i].y;
+
+        dfMinX0 = (dfX0 < dfMinX0) ? dfX0 : dfMinX0;
+        dfMinY0 = (dfY0 < dfMinY0) ? dfY0 : dfMinY0;
+        dfMaxX0 = (dfX0 > dfMaxX0) ? dfX0 : dfMaxX0;
+        dfMaxY0 = (dfY0 > dfMaxY0) ? dfY0 : dfMaxY0;
+    }
+
+    psEnvelope->MinX = (dfMinX1 < dfMinX0) ? dfMinX1 : dfMinX0;
+    psEnvelope->MinY = (dfMinY1 < dfMinY0) ? dfMinY1 : dfMinY0;
+    psEnvelope->MaxX = (dfMaxX1 > dfMaxX0) ? dfMaxX1 : dfMaxX0;
+    psEnvelope->MaxY = (dfMaxY1 > dfMaxY0) ? dfMaxY1 : dfMaxY0;
+}
+
+/************************************************************************/
+/*                          OGRGetValuesRange()                         */
+/*                                                                      */
+/*      Same as OGRGetPointsEnvelope() for a flat array of doubles,     */
+/*      typically the Z values of a line string.                        */
+/************************************************************************/
+
+void OGRGetValuesRange( int nCount, const double *padfValues,
+                        double *pdfMin, double *pdfMax )
+
+{
+    double dfMin0, dfMax0, dfMin1, dfMax1;
+    int    i;
+
+    dfMin0 = dfMax0 = dfMin1 = dfMax1 = padfValues[0];
+
+    for( i = 1; i + 1 < nCount; i += 2 )
+    {
+        const double dfV0 = padfValues[i];
+        const double dfV1 = padfValues[i+1];
+
+        dfMin0 = (dfV0 < dfMin0) ? dfV0 : dfMin0;
+        dfMax0 = (dfV0 > dfMax0) ? dfV0 : dfMax0;
+        dfMin1 = (dfV1 < dfMin1) ? dfV1 : dfMin1;
+        dfMax1 = (dfV1 > dfMax1) ? dfV1 : dfMax1;
+    }
+    if( i < nCount )
+    {
+        dfMin0 = (padfValues[i] < dfMin0) ? padfValues[i] : dfMin0;
+        dfMax0 = (padfValues[i] > dfMax0) ? padfValues[i] : dfMax0;
+    }
+
+    *pdfMin = (dfMin1 < dfMin0) ? dfMin1 : dfMin0;
+    *pdfMax = (dfMax1 > dfMax0) ? dfMax1 : dfMax0;
+}
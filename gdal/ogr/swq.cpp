@@ -255,10 +255,13 @@ int swqlex( YYSTYPE *ppNode, swq_parse_context *context )
             nReturn = SWQT_UNION;
         else if( EQUAL(osToken,"ALL") )
             nReturn = SWQT_ALL;
+        else if( EQUAL(osToken,"LIMIT") )
+            nReturn = SWQT_LIMIT;
+        else if( EQUAL(osToken,"GROUP") )
+            nReturn = SWQT_GROUP;
 
         /* Unhandled by OGR SQL */
-        else if( EQUAL(osToken,"LIMIT") ||
-                 EQUAL(osToken,"OUTER") ||
+        else if( EQUAL(osToken,"OUTER") ||
                  EQUAL(osToken,"INNER") )
             nReturn = SWQT_RESERVED_KEYWORD;
 
@@ -281,6 +284,57 @@ int swqlex( YYSTYPE *ppNode, swq_parse_context *context )
     }
 }
 
+/************************************************************************/
+/*                          swq_summary_init()                          */
+/************************************************************************/
+
+void swq_summary_init( swq_summary *summaries, int count )
+
+{
+    int i;
+
+    memset( summaries, 0, sizeof(swq_summary) * count );
+
+    for( i = 0; i < count; i++ )
+    {
+        summaries[i].min = 1e20;
+        summaries[i].max = -1e20;
+        strcpy(summaries[i].szMin, "9999/99/99 99:99:99");
+        strcpy(summaries[i].szMax, "0000/00/00 00:00:00");
+    }
+}
+
+/************************************************************************/
+/*                          swq_summary_free()                          */
+/*                                                                      */
+/*      Free the distinct lists of an array of summaries, but not the   */
+/*      array itself.                                                   */
+/************************************************************************/
+
+void swq_summary_free( swq_summary *summaries, int count )
+
+{
+    int i, j;
+
+    for( i = 0; i < count; i++ )
+    {
+        if( summaries[i].distinct_list != NULL )
+        {
+            for( j = 0; j < summaries[i].count; j++ )
+                CPLFree( summaries[i].distinct_list[j] );
+
+            CPLFree( summaries[i].distinct_list );
+            summaries[i].distinct_list = NULL;
+        }
+
+        if( summaries[i].distinct_set != NULL )
+        {
+            CPLHashSetDestroy( summaries[i].distinct_set );
+            summaries[i].distinct_set = NULL;
+        }
+    }
+}
+
 /************************************************************************/
 /*                        swq_select_summarize()                        */
 /************************************************************************/
@@ -291,7 +345,6 @@ swq_select_summarize( swq_select *select_info,
 
 {
     swq_col_def *def = select_info->column_defs + dest_column;
-    swq_summary *summary;
 
 /* -------------------------------------------------------------------- */
 /*      Do various checking.                                            */
@@ -311,60 +364,75 @@ swq_select_summarize( swq_select *select_info,
 /* -------------------------------------------------------------------- */
     if( select_info->column_summary == NULL && value != NULL )
     {
-        int i;
-
         select_info->column_summary = (swq_summary *) 
             CPLMalloc(sizeof(swq_summary) * select_info->result_columns);
-        memset( select_info->column_summary, 0, 
-                sizeof(swq_summary) * select_info->result_columns );
-
-        for( i = 0; i < select_info->result_columns; i++ )
-        {
-            select_info->column_summary[i].min = 1e20;
-            select_info->column_summary[i].max = -1e20;
-            strcpy(select_info->column_summary[i].szMin, "9999/99/99 99:99:99");
-            strcpy(select_info->column_summary[i].szMax, "0000/00/00 00:00:00");
-        }
+        swq_summary_init( select_info->column_summary,
+                          select_info->result_columns );
     }
 
     if( select_info->column_summary == NULL )
         return NULL;
 
+    return swq_summary_add_value( def, 
+                                  select_info->column_summary + dest_column,
+                                  value );
+}
+
+/************************************************************************/
+/*                       swq_summary_add_value()                        */
+/*                                                                      */
+/*      Accumulate one value of the column described by def in the      */
+/*      summary.  Also used for each group of a GROUP BY query.         */
+/************************************************************************/
+
+const char *swq_summary_add_value( swq_col_def *def, swq_summary *summary,
+                                   const char *value )
+
+{
+    if( def->col_func == SWQCF_NONE && !def->distinct_flag )
+        return NULL;
+
+    /* COUNT() and COUNT(DISTINCT) only count non-null values. */
+    if( def->col_func == SWQCF_COUNT && value == NULL )
+        return NULL;
+
 /* -------------------------------------------------------------------- */
 /*      If distinct processing is on, process that now.                 */
 /* -------------------------------------------------------------------- */
-    summary = select_info->column_summary + dest_column;
-    
     if( def->distinct_flag )
     {
-        int  i;
-
-        /* This should be implemented with a much more complicated
-           data structure to achieve any sort of efficiency. */
-        for( i = 0; i < summary->count; i++ )
+        if( summary->distinct_set == NULL )
+            summary->distinct_set = CPLHashSetNew( CPLHashSetHashStr,
+                                                   CPLHashSetEqualStr,
+                                                   NULL );
+
+        /* The set may contain NULL, so we cannot rely on */
+        /* CPLHashSetLookup() to tell if it is already there. */
+        int bNew;
+        char *pszNewValue = NULL;
+
+        if( value == NULL )
+            bNew = CPLHashSetInsert( summary->distinct_set, NULL );
+        else
         {
-            if( value == NULL )
+            bNew = CPLHashSetLookup( summary->distinct_set, value ) == NULL;
+            if( bNew )
             {
-                if (summary->distinct_list[i] == NULL)
-                    break;
+                pszNewValue = CPLStrdup( value );
+                CPLHashSetInsert( summary->distinct_set, pszNewValue );
             }
-            else if( summary->distinct_list[i] != NULL &&
-                     strcmp(value,summary->distinct_list[i]) == 0 )
-                break;
         }
         
-        if( i == summary->count )
+        if( bNew )
         {
-            char  **old_list = summary->distinct_list;
-            
-            summary->distinct_list = (char **) 
-                CPLMalloc(sizeof(char *) * (summary->count+1));
-            memcpy( summary->distinct_list, old_list, 
-                    sizeof(char *) * summary->count );
-            summary->distinct_list[(summary->count)++] = 
-                (value != NULL) ? CPLStrdup( value ) : NULL;
-
-            CPLFree(old_list);
+            if( (summary->count & (summary->count - 1)) == 0 )
+            {
+                /* grow the list when count reaches a power of two */
+                summary->distinct_list = (char **) 
+                    CPLRealloc( summary->distinct_list,
+                                sizeof(char *) * MAX(1, summary->count * 2) );
+            }
+            summary->distinct_list[(summary->count)++] = pszNewValue;
         }
     }
 
@@ -377,6 +445,7 @@ swq_select_summarize( swq_select *select_info,
       case SWQCF_MIN:
         if( value != NULL && value[0] != '\0' )
         {
+            summary->count++;
             if(def->field_type == SWQ_DATE ||
                def->field_type == SWQ_TIME ||
                def->field_type == SWQ_TIMESTAMP)
@@ -398,6 +467,7 @@ swq_select_summarize( swq_select *select_info,
       case SWQCF_MAX:
         if( value != NULL && value[0] != '\0' )
         {
+            summary->count++;
             if(def->field_type == SWQ_DATE ||
                def->field_type == SWQ_TIME ||
                def->field_type == SWQ_TIMESTAMP)
@@ -464,6 +534,7 @@ swq_select_summarize( swq_select *select_info,
 
     return NULL;
 }
+
 /************************************************************************/
 /*                      sort comparison functions.                      */
 /************************************************************************/
@@ -821,7 +892,9 @@ static const char* apszSQLReservedKeywords[] = {
     "ASC",
     "DESC",
     "UNION",
-    "ALL"
+    "ALL",
+    "LIMIT",
+    "GROUP"
 };
 
 int swq_is_reserved_keyword(const char* pszStr)
@@ -24,6 +24,7 @@
 #include "cpl_conv.h"
 #include "cpl_string.h"
 #include "ogr_core.h"
+#include "cpl_hash_set.h"
 
 #if defined(_WIN32) && !defined(_WIN32_WCE)
 #  define strcasecmp stricmp
@@ -206,7 +207,7 @@ CPLErr swq_expr_compile2( const char *where_clause,
 /*
 ** Evaluation related.
 */
-int swq_test_like( const char *input, const char *pattern );
+int swq_test_like( const char *input, const char *pattern, char chEscape );
 
 swq_expr_node *SWQGeneralEvaluator( swq_expr_node *, swq_expr_node **);
 swq_field_type SWQGeneralChecker( swq_expr_node *node );
@@ -221,6 +222,7 @@ const char*    SWQFieldTypeToString( swq_field_type field_type );
 #define SWQM_SUMMARY_RECORD  1
 #define SWQM_RECORDSET       2
 #define SWQM_DISTINCT_LIST   3
+#define SWQM_GROUP_BY        4
 
 typedef enum {
     SWQCF_NONE = 0,
@@ -252,6 +254,7 @@ typedef struct {
     int         count;
     
     char        **distinct_list; /* items of the list can be NULL */
+    CPLHashSet  *distinct_set;   /* index of distinct_list */
     double      sum;
     double      min;
     double      max;
@@ -266,6 +269,12 @@ typedef struct {
     int   ascending_flag;
 } swq_order_def;
 
+typedef struct {
+    char *field_name;
+    int   table_index;
+    int   field_index;
+} swq_group_def;
+
 typedef struct {
     int        secondary_table;
 
@@ -308,10 +317,17 @@ public:
 
     swq_expr_node *where_expr;
 
+    void        PushGroupBy( const char *pszFieldName );
+    int         group_specs;
+    swq_group_def *group_defs;
+
     void        PushOrderBy( const char *pszFieldName, int bAscending );
     int         order_specs;
     swq_order_def *order_defs;
 
+    void        SetLimit( long nLimit );
+    long        limit;
+
     swq_select *poOtherSelect;
     void        PushUnionAll( swq_select* poOtherSelectIn );
 
@@ -319,6 +335,7 @@ public:
     void        postpreparse();
     CPLErr      expand_wildcard( swq_field_list *field_list );
     CPLErr      parse( swq_field_list *field_list, int parse_flags );
+    CPLErr      parse_group_by( swq_field_list *field_list );
 
     void        Dump( FILE * );
 };
@@ -332,6 +349,11 @@ const char *swq_select_summarize( swq_select *select_info,
                                   int dest_column, 
                                   const char *value );
 
+void swq_summary_init( swq_summary *summaries, int count );
+void swq_summary_free( swq_summary *summaries, int count );
+const char *swq_summary_add_value( swq_col_def *def, swq_summary *summary,
+                                   const char *value );
+
 int swq_is_reserved_keyword(const char* pszStr);
 
 char* OGRHStoreGetValue(const char* pszHStore, const char* pszSearchedKey);
@@ -1,8 +1,9 @@
-/* A Bison parser, made by GNU Bison 3.0.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2013 Free Software Foundation, Inc.
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
  * Copyright (c) 2010-2013, Even Rouault <even dot rouault at mines-paris dot org>
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +17,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -34,6 +35,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -41,11 +46,11 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.0"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -67,9 +72,8 @@
 #define yydebug         swqdebug
 #define yynerrs         swqnerrs
 
-
-/* Copy the first part of user declarations.  */
-#line 1 "swq_parser.y" /* yacc.c:339  */
+/* First part of user prologue.  */
+#line 1 "swq_parser.y"
 
 /******************************************************************************
  *
@@ -116,121 +120,201 @@
 #define YYSTYPE_IS_TRIVIAL 1
 
 
-#line 119 "swq_parser.cpp" /* yacc.c:339  */
+#line 123 "swq_parser.cpp"
 
-# ifndef YY_NULL
-#  if defined __cplusplus && 201103L <= __cplusplus
-#   define YY_NULL nullptr
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
 #  else
-#   define YY_NULL 0
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
 #  endif
 # endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 1
-#endif
-
-/* In a future release of Bison, this section will be replaced
-   by #include "swq_parser.hpp".  */
-#ifndef YY_SWQ_SWQ_PARSER_HPP_INCLUDED
-# define YY_SWQ_SWQ_PARSER_HPP_INCLUDED
-/* Debug traces.  */
-#ifndef YYDEBUG
-# define YYDEBUG 0
-#endif
-#if YYDEBUG
-extern int swqdebug;
-#endif
-
-/* Token type.  */
-#ifndef YYTOKENTYPE
-# define YYTOKENTYPE
-  enum yytokentype
-  {
-    END = 0,
-    SWQT_INTEGER_NUMBER = 258,
-    SWQT_FLOAT_NUMBER = 259,
-    SWQT_STRING = 260,
-    SWQT_IDENTIFIER = 261,
-    SWQT_IN = 262,
-    SWQT_LIKE = 263,
-    SWQT_ESCAPE = 264,
-    SWQT_BETWEEN = 265,
-    SWQT_NULL = 266,
-    SWQT_IS = 267,
-    SWQT_SELECT = 268,
-    SWQT_LEFT = 269,
-    SWQT_JOIN = 270,
-    SWQT_WHERE = 271,
-    SWQT_ON = 272,
-    SWQT_ORDER = 273,
-    SWQT_BY = 274,
-    SWQT_FROM = 275,
-    SWQT_AS = 276,
-    SWQT_ASC = 277,
-    SWQT_DESC = 278,
-    SWQT_DISTINCT = 279,
-    SWQT_CAST = 280,
-    SWQT_UNION = 281,
-    SWQT_ALL = 282,
-    SWQT_LOGICAL_START = 283,
-    SWQT_VALUE_START = 284,
-    SWQT_SELECT_START = 285,
-    SWQT_NOT = 286,
-    SWQT_OR = 287,
-    SWQT_AND = 288,
-    SWQT_UMINUS = 289,
-    SWQT_RESERVED_KEYWORD = 290
-  };
-#endif
+#include "swq_parser.hpp"
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of string"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_SWQT_INTEGER_NUMBER = 3,        /* "integer number"  */
+  YYSYMBOL_SWQT_FLOAT_NUMBER = 4,          /* "floating point number"  */
+  YYSYMBOL_SWQT_STRING = 5,                /* "string"  */
+  YYSYMBOL_SWQT_IDENTIFIER = 6,            /* "identifier"  */
+  YYSYMBOL_SWQT_IN = 7,                    /* "IN"  */
+  YYSYMBOL_SWQT_LIKE = 8,                  /* "LIKE"  */
+  YYSYMBOL_SWQT_ESCAPE = 9,                /* "ESCAPE"  */
+  YYSYMBOL_SWQT_BETWEEN = 10,              /* "BETWEEN"  */
+  YYSYMBOL_SWQT_NULL = 11,                 /* "NULL"  */
+  YYSYMBOL_SWQT_IS = 12,                   /* "IS"  */
+  YYSYMBOL_SWQT_SELECT = 13,               /* "SELECT"  */
+  YYSYMBOL_SWQT_LEFT = 14,                 /* "LEFT"  */
+  YYSYMBOL_SWQT_JOIN = 15,                 /* "JOIN"  */
+  YYSYMBOL_SWQT_WHERE = 16,                /* "WHERE"  */
+  YYSYMBOL_SWQT_ON = 17,                   /* "ON"  */
+  YYSYMBOL_SWQT_ORDER = 18,                /* "ORDER"  */
+  YYSYMBOL_SWQT_BY = 19,                   /* "BY"  */
+  YYSYMBOL_SWQT_FROM = 20,                 /* "FROM"  */
+  YYSYMBOL_SWQT_AS = 21,                   /* "AS"  */
+  YYSYMBOL_SWQT_ASC = 22,                  /* "ASC"  */
+  YYSYMBOL_SWQT_DESC = 23,                 /* "DESC"  */
+  YYSYMBOL_SWQT_DISTINCT = 24,             /* "DISTINCT"  */
+  YYSYMBOL_SWQT_CAST = 25,                 /* "CAST"  */
+  YYSYMBOL_SWQT_UNION = 26,                /* "UNION"  */
+  YYSYMBOL_SWQT_ALL = 27,                  /* "ALL"  */
+  YYSYMBOL_SWQT_LIMIT = 28,                /* "LIMIT"  */
+  YYSYMBOL_SWQT_GROUP = 29,                /* "GROUP"  */
+  YYSYMBOL_SWQT_LOGICAL_START = 30,        /* SWQT_LOGICAL_START  */
+  YYSYMBOL_SWQT_VALUE_START = 31,          /* SWQT_VALUE_START  */
+  YYSYMBOL_SWQT_SELECT_START = 32,         /* SWQT_SELECT_START  */
+  YYSYMBOL_SWQT_NOT = 33,                  /* "NOT"  */
+  YYSYMBOL_SWQT_OR = 34,                   /* "OR"  */
+  YYSYMBOL_SWQT_AND = 35,                  /* "AND"  */
+  YYSYMBOL_36_ = 36,                       /* '+'  */
+  YYSYMBOL_37_ = 37,                       /* '-'  */
+  YYSYMBOL_38_ = 38,                       /* '*'  */
+  YYSYMBOL_39_ = 39,                       /* '/'  */
+  YYSYMBOL_40_ = 40,                       /* '%'  */
+  YYSYMBOL_SWQT_UMINUS = 41,               /* SWQT_UMINUS  */
+  YYSYMBOL_SWQT_RESERVED_KEYWORD = 42,     /* "reserved keyword"  */
+  YYSYMBOL_43_ = 43,                       /* '('  */
+  YYSYMBOL_44_ = 44,                       /* ')'  */
+  YYSYMBOL_45_ = 45,                       /* '='  */
+  YYSYMBOL_46_ = 46,                       /* '<'  */
+  YYSYMBOL_47_ = 47,                       /* '>'  */
+  YYSYMBOL_48_ = 48,                       /* '!'  */
+  YYSYMBOL_49_ = 49,                       /* ','  */
+  YYSYMBOL_50_ = 50,                       /* '.'  */
+  YYSYMBOL_YYACCEPT = 51,                  /* $accept  */
+  YYSYMBOL_input = 52,                     /* input  */
+  YYSYMBOL_logical_expr = 53,              /* logical_expr  */
+  YYSYMBOL_value_expr_list = 54,           /* value_expr_list  */
+  YYSYMBOL_field_value = 55,               /* field_value  */
+  YYSYMBOL_value_expr = 56,                /* value_expr  */
+  YYSYMBOL_type_def = 57,                  /* type_def  */
+  YYSYMBOL_select_statement = 58,          /* select_statement  */
+  YYSYMBOL_select_core = 59,               /* select_core  */
+  YYSYMBOL_opt_union_all = 60,             /* opt_union_all  */
+  YYSYMBOL_union_all = 61,                 /* union_all  */
+  YYSYMBOL_select_field_list = 62,         /* select_field_list  */
+  YYSYMBOL_column_spec = 63,               /* column_spec  */
+  YYSYMBOL_as_clause = 64,                 /* as_clause  */
+  YYSYMBOL_opt_where = 65,                 /* opt_where  */
+  YYSYMBOL_opt_joins = 66,                 /* opt_joins  */
+  YYSYMBOL_opt_group_by = 67,              /* opt_group_by  */
+  YYSYMBOL_group_spec_list = 68,           /* group_spec_list  */
+  YYSYMBOL_group_spec = 69,                /* group_spec  */
+  YYSYMBOL_opt_order_by = 70,              /* opt_order_by  */
+  YYSYMBOL_sort_spec_list = 71,            /* sort_spec_list  */
+  YYSYMBOL_sort_spec = 72,                 /* sort_spec  */
+  YYSYMBOL_opt_limit = 73,                 /* opt_limit  */
+  YYSYMBOL_string_or_identifier = 74,      /* string_or_identifier  */
+  YYSYMBOL_table_def = 75                  /* table_def  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
-/* Value type.  */
-#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef int YYSTYPE;
-# define YYSTYPE_IS_TRIVIAL 1
-# define YYSTYPE_IS_DECLARED 1
-#endif
 
 
 
-int swqparse (swq_parse_context *context);
+#ifdef short
+# undef short
+#endif
 
-#endif /* !YY_SWQ_SWQ_PARSER_HPP_INCLUDED  */
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
 
-/* Copy the second part of user declarations.  */
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
 
-#line 206 "swq_parser.cpp" /* yacc.c:358  */
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
 
-#ifdef short
-# undef short
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
 #endif
 
-#ifdef YYTYPE_UINT8
-typedef YYTYPE_UINT8 yytype_uint8;
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
 #else
-typedef unsigned char yytype_uint8;
+typedef short yytype_int16;
 #endif
 
-#ifdef YYTYPE_INT8
-typedef YYTYPE_INT8 yytype_int8;
-#else
-typedef signed char yytype_int8;
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
 #endif
 
-#ifdef YYTYPE_UINT16
-typedef YYTYPE_UINT16 yytype_uint16;
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
 #else
-typedef unsigned short int yytype_uint16;
+typedef short yytype_uint8;
 #endif
 
-#ifdef YYTYPE_INT16
-typedef YYTYPE_INT16 yytype_int16;
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
 #else
-typedef short int yytype_int16;
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
 #endif
 
 #ifndef YYSIZE_T
@@ -238,15 +322,28 @@ typedef short int yytype_int16;
 #  define YYSIZE_T __SIZE_TYPE__
 # elif defined size_t
 #  define YYSIZE_T size_t
-# elif ! defined YYSIZE_T
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
 #  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
 #  define YYSIZE_T size_t
 # else
-#  define YYSIZE_T unsigned int
+#  define YYSIZE_T unsigned
 # endif
 #endif
 
-#define YYSIZE_MAXIMUM ((YYSIZE_T) -1)
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_uint8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
 
 #ifndef YY_
 # if defined YYENABLE_NLS && YYENABLE_NLS
@@ -260,28 +357,43 @@ typedef short int yytype_int16;
 # endif
 #endif
 
-#ifndef __attribute__
-/* This feature is available in gcc versions 2.5 and later.  */
-# if (! defined __GNUC__ || __GNUC__ < 2 \
-      || (__GNUC__ == 2 && __GNUC_MINOR__ < 5))
-#  define __attribute__(Spec) /* empty */
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
 # endif
 #endif
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN \
-    _Pragma ("GCC diagnostic push") \
-    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")\
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
-# define YY_IGNORE_MAYBE_UNINITIALIZED_END \
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
 # define YY_INITIAL_VALUE(Value) Value
@@ -294,8 +406,22 @@ typedef short int yytype_int16;
 # define YY_INITIAL_VALUE(Value) /* Nothing. */
 #endif
 
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if 1
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -360,8 +486,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* 1 */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -370,17 +495,17 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 /* A type that is properly aligned for any stack member.  */
 union yyalloc
 {
-  yytype_int16 yyss_alloc;
+  yy_state_t yyss_alloc;
   YYSTYPE yyvs_alloc;
 };
 
 /* The size of the maximum gap between one aligned stack and the next.  */
-# define YYSTACK_GAP_MAXIMUM (sizeof (union yyalloc) - 1)
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
 
 /* The size of an array large to enough to hold all stacks, each with
    N elements.  */
 # define YYSTACK_BYTES(N) \
-     ((N) * (sizeof (yytype_int16) + sizeof (YYSTYPE)) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
       + YYSTACK_GAP_MAXIMUM)
 
 # define YYCOPY_NEEDED 1
@@ -393,11 +518,11 @@ union yyalloc
 # define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
     do                                                                  \
       {                                                                 \
-        YYSIZE_T yynewbytes;                                            \
+        YYPTRDIFF_T yynewbytes;                                         \
         YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
         Stack = &yyptr->Stack_alloc;                                    \
-        yynewbytes = yystacksize * sizeof (*Stack) + YYSTACK_GAP_MAXIMUM; \
-        yyptr += yynewbytes / sizeof (*yyptr);                          \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
       }                                                                 \
     while (0)
 
@@ -409,12 +534,12 @@ union yyalloc
 # ifndef YYCOPY
 #  if defined __GNUC__ && 1 < __GNUC__
 #   define YYCOPY(Dst, Src, Count) \
-      __builtin_memcpy (Dst, Src, (Count) * sizeof (*(Src)))
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
 #  else
 #   define YYCOPY(Dst, Src, Count)              \
       do                                        \
         {                                       \
-          YYSIZE_T yyi;                         \
+          YYPTRDIFF_T yyi;                      \
           for (yyi = 0; yyi < (Count); yyi++)   \
             (Dst)[yyi] = (Src)[yyi];            \
         }                                       \
@@ -426,36 +551,39 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  23
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   328
+#define YYLAST   313
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  49
+#define YYNTOKENS  51
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  21
+#define YYNNTS  25
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  89
+#define YYNRULES  96
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  191
+#define YYNSTATES  202
 
-/* YYTRANSLATE[YYX] -- Symbol number corresponding to YYX as returned
-   by yylex, with out-of-bounds checking.  */
-#define YYUNDEFTOK  2
-#define YYMAXUTOK   290
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   292
 
-#define YYTRANSLATE(YYX)                                                \
-  ((unsigned int) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
-   as returned by yylex, without out-of-bounds checking.  */
-static const yytype_uint8 yytranslate[] =
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,     2,     2,    46,     2,     2,     2,    38,     2,     2,
-      41,    42,    36,    34,    47,    35,    48,    37,     2,     2,
+       2,     2,     2,    48,     2,     2,     2,    40,     2,     2,
+      43,    44,    38,    36,    49,    37,    50,    39,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-      44,    43,    45,     2,     2,     2,     2,     2,     2,     2,
+      46,    45,    47,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -477,101 +605,104 @@ static const yytype_uint8 yytranslate[] =
        2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
        5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
       15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
-      25,    26,    27,    28,    29,    30,    31,    32,    33,    39,
-      40
+      25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
+      35,    41,    42
 };
 
 #if YYDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
-static const yytype_uint16 yyrline[] =
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
 {
-       0,   111,   111,   116,   121,   127,   135,   143,   150,   155,
-     163,   171,   179,   187,   195,   203,   211,   219,   227,   235,
-     248,   257,   271,   280,   295,   304,   318,   325,   339,   345,
-     352,   359,   375,   380,   385,   389,   394,   399,   404,   420,
-     427,   434,   441,   448,   455,   479,   487,   493,   500,   509,
-     527,   547,   548,   551,   556,   557,   559,   567,   568,   571,
-     580,   589,   598,   610,   621,   635,   657,   687,   721,   745,
-     774,   780,   783,   784,   789,   790,   799,   809,   810,   813,
-     814,   817,   823,   829,   837,   841,   847,   857,   868,   879
+       0,   113,   113,   118,   123,   129,   137,   145,   152,   157,
+     165,   173,   181,   189,   197,   205,   213,   221,   229,   237,
+     250,   259,   273,   282,   297,   306,   320,   327,   341,   347,
+     354,   361,   377,   382,   387,   391,   396,   401,   406,   422,
+     429,   436,   443,   450,   457,   481,   489,   495,   502,   511,
+     529,   549,   550,   553,   558,   559,   561,   569,   570,   573,
+     582,   591,   600,   612,   623,   637,   659,   689,   723,   747,
+     776,   782,   785,   786,   791,   792,   801,   811,   812,   815,
+     816,   819,   826,   827,   830,   831,   834,   840,   846,   853,
+     854,   861,   865,   871,   881,   892,   903
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || 1
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if 1
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "\"end of string\"", "error", "$undefined", "\"integer number\"",
+  "\"end of string\"", "error", "\"invalid token\"", "\"integer number\"",
   "\"floating point number\"", "\"string\"", "\"identifier\"", "\"IN\"",
   "\"LIKE\"", "\"ESCAPE\"", "\"BETWEEN\"", "\"NULL\"", "\"IS\"",
   "\"SELECT\"", "\"LEFT\"", "\"JOIN\"", "\"WHERE\"", "\"ON\"", "\"ORDER\"",
   "\"BY\"", "\"FROM\"", "\"AS\"", "\"ASC\"", "\"DESC\"", "\"DISTINCT\"",
-  "\"CAST\"", "\"UNION\"", "\"ALL\"", "SWQT_LOGICAL_START",
-  "SWQT_VALUE_START", "SWQT_SELECT_START", "\"NOT\"", "\"OR\"", "\"AND\"",
-  "'+'", "'-'", "'*'", "'/'", "'%'", "SWQT_UMINUS", "\"reserved keyword\"",
-  "'('", "')'", "'='", "'<'", "'>'", "'!'", "','", "'.'", "$accept",
-  "input", "logical_expr", "value_expr_list", "field_value", "value_expr",
-  "type_def", "select_statement", "select_core", "opt_union_all",
-  "union_all", "select_field_list", "column_spec", "as_clause",
-  "opt_where", "opt_joins", "opt_order_by", "sort_spec_list", "sort_spec",
-  "string_or_identifier", "table_def", YY_NULL
+  "\"CAST\"", "\"UNION\"", "\"ALL\"", "\"LIMIT\"", "\"GROUP\"",
+  "SWQT_LOGICAL_START", "SWQT_VALUE_START", "SWQT_SELECT_START", "\"NOT\"",
+  "\"OR\"", "\"AND\"", "'+'", "'-'", "'*'", "'/'", "'%'", "SWQT_UMINUS",
+  "\"reserved keyword\"", "'('", "')'", "'='", "'<'", "'>'", "'!'", "','",
+  "'.'", "$accept", "input", "logical_expr", "value_expr_list",
+  "field_value", "value_expr", "type_def", "select_statement",
+  "select_core", "opt_union_all", "union_all", "select_field_list",
+  "column_spec", "as_clause", "opt_where", "opt_joins", "opt_group_by",
+  "group_spec_list", "group_spec", "opt_order_by", "sort_spec_list",
+  "sort_spec", "opt_limit", "string_or_identifier", "table_def", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_uint16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279,   280,   281,   282,   283,   284,
-     285,   286,   287,   288,    43,    45,    42,    47,    37,   289,
-     290,    40,    41,    61,    60,    62,    33,    44,    46
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF -170
+#define YYPACT_NINF (-129)
 
-#define yypact_value_is_default(Yystate) \
-  (!!((Yystate) == (-170)))
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF -1
+#define YYTABLE_NINF (-1)
 
-#define yytable_value_is_error(Yytable_value) \
+#define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-      72,   243,   260,    -8,    16,  -170,  -170,  -170,   -10,  -170,
-      -1,   243,   260,   243,    56,  -170,   181,   260,   290,   217,
-      23,  -170,    18,  -170,   260,    36,   260,    56,  -170,   -25,
-     165,   243,   243,    22,   260,   260,    -5,    54,   260,   260,
-     260,   260,   260,    62,   126,   149,    31,    44,    -9,    99,
-    -170,   144,    39,    29,    43,    65,  -170,    -8,    53,   252,
-    -170,   105,  -170,  -170,    87,  -170,   260,   268,   279,  -170,
-     112,    84,   260,   260,    75,    75,  -170,  -170,  -170,   260,
-     260,   290,   260,   260,   290,   260,   290,   260,   226,    -2,
-    -170,    79,     4,  -170,  -170,   103,  -170,  -170,   111,   217,
-      18,  -170,  -170,  -170,   260,   127,   114,   260,   260,  -170,
-     260,   273,   285,   290,   290,   290,   290,   290,   290,   151,
-     116,  -170,  -170,  -170,   115,   153,   121,  -170,  -170,  -170,
-     125,   120,  -170,   290,   290,   122,   260,   260,   128,     4,
-     103,  -170,   161,   111,   152,    69,  -170,  -170,   290,   290,
-       4,  -170,   177,   111,   168,   243,   169,   -20,     1,  -170,
-    -170,   178,   151,    56,   167,  -170,  -170,   191,  -170,   194,
-     151,   155,   151,   162,   163,   170,   151,   123,  -170,   159,
-    -170,  -170,   151,   121,  -170,  -170,   151,   121,  -170,  -170,
-    -170
+      84,   218,   253,     7,    11,  -129,  -129,  -129,   -27,  -129,
+      18,   218,   253,   218,   113,  -129,   156,   253,   273,   194,
+      52,  -129,    42,  -129,   253,    91,   253,   113,  -129,   -26,
+     134,   218,   218,    58,   253,   253,    -6,    95,   253,   253,
+     253,   253,   253,   114,    87,    26,    61,   248,    17,   150,
+    -129,   148,    89,    73,    99,   104,  -129,     7,   105,   234,
+    -129,   229,  -129,  -129,   100,  -129,   253,    19,   262,  -129,
+     141,   119,   253,   253,    88,    88,  -129,  -129,  -129,   253,
+     253,   273,   253,   253,   273,   253,   273,   253,   203,     8,
+    -129,   115,    90,  -129,  -129,   153,  -129,  -129,   170,   194,
+      42,  -129,  -129,  -129,   253,   171,   139,   253,   253,  -129,
+     253,    38,   268,   273,   273,   273,   273,   273,   273,   206,
+     169,  -129,  -129,  -129,   165,   210,   176,  -129,  -129,  -129,
+     174,   181,  -129,   273,   273,   182,   253,   253,   186,    90,
+     153,  -129,   205,   170,   217,    30,  -129,  -129,   273,   273,
+      90,  -129,   228,   170,   219,   218,   209,    37,    40,  -129,
+    -129,   222,   206,   113,   216,   224,  -129,   241,  -129,   242,
+     206,   202,   206,   230,   220,   208,   231,   215,   206,  -129,
+    -129,   204,   206,   251,  -129,  -129,  -129,   206,   176,   206,
+     188,  -129,   213,  -129,   176,  -129,  -129,  -129,  -129,   206,
+    -129,  -129
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
-static const yytype_uint8 yydefact[] =
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
 {
        0,     0,     0,     0,     0,    32,    33,    34,    30,    37,
        0,     0,     0,     0,     2,    35,     0,     0,     3,     0,
@@ -582,200 +713,202 @@ static const yytype_uint8 yydefact[] =
       31,     0,     8,    36,     6,     5,     0,    18,     0,    26,
        0,     0,     0,     0,    39,    40,    41,    42,    43,     0,
        0,     9,     0,     0,    12,     0,    13,     0,     0,     0,
-      60,    30,    59,    85,    84,     0,    63,    71,     0,     0,
+      60,    30,    59,    92,    91,     0,    63,    71,     0,     0,
       54,    56,    55,    44,     0,     0,     0,     0,     0,    27,
        0,    19,     0,    15,    16,    14,    10,    17,    11,     0,
-       0,    65,    62,    70,    85,    86,    74,    58,    52,    28,
+       0,    65,    62,    70,    92,    93,    74,    58,    52,    28,
       46,     0,    22,    20,    24,     0,     0,     0,     0,    66,
-       0,    87,     0,     0,    72,     0,    45,    23,    21,    25,
-      68,    67,    88,     0,     0,     0,    77,     0,     0,    69,
-      89,     0,     0,    73,     0,    53,    47,     0,    49,     0,
-       0,     0,     0,     0,     0,     0,     0,    81,    78,    80,
-      48,    50,     0,    74,    82,    83,     0,    74,    75,    79,
-      76
+       0,    94,     0,     0,    72,     0,    45,    23,    21,    25,
+      68,    67,    95,     0,     0,     0,    77,     0,     0,    69,
+      96,     0,     0,    73,     0,    82,    47,     0,    49,     0,
+       0,     0,     0,     0,    89,     0,     0,     0,     0,    81,
+      78,    80,     0,     0,    53,    48,    50,     0,    74,     0,
+      86,    83,    85,    90,    74,    75,    79,    87,    88,     0,
+      76,    84
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
+/* YYPGOTO[NTERM-NUM].  */
 static const yytype_int16 yypgoto[] =
 {
-    -170,  -170,   -11,   -63,   -48,    11,  -170,   157,   213,   134,
-    -170,   136,  -170,   -81,  -170,  -169,  -170,    50,  -170,   -83,
-    -124
+    -129,  -129,   -10,   -56,   -49,     0,  -129,   223,   243,   177,
+    -129,   180,  -129,   -86,  -129,   -94,  -129,    92,  -129,  -129,
+      77,  -129,  -129,   -91,  -128
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
-static const yytype_int16 yydefgoto[] =
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_uint8 yydefgoto[] =
 {
-      -1,     4,    14,    58,    15,    16,   131,    21,    22,    56,
-      57,    52,    53,    96,   156,   144,   165,   178,   179,    97,
-     126
+       0,     4,    14,    58,    15,    16,   131,    21,    22,    56,
+      57,    52,    53,    96,   156,   144,   165,   180,   181,   174,
+     191,   192,   184,    97,   126
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_uint8 yytable[] =
 {
-      27,    92,    29,   106,    60,    19,    69,    31,    32,    93,
-      94,   122,   123,    18,   188,   125,    23,    62,   190,   154,
-      64,    65,   166,    28,    30,    95,    70,   167,    47,   161,
-      51,    24,    88,    20,   121,    59,    19,    61,    25,    89,
-      26,   129,    60,   168,    55,    67,    68,   135,   169,    74,
-      75,    76,    77,    78,    81,    84,    86,   152,   151,    98,
-     125,    71,    72,    66,    73,     5,     6,     7,     8,   159,
-     125,   138,   157,     9,    87,   158,    99,    59,    38,    39,
-      40,    41,    42,   111,   112,   100,    63,    10,    31,    32,
-     113,   114,   101,   115,   116,   103,   117,    12,   118,    59,
-       1,     2,     3,    17,    90,    91,    79,    80,    93,    94,
-      51,    40,    41,    42,   171,    59,   124,    94,   133,   134,
-      32,    59,   175,   109,   177,   110,   105,    25,   183,     5,
-       6,     7,     8,   130,   187,   142,   143,     9,   177,    38,
-      39,    40,    41,    42,   163,   184,   185,   148,   149,    93,
-      94,    10,     5,     6,     7,     8,   132,    91,   139,   141,
-       9,    12,   146,   140,   147,    95,   145,    17,   155,    82,
-     150,    83,    33,    34,    10,    35,   153,    36,    38,    39,
-      40,    41,    42,   160,    12,   162,   172,   164,    33,    34,
-      17,    35,    85,    36,   173,   170,    37,   174,   176,    38,
-      39,    40,    41,    42,   180,   181,   186,    63,    43,    44,
-      45,    46,    37,   182,   102,    38,    39,    40,    41,    42,
-       5,     6,     7,    48,    43,    44,    45,    46,     9,     5,
-       6,     7,     8,    54,   128,   127,   189,     9,     0,     0,
-       0,    49,    10,     0,     0,     0,     5,     6,     7,     8,
-     119,    10,    12,    50,     9,     0,     0,     0,    17,     0,
-       0,    12,   120,     5,     6,     7,     8,    17,    10,     0,
-       0,     9,     0,     0,    11,     0,     0,   107,    12,     0,
-       0,     0,   136,     0,    13,    10,    38,    39,    40,    41,
-      42,     0,     0,     0,     0,    12,     0,     0,     0,   104,
-       0,    17,    38,    39,    40,    41,    42,    38,    39,    40,
-      41,    42,   108,    38,    39,    40,    41,    42,   137,    38,
-      39,    40,    41,    42,    38,    39,    40,    41,    42
+      92,    27,    18,    29,   123,    69,   122,   125,    31,    32,
+     106,    23,    28,    30,    60,   154,    24,    47,    62,    51,
+      19,    64,    65,    25,    59,   161,    61,    70,   107,     5,
+       6,     7,     8,   157,    67,    68,   158,     9,    74,    75,
+      76,    77,    78,    81,    84,    86,   121,   136,   129,   152,
+      20,    10,   125,   151,   135,    38,    39,    40,    41,    42,
+      88,    26,   125,    12,   159,    19,    59,    89,    55,    17,
+     138,    85,   111,   112,    38,    39,    40,    41,    42,   113,
+     114,   166,   115,   116,   168,   117,   167,   118,    59,   169,
+       5,     6,     7,     8,   195,    93,    94,    60,     9,    51,
+     200,    66,    71,    72,    59,    73,    87,   133,   134,    98,
+      59,    95,    10,   171,     1,     2,     3,     5,     6,     7,
+       8,   177,    99,   179,    12,     9,    40,    41,    42,   188,
+      17,   101,    82,   190,    83,    32,   148,   149,   194,    10,
+     179,    33,    34,   100,    35,   163,    36,    31,    32,   103,
+     190,    12,   109,    93,    94,    90,    91,    17,    93,    94,
+      79,    80,   110,    33,    34,    25,    35,    37,    36,    95,
+      38,    39,    40,    41,    42,   124,    94,   130,    63,    43,
+      44,    45,    46,   132,    38,    39,    40,    41,    42,    37,
+     142,   143,    38,    39,    40,    41,    42,     5,     6,     7,
+      48,    43,    44,    45,    46,     9,     5,     6,     7,     8,
+     197,   198,    91,   139,     9,   140,   141,   145,    49,    10,
+     153,     5,     6,     7,     8,   146,   147,   119,    10,     9,
+     150,    12,    50,   155,   160,   172,   162,    17,   164,   170,
+      12,   120,   173,    10,   175,   176,    17,   178,   183,   182,
+     105,    11,   185,   189,   193,    12,     5,     6,     7,     8,
+     187,    13,   199,    54,     9,    38,    39,    40,    41,    42,
+      38,    39,    40,    41,    42,   186,   201,   128,    10,   127,
+     102,   196,     0,   104,    38,    39,    40,    41,    42,     0,
+      12,     0,    63,     0,     0,     0,    17,   108,    38,    39,
+      40,    41,    42,   137,    38,    39,    40,    41,    42,    38,
+      39,    40,    41,    42
 };
 
 static const yytype_int16 yycheck[] =
 {
-      11,    49,    13,    66,     6,    13,    11,    32,    33,     5,
-       6,    92,    95,     2,   183,    98,     0,    42,   187,   143,
-      31,    32,    42,    12,    13,    21,    31,    47,    17,   153,
-      19,    41,    41,    41,    36,    24,    13,    26,    48,    48,
-      41,   104,     6,    42,    26,    34,    35,   110,    47,    38,
-      39,    40,    41,    42,    43,    44,    45,   140,   139,    20,
-     143,     7,     8,    41,    10,     3,     4,     5,     6,   150,
-     153,   119,     3,    11,    43,     6,    47,    66,    34,    35,
-      36,    37,    38,    72,    73,    42,    42,    25,    32,    33,
-      79,    80,    27,    82,    83,    42,    85,    35,    87,    88,
-      28,    29,    30,    41,     5,     6,    44,    45,     5,     6,
-      99,    36,    37,    38,   162,   104,     5,     6,   107,   108,
-      33,   110,   170,    11,   172,    41,    21,    48,   176,     3,
-       4,     5,     6,     6,   182,    14,    15,    11,   186,    34,
-      35,    36,    37,    38,   155,    22,    23,   136,   137,     5,
-       6,    25,     3,     4,     5,     6,    42,     6,    42,     6,
-      11,    35,    42,    48,    42,    21,    41,    41,    16,    43,
-      42,    45,     7,     8,    25,    10,    15,    12,    34,    35,
-      36,    37,    38,     6,    35,    17,    19,    18,     7,     8,
-      41,    10,    43,    12,     3,    17,    31,     3,    43,    34,
-      35,    36,    37,    38,    42,    42,    47,    42,    43,    44,
-      45,    46,    31,    43,    57,    34,    35,    36,    37,    38,
-       3,     4,     5,     6,    43,    44,    45,    46,    11,     3,
-       4,     5,     6,    20,   100,    99,   186,    11,    -1,    -1,
-      -1,    24,    25,    -1,    -1,    -1,     3,     4,     5,     6,
-      24,    25,    35,    36,    11,    -1,    -1,    -1,    41,    -1,
-      -1,    35,    36,     3,     4,     5,     6,    41,    25,    -1,
-      -1,    11,    -1,    -1,    31,    -1,    -1,     9,    35,    -1,
-      -1,    -1,     9,    -1,    41,    25,    34,    35,    36,    37,
-      38,    -1,    -1,    -1,    -1,    35,    -1,    -1,    -1,    47,
-      -1,    41,    34,    35,    36,    37,    38,    34,    35,    36,
-      37,    38,    33,    34,    35,    36,    37,    38,    33,    34,
-      35,    36,    37,    38,    34,    35,    36,    37,    38
+      49,    11,     2,    13,    95,    11,    92,    98,    34,    35,
+      66,     0,    12,    13,     6,   143,    43,    17,    44,    19,
+      13,    31,    32,    50,    24,   153,    26,    33,     9,     3,
+       4,     5,     6,     3,    34,    35,     6,    11,    38,    39,
+      40,    41,    42,    43,    44,    45,    38,     9,   104,   140,
+      43,    25,   143,   139,   110,    36,    37,    38,    39,    40,
+      43,    43,   153,    37,   150,    13,    66,    50,    26,    43,
+     119,    45,    72,    73,    36,    37,    38,    39,    40,    79,
+      80,    44,    82,    83,    44,    85,    49,    87,    88,    49,
+       3,     4,     5,     6,   188,     5,     6,     6,    11,    99,
+     194,    43,     7,     8,   104,    10,    45,   107,   108,    20,
+     110,    21,    25,   162,    30,    31,    32,     3,     4,     5,
+       6,   170,    49,   172,    37,    11,    38,    39,    40,   178,
+      43,    27,    45,   182,    47,    35,   136,   137,   187,    25,
+     189,     7,     8,    44,    10,   155,    12,    34,    35,    44,
+     199,    37,    11,     5,     6,     5,     6,    43,     5,     6,
+      46,    47,    43,     7,     8,    50,    10,    33,    12,    21,
+      36,    37,    38,    39,    40,     5,     6,     6,    44,    45,
+      46,    47,    48,    44,    36,    37,    38,    39,    40,    33,
+      14,    15,    36,    37,    38,    39,    40,     3,     4,     5,
+       6,    45,    46,    47,    48,    11,     3,     4,     5,     6,
+      22,    23,     6,    44,    11,    50,     6,    43,    24,    25,
+      15,     3,     4,     5,     6,    44,    44,    24,    25,    11,
+      44,    37,    38,    16,     6,    19,    17,    43,    29,    17,
+      37,    38,    18,    25,     3,     3,    43,    45,    28,    19,
+      21,    33,    44,    49,     3,    37,     3,     4,     5,     6,
+      45,    43,    49,    20,    11,    36,    37,    38,    39,    40,
+      36,    37,    38,    39,    40,    44,   199,   100,    25,    99,
+      57,   189,    -1,    49,    36,    37,    38,    39,    40,    -1,
+      37,    -1,    44,    -1,    -1,    -1,    43,    35,    36,    37,
+      38,    39,    40,    35,    36,    37,    38,    39,    40,    36,
+      37,    38,    39,    40
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
-static const yytype_uint8 yystos[] =
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
 {
-       0,    28,    29,    30,    50,     3,     4,     5,     6,    11,
-      25,    31,    35,    41,    51,    53,    54,    41,    54,    13,
-      41,    56,    57,     0,    41,    48,    41,    51,    54,    51,
-      54,    32,    33,     7,     8,    10,    12,    31,    34,    35,
-      36,    37,    38,    43,    44,    45,    46,    54,     6,    24,
-      36,    54,    60,    61,    57,    26,    58,    59,    52,    54,
-       6,    54,    42,    42,    51,    51,    41,    54,    54,    11,
-      31,     7,     8,    10,    54,    54,    54,    54,    54,    44,
-      45,    54,    43,    45,    54,    43,    54,    43,    41,    48,
-       5,     6,    53,     5,     6,    21,    62,    68,    20,    47,
-      42,    27,    56,    42,    47,    21,    52,     9,    33,    11,
-      41,    54,    54,    54,    54,    54,    54,    54,    54,    24,
-      36,    36,    62,    68,     5,    68,    69,    60,    58,    52,
-       6,    55,    42,    54,    54,    52,     9,    33,    53,    42,
-      48,     6,    14,    15,    64,    41,    42,    42,    54,    54,
-      42,    62,    68,    15,    69,    16,    63,     3,     6,    62,
-       6,    69,    17,    51,    18,    65,    42,    47,    42,    47,
-      17,    53,    19,     3,     3,    53,    43,    53,    66,    67,
-      42,    42,    43,    53,    22,    23,    47,    53,    64,    66,
-      64
+       0,    30,    31,    32,    52,     3,     4,     5,     6,    11,
+      25,    33,    37,    43,    53,    55,    56,    43,    56,    13,
+      43,    58,    59,     0,    43,    50,    43,    53,    56,    53,
+      56,    34,    35,     7,     8,    10,    12,    33,    36,    37,
+      38,    39,    40,    45,    46,    47,    48,    56,     6,    24,
+      38,    56,    62,    63,    59,    26,    60,    61,    54,    56,
+       6,    56,    44,    44,    53,    53,    43,    56,    56,    11,
+      33,     7,     8,    10,    56,    56,    56,    56,    56,    46,
+      47,    56,    45,    47,    56,    45,    56,    45,    43,    50,
+       5,     6,    55,     5,     6,    21,    64,    74,    20,    49,
+      44,    27,    58,    44,    49,    21,    54,     9,    35,    11,
+      43,    56,    56,    56,    56,    56,    56,    56,    56,    24,
+      38,    38,    64,    74,     5,    74,    75,    62,    60,    54,
+       6,    57,    44,    56,    56,    54,     9,    35,    55,    44,
+      50,     6,    14,    15,    66,    43,    44,    44,    56,    56,
+      44,    64,    74,    15,    75,    16,    65,     3,     6,    64,
+       6,    75,    17,    53,    29,    67,    44,    49,    44,    49,
+      17,    55,    19,    18,    70,     3,     3,    55,    45,    55,
+      68,    69,    19,    28,    73,    44,    44,    45,    55,    49,
+      55,    71,    72,     3,    55,    66,    68,    22,    23,    49,
+      66,    71
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
-static const yytype_uint8 yyr1[] =
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
 {
-       0,    49,    50,    50,    50,    51,    51,    51,    51,    51,
-      51,    51,    51,    51,    51,    51,    51,    51,    51,    51,
-      51,    51,    51,    51,    51,    51,    51,    51,    52,    52,
-      53,    53,    54,    54,    54,    54,    54,    54,    54,    54,
-      54,    54,    54,    54,    54,    54,    55,    55,    55,    55,
-      55,    56,    56,    57,    58,    58,    59,    60,    60,    61,
-      61,    61,    61,    61,    61,    61,    61,    61,    61,    61,
-      62,    62,    63,    63,    64,    64,    64,    65,    65,    66,
-      66,    67,    67,    67,    68,    68,    69,    69,    69,    69
+       0,    51,    52,    52,    52,    53,    53,    53,    53,    53,
+      53,    53,    53,    53,    53,    53,    53,    53,    53,    53,
+      53,    53,    53,    53,    53,    53,    53,    53,    54,    54,
+      55,    55,    56,    56,    56,    56,    56,    56,    56,    56,
+      56,    56,    56,    56,    56,    56,    57,    57,    57,    57,
+      57,    58,    58,    59,    60,    60,    61,    62,    62,    63,
+      63,    63,    63,    63,    63,    63,    63,    63,    63,    63,
+      64,    64,    65,    65,    66,    66,    66,    67,    67,    68,
+      68,    69,    70,    70,    71,    71,    72,    72,    72,    73,
+      73,    74,    74,    75,    75,    75,    75
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
-static const yytype_uint8 yyr2[] =
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
 {
        0,     2,     2,     2,     2,     3,     3,     2,     3,     3,
        4,     4,     3,     3,     4,     4,     4,     4,     3,     4,
        5,     6,     5,     6,     5,     6,     3,     4,     3,     1,
        1,     3,     1,     1,     1,     1,     3,     1,     2,     3,
        3,     3,     3,     3,     4,     6,     1,     4,     6,     4,
-       6,     2,     4,     7,     0,     2,     2,     1,     3,     2,
+       6,     2,     4,     9,     0,     2,     2,     1,     3,     2,
        2,     1,     3,     2,     1,     3,     4,     5,     5,     6,
        2,     1,     0,     2,     0,     7,     8,     0,     3,     3,
-       1,     1,     2,     2,     1,     1,     1,     2,     3,     4
+       1,     1,     0,     3,     3,     1,     1,     2,     2,     0,
+       2,     1,     1,     1,     2,     3,     4
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
 #define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
 
-#define YYBACKUP(Token, Value)                                  \
-do                                                              \
-  if (yychar == YYEMPTY)                                        \
-    {                                                           \
-      yychar = (Token);                                         \
-      yylval = (Value);                                         \
-      YYPOPSTACK (yylen);                                       \
-      yystate = *yyssp;                                         \
-      goto yybackup;                                            \
-    }                                                           \
-  else                                                          \
-    {                                                           \
-      yyerror (context, YY_("syntax error: cannot back up")); \
-      YYERROR;                                                  \
-    }                                                           \
-while (0)
-
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (context, YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
 
 /* Enable debugging if requested.  */
@@ -792,56 +925,53 @@ do {                                            \
     YYFPRINTF Args;                             \
 } while (0)
 
-/* This macro is provided for backward compatibility. */
-#ifndef YY_LOCATION_PRINT
-# define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-#endif
 
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, context); \
+                  Kind, Value, context); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
 
 
-/*----------------------------------------.
-| Print this symbol's value on YYOUTPUT.  |
-`----------------------------------------*/
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, swq_parse_context *context)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, swq_parse_context *context)
 {
-  FILE *yyo = yyoutput;
-  YYUSE (yyo);
-  YYUSE (context);
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  YY_USE (context);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyoutput, yytoknum[yytype], *yyvaluep);
-# endif
-  YYUSE (yytype);
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, swq_parse_context *context)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, swq_parse_context *context)
 {
-  YYFPRINTF (yyoutput, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep, context);
-  YYFPRINTF (yyoutput, ")");
+  yy_symbol_value_print (yyo, yykind, yyvaluep, context);
+  YYFPRINTF (yyo, ")");
 }
 
 /*------------------------------------------------------------------.
@@ -850,7 +980,7 @@ yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, swq
 `------------------------------------------------------------------*/
 
 static void
-yy_stack_print (yytype_int16 *yybottom, yytype_int16 *yytop)
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
 {
   YYFPRINTF (stderr, "Stack now");
   for (; yybottom <= yytop; yybottom++)
@@ -873,21 +1003,21 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, int yyrule, swq_parse_context *context)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule, swq_parse_context *context)
 {
-  unsigned long int yylno = yyrline[yyrule];
+  int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
   int yyi;
-  YYFPRINTF (stderr, "Reducing stack by rule %d (line %lu):\n",
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
              yyrule - 1, yylno);
   /* The symbols being reduced.  */
   for (yyi = 0; yyi < yynrhs; yyi++)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[yyssp[yyi + 1 - yynrhs]],
-                       &(yyvsp[(yyi + 1) - (yynrhs)])
-                                              , context);
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)], context);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -902,8 +1032,8 @@ do {                                    \
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
@@ -926,28 +1056,76 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
+/* Context of a parse error.  */
+typedef struct
+{
+  yy_state_t *yyssp;
+  yysymbol_kind_t yytoken;
+} yypcontext_t;
+
+/* Put in YYARG at most YYARGN of the expected tokens given the
+   current YYCTX, and return the number of tokens stored in YYARG.  If
+   YYARG is null, return the number of expected tokens (guaranteed to
+   be less than YYNTOKENS).  Return YYENOMEM on memory exhaustion.
+   Return 0 if there are more than YYARGN expected tokens, yet fill
+   YYARG up to YYARGN. */
+static int
+yypcontext_expected_tokens (const yypcontext_t *yyctx,
+                            yysymbol_kind_t yyarg[], int yyargn)
+{
+  /* Actual size of YYARG. */
+  int yycount = 0;
+  int yyn = yypact[+*yyctx->yyssp];
+  if (!yypact_value_is_default (yyn))
+    {
+      /* Start YYX at -YYN if negative to avoid negative indexes in
+         YYCHECK.  In other words, skip the first -YYN actions for
+         this state because they are default actions.  */
+      int yyxbegin = yyn < 0 ? -yyn : 0;
+      /* Stay within bounds of both yycheck and yytname.  */
+      int yychecklim = YYLAST - yyn + 1;
+      int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
+      int yyx;
+      for (yyx = yyxbegin; yyx < yyxend; ++yyx)
+        if (yycheck[yyx + yyn] == yyx && yyx != YYSYMBOL_YYerror
+            && !yytable_value_is_error (yytable[yyx + yyn]))
+          {
+            if (!yyarg)
+              ++yycount;
+            else if (yycount == yyargn)
+              return 0;
+            else
+              yyarg[yycount++] = YY_CAST (yysymbol_kind_t, yyx);
+          }
+    }
+  if (yyarg && yycount == 0 && 0 < yyargn)
+    yyarg[0] = YYSYMBOL_YYEMPTY;
+  return yycount;
+}
+
+
 
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen strlen
-#  else
+
+#ifndef yystrlen
+# if defined __GLIBC__ && defined _STRING_H
+#  define yystrlen(S) (YY_CAST (YYPTRDIFF_T, strlen (S)))
+# else
 /* Return the length of YYSTR.  */
-static YYSIZE_T
+static YYPTRDIFF_T
 yystrlen (const char *yystr)
 {
-  YYSIZE_T yylen;
+  YYPTRDIFF_T yylen;
   for (yylen = 0; yystr[yylen]; yylen++)
     continue;
   return yylen;
 }
-#  endif
 # endif
+#endif
 
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
+#ifndef yystpcpy
+# if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
+#  define yystpcpy stpcpy
+# else
 /* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
    YYDEST.  */
 static char *
@@ -961,10 +1139,10 @@ yystpcpy (char *yydest, const char *yysrc)
 
   return yyd - 1;
 }
-#  endif
 # endif
+#endif
 
-# ifndef yytnamerr
+#ifndef yytnamerr
 /* Copy to YYRES the contents of YYSTR after stripping away unnecessary
    quotes and backslashes, so that it's suitable for yyerror.  The
    heuristic is that double-quoting is unnecessary unless the string
@@ -972,14 +1150,13 @@ yystpcpy (char *yydest, const char *yysrc)
    backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
    null, do not copy; instead, return the length of what the result
    would have been.  */
-static YYSIZE_T
+static YYPTRDIFF_T
 yytnamerr (char *yyres, const char *yystr)
 {
   if (*yystr == '"')
     {
-      YYSIZE_T yyn = 0;
+      YYPTRDIFF_T yyn = 0;
       char const *yyp = yystr;
-
       for (;;)
         switch (*++yyp)
           {
@@ -990,7 +1167,10 @@ yytnamerr (char *yyres, const char *yystr)
           case '\\':
             if (*++yyp != '\\')
               goto do_not_strip_quotes;
-            /* Fall through.  */
+            else
+              goto append;
+
+          append:
           default:
             if (yyres)
               yyres[yyn] = *yyp;
@@ -1005,36 +1185,20 @@ yytnamerr (char *yyres, const char *yystr)
     do_not_strip_quotes: ;
     }
 
-  if (! yyres)
+  if (yyres)
+    return yystpcpy (yyres, yystr) - yyres;
+  else
     return yystrlen (yystr);
-
-  return yystpcpy (yyres, yystr) - yyres;
 }
-# endif
+#endif
 
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
 
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
 static int
-yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
-                yytype_int16 *yyssp, int yytoken)
+yy_syntax_error_arguments (const yypcontext_t *yyctx,
+                           yysymbol_kind_t yyarg[], int yyargn)
 {
-  YYSIZE_T yysize0 = yytnamerr (YY_NULL, yytname[yytoken]);
-  YYSIZE_T yysize = yysize0;
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULL;
-  /* Arguments of yyformat. */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Number of reported tokens (one for the "unexpected", one per
-     "expected"). */
+  /* Actual size of YYARG. */
   int yycount = 0;
-
   /* There are many possibilities here to consider:
      - If this state is a consistent state with a default action, then
        the only way this function was invoked is if the default action
@@ -1058,63 +1222,78 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
        one exception: it will still contain any token that will not be
        accepted due to an error action in a later state.
   */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[*yyssp];
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYSIZE_T yysize1 = yysize + yytnamerr (YY_NULL, yytname[yyx]);
-                  if (! (yysize <= yysize1
-                         && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-                    return 2;
-                  yysize = yysize1;
-                }
-              }
-        }
+  if (yyctx->yytoken != YYSYMBOL_YYEMPTY)
+    {
+      int yyn;
+      if (yyarg)
+        yyarg[yycount] = yyctx->yytoken;
+      ++yycount;
+      yyn = yypcontext_expected_tokens (yyctx,
+                                        yyarg ? yyarg + 1 : yyarg, yyargn - 1);
+      if (yyn == YYENOMEM)
+        return YYENOMEM;
+      else
+        yycount += yyn;
     }
+  return yycount;
+}
+
+/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
+   about the unexpected token YYTOKEN for the state stack whose top is
+   YYSSP.
+
+   Return 0 if *YYMSG was successfully written.  Return -1 if *YYMSG is
+   not large enough to hold the message.  In that case, also set
+   *YYMSG_ALLOC to the required number of bytes.  Return YYENOMEM if the
+   required number of bytes is too large to store.  */
+static int
+yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
+                const yypcontext_t *yyctx)
+{
+  enum { YYARGS_MAX = 5 };
+  /* Internationalized format string. */
+  const char *yyformat = YY_NULLPTR;
+  /* Arguments of yyformat: reported tokens (one for the "unexpected",
+     one per "expected"). */
+  yysymbol_kind_t yyarg[YYARGS_MAX];
+  /* Cumulated lengths of YYARG.  */
+  YYPTRDIFF_T yysize = 0;
+
+  /* Actual size of YYARG. */
+  int yycount = yy_syntax_error_arguments (yyctx, yyarg, YYARGS_MAX);
+  if (yycount == YYENOMEM)
+    return YYENOMEM;
 
   switch (yycount)
     {
-# define YYCASE_(N, S)                      \
+#define YYCASE_(N, S)                       \
       case N:                               \
         yyformat = S;                       \
-      break
+        break
+    default: /* Avoid compiler warnings. */
       YYCASE_(0, YY_("syntax error"));
       YYCASE_(1, YY_("syntax error, unexpected %s"));
       YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
       YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
       YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
       YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
+#undef YYCASE_
     }
 
+  /* Compute error message size.  Don't count the "%s"s, but reserve
+     room for the terminator.  */
+  yysize = yystrlen (yyformat) - 2 * yycount + 1;
   {
-    YYSIZE_T yysize1 = yysize + yystrlen (yyformat);
-    if (! (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-      return 2;
-    yysize = yysize1;
+    int yyi;
+    for (yyi = 0; yyi < yycount; ++yyi)
+      {
+        YYPTRDIFF_T yysize1
+          = yysize + yytnamerr (YY_NULLPTR, yytname[yyarg[yyi]]);
+        if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
+          yysize = yysize1;
+        else
+          return YYENOMEM;
+      }
   }
 
   if (*yymsg_alloc < yysize)
@@ -1123,7 +1302,7 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
       if (! (yysize <= *yymsg_alloc
              && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
         *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
+      return -1;
     }
 
   /* Avoid sprintf, as that infringes on the user's name space.
@@ -1135,102 +1314,102 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
     while ((*yyp = *yyformat) != '\0')
       if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
         {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
+          yyp += yytnamerr (yyp, yytname[yyarg[yyi++]]);
           yyformat += 2;
         }
       else
         {
-          yyp++;
-          yyformat++;
+          ++yyp;
+          ++yyformat;
         }
   }
   return 0;
 }
-#endif /* YYERROR_VERBOSE */
+
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, swq_parse_context *context)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, swq_parse_context *context)
 {
-  YYUSE (yyvaluep);
-  YYUSE (context);
+  YY_USE (yyvaluep);
+  YY_USE (context);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  switch (yytype)
+  switch (yykind)
     {
-          case 3: /* "integer number"  */
-#line 105 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1170 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_SWQT_INTEGER_NUMBER: /* "integer number"  */
+#line 107 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1350 "swq_parser.cpp"
         break;
 
-    case 4: /* "floating point number"  */
-#line 105 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1176 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_SWQT_FLOAT_NUMBER: /* "floating point number"  */
+#line 107 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1356 "swq_parser.cpp"
         break;
 
-    case 5: /* "string"  */
-#line 105 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1182 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_SWQT_STRING: /* "string"  */
+#line 107 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1362 "swq_parser.cpp"
         break;
 
-    case 6: /* "identifier"  */
-#line 105 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1188 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_SWQT_IDENTIFIER: /* "identifier"  */
+#line 107 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1368 "swq_parser.cpp"
         break;
 
-    case 51: /* logical_expr  */
-#line 106 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1194 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_logical_expr: /* logical_expr  */
+#line 108 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1374 "swq_parser.cpp"
         break;
 
-    case 52: /* value_expr_list  */
-#line 106 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1200 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_value_expr_list: /* value_expr_list  */
+#line 108 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1380 "swq_parser.cpp"
         break;
 
-    case 53: /* field_value  */
-#line 106 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1206 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_field_value: /* field_value  */
+#line 108 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1386 "swq_parser.cpp"
         break;
 
-    case 54: /* value_expr  */
-#line 106 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1212 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_value_expr: /* value_expr  */
+#line 108 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1392 "swq_parser.cpp"
         break;
 
-    case 55: /* type_def  */
-#line 106 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1218 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_type_def: /* type_def  */
+#line 108 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1398 "swq_parser.cpp"
         break;
 
-    case 68: /* string_or_identifier  */
-#line 106 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1224 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_string_or_identifier: /* string_or_identifier  */
+#line 108 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1404 "swq_parser.cpp"
         break;
 
-    case 69: /* table_def  */
-#line 106 "swq_parser.y" /* yacc.c:1257  */
-      { delete ((*yyvaluep)); }
-#line 1230 "swq_parser.cpp" /* yacc.c:1257  */
+    case YYSYMBOL_table_def: /* table_def  */
+#line 108 "swq_parser.y"
+            { delete (*yyvaluep); }
+#line 1410 "swq_parser.cpp"
         break;
 
-
       default:
         break;
     }
@@ -1240,6 +1419,8 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, swq_parse_context
 
 
 
+
+
 /*----------.
 | yyparse.  |
 `----------*/
@@ -1247,7 +1428,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, swq_parse_context
 int
 yyparse (swq_parse_context *context)
 {
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 
@@ -1258,45 +1439,41 @@ YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
 YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
 
     /* Number of syntax errors so far.  */
-    int yynerrs;
+    int yynerrs = 0;
 
-    int yystate;
+    yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
-
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
+    int yyerrstatus = 0;
 
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
-    yytype_int16 yyssa[YYINITDEPTH]; /* workaround bug with gcc 4.1 -O2 */ memset(yyssa, 0, sizeof(yyssa));
-    yytype_int16 *yyss;
-    yytype_int16 *yyssp;
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
 
-    /* The semantic value stack.  */
-    YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH]; /* workaround bug with gcc 4.1 -O2 */ memset(yyssa, 0, sizeof(yyssa));
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    YYSIZE_T yystacksize;
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
-#if YYERROR_VERBOSE
   /* Buffer for error messages, and its allocated size.  */
   char yymsgbuf[128];
   char *yymsg = yymsgbuf;
-  YYSIZE_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+  YYPTRDIFF_T yymsg_alloc = sizeof yymsgbuf;
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1304,71 +1481,75 @@ YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
+
   goto yysetstate;
 
+
 /*------------------------------------------------------------.
-| yynewstate -- Push a new state, which is found in yystate.  |
+| yynewstate -- push a new state, which is found in yystate.  |
 `------------------------------------------------------------*/
- yynewstate:
+yynewstate:
   /* In all cases, when you get here, the value and location stacks
      have just been pushed.  So pushing a state here evens the stacks.  */
   yyssp++;
 
- yysetstate:
-  *yyssp = yystate;
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
     {
       /* Get the current used size of the three stacks, in elements.  */
-      YYSIZE_T yysize = yyssp - yyss + 1;
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
 
-#ifdef yyoverflow
+# if defined yyoverflow
       {
         /* Give user a chance to reallocate the stack.  Use copies of
            these so that the &'s don't force the real ones into
            memory.  */
+        yy_state_t *yyss1 = yyss;
         YYSTYPE *yyvs1 = yyvs;
-        yytype_int16 *yyss1 = yyss;
 
         /* Each stack pointer address is followed by the size of the
            data in use in that stack, in bytes.  This used to be a
            conditional around just the two extra args, but that might
            be undefined if yyoverflow is a macro.  */
         yyoverflow (YY_("memory exhausted"),
-                    &yyss1, yysize * sizeof (*yyssp),
-                    &yyvs1, yysize * sizeof (*yyvsp),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
                     &yystacksize);
-
         yyss = yyss1;
         yyvs = yyvs1;
       }
-#else /* no yyoverflow */
-# ifndef YYSTACK_RELOCATE
-      goto yyexhaustedlab;
-# else
+# else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
 
       {
-        yytype_int16 *yyss1 = yyss;
+        yy_state_t *yyss1 = yyss;
         union yyalloc *yyptr =
-          (union yyalloc *) YYSTACK_ALLOC (YYSTACK_BYTES (yystacksize));
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
 #  undef YYSTACK_RELOCATE
@@ -1376,30 +1557,31 @@ YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
           YYSTACK_FREE (yyss1);
       }
 # endif
-#endif /* no yyoverflow */
 
       yyssp = yyss + yysize - 1;
       yyvsp = yyvs + yysize - 1;
 
-      YYDPRINTF ((stderr, "Stack size increased to %lu\n",
-                  (unsigned long int) yystacksize));
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
 
       if (yyss + yystacksize - 1 <= yyssp)
         YYABORT;
     }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
-  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
 
   if (yystate == YYFINAL)
     YYACCEPT;
 
   goto yybackup;
 
+
 /*-----------.
 | yybackup.  |
 `-----------*/
 yybackup:
-
   /* Do appropriate processing given the current state.  Read a
      lookahead token if we need one and don't already have one.  */
 
@@ -1410,18 +1592,29 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
+      YYDPRINTF ((stderr, "Reading a token\n"));
       yychar = yylex (&yylval, context);
     }
 
-  if (yychar <= YYEOF)
+  if (yychar <= END)
     {
-      yychar = yytoken = YYEOF;
+      yychar = END;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1449,15 +1642,13 @@ yybackup:
 
   /* Shift the lookahead token.  */
   YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
-
-  /* Discard the shifted token.  */
-  yychar = YYEMPTY;
-
   yystate = yyn;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
   goto yynewstate;
 
 
@@ -1472,7 +1663,7 @@ yydefault:
 
 
 /*-----------------------------.
-| yyreduce -- Do a reduction.  |
+| yyreduce -- do a reduction.  |
 `-----------------------------*/
 yyreduce:
   /* yyn is the number of a rule to reduce with.  */
@@ -1492,668 +1683,668 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-        case 2:
-#line 112 "swq_parser.y" /* yacc.c:1646  */
-    {
-            context->poRoot = (yyvsp[0]);
+  case 2: /* input: SWQT_LOGICAL_START logical_expr  */
+#line 114 "swq_parser.y"
+        {
+            context->poRoot = yyvsp[0];
         }
-#line 1500 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1691 "swq_parser.cpp"
     break;
 
-  case 3:
-#line 117 "swq_parser.y" /* yacc.c:1646  */
-    {
-            context->poRoot = (yyvsp[0]);
+  case 3: /* input: SWQT_VALUE_START value_expr  */
+#line 119 "swq_parser.y"
+        {
+            context->poRoot = yyvsp[0];
         }
-#line 1508 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1699 "swq_parser.cpp"
     break;
 
-  case 4:
-#line 122 "swq_parser.y" /* yacc.c:1646  */
-    {
-            context->poRoot = (yyvsp[0]);
+  case 4: /* input: SWQT_SELECT_START select_statement  */
+#line 124 "swq_parser.y"
+        {
+            context->poRoot = yyvsp[0];
         }
-#line 1516 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1707 "swq_parser.cpp"
     break;
 
-  case 5:
-#line 128 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_AND );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 5: /* logical_expr: logical_expr "AND" logical_expr  */
+#line 130 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_AND );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1527 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1718 "swq_parser.cpp"
     break;
 
-  case 6:
-#line 136 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_OR );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 6: /* logical_expr: logical_expr "OR" logical_expr  */
+#line 138 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_OR );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1538 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1729 "swq_parser.cpp"
     break;
 
-  case 7:
-#line 144 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_NOT );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 7: /* logical_expr: "NOT" logical_expr  */
+#line 146 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_NOT );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1548 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1739 "swq_parser.cpp"
     break;
 
-  case 8:
-#line 151 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[-1]);
+  case 8: /* logical_expr: '(' logical_expr ')'  */
+#line 153 "swq_parser.y"
+        {
+            yyval = yyvsp[-1];
         }
-#line 1556 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1747 "swq_parser.cpp"
     break;
 
-  case 9:
-#line 156 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_EQ );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 9: /* logical_expr: value_expr '=' value_expr  */
+#line 158 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_EQ );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1567 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1758 "swq_parser.cpp"
     break;
 
-  case 10:
-#line 164 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_NE );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-3]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 10: /* logical_expr: value_expr '<' '>' value_expr  */
+#line 166 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_NE );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-3] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1578 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1769 "swq_parser.cpp"
     break;
 
-  case 11:
-#line 172 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_NE );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-3]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 11: /* logical_expr: value_expr '!' '=' value_expr  */
+#line 174 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_NE );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-3] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1589 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1780 "swq_parser.cpp"
     break;
 
-  case 12:
-#line 180 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_LT );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 12: /* logical_expr: value_expr '<' value_expr  */
+#line 182 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_LT );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1600 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1791 "swq_parser.cpp"
     break;
 
-  case 13:
-#line 188 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_GT );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 13: /* logical_expr: value_expr '>' value_expr  */
+#line 190 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_GT );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1611 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1802 "swq_parser.cpp"
     break;
 
-  case 14:
-#line 196 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_LE );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-3]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 14: /* logical_expr: value_expr '<' '=' value_expr  */
+#line 198 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_LE );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-3] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1622 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1813 "swq_parser.cpp"
     break;
 
-  case 15:
-#line 204 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_LE );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-3]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 15: /* logical_expr: value_expr '=' '<' value_expr  */
+#line 206 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_LE );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-3] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1633 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1824 "swq_parser.cpp"
     break;
 
-  case 16:
-#line 212 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_LE );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-3]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 16: /* logical_expr: value_expr '=' '>' value_expr  */
+#line 214 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_LE );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-3] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1644 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1835 "swq_parser.cpp"
     break;
 
-  case 17:
-#line 220 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_GE );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-3]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 17: /* logical_expr: value_expr '>' '=' value_expr  */
+#line 222 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_GE );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-3] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1655 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1846 "swq_parser.cpp"
     break;
 
-  case 18:
-#line 228 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_LIKE );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 18: /* logical_expr: value_expr "LIKE" value_expr  */
+#line 230 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_LIKE );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1666 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1857 "swq_parser.cpp"
     break;
 
-  case 19:
-#line 236 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 19: /* logical_expr: value_expr "NOT" "LIKE" value_expr  */
+#line 238 "swq_parser.y"
+        {
             swq_expr_node *like;
             like = new swq_expr_node( SWQ_LIKE );
             like->field_type = SWQ_BOOLEAN;
-            like->PushSubExpression( (yyvsp[-3]) );
-            like->PushSubExpression( (yyvsp[0]) );
+            like->PushSubExpression( yyvsp[-3] );
+            like->PushSubExpression( yyvsp[0] );
 
-            (yyval) = new swq_expr_node( SWQ_NOT );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( like );
+            yyval = new swq_expr_node( SWQ_NOT );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( like );
         }
-#line 1682 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1873 "swq_parser.cpp"
     break;
 
-  case 20:
-#line 249 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_LIKE );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-4]) );
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 20: /* logical_expr: value_expr "LIKE" value_expr "ESCAPE" value_expr  */
+#line 251 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_LIKE );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-4] );
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1694 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1885 "swq_parser.cpp"
     break;
 
-  case 21:
-#line 258 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 21: /* logical_expr: value_expr "NOT" "LIKE" value_expr "ESCAPE" value_expr  */
+#line 260 "swq_parser.y"
+        {
             swq_expr_node *like;
             like = new swq_expr_node( SWQ_LIKE );
             like->field_type = SWQ_BOOLEAN;
-            like->PushSubExpression( (yyvsp[-5]) );
-            like->PushSubExpression( (yyvsp[-2]) );
-            like->PushSubExpression( (yyvsp[0]) );
+            like->PushSubExpression( yyvsp[-5] );
+            like->PushSubExpression( yyvsp[-2] );
+            like->PushSubExpression( yyvsp[0] );
 
-            (yyval) = new swq_expr_node( SWQ_NOT );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( like );
+            yyval = new swq_expr_node( SWQ_NOT );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( like );
         }
-#line 1711 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1902 "swq_parser.cpp"
     break;
 
-  case 22:
-#line 272 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[-1]);
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->nOperation = SWQ_IN;
-            (yyval)->PushSubExpression( (yyvsp[-4]) );
-            (yyval)->ReverseSubExpressions();
+  case 22: /* logical_expr: value_expr "IN" '(' value_expr_list ')'  */
+#line 274 "swq_parser.y"
+        {
+            yyval = yyvsp[-1];
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->nOperation = SWQ_IN;
+            yyval->PushSubExpression( yyvsp[-4] );
+            yyval->ReverseSubExpressions();
         }
-#line 1723 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1914 "swq_parser.cpp"
     break;
 
-  case 23:
-#line 281 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 23: /* logical_expr: value_expr "NOT" "IN" '(' value_expr_list ')'  */
+#line 283 "swq_parser.y"
+        {
             swq_expr_node *in;
 
-            in = (yyvsp[-1]);
+            in = yyvsp[-1];
             in->field_type = SWQ_BOOLEAN;
             in->nOperation = SWQ_IN;
-            in->PushSubExpression( (yyvsp[-5]) );
+            in->PushSubExpression( yyvsp[-5] );
             in->ReverseSubExpressions();
             
-            (yyval) = new swq_expr_node( SWQ_NOT );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( in );
+            yyval = new swq_expr_node( SWQ_NOT );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( in );
         }
-#line 1741 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1932 "swq_parser.cpp"
     break;
 
-  case 24:
-#line 296 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_BETWEEN );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-4]) );
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 24: /* logical_expr: value_expr "BETWEEN" value_expr "AND" value_expr  */
+#line 298 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_BETWEEN );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-4] );
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1753 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1944 "swq_parser.cpp"
     break;
 
-  case 25:
-#line 305 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 25: /* logical_expr: value_expr "NOT" "BETWEEN" value_expr "AND" value_expr  */
+#line 307 "swq_parser.y"
+        {
             swq_expr_node *between;
             between = new swq_expr_node( SWQ_BETWEEN );
             between->field_type = SWQ_BOOLEAN;
-            between->PushSubExpression( (yyvsp[-5]) );
-            between->PushSubExpression( (yyvsp[-2]) );
-            between->PushSubExpression( (yyvsp[0]) );
+            between->PushSubExpression( yyvsp[-5] );
+            between->PushSubExpression( yyvsp[-2] );
+            between->PushSubExpression( yyvsp[0] );
 
-            (yyval) = new swq_expr_node( SWQ_NOT );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( between );
+            yyval = new swq_expr_node( SWQ_NOT );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( between );
         }
-#line 1770 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1961 "swq_parser.cpp"
     break;
 
-  case 26:
-#line 319 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_ISNULL );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
+  case 26: /* logical_expr: value_expr "IS" "NULL"  */
+#line 321 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_ISNULL );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( yyvsp[-2] );
         }
-#line 1780 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1971 "swq_parser.cpp"
     break;
 
-  case 27:
-#line 326 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 27: /* logical_expr: value_expr "IS" "NOT" "NULL"  */
+#line 328 "swq_parser.y"
+        {
         swq_expr_node *isnull;
 
             isnull = new swq_expr_node( SWQ_ISNULL );
             isnull->field_type = SWQ_BOOLEAN;
-            isnull->PushSubExpression( (yyvsp[-3]) );
+            isnull->PushSubExpression( yyvsp[-3] );
 
-            (yyval) = new swq_expr_node( SWQ_NOT );
-            (yyval)->field_type = SWQ_BOOLEAN;
-            (yyval)->PushSubExpression( isnull );
+            yyval = new swq_expr_node( SWQ_NOT );
+            yyval->field_type = SWQ_BOOLEAN;
+            yyval->PushSubExpression( isnull );
         }
-#line 1796 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1987 "swq_parser.cpp"
     break;
 
-  case 28:
-#line 340 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[0]);
-            (yyvsp[0])->PushSubExpression( (yyvsp[-2]) );
+  case 28: /* value_expr_list: value_expr ',' value_expr_list  */
+#line 342 "swq_parser.y"
+        {
+            yyval = yyvsp[0];
+            yyvsp[0]->PushSubExpression( yyvsp[-2] );
         }
-#line 1805 "swq_parser.cpp" /* yacc.c:1646  */
+#line 1996 "swq_parser.cpp"
     break;
 
-  case 29:
-#line 346 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_UNKNOWN ); /* list */
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 29: /* value_expr_list: value_expr  */
+#line 348 "swq_parser.y"
+            {
+            yyval = new swq_expr_node( SWQ_UNKNOWN ); /* list */
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1814 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2005 "swq_parser.cpp"
     break;
 
-  case 30:
-#line 353 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[0]);  // validation deferred.
-            (yyval)->eNodeType = SNT_COLUMN;
-            (yyval)->field_index = (yyval)->table_index = -1;
+  case 30: /* field_value: "identifier"  */
+#line 355 "swq_parser.y"
+        {
+            yyval = yyvsp[0];  // validation deferred.
+            yyval->eNodeType = SNT_COLUMN;
+            yyval->field_index = yyval->table_index = -1;
         }
-#line 1824 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2015 "swq_parser.cpp"
     break;
 
-  case 31:
-#line 360 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[-2]);  // validation deferred.
-            (yyval)->eNodeType = SNT_COLUMN;
-            (yyval)->field_index = (yyval)->table_index = -1;
-            (yyval)->string_value = (char *) 
-                            CPLRealloc( (yyval)->string_value, 
-                                        strlen((yyval)->string_value) 
-                                        + strlen((yyvsp[0])->string_value) + 2 );
-            strcat( (yyval)->string_value, "." );
-            strcat( (yyval)->string_value, (yyvsp[0])->string_value );
-            delete (yyvsp[0]);
-            (yyvsp[0]) = NULL;
-        }
-#line 1842 "swq_parser.cpp" /* yacc.c:1646  */
-    break;
-
-  case 32:
-#line 376 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[0]);
+  case 31: /* field_value: "identifier" '.' "identifier"  */
+#line 362 "swq_parser.y"
+        {
+            yyval = yyvsp[-2];  // validation deferred.
+            yyval->eNodeType = SNT_COLUMN;
+            yyval->field_index = yyval->table_index = -1;
+            yyval->string_value = (char *) 
+                            CPLRealloc( yyval->string_value, 
+                                        strlen(yyval->string_value) 
+                                        + strlen(yyvsp[0]->string_value) + 2 );
+            strcat( yyval->string_value, "." );
+            strcat( yyval->string_value, yyvsp[0]->string_value );
+            delete yyvsp[0];
+            yyvsp[0] = NULL;
+        }
+#line 2033 "swq_parser.cpp"
+    break;
+
+  case 32: /* value_expr: "integer number"  */
+#line 378 "swq_parser.y"
+        {
+            yyval = yyvsp[0];
         }
-#line 1850 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2041 "swq_parser.cpp"
     break;
 
-  case 33:
-#line 381 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[0]);
+  case 33: /* value_expr: "floating point number"  */
+#line 383 "swq_parser.y"
+        {
+            yyval = yyvsp[0];
         }
-#line 1858 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2049 "swq_parser.cpp"
     break;
 
-  case 34:
-#line 386 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[0]);
+  case 34: /* value_expr: "string"  */
+#line 388 "swq_parser.y"
+        {
+            yyval = yyvsp[0];
         }
-#line 1866 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2057 "swq_parser.cpp"
     break;
 
-  case 35:
-#line 390 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[0]);
+  case 35: /* value_expr: field_value  */
+#line 392 "swq_parser.y"
+        {
+            yyval = yyvsp[0];
         }
-#line 1874 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2065 "swq_parser.cpp"
     break;
 
-  case 36:
-#line 395 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[-1]);
+  case 36: /* value_expr: '(' value_expr ')'  */
+#line 397 "swq_parser.y"
+        {
+            yyval = yyvsp[-1];
         }
-#line 1882 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2073 "swq_parser.cpp"
     break;
 
-  case 37:
-#line 400 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node((const char*)NULL);
+  case 37: /* value_expr: "NULL"  */
+#line 402 "swq_parser.y"
+        {
+            yyval = new swq_expr_node((const char*)NULL);
         }
-#line 1890 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2081 "swq_parser.cpp"
     break;
 
-  case 38:
-#line 405 "swq_parser.y" /* yacc.c:1646  */
-    {
-            if ((yyvsp[0])->eNodeType == SNT_CONSTANT)
+  case 38: /* value_expr: '-' value_expr  */
+#line 407 "swq_parser.y"
+        {
+            if (yyvsp[0]->eNodeType == SNT_CONSTANT)
             {
-                (yyval) = (yyvsp[0]);
-                (yyval)->int_value *= -1;
-                (yyval)->float_value *= -1;
+                yyval = yyvsp[0];
+                yyval->int_value *= -1;
+                yyval->float_value *= -1;
             }
             else
             {
-                (yyval) = new swq_expr_node( SWQ_MULTIPLY );
-                (yyval)->PushSubExpression( new swq_expr_node(-1) );
-                (yyval)->PushSubExpression( (yyvsp[0]) );
+                yyval = new swq_expr_node( SWQ_MULTIPLY );
+                yyval->PushSubExpression( new swq_expr_node(-1) );
+                yyval->PushSubExpression( yyvsp[0] );
             }
         }
-#line 1909 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2100 "swq_parser.cpp"
     break;
 
-  case 39:
-#line 421 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_ADD );
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 39: /* value_expr: value_expr '+' value_expr  */
+#line 423 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_ADD );
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1919 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2110 "swq_parser.cpp"
     break;
 
-  case 40:
-#line 428 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_SUBTRACT );
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 40: /* value_expr: value_expr '-' value_expr  */
+#line 430 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_SUBTRACT );
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1929 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2120 "swq_parser.cpp"
     break;
 
-  case 41:
-#line 435 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_MULTIPLY );
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 41: /* value_expr: value_expr '*' value_expr  */
+#line 437 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_MULTIPLY );
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1939 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2130 "swq_parser.cpp"
     break;
 
-  case 42:
-#line 442 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_DIVIDE );
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 42: /* value_expr: value_expr '/' value_expr  */
+#line 444 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_DIVIDE );
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1949 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2140 "swq_parser.cpp"
     break;
 
-  case 43:
-#line 449 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = new swq_expr_node( SWQ_MODULUS );
-            (yyval)->PushSubExpression( (yyvsp[-2]) );
-            (yyval)->PushSubExpression( (yyvsp[0]) );
+  case 43: /* value_expr: value_expr '%' value_expr  */
+#line 451 "swq_parser.y"
+        {
+            yyval = new swq_expr_node( SWQ_MODULUS );
+            yyval->PushSubExpression( yyvsp[-2] );
+            yyval->PushSubExpression( yyvsp[0] );
         }
-#line 1959 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2150 "swq_parser.cpp"
     break;
 
-  case 44:
-#line 456 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 44: /* value_expr: "identifier" '(' value_expr_list ')'  */
+#line 458 "swq_parser.y"
+        {
             const swq_operation *poOp = 
-                    swq_op_registrar::GetOperator( (yyvsp[-3])->string_value );
+                    swq_op_registrar::GetOperator( yyvsp[-3]->string_value );
 
             if( poOp == NULL )
             {
                 CPLError( CE_Failure, CPLE_AppDefined, 
                                 "Undefined function '%s' used.",
-                                (yyvsp[-3])->string_value );
-                delete (yyvsp[-3]);
-                delete (yyvsp[-1]);
+                                yyvsp[-3]->string_value );
+                delete yyvsp[-3];
+                delete yyvsp[-1];
                 YYERROR;
             }
             else
             {
-                (yyval) = (yyvsp[-1]);
-                            (yyval)->eNodeType = SNT_OPERATION;
-                            (yyval)->nOperation = poOp->eOperation;
-                (yyval)->ReverseSubExpressions();
-                delete (yyvsp[-3]);
+                yyval = yyvsp[-1];
+                            yyval->eNodeType = SNT_OPERATION;
+                            yyval->nOperation = poOp->eOperation;
+                yyval->ReverseSubExpressions();
+                delete yyvsp[-3];
             }
         }
-#line 1986 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2177 "swq_parser.cpp"
     break;
 
-  case 45:
-#line 480 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[-1]);
-            (yyval)->PushSubExpression( (yyvsp[-3]) );
-            (yyval)->ReverseSubExpressions();
+  case 45: /* value_expr: "CAST" '(' value_expr "AS" type_def ')'  */
+#line 482 "swq_parser.y"
+        {
+            yyval = yyvsp[-1];
+            yyval->PushSubExpression( yyvsp[-3] );
+            yyval->ReverseSubExpressions();
         }
-#line 1996 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2187 "swq_parser.cpp"
     break;
 
-  case 46:
-#line 488 "swq_parser.y" /* yacc.c:1646  */
+  case 46: /* type_def: "identifier"  */
+#line 490 "swq_parser.y"
     {
-        (yyval) = new swq_expr_node( SWQ_CAST );
-        (yyval)->PushSubExpression( (yyvsp[0]) );
+        yyval = new swq_expr_node( SWQ_CAST );
+        yyval->PushSubExpression( yyvsp[0] );
     }
-#line 2005 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2196 "swq_parser.cpp"
     break;
 
-  case 47:
-#line 494 "swq_parser.y" /* yacc.c:1646  */
+  case 47: /* type_def: "identifier" '(' "integer number" ')'  */
+#line 496 "swq_parser.y"
     {
-        (yyval) = new swq_expr_node( SWQ_CAST );
-        (yyval)->PushSubExpression( (yyvsp[-1]) );
-        (yyval)->PushSubExpression( (yyvsp[-3]) );
+        yyval = new swq_expr_node( SWQ_CAST );
+        yyval->PushSubExpression( yyvsp[-1] );
+        yyval->PushSubExpression( yyvsp[-3] );
     }
-#line 2015 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2206 "swq_parser.cpp"
     break;
 
-  case 48:
-#line 501 "swq_parser.y" /* yacc.c:1646  */
+  case 48: /* type_def: "identifier" '(' "integer number" ',' "integer number" ')'  */
+#line 503 "swq_parser.y"
     {
-        (yyval) = new swq_expr_node( SWQ_CAST );
-        (yyval)->PushSubExpression( (yyvsp[-1]) );
-        (yyval)->PushSubExpression( (yyvsp[-3]) );
-        (yyval)->PushSubExpression( (yyvsp[-5]) );
+        yyval = new swq_expr_node( SWQ_CAST );
+        yyval->PushSubExpression( yyvsp[-1] );
+        yyval->PushSubExpression( yyvsp[-3] );
+        yyval->PushSubExpression( yyvsp[-5] );
     }
-#line 2026 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2217 "swq_parser.cpp"
     break;
 
-  case 49:
-#line 510 "swq_parser.y" /* yacc.c:1646  */
+  case 49: /* type_def: "identifier" '(' "identifier" ')'  */
+#line 512 "swq_parser.y"
     {
-        OGRwkbGeometryType eType = OGRFromOGCGeomType((yyvsp[-1])->string_value);
-        if( !EQUAL((yyvsp[-3])->string_value,"GEOMETRY") || 
+        OGRwkbGeometryType eType = OGRFromOGCGeomType(yyvsp[-1]->string_value);
+        if( !EQUAL(yyvsp[-3]->string_value,"GEOMETRY") || 
             (wkbFlatten(eType) == wkbUnknown &&
-            !EQUALN((yyvsp[-1])->string_value, "GEOMETRY", strlen("GEOMETRY"))) )
+            !EQUALN(yyvsp[-1]->string_value, "GEOMETRY", strlen("GEOMETRY"))) )
         {
             yyerror (context, "syntax error");
-            delete (yyvsp[-3]);
-            delete (yyvsp[-1]);
+            delete yyvsp[-3];
+            delete yyvsp[-1];
             YYERROR;
         }
-        (yyval) = new swq_expr_node( SWQ_CAST );
-        (yyval)->PushSubExpression( (yyvsp[-1]) );
-        (yyval)->PushSubExpression( (yyvsp[-3]) );
+        yyval = new swq_expr_node( SWQ_CAST );
+        yyval->PushSubExpression( yyvsp[-1] );
+        yyval->PushSubExpression( yyvsp[-3] );
     }
-#line 2046 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2237 "swq_parser.cpp"
     break;
 
-  case 50:
-#line 528 "swq_parser.y" /* yacc.c:1646  */
+  case 50: /* type_def: "identifier" '(' "identifier" ',' "integer number" ')'  */
+#line 530 "swq_parser.y"
     {
-        OGRwkbGeometryType eType = OGRFromOGCGeomType((yyvsp[-3])->string_value);
-        if( !EQUAL((yyvsp[-5])->string_value,"GEOMETRY") || 
+        OGRwkbGeometryType eType = OGRFromOGCGeomType(yyvsp[-3]->string_value);
+        if( !EQUAL(yyvsp[-5]->string_value,"GEOMETRY") || 
             (wkbFlatten(eType) == wkbUnknown &&
-            !EQUALN((yyvsp[-3])->string_value, "GEOMETRY", strlen("GEOMETRY"))) )
+            !EQUALN(yyvsp[-3]->string_value, "GEOMETRY", strlen("GEOMETRY"))) )
         {
             yyerror (context, "syntax error");
-            delete (yyvsp[-5]);
-            delete (yyvsp[-3]);
-            delete (yyvsp[-1]);
+            delete yyvsp[-5];
+            delete yyvsp[-3];
+            delete yyvsp[-1];
             YYERROR;
         }
-        (yyval) = new swq_expr_node( SWQ_CAST );
-        (yyval)->PushSubExpression( (yyvsp[-1]) );
-        (yyval)->PushSubExpression( (yyvsp[-3]) );
-        (yyval)->PushSubExpression( (yyvsp[-5]) );
+        yyval = new swq_expr_node( SWQ_CAST );
+        yyval->PushSubExpression( yyvsp[-1] );
+        yyval->PushSubExpression( yyvsp[-3] );
+        yyval->PushSubExpression( yyvsp[-5] );
     }
-#line 2068 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2259 "swq_parser.cpp"
     break;
 
-  case 53:
-#line 552 "swq_parser.y" /* yacc.c:1646  */
+  case 53: /* select_core: "SELECT" select_field_list "FROM" table_def opt_joins opt_where opt_group_by opt_order_by opt_limit  */
+#line 554 "swq_parser.y"
     {
-        delete (yyvsp[-3]);
+        delete yyvsp[-5];
     }
-#line 2076 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2267 "swq_parser.cpp"
     break;
 
-  case 56:
-#line 560 "swq_parser.y" /* yacc.c:1646  */
+  case 56: /* union_all: "UNION" "ALL"  */
+#line 562 "swq_parser.y"
     {
         swq_select* poNewSelect = new swq_select();
         context->poCurSelect->PushUnionAll(poNewSelect);
         context->poCurSelect = poNewSelect;
     }
-#line 2086 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2277 "swq_parser.cpp"
     break;
 
-  case 59:
-#line 572 "swq_parser.y" /* yacc.c:1646  */
-    {
-            if( !context->poCurSelect->PushField( (yyvsp[0]), NULL, TRUE ) )
+  case 59: /* column_spec: "DISTINCT" field_value  */
+#line 574 "swq_parser.y"
+        {
+            if( !context->poCurSelect->PushField( yyvsp[0], NULL, TRUE ) )
             {
-                delete (yyvsp[0]);
+                delete yyvsp[0];
                 YYERROR;
             }
         }
-#line 2098 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2289 "swq_parser.cpp"
     break;
 
-  case 60:
-#line 581 "swq_parser.y" /* yacc.c:1646  */
-    {
-            if( !context->poCurSelect->PushField( (yyvsp[0]), NULL, TRUE ) )
+  case 60: /* column_spec: "DISTINCT" "string"  */
+#line 583 "swq_parser.y"
+        {
+            if( !context->poCurSelect->PushField( yyvsp[0], NULL, TRUE ) )
             {
-                delete (yyvsp[0]);
+                delete yyvsp[0];
                 YYERROR;
             }
         }
-#line 2110 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2301 "swq_parser.cpp"
     break;
 
-  case 61:
-#line 590 "swq_parser.y" /* yacc.c:1646  */
-    {
-            if( !context->poCurSelect->PushField( (yyvsp[0]) ) )
+  case 61: /* column_spec: value_expr  */
+#line 592 "swq_parser.y"
+        {
+            if( !context->poCurSelect->PushField( yyvsp[0] ) )
             {
-                delete (yyvsp[0]);
+                delete yyvsp[0];
                 YYERROR;
             }
         }
-#line 2122 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2313 "swq_parser.cpp"
     break;
 
-  case 62:
-#line 599 "swq_parser.y" /* yacc.c:1646  */
-    {
-            if( !context->poCurSelect->PushField( (yyvsp[-1]), (yyvsp[0])->string_value, TRUE ))
+  case 62: /* column_spec: "DISTINCT" field_value as_clause  */
+#line 601 "swq_parser.y"
+        {
+            if( !context->poCurSelect->PushField( yyvsp[-1], yyvsp[0]->string_value, TRUE ))
             {
-                delete (yyvsp[-1]);
-                delete (yyvsp[0]);
+                delete yyvsp[-1];
+                delete yyvsp[0];
                 YYERROR;
             }
 
-            delete (yyvsp[0]);
+            delete yyvsp[0];
         }
-#line 2137 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2328 "swq_parser.cpp"
     break;
 
-  case 63:
-#line 611 "swq_parser.y" /* yacc.c:1646  */
-    {
-            if( !context->poCurSelect->PushField( (yyvsp[-1]), (yyvsp[0])->string_value ) )
+  case 63: /* column_spec: value_expr as_clause  */
+#line 613 "swq_parser.y"
+        {
+            if( !context->poCurSelect->PushField( yyvsp[-1], yyvsp[0]->string_value ) )
             {
-                delete (yyvsp[-1]);
-                delete (yyvsp[0]);
+                delete yyvsp[-1];
+                delete yyvsp[0];
                 YYERROR;
             }
-            delete (yyvsp[0]);
+            delete yyvsp[0];
         }
-#line 2151 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2342 "swq_parser.cpp"
     break;
 
-  case 64:
-#line 622 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 64: /* column_spec: '*'  */
+#line 624 "swq_parser.y"
+        {
             swq_expr_node *poNode = new swq_expr_node();
             poNode->eNodeType = SNT_COLUMN;
             poNode->string_value = CPLStrdup( "*" );
@@ -2165,19 +2356,19 @@ yyreduce:
                 YYERROR;
             }
         }
-#line 2168 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2359 "swq_parser.cpp"
     break;
 
-  case 65:
-#line 636 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 65: /* column_spec: "identifier" '.' '*'  */
+#line 638 "swq_parser.y"
+        {
             CPLString osQualifiedField;
 
-            osQualifiedField = (yyvsp[-2])->string_value;
+            osQualifiedField = yyvsp[-2]->string_value;
             osQualifiedField += ".*";
 
-            delete (yyvsp[-2]);
-            (yyvsp[-2]) = NULL;
+            delete yyvsp[-2];
+            yyvsp[-2] = NULL;
 
             swq_expr_node *poNode = new swq_expr_node();
             poNode->eNodeType = SNT_COLUMN;
@@ -2190,24 +2381,24 @@ yyreduce:
                 YYERROR;
             }
         }
-#line 2193 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2384 "swq_parser.cpp"
     break;
 
-  case 66:
-#line 658 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 66: /* column_spec: "identifier" '(' '*' ')'  */
+#line 660 "swq_parser.y"
+        {
                 // special case for COUNT(*), confirm it.
-            if( !EQUAL((yyvsp[-3])->string_value,"COUNT") )
+            if( !EQUAL(yyvsp[-3]->string_value,"COUNT") )
             {
                 CPLError( CE_Failure, CPLE_AppDefined,
                         "Syntax Error with %s(*).", 
-                    (yyvsp[-3])->string_value );
-                delete (yyvsp[-3]);
+                    yyvsp[-3]->string_value );
+                delete yyvsp[-3];
                     YYERROR;
             }
 
-            delete (yyvsp[-3]);
-            (yyvsp[-3]) = NULL;
+            delete yyvsp[-3];
+            yyvsp[-3] = NULL;
                     
             swq_expr_node *poNode = new swq_expr_node();
             poNode->eNodeType = SNT_COLUMN;
@@ -2223,25 +2414,25 @@ yyreduce:
                 YYERROR;
             }
         }
-#line 2226 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2417 "swq_parser.cpp"
     break;
 
-  case 67:
-#line 688 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 67: /* column_spec: "identifier" '(' '*' ')' as_clause  */
+#line 690 "swq_parser.y"
+        {
                 // special case for COUNT(*), confirm it.
-            if( !EQUAL((yyvsp[-4])->string_value,"COUNT") )
+            if( !EQUAL(yyvsp[-4]->string_value,"COUNT") )
             {
                 CPLError( CE_Failure, CPLE_AppDefined,
                         "Syntax Error with %s(*).", 
-                        (yyvsp[-4])->string_value );
-                delete (yyvsp[-4]);
-                delete (yyvsp[0]);
+                        yyvsp[-4]->string_value );
+                delete yyvsp[-4];
+                delete yyvsp[0];
                 YYERROR;
             }
 
-            delete (yyvsp[-4]);
-            (yyvsp[-4]) = NULL;
+            delete yyvsp[-4];
+            yyvsp[-4] = NULL;
 
             swq_expr_node *poNode = new swq_expr_node();
             poNode->eNodeType = SNT_COLUMN;
@@ -2251,35 +2442,35 @@ yyreduce:
             swq_expr_node *count = new swq_expr_node( (swq_op)SWQ_COUNT );
             count->PushSubExpression( poNode );
 
-            if( !context->poCurSelect->PushField( count, (yyvsp[0])->string_value ) )
+            if( !context->poCurSelect->PushField( count, yyvsp[0]->string_value ) )
             {
                 delete count;
-                delete (yyvsp[0]);
+                delete yyvsp[0];
                 YYERROR;
             }
 
-            delete (yyvsp[0]);
+            delete yyvsp[0];
         }
-#line 2263 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2454 "swq_parser.cpp"
     break;
 
-  case 68:
-#line 722 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 68: /* column_spec: "identifier" '(' "DISTINCT" field_value ')'  */
+#line 724 "swq_parser.y"
+        {
                 // special case for COUNT(DISTINCT x), confirm it.
-            if( !EQUAL((yyvsp[-4])->string_value,"COUNT") )
+            if( !EQUAL(yyvsp[-4]->string_value,"COUNT") )
             {
                 CPLError( CE_Failure, CPLE_AppDefined,
                         "DISTINCT keyword can only be used in COUNT() operator." );
-                delete (yyvsp[-4]);
-                delete (yyvsp[-1]);
+                delete yyvsp[-4];
+                delete yyvsp[-1];
                     YYERROR;
             }
 
-            delete (yyvsp[-4]);
+            delete yyvsp[-4];
             
             swq_expr_node *count = new swq_expr_node( SWQ_COUNT );
-            count->PushSubExpression( (yyvsp[-1]) );
+            count->PushSubExpression( yyvsp[-1] );
                 
             if( !context->poCurSelect->PushField( count, NULL, TRUE ) )
             {
@@ -2287,188 +2478,208 @@ yyreduce:
                 YYERROR;
             }
         }
-#line 2290 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2481 "swq_parser.cpp"
     break;
 
-  case 69:
-#line 746 "swq_parser.y" /* yacc.c:1646  */
-    {
+  case 69: /* column_spec: "identifier" '(' "DISTINCT" field_value ')' as_clause  */
+#line 748 "swq_parser.y"
+        {
             // special case for COUNT(DISTINCT x), confirm it.
-            if( !EQUAL((yyvsp[-5])->string_value,"COUNT") )
+            if( !EQUAL(yyvsp[-5]->string_value,"COUNT") )
             {
                 CPLError( CE_Failure, CPLE_AppDefined,
                         "DISTINCT keyword can only be used in COUNT() operator." );
-                delete (yyvsp[-5]);
-                delete (yyvsp[-2]);
-                delete (yyvsp[0]);
+                delete yyvsp[-5];
+                delete yyvsp[-2];
+                delete yyvsp[0];
                 YYERROR;
             }
 
             swq_expr_node *count = new swq_expr_node( SWQ_COUNT );
-            count->PushSubExpression( (yyvsp[-2]) );
+            count->PushSubExpression( yyvsp[-2] );
 
-            if( !context->poCurSelect->PushField( count, (yyvsp[0])->string_value, TRUE ) )
+            if( !context->poCurSelect->PushField( count, yyvsp[0]->string_value, TRUE ) )
             {
-                delete (yyvsp[-5]);
+                delete yyvsp[-5];
                 delete count;
-                delete (yyvsp[0]);
+                delete yyvsp[0];
                 YYERROR;
             }
 
-            delete (yyvsp[-5]);
-            delete (yyvsp[0]);
+            delete yyvsp[-5];
+            delete yyvsp[0];
         }
-#line 2321 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2512 "swq_parser.cpp"
     break;
 
-  case 70:
-#line 775 "swq_parser.y" /* yacc.c:1646  */
-    {
-            delete (yyvsp[-1]);
-            (yyval) = (yyvsp[0]);
+  case 70: /* as_clause: "AS" string_or_identifier  */
+#line 777 "swq_parser.y"
+        {
+            delete yyvsp[-1];
+            yyval = yyvsp[0];
         }
-#line 2330 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2521 "swq_parser.cpp"
     break;
 
-  case 73:
-#line 785 "swq_parser.y" /* yacc.c:1646  */
-    {
-            context->poCurSelect->where_expr = (yyvsp[0]);
+  case 73: /* opt_where: "WHERE" logical_expr  */
+#line 787 "swq_parser.y"
+        {
+            context->poCurSelect->where_expr = yyvsp[0];
         }
-#line 2338 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2529 "swq_parser.cpp"
     break;
 
-  case 75:
-#line 791 "swq_parser.y" /* yacc.c:1646  */
-    {
-            context->poCurSelect->PushJoin( (yyvsp[-5])->int_value,
-                                            (yyvsp[-3])->string_value, 
-                                            (yyvsp[-1])->string_value );
-            delete (yyvsp[-5]);
-            delete (yyvsp[-3]);
-            delete (yyvsp[-1]);
+  case 75: /* opt_joins: "JOIN" table_def "ON" field_value '=' field_value opt_joins  */
+#line 793 "swq_parser.y"
+        {
+            context->poCurSelect->PushJoin( yyvsp[-5]->int_value,
+                                            yyvsp[-3]->string_value, 
+                                            yyvsp[-1]->string_value );
+            delete yyvsp[-5];
+            delete yyvsp[-3];
+            delete yyvsp[-1];
         }
-#line 2351 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2542 "swq_parser.cpp"
     break;
 
-  case 76:
-#line 800 "swq_parser.y" /* yacc.c:1646  */
-    {
-            context->poCurSelect->PushJoin( (yyvsp[-5])->int_value,
-                                            (yyvsp[-3])->string_value, 
-                                            (yyvsp[-1])->string_value );
-            delete (yyvsp[-5]);
-            delete (yyvsp[-3]);
-            delete (yyvsp[-1]);
+  case 76: /* opt_joins: "LEFT" "JOIN" table_def "ON" field_value '=' field_value opt_joins  */
+#line 802 "swq_parser.y"
+        {
+            context->poCurSelect->PushJoin( yyvsp[-5]->int_value,
+                                            yyvsp[-3]->string_value, 
+                                            yyvsp[-1]->string_value );
+            delete yyvsp[-5];
+            delete yyvsp[-3];
+            delete yyvsp[-1];
 	    }
-#line 2364 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2555 "swq_parser.cpp"
     break;
 
-  case 81:
-#line 818 "swq_parser.y" /* yacc.c:1646  */
-    {
-            context->poCurSelect->PushOrderBy( (yyvsp[0])->string_value, TRUE );
-            delete (yyvsp[0]);
-            (yyvsp[0]) = NULL;
+  case 81: /* group_spec: field_value  */
+#line 820 "swq_parser.y"
+        {
+            context->poCurSelect->PushGroupBy( yyvsp[0]->string_value );
+            delete yyvsp[0];
+            yyvsp[0] = NULL;
         }
-#line 2374 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2565 "swq_parser.cpp"
     break;
 
-  case 82:
-#line 824 "swq_parser.y" /* yacc.c:1646  */
-    {
-            context->poCurSelect->PushOrderBy( (yyvsp[-1])->string_value, TRUE );
-            delete (yyvsp[-1]);
-            (yyvsp[-1]) = NULL;
+  case 86: /* sort_spec: field_value  */
+#line 835 "swq_parser.y"
+        {
+            context->poCurSelect->PushOrderBy( yyvsp[0]->string_value, TRUE );
+            delete yyvsp[0];
+            yyvsp[0] = NULL;
         }
-#line 2384 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2575 "swq_parser.cpp"
     break;
 
-  case 83:
-#line 830 "swq_parser.y" /* yacc.c:1646  */
-    {
-            context->poCurSelect->PushOrderBy( (yyvsp[-1])->string_value, FALSE );
-            delete (yyvsp[-1]);
-            (yyvsp[-1]) = NULL;
+  case 87: /* sort_spec: field_value "ASC"  */
+#line 841 "swq_parser.y"
+        {
+            context->poCurSelect->PushOrderBy( yyvsp[-1]->string_value, TRUE );
+            delete yyvsp[-1];
+            yyvsp[-1] = NULL;
         }
-#line 2394 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2585 "swq_parser.cpp"
     break;
 
-  case 84:
-#line 838 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[0]);
+  case 88: /* sort_spec: field_value "DESC"  */
+#line 847 "swq_parser.y"
+        {
+            context->poCurSelect->PushOrderBy( yyvsp[-1]->string_value, FALSE );
+            delete yyvsp[-1];
+            yyvsp[-1] = NULL;
         }
-#line 2402 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2595 "swq_parser.cpp"
     break;
 
-  case 85:
-#line 842 "swq_parser.y" /* yacc.c:1646  */
-    {
-            (yyval) = (yyvsp[0]);
+  case 90: /* opt_limit: "LIMIT" "integer number"  */
+#line 855 "swq_parser.y"
+        {
+            context->poCurSelect->SetLimit( yyvsp[0]->int_value );
+            delete yyvsp[0];
+        }
+#line 2604 "swq_parser.cpp"
+    break;
+
+  case 91: /* string_or_identifier: "identifier"  */
+#line 862 "swq_parser.y"
+        {
+            yyval = yyvsp[0];
+        }
+#line 2612 "swq_parser.cpp"
+    break;
+
+  case 92: /* string_or_identifier: "string"  */
+#line 866 "swq_parser.y"
+        {
+            yyval = yyvsp[0];
         }
-#line 2410 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2620 "swq_parser.cpp"
     break;
 
-  case 86:
-#line 848 "swq_parser.y" /* yacc.c:1646  */
+  case 93: /* table_def: string_or_identifier  */
+#line 872 "swq_parser.y"
     {
         int iTable;
-        iTable =context->poCurSelect->PushTableDef( NULL, (yyvsp[0])->string_value,
+        iTable =context->poCurSelect->PushTableDef( NULL, yyvsp[0]->string_value,
                                                     NULL );
-        delete (yyvsp[0]);
+        delete yyvsp[0];
 
-        (yyval) = new swq_expr_node( iTable );
+        yyval = new swq_expr_node( iTable );
     }
-#line 2423 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2633 "swq_parser.cpp"
     break;
 
-  case 87:
-#line 858 "swq_parser.y" /* yacc.c:1646  */
+  case 94: /* table_def: string_or_identifier "identifier"  */
+#line 882 "swq_parser.y"
     {
         int iTable;
-        iTable = context->poCurSelect->PushTableDef( NULL, (yyvsp[-1])->string_value,
-                                                     (yyvsp[0])->string_value );
-        delete (yyvsp[-1]);
-        delete (yyvsp[0]);
+        iTable = context->poCurSelect->PushTableDef( NULL, yyvsp[-1]->string_value,
+                                                     yyvsp[0]->string_value );
+        delete yyvsp[-1];
+        delete yyvsp[0];
 
-        (yyval) = new swq_expr_node( iTable );
+        yyval = new swq_expr_node( iTable );
     }
-#line 2437 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2647 "swq_parser.cpp"
     break;
 
-  case 88:
-#line 869 "swq_parser.y" /* yacc.c:1646  */
+  case 95: /* table_def: "string" '.' string_or_identifier  */
+#line 893 "swq_parser.y"
     {
         int iTable;
-        iTable = context->poCurSelect->PushTableDef( (yyvsp[-2])->string_value,
-                                                     (yyvsp[0])->string_value, NULL );
-        delete (yyvsp[-2]);
-        delete (yyvsp[0]);
+        iTable = context->poCurSelect->PushTableDef( yyvsp[-2]->string_value,
+                                                     yyvsp[0]->string_value, NULL );
+        delete yyvsp[-2];
+        delete yyvsp[0];
 
-        (yyval) = new swq_expr_node( iTable );
+        yyval = new swq_expr_node( iTable );
     }
-#line 2451 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2661 "swq_parser.cpp"
     break;
 
-  case 89:
-#line 880 "swq_parser.y" /* yacc.c:1646  */
+  case 96: /* table_def: "string" '.' string_or_identifier "identifier"  */
+#line 904 "swq_parser.y"
     {
         int iTable;
-        iTable = context->poCurSelect->PushTableDef( (yyvsp[-3])->string_value,
-                                                     (yyvsp[-1])->string_value, 
-                                                     (yyvsp[0])->string_value );
-        delete (yyvsp[-3]);
-        delete (yyvsp[-1]);
-        delete (yyvsp[0]);
-
-        (yyval) = new swq_expr_node( iTable );
+        iTable = context->poCurSelect->PushTableDef( yyvsp[-3]->string_value,
+                                                     yyvsp[-1]->string_value, 
+                                                     yyvsp[0]->string_value );
+        delete yyvsp[-3];
+        delete yyvsp[-1];
+        delete yyvsp[0];
+
+        yyval = new swq_expr_node( iTable );
     }
-#line 2467 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2677 "swq_parser.cpp"
     break;
 
 
-#line 2471 "swq_parser.cpp" /* yacc.c:1646  */
+#line 2681 "swq_parser.cpp"
+
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -2482,25 +2693,23 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
 
   /* Now 'shift' the result of the reduction.  Determine what state
      that goes to, based on the state we popped back to and the rule
      number reduced by.  */
-
-  yyn = yyr1[yyn];
-
-  yystate = yypgoto[yyn - YYNTOKENS] + *yyssp;
-  if (0 <= yystate && yystate <= YYLAST && yycheck[yystate] == *yyssp)
-    yystate = yytable[yystate];
-  else
-    yystate = yydefgoto[yyn - YYNTOKENS];
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
 
   goto yynewstate;
 
@@ -2511,59 +2720,53 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
-      yyerror (context, YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
       {
+        yypcontext_t yyctx
+          = {yyssp, yytoken};
         char const *yymsgp = YY_("syntax error");
         int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
+        yysyntax_error_status = yysyntax_error (&yymsg_alloc, &yymsg, &yyctx);
         if (yysyntax_error_status == 0)
           yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
+        else if (yysyntax_error_status == -1)
           {
             if (yymsg != yymsgbuf)
               YYSTACK_FREE (yymsg);
-            yymsg = (char *) YYSTACK_ALLOC (yymsg_alloc);
-            if (!yymsg)
+            yymsg = YY_CAST (char *,
+                             YYSTACK_ALLOC (YY_CAST (YYSIZE_T, yymsg_alloc)));
+            if (yymsg)
               {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
+                yysyntax_error_status
+                  = yysyntax_error (&yymsg_alloc, &yymsg, &yyctx);
+                yymsgp = yymsg;
               }
             else
               {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
+                yymsg = yymsgbuf;
+                yymsg_alloc = sizeof yymsgbuf;
+                yysyntax_error_status = YYENOMEM;
               }
           }
         yyerror (context, yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
+        if (yysyntax_error_status == YYENOMEM)
+          YYNOMEM;
       }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
          error, discard it.  */
 
-      if (yychar <= YYEOF)
+      if (yychar <= END)
         {
           /* Return failure if at end of input.  */
-          if (yychar == YYEOF)
+          if (yychar == END)
             YYABORT;
         }
       else
@@ -2583,12 +2786,11 @@ yyerrlab:
 | yyerrorlab -- error raised explicitly by YYERROR.  |
 `---------------------------------------------------*/
 yyerrorlab:
-
-  /* Pacify compilers like GCC when the user code never invokes
-     YYERROR and the label yyerrorlab therefore never appears in user
-     code.  */
-  if (/*CONSTCOND*/ 0)
-     goto yyerrorlab;
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -2605,13 +2807,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -2625,7 +2828,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, context);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, context);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -2637,7 +2840,7 @@ yyerrlab1:
 
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -2648,26 +2851,30 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
 /*-----------------------------------.
 | yyabortlab -- YYABORT comes here.  |
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (context, YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
+
 
-yyreturn:
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
@@ -2683,16 +2890,15 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp, context);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, context);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
   if (yymsg != yymsgbuf)
     YYSTACK_FREE (yymsg);
-#endif
   return yyresult;
 }
+
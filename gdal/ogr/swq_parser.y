@@ -79,6 +79,8 @@
 %token SWQT_CAST                "CAST"
 %token SWQT_UNION               "UNION"
 %token SWQT_ALL                 "ALL"
+%token SWQT_LIMIT               "LIMIT"
+%token SWQT_GROUP               "GROUP"
 
 %token SWQT_LOGICAL_START
 %token SWQT_VALUE_START
@@ -548,7 +550,7 @@ select_statement:
     | '(' select_core ')' opt_union_all
 
 select_core:
-    SWQT_SELECT select_field_list SWQT_FROM table_def opt_joins opt_where opt_order_by
+    SWQT_SELECT select_field_list SWQT_FROM table_def opt_joins opt_where opt_group_by opt_order_by opt_limit
     {
         delete $4;
     }
@@ -806,6 +808,21 @@ opt_joins:
             delete $7;
 	    }
 
+opt_group_by:
+    | SWQT_GROUP SWQT_BY group_spec_list
+
+group_spec_list:
+    group_spec ',' group_spec_list
+    | group_spec
+
+group_spec:
+    field_value
+        {
+            context->poCurSelect->PushGroupBy( $1->string_value );
+            delete $1;
+            $1 = NULL;
+        }
+
 opt_order_by:
     | SWQT_ORDER SWQT_BY sort_spec_list
 
@@ -833,6 +850,13 @@ sort_spec:
             $1 = NULL;
         }
 
+opt_limit:
+    | SWQT_LIMIT SWQT_INTEGER_NUMBER
+        {
+            context->poCurSelect->SetLimit( $2->int_value );
+            delete $2;
+        }
+
 string_or_identifier:
     SWQT_IDENTIFIER
         {
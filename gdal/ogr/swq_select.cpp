@@ -56,6 +56,11 @@ swq_select::swq_select()
     order_specs = 0;
     order_defs = NULL;
 
+    group_specs = 0;
+    group_defs = NULL;
+
+    limit = -1;
+
     poOtherSelect = NULL;
 }
 
@@ -88,21 +93,12 @@ swq_select::~swq_select()
         CPLFree( column_defs[i].field_alias );
 
         delete column_defs[i].expr;
-
-        if( column_summary != NULL 
-            && column_summary[i].distinct_list != NULL )
-        {
-            int j;
-            
-            for( j = 0; j < column_summary[i].count; j++ )
-                CPLFree( column_summary[i].distinct_list[j] );
-
-            CPLFree( column_summary[i].distinct_list );
-        }
     }
 
     CPLFree( column_defs );
 
+    if( column_summary != NULL )
+        swq_summary_free( column_summary, result_columns );
     CPLFree( column_summary );
 
     for( i = 0; i < order_specs; i++ )
@@ -112,6 +108,13 @@ swq_select::~swq_select()
     
     CPLFree( order_defs );
 
+    for( i = 0; i < group_specs; i++ )
+    {
+        CPLFree( group_defs[i].field_name );
+    }
+    
+    CPLFree( group_defs );
+
     for( i = 0; i < join_count; i++ )
     {
         CPLFree( join_defs[i].primary_field_name );
@@ -205,6 +208,8 @@ void swq_select::Dump( FILE *fp )
         fprintf( fp, "  QUERY MODE: RECORDSET\n" );
     else if( query_mode == SWQM_DISTINCT_LIST )
         fprintf( fp, "  QUERY MODE: DISTINCT LIST\n" );
+    else if( query_mode == SWQM_GROUP_BY )
+        fprintf( fp, "  QUERY MODE: GROUP BY\n" );
     else
         fprintf( fp, "  QUERY MODE: %d/unknown\n", query_mode );
 
@@ -301,6 +306,18 @@ void swq_select::Dump( FILE *fp )
         where_expr->Dump( fp, 2 );
     }
 
+/* -------------------------------------------------------------------- */
+/*      Group by                                                        */
+/* -------------------------------------------------------------------- */
+
+    for( i = 0; i < group_specs; i++ )
+    {
+        fprintf( fp, "  GROUP BY: %s (%d/%d)\n",
+                 group_defs[i].field_name,
+                 group_defs[i].table_index,
+                 group_defs[i].field_index );
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Order by                                                        */
 /* -------------------------------------------------------------------- */
@@ -316,6 +333,12 @@ void swq_select::Dump( FILE *fp )
         else
             fprintf( fp, " DESC\n" );
     }
+
+/* -------------------------------------------------------------------- */
+/*      Limit                                                           */
+/* -------------------------------------------------------------------- */
+    if( limit >= 0 )
+        fprintf( fp, "  LIMIT: %ld\n", limit );
 }
 
 /************************************************************************/
@@ -593,6 +616,146 @@ void swq_select::PushOrderBy( const char *pszFieldName, int bAscending )
     order_defs[order_specs-1].ascending_flag = bAscending;
 }
 
+/************************************************************************/
+/*                            PushGroupBy()                             */
+/************************************************************************/
+
+void swq_select::PushGroupBy( const char *pszFieldName )
+
+{
+    group_specs++;
+    group_defs = (swq_group_def *) 
+        CPLRealloc( group_defs, sizeof(swq_group_def) * group_specs );
+
+    group_defs[group_specs-1].field_name = CPLStrdup(pszFieldName);
+    group_defs[group_specs-1].table_index = -1;
+    group_defs[group_specs-1].field_index = -1;
+}
+
+/************************************************************************/
+/*                           parse_group_by()                           */
+/*                                                                      */
+/*      Identify the GROUP BY fields, and check that each result        */
+/*      column is either an aggregate or one of the grouping fields.    */
+/************************************************************************/
+
+CPLErr swq_select::parse_group_by( swq_field_list *field_list )
+
+{
+    int i, j;
+
+    for( i = 0; i < group_specs; i++ )
+    {
+        swq_group_def *def = group_defs + i;
+        swq_field_type field_type;
+
+        def->field_index = swq_identify_field( def->field_name, field_list,
+                                               &field_type, &(def->table_index) );
+        if( def->field_index == -1 )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined, 
+                      "Unrecognised field name %s in GROUP BY.", 
+                      def->field_name );
+            return CE_Failure;
+        }
+
+        if( def->table_index != 0 )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Cannot use field '%s' of a secondary table in a GROUP BY clause",
+                      def->field_name );
+            return CE_Failure;
+        }
+
+        if( field_type == SWQ_GEOMETRY || field_type == SWQ_OTHER )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Cannot use field '%s' of type %s in a GROUP BY clause",
+                      def->field_name, SWQFieldTypeToString(field_type) );
+            return CE_Failure;
+        }
+    }
+
+    for( i = 0; i < result_columns; i++ )
+    {
+        swq_col_def *def = column_defs + i;
+
+        if( def->col_func == SWQCF_NONE )
+        {
+            if( def->distinct_flag )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "SELECT DISTINCT cannot be used with GROUP BY." );
+                return CE_Failure;
+            }
+
+            if( (def->expr != NULL && def->expr->eNodeType != SNT_COLUMN)
+                || def->target_type != SWQ_OTHER )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Only aggregate functions and GROUP BY fields "
+                          "can be selected in a GROUP BY query." );
+                return CE_Failure;
+            }
+
+            for( j = 0; j < group_specs; j++ )
+            {
+                if( def->table_index == 0
+                    && def->field_index == group_defs[j].field_index )
+                    break;
+            }
+            if( j == group_specs )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Column '%s' must appear in the GROUP BY clause "
+                          "or be used in an aggregate function.",
+                          def->field_name );
+                return CE_Failure;
+            }
+        }
+        else if( def->col_func == SWQCF_CUSTOM )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Column '%s' must appear in the GROUP BY clause "
+                      "or be used in an aggregate function.",
+                      def->field_name );
+            return CE_Failure;
+        }
+        else
+        {
+            if( def->distinct_flag && def->field_type == SWQ_GEOMETRY )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "SELECT COUNT DISTINCT on a geometry not supported." );
+                return CE_Failure;
+            }
+
+            if( def->field_index != -1 && def->table_index != 0 )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Cannot aggregate field '%s' of a secondary table "
+                          "in a GROUP BY query",
+                          def->field_name );
+                return CE_Failure;
+            }
+        }
+    }
+
+    query_mode = SWQM_GROUP_BY;
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                              SetLimit()                              */
+/************************************************************************/
+
+void swq_select::SetLimit( long nLimit )
+
+{
+    limit = nLimit;
+}
+
 /************************************************************************/
 /*                              PushJoin()                              */
 /************************************************************************/
@@ -910,69 +1073,78 @@ CPLErr swq_select::parse( swq_field_list *field_list,
 /* -------------------------------------------------------------------- */
 /*      Check if we are producing a one row summary result or a set     */
 /*      of records.  Generate an error if we get conflicting            */
-/*      indications.                                                    */
+/*      indications.  GROUP BY queries have their own rules.            */
 /* -------------------------------------------------------------------- */
-    query_mode = -1;
-    for( i = 0; i < result_columns; i++ )
+    if( group_specs > 0 )
     {
-        swq_col_def *def = column_defs + i;
-        int this_indicator = -1;
-
-        if( def->col_func == SWQCF_MIN 
-            || def->col_func == SWQCF_MAX
-            || def->col_func == SWQCF_AVG
-            || def->col_func == SWQCF_SUM
-            || def->col_func == SWQCF_COUNT )
-        {
-            this_indicator = SWQM_SUMMARY_RECORD;
-            if( def->col_func == SWQCF_COUNT &&
-                def->distinct_flag &&
-                def->field_type == SWQ_GEOMETRY )
-            {
-                CPLError( CE_Failure, CPLE_AppDefined,
-                          "SELECT COUNT DISTINCT on a geometry not supported." );
-                return CE_Failure;
-            }
-        }
-        else if( def->col_func == SWQCF_NONE )
+        eError = parse_group_by( field_list );
+        if( eError != CE_None )
+            return eError;
+    }
+    else
+    {
+        query_mode = -1;
+        for( i = 0; i < result_columns; i++ )
         {
-            if( def->distinct_flag )
+            swq_col_def *def = column_defs + i;
+            int this_indicator = -1;
+
+            if( def->col_func == SWQCF_MIN 
+                || def->col_func == SWQCF_MAX
+                || def->col_func == SWQCF_AVG
+                || def->col_func == SWQCF_SUM
+                || def->col_func == SWQCF_COUNT )
             {
-                this_indicator = SWQM_DISTINCT_LIST;
-                if( def->field_type == SWQ_GEOMETRY )
+                this_indicator = SWQM_SUMMARY_RECORD;
+                if( def->col_func == SWQCF_COUNT &&
+                    def->distinct_flag &&
+                    def->field_type == SWQ_GEOMETRY )
                 {
                     CPLError( CE_Failure, CPLE_AppDefined,
-                              "SELECT DISTINCT on a geometry not supported." );
+                              "SELECT COUNT DISTINCT on a geometry not supported." );
                     return CE_Failure;
                 }
             }
-            else
-                this_indicator = SWQM_RECORDSET;
+            else if( def->col_func == SWQCF_NONE )
+            {
+                if( def->distinct_flag )
+                {
+                    this_indicator = SWQM_DISTINCT_LIST;
+                    if( def->field_type == SWQ_GEOMETRY )
+                    {
+                        CPLError( CE_Failure, CPLE_AppDefined,
+                                  "SELECT DISTINCT on a geometry not supported." );
+                        return CE_Failure;
+                    }
+                }
+                else
+                    this_indicator = SWQM_RECORDSET;
+            }
+
+            if( this_indicator != query_mode
+                 && this_indicator != -1
+                && query_mode != -1 )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Field list implies mixture of regular recordset mode, summary mode or distinct field list mode." );
+                return CE_Failure;
+            }
+
+            if( this_indicator != -1 )
+                query_mode = this_indicator;
         }
 
-        if( this_indicator != query_mode
-             && this_indicator != -1
-            && query_mode != -1 )
+        if( result_columns > 1 
+            && query_mode == SWQM_DISTINCT_LIST )
         {
             CPLError( CE_Failure, CPLE_AppDefined,
-                      "Field list implies mixture of regular recordset mode, summary mode or distinct field list mode." );
+                      "SELECTing more than one DISTINCT field is a query not supported." );
             return CE_Failure;
         }
-
-        if( this_indicator != -1 )
-            query_mode = this_indicator;
-    }
-
-    if( result_columns > 1 
-        && query_mode == SWQM_DISTINCT_LIST )
-    {
-        CPLError( CE_Failure, CPLE_AppDefined,
-                  "SELECTing more than one DISTINCT field is a query not supported." );
-        return CE_Failure;
-    }
-    else if (result_columns == 0)
-    {
-        query_mode = SWQM_RECORDSET;
+        else if (result_columns == 0)
+        {
+            query_mode = SWQM_RECORDSET;
+        }
     }
 
 /* -------------------------------------------------------------------- */
@@ -1059,6 +1231,25 @@ CPLErr swq_select::parse( swq_field_list *field_list,
                       def->field_name );
             return CE_Failure;
         }
+
+        if( query_mode == SWQM_GROUP_BY )
+        {
+            int j;
+
+            for( j = 0; j < group_specs; j++ )
+            {
+                if( group_defs[j].field_index == def->field_index )
+                    break;
+            }
+            if( j == group_specs )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Field '%s' of the ORDER BY clause must appear in "
+                          "the GROUP BY clause",
+                          def->field_name );
+                return CE_Failure;
+            }
+        }
     }
 
 /* -------------------------------------------------------------------- */
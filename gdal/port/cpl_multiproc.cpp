@@ -1661,3 +1661,367 @@ void CPLSetTLSWithFreeFunc( int nIndex, void *pData, CPLTLSFreeFunc pfnFree )
     papTLSList[nIndex] = pData;
     papTLSList[CTLS_MAX + nIndex] = (void*) pfnFree;
 }
+
+/************************************************************************/
+/* ==================================================================== */
+/*                        CPLWorkerThreadPool                           */
+/* ==================================================================== */
+/************************************************************************/
+
+struct _CPLWorkerThreadJob
+{
+    CPLThreadFunc       pfnFunc;
+    void               *pData;
+    CPLJobGroup        *poGroup;
+    CPLWorkerThreadJob *psNext;
+};
+
+static CPLWorkerThreadPool *poGlobalWorkerThreadPool = NULL;
+static void *hGlobalWorkerThreadPoolMutex = NULL;
+
+/************************************************************************/
+/*                        CPLWorkerThreadPool()                         */
+/************************************************************************/
+
+CPLWorkerThreadPool::CPLWorkerThreadPool()
+
+{
+    hMutex = CPLCreateMutex();
+    if( hMutex != NULL )
+        CPLReleaseMutex( hMutex );
+    hCondJobAvailable = CPLCreateCond();
+    hCondJobDone = CPLCreateCond();
+    bStop = FALSE;
+    nThreads = 0;
+    pahThreads = NULL;
+    psJobListHead = NULL;
+    psJobListTail = NULL;
+}
+
+/************************************************************************/
+/*                       ~CPLWorkerThreadPool()                         */
+/************************************************************************/
+
+CPLWorkerThreadPool::~CPLWorkerThreadPool()
+
+{
+    if( nThreads > 0 )
+    {
+        CPLAcquireMutex( hMutex, 1000.0 );
+        bStop = TRUE;
+        CPLCondBroadcast( hCondJobAvailable );
+        CPLReleaseMutex( hMutex );
+
+        for( int i = 0; i < nThreads; i++ )
+            CPLJoinThread( pahThreads[i] );
+    }
+    CPLFree( pahThreads );
+
+    CPLAssert( psJobListHead == NULL );
+
+    if( hCondJobAvailable != NULL )
+        CPLDestroyCond( hCondJobAvailable );
+    if( hCondJobDone != NULL )
+        CPLDestroyCond( hCondJobDone );
+    if( hMutex != NULL )
+        CPLDestroyMutex( hMutex );
+}
+
+/************************************************************************/
+/*                             AddThreads()                             */
+/************************************************************************/
+
+/**
+ * Start new worker threads.
+ *
+ * @param nNewThreads number of threads to add to the pool.
+ * @return TRUE if all the threads could be started.
+ */
+
+int CPLWorkerThreadPool::AddThreads( int nNewThreads )
+
+{
+    if( hMutex == NULL || hCondJobAvailable == NULL || hCondJobDone == NULL )
+        return FALSE;
+
+    CPLMutexHolderOptionalLockD( hMutex );
+
+    pahThreads = (void**) CPLRealloc( pahThreads,
+                                      sizeof(void*) * (nThreads + nNewThreads) );
+    for( int i = 0; i < nNewThreads; i++ )
+    {
+        void* hThread = CPLCreateJoinableThread( WorkerThreadFunction, this );
+        if( hThread == NULL )
+            return FALSE;
+        pahThreads[nThreads ++] = hThread;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                               PopJob()                               */
+/*                                                                      */
+/*      Must be called with hMutex held.  If poGroup is not NULL,       */
+/*      only a job of that group is returned.                           */
+/************************************************************************/
+
+CPLWorkerThreadJob* CPLWorkerThreadPool::PopJob( CPLJobGroup* poGroup )
+
+{
+    CPLWorkerThreadJob *psPrev = NULL;
+    CPLWorkerThreadJob *psJob = psJobListHead;
+
+    while( psJob != NULL && poGroup != NULL && psJob->poGroup != poGroup )
+    {
+        psPrev = psJob;
+        psJob = psJob->psNext;
+    }
+
+    if( psJob == NULL )
+        return NULL;
+
+    if( psPrev == NULL )
+        psJobListHead = psJob->psNext;
+    else
+        psPrev->psNext = psJob->psNext;
+    if( psJobListTail == psJob )
+        psJobListTail = psPrev;
+
+    return psJob;
+}
+
+/************************************************************************/
+/*                               RunJob()                               */
+/*                                                                      */
+/*      Must be called with hMutex held, which is released while the    */
+/*      job runs.                                                       */
+/************************************************************************/
+
+void CPLWorkerThreadPool::RunJob( CPLWorkerThreadJob* psJob )
+
+{
+    CPLReleaseMutex( hMutex );
+
+    psJob->pfnFunc( psJob->pData );
+
+    CPLAcquireMutex( hMutex, 1000.0 );
+
+    psJob->poGroup->nPendingJobs --;
+    CPLCondBroadcast( hCondJobDone );
+
+    CPLFree( psJob );
+}
+
+/************************************************************************/
+/*                        WorkerThreadFunction()                        */
+/************************************************************************/
+
+void CPLWorkerThreadPool::WorkerThreadFunction( void* pData )
+
+{
+    CPLWorkerThreadPool* poPool = (CPLWorkerThreadPool*) pData;
+
+    CPLAcquireMutex( poPool->hMutex, 1000.0 );
+    for( ;; )
+    {
+        CPLWorkerThreadJob* psJob = poPool->PopJob( NULL );
+        if( psJob != NULL )
+        {
+            poPool->RunJob( psJob );
+            continue;
+        }
+
+        if( poPool->bStop )
+            break;
+
+        CPLCondWait( poPool->hCondJobAvailable, poPool->hMutex );
+    }
+    CPLReleaseMutex( poPool->hMutex );
+}
+
+/************************************************************************/
+/*                             SubmitJob()                              */
+/************************************************************************/
+
+/**
+ * Queue a job to be run by one of the worker threads.
+ *
+ * If the pool has no thread, the job is run immediately in the calling
+ * thread.
+ *
+ * @param pfnFunc function to run.
+ * @param pData user data passed to pfnFunc.
+ * @param poGroup group the job belongs to, used by WaitCompletion().
+ */
+
+void CPLWorkerThreadPool::SubmitJob( CPLThreadFunc pfnFunc, void* pData,
+                                     CPLJobGroup* poGroup )
+
+{
+    CPLAssert( poGroup != NULL );
+
+    if( nThreads == 0 )
+    {
+        pfnFunc( pData );
+        return;
+    }
+
+    CPLWorkerThreadJob* psJob =
+        (CPLWorkerThreadJob*) CPLMalloc( sizeof(CPLWorkerThreadJob) );
+    psJob->pfnFunc = pfnFunc;
+    psJob->pData = pData;
+    psJob->poGroup = poGroup;
+    psJob->psNext = NULL;
+
+    CPLMutexHolderOptionalLockD( hMutex );
+
+    poGroup->nPendingJobs ++;
+    if( psJobListTail == NULL )
+        psJobListHead = psJob;
+    else
+        psJobListTail->psNext = psJob;
+    psJobListTail = psJob;
+
+    CPLCondSignal( hCondJobAvailable );
+}
+
+/************************************************************************/
+/*                           RunPendingJob()                            */
+/************************************************************************/
+
+/**
+ * Run in the calling thread a job of the group that no worker thread has
+ * started yet.
+ *
+ * This is useful for callers that wait for the completion of their jobs
+ * in their own way, to make sure they cannot wait forever when all the
+ * worker threads are busy.
+ *
+ * @return TRUE if a job was run, FALSE if there was no pending job.
+ */
+
+int CPLWorkerThreadPool::RunPendingJob( CPLJobGroup* poGroup )
+
+{
+    if( nThreads == 0 )
+        return FALSE;
+
+    CPLMutexHolderOptionalLockD( hMutex );
+
+    CPLWorkerThreadJob* psJob = PopJob( poGroup );
+    if( psJob == NULL )
+        return FALSE;
+
+    RunJob( psJob );
+    return TRUE;
+}
+
+/************************************************************************/
+/*                           WaitCompletion()                           */
+/************************************************************************/
+
+/**
+ * Wait until all the jobs of the group are finished.
+ *
+ * Jobs of the group that are still queued are run in the calling thread,
+ * so that it is safe to call this method from a job.
+ */
+
+void CPLWorkerThreadPool::WaitCompletion( CPLJobGroup* poGroup )
+
+{
+    if( nThreads == 0 )
+        return;
+
+    CPLMutexHolderOptionalLockD( hMutex );
+
+    while( poGroup->nPendingJobs > 0 )
+    {
+        CPLWorkerThreadJob* psJob = PopJob( poGroup );
+        if( psJob != NULL )
+            RunJob( psJob );
+        else
+            CPLCondWait( hCondJobDone, hMutex );
+    }
+}
+
+/************************************************************************/
+/*                       CPLGetWorkerThreadPool()                       */
+/************************************************************************/
+
+/**
+ * Return the process-wide worker thread pool.
+ *
+ * The pool is created at the first call with the number of threads
+ * specified by the GDAL_NUM_THREADS configuration option (ALL_CPUS by
+ * default).  This is only an initial size, not an upper bound: the pool is
+ * grown whenever a caller asks for more than the current number of threads
+ * with nMinThreads, for example from an explicit NUM_THREADS option, up to
+ * a hard limit of 128 threads.  Callers are responsible for bounding the
+ * number of jobs they submit at the same time.  Threads are only destroyed
+ * by CPLCleanupWorkerThreadPool().
+ *
+ * @param nMinThreads minimum number of worker threads wished (at most 128).
+ * @return the pool, or NULL if no thread can be created.
+ */
+
+CPLWorkerThreadPool *CPLGetWorkerThreadPool( int nMinThreads )
+
+{
+    CPLMutexHolderD( &hGlobalWorkerThreadPoolMutex );
+
+    if( nMinThreads > 128 )
+        nMinThreads = 128;
+
+    int nNewThreads = 0;
+    if( poGlobalWorkerThreadPool == NULL )
+    {
+        const char* pszThreads =
+            CPLGetConfigOption("GDAL_NUM_THREADS", "ALL_CPUS");
+        if( EQUAL(pszThreads, "ALL_CPUS") )
+            nNewThreads = CPLGetNumCPUs();
+        else
+            nNewThreads = atoi(pszThreads);
+        if( nNewThreads > 128 )
+            nNewThreads = 128;
+        if( nNewThreads < nMinThreads )
+            nNewThreads = nMinThreads;
+
+        poGlobalWorkerThreadPool = new CPLWorkerThreadPool();
+    }
+    else if( poGlobalWorkerThreadPool->GetThreadCount() < nMinThreads )
+        nNewThreads = nMinThreads - poGlobalWorkerThreadPool->GetThreadCount();
+
+    if( nNewThreads > 0 &&
+        !poGlobalWorkerThreadPool->AddThreads( nNewThreads ) )
+    {
+        CPLDebug( "CPL", "Could not start %d worker threads", nNewThreads );
+    }
+
+    if( poGlobalWorkerThreadPool->GetThreadCount() == 0 )
+        return NULL;
+
+    return poGlobalWorkerThreadPool;
+}
+
+/************************************************************************/
+/*                     CPLCleanupWorkerThreadPool()                     */
+/************************************************************************/
+
+/**
+ * Stop the worker threads of the process-wide pool.
+ *
+ * Must not be called while jobs are running.
+ */
+
+void CPLCleanupWorkerThreadPool()
+
+{
+    delete poGlobalWorkerThreadPool;
+    poGlobalWorkerThreadPool = NULL;
+
+    if( hGlobalWorkerThreadPoolMutex != NULL )
+        CPLDestroyMutex( hGlobalWorkerThreadPoolMutex );
+    hGlobalWorkerThreadPoolMutex = NULL;
+}
@@ -128,7 +128,7 @@ class CPL_DLL CPLMutexHolder
 #define CTLS_ERRORCONTEXT               5         /* cpl_error.cpp */
 #define CTLS_GDALDATASET_REC_PROTECT_MAP 6        /* gdaldataset.cpp */
 #define CTLS_PATHBUF                    7         /* cpl_path.cpp */
-#define CTLS_UNUSED3                    8
+#define CTLS_GDALRASTERBLOCK_NODIRTYFLUSH 8       /* gdalrasterblock.cpp */
 #define CTLS_UNUSED4                    9
 #define CTLS_CPLSPRINTF                10         /* cpl_string.h */
 #define CTLS_RESPONSIBLEPID            11         /* gdaldataset.cpp */
@@ -151,4 +151,64 @@ void CPL_DLL CPLSetTLSWithFreeFunc( int nIndex, void *pData, CPLTLSFreeFunc pfnF
 void CPL_DLL CPLCleanupTLS( void );
 CPL_C_END
 
+/* -------------------------------------------------------------------- */
+/*      Worker thread pool.                                             */
+/* -------------------------------------------------------------------- */
+
+CPL_C_START
+void CPL_DLL CPLCleanupWorkerThreadPool( void );
+CPL_C_END
+
+#ifdef __cplusplus
+
+typedef struct _CPLWorkerThreadJob CPLWorkerThreadJob;
+
+/** Set of jobs submitted to a CPLWorkerThreadPool that can be waited for
+  * together. */
+class CPL_DLL CPLJobGroup
+{
+    friend class CPLWorkerThreadPool;
+
+    int         nPendingJobs;
+
+  public:
+                CPLJobGroup() : nPendingJobs(0) {}
+};
+
+/** Pool of threads that run submitted jobs, so that the cost of creating
+  * and destroying threads is not paid for each parallelized task. */
+class CPL_DLL CPLWorkerThreadPool
+{
+    void               *hMutex;
+    void               *hCondJobAvailable;
+    void               *hCondJobDone;
+    int                 bStop;
+
+    int                 nThreads;
+    void              **pahThreads;
+
+    CPLWorkerThreadJob *psJobListHead;
+    CPLWorkerThreadJob *psJobListTail;
+
+    static void         WorkerThreadFunction( void* pData );
+    CPLWorkerThreadJob *PopJob( CPLJobGroup* poGroup );
+    void                RunJob( CPLWorkerThreadJob* psJob );
+
+  public:
+                        CPLWorkerThreadPool();
+                       ~CPLWorkerThreadPool();
+
+    int                 AddThreads( int nNewThreads );
+    int                 GetThreadCount() const { return nThreads; }
+
+    void                SubmitJob( CPLThreadFunc pfnFunc, void* pData,
+                                   CPLJobGroup* poGroup );
+    int                 RunPendingJob( CPLJobGroup* poGroup );
+    void                WaitCompletion( CPLJobGroup* poGroup );
+};
+
+CPLWorkerThreadPool CPL_DLL *CPLGetWorkerThreadPool( int nMinThreads );
+
+#endif /* def __cplusplus */
+
 #endif /* _CPL_MULTIPROC_H_INCLUDED_ */
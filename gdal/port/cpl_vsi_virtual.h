@@ -190,7 +190,18 @@ public:
 };
 
 VSIVirtualHandle* VSICreateBufferedReaderHandle(VSIVirtualHandle* poBaseHandle);
-VSIVirtualHandle* VSICreateCachedFile( VSIVirtualHandle* poBaseHandle, size_t nChunkSize = 32768, size_t nCacheSize = 0 );
+VSIVirtualHandle* VSICreateReadAheadHandle( VSIVirtualHandle* poBaseHandle, int nBlocks = 0, size_t nBlockSize = 0 );
+VSIVirtualHandle* VSICreateReadAheadHandleIfNeeded( VSIVirtualHandle* poBaseHandle );
+VSIVirtualHandle* VSICreateCachedFile( VSIVirtualHandle* poBaseHandle, size_t nChunkSize = 32768, size_t nCacheSize = 0, const char* pszFilename = NULL );
 VSIVirtualHandle* VSICreateGZipWritable( VSIVirtualHandle* poBaseHandle, int bRegularZLibIn, int bAutoCloseBaseHandle );
 
+int  VSIBlockCacheRead( const char* pszKey, vsi_l_offset nBlockOffset,
+                        size_t nOffsetInBlock, void* pDest, size_t nDestSize,
+                        size_t* pnBlockSize );
+void VSIBlockCacheAdd( const char* pszKey, vsi_l_offset nBlockOffset,
+                       const void* pData, size_t nSize );
+void VSIBlockCacheInvalidate( const char* pszKey );
+void VSIBlockCacheInvalidateFile( const char* pszFilename );
+void VSIBlockCacheCleanup();
+
 #endif /* ndef CPL_VSI_VIRTUAL_H_INCLUDED */
@@ -1202,6 +1202,8 @@ void VSICleanupFileManager()
         poManager = NULL;
     }
 
+    VSIBlockCacheCleanup();
+
     if( hVSIFileManagerMutex != NULL )
     {
         CPLDestroyMutex(hVSIFileManagerMutex);
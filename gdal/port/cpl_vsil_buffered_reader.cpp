@@ -67,9 +67,12 @@ class VSIBufferedReaderHandle : public VSIVirtualHandle
 /*                    VSICreateBufferedReaderHandle()                   */
 /************************************************************************/
 
+/* If VSI_READAHEAD is set, the base handle is read in a background thread */
+
 VSIVirtualHandle* VSICreateBufferedReaderHandle(VSIVirtualHandle* poBaseHandle)
 {
-    return new VSIBufferedReaderHandle(poBaseHandle);
+    return new VSIBufferedReaderHandle(
+        VSICreateReadAheadHandleIfNeeded(poBaseHandle));
 }
 
 /************************************************************************/
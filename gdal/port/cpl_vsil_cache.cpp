@@ -29,47 +29,334 @@
  ****************************************************************************/
 
 #include "cpl_vsi_virtual.h"
+#include "cpl_hash_set.h"
+#include "cpl_multiproc.h"
 
 CPL_CVSID("$Id$");
 
 /************************************************************************/
 /* ==================================================================== */
-/*                             VSICacheChunk                            */
+/*                           VSIBlockCache                              */
 /* ==================================================================== */
+/*                                                                      */
+/*      Process-wide cache of file blocks, shared by the VSICachedFile  */
+/*      handles and the /vsicurl/ handlers.  Blocks are identified by   */
+/*      a key (typically a file name or URL) and their offset in the    */
+/*      file, and looked up through a hash set.  The total amount of    */
+/*      cached data is bounded by the VSI_CACHE_SIZE configuration      */
+/*      option, and least recently used blocks are evicted first.      */
+/************************************************************************/
+
+typedef struct _VSIBlockCacheEntry VSIBlockCacheEntry;
+
+struct _VSIBlockCacheEntry
+{
+    char               *pszKey;
+    unsigned long       nKeyHash;
+    vsi_l_offset        nOffset;
+    size_t              nSize;
+    GByte              *pabyData;
+
+    /* LRU list : psPrev is more recently used, psNext less recently used */
+    VSIBlockCacheEntry *psPrev;
+    VSIBlockCacheEntry *psNext;
+};
+
+static void               *hBlockCacheMutex = NULL;
+static CPLHashSet         *hBlockCacheSet = NULL;
+static VSIBlockCacheEntry *psBlockCacheMRU = NULL;
+static VSIBlockCacheEntry *psBlockCacheLRU = NULL;
+static GUIntBig            nBlockCacheUsed = 0;
+
+/************************************************************************/
+/*                       VSIBlockCacheHashFunc()                        */
+/************************************************************************/
+
+static unsigned long VSIBlockCacheHashFunc( const void* elt )
+{
+    const VSIBlockCacheEntry* psEntry = (const VSIBlockCacheEntry*) elt;
+    GUIntBig nOffset = (GUIntBig) psEntry->nOffset;
+    return psEntry->nKeyHash ^ (unsigned long)(nOffset ^ (nOffset >> 32));
+}
+
+/************************************************************************/
+/*                       VSIBlockCacheEqualFunc()                       */
+/************************************************************************/
+
+static int VSIBlockCacheEqualFunc( const void* elt1, const void* elt2 )
+{
+    const VSIBlockCacheEntry* psEntry1 = (const VSIBlockCacheEntry*) elt1;
+    const VSIBlockCacheEntry* psEntry2 = (const VSIBlockCacheEntry*) elt2;
+    return psEntry1->nOffset == psEntry2->nOffset &&
+           psEntry1->nKeyHash == psEntry2->nKeyHash &&
+           strcmp(psEntry1->pszKey, psEntry2->pszKey) == 0;
+}
+
+/************************************************************************/
+/*                       VSIBlockCacheFreeFunc()                        */
+/************************************************************************/
+
+static void VSIBlockCacheFreeFunc( void* elt )
+{
+    VSIBlockCacheEntry* psEntry = (VSIBlockCacheEntry*) elt;
+    CPLFree(psEntry->pszKey);
+    CPLFree(psEntry->pabyData);
+    CPLFree(psEntry);
+}
+
+/************************************************************************/
+/*                        VSIBlockCacheUnlink()                         */
+/*                                                                      */
+/*      Remove an entry from the LRU list. Must be called with the      */
+/*      mutex held.                                                     */
 /************************************************************************/
 
-class VSICacheChunk
+static void VSIBlockCacheUnlink( VSIBlockCacheEntry* psEntry )
 {
-public:
-    VSICacheChunk() 
-    { 
-        poLRUPrev = poLRUNext = NULL;
-        nDataFilled = 0;
-        bDirty = FALSE;
-        pabyData = NULL;
+    if( psEntry->psPrev )
+        psEntry->psPrev->psNext = psEntry->psNext;
+    else
+        psBlockCacheMRU = psEntry->psNext;
+    if( psEntry->psNext )
+        psEntry->psNext->psPrev = psEntry->psPrev;
+    else
+        psBlockCacheLRU = psEntry->psPrev;
+    psEntry->psPrev = psEntry->psNext = NULL;
+}
+
+/************************************************************************/
+/*                       VSIBlockCachePushFront()                       */
+/************************************************************************/
+
+static void VSIBlockCachePushFront( VSIBlockCacheEntry* psEntry )
+{
+    psEntry->psPrev = NULL;
+    psEntry->psNext = psBlockCacheMRU;
+    if( psBlockCacheMRU )
+        psBlockCacheMRU->psPrev = psEntry;
+    psBlockCacheMRU = psEntry;
+    if( psBlockCacheLRU == NULL )
+        psBlockCacheLRU = psEntry;
+}
+
+/************************************************************************/
+/*                        VSIBlockCacheRemove()                         */
+/************************************************************************/
+
+static void VSIBlockCacheRemove( VSIBlockCacheEntry* psEntry )
+{
+    VSIBlockCacheUnlink(psEntry);
+    nBlockCacheUsed -= psEntry->nSize;
+    /* Frees the entry */
+    CPLHashSetRemove(hBlockCacheSet, psEntry);
+}
+
+/************************************************************************/
+/*                         VSIBlockCacheRead()                          */
+/************************************************************************/
+
+/**
+ * \brief Read from a block of the shared VSI block cache.
+ *
+ * If the block identified by pszKey and nBlockOffset is in the cache, up to
+ * nDestSize bytes are copied into pDest starting at nOffsetInBlock, and the
+ * block becomes the most recently used one. A nDestSize of 0 can be used to
+ * test whether the block is cached.
+ *
+ * @param pszKey key of the file (file name, URL, ...)
+ * @param nBlockOffset offset of the start of the block in the file.
+ * @param nOffsetInBlock offset in the block from which to copy.
+ * @param pDest destination buffer (may be NULL if nDestSize == 0).
+ * @param nDestSize maximum number of bytes to copy.
+ * @param pnBlockSize if not NULL, set to the size of the cached block.
+ *
+ * @return TRUE if the block was found in the cache.
+ */
+
+int VSIBlockCacheRead( const char* pszKey, vsi_l_offset nBlockOffset,
+                       size_t nOffsetInBlock, void* pDest, size_t nDestSize,
+                       size_t* pnBlockSize )
+{
+    CPLMutexHolderD(&hBlockCacheMutex);
+
+    if( hBlockCacheSet == NULL )
+        return FALSE;
+
+    VSIBlockCacheEntry sKey;
+    sKey.pszKey = (char*) pszKey;
+    sKey.nKeyHash = CPLHashSetHashStr(pszKey);
+    sKey.nOffset = nBlockOffset;
+
+    VSIBlockCacheEntry* psEntry =
+        (VSIBlockCacheEntry*) CPLHashSetLookup(hBlockCacheSet, &sKey);
+    if( psEntry == NULL )
+        return FALSE;
+
+    if( psEntry != psBlockCacheMRU )
+    {
+        VSIBlockCacheUnlink(psEntry);
+        VSIBlockCachePushFront(psEntry);
     }
 
-    virtual ~VSICacheChunk()
+    if( nOffsetInBlock < psEntry->nSize && nDestSize > 0 )
     {
-        VSIFree( pabyData );
+        size_t nToCopy = MIN(nDestSize, psEntry->nSize - nOffsetInBlock);
+        memcpy(pDest, psEntry->pabyData + nOffsetInBlock, nToCopy);
     }
+    if( pnBlockSize )
+        *pnBlockSize = psEntry->nSize;
 
-    bool Allocate( size_t nChunkSize )
+    return TRUE;
+}
+
+/************************************************************************/
+/*                          VSIBlockCacheAdd()                          */
+/************************************************************************/
+
+/**
+ * \brief Add (or replace) a block in the shared VSI block cache.
+ *
+ * The data is copied. A block of size 0 can be added to record that
+ * nBlockOffset is beyond the end of the file. Least recently used blocks
+ * are evicted so that the total size of the cache does not exceed the
+ * value of the VSI_CACHE_SIZE configuration option (25 MB by default).
+ * The block just added is always kept, even if it alone exceeds that size.
+ *
+ * @param pszKey key of the file (file name, URL, ...)
+ * @param nBlockOffset offset of the start of the block in the file.
+ * @param pData block data.
+ * @param nSize size of the block data.
+ */
+
+void VSIBlockCacheAdd( const char* pszKey, vsi_l_offset nBlockOffset,
+                       const void* pData, size_t nSize )
+{
+    GUIntBig nCacheMax = CPLScanUIntBig(
+        CPLGetConfigOption( "VSI_CACHE_SIZE", "25000000" ), 40 );
+
+    GByte* pabyData = NULL;
+    if( nSize > 0 )
     {
-        CPLAssert( pabyData == NULL );
-        pabyData = (GByte *)VSIMalloc( nChunkSize );
-        return (pabyData != NULL);
+        pabyData = (GByte*) VSIMalloc(nSize);
+        if( pabyData == NULL )
+            return;
+        memcpy(pabyData, pData, nSize);
     }
 
-    int            bDirty;
-    vsi_l_offset   iBlock;
+    CPLMutexHolderD(&hBlockCacheMutex);
 
-    VSICacheChunk *poLRUPrev;
-    VSICacheChunk *poLRUNext;
+    if( hBlockCacheSet == NULL )
+        hBlockCacheSet = CPLHashSetNew(VSIBlockCacheHashFunc,
+                                       VSIBlockCacheEqualFunc,
+                                       VSIBlockCacheFreeFunc);
 
-    vsi_l_offset   nDataFilled;
-    GByte          *pabyData;
-};
+    VSIBlockCacheEntry sKey;
+    sKey.pszKey = (char*) pszKey;
+    sKey.nKeyHash = CPLHashSetHashStr(pszKey);
+    sKey.nOffset = nBlockOffset;
+
+    VSIBlockCacheEntry* psEntry =
+        (VSIBlockCacheEntry*) CPLHashSetLookup(hBlockCacheSet, &sKey);
+    if( psEntry != NULL )
+    {
+        /* Another handle might have loaded the same block concurrently */
+        VSIBlockCacheUnlink(psEntry);
+        nBlockCacheUsed -= psEntry->nSize;
+        CPLFree(psEntry->pabyData);
+    }
+    else
+    {
+        psEntry = (VSIBlockCacheEntry*) CPLMalloc(sizeof(VSIBlockCacheEntry));
+        psEntry->pszKey = CPLStrdup(pszKey);
+        psEntry->nKeyHash = sKey.nKeyHash;
+        psEntry->nOffset = nBlockOffset;
+        CPLHashSetInsert(hBlockCacheSet, psEntry);
+    }
+    psEntry->nSize = nSize;
+    psEntry->pabyData = pabyData;
+    VSIBlockCachePushFront(psEntry);
+    nBlockCacheUsed += nSize;
+
+    while( nBlockCacheUsed > nCacheMax && psBlockCacheLRU != psEntry )
+        VSIBlockCacheRemove(psBlockCacheLRU);
+}
+
+/************************************************************************/
+/*                       VSIBlockCacheInvalidate()                      */
+/************************************************************************/
+
+/**
+ * \brief Remove all the blocks of a file from the shared VSI block cache.
+ *
+ * @param pszKey key of the file (file name, URL, ...)
+ */
+
+void VSIBlockCacheInvalidate( const char* pszKey )
+{
+    CPLMutexHolderD(&hBlockCacheMutex);
+
+    VSIBlockCacheEntry* psEntry = psBlockCacheMRU;
+    while( psEntry != NULL )
+    {
+        VSIBlockCacheEntry* psNext = psEntry->psNext;
+        if( strcmp(psEntry->pszKey, pszKey) == 0 )
+            VSIBlockCacheRemove(psEntry);
+        psEntry = psNext;
+    }
+}
+
+/************************************************************************/
+/*                     VSIBlockCacheInvalidateFile()                    */
+/************************************************************************/
+
+/**
+ * \brief Remove the blocks shared by the VSICachedFile handles of a file.
+ *
+ * File handlers call this when a file is modified, renamed or removed. The
+ * key of the shared blocks includes the size and modification time of the
+ * file, but a file rewritten with the same size within the same second would
+ * otherwise still be served from the blocks of its previous content.
+ *
+ * @param pszFilename name of the file, as passed to VSICreateCachedFile().
+ */
+
+void VSIBlockCacheInvalidateFile( const char* pszFilename )
+{
+    CPLMutexHolderD(&hBlockCacheMutex);
+
+    /* Shared keys are "filename:size:mtime:chunksize" */
+    size_t nLen = strlen(pszFilename);
+    VSIBlockCacheEntry* psEntry = psBlockCacheMRU;
+    while( psEntry != NULL )
+    {
+        VSIBlockCacheEntry* psNext = psEntry->psNext;
+        if( strncmp(psEntry->pszKey, pszFilename, nLen) == 0 &&
+            psEntry->pszKey[nLen] == ':' )
+            VSIBlockCacheRemove(psEntry);
+        psEntry = psNext;
+    }
+}
+
+/************************************************************************/
+/*                        VSIBlockCacheCleanup()                        */
+/************************************************************************/
+
+void VSIBlockCacheCleanup()
+{
+    if( hBlockCacheSet != NULL )
+    {
+        CPLHashSetDestroy(hBlockCacheSet);
+        hBlockCacheSet = NULL;
+    }
+    psBlockCacheMRU = psBlockCacheLRU = NULL;
+    nBlockCacheUsed = 0;
+
+    if( hBlockCacheMutex != NULL )
+    {
+        CPLDestroyMutex(hBlockCacheMutex);
+        hBlockCacheMutex = NULL;
+    }
+}
 
 /************************************************************************/
 /* ==================================================================== */
@@ -81,30 +368,22 @@ class VSICachedFile : public VSIVirtualHandle
 { 
   public:
     VSICachedFile( VSIVirtualHandle *poBaseHandle, 
-                   size_t nChunkSize,
-                   size_t nCacheSize );
+                   const char* pszFilename,
+                   size_t nChunkSize );
     ~VSICachedFile() { Close(); }
 
-    void          FlushLRU();
     int           LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount, 
                               void *pBuffer, size_t nBufferSize );
-    void          Demote( VSICacheChunk * );
 
     VSIVirtualHandle *poBase;
-    
+    CPLString     osKey;
+    int           bSharedKey;
+
     vsi_l_offset  nOffset;
     vsi_l_offset  nFileSize;
 
-    GUIntBig      nCacheUsed;
-    GUIntBig      nCacheMax;
-
     size_t        nChunkSize;
 
-    VSICacheChunk *poLRUStart;
-    VSICacheChunk *poLRUEnd;
-
-    std::vector<VSICacheChunk*> apoCache;
-
     int            bEOF;
 
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
@@ -121,25 +400,33 @@ class VSICachedFile : public VSIVirtualHandle
 /*                           VSICachedFile()                            */
 /************************************************************************/
 
-VSICachedFile::VSICachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize, size_t nCacheSize )
+VSICachedFile::VSICachedFile( VSIVirtualHandle *poBaseHandle,
+                              const char* pszFilename, size_t nChunkSize )
 
 {
     poBase = poBaseHandle;
     this->nChunkSize = nChunkSize;
 
-    nCacheUsed = 0;
-    if ( nCacheSize == 0 )
-        nCacheMax = CPLScanUIntBig( 
-             CPLGetConfigOption( "VSI_CACHE_SIZE", "25000000" ), 40 );
-    else
-        nCacheMax = nCacheSize;
-
-    poLRUStart = NULL;
-    poLRUEnd = NULL;
-
     poBase->Seek( 0, SEEK_END );
     nFileSize = poBase->Tell();
 
+/* -------------------------------------------------------------------- */
+/*      Handles opened on the same, unmodified, file share their        */
+/*      blocks. Otherwise use a key private to this handle.             */
+/* -------------------------------------------------------------------- */
+    VSIStatBufL sStat;
+    bSharedKey = FALSE;
+    if( pszFilename != NULL && VSIStatL( pszFilename, &sStat ) == 0 &&
+        (vsi_l_offset)sStat.st_size == nFileSize )
+    {
+        osKey.Printf( "%s:" CPL_FRMT_GUIB ":" CPL_FRMT_GIB ":%d",
+                      pszFilename, (GUIntBig)nFileSize,
+                      (GIntBig)sStat.st_mtime, (int)nChunkSize );
+        bSharedKey = TRUE;
+    }
+    else
+        osKey.Printf( "VSICachedFile:%p", this );
+
     nOffset = 0;
     bEOF = FALSE;
 }
@@ -151,19 +438,11 @@ VSICachedFile::VSICachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize,
 int VSICachedFile::Close()
 
 {
-    size_t i;
-    for( i = 0; i < apoCache.size(); i++ )
-        delete apoCache[i];
-
-    apoCache.resize( 0 );
-
-    poLRUStart = NULL;
-    poLRUEnd = NULL;
-
-    nCacheUsed = 0;
-
     if( poBase )
     {
+        if( !bSharedKey )
+            VSIBlockCacheInvalidate( osKey );
+
         poBase->Close();
         delete poBase;
         poBase = NULL;
@@ -211,75 +490,11 @@ vsi_l_offset VSICachedFile::Tell()
     return nOffset;
 }
 
-/************************************************************************/
-/*                              FlushLRU()                              */
-/************************************************************************/
-
-void VSICachedFile::FlushLRU()
-
-{
-    CPLAssert( poLRUStart != NULL );
-
-    VSICacheChunk *poBlock = poLRUStart;
-
-    CPLAssert( nCacheUsed >= poBlock->nDataFilled );
-
-    nCacheUsed -= poBlock->nDataFilled;
-    
-    poLRUStart = poBlock->poLRUNext;
-    if( poLRUEnd == poBlock )
-        poLRUEnd = NULL;
-
-    if( poBlock->poLRUNext != NULL )
-        poBlock->poLRUNext->poLRUPrev = NULL;
-
-    CPLAssert( !poBlock->bDirty );
-
-    apoCache[poBlock->iBlock] = NULL;
-
-    delete poBlock;
-}
-
-/************************************************************************/
-/*                               Demote()                               */
-/*                                                                      */
-/*      Demote the indicated block to the end of the LRU list.          */
-/*      Potentially integrate the link into the list if it is not       */
-/*      already there.                                                  */
-/************************************************************************/
-
-void VSICachedFile::Demote( VSICacheChunk *poBlock )
-
-{
-    // already at end?
-    if( poLRUEnd == poBlock )
-        return;
-    
-    if( poLRUStart == poBlock )
-        poLRUStart = poBlock->poLRUNext;
-
-    if( poBlock->poLRUPrev != NULL )
-        poBlock->poLRUPrev->poLRUNext = poBlock->poLRUNext;
-
-    if( poBlock->poLRUNext != NULL )
-        poBlock->poLRUNext->poLRUPrev = poBlock->poLRUPrev;
-
-    poBlock->poLRUNext = NULL;
-    poBlock->poLRUPrev = NULL;
-
-    if( poLRUEnd != NULL )
-        poLRUEnd->poLRUNext = poBlock;
-    poLRUEnd = poBlock;
-    
-    if( poLRUStart == NULL )
-        poLRUStart = poBlock;
-}
-
 /************************************************************************/
 /*                             LoadBlocks()                             */
 /*                                                                      */
-/*      Load the desired set of blocks.  Use pBuffer as a temporary     */
-/*      buffer if it would be helpful.                                  */
+/*      Load the desired set of blocks into the shared cache.  Use      */
+/*      pBuffer as a temporary buffer if it would be helpful.           */
 /************************************************************************/
 
 int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
@@ -289,36 +504,6 @@ int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
     if( nBlockCount == 0 )
         return 1;
 
-    if( apoCache.size() < nStartBlock + nBlockCount )
-        apoCache.resize( nStartBlock + nBlockCount );
-
-/* -------------------------------------------------------------------- */
-/*      When we want to load only one block, we can directly load it    */
-/*      into the target buffer with no concern about intermediaries.    */
-/* -------------------------------------------------------------------- */
-    if( nBlockCount == 1 )
-    {
-        poBase->Seek( (vsi_l_offset)nStartBlock * nChunkSize, SEEK_SET );
-
-        VSICacheChunk *poBlock = new VSICacheChunk();
-        if ( !poBlock || !poBlock->Allocate( nChunkSize ) )
-        {
-            delete poBlock;
-            return 0;
-        }
-
-        apoCache[nStartBlock] = poBlock;
-
-        poBlock->iBlock = nStartBlock;
-        poBlock->nDataFilled = poBase->Read( poBlock->pabyData, 1, nChunkSize );
-        nCacheUsed += poBlock->nDataFilled;
-
-        // Merges into the LRU list. 
-        Demote( poBlock );
-
-        return 1;
-    }
-
 /* -------------------------------------------------------------------- */
 /*      If the buffer is quite large but not quite large enough to      */
 /*      hold all the blocks we will take the pain of splitting the      */
@@ -340,52 +525,40 @@ int VSICachedFile::LoadBlocks( vsi_l_offset nStartBlock, size_t nBlockCount,
     GByte *pabyWorkBuffer = (GByte *) pBuffer;
 
     if( nBufferSize < nChunkSize * nBlockCount )
-        pabyWorkBuffer = (GByte *) CPLMalloc(nChunkSize * nBlockCount);
+    {
+        pabyWorkBuffer = (GByte *) VSIMalloc(nChunkSize * nBlockCount);
+        if( pabyWorkBuffer == NULL )
+            return 0;
+    }
 
 /* -------------------------------------------------------------------- */
 /*      Read the whole request into the working buffer.                 */
 /* -------------------------------------------------------------------- */
-    if( poBase->Seek( (vsi_l_offset)nStartBlock * nChunkSize, SEEK_SET ) != 0 )
-        return 0;
-
-    size_t nDataRead = poBase->Read( pabyWorkBuffer, 1, nBlockCount*nChunkSize);
-
-    if( nBlockCount * nChunkSize > nDataRead + nChunkSize - 1 )
-        nBlockCount = (nDataRead + nChunkSize - 1) / nChunkSize;
-
-    for( size_t i = 0; i < nBlockCount; i++ )
+    int bRet = FALSE;
+    if( poBase->Seek( (vsi_l_offset)nStartBlock * nChunkSize, SEEK_SET ) == 0 )
     {
-        VSICacheChunk *poBlock = new VSICacheChunk();
-        if ( !poBlock || !poBlock->Allocate( nChunkSize ) )
-        {
-            delete poBlock;
-            return 0;
-        }
-
-        poBlock->iBlock = nStartBlock + i;
-
-        CPLAssert( apoCache[i+nStartBlock] == NULL );
-
-        apoCache[i + nStartBlock] = poBlock;
-
-        if( nDataRead >= (i+1) * nChunkSize )
-            poBlock->nDataFilled = nChunkSize;
-        else
-            poBlock->nDataFilled = nDataRead - i*nChunkSize;
+        size_t nDataRead = poBase->Read( pabyWorkBuffer, 1,
+                                         nBlockCount*nChunkSize);
 
-        memcpy( poBlock->pabyData, pabyWorkBuffer + i*nChunkSize,
-                (size_t) poBlock->nDataFilled );
+        if( nBlockCount * nChunkSize > nDataRead + nChunkSize - 1 )
+            nBlockCount = (nDataRead + nChunkSize - 1) / nChunkSize;
 
-        nCacheUsed += poBlock->nDataFilled;
+        for( size_t i = 0; i < nBlockCount; i++ )
+        {
+            size_t nDataFilled = nChunkSize;
+            if( nDataRead < (i+1) * nChunkSize )
+                nDataFilled = nDataRead - i*nChunkSize;
 
-        // Merges into the LRU list. 
-        Demote( poBlock );
+            VSIBlockCacheAdd( osKey, (nStartBlock + i) * nChunkSize,
+                              pabyWorkBuffer + i*nChunkSize, nDataFilled );
+        }
+        bRet = TRUE;
     }
 
     if( pabyWorkBuffer != pBuffer )
         CPLFree( pabyWorkBuffer );
 
-    return 1;
+    return bRet;
 }
 
 /************************************************************************/
@@ -409,15 +582,18 @@ size_t VSICachedFile::Read( void * pBuffer, size_t nSize, size_t nCount )
 
     for( vsi_l_offset iBlock = nStartBlock; iBlock <= nEndBlock; iBlock++ )
     {
-        if( apoCache.size() <= iBlock || apoCache[iBlock] == NULL )
+        if( !VSIBlockCacheRead( osKey, iBlock * nChunkSize, 0,
+                                NULL, 0, NULL ) )
         {
             size_t nBlocksToLoad = 1;
             while( iBlock + nBlocksToLoad <= nEndBlock
-                   && (apoCache.size() <= iBlock+nBlocksToLoad 
-                       || apoCache[iBlock+nBlocksToLoad] == NULL) )
+                   && !VSIBlockCacheRead( osKey,
+                                          (iBlock + nBlocksToLoad) * nChunkSize,
+                                          0, NULL, 0, NULL ) )
                 nBlocksToLoad++;
 
             LoadBlocks( iBlock, nBlocksToLoad, pBuffer, nSize * nCount );
+            iBlock += nBlocksToLoad - 1;
         }
     }
     
@@ -429,45 +605,32 @@ size_t VSICachedFile::Read( void * pBuffer, size_t nSize, size_t nCount )
     while( nAmountCopied < nSize * nCount )
     {
         vsi_l_offset iBlock = (nOffset + nAmountCopied) / nChunkSize;
-        size_t nThisCopy;
-        VSICacheChunk *poBlock = apoCache[iBlock];
-        if( poBlock == NULL )
+        vsi_l_offset nStartOffset = (vsi_l_offset)iBlock * nChunkSize;
+        size_t nOffsetInBlock = (size_t)(nOffset + nAmountCopied - nStartOffset);
+        GByte *pabyDest = ((GByte *) pBuffer) + nAmountCopied;
+        size_t nToCopy = nSize * nCount - nAmountCopied;
+        size_t nBlockSize = 0;
+
+        if( !VSIBlockCacheRead( osKey, nStartOffset, nOffsetInBlock,
+                                pabyDest, nToCopy, &nBlockSize ) )
         {
             /* We can reach that point when the amount to read exceeds */
-            /* the cache size */
-            LoadBlocks( iBlock, 1, ((GByte *) pBuffer) + nAmountCopied,
-                        MIN(nSize * nCount - nAmountCopied, nChunkSize) );
-            poBlock = apoCache[iBlock];
-            CPLAssert(poBlock != NULL);
+            /* the cache size, or if another handle has evicted the block */
+            LoadBlocks( iBlock, 1, pabyDest, MIN(nToCopy, nChunkSize) );
+            if( !VSIBlockCacheRead( osKey, nStartOffset, nOffsetInBlock,
+                                    pabyDest, nToCopy, &nBlockSize ) )
+                break;
         }
 
-        vsi_l_offset nStartOffset = (vsi_l_offset)iBlock * nChunkSize;
-        nThisCopy = (size_t)
-            ((nStartOffset + poBlock->nDataFilled) 
-             - nAmountCopied - nOffset);
-        
-        if( nThisCopy > nSize * nCount - nAmountCopied )
-            nThisCopy = nSize * nCount - nAmountCopied;
-
-        if( nThisCopy == 0 )
+        if( nOffsetInBlock >= nBlockSize )
             break;
 
-        memcpy( ((GByte *) pBuffer) + nAmountCopied,
-                poBlock->pabyData 
-                + (nOffset + nAmountCopied) - nStartOffset, 
-                nThisCopy );
-
+        size_t nThisCopy = MIN(nToCopy, nBlockSize - nOffsetInBlock);
         nAmountCopied += nThisCopy;
     }
     
     nOffset += nAmountCopied;
 
-/* -------------------------------------------------------------------- */
-/*      Ensure the cache is reduced to our limit.                       */
-/* -------------------------------------------------------------------- */
-    while( nCacheUsed > nCacheMax )
-        FlushLRU();
-
     size_t nRet = nAmountCopied / nSize;
     if (nRet != nCount)
         bEOF = TRUE;
@@ -508,9 +671,22 @@ int VSICachedFile::Flush()
 /*                        VSICreateCachedFile()                         */
 /************************************************************************/
 
+/**
+ * \brief Create a read-only handle that caches blocks of a base handle.
+ *
+ * Blocks are stored in the process-wide VSI block cache, whose size is
+ * controlled by the VSI_CACHE_SIZE configuration option, so nCacheSize is
+ * ignored. When pszFilename is provided, handles opened on the same file
+ * (with the same size and modification time) share their cached blocks.
+ * Whoever modifies such a file must then call VSIBlockCacheInvalidateFile().
+ */
+
 VSIVirtualHandle *
-VSICreateCachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize, size_t nCacheSize )
+VSICreateCachedFile( VSIVirtualHandle *poBaseHandle, size_t nChunkSize,
+                     size_t nCacheSize, const char* pszFilename )
 
 {
-    return new VSICachedFile( poBaseHandle, nChunkSize, nCacheSize );
+    (void) nCacheSize;
+
+    return new VSICachedFile( poBaseHandle, pszFilename, nChunkSize );
 }
@@ -73,11 +73,10 @@ void CPLHTTPSetOptions(CURL *http_handle, char** papszOptions);
 void VSICurlSetOptions(CURL* hCurlHandle, const char* pszURL);
 
 #include <map>
+#include <vector>
 
 #define ENABLE_DEBUG 1
 
-#define N_MAX_REGIONS       1000
-
 #define DOWNLOAD_CHUNCK_SIZE    16384
 
 typedef enum
@@ -102,14 +101,6 @@ typedef struct
     char**          papszFileList; /* only file name without path */
 } CachedDirList;
 
-typedef struct
-{
-    unsigned long   pszURLHash;
-    vsi_l_offset    nFileOffsetStart;
-    size_t          nSize;
-    char           *pData;
-} CachedRegion;
-
 
 static const char* VSICurlGetCacheFileName()
 {
@@ -199,9 +190,6 @@ class VSICurlFilesystemHandler : public VSIFilesystemHandler
 {
     void           *hMutex;
 
-    CachedRegion  **papsRegions;
-    int             nRegions;
-
     std::map<CPLString, CachedFileProp*>   cacheFileSize;
     std::map<CPLString, CachedDirList*>        cacheDirList;
 
@@ -230,8 +218,11 @@ public:
     virtual char   **ReadDir( const char *pszDirname, int* pbGotFileList );
 
 
-    const CachedRegion* GetRegion(const char*     pszURL,
-                                  vsi_l_offset    nFileOffsetStart);
+    int                 GetRegion(const char*     pszURL,
+                                  vsi_l_offset    nOffset,
+                                  void           *pDest,
+                                  size_t          nDestSize,
+                                  size_t         *pnRegionSize);
 
     void                AddRegion(const char*     pszURL,
                                   vsi_l_offset    nFileOffsetStart,
@@ -240,8 +231,11 @@ public:
 
     CachedFileProp*     GetCachedFileProp(const char*     pszURL);
 
-    void                AddRegionToCacheDisk(CachedRegion* psRegion);
-    const CachedRegion* GetRegionFromCacheDisk(const char*     pszURL,
+    void                AddRegionToCacheDisk(const char*     pszURL,
+                                             vsi_l_offset    nFileOffsetStart,
+                                             size_t          nSize,
+                                             const char     *pData);
+    int                 GetRegionFromCacheDisk(const char*     pszURL,
                                                vsi_l_offset nFileOffsetStart);
 
     CURL               *GetCurlHandleFor(CPLString osURL);
@@ -271,6 +265,13 @@ class VSICurlHandle : public VSIVirtualHandle
 
     int             DownloadRegion(vsi_l_offset startOffset, int nBlocks);
 
+    int             MultipartReadMultiRange( int nRanges, void ** ppData,
+                                             const vsi_l_offset* panOffsets,
+                                             const size_t* panSizes );
+    int             ParallelReadMultiRange( int nRanges, void ** ppData,
+                                            const vsi_l_offset* panOffsets,
+                                            const size_t* panSizes );
+
     VSICurlReadCbkFunc  pfnReadCbk;
     void               *pReadCbkUserData;
     int                 bStopOnInterrruptUntilUninstall;
@@ -920,14 +921,17 @@ int VSICurlHandle::DownloadRegion(vsi_l_offset startOffset, int nBlocks)
                      nSize, nBlocks * DOWNLOAD_CHUNCK_SIZE);
     }
     
-    while(nSize > 0)
+    /* Add the regions from the last one, so that the first one, which */
+    /* the caller wants to read, is the most recently used in the cache */
+    int iRegion = (nSize + DOWNLOAD_CHUNCK_SIZE - 1) / DOWNLOAD_CHUNCK_SIZE;
+    while(--iRegion >= 0)
     {
+        int nRegionSize = MIN(DOWNLOAD_CHUNCK_SIZE,
+                              nSize - iRegion * DOWNLOAD_CHUNCK_SIZE);
         //if (ENABLE_DEBUG)
-        //    CPLDebug("VSICURL", "Add region %d - %d", startOffset, MIN(DOWNLOAD_CHUNCK_SIZE, nSize));
-        poFS->AddRegion(pszURL, startOffset, MIN(DOWNLOAD_CHUNCK_SIZE, nSize), pBuffer);
-        startOffset += DOWNLOAD_CHUNCK_SIZE;
-        pBuffer += DOWNLOAD_CHUNCK_SIZE;
-        nSize -= DOWNLOAD_CHUNCK_SIZE;
+        //    CPLDebug("VSICURL", "Add region %d - %d", startOffset, nRegionSize);
+        poFS->AddRegion(pszURL, startOffset + iRegion * DOWNLOAD_CHUNCK_SIZE,
+                        nRegionSize, pBuffer + iRegion * DOWNLOAD_CHUNCK_SIZE);
     }
 
     CPLFree(sWriteFuncData.pBuffer);
@@ -951,8 +955,10 @@ size_t VSICurlHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
     vsi_l_offset iterOffset = curOffset;
     while (nBufferRequestSize)
     {
-        const CachedRegion* psRegion = poFS->GetRegion(pszURL, iterOffset);
-        if (psRegion == NULL)
+        size_t nRegionSize = 0;
+        int bGotRegion = poFS->GetRegion(pszURL, iterOffset, pBuffer,
+                                         nBufferRequestSize, &nRegionSize);
+        if (!bGotRegion)
         {
             vsi_l_offset nOffsetToDownload =
                 (iterOffset / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
@@ -985,7 +991,8 @@ size_t VSICurlHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
             /* Avoid reading already cached data */
             for(i=1;i<nBlocksToDownload;i++)
             {
-                if (poFS->GetRegion(pszURL, nOffsetToDownload + i * DOWNLOAD_CHUNCK_SIZE) != NULL)
+                if (poFS->GetRegion(pszURL, nOffsetToDownload + i * DOWNLOAD_CHUNCK_SIZE,
+                                    NULL, 0, NULL))
                 {
                     nBlocksToDownload = i;
                     break;
@@ -998,20 +1005,20 @@ size_t VSICurlHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
                     bEOF = TRUE;
                 return 0;
             }
-            psRegion = poFS->GetRegion(pszURL, iterOffset);
+            bGotRegion = poFS->GetRegion(pszURL, iterOffset, pBuffer,
+                                         nBufferRequestSize, &nRegionSize);
         }
-        if (psRegion == NULL || psRegion->pData == NULL)
+        size_t nOffsetInRegion = (size_t)(iterOffset % DOWNLOAD_CHUNCK_SIZE);
+        if (!bGotRegion || nOffsetInRegion >= nRegionSize)
         {
             bEOF = TRUE;
             return 0;
         }
-        int nToCopy = (int) MIN(nBufferRequestSize, psRegion->nSize - (iterOffset - psRegion->nFileOffsetStart));
-        memcpy(pBuffer, psRegion->pData + iterOffset - psRegion->nFileOffsetStart,
-                nToCopy);
+        size_t nToCopy = MIN(nBufferRequestSize, nRegionSize - nOffsetInRegion);
         pBuffer = (char*) pBuffer + nToCopy;
         iterOffset += nToCopy;
         nBufferRequestSize -= nToCopy;
-        if (psRegion->nSize != DOWNLOAD_CHUNCK_SIZE && nBufferRequestSize != 0)
+        if (nRegionSize != DOWNLOAD_CHUNCK_SIZE && nBufferRequestSize != 0)
         {
             break;
         }
@@ -1027,6 +1034,45 @@ size_t VSICurlHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
 }
 
 
+/************************************************************************/
+/*                      VSICurlGetMultiRangeGap()                       */
+/************************************************************************/
+
+static vsi_l_offset VSICurlGetMultiRangeGap()
+{
+    /* Downloading a few unneeded bytes is cheaper than an extra range */
+    return (vsi_l_offset) atoi(CPLGetConfigOption("CPL_VSIL_CURL_MULTIRANGE_GAP",
+                                       CPLSPrintf("%d", DOWNLOAD_CHUNCK_SIZE)));
+}
+
+/************************************************************************/
+/*                        VSICurlMergeRanges()                          */
+/*                                                                      */
+/*      Group ranges (sorted by increasing offsets and not overlapping) */
+/*      that are at most nMaxGap bytes apart, so that they can be       */
+/*      downloaded as a single range. panGroupStart[] receives the      */
+/*      index of the first range of each group, followed by nRanges.    */
+/************************************************************************/
+
+static int VSICurlMergeRanges( int nRanges, const vsi_l_offset* panOffsets,
+                               const size_t* panSizes, vsi_l_offset nMaxGap,
+                               int* panGroupStart )
+{
+    int nGroups = 0;
+    vsi_l_offset nGroupEnd = 0;
+
+    for( int i = 0; i < nRanges; i++ )
+    {
+        if( i == 0 || panOffsets[i] < nGroupEnd ||
+            panOffsets[i] - nGroupEnd > nMaxGap )
+            panGroupStart[nGroups++] = i;
+        nGroupEnd = panOffsets[i] + panSizes[i];
+    }
+    panGroupStart[nGroups] = nRanges;
+
+    return nGroups;
+}
+
 /************************************************************************/
 /*                           ReadMultiRange()                           */
 /************************************************************************/
@@ -1035,9 +1081,6 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
                                    const vsi_l_offset* panOffsets,
                                    const size_t* panSizes )
 {
-    WriteFuncStruct sWriteFuncData;
-    WriteFuncStruct sWriteFuncHeaderData;
-
     if (bInterrupted && bStopOnInterrruptUntilUninstall)
         return FALSE;
 
@@ -1045,28 +1088,53 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
     if (cachedFileProp->eExists == EXIST_NO)
         return -1;
 
+    const char* pszMultiRange =
+        CPLGetConfigOption("CPL_VSIL_CURL_MULTIRANGE", "PARALLEL");
+    if (EQUAL(pszMultiRange, "SINGLE_GET"))
+        return MultipartReadMultiRange(nRanges, ppData, panOffsets, panSizes);
+    else if (EQUAL(pszMultiRange, "SERIAL"))
+        return VSIVirtualHandle::ReadMultiRange(nRanges, ppData,
+                                                panOffsets, panSizes);
+    else
+        return ParallelReadMultiRange(nRanges, ppData, panOffsets, panSizes);
+}
+
+/************************************************************************/
+/*                      MultipartReadMultiRange()                       */
+/*                                                                      */
+/*      Download all the ranges with a single multi-range HTTP request. */
+/************************************************************************/
+
+int VSICurlHandle::MultipartReadMultiRange( int nRanges, void ** ppData,
+                                            const vsi_l_offset* panOffsets,
+                                            const size_t* panSizes )
+{
+    WriteFuncStruct sWriteFuncData;
+    WriteFuncStruct sWriteFuncHeaderData;
+
     CPLString osRanges, osFirstRange, osLastRange;
     int i;
-    int nMergedRanges = 0;
+    int* panGroupStart = (int*) CPLMalloc((nRanges + 1) * sizeof(int));
+    int nMergedRanges = VSICurlMergeRanges(nRanges, panOffsets, panSizes,
+                                           VSICurlGetMultiRangeGap(),
+                                           panGroupStart);
     vsi_l_offset nTotalReqSize = 0;
-    for(i=0;i<nRanges;i++)
+    for(i=0;i<nMergedRanges;i++)
     {
+        vsi_l_offset nGroupStart = panOffsets[panGroupStart[i]];
+        int iLast = panGroupStart[i+1] - 1;
+        vsi_l_offset nGroupEnd = panOffsets[iLast] + panSizes[iLast];
+
         CPLString osCurRange;
         if (i != 0)
             osRanges.append(",");
-        osCurRange = CPLSPrintf(CPL_FRMT_GUIB "-", panOffsets[i]);
-        while (i + 1 < nRanges && panOffsets[i] + panSizes[i] == panOffsets[i+1])
-        {
-            nTotalReqSize += panSizes[i];
-            i ++;
-        }
-        nTotalReqSize += panSizes[i];
-        osCurRange.append(CPLSPrintf(CPL_FRMT_GUIB, panOffsets[i] + panSizes[i]-1));
-        nMergedRanges ++;
+        osCurRange = CPLSPrintf(CPL_FRMT_GUIB "-" CPL_FRMT_GUIB,
+                                nGroupStart, nGroupEnd - 1);
+        nTotalReqSize += nGroupEnd - nGroupStart;
 
         osRanges += osCurRange;
 
-        if (nMergedRanges == 1)
+        if (i == 0)
             osFirstRange = osCurRange;
         osLastRange = osCurRange;
     }
@@ -1077,11 +1145,14 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
         nMaxRanges = 250;
     if (nMergedRanges > nMaxRanges)
     {
+        CPLFree(panGroupStart);
+
         int nHalf = nRanges / 2;
-        int nRet = ReadMultiRange(nHalf, ppData, panOffsets, panSizes);
+        int nRet = MultipartReadMultiRange(nHalf, ppData, panOffsets, panSizes);
         if (nRet != 0)
             return nRet;
-        return ReadMultiRange(nRanges - nHalf, ppData + nHalf, panOffsets + nHalf, panSizes + nHalf);
+        return MultipartReadMultiRange(nRanges - nHalf, ppData + nHalf,
+                                       panOffsets + nHalf, panSizes + nHalf);
     }
 
     CURL* hCurlHandle = poFS->GetCurlHandleFor(pszURL);
@@ -1130,6 +1201,7 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
 
         CPLFree(sWriteFuncData.pBuffer);
         CPLFree(sWriteFuncHeaderData.pBuffer);
+        CPLFree(panGroupStart);
 
         return -1;
     }
@@ -1162,6 +1234,7 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
         */
         CPLFree(sWriteFuncData.pBuffer);
         CPLFree(sWriteFuncHeaderData.pBuffer);
+        CPLFree(panGroupStart);
         return -1;
     }
 
@@ -1182,14 +1255,13 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
 
     if (nMergedRanges == 1)
     {
-        int nAccSize = 0;
         if ((vsi_l_offset)nSize < nTotalReqSize)
             goto end;
 
         for(i=0;i<nRanges;i++)
         {
-            memcpy(ppData[i], pBuffer + nAccSize, panSizes[i]);
-            nAccSize += panSizes[i];
+            memcpy(ppData[i], pBuffer + (panOffsets[i] - panOffsets[0]),
+                   panSizes[i]);
         }
 
         nRet = 0;
@@ -1251,7 +1323,7 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
 /* -------------------------------------------------------------------- */
 /*      Loop over parts...                                              */
 /* -------------------------------------------------------------------- */
-    while( iPart < nRanges )
+    while( iPart < nMergedRanges )
     {
 /* -------------------------------------------------------------------- */
 /*      Collect headers.                                                */
@@ -1305,30 +1377,27 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
 /*      Work out the data block size.                                   */
 /* -------------------------------------------------------------------- */
         size_t nBytesAvail = nSize - (pszNext - pBuffer);
+        vsi_l_offset nPartStart = panOffsets[iRange];
+        int iLast = panGroupStart[iPart+1] - 1;
+        size_t nPartSize = (size_t)
+            (panOffsets[iLast] + panSizes[iLast] - nPartStart);
 
-        while(TRUE)
+        if (nBytesAvail < nPartSize)
         {
-            if (nBytesAvail < panSizes[iRange])
-            {
-                CPLError(CE_Failure, CPLE_AppDefined,
-                            "Error while parsing multipart content (at line %d)", __LINE__);
-                goto end;
-            }
+            CPLError(CE_Failure, CPLE_AppDefined,
+                        "Error while parsing multipart content (at line %d)", __LINE__);
+            goto end;
+        }
 
-            memcpy(ppData[iRange], pszNext, panSizes[iRange]);
-            pszNext += panSizes[iRange];
-            nBytesAvail -= panSizes[iRange];
-            if( iRange + 1 < nRanges &&
-                panOffsets[iRange] + panSizes[iRange] == panOffsets[iRange + 1] )
-            {
-                iRange++;
-            }
-            else
-                break;
+        for( ; iRange <= iLast; iRange++ )
+        {
+            memcpy(ppData[iRange], pszNext + (panOffsets[iRange] - nPartStart),
+                   panSizes[iRange]);
         }
+        pszNext += nPartSize;
+        nBytesAvail -= nPartSize;
 
         iPart ++;
-        iRange ++;
 
         while( nBytesAvail > 0
                && (*pszNext != '-'
@@ -1373,6 +1442,201 @@ int VSICurlHandle::ReadMultiRange( int nRanges, void ** ppData,
 end:
     CPLFree(sWriteFuncData.pBuffer);
     CPLFree(sWriteFuncHeaderData.pBuffer);
+    CPLFree(panGroupStart);
+
+    return nRet;
+}
+
+/************************************************************************/
+/*                       ParallelReadMultiRange()                       */
+/*                                                                      */
+/*      Download each group of close ranges with its own HTTP request,  */
+/*      the requests being run concurrently with a curl multi handle.   */
+/************************************************************************/
+
+int VSICurlHandle::ParallelReadMultiRange( int nRanges, void ** ppData,
+                                           const vsi_l_offset* panOffsets,
+                                           const size_t* panSizes )
+{
+    int* panGroupStart = (int*) CPLMalloc((nRanges + 1) * sizeof(int));
+    int nGroups = VSICurlMergeRanges(nRanges, panOffsets, panSizes,
+                                     VSICurlGetMultiRangeGap(),
+                                     panGroupStart);
+    CPLFree(panGroupStart);
+
+    /* No need to run requests in parallel for a single range */
+    if (nGroups == 1)
+        return MultipartReadMultiRange(nRanges, ppData, panOffsets, panSizes);
+
+    /* Same limit as for the multi-range request */
+    int nMaxRanges = atoi(CPLGetConfigOption("CPL_VSIL_CURL_MAX_RANGES", "250"));
+    if (nMaxRanges <= 0)
+        nMaxRanges = 250;
+    if (nGroups > nMaxRanges)
+    {
+        int nHalf = nRanges / 2;
+        int nRet = ParallelReadMultiRange(nHalf, ppData, panOffsets, panSizes);
+        if (nRet != 0)
+            return nRet;
+        return ParallelReadMultiRange(nRanges - nHalf, ppData + nHalf,
+                                      panOffsets + nHalf, panSizes + nHalf);
+    }
+
+    panGroupStart = (int*) CPLMalloc((nGroups + 1) * sizeof(int));
+    VSICurlMergeRanges(nRanges, panOffsets, panSizes,
+                       VSICurlGetMultiRangeGap(), panGroupStart);
+
+    CURLM* hMultiHandle = curl_multi_init();
+    if (hMultiHandle == NULL)
+    {
+        CPLFree(panGroupStart);
+        return VSIVirtualHandle::ReadMultiRange(nRanges, ppData,
+                                                panOffsets, panSizes);
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x071E00
+    int nMaxConnections =
+        atoi(CPLGetConfigOption("CPL_VSIL_CURL_MAX_CONNECTIONS", "10"));
+    if (nMaxConnections > 0)
+        curl_multi_setopt(hMultiHandle, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                          (long)nMaxConnections);
+#endif
+
+    CURL** pahCurlHandles = (CURL**) CPLCalloc(nGroups, sizeof(CURL*));
+    WriteFuncStruct* pasWriteFuncData = (WriteFuncStruct*)
+        CPLMalloc(nGroups * sizeof(WriteFuncStruct));
+    WriteFuncStruct* pasWriteFuncHeaderData = (WriteFuncStruct*)
+        CPLMalloc(nGroups * sizeof(WriteFuncStruct));
+    char* pszCurlErrBufs = (char*) CPLCalloc(nGroups, CURL_ERROR_SIZE+1);
+    std::vector<CPLString> aosRanges(nGroups);
+    int i;
+
+    for(i=0;i<nGroups;i++)
+    {
+        vsi_l_offset nGroupStart = panOffsets[panGroupStart[i]];
+        int iLast = panGroupStart[i+1] - 1;
+        vsi_l_offset nGroupEnd = panOffsets[iLast] + panSizes[iLast];
+
+        CURL* hCurlHandle = curl_easy_init();
+        pahCurlHandles[i] = hCurlHandle;
+        VSICurlSetOptions(hCurlHandle, pszURL);
+
+        VSICURLInitWriteFuncStruct(&pasWriteFuncData[i], (VSILFILE*)this,
+                                   pfnReadCbk, pReadCbkUserData);
+        curl_easy_setopt(hCurlHandle, CURLOPT_WRITEDATA, &pasWriteFuncData[i]);
+        curl_easy_setopt(hCurlHandle, CURLOPT_WRITEFUNCTION, VSICurlHandleWriteFunc);
+
+        VSICURLInitWriteFuncStruct(&pasWriteFuncHeaderData[i], NULL, NULL, NULL);
+        curl_easy_setopt(hCurlHandle, CURLOPT_HEADERDATA, &pasWriteFuncHeaderData[i]);
+        curl_easy_setopt(hCurlHandle, CURLOPT_HEADERFUNCTION, VSICurlHandleWriteFunc);
+        pasWriteFuncHeaderData[i].bIsHTTP = strncmp(pszURL, "http", 4) == 0;
+        pasWriteFuncHeaderData[i].nStartOffset = nGroupStart;
+        pasWriteFuncHeaderData[i].nEndOffset = nGroupEnd - 1;
+
+        aosRanges[i] = CPLSPrintf(CPL_FRMT_GUIB "-" CPL_FRMT_GUIB,
+                                  nGroupStart, nGroupEnd - 1);
+        curl_easy_setopt(hCurlHandle, CURLOPT_RANGE, aosRanges[i].c_str());
+
+        curl_easy_setopt(hCurlHandle, CURLOPT_ERRORBUFFER,
+                         pszCurlErrBufs + i * (CURL_ERROR_SIZE+1));
+
+        curl_multi_add_handle(hMultiHandle, hCurlHandle);
+    }
+
+    if (ENABLE_DEBUG)
+        CPLDebug("VSICURL", "Downloading %s, ..., %s (%d ranges, %s)...",
+                 aosRanges[0].c_str(), aosRanges[nGroups-1].c_str(),
+                 nGroups, pszURL);
+
+/* -------------------------------------------------------------------- */
+/*      Run the requests.                                               */
+/* -------------------------------------------------------------------- */
+    int nStillRunning = 0;
+    while (curl_multi_perform(hMultiHandle, &nStillRunning) == CURLM_CALL_MULTI_PERFORM);
+    while (nStillRunning)
+    {
+        struct timeval timeout;
+        fd_set fdread, fdwrite, fdexcep;
+        int maxfd = -1;
+
+        FD_ZERO(&fdread);
+        FD_ZERO(&fdwrite);
+        FD_ZERO(&fdexcep);
+        curl_multi_fdset(hMultiHandle, &fdread, &fdwrite, &fdexcep, &maxfd);
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 100000;
+        if (maxfd >= 0)
+            select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &timeout);
+        else
+            CPLSleep(0.01);
+        while (curl_multi_perform(hMultiHandle, &nStillRunning) == CURLM_CALL_MULTI_PERFORM);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Check the responses and dispatch the data.                      */
+/* -------------------------------------------------------------------- */
+    int nRet = 0;
+    for(i=0;i<nGroups;i++)
+    {
+        CURL* hCurlHandle = pahCurlHandles[i];
+
+        if (nRet == 0)
+        {
+            long response_code = 0;
+            curl_easy_getinfo(hCurlHandle, CURLINFO_HTTP_CODE, &response_code);
+            const char* pszCurlErrBuf = pszCurlErrBufs + i * (CURL_ERROR_SIZE+1);
+
+            vsi_l_offset nGroupStart = panOffsets[panGroupStart[i]];
+            int iLast = panGroupStart[i+1] - 1;
+            vsi_l_offset nGroupEnd = panOffsets[iLast] + panSizes[iLast];
+
+            if (pasWriteFuncData[i].bInterrupted)
+            {
+                bInterrupted = TRUE;
+                nRet = -1;
+            }
+            else if ((response_code != 200 && response_code != 206 &&
+                      response_code != 225 && response_code != 226 &&
+                      response_code != 426) ||
+                     pasWriteFuncHeaderData[i].bError)
+            {
+                if (response_code >= 400 && pszCurlErrBuf[0] != '\0')
+                    CPLError(CE_Failure, CPLE_AppDefined, "%d: %s",
+                             (int)response_code, pszCurlErrBuf);
+                nRet = -1;
+            }
+            else if ((vsi_l_offset)pasWriteFuncData[i].nSize <
+                                                nGroupEnd - nGroupStart)
+            {
+                CPLError(CE_Failure, CPLE_AppDefined,
+                         "Got only %d bytes, where " CPL_FRMT_GUIB " were expected",
+                         (int)pasWriteFuncData[i].nSize,
+                         (GUIntBig)(nGroupEnd - nGroupStart));
+                nRet = -1;
+            }
+            else
+            {
+                for(int iRange=panGroupStart[i];iRange<=iLast;iRange++)
+                {
+                    memcpy(ppData[iRange], pasWriteFuncData[i].pBuffer +
+                                (panOffsets[iRange] - nGroupStart),
+                           panSizes[iRange]);
+                }
+            }
+        }
+
+        curl_multi_remove_handle(hMultiHandle, hCurlHandle);
+        curl_easy_cleanup(hCurlHandle);
+        CPLFree(pasWriteFuncData[i].pBuffer);
+        CPLFree(pasWriteFuncHeaderData[i].pBuffer);
+    }
+
+    curl_multi_cleanup(hMultiHandle);
+    CPLFree(pahCurlHandles);
+    CPLFree(pasWriteFuncData);
+    CPLFree(pasWriteFuncHeaderData);
+    CPLFree(pszCurlErrBufs);
+    CPLFree(panGroupStart);
 
     return nRet;
 }
@@ -1424,8 +1688,6 @@ int       VSICurlHandle::Close()
 VSICurlFilesystemHandler::VSICurlFilesystemHandler()
 {
     hMutex = NULL;
-    papsRegions = NULL;
-    nRegions = 0;
     bUseCacheDisk = CSLTestBoolean(CPLGetConfigOption("CPL_VSIL_CURL_USE_CACHE", "NO"));
 }
 
@@ -1435,14 +1697,6 @@ VSICurlFilesystemHandler::VSICurlFilesystemHandler()
 
 VSICurlFilesystemHandler::~VSICurlFilesystemHandler()
 {
-    int i;
-    for(i=0;i<nRegions;i++)
-    {
-        CPLFree(papsRegions[i]->pData);
-        CPLFree(papsRegions[i]);
-    }
-    CPLFree(papsRegions);
-
     std::map<CPLString, CachedFileProp*>::const_iterator iterCacheFileSize;
 
     for( iterCacheFileSize = cacheFileSize.begin(); iterCacheFileSize != cacheFileSize.end(); iterCacheFileSize++ )
@@ -1522,8 +1776,7 @@ CURL* VSICurlFilesystemHandler::GetCurlHandleFor(CPLString osURL)
 /*                   GetRegionFromCacheDisk()                           */
 /************************************************************************/
 
-const CachedRegion* 
-VSICurlFilesystemHandler::GetRegionFromCacheDisk(const char* pszURL,
+int VSICurlFilesystemHandler::GetRegionFromCacheDisk(const char* pszURL,
                                                  vsi_l_offset nFileOffsetStart)
 {
     nFileOffsetStart = (nFileOffsetStart / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
@@ -1549,15 +1802,15 @@ VSICurlFilesystemHandler::GetRegionFromCacheDisk(const char* pszURL,
                 {
                     char* pBuffer = (char*) CPLMalloc(nSizeCached);
                     VSIFReadL(pBuffer, 1, nSizeCached, fp);
-                    AddRegion(pszURL, nFileOffsetStart, nSizeCached, pBuffer);
+                    VSIBlockCacheAdd(pszURL, nFileOffsetStart, pBuffer, nSizeCached);
                     CPLFree(pBuffer);
                 }
                 else
                 {
-                    AddRegion(pszURL, nFileOffsetStart, 0, NULL);
+                    VSIBlockCacheAdd(pszURL, nFileOffsetStart, NULL, 0);
                 }
                 VSIFCloseL(fp);
-                return GetRegion(pszURL, nFileOffsetStart);
+                return TRUE;
             }
             else
             {
@@ -1566,7 +1819,7 @@ VSICurlFilesystemHandler::GetRegionFromCacheDisk(const char* pszURL,
         }
         VSIFCloseL(fp);
     }
-    return NULL;
+    return FALSE;
 }
 
 
@@ -1574,8 +1827,12 @@ VSICurlFilesystemHandler::GetRegionFromCacheDisk(const char* pszURL,
 /*                  AddRegionToCacheDisk()                                */
 /************************************************************************/
 
-void VSICurlFilesystemHandler::AddRegionToCacheDisk(CachedRegion* psRegion)
+void VSICurlFilesystemHandler::AddRegionToCacheDisk(const char* pszURL,
+                                                    vsi_l_offset nFileOffsetStart,
+                                                    size_t nSize,
+                                                    const char* pData)
 {
+    unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
     VSILFILE* fp = VSIFOpenL(VSICurlGetCacheFileName(), "r+b");
     if (fp)
     {
@@ -1588,10 +1845,10 @@ void VSICurlFilesystemHandler::AddRegionToCacheDisk(CachedRegion* psRegion)
                 break;
             VSIFReadL(&nFileOffsetStartCached, 1, sizeof(vsi_l_offset), fp);
             VSIFReadL(&nSizeCached, 1, sizeof(size_t), fp);
-            if (psRegion->pszURLHash == pszURLHashCached &&
-                psRegion->nFileOffsetStart == nFileOffsetStartCached)
+            if (pszURLHash == pszURLHashCached &&
+                nFileOffsetStart == nFileOffsetStartCached)
             {
-                CPLAssert(psRegion->nSize == nSizeCached);
+                CPLAssert(nSize == nSizeCached);
                 VSIFCloseL(fp);
                 return;
             }
@@ -1608,12 +1865,12 @@ void VSICurlFilesystemHandler::AddRegionToCacheDisk(CachedRegion* psRegion)
     if (fp)
     {
         if (ENABLE_DEBUG)
-             CPLDebug("VSICURL", "Write data at offset " CPL_FRMT_GUIB " to disk" , psRegion->nFileOffsetStart);
-        VSIFWriteL(&psRegion->pszURLHash, 1, sizeof(unsigned long), fp);
-        VSIFWriteL(&psRegion->nFileOffsetStart, 1, sizeof(vsi_l_offset), fp);
-        VSIFWriteL(&psRegion->nSize, 1, sizeof(size_t), fp);
-        if (psRegion->nSize)
-            VSIFWriteL(psRegion->pData, 1, psRegion->nSize, fp);
+             CPLDebug("VSICURL", "Write data at offset " CPL_FRMT_GUIB " to disk" , nFileOffsetStart);
+        VSIFWriteL(&pszURLHash, 1, sizeof(unsigned long), fp);
+        VSIFWriteL(&nFileOffsetStart, 1, sizeof(vsi_l_offset), fp);
+        VSIFWriteL(&nSize, 1, sizeof(size_t), fp);
+        if (nSize)
+            VSIFWriteL(pData, 1, nSize, fp);
 
         VSIFCloseL(fp);
     }
@@ -1623,31 +1880,35 @@ void VSICurlFilesystemHandler::AddRegionToCacheDisk(CachedRegion* psRegion)
 
 /************************************************************************/
 /*                          GetRegion()                                 */
+/*                                                                      */
+/*      Copy up to nDestSize bytes from nOffset into pDest if the       */
+/*      region containing nOffset is cached. Regions are stored in      */
+/*      the process-wide VSI block cache, keyed by URL, so that all     */
+/*      handles on the same URL share them.                             */
 /************************************************************************/
 
-const CachedRegion* VSICurlFilesystemHandler::GetRegion(const char* pszURL,
-                                                        vsi_l_offset nFileOffsetStart)
+int VSICurlFilesystemHandler::GetRegion(const char*     pszURL,
+                                        vsi_l_offset    nOffset,
+                                        void           *pDest,
+                                        size_t          nDestSize,
+                                        size_t         *pnRegionSize)
 {
-    CPLMutexHolder oHolder( &hMutex );
+    vsi_l_offset nFileOffsetStart =
+        (nOffset / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
+    size_t nOffsetInRegion = (size_t)(nOffset - nFileOffsetStart);
 
-    unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
+    if (VSIBlockCacheRead(pszURL, nFileOffsetStart, nOffsetInRegion,
+                          pDest, nDestSize, pnRegionSize))
+        return TRUE;
 
-    nFileOffsetStart = (nFileOffsetStart / DOWNLOAD_CHUNCK_SIZE) * DOWNLOAD_CHUNCK_SIZE;
-    int i;
-    for(i=0;i<nRegions;i++)
+    if (bUseCacheDisk)
     {
-        CachedRegion* psRegion = papsRegions[i];
-        if (psRegion->pszURLHash == pszURLHash &&
-            nFileOffsetStart == psRegion->nFileOffsetStart)
-        {
-            memmove(papsRegions + 1, papsRegions, i * sizeof(CachedRegion*));
-            papsRegions[0] = psRegion;
-            return psRegion;
-        }
+        CPLMutexHolder oHolder( &hMutex );
+        if (GetRegionFromCacheDisk(pszURL, nFileOffsetStart))
+            return VSIBlockCacheRead(pszURL, nFileOffsetStart, nOffsetInRegion,
+                                     pDest, nDestSize, pnRegionSize);
     }
-    if (bUseCacheDisk)
-        return GetRegionFromCacheDisk(pszURL, nFileOffsetStart);
-    return NULL;
+    return FALSE;
 }
 
 /************************************************************************/
@@ -1659,36 +1920,13 @@ void  VSICurlFilesystemHandler::AddRegion(const char* pszURL,
                                           size_t          nSize,
                                           const char     *pData)
 {
-    CPLMutexHolder oHolder( &hMutex );
-
-    unsigned long   pszURLHash = CPLHashSetHashStr(pszURL);
+    VSIBlockCacheAdd(pszURL, nFileOffsetStart, pData, nSize);
 
-    CachedRegion* psRegion;
-    if (nRegions == N_MAX_REGIONS)
-    {
-        psRegion = papsRegions[N_MAX_REGIONS-1];
-        memmove(papsRegions + 1, papsRegions, (N_MAX_REGIONS-1) * sizeof(CachedRegion*));
-        papsRegions[0] = psRegion;
-        CPLFree(psRegion->pData);
-    }
-    else
+    if (bUseCacheDisk)
     {
-        papsRegions = (CachedRegion**) CPLRealloc(papsRegions, (nRegions + 1) * sizeof(CachedRegion*));
-        if (nRegions)
-            memmove(papsRegions + 1, papsRegions, nRegions * sizeof(CachedRegion*));
-        nRegions ++;
-        papsRegions[0] = psRegion = (CachedRegion*) CPLMalloc(sizeof(CachedRegion));
+        CPLMutexHolder oHolder( &hMutex );
+        AddRegionToCacheDisk(pszURL, nFileOffsetStart, nSize, pData);
     }
-
-    psRegion->pszURLHash = pszURLHash;
-    psRegion->nFileOffsetStart = nFileOffsetStart;
-    psRegion->nSize = nSize;
-    psRegion->pData = (nSize) ? (char*) CPLMalloc(nSize) : NULL;
-    if (nSize)
-        memcpy(psRegion->pData, pData, nSize);
-
-    if (bUseCacheDisk)
-        AddRegionToCacheDisk(psRegion);
 }
 
 /************************************************************************/
@@ -1758,10 +1996,7 @@ VSIVirtualHandle* VSICurlFilesystemHandler::Open( const char *pszFilename,
         }
     }
 
-    if( CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
-        return VSICreateCachedFile( poHandle );
-    else
-        return poHandle;
+    return poHandle;
 }
 
 /************************************************************************/
@@ -2644,9 +2879,18 @@ char** VSICurlFilesystemHandler::ReadDir( const char *pszDirname )
  * used to define a proxy server. The syntax to use is the one of Curl CURLOPT_PROXY,
  * CURLOPT_PROXYUSERPWD and CURLOPT_PROXYAUTH options.
  *
- * Starting with GDAL 1.10, the file can be cached in RAM by setting the configuration option
- * VSI_CACHE to TRUE. The cache size defaults to 25 MB, but can be modified by setting
- * the configuration option VSI_CACHE_SIZE (in bytes).
+ * VSIFReadMultiRangeL() merges ranges that are less than
+ * CPL_VSIL_CURL_MULTIRANGE_GAP bytes apart (16 KB by default) and downloads
+ * the resulting ranges in parallel, with at most CPL_VSIL_CURL_MAX_CONNECTIONS
+ * connections (10 by default). Setting the CPL_VSIL_CURL_MULTIRANGE
+ * configuration option to SINGLE_GET uses instead a single multi-range HTTP
+ * request, and SERIAL downloads the ranges one after the other.
+ *
+ * Downloaded chunks are kept in RAM in a cache shared by all the handles opened
+ * on the same URL (and with the files opened with VSI_CACHE=TRUE). The cache
+ * size defaults to 25 MB for the whole process, but can be modified by setting
+ * the configuration option VSI_CACHE_SIZE (in bytes). Setting VSI_CACHE is
+ * no longer needed for /vsicurl/ files.
  *
  * VSIStatL() will return the size in st_size member and file
  * nature- file or directory - in st_mode member (the later only reliable with FTP
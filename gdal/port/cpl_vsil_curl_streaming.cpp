@@ -1449,7 +1449,7 @@ int VSICurlStreamingFSHandler::Stat( const char *pszFilename,
  * CURLOPT_PROXYUSERPWD and CURLOPT_PROXYAUTH options.
  *
  * The file can be cached in RAM by setting the configuration option
- * VSI_CACHE to TRUE. The cache size defaults to 25 MB, but can be modified by setting
+ * VSI_CACHE to TRUE. The cache size (shared by all cached files) defaults to 25 MB, but can be modified by setting
  * the configuration option VSI_CACHE_SIZE (in bytes).
  *
  * VSIStatL() will return the size in st_size member and file
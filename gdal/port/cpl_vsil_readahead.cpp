@@ -0,0 +1,484 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  VSI Virtual File System
+ * Purpose:  Implementation of an asynchronous readahead IO layer.
+ * Author:   Even Rouault, even.rouault at mines-paris.org
+ *
+ ******************************************************************************
+ * Copyright (c) 2014, Even Rouault <even dot rouault at mines-paris dot org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+/* The intent of this class is to be a wrapper around an underlying virtual */
+/* handle that is read sequentially (text or streamed formats, /vsigzip/, */
+/* /vsicurl_streaming/, ...). A background thread reads the next blocks of */
+/* the base handle into a ring buffer, so that the I/O (and decompression) */
+/* of the base handle overlaps with the parsing done by the caller. */
+/* A seek outside of the prefetched window restarts the readahead from the */
+/* new position. */
+
+#include "cpl_vsi_virtual.h"
+#include "cpl_multiproc.h"
+
+CPL_CVSID("$Id$");
+
+class VSIReadAheadHandle : public VSIVirtualHandle
+{
+    VSIVirtualHandle* poBaseHandle;
+
+    /* Ring of nBlocks buffers of nBlockSize bytes. The nFilled blocks */
+    /* starting at nHead contain consecutive data of the base handle */
+    int               nBlocks;
+    size_t            nBlockSize;
+    GByte           **papabyBlocks;
+    vsi_l_offset     *panBlockOffset;
+    size_t           *panBlockDataSize;
+    int               nHead;
+    int               nFilled;
+
+    /* Offset of the next block the thread will read */
+    vsi_l_offset      nNextFetchOffset;
+    /* Position of the base handle, as known by the thread */
+    vsi_l_offset      nBaseOffset;
+    int               bBaseEOF;
+    int               bFetching;
+    int               bStop;
+    int               bPaused;
+    /* Incremented when the prefetched window is discarded */
+    int               nGeneration;
+
+    void             *hMutex;
+    void             *hCond;
+    void             *hThread;
+
+    vsi_l_offset      nCurOffset;
+    int               bEOF;
+
+    static void       ThreadFunc( void* pData );
+    void              Run();
+    void              Pause();
+    void              Resume();
+    void              Restart( vsi_l_offset nOffset );
+
+  public:
+
+    VSIReadAheadHandle( VSIVirtualHandle* poBaseHandle,
+                        int nBlocks, size_t nBlockSize );
+    ~VSIReadAheadHandle();
+
+    int               Start();
+    void              DetachBaseHandle() { poBaseHandle = NULL; }
+
+    virtual int       Seek( vsi_l_offset nOffset, int nWhence );
+    virtual vsi_l_offset Tell();
+    virtual size_t    Read( void *pBuffer, size_t nSize, size_t nMemb );
+    virtual size_t    Write( const void *pBuffer, size_t nSize, size_t nMemb );
+    virtual int       Eof();
+    virtual int       Flush();
+    virtual int       Close();
+};
+
+/************************************************************************/
+/*                     VSICreateReadAheadHandle()                       */
+/************************************************************************/
+
+/**
+ * \brief Wrap a handle so that its next blocks are read in a background thread.
+ *
+ * The handle takes ownership of poBaseHandle. If nBlocks or nBlockSize are 0,
+ * the VSI_READAHEAD_BLOCKS (4 by default) and VSI_READAHEAD_BLOCK_SIZE
+ * (262144 by default) configuration options are used. If the readahead
+ * thread cannot be started, poBaseHandle is returned as is.
+ */
+
+VSIVirtualHandle* VSICreateReadAheadHandle( VSIVirtualHandle* poBaseHandle,
+                                            int nBlocks, size_t nBlockSize )
+{
+    if( nBlocks <= 0 )
+        nBlocks = atoi(CPLGetConfigOption("VSI_READAHEAD_BLOCKS", "4"));
+    if( nBlockSize == 0 )
+        nBlockSize = (size_t) CPLScanUIntBig(
+            CPLGetConfigOption("VSI_READAHEAD_BLOCK_SIZE", "262144"), 40);
+    if( nBlocks <= 0 || nBlockSize == 0 )
+        return poBaseHandle;
+
+    VSIReadAheadHandle* poHandle =
+        new VSIReadAheadHandle(poBaseHandle, nBlocks, nBlockSize);
+    if( !poHandle->Start() )
+    {
+        CPLDebug("VSI", "Cannot start readahead thread");
+        poHandle->DetachBaseHandle();
+        poHandle->Close();
+        delete poHandle;
+        return poBaseHandle;
+    }
+    return poHandle;
+}
+
+/************************************************************************/
+/*                   VSICreateReadAheadHandleIfNeeded()                 */
+/************************************************************************/
+
+/**
+ * \brief Wrap a handle with VSICreateReadAheadHandle() if the
+ * VSI_READAHEAD configuration option is set to YES.
+ */
+
+VSIVirtualHandle* VSICreateReadAheadHandleIfNeeded( VSIVirtualHandle* poBaseHandle )
+{
+    if( poBaseHandle != NULL &&
+        CSLTestBoolean(CPLGetConfigOption("VSI_READAHEAD", "NO")) )
+        return VSICreateReadAheadHandle(poBaseHandle);
+    return poBaseHandle;
+}
+
+/************************************************************************/
+/*                        VSIReadAheadHandle()                          */
+/************************************************************************/
+
+VSIReadAheadHandle::VSIReadAheadHandle( VSIVirtualHandle* poBaseHandle,
+                                        int nBlocks, size_t nBlockSize )
+{
+    this->poBaseHandle = poBaseHandle;
+    this->nBlocks = nBlocks;
+    this->nBlockSize = nBlockSize;
+    papabyBlocks = (GByte**) CPLCalloc(nBlocks, sizeof(GByte*));
+    panBlockOffset = (vsi_l_offset*) CPLCalloc(nBlocks, sizeof(vsi_l_offset));
+    panBlockDataSize = (size_t*) CPLCalloc(nBlocks, sizeof(size_t));
+    nHead = 0;
+    nFilled = 0;
+
+    nBaseOffset = poBaseHandle->Tell();
+    nNextFetchOffset = nBaseOffset;
+    nCurOffset = nBaseOffset;
+    bBaseEOF = FALSE;
+    bFetching = FALSE;
+    bStop = FALSE;
+    bPaused = FALSE;
+    nGeneration = 0;
+    bEOF = FALSE;
+
+    hMutex = NULL;
+    hCond = NULL;
+    hThread = NULL;
+}
+
+/************************************************************************/
+/*                        ~VSIReadAheadHandle()                         */
+/************************************************************************/
+
+VSIReadAheadHandle::~VSIReadAheadHandle()
+{
+    Close();
+}
+
+/************************************************************************/
+/*                               Start()                                */
+/************************************************************************/
+
+int VSIReadAheadHandle::Start()
+{
+    for( int i = 0; i < nBlocks; i++ )
+    {
+        papabyBlocks[i] = (GByte*) VSIMalloc(nBlockSize);
+        if( papabyBlocks[i] == NULL )
+            return FALSE;
+    }
+
+    hMutex = CPLCreateMutex();
+    if( hMutex == NULL )
+        return FALSE;
+    CPLReleaseMutex(hMutex);
+
+    hCond = CPLCreateCond();
+    if( hCond == NULL )
+        return FALSE;
+
+    hThread = CPLCreateJoinableThread(ThreadFunc, this);
+    return hThread != NULL;
+}
+
+/************************************************************************/
+/*                             ThreadFunc()                             */
+/************************************************************************/
+
+void VSIReadAheadHandle::ThreadFunc( void* pData )
+{
+    ((VSIReadAheadHandle*) pData)->Run();
+}
+
+/************************************************************************/
+/*                                Run()                                 */
+/*                                                                      */
+/*      Body of the readahead thread. The base handle is only used      */
+/*      by this thread, unless the thread is paused.                    */
+/************************************************************************/
+
+void VSIReadAheadHandle::Run()
+{
+    CPLAcquireMutex(hMutex, 1000.0);
+    while( TRUE )
+    {
+        while( !bStop && (bPaused || bBaseEOF || nFilled == nBlocks) )
+            CPLCondWait(hCond, hMutex);
+        if( bStop )
+            break;
+
+        int iBlock = (nHead + nFilled) % nBlocks;
+        vsi_l_offset nOffset = nNextFetchOffset;
+        int nThisGeneration = nGeneration;
+        bFetching = TRUE;
+        CPLReleaseMutex(hMutex);
+
+        size_t nRead = 0;
+        int bSeekOK = TRUE;
+        if( nBaseOffset != nOffset )
+            bSeekOK = poBaseHandle->Seek(nOffset, SEEK_SET) == 0;
+        if( bSeekOK )
+            nRead = poBaseHandle->Read(papabyBlocks[iBlock], 1, nBlockSize);
+        nBaseOffset = nOffset + nRead;
+
+        CPLAcquireMutex(hMutex, 1000.0);
+        bFetching = FALSE;
+        if( nThisGeneration == nGeneration )
+        {
+            if( nRead > 0 )
+            {
+                panBlockOffset[iBlock] = nOffset;
+                panBlockDataSize[iBlock] = nRead;
+                nFilled ++;
+                nNextFetchOffset = nOffset + nRead;
+            }
+            if( nRead < nBlockSize )
+                bBaseEOF = TRUE;
+        }
+        CPLCondBroadcast(hCond);
+    }
+    CPLReleaseMutex(hMutex);
+}
+
+/************************************************************************/
+/*                               Pause()                                */
+/*                                                                      */
+/*      Wait for the thread to be idle so that the caller can use the   */
+/*      base handle. Must be called with the mutex held.                */
+/************************************************************************/
+
+void VSIReadAheadHandle::Pause()
+{
+    bPaused = TRUE;
+    while( bFetching )
+        CPLCondWait(hCond, hMutex);
+}
+
+/************************************************************************/
+/*                               Resume()                               */
+/************************************************************************/
+
+void VSIReadAheadHandle::Resume()
+{
+    bPaused = FALSE;
+    CPLCondBroadcast(hCond);
+}
+
+/************************************************************************/
+/*                              Restart()                               */
+/*                                                                      */
+/*      Discard the prefetched blocks, and restart reading at nOffset.  */
+/*      Must be called with the mutex held.                             */
+/************************************************************************/
+
+void VSIReadAheadHandle::Restart( vsi_l_offset nOffset )
+{
+    nGeneration ++;
+    nHead = 0;
+    nFilled = 0;
+    nNextFetchOffset = nOffset;
+    bBaseEOF = FALSE;
+    CPLCondBroadcast(hCond);
+}
+
+/************************************************************************/
+/*                               Seek()                                 */
+/************************************************************************/
+
+int VSIReadAheadHandle::Seek( vsi_l_offset nOffset, int nWhence )
+{
+    bEOF = FALSE;
+    if( nWhence == SEEK_CUR )
+        nCurOffset += nOffset;
+    else if( nWhence == SEEK_END )
+    {
+        CPLMutexHolderD(&hMutex);
+        Pause();
+        int nRet = poBaseHandle->Seek(nOffset, nWhence);
+        nBaseOffset = poBaseHandle->Tell();
+        if( nRet == 0 )
+            nCurOffset = nBaseOffset;
+        Resume();
+        return nRet;
+    }
+    else
+        nCurOffset = nOffset;
+
+    return 0;
+}
+
+/************************************************************************/
+/*                               Tell()                                 */
+/************************************************************************/
+
+vsi_l_offset VSIReadAheadHandle::Tell()
+{
+    return nCurOffset;
+}
+
+/************************************************************************/
+/*                               Read()                                 */
+/************************************************************************/
+
+size_t VSIReadAheadHandle::Read( void *pBuffer, size_t nSize, size_t nMemb )
+{
+    const size_t nTotalToRead = nSize * nMemb;
+    if( nTotalToRead == 0 )
+        return 0;
+
+    size_t nTotalRead = 0;
+
+    CPLMutexHolderD(&hMutex);
+
+    while( nTotalRead < nTotalToRead )
+    {
+        /* Drop the blocks that are entirely before the current position */
+        while( nFilled > 0 &&
+               nCurOffset >= panBlockOffset[nHead] + panBlockDataSize[nHead] &&
+               nCurOffset <= nNextFetchOffset )
+        {
+            nHead = (nHead + 1) % nBlocks;
+            nFilled --;
+            CPLCondBroadcast(hCond);
+        }
+
+        if( nFilled > 0 && nCurOffset >= panBlockOffset[nHead] &&
+            nCurOffset < panBlockOffset[nHead] + panBlockDataSize[nHead] )
+        {
+            size_t nOffsetInBlock = (size_t)(nCurOffset - panBlockOffset[nHead]);
+            size_t nToCopy = MIN(nTotalToRead - nTotalRead,
+                                 panBlockDataSize[nHead] - nOffsetInBlock);
+            memcpy((GByte*)pBuffer + nTotalRead,
+                   papabyBlocks[nHead] + nOffsetInBlock, nToCopy);
+            nTotalRead += nToCopy;
+            nCurOffset += nToCopy;
+            continue;
+        }
+
+        if( nFilled == 0 && nCurOffset == nNextFetchOffset )
+        {
+            if( bBaseEOF )
+                break;
+            /* The thread is (or will be) reading the block we need */
+            CPLCondWait(hCond, hMutex);
+            continue;
+        }
+
+        /* Outside of the prefetched window */
+        Restart(nCurOffset);
+    }
+
+    if( nTotalRead < nTotalToRead )
+        bEOF = TRUE;
+
+    return nTotalRead / nSize;
+}
+
+/************************************************************************/
+/*                              Write()                                 */
+/************************************************************************/
+
+size_t VSIReadAheadHandle::Write( const void *pBuffer, size_t nSize, size_t nMemb )
+{
+    CPLError(CE_Failure, CPLE_NotSupported,
+             "VSIFWriteL is not supported on readahead streams\n");
+    return 0;
+}
+
+/************************************************************************/
+/*                               Eof()                                  */
+/************************************************************************/
+
+int VSIReadAheadHandle::Eof()
+{
+    return bEOF;
+}
+
+/************************************************************************/
+/*                              Flush()                                 */
+/************************************************************************/
+
+int VSIReadAheadHandle::Flush()
+{
+    return 0;
+}
+
+/************************************************************************/
+/*                              Close()                                 */
+/************************************************************************/
+
+int VSIReadAheadHandle::Close()
+{
+    if( hThread != NULL )
+    {
+        CPLAcquireMutex(hMutex, 1000.0);
+        bStop = TRUE;
+        CPLCondBroadcast(hCond);
+        CPLReleaseMutex(hMutex);
+        CPLJoinThread(hThread);
+        hThread = NULL;
+    }
+    if( hCond != NULL )
+    {
+        CPLDestroyCond(hCond);
+        hCond = NULL;
+    }
+    if( hMutex != NULL )
+    {
+        CPLDestroyMutex(hMutex);
+        hMutex = NULL;
+    }
+    if( papabyBlocks != NULL )
+    {
+        for( int i = 0; i < nBlocks; i++ )
+            VSIFree(papabyBlocks[i]);
+        CPLFree(papabyBlocks);
+        papabyBlocks = NULL;
+        CPLFree(panBlockOffset);
+        panBlockOffset = NULL;
+        CPLFree(panBlockDataSize);
+        panBlockDataSize = NULL;
+    }
+    if( poBaseHandle )
+    {
+        poBaseHandle->Close();
+        delete poBaseHandle;
+        poBaseHandle = NULL;
+    }
+    return 0;
+}
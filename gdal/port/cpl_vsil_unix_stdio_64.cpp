@@ -145,13 +145,15 @@ class VSIUnixStdioHandle : public VSIVirtualHandle
     int           bLastOpWrite;
     int           bLastOpRead;
     int           bAtEOF;
+    CPLString     osFilename;   /* set for writable handles only */
 #ifdef VSI_COUNT_BYTES_READ
     vsi_l_offset  nTotalBytesRead;
     VSIUnixStdioFilesystemHandler *poFS;
 #endif
   public:
                       VSIUnixStdioHandle(VSIUnixStdioFilesystemHandler *poFSIn,
-                                         FILE* fpIn, int bReadOnlyIn);
+                                         FILE* fpIn, int bReadOnlyIn,
+                                         const char* pszFilenameIn);
 
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
     virtual vsi_l_offset Tell();
@@ -170,12 +172,15 @@ class VSIUnixStdioHandle : public VSIVirtualHandle
 /************************************************************************/
 
 VSIUnixStdioHandle::VSIUnixStdioHandle(VSIUnixStdioFilesystemHandler *poFSIn,
-                                       FILE* fpIn, int bReadOnlyIn) :
+                                       FILE* fpIn, int bReadOnlyIn,
+                                       const char* pszFilenameIn) :
     fp(fpIn), nOffset(0), bReadOnly(bReadOnlyIn), bLastOpWrite(FALSE), bLastOpRead(FALSE), bAtEOF(FALSE)
 #ifdef VSI_COUNT_BYTES_READ
     , nTotalBytesRead(0), poFS(poFSIn)
 #endif
 {
+    if( !bReadOnly )
+        osFilename = pszFilenameIn;
 }
 
 /************************************************************************/
@@ -191,7 +196,13 @@ int VSIUnixStdioHandle::Close()
     poFS->AddToTotal(nTotalBytesRead);
 #endif
 
-    return fclose( fp );
+    int nRet = fclose( fp );
+
+    /* Cached read-only handles must not see the previous content */
+    if( !bReadOnly )
+        VSIBlockCacheInvalidateFile( osFilename );
+
+    return nRet;
 }
 
 /************************************************************************/
@@ -479,7 +490,8 @@ VSIUnixStdioFilesystemHandler::Open( const char *pszFilename,
     }
 
     int bReadOnly = strcmp(pszAccess, "rb") == 0 || strcmp(pszAccess, "r") == 0;
-    VSIUnixStdioHandle *poHandle = new VSIUnixStdioHandle(this, fp, bReadOnly );
+    VSIUnixStdioHandle *poHandle = new VSIUnixStdioHandle(this, fp, bReadOnly,
+                                                          pszFilename );
 
     errno = nError;
 
@@ -490,7 +502,7 @@ VSIUnixStdioFilesystemHandler::Open( const char *pszFilename,
     if( bReadOnly
         && CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
     {
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, 32768, 0, pszFilename );
     }
     else
     {
@@ -517,6 +529,7 @@ int VSIUnixStdioFilesystemHandler::Stat( const char * pszFilename,
 int VSIUnixStdioFilesystemHandler::Unlink( const char * pszFilename )
 
 {
+    VSIBlockCacheInvalidateFile( pszFilename );
     return unlink( pszFilename );
 }
 
@@ -528,6 +541,8 @@ int VSIUnixStdioFilesystemHandler::Rename( const char *oldpath,
                                            const char *newpath )
 
 {
+    VSIBlockCacheInvalidateFile( oldpath );
+    VSIBlockCacheInvalidateFile( newpath );
     return rename( oldpath, newpath );
 }
 
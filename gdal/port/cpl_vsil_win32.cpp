@@ -85,6 +85,7 @@ class VSIWin32Handle : public VSIVirtualHandle
   public:
     HANDLE       hFile;
     int          bEOF;
+    CPLString    osFilename;    /* set for writable handles only */
 
     virtual int       Seek( vsi_l_offset nOffset, int nWhence );
     virtual vsi_l_offset Tell();
@@ -189,7 +190,13 @@ static int ErrnoFromGetLastError()
 int VSIWin32Handle::Close()
 
 {
-    return CloseHandle( hFile ) ? 0 : -1;
+    int nRet = CloseHandle( hFile ) ? 0 : -1;
+
+    /* Cached read-only handles must not see the previous content */
+    if( !osFilename.empty() )
+        VSIBlockCacheInvalidateFile( osFilename );
+
+    return nRet;
 }
 
 /************************************************************************/
@@ -437,6 +444,8 @@ VSIVirtualHandle *VSIWin32FilesystemHandler::Open( const char *pszFilename,
     
     poHandle->hFile = hFile;
     poHandle->bEOF = FALSE;
+    if( !EQUAL(pszAccess,"r") && !EQUAL(pszAccess,"rb") )
+        poHandle->osFilename = pszFilename;
     
     if (strchr(pszAccess, 'a') != 0)
         poHandle->Seek(0, SEEK_END);
@@ -448,7 +457,7 @@ VSIVirtualHandle *VSIWin32FilesystemHandler::Open( const char *pszFilename,
     if( (EQUAL(pszAccess,"r") || EQUAL(pszAccess,"rb"))
         && CSLTestBoolean( CPLGetConfigOption( "VSI_CACHE", "FALSE" ) ) )
     {
-        return VSICreateCachedFile( poHandle );
+        return VSICreateCachedFile( poHandle, 32768, 0, pszFilename );
     }
     else
     {
@@ -495,6 +504,8 @@ int VSIWin32FilesystemHandler::Stat( const char * pszFilename,
 int VSIWin32FilesystemHandler::Unlink( const char * pszFilename )
 
 {
+    VSIBlockCacheInvalidateFile( pszFilename );
+
 #if (defined(WIN32) && _MSC_VER >= 1310) || __MSVCRT_VERSION__ >= 0x0601
     if( CSLTestBoolean(
             CPLGetConfigOption( "GDAL_FILENAME_IS_UTF8", "YES" ) ) )
@@ -522,6 +533,9 @@ int VSIWin32FilesystemHandler::Rename( const char *oldpath,
                                            const char *newpath )
 
 {
+    VSIBlockCacheInvalidateFile( oldpath );
+    VSIBlockCacheInvalidateFile( newpath );
+
 #if (defined(WIN32) && _MSC_VER >= 1310) || __MSVCRT_VERSION__ >= 0x0601
     if( CSLTestBoolean(
             CPLGetConfigOption( "GDAL_FILENAME_IS_UTF8", "YES" ) ) )